@@ -13,6 +13,14 @@ int read_packet(void* opaque, uint8_t* buf, int buf_size)
 	return buf_size;
 }
 
+// the last reference to a packet of the packet input (or to a frame decoded from it) went away
+void release_packet_buffer(void* opaque, uint8_t* data)
+{
+	PacketScaleQueue* raw_packet = static_cast<PacketScaleQueue*>(opaque);
+	Buffer buffer = { data, static_cast<unsigned int>(raw_packet->getBufferSize()) };
+	raw_packet->pushPacket(buffer);
+}
+
 char* err2str(int errnum)
 {
 	char errbuf[AV_ERROR_MAX_STRING_SIZE];
@@ -20,11 +28,8 @@ char* err2str(int errnum)
 	return av_make_error_string(errbuf, AV_ERROR_MAX_STRING_SIZE, errnum);
 }
 
-int encode_write_one_frame(CodecQueue& codec_queue, CodecCtx* codec_ctx)
+int encode_write_one_frame(AVFrame* filt_frame, CodecCtx* codec_ctx)
 {
-	AVFrame* filt_frame = nullptr;
-	codec_queue.popEncode(&filt_frame);
-	if (!filt_frame) return -1;
 	//fprintf(stderr, "#### line: %d; linesize: %d, %d, %d, %d; width: %d, height: %d\n", __LINE__,
 	//	filt_frame->linesize[0], filt_frame->linesize[1], filt_frame->linesize[2], filt_frame->linesize[3],
 	//	filt_frame->width, filt_frame->height);
@@ -69,22 +74,21 @@ int encode_write_one_frame(CodecQueue& codec_queue, CodecCtx* codec_ctx)
 		codec_ctx->frame_count++;
 	}
 
-	av_frame_free(&filt_frame);
-	filt_frame = nullptr;
-	codec_queue.pushDecode(&filt_frame);
 	return 0;
 }
 
+// runs until the queue is closed and drained
 void encode_write_frame(CodecQueue& codec_queue, CodecCtx* codec_ctx)
 {
-	while (!codec_ctx->encode_thread_end) {
-		auto ret = encode_write_one_frame(codec_queue, codec_ctx);
+	AVFrame* filt_frame = nullptr;
+	while (codec_queue.popEncode(&filt_frame)) {
+		auto ret = encode_write_one_frame(filt_frame, codec_ctx);
 		if (ret != 0) {
 			fprintf(stderr, "#### Warning: encode_write_one_frame: %d\n", ret);
 			//break;
 		}
+		av_frame_free(&filt_frame);
 	}
-	codec_ctx->exit_encode_thread = true;
 }
 
 } // namespace
@@ -105,6 +109,10 @@ int VideoCodec::openEncode()
 	strcpy(codec_ctx_->pixel_format, pixel_format_.c_str());
 	strcpy(codec_ctx_->filter_descr, filter_descr_.c_str());
 
+	// the decoder is fed directly by processEncode
+	if (packet_input_)
+		return 0;
+
 	uint8_t* avio_ctx_buffer = static_cast<uint8_t*>(av_malloc(block_size_));
 	if (!avio_ctx_buffer) {
 		fprintf(stderr, "Error: avio_ctx_buffer malloc failed\n");
@@ -182,6 +190,73 @@ int VideoCodec::get_decode_context()
 	return 0;
 }
 
+// the decoder of the packet input, set up with what the rawvideo demuxer gets from the video_size and pixel_format options
+int VideoCodec::get_packet_decode_context()
+{
+	AVCodec* decoder = avcodec_find_decoder(AV_CODEC_ID_RAWVIDEO);
+	if (!decoder) {
+		av_log(nullptr, AV_LOG_ERROR, "Failed to find the rawvideo decoder\n");
+		return AVERROR_DECODER_NOT_FOUND;
+	}
+
+	codec_ctx_->stream_index = 0;
+	AVCodecContext* avcodec_ctx = avcodec_alloc_context3(decoder);
+	if (!avcodec_ctx) {
+		av_log(nullptr, AV_LOG_ERROR, "Failed to allocate the decoder context\n");
+		return AVERROR(ENOMEM);
+	}
+
+	auto ret = av_parse_video_size(&avcodec_ctx->width, &avcodec_ctx->height, codec_ctx_->video_size);
+	if (ret < 0) {
+		av_log(nullptr, AV_LOG_ERROR, "Invalid video size: %s\n", codec_ctx_->video_size);
+		return ret;
+	}
+	avcodec_ctx->pix_fmt = av_get_pix_fmt(codec_ctx_->pixel_format);
+	if (avcodec_ctx->pix_fmt == AV_PIX_FMT_NONE) {
+		av_log(nullptr, AV_LOG_ERROR, "Invalid pixel format: %s\n", codec_ctx_->pixel_format);
+		return AVERROR(EINVAL);
+	}
+	avcodec_ctx->time_base = av_inv_q(codec_ctx_->frame_rate);
+	avcodec_ctx->pkt_timebase = avcodec_ctx->time_base;
+	avcodec_ctx->framerate = codec_ctx_->frame_rate;
+
+	ret = avcodec_open2(avcodec_ctx, decoder, nullptr);
+	if (ret < 0) {
+		av_log(nullptr, AV_LOG_ERROR, "Failed to open the rawvideo decoder\n");
+		return ret;
+	}
+	codec_ctx_->dec_ctx = avcodec_ctx;
+	codec_ctx_->dec_frame = av_frame_alloc();
+	if (!codec_ctx_->dec_frame)
+		return AVERROR(ENOMEM);
+	return 0;
+}
+
+// wraps the next filled buffer of the raw packet queue without a copy, the rawvideo decoder references it in the
+// decoded frame, so the buffer goes back to the queue when the last frame which uses it is released
+int VideoCodec::get_packet(AVPacket* packet)
+{
+	Buffer buffer;
+	raw_packet_queue_.popScale(buffer);
+	if (codec_ctx_->term_status) { // the buffer of stopEncode
+		raw_packet_queue_.pushPacket(buffer);
+		return AVERROR_EOF;
+	}
+
+	packet->buf = av_buffer_create(buffer.data, block_size_, &release_packet_buffer, &raw_packet_queue_, 0);
+	if (!packet->buf) {
+		raw_packet_queue_.pushPacket(buffer);
+		return AVERROR(ENOMEM);
+	}
+
+	packet->data = buffer.data;
+	packet->size = block_size_;
+	packet->stream_index = codec_ctx_->stream_index;
+	packet->pts = packet->dts = codec_ctx_->packet_count++; // in the time base of the decoder
+	packet->flags |= AV_PKT_FLAG_KEY;
+	return 0;
+}
+
 int VideoCodec::init_filters()
 {
 	AVFilterContext* buffersrc_ctx = nullptr;
@@ -396,9 +471,12 @@ int VideoCodec::filter_encode_write_frame(AVFrame* frame)
 
 		filt_frame->pict_type = AV_PICTURE_TYPE_NONE;
 
-		AVFrame* tmp = nullptr;
-		codec_queue_.popDecode(&tmp);
-		codec_queue_.pushEncode(&filt_frame);
+		// waits while the encode thread is behind
+		if (!codec_queue_.pushEncode(&filt_frame)) {
+			av_frame_free(&filt_frame);
+			ret = AVERROR_EOF;
+			break;
+		}
 	}
 
 	return ret;
@@ -516,14 +594,14 @@ int VideoCodec::flush_encoder()
 
 void VideoCodec::flush_codec()
 {
+	// the frames left in the decoder and the filtergraph still go through the encode thread
 	auto ret = flush_decoder();
 	if (ret != 0)
 		fprintf(stderr, "Warning: flush_decoder: %d\n", ret);
 
-	while (codec_queue_.getEncodeSize() > 0) {
-		if (encode_write_one_frame(codec_queue_, codec_ctx_) != 0)
-			break;
-	}
+	// the encode thread writes the queued frames and exits, then the encoder is drained here
+	codec_queue_.close();
+	encode_thread_.join();
 
 	if ((ret = flush_encoder()) != 0)
 		fprintf(stderr, "Warning: flush_encoder: %d\n", ret);
@@ -543,7 +621,6 @@ int VideoCodec::processEncode()
 	}
 
 	codec_queue_.init(10);
-	codec_ctx_->encode_thread_end = false;
 	encode_thread_ = std::thread(encode_write_frame, std::ref(codec_queue_), codec_ctx_);
 
 	codec_ctx_->ofmt_ctx = (AVFormatContext*)malloc(sizeof(AVFormatContext));
@@ -553,7 +630,7 @@ int VideoCodec::processEncode()
 	}
 	memset(codec_ctx_->ofmt_ctx, 0, sizeof(AVFormatContext));
 
-	auto ret = get_decode_context();
+	auto ret = packet_input_ ? get_packet_decode_context() : get_decode_context();
 	if (ret != 0) {
 		fprintf(stderr, "Error: fail to get_decode_context: %d\n", ret);
 		return -1;
@@ -579,7 +656,9 @@ int VideoCodec::processEncode()
 
 	int total_frames = 0;
 	while (!codec_ctx_->term_status) {
-		if ((ret = av_read_frame(ifmt_ctx, packet)) < 0) {
+		if ((ret = packet_input_ ? get_packet(packet) : av_read_frame(ifmt_ctx, packet)) < 0) {
+			if (packet_input_ && ret == AVERROR_EOF)
+				ret = 0;
 			break;
 		}
 
@@ -589,9 +668,10 @@ int VideoCodec::processEncode()
 			continue;
 		}
 
-		av_packet_rescale_ts(packet,
-			ifmt_ctx->streams[codec_ctx_->stream_index]->time_base,
-			codec_ctx_->dec_ctx->time_base);
+		if (!packet_input_)
+			av_packet_rescale_ts(packet,
+				ifmt_ctx->streams[codec_ctx_->stream_index]->time_base,
+				codec_ctx_->dec_ctx->time_base);
 
 		ret = avcodec_send_packet(codec_ctx_->dec_ctx, packet);
 		if (ret < 0) {
@@ -628,9 +708,6 @@ int VideoCodec::processEncode()
 		av_packet_unref(packet);
 	}
 		
-	codec_ctx_->encode_thread_end = true;
-	while (!codec_ctx_->exit_encode_thread)
-		std::this_thread::sleep_for(std::chrono::milliseconds(10));
 	flush_codec();
 	av_packet_free(&packet);
 
@@ -641,7 +718,9 @@ int VideoCodec::processEncode()
 
 int VideoCodec::closeEncode()
 {
-	encode_thread_.join();
+	codec_queue_.close();
+	if (encode_thread_.joinable())
+		encode_thread_.join();
 	codec_queue_.release();
 
 	avcodec_free_context(&codec_ctx_->dec_ctx);
@@ -2,11 +2,9 @@
 #define FBC_FFMPEG_TEST_COMMON_HPP_
 
 #include <chrono>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 #include <string>
 #include <thread>
+#include "ring_queue.hpp"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +13,8 @@ extern "C" {
 #include <libavutil/error.h>
 #include <libavutil/frame.h>
 #include <libavutil/opt.h>
+#include <libavutil/parseutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavformat/avio.h>
 #include <libavformat/avformat.h>
 #include <libavfilter/avfilter.h>
@@ -47,36 +47,8 @@ typedef struct Buffer {
 	unsigned int length;
 } Buffer;
 
-class BufferQueue {
-public:
-	BufferQueue() = default;
-	~BufferQueue() {}
-
-	void push(Buffer& buffer) {
-		std::unique_lock<std::mutex> lck(mtx);
-		queue.push(buffer);
-		cv.notify_all();
-	}
-
-	void pop(Buffer& buffer) {
-		std::unique_lock<std::mutex> lck(mtx);
-		while (queue.empty()) {
-			cv.wait(lck);
-		}
-		buffer = queue.front();
-		queue.pop();
-	}
-
-	size_t size() const {
-		return queue.size();
-	}
-
-private:
-	std::queue<Buffer> queue;
-	std::mutex mtx;
-	std::condition_variable cv;
-};
-
+// a pool of preallocated buffers: the producer takes a free buffer (popPacket), fills it and passes it on (pushScale),
+// the consumer takes the filled buffer (popScale) and gives it back to the pool (pushPacket)
 class PacketScaleQueue {
 public:
 	PacketScaleQueue() = default;
@@ -84,107 +56,71 @@ public:
 	~PacketScaleQueue() {
 		Buffer buffer;
 
-		while (getPacketSize() > 0) {
-			popPacket(buffer);
+		while (packet_queue.tryPop(buffer))
 			delete[] buffer.data;
-		}
 
-		while (getScaleSize() > 0) {
-			popScale(buffer);
+		while (scale_queue.tryPop(buffer))
 			delete[] buffer.data;
-		}
 	}
 
+	// the buffers carry the zeroed padding of AVPacket data, so they can be handed to the decoder without a copy
 	void init(unsigned int buffer_num = 16, size_t buffer_size = 1024 * 1024 * 4) {
+		packet_queue.reset(buffer_num);
+		scale_queue.reset(buffer_num);
+		buffer_size_ = buffer_size;
+
 		for (auto i = 0; i < buffer_num; ++i) {
-			Buffer buffer = { new unsigned char[buffer_size], buffer_num};
+			Buffer buffer = { new unsigned char[buffer_size + AV_INPUT_BUFFER_PADDING_SIZE], static_cast<unsigned int>(buffer_size) };
+			memset(buffer.data + buffer_size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
 			pushPacket(buffer);
 		}
 	}
 
+	size_t getBufferSize() const { return buffer_size_; }
+
 	void pushPacket(Buffer& buffer) { packet_queue.push(buffer); }
 	void popPacket(Buffer& buffer) { packet_queue.pop(buffer); }
 	size_t getPacketSize() const { return packet_queue.size(); }
+	RingQueueStats getPacketStats() const { return packet_queue.getStats(); }
 
 	void pushScale(Buffer& buffer) { scale_queue.push(buffer); }
 	void popScale(Buffer& buffer) { scale_queue.pop(buffer); }
 	size_t getScaleSize() const { return scale_queue.size(); }
+	RingQueueStats getScaleStats() const { return scale_queue.getStats(); }
 
 private:
-	BufferQueue packet_queue, scale_queue;
-};
-
-class AVFrameQueue {
-public:
-	AVFrameQueue() = default;
-	~AVFrameQueue() {}
-
-	void push(AVFrame** frame) {
-		std::unique_lock<std::mutex> lck(mtx);
-		queue.push(*frame);
-		cv.notify_all();
-	}
-
-	void pop(AVFrame** frame) {
-		std::unique_lock<std::mutex> lck(mtx);
-		while (queue.empty()) {
-			//cv.wait(lck);
-			if (cv.wait_for(lck, std::chrono::milliseconds(50)) == std::cv_status::timeout) {
-				fprintf(stderr, "#### Warning: wait timeout\n");
-				*frame = nullptr;
-				return;
-			}
-		}
-		*frame = queue.front();
-		queue.pop();
-	}
-
-	size_t size() const {
-		return queue.size();
-	}
-
-private:
-	std::queue<AVFrame*> queue;
-	std::mutex mtx;
-	std::condition_variable cv;
+	MPMCRingQueue<Buffer> packet_queue; // the free buffers
+	SPSCRingQueue<Buffer> scale_queue; // the filled buffers, one thread pushes and one thread pops at a time
+	size_t buffer_size_ = 0;
 };
 
+// the filtered frames on their way to the encode thread
 class CodecQueue {
 public:
 	CodecQueue() = default;
-	void init(unsigned int frame_num) {
-		for (auto i = 0; i < frame_num; ++i) {
-			AVFrame* frame = nullptr;
-			pushDecode(&frame);
-		}
-	}
-
 	~CodecQueue() { release(); }
 
+	// at most frame_num frames wait for the encoder, pushEncode blocks when it falls behind
+	void init(unsigned int frame_num) { encode_queue.reset(frame_num); }
+
 	void release() {
 		AVFrame* frame = nullptr;
 
-		while (getDecodeSize() > 0) {
-			popDecode(&frame);
+		while (encode_queue.tryPop(frame))
 			av_frame_free(&frame);
-		}
-
-		while (getEncodeSize() > 0) {
-			popEncode(&frame);
-			av_frame_free(&frame);
-		}
 	}
 
-	void pushDecode(AVFrame** frame) { decode_queue.push(frame); }
-	void popDecode(AVFrame** frame) { decode_queue.pop(frame); }
-	size_t getDecodeSize() const { return decode_queue.size(); }
-
-	void pushEncode(AVFrame** frame) { encode_queue.push(frame); }
-	void popEncode(AVFrame** frame) { encode_queue.pop(frame); }
+	// false once the queue is closed, the frame is then still owned by the caller
+	bool pushEncode(AVFrame** frame) { return encode_queue.push(*frame); }
+	// false once the queue is closed and all its frames were taken
+	bool popEncode(AVFrame** frame) { return encode_queue.pop(*frame); }
 	size_t getEncodeSize() const { return encode_queue.size(); }
+	RingQueueStats getEncodeStats() const { return encode_queue.getStats(); }
+	// no more frames, wakes the encode thread
+	void close() { encode_queue.close(); }
 
 private:
-	AVFrameQueue decode_queue, encode_queue;
+	SPSCRingQueue<AVFrame*> encode_queue;
 };
 
 typedef struct CodecCtx {
@@ -206,8 +142,7 @@ typedef struct CodecCtx {
 	int term_status;
 	int stream_index;
 	int frame_count;
-	bool encode_thread_end;
-	bool exit_encode_thread;
+	int64_t packet_count;
 } CodecCtx;
 
 class VideoCodec {
@@ -219,6 +154,10 @@ public:
 	void setVideoSize(const std::string& size) { video_size_ = size; }
 	void setPixelFormat(const std::string& format) { pixel_format_ = format; }
 	void setFilterDescr(const std::string& filter_descr) { filter_descr_ = filter_descr; }
+	// true: the filled buffers of the raw packet queue go to the rawvideo decoder as refcounted AVPackets, which
+	// return them to the queue when the decoded frames are released; false: they are read through AVIO and the
+	// rawvideo demuxer, which copy every frame twice
+	void setPacketInput(bool packet_input) { packet_input_ = packet_input; }
 
 	void stopEncode() {
 		while (raw_packet_queue_.getScaleSize() > 0) {
@@ -249,6 +188,7 @@ private:
 	std::string video_size_ = "";
 	std::string pixel_format_ = "";
 	std::string filter_descr_ = "";
+	bool packet_input_ = false;
 	PacketScaleQueue raw_packet_queue_;
 	int block_size_ = 0;
 	CodecCtx* codec_ctx_ = nullptr;
@@ -257,6 +197,8 @@ private:
 	std::thread encode_thread_;
 
 	int get_decode_context();
+	int get_packet_decode_context();
+	int get_packet(AVPacket* packet);
 	int get_encode_context();
 	int init_filters();
 	int filter_encode_write_frame(AVFrame* frame);
@@ -27,6 +27,7 @@ int test_ffmpeg_usb_stream();
 int test_ffmpeg_rtsp_client();
 int test_ffmpeg_decode_dshow();
 int test_ffmpeg_dshow_mjpeg_encode_libyuv_decode();
+int test_ring_queue_blocking(); // the rings between the threads of the tests, with producers and consumers both blocked
 
 // libavfilter
 int test_ffmpeg_libavfilter_movie(const char* filename);
@@ -63,6 +64,7 @@ int test_ffmpeg_libavutil_base64(); // base64 codec
 
 /////////////////////////// LIVE555 /////////////////////////////
 int test_live555_rtsp_client();
+int test_rtsp_ingest(); // several RTSP streams of a local RTSP server on one event loop and a shared decoder pool
 
 /////////////////////////// V4L2 ///////////////////////////////
 int test_v4l2_usb_stream();
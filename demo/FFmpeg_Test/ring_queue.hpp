@@ -0,0 +1,447 @@
+#ifndef FBC_FFMPEG_TEST_RING_QUEUE_HPP_
+#define FBC_FFMPEG_TEST_RING_QUEUE_HPP_
+
+// Bounded lock-free ring buffers to pass buffers and frames between threads:
+//     SPSCRingQueue: one producer thread and one consumer thread (packet -> decode, filter -> encode),
+//     MPMCRingQueue: any number of producer and consumer threads (worker pools, pools of free buffers).
+// The capacity is fixed (rounded up to a power of two). tryPush/tryPop never block, push/pop block while the
+// queue is full/empty (backpressure) and come with a timed variant. A blocked thread spins a little and then sleeps
+// on a condition variable, the mutex is only taken when a thread really sleeps, so a push or pop on a queue which is
+// neither full nor empty never takes a lock and wakes nobody.
+// After close() push fails and pop returns the remaining items, then fails, which lets the consumers exit.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+typedef struct RingQueueStats {
+	size_t capacity;
+	size_t size; // current occupancy
+	size_t max_size; // highest occupancy seen after a push
+	uint64_t pushed;
+	uint64_t popped;
+	uint64_t full_waits; // pushes which found the queue full and had to wait (backpressure)
+	uint64_t empty_waits; // pops which found the queue empty and had to wait
+	uint64_t timeouts; // timed pushes and pops which gave up
+	double avg_latency_us; // average time the popped items spent in the queue
+	double max_latency_us;
+} RingQueueStats;
+
+namespace ring_queue_detail {
+
+constexpr size_t cache_line_size = 64;
+
+inline size_t roundUpPow2(size_t n)
+{
+	size_t c = 1;
+	while (c < n) c <<= 1;
+	return c;
+}
+
+inline int64_t nowNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+template<typename V>
+inline void updateMax(std::atomic<V>& target, V value)
+{
+	V current = target.load(std::memory_order_relaxed);
+	while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+// the threads waiting for a state change of a queue (not empty or not full)
+class WaitEvent {
+public:
+	// returns the last result of ready(), which is retried until it succeeds or the deadline passes;
+	// ready() runs without the mutex: it may notify the other event of the queue, whose waiters sleep under its mutex
+	template<typename Ready>
+	bool wait(Ready ready, std::chrono::steady_clock::time_point deadline) {
+		for (int i = 0; i < spin_count; ++i) {
+			if (ready()) return true;
+			if (i < spin_count / 2) cpuRelax();
+			else std::this_thread::yield();
+		}
+
+		// pairs with the read-modify-write of notify(): either notify() sees the waiter or ready() sees the new state
+		waiters.fetch_add(1, std::memory_order_acq_rel);
+		bool ok = false;
+		std::unique_lock<std::mutex> lck(mtx);
+		while (true) {
+			uint64_t seen = generation;
+			lck.unlock();
+			ok = ready();
+			if (ok) break;
+
+			lck.lock();
+			if (generation != seen) continue; // notified while ready() ran
+			if (deadline == std::chrono::steady_clock::time_point::max()) {
+				cv.wait(lck);
+			} else if (cv.wait_until(lck, deadline) == std::cv_status::timeout && generation == seen) {
+				lck.unlock();
+				ok = ready();
+				break;
+			}
+		}
+		waiters.fetch_sub(1, std::memory_order_relaxed);
+		return ok;
+	}
+
+	// called after the state changed, never with the mutex of a WaitEvent held
+	void notify() {
+		if (waiters.fetch_add(0, std::memory_order_acq_rel) > 0) {
+			// a waiter compares the generation under the mutex before it sleeps, so the notification can't get lost
+			{
+				std::lock_guard<std::mutex> lck(mtx);
+				++generation;
+			}
+			cv.notify_all();
+		}
+	}
+
+private:
+	static constexpr int spin_count = 64;
+
+	std::atomic<int> waiters{ 0 };
+	std::mutex mtx;
+	uint64_t generation = 0; // notifications so far, guarded by mtx
+	std::condition_variable cv;
+};
+
+// blocking, timed and non-blocking push/pop, close and statistics on top of the tryPushImpl/tryPopImpl of Queue
+template<typename Queue, typename T>
+class RingQueueBase {
+public:
+	// false if the queue is full or closed, v is only moved from if the push succeeds
+	template<typename U>
+	bool tryPush(U&& v) {
+		if (closed.load(std::memory_order_acquire) || !queue().tryPushImpl(std::forward<U>(v)))
+			return false;
+		not_empty.notify();
+		return true;
+	}
+
+	// waits while the queue is full, false if the queue is closed
+	template<typename U>
+	bool push(U&& v) { return pushUntil(std::forward<U>(v), std::chrono::steady_clock::time_point::max()); }
+
+	template<typename U, typename Rep, typename Period>
+	bool push(U&& v, const std::chrono::duration<Rep, Period>& timeout) {
+		return pushUntil(std::forward<U>(v), std::chrono::steady_clock::now() + timeout);
+	}
+
+	// false if the queue is empty
+	bool tryPop(T& v) {
+		if (!queue().tryPopImpl(v))
+			return false;
+		not_full.notify();
+		return true;
+	}
+
+	// waits while the queue is empty, false if the queue is closed and empty
+	bool pop(T& v) { return popUntil(v, std::chrono::steady_clock::time_point::max()); }
+
+	template<typename Rep, typename Period>
+	bool pop(T& v, const std::chrono::duration<Rep, Period>& timeout) {
+		return popUntil(v, std::chrono::steady_clock::now() + timeout);
+	}
+
+	// wakes all the blocked threads, the later pushes fail
+	void close() {
+		closed.store(true, std::memory_order_release);
+		not_empty.notify();
+		not_full.notify();
+	}
+
+	bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+	size_t size() const {
+		size_t pushed = queue().pushedCount(), popped = queue().poppedCount();
+		return pushed > popped ? pushed - popped : 0;
+	}
+
+	bool empty() const { return size() == 0; }
+
+	RingQueueStats getStats() const {
+		RingQueueStats stats;
+		stats.capacity = queue().capacity();
+		stats.pushed = queue().pushedCount();
+		stats.popped = queue().poppedCount();
+		stats.size = stats.pushed > stats.popped ? (size_t)(stats.pushed - stats.popped) : 0;
+		stats.max_size = producer_stats.max_size.load(std::memory_order_relaxed);
+		stats.full_waits = producer_stats.full_waits.load(std::memory_order_relaxed);
+		stats.empty_waits = consumer_stats.empty_waits.load(std::memory_order_relaxed);
+		stats.timeouts = producer_stats.timeouts.load(std::memory_order_relaxed) + consumer_stats.timeouts.load(std::memory_order_relaxed);
+		uint64_t latency_count = consumer_stats.latency_count.load(std::memory_order_relaxed);
+		stats.avg_latency_us = latency_count > 0 ? consumer_stats.latency_sum.load(std::memory_order_relaxed) / 1000. / latency_count : 0.;
+		stats.max_latency_us = consumer_stats.latency_max.load(std::memory_order_relaxed) / 1000.;
+		return stats;
+	}
+
+protected:
+	// not thread safe, the queue must not be in use
+	void resetBase() {
+		closed.store(false, std::memory_order_relaxed);
+		producer_stats.max_size.store(0, std::memory_order_relaxed);
+		producer_stats.full_waits.store(0, std::memory_order_relaxed);
+		producer_stats.timeouts.store(0, std::memory_order_relaxed);
+		consumer_stats.empty_waits.store(0, std::memory_order_relaxed);
+		consumer_stats.timeouts.store(0, std::memory_order_relaxed);
+		consumer_stats.latency_count.store(0, std::memory_order_relaxed);
+		consumer_stats.latency_sum.store(0, std::memory_order_relaxed);
+		consumer_stats.latency_max.store(0, std::memory_order_relaxed);
+	}
+
+	// called by the implementations after a push/pop succeeded
+	void recordPush(size_t pushed) {
+		size_t popped = queue().poppedCount();
+		updateMax(producer_stats.max_size, pushed > popped ? pushed - popped : (size_t)0);
+	}
+
+	void recordPop(int64_t timestamp) {
+		int64_t latency = nowNanoseconds() - timestamp;
+		consumer_stats.latency_count.fetch_add(1, std::memory_order_relaxed);
+		consumer_stats.latency_sum.fetch_add(latency, std::memory_order_relaxed);
+		updateMax(consumer_stats.latency_max, latency);
+	}
+
+private:
+	Queue& queue() { return *static_cast<Queue*>(this); }
+	const Queue& queue() const { return *static_cast<const Queue*>(this); }
+
+	template<typename U>
+	bool pushUntil(U&& v, std::chrono::steady_clock::time_point deadline) {
+		// v is forwarded more than once, tryPush only moves from it when it succeeds
+		if (tryPush(std::forward<U>(v))) return true;
+		if (isClosed()) return false;
+
+		producer_stats.full_waits.fetch_add(1, std::memory_order_relaxed);
+		bool pushed = false;
+		not_full.wait([&]() { return (pushed = tryPush(std::forward<U>(v))) || isClosed(); }, deadline);
+		if (!pushed && !isClosed()) producer_stats.timeouts.fetch_add(1, std::memory_order_relaxed);
+		return pushed;
+	}
+
+	bool popUntil(T& v, std::chrono::steady_clock::time_point deadline) {
+		if (tryPop(v)) return true;
+
+		consumer_stats.empty_waits.fetch_add(1, std::memory_order_relaxed);
+		bool popped = false;
+		// a closed queue is drained before pop fails
+		not_empty.wait([&]() { return (popped = tryPop(v)) || isClosed(); }, deadline);
+		if (!popped && isClosed()) popped = tryPop(v);
+		if (!popped && !isClosed()) consumer_stats.timeouts.fetch_add(1, std::memory_order_relaxed);
+		return popped;
+	}
+
+	std::atomic<bool> closed{ false };
+	// the counters of the producers and of the consumers are on separate cache lines
+	struct alignas(cache_line_size) ProducerStats {
+		std::atomic<size_t> max_size{ 0 };
+		std::atomic<uint64_t> full_waits{ 0 }, timeouts{ 0 };
+	} producer_stats;
+	struct alignas(cache_line_size) ConsumerStats {
+		std::atomic<uint64_t> empty_waits{ 0 }, timeouts{ 0 }, latency_count{ 0 };
+		std::atomic<int64_t> latency_sum{ 0 }, latency_max{ 0 };
+	} consumer_stats;
+	WaitEvent not_empty, not_full;
+};
+
+} // namespace ring_queue_detail
+
+// Single producer, single consumer: a ring of slots indexed by two monotonic counters, each side caches the counter of
+// the other side and only reloads it when the ring looks full or empty. At most one thread may push and one thread
+// may pop at a time; another thread may take over a side once the previous one is done with it (joined, or handed
+// over through a mutex or atomic)
+template<typename T>
+class SPSCRingQueue : public ring_queue_detail::RingQueueBase<SPSCRingQueue<T>, T> {
+	typedef ring_queue_detail::RingQueueBase<SPSCRingQueue<T>, T> Base;
+	friend Base;
+
+public:
+	explicit SPSCRingQueue(size_t capacity = 0) { reset(capacity); }
+	SPSCRingQueue(const SPSCRingQueue&) = delete;
+	SPSCRingQueue& operator = (const SPSCRingQueue&) = delete;
+
+	// sets the capacity and drops the items, not thread safe
+	void reset(size_t capacity) {
+		mask = capacity > 0 ? ring_queue_detail::roundUpPow2(capacity) - 1 : 0;
+		slots.reset(capacity > 0 ? new Slot[mask + 1] : nullptr);
+		head.value.store(0, std::memory_order_relaxed);
+		tail.value.store(0, std::memory_order_relaxed);
+		head_cache = tail_cache = 0;
+		this->resetBase();
+	}
+
+	size_t capacity() const { return slots ? mask + 1 : 0; }
+
+private:
+	struct Slot {
+		T value;
+		int64_t timestamp;
+	};
+
+	template<typename U>
+	bool tryPushImpl(U&& v) {
+		size_t t = tail.value.load(std::memory_order_relaxed);
+		if (t - head_cache > mask || !slots) {
+			head_cache = head.value.load(std::memory_order_acquire);
+			if (t - head_cache > mask || !slots) return false;
+		}
+
+		Slot& slot = slots[t & mask];
+		slot.value = std::forward<U>(v);
+		slot.timestamp = ring_queue_detail::nowNanoseconds();
+		tail.value.store(t + 1, std::memory_order_release);
+		this->recordPush(t + 1);
+		return true;
+	}
+
+	bool tryPopImpl(T& v) {
+		size_t h = head.value.load(std::memory_order_relaxed);
+		if (h == tail_cache) {
+			tail_cache = tail.value.load(std::memory_order_acquire);
+			if (h == tail_cache) return false;
+		}
+
+		Slot& slot = slots[h & mask];
+		v = std::move(slot.value);
+		this->recordPop(slot.timestamp);
+		head.value.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t pushedCount() const { return tail.value.load(std::memory_order_acquire); }
+	size_t poppedCount() const { return head.value.load(std::memory_order_acquire); }
+
+	struct alignas(ring_queue_detail::cache_line_size) Index {
+		std::atomic<size_t> value{ 0 };
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask = 0;
+	// the consumer side: its counter and its copy of the producer counter
+	Index head;
+	alignas(ring_queue_detail::cache_line_size) size_t tail_cache = 0;
+	// the producer side
+	Index tail;
+	alignas(ring_queue_detail::cache_line_size) size_t head_cache = 0;
+};
+
+// Multiple producers, multiple consumers (D. Vyukov's bounded queue): every cell carries a sequence number which
+// tells whether it is free for the push of a position or holds the item for the pop of a position, the producers and
+// the consumers claim their positions with a compare-and-swap on their counter
+template<typename T>
+class MPMCRingQueue : public ring_queue_detail::RingQueueBase<MPMCRingQueue<T>, T> {
+	typedef ring_queue_detail::RingQueueBase<MPMCRingQueue<T>, T> Base;
+	friend Base;
+
+public:
+	explicit MPMCRingQueue(size_t capacity = 0) { reset(capacity); }
+	MPMCRingQueue(const MPMCRingQueue&) = delete;
+	MPMCRingQueue& operator = (const MPMCRingQueue&) = delete;
+
+	// sets the capacity (at least 2) and drops the items, not thread safe
+	void reset(size_t capacity) {
+		mask = capacity > 0 ? ring_queue_detail::roundUpPow2(capacity < 2 ? 2 : capacity) - 1 : 0;
+		cells.reset(capacity > 0 ? new Cell[mask + 1] : nullptr);
+		for (size_t i = 0; cells && i <= mask; ++i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		enqueue_pos.value.store(0, std::memory_order_relaxed);
+		dequeue_pos.value.store(0, std::memory_order_relaxed);
+		this->resetBase();
+	}
+
+	size_t capacity() const { return cells ? mask + 1 : 0; }
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+		int64_t timestamp;
+	};
+
+	template<typename U>
+	bool tryPushImpl(U&& v) {
+		if (!cells) return false;
+
+		Cell* cell;
+		size_t pos = enqueue_pos.value.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &cells[pos & mask];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (enqueue_pos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false; // full
+			} else {
+				pos = enqueue_pos.value.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->value = std::forward<U>(v);
+		cell->timestamp = ring_queue_detail::nowNanoseconds();
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		this->recordPush(pos + 1);
+		return true;
+	}
+
+	bool tryPopImpl(T& v) {
+		if (!cells) return false;
+
+		Cell* cell;
+		size_t pos = dequeue_pos.value.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &cells[pos & mask];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (dequeue_pos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0) {
+				return false; // empty
+			} else {
+				pos = dequeue_pos.value.load(std::memory_order_relaxed);
+			}
+		}
+
+		v = std::move(cell->value);
+		this->recordPop(cell->timestamp);
+		cell->sequence.store(pos + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t pushedCount() const { return enqueue_pos.value.load(std::memory_order_acquire); }
+	size_t poppedCount() const { return dequeue_pos.value.load(std::memory_order_acquire); }
+
+	struct alignas(ring_queue_detail::cache_line_size) Index {
+		std::atomic<size_t> value{ 0 };
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask = 0;
+	Index enqueue_pos;
+	Index dequeue_pos;
+};
+
+#endif // FBC_FFMPEG_TEST_RING_QUEUE_HPP_
@@ -0,0 +1,809 @@
+#include "rtsp_ingest.hpp"
+#include <string.h>
+#include <cmath>
+#include <mutex>
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#include <GroupsockHelper.hh>
+#include "common.hpp"
+
+namespace {
+
+constexpr unsigned housekeeping_interval_us = 100000;
+constexpr int64_t stats_interval_ns = 1000000000;
+// access units a decode thread takes from a stream before it goes on with the other streams
+constexpr int decode_batch_size = 4;
+// free space below which the next NAL unit is not received into the access unit any more
+constexpr size_t min_receive_space = 1024;
+
+const uint8_t start_code[4] = { 0, 0, 0, 1 };
+
+using ring_queue_detail::nowNanoseconds;
+
+} // namespace
+
+// an access unit with the time it was complete, a null packet ends a session: the decoder is drained and released
+typedef struct IngestPacket {
+	AVPacket* packet;
+	int64_t receive_time;
+} IngestPacket;
+
+struct IngestStream {
+	IngestStream() { memset(&stats, 0, sizeof(stats)); }
+
+	int index = 0;
+	std::string url;
+	const RtspIngestConfig* config = nullptr;
+	MPMCRingQueue<IngestStream*>* ready_queue = nullptr;
+
+	// the network thread
+	UsageEnvironment* env = nullptr;
+	RTSPClient* client = nullptr;
+	MediaSession* session = nullptr;
+	MediaSubsession* subsession = nullptr; // the video subsession
+	TaskToken reconnect_task = nullptr;
+	std::unique_ptr<uint8_t[]> au_data; // the access unit being received, Annex B
+	size_t au_size = 0;
+	int64_t au_pts = 0;
+	bool au_key = false;
+	bool au_vcl = false; // has a slice, the parameter sets and SEI before the first slice go with it
+	bool au_truncated = false;
+	std::vector<uint8_t> parameter_sets; // from the SDP, Annex B, given to the decoder with the first key frame
+	bool send_parameter_sets = false;
+	bool wait_key_frame = true;
+	bool has_data = false; // access units were queued since the last end of session
+	bool end_pending = false; // the end of session waits for room in the packet queue
+	int64_t last_receive_time = 0; // of an access unit, or the start of the session
+	int64_t last_arrival = 0, last_pts = 0;
+	double jitter = 0.; // nanoseconds
+	uint64_t rtp_lost_base = 0; // the losses of the previous sessions
+	int64_t rate_time = 0;
+	uint64_t rate_access_units = 0, rate_decoded = 0;
+
+	// network thread -> decode threads
+	SPSCRingQueue<IngestPacket> packet_queue;
+	std::atomic<int64_t> pending{ 0 }; // packets queued and not yet decoded, the stream is scheduled while it's positive
+	std::atomic<int> codec_id{ AV_CODEC_ID_NONE };
+	std::atomic<bool> finished{ false }; // no session follows the last end of session
+
+	// the decode thread which holds the stream
+	AVCodecContext* dec_ctx = nullptr;
+	AVFrame* dec_frame = nullptr;
+	uint64_t frame_sequence = 0;
+	double latency_sum = 0.;
+
+	// decode threads -> reader
+	SPSCRingQueue<IngestFrame> frame_queue;
+
+	mutable std::mutex stats_mtx;
+	IngestStreamStats stats;
+};
+
+namespace {
+
+void openStream(IngestStream& s);
+void closeSession(IngestStream& s);
+
+void setState(IngestStream& s, int state)
+{
+	std::lock_guard<std::mutex> lck(s.stats_mtx);
+	s.stats.state = state;
+}
+
+// hands the stream to the decode threads if it isn't queued or decoding yet
+void schedule(IngestStream& s)
+{
+	if (s.pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+		s.ready_queue->push(&s);
+}
+
+void pushEndOfSession(IngestStream& s)
+{
+	if (!s.end_pending) return;
+
+	IngestPacket item = { nullptr, 0 };
+	if (s.packet_queue.tryPush(item)) {
+		s.end_pending = false;
+		s.has_data = false;
+		schedule(s);
+	}
+}
+
+void dispatchAccessUnit(IngestStream& s)
+{
+	size_t size = s.au_size;
+	bool key = s.au_key, truncated = s.au_truncated;
+	s.au_size = 0;
+	s.au_key = false;
+	s.au_vcl = false;
+	s.au_truncated = false;
+	if (size == 0) {
+		// truncated in continuePlaying and nothing received since: dropped like the truncated access units below
+		if (truncated) {
+			s.wait_key_frame = true;
+			std::lock_guard<std::mutex> lck(s.stats_mtx);
+			++s.stats.access_units;
+			++s.stats.truncated;
+		}
+		return;
+	}
+
+	int64_t now = nowNanoseconds();
+	s.last_receive_time = now;
+	double jitter = -1.;
+	if (s.last_arrival != 0 && s.au_pts != s.last_pts) {
+		double d = (double)(now - s.last_arrival) - (double)(s.au_pts - s.last_pts) * 1000.;
+		s.jitter += (std::fabs(d) - s.jitter) / 16.;
+		jitter = s.jitter;
+	}
+	s.last_arrival = now;
+	s.last_pts = s.au_pts;
+
+	// the decoder can't use the frames which refer to a dropped one, so the drops go on up to the next key frame;
+	// the last slot of the queue is kept for the end of session
+	bool drop = truncated || (s.wait_key_frame && !key) || s.end_pending || s.packet_queue.size() + 1 >= s.packet_queue.capacity();
+
+	// one copy into a packet of the exact size keeps the memory of the queued access units proportional to the bitrate
+	AVPacket* packet = nullptr;
+	size_t prefix = (key && s.send_parameter_sets) ? s.parameter_sets.size() : 0;
+	if (!drop) {
+		packet = av_packet_alloc();
+		if (!packet || av_new_packet(packet, static_cast<int>(prefix + size)) < 0) {
+			av_packet_free(&packet);
+			drop = true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		++s.stats.access_units;
+		s.stats.bytes += size;
+		if (jitter >= 0.) s.stats.jitter_ms = jitter / 1000000.;
+		if (truncated) ++s.stats.truncated;
+		else if (drop) ++s.stats.dropped_packets;
+	}
+
+	if (drop) {
+		s.wait_key_frame = true;
+		return;
+	}
+
+	if (prefix > 0) memcpy(packet->data, s.parameter_sets.data(), prefix);
+	memcpy(packet->data + prefix, s.au_data.get(), size);
+	packet->pts = s.au_pts;
+	if (key) packet->flags |= AV_PKT_FLAG_KEY;
+
+	IngestPacket item = { packet, now };
+	if (!s.packet_queue.tryPush(item)) {
+		av_packet_free(&packet);
+		s.wait_key_frame = true;
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		++s.stats.dropped_packets;
+		return;
+	}
+	s.wait_key_frame = false;
+	if (prefix > 0) s.send_parameter_sets = false;
+	s.has_data = true;
+	schedule(s);
+}
+
+// a NAL unit of size bytes was received after its start code at the end of the access unit
+void receiveNalUnit(IngestStream& s, unsigned size, unsigned truncated, struct timeval presentation_time, bool marker)
+{
+	int64_t pts = (int64_t)presentation_time.tv_sec * 1000000 + presentation_time.tv_usec;
+	uint8_t* nal = s.au_data.get() + s.au_size + sizeof(start_code);
+
+	// a new presentation time starts a new access unit even if the marker of the last one was lost
+	if (s.au_vcl && pts != s.au_pts) {
+		dispatchAccessUnit(s);
+		memmove(s.au_data.get() + sizeof(start_code), nal, size);
+		nal = s.au_data.get() + sizeof(start_code);
+	}
+
+	memcpy(s.au_data.get() + s.au_size, start_code, sizeof(start_code));
+	s.au_size += sizeof(start_code) + size;
+	s.au_pts = pts;
+	if (truncated > 0) s.au_truncated = true;
+
+	bool vcl = false;
+	if (size > 0) {
+		if (s.codec_id.load(std::memory_order_relaxed) == AV_CODEC_ID_H264) {
+			int type = nal[0] & 0x1f;
+			vcl = type >= 1 && type <= 5;
+			if (type == 5) s.au_key = true; // IDR
+		} else {
+			int type = (nal[0] >> 1) & 0x3f;
+			vcl = type <= 31;
+			if (type >= 16 && type <= 23) s.au_key = true; // IRAP
+		}
+	}
+	if (vcl) s.au_vcl = true;
+
+	// the marker bit is set on the last packet of the access unit, which may carry parameter sets before its last slice
+	if (marker && vcl) dispatchAccessUnit(s);
+}
+
+// receives the NAL units of the video subsession straight into the access unit buffer of the stream
+class IngestSink : public MediaSink {
+public:
+	static IngestSink* createNew(UsageEnvironment& env, IngestStream& stream) { return new IngestSink(env, stream); }
+
+private:
+	IngestSink(UsageEnvironment& env, IngestStream& stream) : MediaSink(env), fStream(stream) {}
+
+	static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+		struct timeval presentationTime, unsigned /*durationInMicroseconds*/)
+	{
+		IngestSink* sink = (IngestSink*)clientData;
+		RTPSource* rtp_source = sink->fStream.subsession->rtpSource();
+		bool marker = rtp_source != NULL && rtp_source->curPacketMarkerBit();
+		receiveNalUnit(sink->fStream, frameSize, numTruncatedBytes, presentationTime, marker);
+		sink->continuePlaying();
+	}
+
+	virtual Boolean continuePlaying()
+	{
+		if (fSource == NULL) return False;
+
+		IngestStream& s = fStream;
+		size_t capacity = s.config->max_access_unit_size;
+		if (s.au_size + sizeof(start_code) + min_receive_space > capacity) {
+			// too large, the rest of the access unit is received over its beginning and the whole is dropped
+			s.au_size = 0;
+			s.au_truncated = true;
+		}
+
+		uint8_t* to = s.au_data.get() + s.au_size + sizeof(start_code);
+		fSource->getNextFrame(to, static_cast<unsigned>(capacity - s.au_size - sizeof(start_code)),
+			afterGettingFrame, this, onSourceClosure, this);
+		return True;
+	}
+
+	IngestStream& fStream;
+};
+
+class IngestRTSPClient : public RTSPClient {
+public:
+	static IngestRTSPClient* createNew(UsageEnvironment& env, IngestStream& stream)
+	{
+		return new IngestRTSPClient(env, stream);
+	}
+
+	IngestStream& stream;
+
+protected:
+	IngestRTSPClient(UsageEnvironment& env, IngestStream& stream)
+		: RTSPClient(env, stream.url.c_str(), stream.config->verbosity, "RtspIngest", 0, -1), stream(stream) {}
+	virtual ~IngestRTSPClient() {}
+};
+
+IngestStream& streamOf(RTSPClient* client)
+{
+	return ((IngestRTSPClient*)client)->stream;
+}
+
+void appendParameterSet(std::vector<uint8_t>& out, char const* sprop)
+{
+	if (sprop == NULL) return;
+
+	unsigned num = 0;
+	SPropRecord* records = parseSPropParameterSets(sprop, num);
+	for (unsigned i = 0; i < num; ++i) {
+		out.insert(out.end(), start_code, start_code + sizeof(start_code));
+		out.insert(out.end(), records[i].sPropBytes, records[i].sPropBytes + records[i].sPropLength);
+	}
+	delete[] records;
+}
+
+void sessionAfterPlaying(void* clientData)
+{
+	IngestStream& s = *(IngestStream*)clientData;
+	closeSession(s);
+}
+
+void sessionByeHandler(void* clientData, char const* reason)
+{
+	delete[] reason;
+	sessionAfterPlaying(clientData);
+}
+
+void continueAfterPLAY(RTSPClient* client, int resultCode, char* resultString)
+{
+	IngestStream& s = streamOf(client);
+	delete[] resultString;
+
+	if (resultCode != 0) {
+		fprintf(stderr, "fail to play: %s, result code: %d\n", s.url.c_str(), resultCode);
+		closeSession(s);
+		return;
+	}
+
+	s.last_receive_time = nowNanoseconds();
+	std::lock_guard<std::mutex> lck(s.stats_mtx);
+	s.stats.state = RTSP_INGEST_PLAYING;
+	++s.stats.sessions;
+}
+
+void continueAfterSETUP(RTSPClient* client, int resultCode, char* resultString)
+{
+	IngestStream& s = streamOf(client);
+	delete[] resultString;
+
+	if (resultCode != 0) {
+		fprintf(stderr, "fail to set up the video subsession: %s, result code: %d\n", s.url.c_str(), resultCode);
+		closeSession(s);
+		return;
+	}
+
+	s.subsession->sink = IngestSink::createNew(*s.env, s);
+	s.subsession->sink->startPlaying(*s.subsession->readSource(), sessionAfterPlaying, &s);
+	if (s.subsession->rtcpInstance() != NULL)
+		s.subsession->rtcpInstance()->setByeWithReasonHandler(sessionByeHandler, &s);
+
+	client->sendPlayCommand(*s.session, continueAfterPLAY);
+}
+
+void continueAfterDESCRIBE(RTSPClient* client, int resultCode, char* resultString)
+{
+	IngestStream& s = streamOf(client);
+
+	if (resultCode != 0) {
+		fprintf(stderr, "fail to get the SDP description: %s, result code: %d\n", s.url.c_str(), resultCode);
+		delete[] resultString;
+		closeSession(s);
+		return;
+	}
+
+	s.session = MediaSession::createNew(*s.env, resultString);
+	delete[] resultString;
+	if (s.session == NULL) {
+		fprintf(stderr, "fail to create the media session: %s: %s\n", s.url.c_str(), s.env->getResultMsg());
+		closeSession(s);
+		return;
+	}
+
+	// the first H.264 or H.265 video subsession, the others are not set up
+	MediaSubsessionIterator iter(*s.session);
+	MediaSubsession* subsession = NULL;
+	while ((subsession = iter.next()) != NULL) {
+		if (strcmp(subsession->mediumName(), "video") == 0 &&
+			(strcmp(subsession->codecName(), "H264") == 0 || strcmp(subsession->codecName(), "H265") == 0))
+			break;
+	}
+	if (subsession == NULL || !subsession->initiate()) {
+		fprintf(stderr, "no H.264/H.265 video subsession: %s\n", s.url.c_str());
+		closeSession(s);
+		return;
+	}
+	s.subsession = subsession;
+
+	if (!s.config->rtp_over_tcp && subsession->rtpSource() != NULL)
+		increaseReceiveBufferTo(*s.env, subsession->rtpSource()->RTPgs()->socketNum(), s.config->receive_buffer_size);
+
+	s.parameter_sets.clear();
+	if (strcmp(subsession->codecName(), "H264") == 0) {
+		s.codec_id.store(AV_CODEC_ID_H264, std::memory_order_relaxed);
+		appendParameterSet(s.parameter_sets, subsession->fmtp_spropparametersets());
+	} else {
+		s.codec_id.store(AV_CODEC_ID_HEVC, std::memory_order_relaxed);
+		appendParameterSet(s.parameter_sets, subsession->fmtp_spropvps());
+		appendParameterSet(s.parameter_sets, subsession->fmtp_spropsps());
+		appendParameterSet(s.parameter_sets, subsession->fmtp_sproppps());
+	}
+	s.send_parameter_sets = !s.parameter_sets.empty();
+	s.wait_key_frame = true;
+	s.au_size = 0;
+	s.au_key = false;
+	s.au_vcl = false;
+	s.au_truncated = false;
+	s.last_arrival = 0;
+	{
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		s.stats.codec_id = s.codec_id.load(std::memory_order_relaxed);
+	}
+
+	client->sendSetupCommand(*subsession, continueAfterSETUP, False, s.config->rtp_over_tcp ? True : False);
+}
+
+void reconnect(void* clientData)
+{
+	IngestStream& s = *(IngestStream*)clientData;
+	s.reconnect_task = NULL;
+	openStream(s);
+}
+
+void openStream(IngestStream& s)
+{
+	s.client = IngestRTSPClient::createNew(*s.env, s);
+	s.last_receive_time = nowNanoseconds();
+	setState(s, RTSP_INGEST_CONNECTING);
+	s.client->sendDescribeCommand(continueAfterDESCRIBE);
+}
+
+uint64_t rtpPacketsLost(IngestStream& s)
+{
+	if (s.subsession == NULL || s.subsession->rtpSource() == NULL) return 0;
+
+	uint64_t lost = 0;
+	RTPReceptionStatsDB::Iterator iter(s.subsession->rtpSource()->receptionStatsDB());
+	RTPReceptionStats* stats = NULL;
+	while ((stats = iter.next(True)) != NULL) {
+		if (stats->totNumPacketsExpected() > stats->totNumPacketsReceived())
+			lost += stats->totNumPacketsExpected() - stats->totNumPacketsReceived();
+	}
+	return lost;
+}
+
+// tears the session down, the stream is reopened later unless stopping; also when a step of the setup failed
+void closeSessionAndReconnect(IngestStream& s, bool stopping)
+{
+	if (s.client == NULL) return;
+
+	// the last access unit if its marker is missing, parameter sets without a slice are of no use
+	if (s.au_vcl) dispatchAccessUnit(s);
+
+	uint64_t lost = rtpPacketsLost(s);
+	s.rtp_lost_base += lost;
+
+	bool active = false;
+	if (s.subsession != NULL && s.subsession->sink != NULL) {
+		Medium::close(s.subsession->sink);
+		s.subsession->sink = NULL;
+		if (s.subsession->rtcpInstance() != NULL)
+			s.subsession->rtcpInstance()->setByeHandler(NULL, NULL);
+		active = true;
+	}
+	if (active) s.client->sendTeardownCommand(*s.session, NULL);
+
+	Medium::close(s.session);
+	s.session = NULL;
+	s.subsession = NULL;
+	Medium::close(s.client);
+	s.client = NULL;
+
+	bool reopen = !stopping && s.config->reconnect_delay_ms > 0;
+	{
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		s.stats.rtp_packets_lost = s.rtp_lost_base;
+		s.stats.state = reopen ? RTSP_INGEST_WAITING : RTSP_INGEST_ENDED;
+	}
+
+	if (stopping) return;
+
+	// the decoder of the stream is drained and released, the output queue is closed if no session follows
+	if (!reopen) s.finished.store(true, std::memory_order_relaxed);
+	if (s.has_data || !reopen) {
+		s.end_pending = true;
+		pushEndOfSession(s);
+	}
+
+	if (reopen)
+		s.reconnect_task = s.env->taskScheduler().scheduleDelayedTask(s.config->reconnect_delay_ms * 1000, reconnect, &s);
+}
+
+void closeSession(IngestStream& s)
+{
+	closeSessionAndReconnect(s, false);
+}
+
+// the rates of the last second and the RTP losses
+void updateRates(IngestStream& s, int64_t now)
+{
+	uint64_t lost = s.rtp_lost_base + rtpPacketsLost(s);
+
+	std::lock_guard<std::mutex> lck(s.stats_mtx);
+	s.stats.rtp_packets_lost = lost;
+	if (s.rate_time != 0) {
+		double seconds = (double)(now - s.rate_time) / 1000000000.;
+		s.stats.receive_fps = (double)(s.stats.access_units - s.rate_access_units) / seconds;
+		s.stats.decode_fps = (double)(s.stats.decoded - s.rate_decoded) / seconds;
+	}
+	s.rate_time = now;
+	s.rate_access_units = s.stats.access_units;
+	s.rate_decoded = s.stats.decoded;
+}
+
+typedef struct NetworkState {
+	std::vector<std::unique_ptr<IngestStream>>* streams;
+	std::atomic<bool>* stop_request;
+	UsageEnvironment* env;
+	char watch;
+	int64_t rate_time;
+} NetworkState;
+
+// runs in the event loop: stop request, pending ends of sessions, receive timeouts and statistics
+void housekeeping(void* clientData)
+{
+	NetworkState& state = *(NetworkState*)clientData;
+
+	if (state.stop_request->load(std::memory_order_acquire)) {
+		for (auto& stream : *state.streams) {
+			IngestStream& s = *stream;
+			state.env->taskScheduler().unscheduleDelayedTask(s.reconnect_task);
+			closeSessionAndReconnect(s, true);
+			setState(s, RTSP_INGEST_ENDED);
+		}
+		state.watch = 1;
+		return;
+	}
+
+	int64_t now = nowNanoseconds();
+	bool update_rates = now - state.rate_time >= stats_interval_ns;
+	if (update_rates) state.rate_time = now;
+
+	for (auto& stream : *state.streams) {
+		IngestStream& s = *stream;
+		pushEndOfSession(s);
+
+		// also a server which doesn't answer
+		if (s.client != NULL && s.config->receive_timeout_ms > 0 && now - s.last_receive_time > (int64_t)s.config->receive_timeout_ms * 1000000) {
+			fprintf(stderr, "no data for %d ms, close: %s\n", s.config->receive_timeout_ms, s.url.c_str());
+			closeSession(s);
+		}
+
+		if (update_rates) updateRates(s, now);
+	}
+
+	state.env->taskScheduler().scheduleDelayedTask(housekeeping_interval_us, housekeeping, &state);
+}
+
+int openDecoder(IngestStream& s)
+{
+	AVCodecID id = (AVCodecID)s.codec_id.load(std::memory_order_relaxed);
+	const AVCodec* codec = avcodec_find_decoder(id);
+	if (!codec) {
+		fprintf(stderr, "fail to avcodec_find_decoder: %d\n", id);
+		return -1;
+	}
+
+	s.dec_ctx = avcodec_alloc_context3(codec);
+	if (!s.dec_ctx) {
+		fprintf(stderr, "fail to avcodec_alloc_context3\n");
+		return -1;
+	}
+
+	// the pool decodes the streams in parallel, a decoder with its own threads would oversubscribe the cores
+	// and frame threading would delay every frame by a frame per thread
+	s.dec_ctx->thread_count = 1;
+	s.dec_ctx->pkt_timebase = AVRational{ 1, 1000000 };
+	int ret = avcodec_open2(s.dec_ctx, codec, nullptr);
+	if (ret < 0) {
+		print_error_string(ret);
+		avcodec_free_context(&s.dec_ctx);
+		return ret;
+	}
+
+	return 0;
+}
+
+void receiveFrames(IngestStream& s)
+{
+	while (1) {
+		if (!s.dec_frame && !(s.dec_frame = av_frame_alloc())) return;
+
+		int ret = avcodec_receive_frame(s.dec_ctx, s.dec_frame);
+		if (ret < 0) {
+			if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+				std::lock_guard<std::mutex> lck(s.stats_mtx);
+				++s.stats.decode_errors;
+			}
+			return;
+		}
+
+		int64_t now = nowNanoseconds();
+		IngestFrame frame = { s.dec_frame, s.index, s.frame_sequence++, s.dec_frame->best_effort_timestamp, s.dec_frame->reordered_opaque, now };
+		double latency = (double)(now - frame.receive_time) / 1000000.;
+		int width = s.dec_frame->width, height = s.dec_frame->height;
+		bool queued = s.frame_queue.tryPush(frame);
+		if (queued) s.dec_frame = nullptr;
+		else av_frame_unref(s.dec_frame);
+
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		++s.stats.decoded;
+		if (!queued) ++s.stats.dropped_frames;
+		s.stats.width = width;
+		s.stats.height = height;
+		s.latency_sum += latency;
+		s.stats.avg_decode_latency_ms = s.latency_sum / s.stats.decoded;
+		if (latency > s.stats.max_decode_latency_ms) s.stats.max_decode_latency_ms = latency;
+	}
+}
+
+void decodePacket(IngestStream& s, IngestPacket& item)
+{
+	if (!item.packet) { // end of session
+		if (s.dec_ctx) {
+			avcodec_send_packet(s.dec_ctx, nullptr);
+			receiveFrames(s);
+			avcodec_free_context(&s.dec_ctx);
+		}
+		if (s.finished.load(std::memory_order_relaxed)) s.frame_queue.close();
+		return;
+	}
+
+	if (!s.dec_ctx && openDecoder(s) < 0) {
+		av_packet_free(&item.packet);
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		++s.stats.decode_errors;
+		return;
+	}
+
+	// carried through the reordering of the decoder to the frame of the access unit
+	s.dec_ctx->reordered_opaque = item.receive_time;
+	int ret = avcodec_send_packet(s.dec_ctx, item.packet);
+	av_packet_free(&item.packet);
+	if (ret < 0) {
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		++s.stats.decode_errors;
+	}
+
+	receiveFrames(s);
+}
+
+void freeStream(IngestStream& s)
+{
+	IngestPacket item;
+	while (s.packet_queue.tryPop(item))
+		av_packet_free(&item.packet);
+	s.pending.store(0, std::memory_order_relaxed);
+
+	avcodec_free_context(&s.dec_ctx);
+	av_frame_free(&s.dec_frame);
+	s.frame_queue.close();
+}
+
+} // namespace
+
+RtspIngest::RtspIngest() = default;
+
+RtspIngest::~RtspIngest()
+{
+	stop();
+
+	for (auto& stream : streams_) {
+		IngestFrame frame;
+		while (stream->frame_queue.tryPop(frame))
+			av_frame_free(&frame.frame);
+	}
+}
+
+int RtspIngest::addStream(const std::string& url)
+{
+	if (started_) {
+		fprintf(stderr, "the streams are added before start\n");
+		return -1;
+	}
+
+	std::unique_ptr<IngestStream> stream(new IngestStream);
+	stream->index = static_cast<int>(streams_.size());
+	stream->url = url;
+	streams_.push_back(std::move(stream));
+	return streams_.back()->index;
+}
+
+int RtspIngest::start(const RtspIngestConfig& config)
+{
+	if (started_ || streams_.empty() || config.decode_threads < 1 || config.packet_queue_size < 2 || config.frame_queue_size < 1) {
+		fprintf(stderr, "fail to start: started: %d, stream count: %d\n", started_, getStreamCount());
+		return -1;
+	}
+
+	config_ = config;
+	ready_queue_.reset(streams_.size());
+	for (auto& stream : streams_) {
+		IngestStream& s = *stream;
+		s.config = &config_;
+		s.ready_queue = &ready_queue_;
+		s.au_data.reset(new uint8_t[config_.max_access_unit_size]);
+		s.packet_queue.reset(config_.packet_queue_size);
+		s.frame_queue.reset(config_.frame_queue_size);
+	}
+
+	started_ = true;
+	network_thread_ = std::thread(&RtspIngest::networkLoop, this);
+	for (int i = 0; i < config_.decode_threads; ++i)
+		decode_threads_.emplace_back(&RtspIngest::decodeLoop, this);
+
+	return 0;
+}
+
+void RtspIngest::stop()
+{
+	if (!started_ || stop_request_.load(std::memory_order_relaxed)) return;
+
+	stop_request_.store(true, std::memory_order_release);
+	network_thread_.join();
+
+	// the decode threads finish the streams already scheduled and exit
+	ready_queue_.close();
+	for (auto& th : decode_threads_)
+		th.join();
+	decode_threads_.clear();
+
+	for (auto& stream : streams_)
+		freeStream(*stream);
+}
+
+bool RtspIngest::read(int stream, IngestFrame& frame, int timeout)
+{
+	if (stream < 0 || stream >= getStreamCount()) return false;
+
+	IngestStream& s = *streams_[stream];
+	bool ok = false;
+	if (timeout < 0) ok = s.frame_queue.pop(frame);
+	else if (timeout == 0) ok = s.frame_queue.tryPop(frame);
+	else ok = s.frame_queue.pop(frame, std::chrono::milliseconds(timeout));
+	if (!ok) return false;
+
+	std::lock_guard<std::mutex> lck(s.stats_mtx);
+	++s.stats.delivered;
+	return true;
+}
+
+void RtspIngest::releaseFrame(IngestFrame& frame)
+{
+	av_frame_free(&frame.frame);
+}
+
+bool RtspIngest::isEnded(int stream) const
+{
+	if (stream < 0 || stream >= getStreamCount()) return true;
+
+	const IngestStream& s = *streams_[stream];
+	return s.frame_queue.isClosed() && s.frame_queue.empty();
+}
+
+IngestStreamStats RtspIngest::getStats(int stream) const
+{
+	IngestStreamStats stats;
+	memset(&stats, 0, sizeof(stats));
+	if (stream < 0 || stream >= getStreamCount()) return stats;
+
+	const IngestStream& s = *streams_[stream];
+	{
+		std::lock_guard<std::mutex> lck(s.stats_mtx);
+		stats = s.stats;
+	}
+	stats.packet_queue = s.packet_queue.getStats();
+	stats.frame_queue = s.frame_queue.getStats();
+	return stats;
+}
+
+void RtspIngest::networkLoop()
+{
+	TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+	UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
+
+	NetworkState state = { &streams_, &stop_request_, env, 0, nowNanoseconds() };
+	for (auto& stream : streams_) {
+		stream->env = env;
+		openStream(*stream);
+	}
+	scheduler->scheduleDelayedTask(housekeeping_interval_us, housekeeping, &state);
+
+	// returns after the housekeeping saw the stop request and closed all the sessions
+	env->taskScheduler().doEventLoop(&state.watch);
+
+	env->reclaim();
+	delete scheduler;
+}
+
+void RtspIngest::decodeLoop()
+{
+	IngestStream* stream = nullptr;
+
+	while (ready_queue_.pop(stream)) {
+		IngestStream& s = *stream;
+		IngestPacket item;
+		int64_t n = 0;
+
+		while (n < decode_batch_size && s.packet_queue.tryPop(item)) {
+			++n;
+			decodePacket(s, item);
+		}
+
+		// still packets left: back to the end of the queue, so the other streams get their turn
+		if (s.pending.fetch_sub(n, std::memory_order_acq_rel) - n > 0)
+			ready_queue_.push(stream);
+	}
+}
@@ -0,0 +1,122 @@
+#ifndef FBC_FFMPEG_TEST_RTSP_INGEST_HPP_
+#define FBC_FFMPEG_TEST_RTSP_INGEST_HPP_
+
+// Ingest of many RTSP streams (H.264/H.265) with a fixed set of threads, whatever the number of streams:
+//     one live555 event loop does the network I/O of all the streams and assembles their access units,
+//     a pool of decode threads is shared by all the streams, at most one of them works on a given stream at
+//     a time, so the access units of a stream are decoded in order,
+//     the decoded frames of each stream go to a bounded queue, which the application reads.
+// Neither the event loop nor a decode thread ever waits for a slow stream or a slow reader: an access unit which
+// finds the decode backlog of its stream full is dropped together with the following ones up to the next key
+// frame, a frame which finds the output queue of its stream full is dropped; both are counted in the statistics.
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ring_queue.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+typedef enum rtsp_ingest_state_t {
+	RTSP_INGEST_IDLE,
+	RTSP_INGEST_CONNECTING, // DESCRIBE, SETUP, PLAY
+	RTSP_INGEST_PLAYING,
+	RTSP_INGEST_WAITING, // the session ended or failed, reconnects after reconnect_delay_ms
+	RTSP_INGEST_ENDED
+} rtsp_ingest_state_t;
+
+typedef struct RtspIngestConfig {
+	int decode_threads = 4;
+	unsigned int packet_queue_size = 32; // access units of a stream waiting for the decoder
+	unsigned int frame_queue_size = 8; // decoded frames of a stream waiting for the application
+	size_t max_access_unit_size = 2 * 1024 * 1024; // larger access units are dropped
+	bool rtp_over_tcp = false; // RTP interleaved in the RTSP connection instead of UDP
+	unsigned int receive_buffer_size = 2 * 1024 * 1024; // socket receive buffer of the RTP/UDP sockets
+	int reconnect_delay_ms = 2000; // 0: a stream which ends or fails is not reopened
+	int receive_timeout_ms = 10000; // a stream without data or answer of the server for so long is closed (and reopened), 0: never
+	int verbosity = 0; // of the live555 RTSP clients
+} RtspIngestConfig;
+
+typedef struct IngestFrame {
+	AVFrame* frame; // owned by the reader until RtspIngest::releaseFrame
+	int stream;
+	uint64_t sequence; // number of the frame in the output of its stream's decoder
+	int64_t pts; // presentation time in microseconds, the wall clock once the stream is synchronized by RTCP
+	int64_t receive_time; // steady clock nanoseconds when the access unit of the frame was complete
+	int64_t decode_time; // steady clock nanoseconds when the frame came out of the decoder
+} IngestFrame;
+
+typedef struct IngestStreamStats {
+	int state; // rtsp_ingest_state_t
+	int codec_id; // AVCodecID of the current or last session
+	int width;
+	int height;
+	uint64_t sessions; // sessions which started playing, reconnects included
+	uint64_t access_units; // complete access units received
+	uint64_t bytes;
+	uint64_t rtp_packets_lost;
+	uint64_t truncated; // access units larger than max_access_unit_size, dropped
+	uint64_t dropped_packets; // access units dropped: backlog full or waiting for a key frame after a loss
+	uint64_t decoded;
+	uint64_t decode_errors;
+	uint64_t dropped_frames; // decoded frames dropped because the output queue was full
+	uint64_t delivered; // frames returned by RtspIngest::read
+	double receive_fps; // access units per second over the last second
+	double decode_fps; // decoded frames per second over the last second
+	double jitter_ms; // interarrival jitter of the access units against their presentation times (RFC 3550)
+	double avg_decode_latency_ms; // from the complete access unit to the decoded frame, the backlog included
+	double max_decode_latency_ms;
+	RingQueueStats packet_queue;
+	RingQueueStats frame_queue;
+} IngestStreamStats;
+
+struct IngestStream; // rtsp_ingest.cpp
+
+class RtspIngest {
+public:
+	RtspIngest();
+	~RtspIngest();
+
+	// the streams are added before start, returns the index of the stream
+	int addStream(const std::string& url);
+	int getStreamCount() const { return static_cast<int>(streams_.size()); }
+
+	// once per object
+	int start(const RtspIngestConfig& config = RtspIngestConfig());
+	// closes the sessions and stops the threads, the frames already decoded can still be read
+	void stop();
+
+	// the next frame of the stream; timeout: milliseconds, 0 doesn't wait, -1 waits until a frame arrives or the stream ends;
+	// false on timeout or once the stream ended and all its frames were read
+	bool read(int stream, IngestFrame& frame, int timeout = -1);
+	void releaseFrame(IngestFrame& frame);
+	// no more frames will come: the stream ended without reconnect or the ingest was stopped, and all its frames were read
+	bool isEnded(int stream) const;
+
+	IngestStreamStats getStats(int stream) const;
+
+private:
+	void networkLoop();
+	void decodeLoop();
+
+	RtspIngestConfig config_;
+	std::vector<std::unique_ptr<IngestStream>> streams_;
+	MPMCRingQueue<IngestStream*> ready_queue_; // the streams with access units to decode, each at most once
+	std::thread network_thread_;
+	std::vector<std::thread> decode_threads_;
+	std::atomic<bool> stop_request_{ false };
+	bool started_ = false;
+};
+
+#endif // FBC_FFMPEG_TEST_RTSP_INGEST_HPP_
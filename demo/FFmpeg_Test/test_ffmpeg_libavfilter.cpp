@@ -1,5 +1,6 @@
 #include "funset.hpp"
 #include <thread>
+#include <atomic>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,7 +25,8 @@ extern "C" {
 namespace {
 
 const int total_push_count = 121;
-bool flag1 = true;
+// also hands the producer side of the scale queue over to stopEncode
+std::atomic<bool> flag1{ true };
 const size_t block_size_1 = 640 * 480 * 3;
 size_t total_push_count_1 = 0;
 
@@ -63,6 +65,7 @@ void encode_1()
     video_codec.setVideoSize("640x480");
     video_codec.setPixelFormat("bgr24");
     video_codec.setFilterDescr("movie=1.jpg[logo];[in][logo]overlay=10:20[out]");
+    video_codec.setPacketInput(true);
 
     auto& raw_queue = video_codec.get_raw_packet_queue(16, block_size_1);
     std::thread thread_fill(fill_raw_data_1, std::ref(raw_queue));
@@ -89,7 +92,7 @@ void encode_1()
     std::cout << "1 total push count: " << total_push_count_1 << std::endl;
 }
 
-bool flag2 = true;
+std::atomic<bool> flag2{ true };
 const size_t block_size_2 = 640 * 480 * 3;
 size_t total_push_count_2 = 0;
 
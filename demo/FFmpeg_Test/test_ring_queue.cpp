@@ -0,0 +1,87 @@
+#include "funset.hpp"
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "ring_queue.hpp"
+
+namespace {
+
+// an item whose move assignment pauses, so that a push or a pop stays inside tryPush/tryPop long enough for a waiter
+// of the other side to wake up meanwhile
+struct SlowItem {
+	SlowItem() = default;
+	explicit SlowItem(int v) : value(v) {}
+	SlowItem(const SlowItem&) = default;
+	SlowItem& operator = (SlowItem&& other) {
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+		value = other.value;
+		return *this;
+	}
+
+	int value = 0;
+};
+
+struct BlockingState {
+	MPMCRingQueue<SlowItem> queue{ 2 };
+	std::atomic<int> producers_left{ 0 };
+	std::atomic<int> consumers_left{ 0 };
+	std::atomic<long long> sum{ 0 };
+	std::atomic<int> count{ 0 };
+};
+
+} // namespace
+
+int test_ring_queue_blocking()
+{
+	// a tiny queue with more producers than consumers: the producers sleep in push while the queue is full and the
+	// consumers sleep in pop while it is empty, a woken waiter pushes or pops and then wakes the other side
+	const int producer_count = 3, consumer_count = 2, items_per_producer = 2000;
+	// the threads share the state, so that they can be left behind if they deadlock
+	std::shared_ptr<BlockingState> state = std::make_shared<BlockingState>();
+	state->producers_left = producer_count;
+	state->consumers_left = consumer_count;
+
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producer_count; ++p) {
+		threads.emplace_back([state, p, items_per_producer]() {
+			for (int i = 0; i < items_per_producer; ++i)
+				state->queue.push(SlowItem(p * items_per_producer + i + 1));
+			if (--state->producers_left == 0) state->queue.close();
+		});
+	}
+	for (int c = 0; c < consumer_count; ++c) {
+		threads.emplace_back([state]() {
+			SlowItem item;
+			while (state->queue.pop(item)) {
+				state->sum += item.value;
+				++state->count;
+			}
+			--state->consumers_left;
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	while (state->consumers_left.load() > 0 && std::chrono::steady_clock::now() - begin < std::chrono::seconds(30))
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	if (state->consumers_left.load() > 0) {
+		fprintf(stderr, "Error: deadlock, %d of %d items popped\n", state->count.load(), producer_count * items_per_producer);
+		for (auto& thread : threads) thread.detach();
+		return -1;
+	}
+	for (auto& thread : threads) thread.join();
+
+	const long long n = producer_count * items_per_producer;
+	RingQueueStats stats = state->queue.getStats();
+	fprintf(stdout, "popped %d items, full waits: %llu, empty waits: %llu\n", state->count.load(),
+		(unsigned long long)stats.full_waits, (unsigned long long)stats.empty_waits);
+	if (state->count.load() != n || state->sum.load() != n * (n + 1) / 2) {
+		fprintf(stderr, "Error: items lost or duplicated\n");
+		return -1;
+	}
+
+	return 0;
+}
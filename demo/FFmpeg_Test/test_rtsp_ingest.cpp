@@ -0,0 +1,165 @@
+#include "funset.hpp"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <liveMedia.hh>
+#include <BasicUsageEnvironment.hh>
+#include "rtsp_ingest.hpp"
+
+namespace {
+
+// serves each file as rtsp://127.0.0.1:port/streamN, every client gets its own source from the start of the file
+class FileRTSPServer {
+public:
+	bool start(int port, const std::vector<std::pair<std::string, int>>& files) { // file name, video_codec_type_t
+		thread_ = std::thread(&FileRTSPServer::run, this, port, files);
+		while (state_.load() == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		return state_.load() == 1;
+	}
+
+	void stop() {
+		stop_request_.store(true);
+		if (thread_.joinable()) thread_.join();
+	}
+
+private:
+	static void checkStop(void* clientData) {
+		FileRTSPServer* server = (FileRTSPServer*)clientData;
+		if (server->stop_request_.load()) {
+			server->watch_ = 1;
+			return;
+		}
+		server->env_->taskScheduler().scheduleDelayedTask(100000, checkStop, server);
+	}
+
+	void run(int port, std::vector<std::pair<std::string, int>> files) {
+		TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+		env_ = BasicUsageEnvironment::createNew(*scheduler);
+
+		OutPacketBuffer::maxSize = 2 * 1024 * 1024;
+		RTSPServer* server = RTSPServer::createNew(*env_, port);
+		if (server == NULL) {
+			fprintf(stderr, "fail to create RTSP server: %s\n", env_->getResultMsg());
+			state_.store(-1);
+		} else {
+			for (size_t i = 0; i < files.size(); ++i) {
+				std::string name = "stream" + std::to_string(i);
+				ServerMediaSession* sms = ServerMediaSession::createNew(*env_, name.c_str(), name.c_str(), "RtspIngest test");
+				if (files[i].second == VIDEO_CODEC_TYPE_H264)
+					sms->addSubsession(H264VideoFileServerMediaSubsession::createNew(*env_, files[i].first.c_str(), False));
+				else
+					sms->addSubsession(H265VideoFileServerMediaSubsession::createNew(*env_, files[i].first.c_str(), False));
+				server->addServerMediaSession(sms);
+			}
+
+			state_.store(1);
+			scheduler->scheduleDelayedTask(100000, checkStop, this);
+			env_->taskScheduler().doEventLoop(&watch_);
+			Medium::close(server);
+		}
+
+		env_->reclaim();
+		env_ = NULL;
+		delete scheduler;
+	}
+
+	std::thread thread_;
+	std::atomic<int> state_{ 0 }; // 1: serving, -1: failed
+	std::atomic<bool> stop_request_{ false };
+	UsageEnvironment* env_ = NULL;
+	char watch_ = 0;
+};
+
+} // namespace
+
+int test_rtsp_ingest()
+{
+	// raw Annex B streams without B-frames; test.h264 is in the tree: 64x48, 50 IDR frames of I_PCM macroblocks,
+	// test.h265 is optional, e.g.: ffmpeg -i in.mp4 -an -c:v libx265 -bf 0 -t 10 test.h265
+	const std::vector<std::pair<std::string, int>> candidates = {
+		{ "../../../test_images/test.h264", VIDEO_CODEC_TYPE_H264 },
+		{ "../../../test_images/test.h265", VIDEO_CODEC_TYPE_H265 } };
+	std::vector<std::pair<std::string, int>> files;
+	for (const auto& file : candidates) {
+		if (std::ifstream(file.first, std::ios::binary).good()) files.push_back(file);
+		else fprintf(stderr, "Warning: no test file: %s\n", file.first.c_str());
+	}
+	if (files.empty()) {
+		fprintf(stderr, "Error: no test file\n");
+		return -1;
+	}
+
+	const int port = 8554, stream_count = 16;
+	FileRTSPServer server;
+	if (!server.start(port, files)) {
+		server.stop();
+		return -1;
+	}
+
+	RtspIngest ingest;
+	for (int i = 0; i < stream_count; ++i)
+		ingest.addStream("rtsp://127.0.0.1:" + std::to_string(port) + "/stream" + std::to_string(i % files.size()));
+
+	RtspIngestConfig config;
+	config.decode_threads = 4;
+	config.rtp_over_tcp = true; // no loss, every stream of a file decodes the same frames
+	config.reconnect_delay_ms = 0; // each file is played once
+	if (ingest.start(config) != 0) {
+		server.stop();
+		return -1;
+	}
+
+	std::vector<uint64_t> frames(stream_count, 0);
+	std::vector<int64_t> last_pts(stream_count, INT64_MIN);
+	int ret = 0;
+	auto begin = std::chrono::steady_clock::now();
+	while (1) {
+		int ended = 0;
+		for (int i = 0; i < stream_count; ++i) {
+			IngestFrame frame;
+			while (ingest.read(i, frame, 0)) {
+				// per stream in order
+				if (frame.stream != i || frame.sequence != frames[i] || frame.pts <= last_pts[i] || frame.decode_time < frame.receive_time) {
+					fprintf(stderr, "Error: stream %d, frame %llu out of order: stream %d, sequence %llu, pts %lld after %lld\n",
+						i, (unsigned long long)frames[i], frame.stream, (unsigned long long)frame.sequence, (long long)frame.pts, (long long)last_pts[i]);
+					ret = -1;
+				}
+				last_pts[i] = frame.pts;
+				++frames[i];
+				ingest.releaseFrame(frame);
+			}
+			if (ingest.isEnded(i)) ++ended;
+		}
+
+		if (ended == stream_count) break;
+		if (std::chrono::steady_clock::now() - begin > std::chrono::seconds(120)) {
+			fprintf(stderr, "Error: the streams didn't end\n");
+			ret = -1;
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	ingest.stop();
+	server.stop();
+
+	for (int i = 0; i < stream_count; ++i) {
+		IngestStreamStats stats = ingest.getStats(i);
+		fprintf(stdout, "stream %d: codec: %d, %dx%d, access units: %llu, decoded: %llu, delivered: %llu, dropped packets: %llu, "
+			"dropped frames: %llu, decode errors: %llu, jitter: %.2fms, decode latency: avg %.2fms, max %.2fms, packet queue max: %d\n",
+			i, stats.codec_id, stats.width, stats.height, (unsigned long long)stats.access_units, (unsigned long long)stats.decoded,
+			(unsigned long long)stats.delivered, (unsigned long long)stats.dropped_packets, (unsigned long long)stats.dropped_frames,
+			(unsigned long long)stats.decode_errors, stats.jitter_ms, stats.avg_decode_latency_ms, stats.max_decode_latency_ms,
+			(int)stats.packet_queue.max_size);
+
+		if (frames[i] == 0 || frames[i] != stats.delivered || stats.decoded != stats.delivered + stats.dropped_frames) ret = -1;
+		// the streams of the same file which lost nothing decoded the same frames
+		IngestStreamStats first = ingest.getStats(i % files.size());
+		if (stats.dropped_packets == 0 && first.dropped_packets == 0 && stats.decoded != first.decoded) ret = -1;
+	}
+
+	return ret;
+}
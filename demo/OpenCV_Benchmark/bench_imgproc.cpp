@@ -0,0 +1,795 @@
+#include <stdlib.h>
+#include <math.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <core/mat.hpp>
+#include <core/types.hpp>
+#include <resize.hpp>
+#include <cvtColor.hpp>
+#include <remap.hpp>
+#include <warpAffine.hpp>
+#include <warpPerspective.hpp>
+#include <rotate.hpp>
+#include <erode.hpp>
+#include <dilate.hpp>
+#include <morphologyEx.hpp>
+#include <threshold.hpp>
+#include <dft.hpp>
+#include <flip.hpp>
+#include <split.hpp>
+#include <merge.hpp>
+#include <lut.hpp>
+#include <GaussianBlur.hpp>
+#include <boxFilter.hpp>
+#include <integral.hpp>
+#include <pyramids.hpp>
+#include <blobFromYUV.hpp>
+
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+	#include <opencv2/opencv.hpp>
+#endif
+
+#include "benchmark.hpp"
+
+using fbc::uchar;
+
+template<typename _Tp> struct BenchDepth;
+template<> struct BenchDepth<uchar> { static const char* name() { return "8U"; } enum { cv_depth = 0 }; };
+template<> struct BenchDepth<float> { static const char* name() { return "32F"; } enum { cv_depth = 5 }; };
+template<> struct BenchDepth<double> { static const char* name() { return "64F"; } enum { cv_depth = 6 }; };
+
+template<typename _Tp, int chs>
+static std::string typeName()
+{
+	return std::string(BenchDepth<_Tp>::name()) + "C" + std::to_string(chs);
+}
+
+static std::string sizeName(fbc::Size size)
+{
+	return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+// uchar: [0, 255], float: [0, 255) with a fractional part
+template<typename _Tp, int chs>
+static void fillRandom(fbc::Mat_<_Tp, chs>& mat, unsigned int seed)
+{
+	srand(seed);
+	_Tp* p = (_Tp*)mat.data;
+	size_t total = (size_t)mat.rows * mat.cols * chs;
+
+	for (size_t i = 0; i < total; i++) {
+		p[i] = sizeof(_Tp) == 1 ? (_Tp)(rand() & 255) : (_Tp)((rand() % 65536) / 257.f);
+	}
+}
+
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+// a cv::Mat header on the data of a fbc::Mat_
+template<typename _Tp, int chs>
+static cv::Mat toCv(const fbc::Mat_<_Tp, chs>& mat)
+{
+	return cv::Mat(mat.rows, mat.cols, CV_MAKETYPE(BenchDepth<_Tp>::cv_depth, chs), mat.data, mat.step);
+}
+#endif
+
+// a case of one source and one destination image, fbc_op(src, dst) and cv_op(src, dst)
+template<typename _Tp, int chs1, int chs2, class FbcOp, class CvOp>
+static void addCase(std::vector<BenchCase>& cases, const std::string& op, const std::string& params,
+	fbc::Size ssize, fbc::Size dsize, FbcOp fbc_op, CvOp cv_op)
+{
+	BenchCase c;
+	c.op = op;
+	c.params = params;
+	c.type = typeName<_Tp, chs1>();
+	if (chs1 != chs2)
+		c.type += "->" + typeName<_Tp, chs2>();
+	c.width = dsize.width;
+	c.height = dsize.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<_Tp, chs1>>(ssize.height, ssize.width);
+		auto dst = std::make_shared<fbc::Mat_<_Tp, chs2>>(dsize.height, dsize.width);
+		fillRandom(*src, 1234);
+
+		BenchFunctions f;
+		f.fbc = [=]() { fbc_op(*src, *dst); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto dst_ = std::make_shared<cv::Mat>(dsize.height, dsize.width, CV_MAKETYPE(BenchDepth<_Tp>::cv_depth, chs2));
+		f.cv = [=]() { cv_op(toCv(*src), *dst_); };
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+static const char* interName(int interpolation)
+{
+	static const char* names[] = { "INTER_NEAREST", "INTER_LINEAR", "INTER_CUBIC", "INTER_AREA", "INTER_LANCZOS4" };
+	return names[interpolation];
+}
+
+template<typename _Tp, int chs>
+static void addResize(std::vector<BenchCase>& cases, fbc::Size ssize, fbc::Size dsize)
+{
+	for (int inter = 0; inter < 5; inter++) {
+		addCase<_Tp, chs, chs>(cases, "resize", std::string(interName(inter)) + " " + sizeName(ssize) + "->" + sizeName(dsize), ssize, dsize,
+			[inter](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::resize(src, dst, inter); },
+			BENCH_CV([inter](const cv::Mat& src, cv::Mat& dst) { cv::resize(src, dst, dst.size(), 0, 0, inter); }));
+	}
+}
+
+// a batch of count crops resized to the input size of a network, one batch call against a loop of OpenCV calls
+template<typename _Tp, int chs>
+static void addResizeBatch(std::vector<BenchCase>& cases, fbc::Size ssize, fbc::Size dsize, int count, int inter)
+{
+	BenchCase c;
+	c.op = "resize";
+	c.params = "batch of " + std::to_string(count) + " " + interName(inter) + " " + sizeName(ssize) + "->" + sizeName(dsize);
+	c.type = typeName<_Tp, chs>();
+	c.width = dsize.width;
+	c.height = dsize.height * count;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<std::vector<fbc::Mat_<_Tp, chs>>>();
+		auto dst = std::make_shared<std::vector<fbc::Mat_<_Tp, chs>>>();
+		for (int i = 0; i < count; i++) {
+			src->push_back(fbc::Mat_<_Tp, chs>(ssize.height, ssize.width));
+			fillRandom(src->back(), 1234 + i);
+		}
+
+		BenchFunctions f;
+		f.fbc = [=]() { fbc::resize(*src, *dst, dsize, inter); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto dst_ = std::make_shared<std::vector<cv::Mat>>(count);
+		f.cv = [=]() {
+			for (int i = 0; i < count; i++)
+				cv::resize(toCv((*src)[i]), (*dst_)[i], cv::Size(dsize.width, dsize.height), 0, 0, inter);
+		};
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+template<typename _Tp, int chs1, int chs2>
+static void addCvtColor(std::vector<BenchCase>& cases, const char* name, int code, fbc::Size ssize, fbc::Size dsize)
+{
+	// the codes of fbc_cv have the values of the OpenCV ones
+	addCase<_Tp, chs1, chs2>(cases, "cvtColor", std::string(name) + " " + sizeName(dsize), ssize, dsize,
+		[code](const fbc::Mat_<_Tp, chs1>& src, fbc::Mat_<_Tp, chs2>& dst) { fbc::cvtColor(src, dst, code); },
+		BENCH_CV([code](const cv::Mat& src, cv::Mat& dst) { cv::cvtColor(src, dst, code); }));
+}
+
+// cvtColor<code>(): the conversion selected at compile time
+template<int code, typename _Tp, int chs1, int chs2>
+static void addCvtColorStatic(std::vector<BenchCase>& cases, const char* name, fbc::Size size)
+{
+	addCase<_Tp, chs1, chs2>(cases, "cvtColor<code>", std::string(name) + " " + sizeName(size), size, size,
+		[](const fbc::Mat_<_Tp, chs1>& src, fbc::Mat_<_Tp, chs2>& dst) { fbc::cvtColor<code>(src, dst); },
+		BENCH_CV([](const cv::Mat& src, cv::Mat& dst) { cv::cvtColor(src, dst, code); }));
+}
+
+// a rotation with a small zoom, the maps of remap are made of the same transformation
+static void rotationMatrix(fbc::Size size, fbc::Mat_<double, 1>& M)
+{
+	fbc::getRotationMatrix2D(fbc::Point2f(size.width / 2.f, size.height / 2.f), 30, 0.9, M);
+}
+
+// plan: fbc_cv remaps with a RemapPlan, OpenCV with the maps converted by convertMaps
+template<typename _Tp, int chs>
+static void addRemap(std::vector<BenchCase>& cases, fbc::Size size, int inter, bool plan = false)
+{
+	BenchCase c;
+	c.op = "remap";
+	c.params = std::string(interName(inter)) + " " + sizeName(size) + (plan ? " RemapPlan" : " 32FC1 maps");
+	c.type = typeName<_Tp, chs>();
+	c.width = size.width;
+	c.height = size.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<_Tp, chs>>(size.height, size.width);
+		auto dst = std::make_shared<fbc::Mat_<_Tp, chs>>(size.height, size.width);
+		auto mapx = std::make_shared<fbc::Mat_<float, 1>>(size.height, size.width);
+		auto mapy = std::make_shared<fbc::Mat_<float, 1>>(size.height, size.width);
+		fillRandom(*src, 1234);
+
+		fbc::Mat_<double, 1> M(2, 3);
+		rotationMatrix(size, M);
+		const double* m = (const double*)M.data;
+		for (int y = 0; y < size.height; y++) {
+			float* px = (float*)mapx->ptr(y);
+			float* py = (float*)mapy->ptr(y);
+			for (int x = 0; x < size.width; x++) {
+				px[x] = (float)(m[0] * x + m[1] * y + m[2]);
+				py[x] = (float)(m[3] * x + m[4] * y + m[5]);
+			}
+		}
+
+		BenchFunctions f;
+		if (plan) {
+			auto p = std::make_shared<fbc::RemapPlan<_Tp, chs>>(size, *mapx, *mapy, inter, fbc::BORDER_CONSTANT);
+			f.fbc = [=]() { p->apply(*src, *dst); };
+		} else {
+			f.fbc = [=]() { fbc::remap(*src, *dst, *mapx, *mapy, inter, fbc::BORDER_CONSTANT); };
+		}
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto dst_ = std::make_shared<cv::Mat>(size.height, size.width, CV_MAKETYPE(BenchDepth<_Tp>::cv_depth, chs));
+		if (plan) {
+			auto map1_ = std::make_shared<cv::Mat>(), map2_ = std::make_shared<cv::Mat>();
+			cv::convertMaps(toCv(*mapx), toCv(*mapy), *map1_, *map2_, CV_16SC2, inter == fbc::INTER_NEAREST);
+			f.cv = [=]() { cv::remap(toCv(*src), *dst_, *map1_, *map2_, inter, cv::BORDER_CONSTANT); };
+		} else {
+			f.cv = [=]() { cv::remap(toCv(*src), *dst_, toCv(*mapx), toCv(*mapy), inter, cv::BORDER_CONSTANT); };
+		}
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+// dsize: the destination size when it differs from the source size (e.g. the aligned crops of face alignment)
+template<typename _Tp, int chs>
+static void addWarpAffine(std::vector<BenchCase>& cases, fbc::Size size, int inter, fbc::Size dsize = fbc::Size())
+{
+	std::shared_ptr<fbc::Mat_<double, 1>> M = std::make_shared<fbc::Mat_<double, 1>>(2, 3);
+	rotationMatrix(size, *M);
+	if (dsize.width == 0)
+		dsize = size;
+
+	addCase<_Tp, chs, chs>(cases, "warpAffine", std::string(interName(inter)) + " " + sizeName(size) +
+		(dsize == size ? std::string() : "->" + sizeName(dsize)), size, dsize,
+		[inter, M](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::warpAffine(src, dst, *M, inter); },
+		BENCH_CV([inter, M](const cv::Mat& src, cv::Mat& dst) { cv::warpAffine(src, dst, toCv(*M), dst.size(), inter); }));
+}
+
+template<typename _Tp, int chs>
+static void addWarpPerspective(std::vector<BenchCase>& cases, fbc::Size size, int inter)
+{
+	float w = (float)size.width, h = (float)size.height;
+	fbc::Point2f src_pts[4] = { fbc::Point2f(0, 0), fbc::Point2f(w - 1, 0), fbc::Point2f(w - 1, h - 1), fbc::Point2f(0, h - 1) };
+	fbc::Point2f dst_pts[4] = { fbc::Point2f(w * 0.05f, h * 0.1f), fbc::Point2f(w * 0.9f, 0), fbc::Point2f(w - 1, h * 0.95f), fbc::Point2f(w * 0.1f, h * 0.85f) };
+	std::shared_ptr<fbc::Mat_<double, 1>> M = std::make_shared<fbc::Mat_<double, 1>>(3, 3);
+	fbc::getPerspectiveTransform(src_pts, dst_pts, *M);
+
+	addCase<_Tp, chs, chs>(cases, "warpPerspective", std::string(interName(inter)) + " " + sizeName(size), size, size,
+		[inter, M](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::warpPerspective(src, dst, *M, inter); },
+		BENCH_CV([inter, M](const cv::Mat& src, cv::Mat& dst) { cv::warpPerspective(src, dst, toCv(*M), dst.size(), inter); }));
+}
+
+static const char* morphName(int op)
+{
+	static const char* names[] = { "MORPH_ERODE", "MORPH_DILATE", "MORPH_OPEN", "MORPH_CLOSE", "MORPH_GRADIENT", "MORPH_TOPHAT", "MORPH_BLACKHAT" };
+	return names[op];
+}
+
+template<typename _Tp, int chs>
+static void addMorphology(std::vector<BenchCase>& cases, fbc::Size size, int op, int ksize, int shape = fbc::MORPH_RECT)
+{
+	std::shared_ptr<fbc::Mat_<uchar, 1>> kernel = std::make_shared<fbc::Mat_<uchar, 1>>(ksize, ksize);
+	fbc::getStructuringElement(*kernel, shape, fbc::Size(ksize, ksize));
+	std::string params = std::string(morphName(op)) + " " + std::to_string(ksize) + "x" + std::to_string(ksize) +
+		(shape == fbc::MORPH_RECT ? "" : shape == fbc::MORPH_CROSS ? " cross" : " ellipse") + " " + sizeName(size);
+	const char* name = op == fbc::MORPH_ERODE ? "erode" : op == fbc::MORPH_DILATE ? "dilate" : "morphologyEx";
+
+	addCase<_Tp, chs, chs>(cases, name, params, size, size,
+		[op, kernel](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) {
+			if (op == fbc::MORPH_ERODE)
+				fbc::erode(src, dst, *kernel);
+			else if (op == fbc::MORPH_DILATE)
+				fbc::dilate(src, dst, *kernel);
+			else
+				fbc::morphologyEx(src, dst, op, *kernel);
+		},
+		BENCH_CV([op, kernel](const cv::Mat& src, cv::Mat& dst) { cv::morphologyEx(src, dst, op, toCv(*kernel)); }));
+}
+
+template<typename _Tp>
+static void addThreshold(std::vector<BenchCase>& cases, fbc::Size size, const char* name, int type)
+{
+	addCase<_Tp, 1, 1>(cases, "threshold", std::string(name) + " " + sizeName(size), size, size,
+		[type](const fbc::Mat_<_Tp, 1>& src, fbc::Mat_<_Tp, 1>& dst) { fbc::threshold(src, dst, 127, 255, type); },
+		BENCH_CV([type](const cv::Mat& src, cv::Mat& dst) { cv::threshold(src, dst, 127, 255, type); }));
+}
+
+// thresholding by tiles (Otsu's threshold of every tile), against cv::adaptiveThreshold with a box of the tile width
+static void addLocalThreshold(std::vector<BenchCase>& cases, fbc::Size size, fbc::Size tile)
+{
+	addCase<uchar, 1, 1>(cases, "localThreshold", "THRESH_BINARY|THRESH_OTSU " + sizeName(tile) + " " + sizeName(size), size, size,
+		[tile](const fbc::Mat_<uchar, 1>& src, fbc::Mat_<uchar, 1>& dst) { fbc::localThreshold(src, dst, tile, 255, fbc::THRESH_BINARY | fbc::THRESH_OTSU); },
+		BENCH_CV([tile](const cv::Mat& src, cv::Mat& dst) { cv::adaptiveThreshold(src, dst, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY, tile.width | 1, 0); }));
+}
+
+// a gamma curve, one table or a table per channel
+template<int chs, int lutcn>
+static void addLUT(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	auto lut = std::make_shared<fbc::Mat_<uchar, lutcn>>(1, 256);
+	for (int i = 0; i < 256 * lutcn; i++)
+		lut->data[i] = fbc::saturate_cast<uchar>(std::pow(i / lutcn / 255., 1. / (2.2 + i % lutcn * 0.1)) * 255);
+
+	addCase<uchar, chs, chs>(cases, "LUT", std::string(lutcn == 1 ? "one table " : "table per channel ") + sizeName(size), size, size,
+		[lut](const fbc::Mat_<uchar, chs>& src, fbc::Mat_<uchar, chs>& dst) { fbc::LUT(src, *lut, dst); },
+		BENCH_CV([lut](const cv::Mat& src, cv::Mat& dst) { cv::LUT(src, toCv(*lut), dst); }));
+}
+
+// a 3D table of lsize^3 entries on a smooth frame (random colors would measure the cache misses of the table reads),
+// OpenCV has no equivalent
+template<typename _Tp, int chs>
+static void addLut3D(std::vector<BenchCase>& cases, fbc::Size size, int lsize, int interpolation)
+{
+	BenchCase c;
+	c.op = "Lut3D";
+	c.params = std::string(interpolation == fbc::LUT3D_TETRAHEDRAL ? "LUT3D_TETRAHEDRAL " : "LUT3D_TRILINEAR ") +
+		std::to_string(lsize) + "^3 " + sizeName(size);
+	c.type = typeName<_Tp, chs>();
+	c.width = size.width;
+	c.height = size.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<_Tp, chs>>(size.height, size.width);
+		auto dst = std::make_shared<fbc::Mat_<_Tp, chs>>(size.height, size.width);
+		const float scale = sizeof(_Tp) == 1 ? 1.f : 1.f / 255;
+		for (int y = 0; y < size.height; y++) {
+			_Tp* p = (_Tp*)src->ptr(y);
+			for (int x = 0; x < size.width; x++, p += chs) {
+				p[0] = (_Tp)((x * 255 / size.width) * scale);
+				p[1] = (_Tp)((y * 255 / size.height) * scale);
+				p[2] = (_Tp)(((x + y) / 4 % 256) * scale);
+				if (chs == 4)
+					p[3] = (_Tp)(255 * scale);
+			}
+		}
+
+		fbc::Mat_<float, 3> table(lsize * lsize, lsize);
+		fillRandom(table, 4321);
+		for (int i = 0; i < table.rows; i++) {
+			float* p = (float*)table.ptr(i);
+			for (int j = 0; j < table.cols * 3; j++)
+				p[j] = p[j] - std::floor(p[j]);
+		}
+		auto lut = std::make_shared<fbc::Lut3D<_Tp, chs>>(table, interpolation);
+
+		BenchFunctions f;
+		f.fbc = [=]() { lut->apply(*src, *dst); };
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+template<typename _Tp, int chs>
+static void addGaussianBlur(std::vector<BenchCase>& cases, fbc::Size size, int ksize, double sigma)
+{
+	addCase<_Tp, chs, chs>(cases, "GaussianBlur", std::to_string(ksize) + "x" + std::to_string(ksize) + " sigma " +
+		std::to_string(sigma).substr(0, 3) + " " + sizeName(size), size, size,
+		[ksize, sigma](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::GaussianBlur(src, dst, fbc::Size(ksize, ksize), sigma); },
+		BENCH_CV([ksize, sigma](const cv::Mat& src, cv::Mat& dst) { cv::GaussianBlur(src, dst, cv::Size(ksize, ksize), sigma); }));
+}
+
+template<typename _Tp, int chs>
+static void addBlur(std::vector<BenchCase>& cases, fbc::Size size, int ksize)
+{
+	addCase<_Tp, chs, chs>(cases, "blur", std::to_string(ksize) + "x" + std::to_string(ksize) + " " + sizeName(size), size, size,
+		[ksize](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::blur(src, dst, fbc::Size(ksize, ksize)); },
+		BENCH_CV([ksize](const cv::Mat& src, cv::Mat& dst) { cv::blur(src, dst, cv::Size(ksize, ksize)); }));
+}
+
+// the sums of an 8-bit image, the destination is (rows + 1) x (cols + 1) of int
+template<int chs>
+static void addIntegral(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	BenchCase c;
+	c.op = "integral";
+	c.params = sizeName(size);
+	c.type = typeName<uchar, chs>() + "->32SC" + std::to_string(chs);
+	c.width = size.width;
+	c.height = size.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<uchar, chs>>(size.height, size.width);
+		auto sum = std::make_shared<fbc::Mat_<int, chs>>(size.height + 1, size.width + 1);
+		fillRandom(*src, 1234);
+
+		BenchFunctions f;
+		f.fbc = [=]() { fbc::integral(*src, *sum); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto sum_ = std::make_shared<cv::Mat>();
+		f.cv = [=]() { cv::integral(toCv(*src), *sum_, CV_32S); };
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+template<typename _Tp, int chs>
+static void addPyrDown(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	addCase<_Tp, chs, chs>(cases, "pyrDown", sizeName(size), size, fbc::Size((size.width + 1) / 2, (size.height + 1) / 2),
+		[](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::pyrDown(src, dst); },
+		BENCH_CV([](const cv::Mat& src, cv::Mat& dst) { cv::pyrDown(src, dst); }));
+}
+
+template<typename _Tp, int chs>
+static void addPyrUp(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	addCase<_Tp, chs, chs>(cases, "pyrUp", sizeName(size), size, fbc::Size(size.width * 2, size.height * 2),
+		[](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::pyrUp(src, dst); },
+		BENCH_CV([](const cv::Mat& src, cv::Mat& dst) { cv::pyrUp(src, dst); }));
+}
+
+// all the levels of a frame, the levels of the pyramid are reused from one build to the next
+template<int chs>
+static void addPyramid(std::vector<BenchCase>& cases, fbc::Size size, int maxlevel)
+{
+	BenchCase c;
+	c.op = "buildPyramid";
+	c.params = std::to_string(maxlevel + 1) + " levels " + sizeName(size);
+	c.type = typeName<uchar, chs>();
+	c.width = size.width;
+	c.height = size.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<uchar, chs>>(size.height, size.width);
+		auto pyr = std::make_shared<fbc::Pyramid<uchar, chs>>(maxlevel);
+		fillRandom(*src, 1234);
+
+		BenchFunctions f;
+		f.fbc = [=]() { pyr->build(*src); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto levels = std::make_shared<std::vector<cv::Mat>>();
+		f.cv = [=]() { cv::buildPyramid(toCv(*src), *levels, maxlevel); };
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+template<int chs1, int chs2>
+static void addDft(std::vector<BenchCase>& cases, fbc::Size size, const char* name, int flags)
+{
+	addCase<float, chs1, chs2>(cases, "dft", std::string(name) + " " + sizeName(size), size, size,
+		[flags](const fbc::Mat_<float, chs1>& src, fbc::Mat_<float, chs2>& dst) { fbc::dft(src, dst, flags); },
+		BENCH_CV([flags](const cv::Mat& src, cv::Mat& dst) { cv::dft(src, dst, flags); }));
+}
+
+// a batch of frames of the same size transformed by one call, against a loop of cv::dft
+static void addDftBatch(std::vector<BenchCase>& cases, fbc::Size size, int count, int flags)
+{
+	BenchCase c;
+	c.op = "dft";
+	c.params = "batch of " + std::to_string(count) + " DFT_COMPLEX_OUTPUT " + sizeName(size);
+	c.type = typeName<float, 1>() + "->" + typeName<float, 2>();
+	c.width = size.width;
+	c.height = size.height * count;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<std::vector<fbc::Mat_<float, 1>>>();
+		auto dst = std::make_shared<std::vector<fbc::Mat_<float, 2>>>();
+		for (int i = 0; i < count; i++) {
+			src->push_back(fbc::Mat_<float, 1>(size.height, size.width));
+			fillRandom(src->back(), 1234 + i);
+		}
+
+		BenchFunctions f;
+		f.fbc = [=]() { fbc::dft(*src, *dst, flags); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		auto dst_ = std::make_shared<std::vector<cv::Mat>>(count);
+		f.cv = [=]() {
+			for (int i = 0; i < count; i++)
+				cv::dft(toCv((*src)[i]), (*dst_)[i], flags);
+		};
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+template<typename _Tp, int chs>
+static void addFlip(std::vector<BenchCase>& cases, fbc::Size size, int code)
+{
+	addCase<_Tp, chs, chs>(cases, "flip", "flipCode " + std::to_string(code) + " " + sizeName(size), size, size,
+		[code](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::flip(src, dst, code); },
+		BENCH_CV([code](const cv::Mat& src, cv::Mat& dst) { cv::flip(src, dst, code); }));
+}
+
+template<typename _Tp, int chs>
+static void addTranspose(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	addCase<_Tp, chs, chs>(cases, "transpose", sizeName(size), size, fbc::Size(size.height, size.width),
+		[](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::transpose(src, dst); },
+		BENCH_CV([](const cv::Mat& src, cv::Mat& dst) { cv::transpose(src, dst); }));
+}
+
+static const char* rotateName(int code)
+{
+	static const char* names[] = { "ROTATE_90_CLOCKWISE", "ROTATE_180", "ROTATE_90_COUNTERCLOCKWISE" };
+	return names[code];
+}
+
+// the OpenCV side is transpose + flip
+template<typename _Tp, int chs>
+static void addRotate90(std::vector<BenchCase>& cases, fbc::Size size, int code)
+{
+	fbc::Size dsize = code == fbc::ROTATE_180 ? size : fbc::Size(size.height, size.width);
+	addCase<_Tp, chs, chs>(cases, "rotate", std::string(rotateName(code)) + " " + sizeName(size), size, dsize,
+		[code](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, chs>& dst) { fbc::rotate(src, dst, code); },
+		BENCH_CV([code](const cv::Mat& src, cv::Mat& dst) {
+			if (code == fbc::ROTATE_180) {
+				cv::flip(src, dst, -1);
+			} else {
+				cv::Mat tmp;
+				cv::transpose(src, tmp);
+				cv::flip(tmp, dst, code == fbc::ROTATE_90_CLOCKWISE ? 1 : 0);
+			}
+		}));
+}
+
+// the planes are the rows of a chs * rows x cols single-channel blob (CHW layout)
+template<typename _Tp, int chs>
+static void addSplit(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	addCase<_Tp, chs, 1>(cases, "split", sizeName(size) + " -> CHW", size, fbc::Size(size.width, size.height * chs),
+		[size](const fbc::Mat_<_Tp, chs>& src, fbc::Mat_<_Tp, 1>& dst) {
+			_Tp* planes[chs];
+			for (int i = 0; i < chs; i++)
+				planes[i] = (_Tp*)dst.ptr(i * size.height);
+			fbc::split(src, planes, dst.step);
+		},
+		BENCH_CV([size](const cv::Mat& src, cv::Mat& dst) {
+			std::vector<cv::Mat> planes(chs);
+			for (int i = 0; i < chs; i++)
+				planes[i] = dst.rowRange(i * size.height, (i + 1) * size.height);
+			cv::split(src, planes);
+		}));
+	cases.back().height = size.height; // MPix/s of the source image
+}
+
+template<typename _Tp, int chs>
+static void addMerge(std::vector<BenchCase>& cases, fbc::Size size)
+{
+	addCase<_Tp, 1, chs>(cases, "merge", "CHW -> " + sizeName(size), fbc::Size(size.width, size.height * chs), size,
+		[size](const fbc::Mat_<_Tp, 1>& src, fbc::Mat_<_Tp, chs>& dst) {
+			const _Tp* planes[chs];
+			for (int i = 0; i < chs; i++)
+				planes[i] = (const _Tp*)src.ptr(i * size.height);
+			fbc::merge(planes, src.step, dst);
+		},
+		BENCH_CV([size](const cv::Mat& src, cv::Mat& dst) {
+			std::vector<cv::Mat> planes(chs);
+			for (int i = 0; i < chs; i++)
+				planes[i] = src.rowRange(i * size.height, (i + 1) * size.height);
+			cv::merge(planes, dst);
+		}));
+}
+
+// the OpenCV side is the chain the fused function replaces: cvtColor + resize + normalize + split
+static void addBlobFromYUV(std::vector<BenchCase>& cases, fbc::Size size, fbc::Size dsize, int inter)
+{
+	BenchCase c;
+	c.op = "blobFromYUV";
+	c.params = std::string("CV_YUV2BGR_NV12 ") + interName(inter) + " " + sizeName(size) + "->" + sizeName(dsize);
+	c.type = "8UC1->32FC1 x3";
+	c.width = dsize.width;
+	c.height = dsize.height;
+
+	c.setup = [=]() {
+		auto src = std::make_shared<fbc::Mat_<uchar, 1>>(size.height * 3 / 2, size.width);
+		auto blob = std::make_shared<std::vector<float>>((size_t)dsize.area() * 3);
+		fbc::Scalar mean(103.53, 116.28, 123.675), stddev(57.375, 57.12, 58.395);
+		fillRandom(*src, 1234);
+
+		BenchFunctions f;
+		f.fbc = [=]() { fbc::blobFromYUV(*src, fbc::CV_YUV2BGR_NV12, blob->data(), dsize, inter, mean, stddev); };
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+		f.cv = [=]() {
+			cv::Mat bgr, resized, resized_f;
+			cv::cvtColor(toCv(*src), bgr, cv::COLOR_YUV2BGR_NV12);
+			cv::resize(bgr, resized, cv::Size(dsize.width, dsize.height), 0, 0, inter);
+			resized.convertTo(resized_f, CV_32F);
+
+			cv::Mat planes[3];
+			for (int i = 0; i < 3; i++)
+				planes[i] = cv::Mat(dsize.height, dsize.width, CV_32F, blob->data() + (size_t)i * dsize.area());
+			cv::split(resized_f, planes);
+			for (int i = 0; i < 3; i++)
+				planes[i].convertTo(planes[i], CV_32F, 1. / stddev.val[i], -mean.val[i] / stddev.val[i]);
+		};
+#endif
+		return f;
+	};
+
+	cases.push_back(c);
+}
+
+void registerBenchmarks(std::vector<BenchCase>& cases, bool quick)
+{
+	const fbc::Size vga(640, 480), hd(1280, 720), full_hd(1920, 1080);
+	const fbc::Size big = quick ? vga : full_hd;
+
+	// resize: downscale (fractional and integer factors) and upscale
+	std::vector<std::pair<fbc::Size, fbc::Size>> resize_sizes;
+	if (quick) {
+		resize_sizes = { { hd, fbc::Size(416, 416) }, { vga, fbc::Size(1280, 960) } };
+	} else {
+		resize_sizes = { { full_hd, fbc::Size(640, 360) }, { full_hd, fbc::Size(1280, 720) }, { hd, fbc::Size(416, 416) },
+			{ full_hd, fbc::Size(960, 540) }, { vga, fbc::Size(1280, 960) } };
+	}
+	for (const auto& s : resize_sizes) {
+		addResize<uchar, 1>(cases, s.first, s.second);
+		addResize<uchar, 3>(cases, s.first, s.second);
+		addResize<uchar, 4>(cases, s.first, s.second);
+		addResize<float, 3>(cases, s.first, s.second);
+	}
+	addResizeBatch<uchar, 3>(cases, fbc::Size(256, 192), fbc::Size(416, 416), 32, fbc::INTER_LINEAR);
+	addResizeBatch<uchar, 3>(cases, fbc::Size(256, 192), fbc::Size(416, 416), 32, fbc::INTER_AREA);
+
+	// cvtColor
+	fbc::Size yuv_size(big.width, big.height * 3 / 2);
+	addCvtColor<uchar, 3, 1>(cases, "CV_BGR2GRAY", fbc::CV_BGR2GRAY, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2RGB", fbc::CV_BGR2RGB, big, big);
+	addCvtColor<uchar, 3, 4>(cases, "CV_BGR2BGRA", fbc::CV_BGR2BGRA, big, big);
+	addCvtColor<uchar, 1, 3>(cases, "CV_GRAY2BGR", fbc::CV_GRAY2BGR, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2YCrCb", fbc::CV_BGR2YCrCb, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_YCrCb2BGR", fbc::CV_YCrCb2BGR, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2XYZ", fbc::CV_BGR2XYZ, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2HSV", fbc::CV_BGR2HSV, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_HSV2BGR", fbc::CV_HSV2BGR, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2HLS", fbc::CV_BGR2HLS, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2Lab", fbc::CV_BGR2Lab, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_Lab2BGR", fbc::CV_Lab2BGR, big, big);
+	addCvtColor<uchar, 3, 3>(cases, "CV_BGR2Luv", fbc::CV_BGR2Luv, big, big);
+	addCvtColor<uchar, 1, 3>(cases, "CV_YUV2BGR_NV12", fbc::CV_YUV2BGR_NV12, yuv_size, big);
+	addCvtColor<uchar, 1, 3>(cases, "CV_YUV2BGR_NV21", fbc::CV_YUV2BGR_NV21, yuv_size, big);
+	addCvtColor<uchar, 1, 4>(cases, "CV_YUV2BGRA_NV12", fbc::CV_YUV2BGRA_NV12, yuv_size, big);
+	addCvtColor<uchar, 1, 3>(cases, "CV_YUV2BGR_I420", fbc::CV_YUV2BGR_I420, yuv_size, big);
+	addCvtColor<uchar, 3, 1>(cases, "CV_BGR2YUV_I420", fbc::CV_BGR2YUV_I420, big, yuv_size);
+	addCvtColor<float, 3, 1>(cases, "CV_BGR2GRAY", fbc::CV_BGR2GRAY, big, big);
+	addCvtColor<float, 3, 3>(cases, "CV_BGR2HSV", fbc::CV_BGR2HSV, big, big);
+	addCvtColor<float, 3, 3>(cases, "CV_BGR2Lab", fbc::CV_BGR2Lab, big, big);
+	addCvtColorStatic<fbc::CV_BGR2GRAY, uchar, 3, 1>(cases, "CV_BGR2GRAY", big);
+	addCvtColorStatic<fbc::CV_BGR2BGRA, uchar, 3, 4>(cases, "CV_BGR2BGRA", big);
+	addCvtColorStatic<fbc::CV_BGR2YCrCb, uchar, 3, 3>(cases, "CV_BGR2YCrCb", big);
+	addCvtColorStatic<fbc::CV_YCrCb2BGR, uchar, 3, 3>(cases, "CV_YCrCb2BGR", big);
+	addCvtColorStatic<fbc::CV_BGR2YUV, uchar, 3, 3>(cases, "CV_BGR2YUV", big);
+	addCvtColorStatic<fbc::CV_BGR2HSV, uchar, 3, 3>(cases, "CV_BGR2HSV", big);
+	addCvtColorStatic<fbc::CV_HSV2BGR, uchar, 3, 3>(cases, "CV_HSV2BGR", big);
+	addCvtColorStatic<fbc::CV_BGR2GRAY, float, 3, 1>(cases, "CV_BGR2GRAY", big);
+
+	// fused preprocessing
+	addBlobFromYUV(cases, big, fbc::Size(416, 416), fbc::INTER_LINEAR);
+	addBlobFromYUV(cases, big, fbc::Size(416, 416), fbc::INTER_AREA);
+
+	// geometric transformations
+	for (int inter = fbc::INTER_NEAREST; inter <= fbc::INTER_CUBIC; inter++) {
+		addRemap<uchar, 1>(cases, big, inter);
+		addRemap<uchar, 3>(cases, big, inter);
+		addRemap<float, 1>(cases, big, inter);
+		addRemap<uchar, 3>(cases, big, inter, true);
+		addWarpAffine<uchar, 1>(cases, big, inter);
+		addWarpAffine<uchar, 3>(cases, big, inter);
+		addWarpAffine<float, 3>(cases, big, inter);
+		addWarpPerspective<uchar, 1>(cases, big, inter);
+		addWarpPerspective<uchar, 3>(cases, big, inter);
+		addWarpPerspective<float, 3>(cases, big, inter);
+	}
+	addWarpAffine<uchar, 4>(cases, big, fbc::INTER_LINEAR);
+	addWarpAffine<float, 1>(cases, big, fbc::INTER_LINEAR);
+	addWarpAffine<uchar, 3>(cases, fbc::Size(160, 160), fbc::INTER_LINEAR, fbc::Size(112, 112));
+	addWarpAffine<uchar, 3>(cases, fbc::Size(256, 256), fbc::INTER_LINEAR, fbc::Size(112, 112));
+
+	// morphology
+	for (int ksize : { 3, 7, 31 }) {
+		addMorphology<uchar, 1>(cases, big, fbc::MORPH_ERODE, ksize);
+		addMorphology<uchar, 3>(cases, big, fbc::MORPH_ERODE, ksize);
+		addMorphology<float, 1>(cases, big, fbc::MORPH_ERODE, ksize);
+		addMorphology<uchar, 1>(cases, big, fbc::MORPH_DILATE, ksize);
+		addMorphology<uchar, 3>(cases, big, fbc::MORPH_DILATE, ksize);
+		addMorphology<float, 1>(cases, big, fbc::MORPH_DILATE, ksize);
+	}
+	addMorphology<uchar, 1>(cases, big, fbc::MORPH_ERODE, 31, fbc::MORPH_CROSS);
+	addMorphology<uchar, 1>(cases, big, fbc::MORPH_ERODE, 31, fbc::MORPH_ELLIPSE);
+	addMorphology<float, 1>(cases, big, fbc::MORPH_ERODE, 31, fbc::MORPH_ELLIPSE);
+	for (int op = fbc::MORPH_OPEN; op <= fbc::MORPH_BLACKHAT; op++) {
+		addMorphology<uchar, 1>(cases, big, op, 5);
+		addMorphology<uchar, 1>(cases, big, op, 31);
+	}
+
+	// threshold
+	addThreshold<uchar>(cases, big, "THRESH_BINARY", fbc::THRESH_BINARY);
+	addThreshold<uchar>(cases, big, "THRESH_TRUNC", fbc::THRESH_TRUNC);
+	addThreshold<uchar>(cases, big, "THRESH_TOZERO", fbc::THRESH_TOZERO);
+	addThreshold<uchar>(cases, big, "THRESH_BINARY|THRESH_OTSU", fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	addThreshold<uchar>(cases, big, "THRESH_BINARY|THRESH_TRIANGLE", fbc::THRESH_BINARY | fbc::THRESH_TRIANGLE);
+	addThreshold<float>(cases, big, "THRESH_BINARY", fbc::THRESH_BINARY);
+	addThreshold<float>(cases, big, "THRESH_TRUNC", fbc::THRESH_TRUNC);
+	// a page scanned at 600 dpi (A3)
+	const fbc::Size page = quick ? hd : fbc::Size(7016, 9921);
+	addThreshold<uchar>(cases, page, "THRESH_BINARY|THRESH_OTSU", fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	addLocalThreshold(cases, page, fbc::Size(256, 256));
+
+	// look-up tables
+	addLUT<1, 1>(cases, big);
+	addLUT<3, 1>(cases, big);
+	addLUT<3, 3>(cases, big);
+	const fbc::Size uhd = quick ? big : fbc::Size(3840, 2160);
+	for (int inter : { fbc::LUT3D_TETRAHEDRAL, fbc::LUT3D_TRILINEAR }) {
+		addLut3D<uchar, 3>(cases, uhd, 33, inter);
+		addLut3D<uchar, 4>(cases, uhd, 33, inter);
+		addLut3D<float, 3>(cases, big, 33, inter);
+	}
+	addLut3D<uchar, 3>(cases, uhd, 65, fbc::LUT3D_TETRAHEDRAL);
+
+	// smoothing
+	for (int ksize : { 3, 5 }) {
+		addGaussianBlur<uchar, 1>(cases, big, ksize, 0);
+		addGaussianBlur<uchar, 3>(cases, big, ksize, 0);
+		addGaussianBlur<float, 1>(cases, big, ksize, 0);
+	}
+	addGaussianBlur<uchar, 3>(cases, big, 0, 3);
+	addGaussianBlur<float, 3>(cases, big, 0, 3);
+	for (int ksize : { 5, 31 }) {
+		addBlur<uchar, 1>(cases, big, ksize);
+		addBlur<uchar, 3>(cases, big, ksize);
+		addBlur<float, 1>(cases, big, ksize);
+	}
+	addIntegral<1>(cases, big);
+	addIntegral<3>(cases, big);
+
+	// pyramids
+	addPyrDown<uchar, 1>(cases, big);
+	addPyrDown<uchar, 3>(cases, big);
+	addPyrDown<float, 1>(cases, big);
+	addPyrUp<uchar, 1>(cases, fbc::Size(big.width / 2, big.height / 2));
+	addPyrUp<uchar, 3>(cases, fbc::Size(big.width / 2, big.height / 2));
+	addPyramid<1>(cases, big, 5);
+	addPyramid<3>(cases, big, 5);
+
+	// dft
+	std::vector<fbc::Size> dft_sizes;
+	if (quick)
+		dft_sizes = { fbc::Size(256, 256) };
+	else
+		dft_sizes = { fbc::Size(256, 256), fbc::Size(512, 512), fbc::Size(1024, 1024), fbc::Size(640, 480) };
+	for (const auto& s : dft_sizes) {
+		addDft<2, 2>(cases, s, "forward complex", 0);
+		addDft<2, 2>(cases, s, "DFT_INVERSE|DFT_SCALE complex", fbc::DFT_INVERSE | fbc::DFT_SCALE);
+		addDft<1, 1>(cases, s, "forward real (CCS)", 0);
+		addDft<1, 2>(cases, s, "DFT_COMPLEX_OUTPUT real", fbc::DFT_COMPLEX_OUTPUT);
+		addDft<2, 1>(cases, s, "DFT_INVERSE|DFT_SCALE|DFT_REAL_OUTPUT complex", fbc::DFT_INVERSE | fbc::DFT_SCALE | fbc::DFT_REAL_OUTPUT);
+	}
+	addDftBatch(cases, fbc::Size(256, 256), 16, fbc::DFT_COMPLEX_OUTPUT);
+
+	// flip, transpose, rotate
+	for (int code : { 0, 1, -1 }) {
+		addFlip<uchar, 1>(cases, big, code);
+		addFlip<uchar, 3>(cases, big, code);
+		addFlip<float, 1>(cases, big, code);
+	}
+	for (const auto& s : { big, fbc::Size(1024, 1024) }) {
+		addTranspose<uchar, 1>(cases, s);
+		addTranspose<uchar, 3>(cases, s);
+		addTranspose<uchar, 4>(cases, s);
+		addTranspose<float, 1>(cases, s);
+	}
+	for (int code = fbc::ROTATE_90_CLOCKWISE; code <= fbc::ROTATE_90_COUNTERCLOCKWISE; code++) {
+		addRotate90<uchar, 1>(cases, big, code);
+		addRotate90<uchar, 3>(cases, big, code);
+		addRotate90<float, 1>(cases, big, code);
+	}
+	if (!quick)
+		addRotate90<uchar, 3>(cases, fbc::Size(3840, 2160), fbc::ROTATE_90_CLOCKWISE);
+
+	// split, merge
+	addSplit<uchar, 3>(cases, big);
+	addSplit<uchar, 4>(cases, big);
+	addSplit<float, 3>(cases, big);
+	addMerge<uchar, 3>(cases, big);
+	addMerge<uchar, 4>(cases, big);
+	addMerge<float, 3>(cases, big);
+}
@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <core/fbcdef.hpp>
+#include <core/utility.hpp>
+#include <core/parallel.hpp>
+
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+	#include <opencv2/opencv.hpp>
+#endif
+
+#include "benchmark.hpp"
+
+// Benchmark of the fbc_cv ops against their OpenCV equivalents
+// every case is run until both min_time seconds and min_iters iterations are reached (max_iters at most),
+// after one warm-up call which fills the caches, the thread pool and the resize plans
+// the median and the 99th percentile of the per-call times are reported, the throughput is computed
+// with the median and ratio = fbc median / cv median (< 1: fbc_cv is faster)
+
+struct BenchStats {
+	int iterations;
+	double median_ms, p99_ms, mean_ms, min_ms;
+};
+
+struct BenchResult {
+	const BenchCase* bench;
+	BenchStats fbc, cv;
+	bool has_cv;
+};
+
+struct BenchOptions {
+	std::string filter;
+	std::string json;
+	double min_time = 0.2;
+	int min_iters = 10;
+	int max_iters = 2000;
+	int threads = -1;
+	bool quick = false;
+	bool list = false;
+};
+
+static BenchStats measure(const std::function<void()>& fn, const BenchOptions& options)
+{
+	typedef std::chrono::steady_clock clock;
+
+	fn(); // warm up
+
+	std::vector<double> samples;
+	double total = 0;
+	while ((total < options.min_time || (int)samples.size() < options.min_iters) && (int)samples.size() < options.max_iters) {
+		clock::time_point t0 = clock::now();
+		fn();
+		double t = std::chrono::duration<double>(clock::now() - t0).count();
+		samples.push_back(t * 1000.);
+		total += t;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	size_t n = samples.size();
+
+	BenchStats stats;
+	stats.iterations = (int)n;
+	stats.median_ms = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+	stats.p99_ms = samples[std::min(n - 1, (size_t)ceil(n * 0.99) - 1)]; // nearest rank
+	stats.min_ms = samples[0];
+	double sum = 0;
+	for (double s : samples)
+		sum += s;
+	stats.mean_ms = sum / n;
+
+	return stats;
+}
+
+static double mpixPerSec(const BenchCase& c, const BenchStats& stats)
+{
+	return (double)c.width * c.height / (stats.median_ms * 1000.);
+}
+
+static std::string caseName(const BenchCase& c)
+{
+	return c.op + " " + c.params + " " + c.type;
+}
+
+static std::string jsonString(const std::string& s)
+{
+	std::string out = "\"";
+	for (char ch : s) {
+		if (ch == '"' || ch == '\\')
+			out += '\\';
+		out += ch;
+	}
+	return out + "\"";
+}
+
+static void writeStats(FILE* fp, const BenchCase& c, const BenchStats& stats)
+{
+	fprintf(fp, "{\"iterations\": %d, \"median_ms\": %.6f, \"p99_ms\": %.6f, \"mean_ms\": %.6f, \"min_ms\": %.6f, \"mpix_per_s\": %.3f}",
+		stats.iterations, stats.median_ms, stats.p99_ms, stats.mean_ms, stats.min_ms, mpixPerSec(c, stats));
+}
+
+static int writeJson(const std::string& path, const std::vector<BenchResult>& results, const BenchOptions& options)
+{
+	FILE* fp = fopen(path.c_str(), "w");
+	if (!fp) {
+		fprintf(stderr, "fail to open %s\n", path.c_str());
+		return -1;
+	}
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"version\": 1,\n");
+	fprintf(fp, "  \"threads\": %d,\n", fbc::getNumThreads());
+	fprintf(fp, "  \"optimized\": %s,\n", fbc::useOptimized() ? "true" : "false");
+	fprintf(fp, "  \"cpu\": {\"sse4_1\": %s, \"avx2\": %s},\n", fbc::checkHardwareSupport(FBC_CPU_SSE4_1) ? "true" : "false",
+		fbc::checkHardwareSupport(FBC_CPU_AVX2) ? "true" : "false");
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+	fprintf(fp, "  \"opencv\": %s,\n", jsonString(CV_VERSION).c_str());
+#else
+	fprintf(fp, "  \"opencv\": null,\n");
+#endif
+	fprintf(fp, "  \"min_time_s\": %g,\n", options.min_time);
+	fprintf(fp, "  \"cases\": [");
+
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& r = results[i];
+		const BenchCase& c = *r.bench;
+
+		fprintf(fp, "%s\n    {\"name\": %s, \"op\": %s, \"params\": %s, \"type\": %s, \"width\": %d, \"height\": %d,\n     \"fbc\": ",
+			i ? "," : "", jsonString(caseName(c)).c_str(), jsonString(c.op).c_str(), jsonString(c.params).c_str(), jsonString(c.type).c_str(), c.width, c.height);
+		writeStats(fp, c, r.fbc);
+		if (r.has_cv) {
+			fprintf(fp, ",\n     \"cv\": ");
+			writeStats(fp, c, r.cv);
+			fprintf(fp, ",\n     \"ratio\": %.4f}", r.fbc.median_ms / r.cv.median_ms);
+		} else {
+			fprintf(fp, ",\n     \"cv\": null, \"ratio\": null}");
+		}
+	}
+
+	fprintf(fp, "\n  ]\n}\n");
+	fclose(fp);
+
+	return 0;
+}
+
+static void usage(const char* name)
+{
+	fprintf(stderr, "usage: %s [options]\n"
+		"  --filter <text>    run only the cases whose name contains text, e.g. \"resize INTER_LINEAR\"\n"
+		"  --json <file>      write the results to file as JSON\n"
+		"  --min-time <s>     minimum measuring time of a case (default 0.2)\n"
+		"  --min-iters <n>    minimum number of iterations of a case (default 10)\n"
+		"  --max-iters <n>    maximum number of iterations of a case (default 2000)\n"
+		"  --threads <n>      number of threads of fbc_cv and OpenCV\n"
+		"  --quick            fewer and smaller cases\n"
+		"  --list             print the names of the cases only\n", name);
+}
+
+static bool parseOptions(int argc, char* argv[], BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+
+		if (arg == "--filter" && has_value) options.filter = argv[++i];
+		else if (arg == "--json" && has_value) options.json = argv[++i];
+		else if (arg == "--min-time" && has_value) options.min_time = atof(argv[++i]);
+		else if (arg == "--min-iters" && has_value) options.min_iters = atoi(argv[++i]);
+		else if (arg == "--max-iters" && has_value) options.max_iters = atoi(argv[++i]);
+		else if (arg == "--threads" && has_value) options.threads = atoi(argv[++i]);
+		else if (arg == "--quick") options.quick = true;
+		else if (arg == "--list") options.list = true;
+		else return false;
+	}
+
+	return options.min_iters >= 1 && options.max_iters >= options.min_iters;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	if (options.threads > 0)
+		fbc::setNumThreads(options.threads);
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+	// both libraries run with the same number of threads
+	cv::setNumThreads(fbc::getNumThreads());
+#endif
+
+	std::vector<BenchCase> cases;
+	registerBenchmarks(cases, options.quick);
+
+	std::vector<BenchResult> results;
+	if (!options.list) {
+		fprintf(stdout, "threads: %d, optimized: %d, SSE4.1: %d, AVX2: %d\n", fbc::getNumThreads(), fbc::useOptimized(),
+			fbc::checkHardwareSupport(FBC_CPU_SSE4_1), fbc::checkHardwareSupport(FBC_CPU_AVX2));
+		fprintf(stdout, "%-72s %10s %10s %9s %10s %7s\n", "case", "median ms", "p99 ms", "MPix/s", "cv ms", "ratio");
+	}
+
+	for (const BenchCase& c : cases) {
+		std::string name = caseName(c);
+		if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+			continue;
+		if (options.list) {
+			fprintf(stdout, "%s\n", name.c_str());
+			continue;
+		}
+
+		BenchResult r;
+		r.bench = &c;
+		{
+			BenchFunctions f = c.setup();
+			r.fbc = measure(f.fbc, options);
+			r.has_cv = (bool)f.cv;
+			if (r.has_cv)
+				r.cv = measure(f.cv, options);
+		} // the images of the case are released here
+
+		if (r.has_cv)
+			fprintf(stdout, "%-72s %10.3f %10.3f %9.1f %10.3f %7.2f\n", name.c_str(), r.fbc.median_ms, r.fbc.p99_ms, mpixPerSec(c, r.fbc),
+				r.cv.median_ms, r.fbc.median_ms / r.cv.median_ms);
+		else
+			fprintf(stdout, "%-72s %10.3f %10.3f %9.1f %10s %7s\n", name.c_str(), r.fbc.median_ms, r.fbc.p99_ms, mpixPerSec(c, r.fbc), "-", "-");
+		fflush(stdout);
+
+		results.push_back(r);
+	}
+
+	if (!options.json.empty() && !options.list)
+		return writeJson(options.json, results, options);
+
+	return 0;
+}
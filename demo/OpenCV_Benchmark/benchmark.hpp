@@ -0,0 +1,34 @@
+#ifndef FBC_CV_BENCHMARK_HPP_
+#define FBC_CV_BENCHMARK_HPP_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// the OpenCV side of a case, compiled only when the benchmark is built with OpenCV
+#ifdef FBC_BENCHMARK_WITH_OPENCV
+	#define BENCH_CV(...) __VA_ARGS__
+#else
+	#define BENCH_CV(...) nullptr
+#endif
+
+// the calls measured by a case, cv is empty without OpenCV or when OpenCV has no equivalent
+struct BenchFunctions {
+	std::function<void()> fbc;
+	std::function<void()> cv;
+};
+
+// one measured operation, setup() allocates and fills the images of the case (they are released
+// after the case is measured) and returns the calls
+struct BenchCase {
+	std::string op; // e.g. "resize"
+	std::string params; // e.g. "INTER_LINEAR 1920x1080->640x360"
+	std::string type; // e.g. "8UC3"
+	int width, height; // the size the throughput (MPix/s) is computed with, usually the output size
+	std::function<BenchFunctions()> setup;
+};
+
+// quick: fewer and smaller sizes, for a fast check
+void registerBenchmarks(std::vector<BenchCase>& cases, bool quick);
+
+#endif // FBC_CV_BENCHMARK_HPP_
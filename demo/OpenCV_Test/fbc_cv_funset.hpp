@@ -4,6 +4,8 @@
 int test_ffmpeg_dshow_mjpeg();
 int test_get_camera_info();
 int test_opencv_dshow();
+int test_videocapture_v4l2();
+int test_videocapture_async();
 
 int test_fast_math();
 int test_base();
@@ -18,6 +20,8 @@ int test_Range();
 int test_Scalar();
 int test_Mat();
 int test_RotateRect();
+int test_parallel_for();
+int test_MatAllocator();
 
 int test_cvtColor_RGB2RGB();
 int test_cvtColor_RGB2Gray();
@@ -33,8 +37,10 @@ int test_cvtColor_Lab2RGB();
 int test_cvtColor_YUV2BGR();
 int test_cvtColor_BGR2YUV();
 int test_cvtColor_YUV2Gray();
+int test_cvtColor_static();
 
 int test_dft_float();
+int test_dft_plan();
 
 int test_getStructuringElement();
 int test_dilate_uchar();
@@ -47,35 +53,65 @@ int test_directory_GetListFolders();
 int test_erode_uchar();
 int test_erode_float();
 
+int test_filterpipeline();
+
+int test_GaussianBlur_uchar();
+int test_GaussianBlur_float();
+
+int test_boxFilter_uchar();
+int test_boxFilter_float();
+
+int test_integral();
+
+int test_pyrDown_uchar();
+int test_pyrDown_float();
+int test_pyrUp_uchar();
+int test_buildPyramid();
+
 int test_flip_uchar();
 int test_flip_float();
 
+int test_LUT();
+int test_Lut3D();
+
 int test_merge_uchar();
 int test_merge_float();
 
 int test_morphologyEx_uchar();
 int test_morphologyEx_float();
 int test_morphologyEx_hitmiss();
+int test_morphologyEx_large_kernel();
 
 int test_remap_uchar();
 int test_remap_float();
+int test_remap_plan();
 
 int test_resize_uchar();
 int test_resize_float();
 int test_resize_area();
+int test_ResizePlan();
+int test_resize_optimized();
+
+int test_blobFromYUV();
+
+int test_batch();
 
 int test_getRotationMatrix2D();
 int test_rotate_uchar();
 int test_rotate_float();
 int test_rotate_without_crop();
+int test_rotate_right_angle();
 
 int test_rotate90();
 
 int test_split_uchar();
 int test_split_float();
+int test_split_planes();
 
 int test_threshold_uchar();
 int test_threshold_float();
+int test_threshold_otsu();
+int test_localThreshold();
 
 int test_transpose_uchar();
 int test_transpose_float();
@@ -83,6 +119,7 @@ int test_transpose_float();
 int test_getAffineTransform();
 int test_warpAffine_uchar();
 int test_warpAffine_float();
+int test_warpAffine_crops();
 
 int test_getPerspectiveTransform();
 int test_warpPerspective_uchar();
@@ -0,0 +1,118 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <math.h>
+
+#include <GaussianBlur.hpp>
+#include <sepFilter2D.hpp>
+#include <opencv2/opencv.hpp>
+
+int test_GaussianBlur_uchar()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// fixed kernels (sigma 0), kernels computed from sigma, different sizes in x and y
+	const int ksizes[][2] = { { 3, 3 }, { 5, 5 }, { 7, 7 }, { 0, 0 }, { 9, 3 } };
+	const double sigmas[] = { 0, 0, 0, 2.5, 1.2 };
+	const int borders[] = { fbc::BORDER_DEFAULT, fbc::BORDER_REPLICATE, fbc::BORDER_CONSTANT };
+
+	for (int i = 0; i < 5; i++) {
+		for (int b = 0; b < 3; b++) {
+			fbc::Mat3BGR mat1(height, width, matSrc.data);
+			fbc::Mat3BGR mat2(height, width);
+			fbc::GaussianBlur(mat1, mat2, fbc::Size(ksizes[i][0], ksizes[i][1]), sigmas[i], 0, borders[b]);
+
+			cv::Mat mat1_(height, width, CV_8UC3, matSrc.data);
+			cv::Mat mat2_;
+			cv::GaussianBlur(mat1_, mat2_, cv::Size(ksizes[i][0], ksizes[i][1]), sigmas[i], 0, borders[b]);
+
+			assert(mat2.rows == mat2_.rows && mat2.cols == mat2_.cols && mat2.step == mat2_.step);
+			for (int y = 0; y < mat2.rows; y++) {
+				const fbc::uchar* p1 = mat2.ptr(y);
+				const uchar* p2 = mat2_.ptr(y);
+
+				for (int x = 0; x < mat2.step; x++) {
+					assert(p1[x] == p2[x]);
+				}
+			}
+		}
+	}
+
+	// separable filter with an asymmetrical kernel (float buffer) and a delta
+	cv::Mat kx_ = (cv::Mat_<float>(1, 3) << -1, 0, 1);
+	cv::Mat ky_ = cv::getGaussianKernel(5, 0, CV_32F);
+	fbc::Mat_<float, 1> kx(1, 3, kx_.data), ky(5, 1, ky_.data);
+
+	fbc::Mat3BGR mat1(height, width, matSrc.data);
+	fbc::Mat3BGR mat2(height, width);
+	fbc::sepFilter2D(mat1, mat2, kx, ky, fbc::Point(-1, -1), 128);
+
+	cv::Mat mat1_(height, width, CV_8UC3, matSrc.data);
+	cv::Mat mat2_;
+	cv::sepFilter2D(mat1_, mat2_, CV_8U, kx_, ky_, cv::Point(-1, -1), 128);
+
+	for (int y = 0; y < mat2.rows; y++) {
+		const fbc::uchar* p1 = mat2.ptr(y);
+		const uchar* p2 = mat2_.ptr(y);
+
+		for (int x = 0; x < mat2.step; x++) {
+			assert(p1[x] == p2[x]);
+		}
+	}
+
+	return 0;
+}
+
+int test_GaussianBlur_float()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::cvtColor(matSrc, matSrc, CV_BGR2GRAY);
+	matSrc.convertTo(matSrc, CV_32FC1);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	const int ksizes[] = { 3, 5, 0 };
+	const double sigmas[] = { 0, 0, 3 };
+
+	for (int i = 0; i < 3; i++) {
+		fbc::Mat_<float, 1> mat1(height, width, matSrc.data);
+		fbc::Mat_<float, 1> mat2(height, width);
+		fbc::GaussianBlur(mat1, mat2, fbc::Size(ksizes[i], ksizes[i]), sigmas[i]);
+
+		cv::Mat mat1_(height, width, CV_32FC1, matSrc.data);
+		cv::Mat mat2_;
+		cv::GaussianBlur(mat1_, mat2_, cv::Size(ksizes[i], ksizes[i]), sigmas[i]);
+
+		// OpenCV sums the terms in another order
+		for (int y = 0; y < mat2.rows; y++) {
+			const float* p1 = (const float*)mat2.ptr(y);
+			const float* p2 = (const float*)mat2_.ptr(y);
+
+			for (int x = 0; x < mat2.cols; x++) {
+				assert(fabs(p1[x] - p2[x]) < 1e-3);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <iostream>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <core/mat.hpp>
+#include <resize.hpp>
+#include <cvtColor.hpp>
+#include <warpAffine.hpp>
+#include <threshold.hpp>
+#include <flip.hpp>
+#include <erode.hpp>
+
+template<typename _Tp, int chs>
+static bool batchEqual(const fbc::Mat_<_Tp, chs>& mat, const cv::Mat& mat_)
+{
+	if (mat.rows != mat_.rows || mat.cols != mat_.cols || (int)mat.elemSize() != (int)mat_.elemSize())
+		return false;
+
+	for (int y = 0; y < mat.rows; y++) {
+		if (memcmp(mat.ptr(y), mat_.ptr(y), mat.cols * mat.elemSize()) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+int test_batch()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	// 32 crops of an inference batch: different sizes for resize, the same size for the other ops
+	const int count = 32;
+	std::vector<cv::Mat> crops_(count), same_(count);
+	std::vector<fbc::Mat_<uchar, 3>> crops(count), same(count);
+	for (int i = 0; i < count; i++) {
+		cv::Rect rect((i * 37) % (matSrc.cols / 2), (i * 53) % (matSrc.rows / 2), 64 + (i % 5) * 40, 96 + (i % 3) * 30);
+		crops_[i] = matSrc(rect).clone();
+		crops[i] = fbc::Mat_<uchar, 3>(crops_[i].rows, crops_[i].cols);
+		memcpy(crops[i].data, crops_[i].data, crops_[i].total() * 3);
+
+		same_[i] = matSrc(cv::Rect(rect.x, rect.y, 128, 96)).clone();
+		same[i] = fbc::Mat_<uchar, 3>(96, 128);
+		memcpy(same[i].data, same_[i].data, 96 * 128 * 3);
+	}
+
+	std::vector<fbc::Mat_<uchar, 3>> dst;
+	for (int interpolation = 0; interpolation < 5; interpolation++) {
+		fbc::resize(crops, dst, fbc::Size(416, 416), interpolation);
+		assert((int)dst.size() == count);
+
+		for (int i = 0; i < count; i++) {
+			cv::Mat dst_;
+			cv::resize(crops_[i], dst_, cv::Size(416, 416), 0, 0, interpolation);
+			assert(batchEqual(dst[i], dst_));
+		}
+	}
+
+	// the images of the previous batch are reused
+	const uchar* data = dst[0].data;
+	fbc::resize(crops, dst, fbc::Size(416, 416), fbc::INTER_LINEAR);
+	assert(dst[0].data == data);
+
+	std::vector<fbc::Mat_<uchar, 1>> gray;
+	fbc::cvtColor(same, gray, fbc::CV_BGR2GRAY);
+	std::vector<fbc::Mat_<uchar, 1>> yuv;
+	fbc::cvtColor(same, yuv, fbc::CV_BGR2YUV_I420);
+	for (int i = 0; i < count; i++) {
+		cv::Mat gray_, yuv_;
+		cv::cvtColor(same_[i], gray_, cv::COLOR_BGR2GRAY);
+		cv::cvtColor(same_[i], yuv_, cv::COLOR_BGR2YUV_I420);
+		assert(batchEqual(gray[i], gray_));
+		assert(batchEqual(yuv[i], yuv_));
+	}
+
+	cv::Mat warp_mat_ = cv::getRotationMatrix2D(cv::Point2f(64, 48), 30, 0.8);
+	fbc::Mat_<double, 1> warp_mat(2, 3, warp_mat_.data);
+	for (int interpolation = 0; interpolation < 5; interpolation++) {
+		if (interpolation == fbc::INTER_AREA)
+			continue;
+
+		fbc::warpAffine(same, dst, warp_mat, fbc::Size(112, 112), interpolation);
+		for (int i = 0; i < count; i++) {
+			cv::Mat dst_;
+			cv::warpAffine(same_[i], dst_, warp_mat_, cv::Size(112, 112), interpolation);
+			assert(batchEqual(dst[i], dst_));
+		}
+	}
+
+	std::vector<fbc::Mat_<uchar, 1>> binary;
+	std::vector<double> thresholds = fbc::threshold(gray, binary, 0, 255, fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	assert((int)thresholds.size() == count);
+	for (int i = 0; i < count; i++) {
+		cv::Mat gray_, binary_;
+		cv::cvtColor(same_[i], gray_, cv::COLOR_BGR2GRAY);
+		double thresh_ = cv::threshold(gray_, binary_, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+		assert(batchEqual(binary[i], binary_) && thresholds[i] == thresh_);
+	}
+
+	for (int flipCode = -1; flipCode <= 1; flipCode++) {
+		fbc::flip(same, dst, flipCode);
+		for (int i = 0; i < count; i++) {
+			cv::Mat dst_;
+			cv::flip(same_[i], dst_, flipCode);
+			assert(batchEqual(dst[i], dst_));
+		}
+	}
+
+	// the images of a batch don't share their data: a filter which replicates the border of an image gives the
+	// same result as on a standalone copy of the image, whatever the neighbouring images of the batch are
+	std::vector<fbc::Mat_<uchar, 1>> planes(4), flipped;
+	for (int i = 0; i < (int)planes.size(); i++) {
+		planes[i] = fbc::Mat_<uchar, 1>(6, 7);
+		planes[i].setTo(fbc::Scalar::all(i % 2 ? 255 : 0));
+	}
+	fbc::flip(planes, flipped, 1);
+	fbc::Mat_<uchar, 1> element(3, 3);
+	element.setTo(fbc::Scalar::all(1));
+	for (int i = 0; i < (int)flipped.size(); i++) {
+		fbc::Mat_<uchar, 1> standalone = flipped[i].clone(), eroded(6, 7), eroded_standalone(6, 7);
+		fbc::erode(flipped[i], eroded, element, fbc::Point(-1, -1), 1, fbc::BORDER_REPLICATE);
+		fbc::erode(standalone, eroded_standalone, element, fbc::Point(-1, -1), 1, fbc::BORDER_REPLICATE);
+		for (int y = 0; y < eroded.rows; y++)
+			assert(memcmp(eroded.ptr(y), eroded_standalone.ptr(y), eroded.cols) == 0 && eroded.ptr(y)[0] == (i % 2 ? 255 : 0));
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <assert.h>
+#include <vector>
+#include <core/mat.hpp>
+#include <blobFromYUV.hpp>
+
+#include <opencv2/opencv.hpp>
+
+#include "fbc_cv_funset.hpp"
+
+int test_blobFromYUV()
+{
+#ifdef _MSC_VER
+	cv::Mat mat = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat mat = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!mat.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat i420;
+	cv::cvtColor(mat, i420, cv::COLOR_BGR2YUV_I420);
+
+	int width = mat.cols, height = mat.rows;
+
+	// NV12 frame: the U and V planes of the I420 frame interleaved
+	cv::Mat nv12(i420.rows, i420.cols, CV_8UC1);
+	memcpy(nv12.data, i420.data, width * height);
+	const uchar* u = i420.data + width * height;
+	const uchar* v = u + width * height / 4;
+	uchar* uv = nv12.data + width * height;
+	for (int i = 0; i < width * height / 4; i++) {
+		uv[2 * i] = u[i];
+		uv[2 * i + 1] = v[i];
+	}
+
+	const int codes[][2] = { { fbc::CV_YUV2BGR_I420, cv::COLOR_YUV2BGR_I420 }, { fbc::CV_YUV2RGB_I420, cv::COLOR_YUV2RGB_I420 },
+		{ fbc::CV_YUV2BGR_NV12, cv::COLOR_YUV2BGR_NV12 }, { fbc::CV_YUV2RGB_NV12, cv::COLOR_YUV2RGB_NV12 } };
+	const int sizes[][2] = { { 416, 416 }, { width / 2, height / 2 }, { 300, 200 } };
+	const int inters[] = { fbc::INTER_LINEAR, fbc::INTER_AREA };
+	fbc::Scalar mean(103.53, 116.28, 123.675), stddev(57.375, 57.12, 58.395);
+
+	for (int c = 0; c < 4; c++) {
+		cv::Mat& yuv = (c < 2) ? i420 : nv12;
+
+		for (int s = 0; s < 3; s++) {
+			for (int i = 0; i < 2; i++) {
+				int dw = sizes[s][0], dh = sizes[s][1];
+
+				// cvtColor + resize + normalize + split of OpenCV
+				cv::Mat bgr_, resized_;
+				cv::cvtColor(yuv, bgr_, codes[c][1]);
+				cv::resize(bgr_, resized_, cv::Size(dw, dh), 0, 0, inters[i]);
+
+				std::vector<float> blob_(dw * dh * 3);
+				for (int y = 0; y < dh; y++) {
+					const uchar* p = resized_.ptr(y);
+					for (int x = 0; x < dw; x++) {
+						for (int ch = 0; ch < 3; ch++) {
+							blob_[ch * dw * dh + y * dw + x] = (float)((p[x * 3 + ch] - mean.val[ch]) / stddev.val[ch]);
+						}
+					}
+				}
+
+				fbc::Mat_<uchar, 1> mat1(yuv.rows, yuv.cols, yuv.data);
+				std::vector<float> blob(dw * dh * 3);
+				fbc::blobFromYUV(mat1, codes[c][0], blob.data(), fbc::Size(dw, dh), inters[i], mean, stddev);
+
+				assert(memcmp(blob.data(), blob_.data(), blob.size() * sizeof(float)) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
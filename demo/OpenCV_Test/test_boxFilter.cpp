@@ -0,0 +1,112 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <math.h>
+
+#include <boxFilter.hpp>
+#include <opencv2/opencv.hpp>
+
+int test_boxFilter_uchar()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	const int ksizes[][2] = { { 3, 3 }, { 5, 5 }, { 31, 31 }, { 7, 2 } };
+
+	for (int i = 0; i < 4; i++) {
+		for (int normalize = 0; normalize < 2; normalize++) {
+			fbc::Mat3BGR mat1(height, width, matSrc.data);
+			fbc::Mat3BGR mat2(height, width);
+			if (normalize)
+				fbc::blur(mat1, mat2, fbc::Size(ksizes[i][0], ksizes[i][1]));
+			else
+				fbc::boxFilter(mat1, mat2, fbc::Size(ksizes[i][0], ksizes[i][1]), fbc::Point(-1, -1), false, fbc::BORDER_REPLICATE);
+
+			cv::Mat mat1_(height, width, CV_8UC3, matSrc.data);
+			cv::Mat mat2_;
+			if (normalize)
+				cv::blur(mat1_, mat2_, cv::Size(ksizes[i][0], ksizes[i][1]));
+			else
+				cv::boxFilter(mat1_, mat2_, -1, cv::Size(ksizes[i][0], ksizes[i][1]), cv::Point(-1, -1), false, cv::BORDER_REPLICATE);
+
+			assert(mat2.rows == mat2_.rows && mat2.cols == mat2_.cols && mat2.step == mat2_.step);
+			for (int y = 0; y < mat2.rows; y++) {
+				const fbc::uchar* p1 = mat2.ptr(y);
+				const uchar* p2 = mat2_.ptr(y);
+
+				for (int x = 0; x < mat2.step; x++) {
+					assert(p1[x] == p2[x]);
+				}
+			}
+		}
+	}
+
+	// an odd width reaches the scalar tail of the optimized column sums: the ties of the even kernels are rounded
+	// the same with and without the optimized code
+	cv::Mat crop = matSrc(cv::Rect(0, 0, 101, 64)).clone();
+	const int even_ksizes[][2] = { { 2, 2 }, { 7, 2 } };
+	for (int i = 0; i < 2; i++) {
+		fbc::Mat3BGR mat1(crop.rows, crop.cols, crop.data);
+		fbc::Mat3BGR mat2(crop.rows, crop.cols), mat3(crop.rows, crop.cols);
+		fbc::setUseOptimized(true);
+		fbc::blur(mat1, mat2, fbc::Size(even_ksizes[i][0], even_ksizes[i][1]));
+		fbc::setUseOptimized(false);
+		fbc::blur(mat1, mat3, fbc::Size(even_ksizes[i][0], even_ksizes[i][1]));
+		fbc::setUseOptimized(true);
+
+		for (int y = 0; y < mat2.rows; y++)
+			assert(memcmp(mat2.ptr(y), mat3.ptr(y), mat2.cols * 3) == 0);
+	}
+
+	return 0;
+}
+
+int test_boxFilter_float()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	matSrc.convertTo(matSrc, CV_32FC3);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	const int ksizes[] = { 3, 9, 31 };
+
+	for (int i = 0; i < 3; i++) {
+		fbc::Mat_<float, 3> mat1(height, width, matSrc.data);
+		fbc::Mat_<float, 3> mat2(height, width);
+		fbc::blur(mat1, mat2, fbc::Size(ksizes[i], ksizes[i]));
+
+		cv::Mat mat1_(height, width, CV_32FC3, matSrc.data);
+		cv::Mat mat2_;
+		cv::blur(mat1_, mat2_, cv::Size(ksizes[i], ksizes[i]));
+
+		for (int y = 0; y < mat2.rows; y++) {
+			const float* p1 = (const float*)mat2.ptr(y);
+			const float* p2 = (const float*)mat2_.ptr(y);
+
+			for (int x = 0; x < mat2.cols * 3; x++) {
+				assert(fabs(p1[x] - p2[x]) < 1e-3);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -7,6 +7,9 @@
 #include <core/types.hpp>
 #include <core/mat.hpp>
 #include <core/Ptr.hpp>
+#include <core/parallel.hpp>
+#include <core/utility.hpp>
+#include <resize.hpp>
 
 #include <opencv2/opencv.hpp>
 #include "fbc_cv_funset.hpp"
@@ -633,9 +636,15 @@ int test_Mat()
 	assert(flag1 == false);
 	bool flag_isContinuous1 = mat4.isContinuous();
 	assert(flag_isContinuous1 == true);
-	fbc::Mat3BGR mat5(mat4); // mat5分配了新的空间,注意与mat5_的不同
+	fbc::Mat3BGR mat5(mat4); // mat5并未分配新的空间,与mat5_相同
+	assert(mat5.data == mat4.data && mat5.refcount == NULL);
 	fbc::Mat3BGR mat6;
-	mat6 = mat4; // mat6分配了新的空间,注意与mat6_的不同
+	mat6 = mat4; // mat6并未分配新的空间,与mat6_相同
+	assert(mat6.data == mat4.data);
+	fbc::Mat3BGR mat15 = mat4.clone(); // mat15分配了新的空间
+	assert(mat15.data != mat4.data && *mat15.refcount == 1);
+	fbc::Mat3BGR mat16(mat15), mat17(std::move(mat15));
+	assert(*mat16.refcount == 2 && mat15.empty() && mat17.data == mat16.data);
 	fbc::Mat3BGR mat7(100, 100);
 	mat_dump(mat4, mat7);
 	fbc::Mat3BGR mat8;
@@ -739,3 +748,116 @@ int test_RotateRect()
 	return 0;
 }
 
+int test_parallel_for()
+{
+	const int rows = 1080, cols = 1920;
+	std::vector<int> sum(rows, 0), sum_(rows, 0);
+
+	fbc::setNumThreads(4);
+	assert(fbc::getNumThreads() == 4);
+	fbc::parallel_for_(fbc::Range(0, rows), [&](const fbc::Range& range) {
+		for (int y = range.start; y < range.end; y++) {
+			for (int x = 0; x < cols; x++)
+				sum[y] += (x ^ y) & 0xff;
+		}
+	});
+
+	cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+		for (int y = range.start; y < range.end; y++) {
+			for (int x = 0; x < cols; x++)
+				sum_[y] += (x ^ y) & 0xff;
+		}
+	});
+
+	for (int y = 0; y < rows; y++) {
+		assert(sum[y] == sum_[y]);
+	}
+
+	fbc::Mat_<uchar, 3> mat1(rows, cols);
+	for (int y = 0; y < rows; y++) {
+		uchar* p = mat1.ptr(y);
+		for (int x = 0; x < cols * 3; x++)
+			p[x] = (uchar)((x * 7 + y * 13) & 0xff);
+	}
+
+	fbc::Mat_<uchar, 3> mat2(rows / 3, cols / 3), mat3(rows / 3, cols / 3);
+	fbc::setNumThreads(0);
+	fbc::resize(mat1, mat2, fbc::INTER_LINEAR);
+	fbc::setNumThreads(-1);
+	fbc::resize(mat1, mat3, fbc::INTER_LINEAR);
+
+	cv::Mat mat1_(rows, cols, CV_8UC3, mat1.data);
+	cv::Mat mat2_;
+	cv::resize(mat1_, mat2_, cv::Size(cols / 3, rows / 3), 0, 0, cv::INTER_LINEAR);
+
+	for (int y = 0; y < rows / 3; y++) {
+		assert(memcmp(mat2.ptr(y), mat3.ptr(y), mat2.step) == 0);
+		assert(memcmp(mat3.ptr(y), mat2_.ptr(y), mat2.step) == 0);
+	}
+
+	return 0;
+}
+
+namespace {
+class CountingAllocator : public fbc::MatAllocator {
+public:
+	void* allocate(size_t size) { count++; return fbc::fastMalloc(size); }
+	void deallocate(void* ptr, size_t size) { count--; fbc::fastFree(ptr); }
+
+	int count = 0;
+};
+} // namespace
+
+int test_MatAllocator()
+{
+	const int rows = 480, cols = 640;
+	fbc::setBufferPoolEnabled(true);
+	fbc::resetMemoryStats();
+	fbc::MemoryStats stats1 = fbc::getMemoryStats();
+
+	{
+		fbc::Mat_<uchar, 3> mat1(rows, cols);
+		assert(fbc::getMemoryStats().bytesLive >= stats1.bytesLive + rows * cols * 3);
+	}
+	{
+		// a buffer of the same size class is taken from the pool
+		fbc::Mat_<uchar, 3> mat2(rows, cols);
+		assert(fbc::getMemoryStats().poolHits > stats1.poolHits);
+	}
+	for (int i = 0; i < 10; i++) {
+		fbc::AutoBuffer<int> buf(4096);
+		buf[0] = i;
+	}
+	assert(fbc::getMemoryStats().scratchHits >= stats1.scratchHits + 9);
+
+	CountingAllocator allocator;
+	{
+		fbc::Mat_<float, 1> mat3;
+		mat3.allocator = &allocator;
+		mat3.create(rows, cols);
+		fbc::Mat_<float, 1> mat4(mat3);
+		assert(allocator.count == 1);
+	}
+	assert(allocator.count == 0);
+
+	fbc::setDefaultAllocator(&allocator);
+	fbc::Mat_<uchar, 3> mat5(rows, cols, fbc::Scalar(1, 2, 3)), mat6(rows / 2, cols / 2);
+	assert(allocator.count == 2);
+	fbc::resize(mat5, mat6, fbc::INTER_AREA);
+	fbc::setDefaultAllocator(NULL);
+
+	cv::Mat mat5_(rows, cols, CV_8UC3, cv::Scalar(1, 2, 3)), mat6_;
+	cv::resize(mat5_, mat6_, cv::Size(cols / 2, rows / 2), 0, 0, cv::INTER_AREA);
+	for (int y = 0; y < rows / 2; y++) {
+		assert(memcmp(mat6.ptr(y), mat6_.ptr(y), mat6.step) == 0);
+	}
+
+	mat5.release();
+	mat6.release();
+	assert(allocator.count == 0);
+
+	fbc::releaseBufferPool();
+	assert(fbc::getMemoryStats().peakBytesLive >= rows * cols * 4);
+
+	return 0;
+}
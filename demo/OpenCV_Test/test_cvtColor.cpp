@@ -873,3 +873,76 @@ int test_cvtColor_YUV2Gray()
 
 	return 0;
 }
+
+// cvtColor<code>(src, dst) gives the same results as cvtColor(src, dst, code)
+template<int code, typename _Tp, int chs1, int chs2>
+static bool cvtColorStaticEqual(const fbc::Mat_<_Tp, chs1>& src)
+{
+	fbc::Mat_<_Tp, chs2> dst1(src.rows, src.cols), dst2(src.rows, src.cols);
+	fbc::cvtColor(src, dst1, code);
+	fbc::cvtColor<code>(src, dst2);
+
+	for (int y = 0; y < src.rows; y++) {
+		if (memcmp(dst1.ptr(y), dst2.ptr(y), src.cols * chs2 * sizeof(_Tp)) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+int test_cvtColor_static()
+{
+#ifdef _MSC_VER
+	cv::Mat mat = cv::imread("../../../test_images/lena.png", 1);
+#else	
+	cv::Mat mat = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!mat.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	// uchar, odd width submatrix
+	fbc::Mat3BGR mat1(mat.rows, mat.cols, mat.data), roi1;
+	mat1.getROI(roi1, fbc::Rect(3, 5, mat.cols - 10, mat.rows - 7));
+
+	assert((cvtColorStaticEqual<fbc::CV_BGR2BGRA, uchar, 3, 4>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_RGB2BGR, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_BGR2GRAY, uchar, 3, 1>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_BGR2YCrCb, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_RGB2YUV, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_YCrCb2BGR, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_YUV2RGB, uchar, 3, 4>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_BGR2HSV, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_RGB2HSV_FULL, uchar, 3, 3>(roi1)));
+	assert((cvtColorStaticEqual<fbc::CV_HSV2BGR, uchar, 3, 3>(roi1)));
+
+	fbc::Mat_<uchar, 4> mat2(mat.rows, mat.cols);
+	fbc::cvtColor(mat1, mat2, fbc::CV_BGR2BGRA);
+	assert((cvtColorStaticEqual<fbc::CV_BGRA2BGR, uchar, 4, 3>(mat2)));
+	assert((cvtColorStaticEqual<fbc::CV_RGBA2GRAY, uchar, 4, 1>(mat2)));
+	assert((cvtColorStaticEqual<fbc::CV_BGR2YUV, uchar, 4, 3>(mat2)));
+
+	// float
+	cv::Mat matf;
+	mat.convertTo(matf, CV_32FC3, 1.0 / 255);
+	fbc::Mat_<float, 3> mat3(mat.rows, mat.cols, matf.data);
+
+	assert((cvtColorStaticEqual<fbc::CV_BGR2GRAY, float, 3, 1>(mat3)));
+	assert((cvtColorStaticEqual<fbc::CV_BGR2YCrCb, float, 3, 3>(mat3)));
+	assert((cvtColorStaticEqual<fbc::CV_YUV2BGR, float, 3, 3>(mat3)));
+	assert((cvtColorStaticEqual<fbc::CV_RGB2HSV, float, 3, 3>(mat3)));
+
+	// the template path against OpenCV
+	fbc::Mat3BGR mat4(mat.rows, mat.cols);
+	fbc::cvtColor<fbc::CV_BGR2YCrCb>(mat1, mat4);
+
+	cv::Mat mat4_;
+	cv::cvtColor(mat, mat4_, cv::COLOR_BGR2YCrCb);
+
+	for (int y = 0; y < mat4.rows; y++) {
+		assert(memcmp(mat4.ptr(y), mat4_.ptr(y), mat4.cols * 3) == 0);
+	}
+
+	return 0;
+}
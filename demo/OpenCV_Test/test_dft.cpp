@@ -188,3 +188,71 @@ int test_dft_float()
 
 	return 0;
 }
+
+int test_dft_plan()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 0);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 0);
+#endif
+	if (matSrc.empty()) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+	cv::Mat matf;
+	matSrc.convertTo(matf, CV_32FC1);
+
+	const int sizes[][2] = { { 256, 256 }, { 300, 200 }, { 97, 61 }, { 1, 128 }, { 75, 1 } };
+	const int batch = 4;
+
+	for (int s = 0; s < 5; s++) {
+		int width = sizes[s][0], height = sizes[s][1];
+
+		// the frames of a batch: crops at different offsets
+		std::vector<cv::Mat> frames_(batch);
+		std::vector<fbc::Mat_<float, 1>> frames(batch);
+		for (int i = 0; i < batch; i++) {
+			frames_[i] = matf(cv::Rect(i * 17, i * 11, width, height)).clone();
+			frames[i] = fbc::Mat_<float, 1>(height, width, frames_[i].data);
+		}
+
+		// real -> complex spectrum, the whole batch at once
+		std::vector<fbc::Mat_<float, 2>> spectrums;
+		fbc::dft(frames, spectrums, fbc::DFT_COMPLEX_OUTPUT);
+		assert((int)spectrums.size() == batch);
+
+		// complex -> real with a plan
+		fbc::DFTPlan<float, 2, 1> plan(fbc::Size(width, height), fbc::DFT_INVERSE | fbc::DFT_SCALE | fbc::DFT_REAL_OUTPUT);
+
+		for (int i = 0; i < batch; i++) {
+			cv::Mat spectrum_;
+			cv::dft(frames_[i], spectrum_, cv::DFT_COMPLEX_OUTPUT);
+
+			const fbc::Mat_<float, 2>& spectrum = spectrums[i];
+			assert(spectrum.rows == spectrum_.rows && spectrum.cols == spectrum_.cols && spectrum_.channels() == 2);
+			double scale = 255. * width * height;
+			for (int y = 0; y < height; y++) {
+				const float* p = (const float*)spectrum.ptr(y);
+				const float* p_ = spectrum_.ptr<float>(y);
+
+				for (int x = 0; x < width * 2; x++) {
+					assert(fabs(p[x] - p_[x]) <= 1e-5 * scale);
+				}
+			}
+
+			fbc::Mat_<float, 1> back;
+			plan.apply(spectrum, back);
+			for (int y = 0; y < height; y++) {
+				const float* p = (const float*)back.ptr(y);
+				const float* p_ = frames_[i].ptr<float>(y);
+
+				for (int x = 0; x < width; x++) {
+					assert(fabs(p[x] - p_[x]) <= 1e-2);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -104,7 +104,7 @@ int test_ffmpeg_dshow_mjpeg()
 // Blog: https://blog.csdn.net/fengbingchun/article/details/102806822
 int test_get_camera_info()
 {
-#ifdef _MSC_VER
+#if defined(_MSC_VER) || defined(__linux__)
 	std::map<int, fbc::device_info> camera_names;
 	fbc::get_camera_names(camera_names);
 	fprintf(stdout, "camera count: %d\n", camera_names.size());
@@ -137,7 +137,7 @@ int test_get_camera_info()
 
 	return 0;
 #else
-	fprintf(stderr, "Error: only support windows platform\n");
+	fprintf(stderr, "Error: only support windows and linux platform\n");
 	return -1;
 #endif
 }
@@ -19,6 +19,8 @@ int run_all_test()
 	test_Scalar();
 	test_Mat();
 	test_RotateRect();
+	test_parallel_for();
+	test_MatAllocator();
 
 	// test directory
 	std::cout << "test directory: " << std::endl;
@@ -56,6 +58,8 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_cvtColor_YUV2Gray();
 	assert(ret == 0);
+	ret = test_cvtColor_static();
+	assert(ret == 0);
 
 	// test merge
 	std::cout << "test merge: " << std::endl;
@@ -70,6 +74,8 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_split_float();
 	assert(ret == 0);
+	ret = test_split_planes();
+	assert(ret == 0);
 
 	// test resize
 	std::cout << "test resize: " << std::endl;
@@ -79,6 +85,15 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_resize_area();
 	assert(ret == 0);
+	ret = test_ResizePlan();
+	assert(ret == 0);
+	ret = test_resize_optimized();
+	assert(ret == 0);
+
+	// test blobFromYUV
+	std::cout << "test blobFromYUV: " << std::endl;
+	ret = test_blobFromYUV();
+	assert(ret == 0);
 
 	// test remap
 	std::cout << "test remap: " << std::endl;
@@ -86,6 +101,8 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_remap_float();
 	assert(ret == 0);
+	ret = test_remap_plan();
+	assert(ret == 0);
 
 	// test warpAffine
 	std::cout << "test warpAffine: " << std::endl;
@@ -95,6 +112,8 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_warpAffine_float();
 	assert(ret == 0);
+	ret = test_warpAffine_crops();
+	assert(ret == 0);
 
 	// test rotate
 	std::cout << "test rotate: " << std::endl;
@@ -106,6 +125,8 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_rotate_without_crop();
 	assert(ret == 0);
+	ret = test_rotate_right_angle();
+	assert(ret == 0);
 
 	// test warpPerspective
 	std::cout << "test warpPerspective: " << std::endl;
@@ -140,6 +161,13 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_morphologyEx_hitmiss();
 	assert(ret == 0);
+	ret = test_morphologyEx_large_kernel();
+	assert(ret == 0);
+
+	// test filterpipeline
+	std::cout << "test filterpipeline: " << std::endl;
+	ret = test_filterpipeline();
+	assert(ret == 0);
 
 	// test threshold
 	std::cout << "test threshold: " << std::endl;
@@ -147,6 +175,10 @@ int run_all_test()
 	assert(ret == 0);
 	ret = test_threshold_float();
 	assert(ret == 0);
+	ret = test_threshold_otsu();
+	assert(ret == 0);
+	ret = test_localThreshold();
+	assert(ret == 0);
 
 	// test transpose
 	std::cout << "test transpose: " << std::endl;
@@ -167,10 +199,63 @@ int run_all_test()
 	ret = test_rotate90();
 	assert(ret == 0);
 
+	// test LUT
+	std::cout << "test LUT: " << std::endl;
+	ret = test_LUT();
+	assert(ret == 0);
+	ret = test_Lut3D();
+	assert(ret == 0);
+
+	// test GaussianBlur
+	std::cout << "test GaussianBlur: " << std::endl;
+	ret = test_GaussianBlur_uchar();
+	assert(ret == 0);
+	ret = test_GaussianBlur_float();
+	assert(ret == 0);
+
+	// test boxFilter
+	std::cout << "test boxFilter: " << std::endl;
+	ret = test_boxFilter_uchar();
+	assert(ret == 0);
+	ret = test_boxFilter_float();
+	assert(ret == 0);
+
+	// test integral
+	std::cout << "test integral: " << std::endl;
+	ret = test_integral();
+	assert(ret == 0);
+
+	// test pyramids
+	std::cout << "test pyramids: " << std::endl;
+	ret = test_pyrDown_uchar();
+	assert(ret == 0);
+	ret = test_pyrDown_float();
+	assert(ret == 0);
+	ret = test_pyrUp_uchar();
+	assert(ret == 0);
+	ret = test_buildPyramid();
+	assert(ret == 0);
+
+	// test videocapture
+	std::cout << "test videocapture: " << std::endl;
+#ifdef __linux__
+	ret = test_videocapture_v4l2();
+	assert(ret == 0);
+	ret = test_videocapture_async();
+	assert(ret == 0);
+#endif
+
 	// test dft
 	std::cout << "test dft: " << std::endl;
 	ret = test_dft_float();
 	assert(ret == 0);
+	ret = test_dft_plan();
+	assert(ret == 0);
+
+	// test batch
+	std::cout << "test batch: " << std::endl;
+	ret = test_batch();
+	assert(ret == 0);
 
 	return 0;
 }
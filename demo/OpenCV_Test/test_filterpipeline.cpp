@@ -0,0 +1,82 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <string.h>
+
+#include <morph.hpp>
+#include <filterpipeline.hpp>
+#include <opencv2/opencv.hpp>
+
+int test_filterpipeline()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else	
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// erode (31x31 rect) -> dilate (9x9 ellipse) -> erode (15x15 cross), the source is pushed by bands of various heights
+	fbc::Mat_<uchar, 1> k1(31, 31), k2(9, 9), k3(15, 15);
+	fbc::getStructuringElement(k1, fbc::MORPH_RECT, fbc::Size(31, 31));
+	fbc::getStructuringElement(k2, fbc::MORPH_ELLIPSE, fbc::Size(9, 9));
+	fbc::getStructuringElement(k3, fbc::MORPH_CROSS, fbc::Size(15, 15));
+
+	cv::Mat k1_ = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(31, 31));
+	cv::Mat k2_ = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(9, 9));
+	cv::Mat k3_ = cv::getStructuringElement(cv::MORPH_CROSS, cv::Size(15, 15));
+
+	const int borders[] = { fbc::BORDER_CONSTANT, fbc::BORDER_REPLICATE, fbc::BORDER_REFLECT_101 };
+	const int bands[] = { 1, 7, 64, 512 };
+
+	for (int border : borders) {
+		cv::Mat mat1_(height, width, CV_8UC3, matSrc.data);
+		cv::Mat tmp1_, tmp2_, mat2_;
+		cv::erode(mat1_, tmp1_, k1_, cv::Point(-1, -1), 1, border);
+		cv::dilate(tmp1_, tmp2_, k2_, cv::Point(-1, -1), 1, border);
+		cv::erode(tmp2_, mat2_, k3_, cv::Point(-1, -1), 1, border);
+
+		fbc::FilterPipeline pipeline;
+		pipeline.add(fbc::createMorphologyFilter<uchar, 3>(fbc::MORPH_ERODE, k1, fbc::Point(-1, -1), border));
+		pipeline.add(fbc::createMorphologyFilter<uchar, 3>(fbc::MORPH_DILATE, k2, fbc::Point(-1, -1), border));
+		pipeline.add(fbc::createMorphologyFilter<uchar, 3>(fbc::MORPH_ERODE, k3, fbc::Point(-1, -1), border));
+
+		for (int band : bands) {
+			fbc::Mat3BGR mat1(height, width, matSrc.data);
+			fbc::Mat3BGR mat2(height, width);
+			fbc::Mat3BGR rows(band, width);
+
+			pipeline.start(fbc::Size(width, height));
+			int y = 0, dy = 0;
+			while (pipeline.remainingInputRows() > 0) {
+				int count = std::min(band, height - y);
+				pipeline.push(mat1.ptr(y), (int)mat1.step, count);
+				y += count;
+
+				while (pipeline.availableRows() > 0) {
+					int n = pipeline.pull(rows);
+					memcpy(mat2.ptr(dy), rows.ptr(), n * rows.step);
+					dy += n;
+				}
+			}
+			assert(dy == height && pipeline.remainingOutputRows() == 0);
+
+			assert(mat2.rows == mat2_.rows && mat2.cols == mat2_.cols && mat2.step == mat2_.step);
+			for (int y = 0; y < mat2.rows; y++) {
+				const fbc::uchar* p1 = mat2.ptr(y);
+				const uchar* p2 = mat2_.ptr(y);
+
+				for (int x = 0; x < mat2.step; x++) {
+					assert(p1[x] == p2[x]);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+
+#include <integral.hpp>
+#include <opencv2/opencv.hpp>
+
+int test_integral()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat matGray;
+	cv::cvtColor(matSrc, matGray, CV_BGR2GRAY);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// single-channel sums (SIMD rows)
+	fbc::Mat_<uchar, 1> mat1(height, width, matGray.data);
+	fbc::Mat_<int, 1> sum1;
+	fbc::integral(mat1, sum1);
+
+	cv::Mat sum1_;
+	cv::integral(matGray, sum1_, CV_32S);
+
+	assert(sum1.rows == sum1_.rows && sum1.cols == sum1_.cols);
+	for (int y = 0; y < sum1.rows; y++) {
+		assert(memcmp(sum1.ptr(y), sum1_.ptr(y), sum1.cols * sizeof(int)) == 0);
+	}
+
+	// sums, squared sums and tilted sums of a 3-channel image
+	fbc::Mat_<uchar, 3> mat3(height, width, matSrc.data);
+	fbc::Mat_<int, 3> sum3, tilted3;
+	fbc::Mat_<double, 3> sqsum3;
+	fbc::integral(mat3, sum3, sqsum3, tilted3);
+
+	cv::Mat sum3_, sqsum3_, tilted3_;
+	cv::integral(matSrc, sum3_, sqsum3_, tilted3_, CV_32S, CV_64F);
+
+	for (int y = 0; y < sum3.rows; y++) {
+		assert(memcmp(sum3.ptr(y), sum3_.ptr(y), sum3.cols * 3 * sizeof(int)) == 0);
+		assert(memcmp(sqsum3.ptr(y), sqsum3_.ptr(y), sqsum3.cols * 3 * sizeof(double)) == 0);
+		assert(memcmp(tilted3.ptr(y), tilted3_.ptr(y), tilted3.cols * 3 * sizeof(int)) == 0);
+	}
+
+	return 0;
+}
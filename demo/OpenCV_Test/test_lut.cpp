@@ -0,0 +1,137 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <math.h>
+#include <opencv2/opencv.hpp>
+#include <lut.hpp>
+
+template<typename _Tp, int chs>
+static bool lutEqual(const fbc::Mat_<_Tp, chs>& mat, const cv::Mat& mat_)
+{
+	if (mat.rows != mat_.rows || mat.cols != mat_.cols)
+		return false;
+
+	for (int y = 0; y < mat.rows; y++) {
+		if (memcmp(mat.ptr(y), mat_.ptr(y), mat.cols * mat.elemSize()) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+int test_LUT()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/1.jpg", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/1.jpg", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// gamma curve shared by all channels, and a different curve per channel
+	cv::Mat lut1_(1, 256, CV_8UC1), lut3_(1, 256, CV_8UC3);
+	for (int i = 0; i < 256; i++) {
+		lut1_.at<uchar>(i) = cv::saturate_cast<uchar>(pow(i / 255.0, 1 / 2.2) * 255.0);
+		for (int c = 0; c < 3; c++)
+			lut3_.at<cv::Vec3b>(i)[c] = cv::saturate_cast<uchar>(pow(i / 255.0, 0.5 + c * 0.5) * 255.0);
+	}
+
+	fbc::Mat_<uchar, 3> mat1(height, width, matSrc.data);
+	fbc::Mat_<uchar, 1> lut1(1, 256, lut1_.data);
+	fbc::Mat_<uchar, 3> lut3(1, 256, lut3_.data);
+
+	fbc::Mat_<uchar, 3> matDst1, matDst3;
+	fbc::LUT(mat1, lut1, matDst1);
+	fbc::LUT(mat1, lut3, matDst3);
+
+	cv::Mat matDst1_, matDst3_;
+	cv::LUT(matSrc, lut1_, matDst1_);
+	cv::LUT(matSrc, lut3_, matDst3_);
+
+	assert(lutEqual(matDst1, matDst1_));
+	assert(lutEqual(matDst3, matDst3_));
+
+	// float table on a submatrix
+	cv::Mat lutf_(1, 256, CV_32FC1);
+	for (int i = 0; i < 256; i++)
+		lutf_.at<float>(i) = (float)sqrt(i / 255.0);
+
+	fbc::Mat_<float, 1> lutf(1, 256, lutf_.data);
+	fbc::Rect rect(13, 7, width / 2 + 3, height / 2 + 5);
+	fbc::Mat_<uchar, 3> roi;
+	mat1.getROI(roi, rect);
+	fbc::Mat_<float, 3> matDstf;
+	fbc::LUT(roi, lutf, matDstf);
+
+	cv::Mat matDstf_;
+	cv::LUT(matSrc(cv::Rect(rect.x, rect.y, rect.width, rect.height)), lutf_, matDstf_);
+	assert(lutEqual(matDstf, matDstf_));
+
+	return 0;
+}
+
+int test_Lut3D()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/1.jpg", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/1.jpg", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// identity table: the output must reproduce the input
+	const int size = 33;
+	fbc::Mat_<float, 3> table(size * size, size);
+	for (int b = 0; b < size; b++) {
+		for (int g = 0; g < size; g++) {
+			float* p = (float*)table.ptr(b * size + g);
+			for (int r = 0; r < size; r++) {
+				p[r * 3 + 0] = r / (float)(size - 1);
+				p[r * 3 + 1] = g / (float)(size - 1);
+				p[r * 3 + 2] = b / (float)(size - 1);
+			}
+		}
+	}
+
+	fbc::Mat_<uchar, 3> mat1(height, width, matSrc.data);
+	cv::Mat matSrcf;
+	matSrc.convertTo(matSrcf, CV_32FC3, 1 / 255.0);
+	fbc::Mat_<float, 3> mat2(height, width, matSrcf.data);
+
+	for (int inter = fbc::LUT3D_TRILINEAR; inter <= fbc::LUT3D_TETRAHEDRAL; inter++) {
+		fbc::Lut3D<uchar, 3> lut3d(table, inter);
+		fbc::Mat_<uchar, 3> matDst;
+		lut3d.apply(mat1, matDst);
+
+		for (int y = 0; y < height; y++) {
+			const uchar* p = mat1.ptr(y);
+			const uchar* q = matDst.ptr(y);
+			for (int x = 0; x < width * 3; x++)
+				assert(abs(p[x] - q[x]) <= 1);
+		}
+
+		fbc::Lut3D<float, 3> lut3df(table, inter);
+		fbc::Mat_<float, 3> matDstf;
+		lut3df.apply(mat2, matDstf);
+
+		for (int y = 0; y < height; y++) {
+			const float* p = (const float*)mat2.ptr(y);
+			const float* q = (const float*)matDstf.ptr(y);
+			for (int x = 0; x < width * 3; x++)
+				assert(fabs(p[x] - q[x]) < 1e-5);
+		}
+	}
+
+	return 0;
+}
@@ -215,3 +215,58 @@ int test_morphologyEx_hitmiss()
 
 	return 0;
 }
+
+int test_morphologyEx_large_kernel()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else	
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	// van Herk/Gil-Werman filters (rect) and split structuring elements (cross, ellipse)
+	const int sizes[] = { 15, 31, 61 };
+	const int borders[] = { fbc::BORDER_CONSTANT, fbc::BORDER_REPLICATE, fbc::BORDER_REFLECT_101 };
+
+	for (int elem = 0; elem < 3; elem++) {
+		for (int size : sizes) {
+			for (int border : borders) {
+				for (int operation = 0; operation < 7; operation++) {
+					int type = elem == 0 ? fbc::MORPH_RECT : (elem == 1 ? fbc::MORPH_CROSS : fbc::MORPH_ELLIPSE);
+					int type_ = elem == 0 ? cv::MORPH_RECT : (elem == 1 ? cv::MORPH_CROSS : cv::MORPH_ELLIPSE);
+
+					fbc::Mat_<uchar, 1> element(size, size);
+					fbc::getStructuringElement(element, type, fbc::Size(size, size));
+					cv::Mat element_ = cv::getStructuringElement(type_, cv::Size(size, size));
+
+					fbc::Mat3BGR mat1(height, width, matSrc.data);
+					fbc::Mat3BGR mat2(height, width);
+					fbc::morphologyEx(mat1, mat2, operation, element, fbc::Point(-1, -1), 1, border);
+
+					cv::Mat mat1_(height, width, CV_8UC3, matSrc.data);
+					cv::Mat mat2_;
+					cv::morphologyEx(mat1_, mat2_, operation, element_, cv::Point(-1, -1), 1, border);
+
+					assert(mat2.rows == mat2_.rows && mat2.cols == mat2_.cols && mat2.step == mat2_.step);
+					for (int y = 0; y < mat2.rows; y++) {
+						const fbc::uchar* p1 = mat2.ptr(y);
+						const uchar* p2 = mat2_.ptr(y);
+
+						for (int x = 0; x < mat2.step; x++) {
+							assert(p1[x] == p2[x]);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+
+#include <pyramids.hpp>
+#include <opencv2/opencv.hpp>
+
+int test_pyrDown_uchar()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat matGray;
+	cv::cvtColor(matSrc, matGray, CV_BGR2GRAY);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	int borderTypes[] = { fbc::BORDER_REFLECT_101, fbc::BORDER_REFLECT, fbc::BORDER_REPLICATE };
+	for (int borderType : borderTypes) {
+		fbc::Mat_<uchar, 1> mat1(height, width, matGray.data);
+		fbc::Mat_<uchar, 1> dst1;
+		fbc::pyrDown(mat1, dst1, fbc::Size(), borderType);
+
+		cv::Mat dst1_;
+		cv::pyrDown(matGray, dst1_, cv::Size(), borderType);
+
+		assert(dst1.rows == dst1_.rows && dst1.cols == dst1_.cols);
+		for (int y = 0; y < dst1.rows; y++) {
+			assert(memcmp(dst1.ptr(y), dst1_.ptr(y), dst1.cols * sizeof(uchar)) == 0);
+		}
+
+		fbc::Mat_<uchar, 3> mat3(height, width, matSrc.data);
+		fbc::Mat_<uchar, 3> dst3;
+		fbc::pyrDown(mat3, dst3, fbc::Size(), borderType);
+
+		cv::Mat dst3_;
+		cv::pyrDown(matSrc, dst3_, cv::Size(), borderType);
+
+		for (int y = 0; y < dst3.rows; y++) {
+			assert(memcmp(dst3.ptr(y), dst3_.ptr(y), dst3.cols * 3 * sizeof(uchar)) == 0);
+		}
+	}
+
+	return 0;
+}
+
+int test_pyrDown_float()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+	cv::cvtColor(matSrc, matSrc, CV_BGR2GRAY);
+	matSrc.convertTo(matSrc, CV_32FC1);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	fbc::Mat_<float, 1> mat1(height, width, matSrc.data);
+	fbc::Mat_<float, 1> dst1;
+	fbc::pyrDown(mat1, dst1);
+
+	cv::Mat dst1_;
+	cv::pyrDown(matSrc, dst1_);
+
+	for (int y = 0; y < dst1.rows; y++) {
+		const float* p1 = (const float*)dst1.ptr(y);
+		const float* p2 = (const float*)dst1_.ptr(y);
+		for (int x = 0; x < dst1.cols; x++) {
+			assert(fabs(p1[x] - p2[x]) < 1e-3);
+		}
+	}
+
+	return 0;
+}
+
+int test_pyrUp_uchar()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat matGray;
+	cv::cvtColor(matSrc, matGray, CV_BGR2GRAY);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+
+	fbc::Mat_<uchar, 1> mat1(height, width, matGray.data);
+	fbc::Mat_<uchar, 1> dst1;
+	fbc::pyrUp(mat1, dst1);
+
+	cv::Mat dst1_;
+	cv::pyrUp(matGray, dst1_);
+
+	assert(dst1.rows == dst1_.rows && dst1.cols == dst1_.cols);
+	for (int y = 0; y < dst1.rows; y++) {
+		assert(memcmp(dst1.ptr(y), dst1_.ptr(y), dst1.cols * sizeof(uchar)) == 0);
+	}
+
+	fbc::Mat_<uchar, 3> mat3(height, width, matSrc.data);
+	fbc::Mat_<uchar, 3> dst3;
+	fbc::pyrUp(mat3, dst3);
+
+	cv::Mat dst3_;
+	cv::pyrUp(matSrc, dst3_);
+
+	for (int y = 0; y < dst3.rows; y++) {
+		assert(memcmp(dst3.ptr(y), dst3_.ptr(y), dst3.cols * 3 * sizeof(uchar)) == 0);
+	}
+
+	// a 1-column source: the extra column of an odd destination width is the last column of the even width
+	fbc::Mat_<uchar, 1> column(height, 1), up_even, up_odd;
+	for (int y = 0; y < height; y++)
+		column.ptr(y)[0] = matGray.ptr(y)[width / 2];
+	fbc::pyrUp(column, up_even, fbc::Size(2, height * 2));
+	fbc::pyrUp(column, up_odd, fbc::Size(3, height * 2));
+
+	for (int y = 0; y < up_odd.rows; y++) {
+		assert(memcmp(up_odd.ptr(y), up_even.ptr(y), 2) == 0 && up_odd.ptr(y)[2] == up_even.ptr(y)[1]);
+	}
+
+	return 0;
+}
+
+int test_buildPyramid()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+	const int maxlevel = 5;
+
+	fbc::Mat_<uchar, 3> mat3(height, width, matSrc.data);
+	std::vector<fbc::Mat_<uchar, 3>> dst;
+	fbc::buildPyramid(mat3, dst, maxlevel);
+
+	std::vector<cv::Mat> dst_;
+	cv::buildPyramid(matSrc, dst_, maxlevel);
+
+	// the same frame twice through the reused levels
+	fbc::Pyramid<uchar, 3> pyramid(maxlevel);
+	for (int i = 0; i < 2; i++) {
+		pyramid.build(mat3);
+
+		assert(dst.size() == dst_.size() && pyramid.levels() == (int)dst_.size());
+		for (int level = 0; level <= maxlevel; level++) {
+			const fbc::Mat_<uchar, 3>& a = dst[level];
+			const fbc::Mat_<uchar, 3>& b = pyramid[level];
+			assert(a.rows == dst_[level].rows && a.cols == dst_[level].cols);
+			assert(b.rows == a.rows && b.cols == a.cols);
+			for (int y = 0; y < a.rows; y++) {
+				assert(memcmp(a.ptr(y), dst_[level].ptr(y), a.cols * 3 * sizeof(uchar)) == 0);
+				assert(memcmp(b.ptr(y), a.ptr(y), a.cols * 3 * sizeof(uchar)) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
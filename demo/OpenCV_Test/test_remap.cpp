@@ -145,3 +145,95 @@ int test_remap_float()
 
 	return 0;
 }
+
+int test_remap_plan()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+	fbc::Mat_<fbc::uchar, 3> mat1(height, width, matSrc.data);
+
+	// a barrel distortion, strong enough to get tiles of different sizes
+	cv::Mat map_x(height, width, CV_32FC1), map_y(height, width, CV_32FC1);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			double dx = (x - width / 2.) / (width / 2.), dy = (y - height / 2.) / (height / 2.);
+			double k = 1 + 0.4 * (dx * dx + dy * dy);
+			map_x.at<float>(y, x) = (float)(width / 2. + dx * k * width / 2. * 0.8);
+			map_y.at<float>(y, x) = (float)(height / 2. + dy * k * height / 2. * 0.8);
+		}
+	}
+	fbc::Mat_<float, 1> mapX(height, width, map_x.data);
+	fbc::Mat_<float, 1> mapY(height, width, map_y.data);
+
+	// convertMaps
+	for (int nn = 0; nn < 2; nn++) {
+		fbc::Mat_<short, 2> xy;
+		fbc::Mat_<fbc::ushort, 1> a;
+		fbc::convertMaps(mapX, mapY, xy, a, nn != 0);
+
+		cv::Mat xy_, a_;
+		cv::convertMaps(map_x, map_y, xy_, a_, CV_16SC2, nn != 0);
+
+		assert(xy.step == xy_.step && (nn ? a.empty() : a.step == a_.step));
+		for (int y = 0; y < height; y++) {
+			assert(memcmp(xy.ptr(y), xy_.ptr(y), xy.step) == 0);
+			if (!nn)
+				assert(memcmp(a.ptr(y), a_.ptr(y), a.step) == 0);
+		}
+	}
+
+	// RemapPlan, a small cache to get small tiles
+	for (int interpolation = 0; interpolation < 5; interpolation++) {
+		for (int borderType = 0; borderType < 5; borderType++) {
+			for (int cacheSize : { 1 << 12, fbc::REMAP_TILE_CACHE_SIZE }) {
+				fbc::RemapPlan<fbc::uchar, 3> plan(mat1.size(), mapX, mapY, interpolation, borderType, fbc::Scalar::all(0), cacheSize);
+				fbc::Mat_<fbc::uchar, 3> mat2(height, width);
+				plan.apply(mat1, mat2);
+
+				cv::Mat mat2_ = cv::Mat(height, width, CV_8UC3);
+				cv::remap(matSrc, mat2_, map_x, map_y, interpolation, borderType, cv::Scalar::all(0));
+
+				assert(mat2.step == mat2_.step);
+				for (int y = 0; y < mat2.rows; y++) {
+					const fbc::uchar* p = mat2.ptr(y);
+					const uchar* p_ = mat2_.ptr(y);
+
+					for (int x = 0; x < mat2.step; x++) {
+						assert(p[x] == p_[x]);
+					}
+				}
+			}
+		}
+	}
+
+	// RemapPlan of INTER_NEAREST with the fixed-point maps: the rounded maps of convertMaps (no map2) and the maps
+	// with the fractional parts
+	for (int nn = 1; nn >= 0; nn--) {
+		fbc::Mat_<short, 2> xy;
+		fbc::Mat_<fbc::ushort, 1> a;
+		fbc::convertMaps(mapX, mapY, xy, a, nn != 0);
+		fbc::RemapPlan<fbc::uchar, 3> plan(mat1.size(), xy, a, fbc::INTER_NEAREST);
+		fbc::Mat_<fbc::uchar, 3> mat2(height, width);
+		plan.apply(mat1, mat2);
+
+		cv::Mat xy_, a_;
+		cv::convertMaps(map_x, map_y, xy_, a_, CV_16SC2, nn != 0);
+		cv::Mat mat2_ = cv::Mat(height, width, CV_8UC3);
+		cv::remap(matSrc, mat2_, xy_, a_, cv::INTER_NEAREST, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+
+		for (int y = 0; y < mat2.rows; y++)
+			assert(memcmp(mat2.ptr(y), mat2_.ptr(y), mat2.step) == 0);
+	}
+
+	return 0;
+}
@@ -154,3 +154,89 @@ int test_resize_area()
 
 	return 0;
 }
+
+int test_ResizePlan()
+{
+#ifdef _MSC_VER
+	cv::Mat mat = cv::imread("../../../test_images/lena.png", 1);
+#else	
+	cv::Mat mat = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!mat.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	int width = 416, height = 416;
+
+	for (int inter = 0; inter < 5; inter++) {
+		fbc::Mat3BGR mat1(mat.rows, mat.cols, mat.data);
+		fbc::ResizePlan<fbc::uchar, 3> plan(mat1.size(), fbc::Size(width, height), inter);
+
+		cv::Mat mat1_(mat.rows, mat.cols, CV_8UC3, mat.data);
+		cv::Mat mat2_(height, width, CV_8UC3);
+		cv::resize(mat1_, mat2_, cv::Size(width, height), 0, 0, inter);
+
+		// every frame of a stream reuses the tables of the plan
+		for (int frame = 0; frame < 3; frame++) {
+			fbc::Mat3BGR mat2(height, width), mat3(height, width);
+			plan.apply(mat1, mat2);
+			fbc::resize(mat1, mat3, inter);
+
+			for (int y = 0; y < height; y++) {
+				assert(memcmp(mat2.ptr(y), mat2_.ptr(y), mat2.step) == 0);
+				assert(memcmp(mat3.ptr(y), mat2_.ptr(y), mat3.step) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
+
+int test_resize_optimized()
+{
+#ifdef _MSC_VER
+	cv::Mat mat = cv::imread("../../../test_images/lena.png", 1);
+#else	
+	cv::Mat mat = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!mat.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	const fbc::Size sizes[] = { fbc::Size(416, 416), fbc::Size(mat.cols / 2, mat.rows / 2), fbc::Size(mat.cols * 2 + 3, mat.rows * 2 + 1) };
+
+	for (int inter = 0; inter < 5; inter++) {
+		for (int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			int width = sizes[i].width, height = sizes[i].height;
+
+			fbc::Mat3BGR mat1(mat.rows, mat.cols, mat.data);
+			fbc::Mat3BGR mat2(height, width), mat3(height, width);
+
+			// SSE4.1/AVX2 kernels must give the same results as the plain C++ code
+			fbc::setUseOptimized(false);
+			fbc::resize(mat1, mat2, inter);
+			fbc::setUseOptimized(true);
+			fbc::resize(mat1, mat3, inter);
+
+			for (int y = 0; y < height; y++) {
+				assert(memcmp(mat2.ptr(y), mat3.ptr(y), mat2.step) == 0);
+			}
+
+			fbc::Mat_<float, 3> matf1(mat.rows, mat.cols), matf2(height, width), matf3(height, width);
+			mat1.convertTo(matf1);
+
+			fbc::setUseOptimized(false);
+			fbc::resize(matf1, matf2, inter);
+			fbc::setUseOptimized(true);
+			fbc::resize(matf1, matf3, inter);
+
+			for (int y = 0; y < height; y++) {
+				assert(memcmp(matf2.ptr(y), matf3.ptr(y), matf2.step) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -160,3 +160,45 @@ int test_rotate_without_crop()
 
 	return 0;
 }
+
+// multiples of 90 degrees: the centers of the pixel grid give exact rotations (without warp), the other centers
+// translate by half pixels and are warped; both must be the results of cv::warpAffine
+int test_rotate_right_angle()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat roi_ = matSrc(cv::Rect(11, 17, 301, 301)), rect_ = matSrc(cv::Rect(5, 9, 320, 240));
+	fbc::Mat_<uchar, 3> mat(matSrc.rows, matSrc.cols, matSrc.data), roi, rect;
+	mat.getROI(roi, fbc::Rect(11, 17, 301, 301));
+	mat.getROI(rect, fbc::Rect(5, 9, 320, 240));
+
+	for (int angle = -90; angle <= 360; angle += 90) {
+		for (int interpolation = 0; interpolation < 5; interpolation++) {
+			for (int k = 0; k < 3; k++) {
+				const cv::Mat& src_ = k == 2 ? rect_ : roi_;
+				const fbc::Mat_<uchar, 3>& src = k == 2 ? rect : roi;
+				cv::Point2f center_ = k == 1 ? cv::Point2f(src_.cols / 2.f, src_.rows / 2.f) : cv::Point2f((src_.cols - 1) / 2.f, (src_.rows - 1) / 2.f);
+
+				fbc::Mat_<uchar, 3> rotate_dst;
+				fbc::rotate(src, rotate_dst, fbc::Point2f(center_.x, center_.y), angle, true, interpolation);
+
+				cv::Mat mat_rot_ = cv::getRotationMatrix2D(center_, angle, 1.0), rotate_dst_;
+				cv::warpAffine(src_, rotate_dst_, mat_rot_, src_.size(), interpolation);
+
+				assert(rotate_dst.rows == rotate_dst_.rows && rotate_dst.cols == rotate_dst_.cols);
+				for (int y = 0; y < rotate_dst.rows; y++)
+					assert(memcmp(rotate_dst.ptr(y), rotate_dst_.ptr(y), rotate_dst.cols * 3) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -1,15 +1,41 @@
 #include "fbc_cv_funset.hpp"
+#include <assert.h>
 #include <opencv2/opencv.hpp>
-#include <transpose.hpp>
-#include <flip.hpp>
+#include <rotate.hpp>
 
 // Blog: http://blog.csdn.net/fengbingchun/article/details/52554711
 
+// the reference rotations of OpenCV: transpose + flip
+static void rotate90_cv(const cv::Mat& src, cv::Mat& dst, int rotateCode)
+{
+	if (rotateCode == fbc::ROTATE_180) {
+		cv::flip(src, dst, -1);
+	} else {
+		cv::Mat tmp;
+		cv::transpose(src, tmp);
+		cv::flip(tmp, dst, rotateCode == fbc::ROTATE_90_CLOCKWISE ? 1 : 0);
+	}
+}
+
+template<typename _Tp, int chs>
+static bool rotate90Equal(const fbc::Mat_<_Tp, chs>& mat, const cv::Mat& mat_)
+{
+	if (mat.rows != mat_.rows || mat.cols != mat_.cols)
+		return false;
+
+	for (int y = 0; y < mat.rows; y++) {
+		if (memcmp(mat.ptr(y), mat_.ptr(y), mat.cols * mat.elemSize()) != 0)
+			return false;
+	}
+
+	return true;
+}
+
 int test_rotate90()
 {
 #ifdef _MSC_VER
 	cv::Mat matSrc = cv::imread("../../../test_images/1.jpg", 1);
-#else	
+#else
 	cv::Mat matSrc = cv::imread("test_images/1.jpg", 1);
 #endif
 	if (!matSrc.data) {
@@ -21,37 +47,45 @@ int test_rotate90()
 	int height = matSrc.rows;
 
 	fbc::Mat_<uchar, 3> mat1(height, width, matSrc.data);
-	fbc::Mat_<uchar, 3> matTranspose(width, height);
-	fbc::transpose(mat1, matTranspose);
+	const char* names[3] = { "rotate_90", "rotate_180", "rotate_270" };
 
-	// clockwise rotation  90
-	fbc::Mat_<uchar, 3> matRotate90(width, height);
-	fbc::flip(matTranspose, matRotate90, 1);
-	cv::Mat tmp2(width, height, CV_8UC3, matRotate90.data);
-#ifdef _MSC_VER
-	cv::imwrite("../../../test_images/rotate_90.jpg", tmp2);
-#else	
-	cv::imwrite("test_images/rotate_90.jpg", tmp2);
-#endif
+	for (int rotateCode = fbc::ROTATE_90_CLOCKWISE; rotateCode <= fbc::ROTATE_90_COUNTERCLOCKWISE; rotateCode++) {
+		fbc::Mat_<uchar, 3> matRotate;
+		fbc::rotate(mat1, matRotate, rotateCode);
 
-	// clockwise rotation 180
-	fbc::Mat_<uchar, 3> matRotate180(height, width);
-	fbc::flip(mat1, matRotate180, -1);
-	cv::Mat tmp3(height, width, CV_8UC3, matRotate180.data);
-#ifdef _MSC_VER
-	cv::imwrite("../../../test_images/rotate_180.jpg", tmp3);
-#else
-	cv::imwrite("test_images/rotate_180.jpg", tmp3);
-#endif
-	// clockwise rotation 270
-	fbc::Mat_<uchar, 3> matRotate270(width, height);
-	fbc::flip(matTranspose, matRotate270, 0);
-	cv::Mat tmp4(matTranspose.rows, matTranspose.cols, CV_8UC3, matRotate270.data);
+		cv::Mat matRotate_;
+		rotate90_cv(matSrc, matRotate_, rotateCode);
+		assert(rotate90Equal(matRotate, matRotate_));
+
+		cv::Mat tmp(matRotate.rows, matRotate.cols, CV_8UC3, matRotate.data);
 #ifdef _MSC_VER
-	cv::imwrite("../../../test_images/rotate_270.jpg", tmp4);
+		cv::imwrite(std::string("../../../test_images/") + names[rotateCode] + ".jpg", tmp);
 #else
-	cv::imwrite("test_images/rotate_270.jpg", tmp4);
+		cv::imwrite(std::string("test_images/") + names[rotateCode] + ".jpg", tmp);
 #endif
+	}
+
+	// float, submatrix source and in-place rotation
+	cv::Mat matGray;
+	cv::cvtColor(matSrc, matGray, cv::COLOR_BGR2GRAY);
+	matGray.convertTo(matGray, CV_32FC1);
+	fbc::Mat_<float, 1> mat2(height, width, matGray.data), roi;
+	fbc::Rect rect(13, 7, width / 2 + 3, height / 2 + 5);
+	mat2.getROI(roi, rect);
+	cv::Mat roi_ = matGray(cv::Rect(rect.x, rect.y, rect.width, rect.height));
+
+	for (int rotateCode = fbc::ROTATE_90_CLOCKWISE; rotateCode <= fbc::ROTATE_90_COUNTERCLOCKWISE; rotateCode++) {
+		fbc::Mat_<float, 1> matRotate;
+		fbc::rotate(roi, matRotate, rotateCode);
+		fbc::Mat_<float, 1> matInplace(roi.rows, roi.cols);
+		roi.copyTo(matInplace);
+		fbc::rotate(matInplace, matInplace, rotateCode);
+
+		cv::Mat matRotate_;
+		rotate90_cv(roi_, matRotate_, rotateCode);
+		assert(rotate90Equal(matRotate, matRotate_));
+		assert(rotate90Equal(matInplace, matRotate_));
+	}
+
 	return 0;
 }
-
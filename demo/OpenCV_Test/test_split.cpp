@@ -2,6 +2,7 @@
 #include <vector>
 #include <core/mat.hpp>
 #include <split.hpp>
+#include <merge.hpp>
 
 #include <opencv2/opencv.hpp>
 
@@ -113,3 +114,69 @@ int test_split_float()
 
 	return 0;
 }
+
+int test_split_planes()
+{
+#ifdef _MSC_VER
+	cv::Mat mat = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat mat = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!mat.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	// a roi of odd width, its rows are not continuous
+	cv::Rect rect(7, 5, 301, 203);
+	cv::Mat roi_ = mat(rect), roif_;
+	roi_.convertTo(roif_, CV_32FC3, 1. / 255);
+
+	fbc::Mat_<fbc::uchar, 3> mat1(mat.rows, mat.cols, mat.data), roi;
+	mat1.getROI(roi, fbc::Rect(rect.x, rect.y, rect.width, rect.height));
+	fbc::Mat_<float, 3> roif(rect.height, rect.width);
+	for (int y = 0; y < rect.height; y++)
+		memcpy(roif.ptr(y), roif_.ptr(y), rect.width * 3 * sizeof(float));
+
+	std::vector<cv::Mat> planes_, planesf_;
+	cv::split(roi_, planes_);
+	cv::split(roif_, planesf_);
+
+	// HWC -> CHW blob
+	int area = rect.width * rect.height;
+	std::vector<fbc::uchar> blob(area * 3);
+	fbc::uchar* planes[3] = { &blob[0], &blob[area], &blob[area * 2] };
+	fbc::split(roi, planes, rect.width);
+	std::vector<float> blobf(area * 3);
+	float* planesf[3] = { &blobf[0], &blobf[area], &blobf[area * 2] };
+	fbc::split(roif, planesf, rect.width * sizeof(float));
+
+	fbc::Mat_<fbc::uchar, 1> mat2[3];
+	fbc::split(roi, mat2);
+
+	for (int i = 0; i < 3; i++) {
+		for (int y = 0; y < rect.height; y++) {
+			assert(memcmp(planes[i] + y * rect.width, planes_[i].ptr(y), rect.width) == 0);
+			assert(memcmp(planesf[i] + y * rect.width, planesf_[i].ptr(y), rect.width * sizeof(float)) == 0);
+			assert(memcmp(mat2[i].ptr(y), planes_[i].ptr(y), rect.width) == 0);
+		}
+	}
+
+	// CHW blob -> HWC
+	fbc::Mat_<fbc::uchar, 3> mat3(rect.height, rect.width);
+	fbc::merge(planes, rect.width, mat3);
+	fbc::Mat_<float, 3> mat3f(rect.height, rect.width);
+	fbc::merge(planesf, rect.width * sizeof(float), mat3f);
+	fbc::Mat_<fbc::uchar, 3> mat4;
+	fbc::merge(mat2, mat4);
+
+	cv::Mat mat3_;
+	cv::merge(planes_, mat3_);
+	for (int y = 0; y < rect.height; y++) {
+		assert(memcmp(mat3.ptr(y), mat3_.ptr(y), rect.width * 3) == 0);
+		assert(memcmp(mat4.ptr(y), mat3_.ptr(y), rect.width * 3) == 0);
+		assert(memcmp(mat3f.ptr(y), roif_.ptr(y), rect.width * 3 * sizeof(float)) == 0);
+	}
+
+	return 0;
+}
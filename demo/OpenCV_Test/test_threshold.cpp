@@ -94,3 +94,92 @@ int test_threshold_float()
 
 	return 0;
 }
+
+int test_threshold_otsu()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+	cv::cvtColor(matSrc, matSrc, cv::COLOR_BGR2GRAY);
+	// several row stripes of histograms, an odd width
+	cv::resize(matSrc, matSrc, cv::Size(1531, 1277));
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+	int flags[2] = { fbc::THRESH_OTSU, fbc::THRESH_TRIANGLE };
+
+	for (int i = 0; i < 2; i++) {
+		for (int type = 0; type <= 4; type++) {
+			fbc::Mat_<uchar, 1> mat1(height, width, matSrc.data);
+			fbc::Mat_<uchar, 1> mat2(height, width);
+			double thresh = fbc::threshold(mat1, mat2, 0, 200, type | flags[i]);
+
+			cv::Mat mat2_;
+			double thresh_ = cv::threshold(matSrc, mat2_, 0, 200, type | flags[i]);
+
+			assert(thresh == thresh_);
+			for (int y = 0; y < mat2.rows; y++) {
+				assert(memcmp(mat2.ptr(y), mat2_.ptr(y), width) == 0);
+			}
+		}
+	}
+
+	return 0;
+}
+
+int test_localThreshold()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+	cv::cvtColor(matSrc, matSrc, cv::COLOR_BGR2GRAY);
+
+	int width = matSrc.cols;
+	int height = matSrc.rows;
+	fbc::Mat_<uchar, 1> mat1(height, width, matSrc.data);
+
+	// a single tile: the global threshold
+	fbc::Mat_<uchar, 1> mat2(height, width);
+	double thresh = fbc::localThreshold(mat1, mat2, fbc::Size(width, height), 255, fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	cv::Mat mat2_;
+	double thresh_ = cv::threshold(matSrc, mat2_, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+	assert(thresh == thresh_);
+	for (int y = 0; y < height; y++) {
+		assert(memcmp(mat2.ptr(y), mat2_.ptr(y), width) == 0);
+	}
+
+	// at the center of a tile (odd size) the threshold is the one of the tile
+	const int tile = 63;
+	fbc::localThreshold(mat1, mat2, fbc::Size(tile, tile), 255, fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	for (int y = 0; y + tile <= height; y += tile) {
+		for (int x = 0; x + tile <= width; x += tile) {
+			cv::Mat tmp;
+			int t = (int)cv::threshold(matSrc(cv::Rect(x, y, tile, tile)), tmp, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+			int cx = x + tile / 2, cy = y + tile / 2;
+			uchar v = matSrc.at<uchar>(cy, cx);
+			assert(mat2.ptr(cy)[cx] == (v > t ? 255 : 0));
+		}
+	}
+
+	// in-place
+	fbc::Mat_<uchar, 1> mat3(height, width);
+	mat1.copyTo(mat3);
+	fbc::localThreshold(mat3, mat3, fbc::Size(tile, tile), 255, fbc::THRESH_BINARY | fbc::THRESH_OTSU);
+	for (int y = 0; y < height; y++) {
+		assert(memcmp(mat2.ptr(y), mat3.ptr(y), width) == 0);
+	}
+
+	return 0;
+}
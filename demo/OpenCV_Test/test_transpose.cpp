@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <transpose.hpp>
 
@@ -161,5 +162,14 @@ int test_transpose_float()
 		}
 	}
 
+	// batch
+	std::vector<fbc::Mat_<float, 1>> batch(5, mat2), batch_t;
+	fbc::transpose(batch, batch_t);
+	assert(batch_t.size() == batch.size());
+	for (size_t i = 0; i < batch_t.size(); i++) {
+		for (int y = 0; y < mat3.rows; y++)
+			assert(memcmp(batch_t[i].ptr(y), mat3_.ptr(y), mat3.step) == 0);
+	}
+
 	return 0;
 }
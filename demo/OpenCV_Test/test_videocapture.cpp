@@ -0,0 +1,118 @@
+#include "fbc_cv_funset.hpp"
+#include <assert.h>
+#include <string.h>
+#include <thread>
+#include <chrono>
+
+#include <videocapture.hpp>
+
+// V4L2 capture through the stand-in device, no camera needed
+int test_videocapture_v4l2()
+{
+#ifdef __linux__
+	const int width = 64, height = 48;
+
+	fbc::VideoCapture capture("synthetic:64x48:YUYV@0");
+	if (!capture.isOpened()) {
+		fprintf(stderr, "fail to open capture\n");
+		return -1;
+	}
+
+	assert(capture.get(fbc::CV_CAP_PROP_FRAME_WIDTH) == width && capture.get(fbc::CV_CAP_PROP_FRAME_HEIGHT) == height);
+	assert(capture.get(fbc::CV_CAP_PROP_FOURCC) == fbc::CV_FOURCC('Y', 'U', 'Y', 'V'));
+
+	std::vector<int> codecids;
+	assert(capture.getCodecList(codecids) && codecids.size() == 1 && codecids[0] == fbc::VIDEO_CODEC_TYPE_RAWVIDEO);
+	std::vector<std::string> sizelist;
+	assert(capture.getVideoSizeList(fbc::VIDEO_CODEC_TYPE_RAWVIDEO, sizelist) && sizelist.size() == 1 && sizelist[0] == "64x48");
+
+	fbc::Mat_<unsigned char, 3> image(height, width);
+	for (int n = 0; n < 10; n++) {
+		assert(capture.grab());
+
+		// the frame in the mapped buffer: byte x of row y of frame n is x + 2 * y + 7 * n
+		fbc::Mat_<unsigned char, 1> view;
+		int fourcc = 0;
+		assert(capture.retrieveView(view, &fourcc));
+		assert(fourcc == fbc::CV_FOURCC('Y', 'U', 'Y', 'V') && view.rows == height && view.cols == width * 2);
+		for (int y = 0; y < view.rows; y++) {
+			const unsigned char* p = view.ptr(y);
+			for (int x = 0; x < view.cols; x++) {
+				assert(p[x] == (unsigned char)(x + 2 * y + 7 * n));
+			}
+		}
+
+		assert(capture.retrieve(image));
+	}
+
+	// BGR24 frames are handed out without a copy
+	assert(capture.set(fbc::CV_CAP_PROP_FOURCC, fbc::CV_FOURCC('B', 'G', 'R', '3')));
+	assert(capture.grab());
+	fbc::Mat_<unsigned char, 3> view;
+	assert(capture.retrieveView(view) && view.rows == height && view.cols == width);
+	assert(capture.retrieve(image) && memcmp(image.data, view.data, width * height * 3) == 0);
+
+	return 0;
+#else
+	fprintf(stderr, "Error: only support linux platform\n");
+	return -1;
+#endif
+}
+
+int test_videocapture_async()
+{
+#ifdef __linux__
+	fbc::VideoCapture capture("synthetic:64x48:BGR3@0");
+	if (!capture.isOpened()) {
+		fprintf(stderr, "fail to open capture\n");
+		return -1;
+	}
+
+	// no drop: every frame in order, the content of frame n is x + 2 * y + 7 * n
+	assert(capture.startAsync(3, fbc::CAP_ASYNC_NO_DROP) && capture.isAsync());
+	assert(!capture.grab());
+	fbc::Mat_<unsigned char, 3> image;
+	fbc::frame_info info;
+	for (int n = 0; n < 20; n++) {
+		assert(capture.read(image, info, 1000));
+		assert(info.sequence == (fbc::uint64)n && image.rows == 48 && image.cols == 64);
+		for (int y = 0; y < image.rows; y++) {
+			const unsigned char* p = image.ptr(y);
+			for (int x = 0; x < image.cols * 3; x++) {
+				assert(p[x] == (unsigned char)(x + 2 * y + 7 * n));
+			}
+		}
+	}
+	fbc::capture_stats stats = capture.getAsyncStats();
+	assert(stats.delivered == 20 && stats.dropped == 0 && stats.grabbed >= 20);
+
+	// the ring follows a change of the resolution
+	assert(capture.set(fbc::CV_CAP_PROP_FRAME_WIDTH, 32));
+	for (int n = 0; n < 5; n++)
+		assert(capture.read(image, info, 1000));
+	assert(image.rows == 48 && image.cols == 32);
+	capture.stopAsync();
+
+	// latest: the frames grabbed while the reader is busy are dropped, the newest one is returned
+	assert(capture.startAsync(3, fbc::CAP_ASYNC_LATEST));
+	fbc::uint64 last = 0;
+	for (int n = 0; n < 5; n++) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		assert(capture.read(image, info, 1000));
+		assert(n == 0 || info.sequence > last);
+		last = info.sequence;
+	}
+	stats = capture.getAsyncStats();
+	assert(stats.delivered == 5 && stats.dropped > 0);
+	capture.stopAsync();
+
+	// synchronous again, retrieve follows the resolution
+	assert(capture.set(fbc::CV_CAP_PROP_FRAME_HEIGHT, 24));
+	assert(capture.read(image) && image.rows == 24 && image.cols == 32);
+
+	return 0;
+#else
+	fprintf(stderr, "Error: only support linux platform\n");
+	return -1;
+#endif
+}
@@ -215,3 +215,71 @@ int test_warpAffine_float()
 
 	return 0;
 }
+
+template<typename _Tp, int chs>
+static bool warpEqual(const fbc::Mat_<_Tp, chs>& mat, const cv::Mat& mat_)
+{
+	if (mat.rows != mat_.rows || mat.cols != mat_.cols)
+		return false;
+
+	for (int y = 0; y < mat.rows; y++) {
+		if (memcmp(mat.ptr(y), mat_.ptr(y), mat.cols * mat.elemSize()) != 0)
+			return false;
+	}
+
+	return true;
+}
+
+// the aligned crops of face alignment: small destinations of a submatrix, all interpolations and borders
+template<typename _Tp, int chs>
+static void warpAffineCrops(const cv::Mat& matSrc)
+{
+	cv::Mat roi_ = matSrc(cv::Rect(37, 21, 161, 147));
+	fbc::Mat_<_Tp, chs> mat(matSrc.rows, matSrc.cols, matSrc.data), roi;
+	mat.getROI(roi, fbc::Rect(37, 21, 161, 147));
+
+	const int borders[] = { fbc::BORDER_CONSTANT, fbc::BORDER_REPLICATE, fbc::BORDER_REFLECT_101, fbc::BORDER_TRANSPARENT };
+	for (int i = 0; i < 8; i++) {
+		cv::Mat warp_mat_ = cv::getRotationMatrix2D(cv::Point2f(80 + i * 3, 70 - i * 2), -35 + i * 11, 0.6 + i * 0.1);
+		fbc::Mat_<double, 1> warp_mat(2, 3, warp_mat_.data);
+		cv::Size dsize(112 - i, 96 + i * 3);
+
+		for (int interpolation = 0; interpolation < 5; interpolation++) {
+			for (int border : borders) {
+				fbc::Mat_<_Tp, chs> warp_dst(dsize.height, dsize.width, fbc::Scalar::all(11));
+				fbc::warpAffine(roi, warp_dst, warp_mat, interpolation, border, fbc::Scalar(0, 128, 255, 64));
+
+				cv::Mat warp_dst_(dsize, roi_.type(), cv::Scalar::all(11));
+				cv::warpAffine(roi_, warp_dst_, warp_mat_, dsize, interpolation, border, cv::Scalar(0, 128, 255, 64));
+				assert(warpEqual(warp_dst, warp_dst_));
+			}
+		}
+	}
+}
+
+int test_warpAffine_crops()
+{
+#ifdef _MSC_VER
+	cv::Mat matSrc = cv::imread("../../../test_images/lena.png", 1);
+#else
+	cv::Mat matSrc = cv::imread("test_images/lena.png", 1);
+#endif
+	if (!matSrc.data) {
+		std::cout << "read image fail" << std::endl;
+		return -1;
+	}
+
+	cv::Mat matGray, matBGRA, matFloat, matFloat3;
+	cv::cvtColor(matSrc, matGray, cv::COLOR_BGR2GRAY);
+	cv::cvtColor(matSrc, matBGRA, cv::COLOR_BGR2BGRA);
+	matGray.convertTo(matFloat, CV_32FC1);
+	matSrc.convertTo(matFloat3, CV_32FC3, 1.0 / 255);
+
+	warpAffineCrops<uchar, 1>(matGray);
+	warpAffineCrops<uchar, 3>(matSrc);
+	warpAffineCrops<uchar, 4>(matBGRA);
+	warpAffineCrops<float, 1>(matFloat);
+	warpAffineCrops<float, 3>(matFloat3);
+
+	return 0;
+}
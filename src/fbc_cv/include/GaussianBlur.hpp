@@ -0,0 +1,70 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_GAUSSIANBLUR_HPP_
+#define FBC_CV_GAUSSIANBLUR_HPP_
+
+/* reference: include/opencv2/imgproc.hpp
+              modules/imgproc/src/smooth.cpp
+*/
+
+#include <typeinfo>
+#include "core/mat.hpp"
+#include "imgproc.hpp"
+#include "sepFilter2D.hpp"
+
+namespace fbc {
+
+// Blurs an image using a Gaussian filter
+// The function convolves the source image with the specified Gaussian kernel, ksize.width and ksize.height
+// must be positive and odd, or zero and then they are computed from sigma; sigmaY = 0: sigmaY = sigmaX,
+// both zero: they are computed from ksize (see getGaussianKernel)
+// support type: uchar/float, multi-channels
+template<typename _Tp, int chs>
+int GaussianBlur(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size ksize, double sigmaX, double sigmaY = 0, int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	if (borderType != BORDER_CONSTANT && (borderType & BORDER_ISOLATED) != 0) {
+		if (src.rows == 1)
+			ksize.height = 1;
+		if (src.cols == 1)
+			ksize.width = 1;
+	}
+
+	if (ksize.width == 1 && ksize.height == 1) {
+		if (src.data != dst.data)
+			src.copyTo(dst);
+		return 0;
+	}
+
+	// automatic detection of kernel size from sigma
+	if (sigmaY <= 0)
+		sigmaY = sigmaX;
+	if (ksize.width <= 0 && sigmaX > 0)
+		ksize.width = fbcRound(sigmaX*(sizeof(_Tp) == 1 ? 3 : 4) * 2 + 1) | 1;
+	if (ksize.height <= 0 && sigmaY > 0)
+		ksize.height = fbcRound(sigmaY*(sizeof(_Tp) == 1 ? 3 : 4) * 2 + 1) | 1;
+	FBC_Assert(ksize.width > 0 && ksize.width % 2 == 1 && ksize.height > 0 && ksize.height % 2 == 1);
+
+	sigmaX = std::max(sigmaX, 0.);
+	sigmaY = std::max(sigmaY, 0.);
+
+	Mat_<float, 1> kx, ky;
+	getGaussianKernel(kx, ksize.width, sigmaX);
+	if (ksize.height == ksize.width && std::abs(sigmaX - sigmaY) < DBL_EPSILON)
+		ky = kx;
+	else
+		getGaussianKernel(ky, ksize.height, sigmaY);
+
+	return sepFilter2D(src, dst, kx, ky, Point(-1, -1), 0, borderType);
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_GAUSSIANBLUR_HPP_
@@ -0,0 +1,217 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_BLOBFROMYUV_HPP_
+#define FBC_CV_BLOBFROMYUV_HPP_
+
+/* reference: imgproc/src/color.cpp (YUV420sp2RGB888Invoker, YUV420p2RGB888Invoker)
+              dnn/src/dnn.cpp (blobFromImage)
+*/
+
+#include "core/mat.hpp"
+#include "core/types.hpp"
+#include "imgproc.hpp"
+#include "cvtColor.hpp"
+#include "resize.hpp"
+
+namespace fbc {
+
+// converts a YUV 4:2:0 frame to a resized, normalized, planar float blob (CHW) in one pass:
+// cvtColor(code) + resize(interpolation) + (value - mean) / stddev + split into planes, without the
+// intermediate images. the source rows are converted as the resize needs them and the resized rows
+// are written to the planes of blob directly, the result is the same as the one of the separate steps
+// code: CV_YUV2BGR_NV12/NV21/I420/YV12 or CV_YUV2RGB_NV12/NV21/I420/YV12, the planes of blob follow the
+//       channel order of the code
+// y, ystep: the luma plane, size.width x size.height
+// u, v, uvstep: NV12/NV21: u is the interleaved chroma plane, v is not used; I420/YV12: the chroma planes,
+//       u and v are always the U and V planes whatever the order of the planes in the frame is
+// blob: 3 planes of dsize.width x dsize.height floats
+// interpolation: INTER_LINEAR/INTER_AREA
+int blobFromYUV(const uchar* y, int ystep, const uchar* u, const uchar* v, int uvstep, Size size, int code,
+	float* blob, Size dsize, int interpolation = INTER_LINEAR, const Scalar& mean = Scalar(), const Scalar& stddev = Scalar(1, 1, 1));
+
+// src: a continuous frame of width x (height * 3 / 2) as the one of cvtColor
+int blobFromYUV(const Mat_<uchar, 1>& src, int code, float* blob, Size dsize, int interpolation = INTER_LINEAR,
+	const Scalar& mean = Scalar(), const Scalar& stddev = Scalar(1, 1, 1));
+
+// rows of a NV12/NV21 frame converted to BGR/RGB, the arithmetic of YUV420sp2RGB888Invoker
+template<int bIdx, int uIdx>
+struct YUV420spRowSource {
+	enum { GENERATED = 1 };
+
+	YUV420spRowSource(const uchar* y_, int ystep_, const uchar* uv_, int uvstep_, int width_)
+		: my(y_), muv(uv_), ystep(ystep_), uvstep(uvstep_), width(width_) {}
+
+	size_t step() const { return alignSize(width * 3, 16); }
+
+	const uchar* operator()(int sy, int count, uchar* buf) const
+	{
+		for (int j = 0; j < count; j++) {
+			const uchar* y1 = my + (size_t)(sy + j) * ystep;
+			const uchar* uv1 = muv + (size_t)((sy + j) / 2) * uvstep;
+			uchar* row = buf + j * step();
+
+			for (int i = 0; i < width; i += 2, row += 6) {
+				int u = int(uv1[i + 0 + uIdx]) - 128;
+				int v = int(uv1[i + 1 - uIdx]) - 128;
+
+				int ruv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVR * v;
+				int guv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVG * v + ITUR_BT_601_CUG * u;
+				int buv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CUB * u;
+
+				int y00 = std::max(0, int(y1[i]) - 16) * ITUR_BT_601_CY;
+				row[2 - bIdx] = saturate_cast<uchar>((y00 + ruv) >> ITUR_BT_601_SHIFT);
+				row[1] = saturate_cast<uchar>((y00 + guv) >> ITUR_BT_601_SHIFT);
+				row[bIdx] = saturate_cast<uchar>((y00 + buv) >> ITUR_BT_601_SHIFT);
+
+				int y01 = std::max(0, int(y1[i + 1]) - 16) * ITUR_BT_601_CY;
+				row[5 - bIdx] = saturate_cast<uchar>((y01 + ruv) >> ITUR_BT_601_SHIFT);
+				row[4] = saturate_cast<uchar>((y01 + guv) >> ITUR_BT_601_SHIFT);
+				row[3 + bIdx] = saturate_cast<uchar>((y01 + buv) >> ITUR_BT_601_SHIFT);
+			}
+		}
+
+		return buf;
+	}
+
+	const uchar *my, *muv;
+	int ystep, uvstep, width;
+};
+
+// rows of a I420/YV12 frame converted to BGR/RGB, the arithmetic of YUV420p2RGB888Invoker
+template<int bIdx>
+struct YUV420pRowSource {
+	enum { GENERATED = 1 };
+
+	YUV420pRowSource(const uchar* y_, int ystep_, const uchar* u_, const uchar* v_, int uvstep_, int width_)
+		: my(y_), mu(u_), mv(v_), ystep(ystep_), uvstep(uvstep_), width(width_) {}
+
+	size_t step() const { return alignSize(width * 3, 16); }
+
+	const uchar* operator()(int sy, int count, uchar* buf) const
+	{
+		for (int j = 0; j < count; j++) {
+			const uchar* y1 = my + (size_t)(sy + j) * ystep;
+			const uchar* u1 = mu + (size_t)((sy + j) / 2) * uvstep;
+			const uchar* v1 = mv + (size_t)((sy + j) / 2) * uvstep;
+			uchar* row = buf + j * step();
+
+			for (int i = 0; i < width / 2; i++, row += 6) {
+				int u = int(u1[i]) - 128;
+				int v = int(v1[i]) - 128;
+
+				int ruv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVR * v;
+				int guv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVG * v + ITUR_BT_601_CUG * u;
+				int buv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CUB * u;
+
+				int y00 = std::max(0, int(y1[2 * i]) - 16) * ITUR_BT_601_CY;
+				row[2 - bIdx] = saturate_cast<uchar>((y00 + ruv) >> ITUR_BT_601_SHIFT);
+				row[1] = saturate_cast<uchar>((y00 + guv) >> ITUR_BT_601_SHIFT);
+				row[bIdx] = saturate_cast<uchar>((y00 + buv) >> ITUR_BT_601_SHIFT);
+
+				int y01 = std::max(0, int(y1[2 * i + 1]) - 16) * ITUR_BT_601_CY;
+				row[5 - bIdx] = saturate_cast<uchar>((y01 + ruv) >> ITUR_BT_601_SHIFT);
+				row[4] = saturate_cast<uchar>((y01 + guv) >> ITUR_BT_601_SHIFT);
+				row[3 + bIdx] = saturate_cast<uchar>((y01 + buv) >> ITUR_BT_601_SHIFT);
+			}
+		}
+
+		return buf;
+	}
+
+	const uchar *my, *mu, *mv;
+	int ystep, uvstep, width;
+};
+
+// resized rows normalized through a table per channel and written to the planes of the blob
+struct BlobRowSink {
+	enum { GENERATED = 1 };
+
+	BlobRowSink(float* blob_, Size dsize_, const Scalar& mean, const Scalar& stddev) : blob(blob_), dsize(dsize_)
+	{
+		// the resized values are 8 bits, (value - mean) / stddev is computed once for each of them
+		for (int c = 0; c < 3; c++) {
+			for (int i = 0; i < 256; i++) {
+				tab[c][i] = (float)((i - mean.val[c]) / stddev.val[c]);
+			}
+		}
+	}
+
+	uchar* operator()(int, uchar* buf) const { return buf; }
+
+	void commit(int dy, const uchar* row) const
+	{
+		size_t plane = (size_t)dsize.width * dsize.height;
+		float* D0 = blob + (size_t)dy * dsize.width;
+		float* D1 = D0 + plane;
+		float* D2 = D1 + plane;
+
+		for (int x = 0; x < dsize.width; x++, row += 3) {
+			D0[x] = tab[0][row[0]];
+			D1[x] = tab[1][row[1]];
+			D2[x] = tab[2][row[2]];
+		}
+	}
+
+	float* blob;
+	Size dsize;
+	float tab[3][256];
+};
+
+inline int blobFromYUV(const uchar* y, int ystep, const uchar* u, const uchar* v, int uvstep, Size size, int code,
+	float* blob, Size dsize, int interpolation, const Scalar& mean, const Scalar& stddev)
+{
+	FBC_Assert(y && u && blob);
+	FBC_Assert(size.width % 2 == 0 && size.height % 2 == 0);
+	FBC_Assert(interpolation == INTER_LINEAR || interpolation == INTER_AREA);
+	FBC_Assert(stddev.val[0] != 0 && stddev.val[1] != 0 && stddev.val[2] != 0);
+
+	std::shared_ptr<const ResizePlan<uchar, 3>> plan = ResizePlanCache<uchar, 3>::getInstance().get(size, dsize, interpolation);
+	BlobRowSink sink(blob, dsize, mean, stddev);
+
+	switch (code) {
+		case CV_YUV2BGR_NV12: return plan->apply(YUV420spRowSource<0, 0>(y, ystep, u, uvstep, size.width), sink);
+		case CV_YUV2RGB_NV12: return plan->apply(YUV420spRowSource<2, 0>(y, ystep, u, uvstep, size.width), sink);
+		case CV_YUV2BGR_NV21: return plan->apply(YUV420spRowSource<0, 1>(y, ystep, u, uvstep, size.width), sink);
+		case CV_YUV2RGB_NV21: return plan->apply(YUV420spRowSource<2, 1>(y, ystep, u, uvstep, size.width), sink);
+		case CV_YUV2BGR_I420: case CV_YUV2BGR_YV12: {
+			FBC_Assert(v);
+			return plan->apply(YUV420pRowSource<0>(y, ystep, u, v, uvstep, size.width), sink);
+		}
+		case CV_YUV2RGB_I420: case CV_YUV2RGB_YV12: {
+			FBC_Assert(v);
+			return plan->apply(YUV420pRowSource<2>(y, ystep, u, v, uvstep, size.width), sink);
+		}
+		default:
+			FBC_Error("Unknown/unsupported color conversion code");
+	}
+
+	return -1;
+}
+
+inline int blobFromYUV(const Mat_<uchar, 1>& src, int code, float* blob, Size dsize, int interpolation, const Scalar& mean, const Scalar& stddev)
+{
+	FBC_Assert(src.cols % 2 == 0 && src.rows % 3 == 0);
+
+	Size size(src.cols, src.rows * 2 / 3);
+	const uchar* y = src.data;
+	const uchar* chroma = src.data + (size_t)src.step * size.height;
+	int stride = (int)src.step;
+
+	switch (code) {
+		case CV_YUV2BGR_NV12: case CV_YUV2RGB_NV12: case CV_YUV2BGR_NV21: case CV_YUV2RGB_NV21:
+			return blobFromYUV(y, stride, chroma, NULL, stride, size, code, blob, dsize, interpolation, mean, stddev);
+		case CV_YUV2BGR_I420: case CV_YUV2RGB_I420:
+			return blobFromYUV(y, stride, chroma, chroma + size.area() / 4, stride / 2, size, code, blob, dsize, interpolation, mean, stddev);
+		case CV_YUV2BGR_YV12: case CV_YUV2RGB_YV12:
+			return blobFromYUV(y, stride, chroma + size.area() / 4, chroma, stride / 2, size, code, blob, dsize, interpolation, mean, stddev);
+		default:
+			FBC_Error("Unknown/unsupported color conversion code");
+	}
+
+	return -1;
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_BLOBFROMYUV_HPP_
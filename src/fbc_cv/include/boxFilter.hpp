@@ -0,0 +1,223 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_BOXFILTER_HPP_
+#define FBC_CV_BOXFILTER_HPP_
+
+/* reference: include/opencv2/imgproc.hpp
+              modules/imgproc/src/smooth.cpp
+*/
+
+#include <string.h>
+#include <cmath>
+#include <typeinfo>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/Ptr.hpp"
+#include "core/saturate.hpp"
+#include "core/hal.hpp"
+#include "imgproc.hpp"
+#include "filterengine.hpp"
+
+namespace fbc {
+
+// the horizontal sums of ksize elements, a running sum: one addition and one subtraction per element
+template<typename T, typename ST> struct RowSum : public BaseRowFilter
+{
+	RowSum(int _ksize, int _anchor)
+	{
+		ksize = _ksize;
+		anchor = _anchor;
+	}
+
+	void operator()(const uchar* src, uchar* dst, int width, int cn)
+	{
+		const T* S = (const T*)src;
+		ST* D = (ST*)dst;
+		int i = 0, k, ksz_cn = ksize*cn;
+
+		width = (width - 1)*cn;
+		for (k = 0; k < cn; k++, S++, D++) {
+			ST s = 0;
+			for (i = 0; i < ksz_cn; i += cn)
+				s += S[i];
+			D[0] = s;
+			for (i = 0; i < width; i += cn) {
+				s += S[i + ksz_cn] - S[i];
+				D[i + cn] = s;
+			}
+		}
+	}
+};
+
+// a scaled column sum; for uchar the product is computed in float and rounded half to even, as the optimized
+// column sums do, so the tail of a row rounds the ties like the rest of it
+template<typename T, typename ST>
+static inline T columnSumScale(ST s, double scale) { return saturate_cast<T>(s*scale); }
+template<>
+inline uchar columnSumScale<uchar, int>(int s, double scale) { return saturate_cast<uchar>((int)std::nearbyint((float)s * (float)scale)); }
+
+// the optimized running column sums, returns the number of processed elements
+template<typename ST, typename T>
+static inline int columnSumVec(const ST*, const ST*, ST*, T*, int, double) { return 0; }
+static inline int columnSumVec(const int* Sp, const int* Sm, int* sum, uchar* dst, int width, double scale)
+{
+	return hal::boxFilterColumn32s8u(Sp, Sm, sum, dst, width, scale);
+}
+
+// the vertical sums of ksize rows of the horizontal sums, scaled: the sums of the last ksize - 1 rows are kept
+// between the calls, so every output row costs one addition and one subtraction per element
+template<typename ST, typename T> struct ColumnSum : public BaseColumnFilter
+{
+	ColumnSum(int _ksize, int _anchor, double _scale)
+	{
+		ksize = _ksize;
+		anchor = _anchor;
+		scale = _scale;
+		sumCount = 0;
+	}
+
+	void reset() { sumCount = 0; }
+
+	void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
+	{
+		int i;
+		ST* SUM;
+		bool haveScale = scale != 1;
+		double _scale = scale;
+
+		if (width != (int)sum.size()) {
+			sum.resize(width);
+			sumCount = 0;
+		}
+
+		SUM = &sum[0];
+		if (sumCount == 0) {
+			memset((void*)SUM, 0, width*sizeof(ST));
+
+			for (; sumCount < ksize - 1; sumCount++, src++) {
+				const ST* Sp = (const ST*)src[0];
+				for (i = 0; i <= width - 2; i += 2) {
+					ST s0 = SUM[i] + Sp[i], s1 = SUM[i + 1] + Sp[i + 1];
+					SUM[i] = s0; SUM[i + 1] = s1;
+				}
+
+				for (; i < width; i++)
+					SUM[i] += Sp[i];
+			}
+		} else {
+			FBC_Assert(sumCount == ksize - 1);
+			src += ksize - 1;
+		}
+
+		for (; count--; src++) {
+			const ST* Sp = (const ST*)src[0];
+			const ST* Sm = (const ST*)src[1 - ksize];
+			T* D = (T*)dst;
+
+			i = columnSumVec(Sp, Sm, SUM, D, width, _scale);
+			if (haveScale) {
+				for (; i <= width - 2; i += 2) {
+					ST s0 = SUM[i] + Sp[i], s1 = SUM[i + 1] + Sp[i + 1];
+					D[i] = columnSumScale<T>(s0, _scale);
+					D[i + 1] = columnSumScale<T>(s1, _scale);
+					s0 -= Sm[i]; s1 -= Sm[i + 1];
+					SUM[i] = s0; SUM[i + 1] = s1;
+				}
+
+				for (; i < width; i++) {
+					ST s0 = SUM[i] + Sp[i];
+					D[i] = columnSumScale<T>(s0, _scale);
+					SUM[i] = s0 - Sm[i];
+				}
+			} else {
+				for (; i <= width - 2; i += 2) {
+					ST s0 = SUM[i] + Sp[i], s1 = SUM[i + 1] + Sp[i + 1];
+					D[i] = saturate_cast<T>(s0);
+					D[i + 1] = saturate_cast<T>(s1);
+					s0 -= Sm[i]; s1 -= Sm[i + 1];
+					SUM[i] = s0; SUM[i + 1] = s1;
+				}
+
+				for (; i < width; i++) {
+					ST s0 = SUM[i] + Sp[i];
+					D[i] = saturate_cast<T>(s0);
+					SUM[i] = s0 - Sm[i];
+				}
+			}
+
+			dst += dststep;
+		}
+	}
+
+	double scale;
+	int sumCount;
+	std::vector<ST> sum;
+};
+
+// creates the engine of the box filter, the sums _Tp3 are int for uchar (double when a normalized kernel has
+// more than 1 << 23 elements), double for float
+template<typename _Tp1, typename _Tp2, typename _Tp3, int chs>
+Ptr<FilterEngine<_Tp1, _Tp2, _Tp3, chs, chs, chs>> createBoxFilter(Size ksize, Point anchor = Point(-1, -1),
+	bool normalize = true, int borderType = BORDER_DEFAULT)
+{
+	anchor = normalizeAnchor(anchor, ksize);
+	Ptr<BaseRowFilter> rowFilter = makePtr<RowSum<_Tp1, _Tp3> >(ksize.width, anchor.x);
+	Ptr<BaseColumnFilter> columnFilter = makePtr<ColumnSum<_Tp3, _Tp2> >(ksize.height, anchor.y,
+		normalize ? 1. / (ksize.width*ksize.height) : 1);
+
+	return makePtr<FilterEngine<_Tp1, _Tp2, _Tp3, chs, chs, chs>>(Ptr<BaseFilter>(), rowFilter, columnFilter, borderType, borderType);
+}
+
+// Blurs an image using the box filter
+// The function smooths an image using the kernel:
+// \f[\texttt{K} =  \alpha \begin{bmatrix} 1 & 1 & 1 &  \cdots & 1 & 1  \\ 1 & 1 & 1 &  \cdots & 1 & 1  \\ \hdotsfor{6} \\ 1 & 1 & 1 &  \cdots & 1 & 1 \end{bmatrix}\f]
+// where alpha = 1 / (ksize.width * ksize.height) when normalize = true, 1 otherwise.
+// The cost per pixel does not depend on the kernel size, the image is processed in parallel horizontal stripes
+// support type: uchar/float, multi-channels
+template<typename _Tp, int chs>
+int boxFilter(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size ksize, Point anchor = Point(-1, -1),
+	bool normalize = true, int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(ksize.width > 0 && ksize.height > 0);
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	if (borderType != BORDER_CONSTANT && normalize && (borderType & BORDER_ISOLATED) != 0) {
+		if (src.rows == 1)
+			ksize.height = 1;
+		if (src.cols == 1)
+			ksize.width = 1;
+	}
+
+	bool isolated = (borderType & BORDER_ISOLATED) != 0;
+	borderType &= ~BORDER_ISOLATED;
+
+	if (sizeof(_Tp) == 1 && (!normalize || ksize.width*ksize.height <= (1 << 23))) {
+		applyFilterStripes(src, dst, ksize.height, isolated, [&]() {
+			return createBoxFilter<_Tp, _Tp, int, chs>(ksize, anchor, normalize, borderType); });
+	} else {
+		applyFilterStripes(src, dst, ksize.height, isolated, [&]() {
+			return createBoxFilter<_Tp, _Tp, double, chs>(ksize, anchor, normalize, borderType); });
+	}
+
+	return 0;
+}
+
+// Blurs an image using the normalized box filter
+// The call blur(src, dst, ksize, anchor, borderType) is equivalent to
+// boxFilter(src, dst, ksize, anchor, true, borderType)
+// support type: uchar/float, multi-channels
+template<typename _Tp, int chs>
+int blur(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size ksize, Point anchor = Point(-1, -1), int borderType = BORDER_DEFAULT)
+{
+	return boxFilter(src, dst, ksize, anchor, true, borderType);
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_BOXFILTER_HPP_
@@ -0,0 +1,84 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_CAP_V4L2_HPP_
+#define FBC_CV_CAP_V4L2_HPP_
+
+// reference: 2.4.13.6
+//            highgui/src/cap_v4l.cpp
+
+#ifdef __linux__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "capture.hpp"
+#include "iplimage.hpp"
+
+namespace fbc {
+
+class V4L2Device;
+
+// Capturing video from a Video4Linux2 device: the frames are dequeued from a ring of MMAP buffers when epoll reports
+// the device readable. The dequeued buffer stays with the user until the next grab, so retrieveFrameView (and
+// retrieveFrame for BGR24 devices) hands out the mapped memory of the driver without a copy
+class CvCaptureCAM_V4L2 : public CvCapture {
+public:
+	CvCaptureCAM_V4L2();
+	virtual ~CvCaptureCAM_V4L2();
+
+	// index: N of /dev/videoN
+	virtual bool open(int index);
+	// name: a device path or a stand-in device, see cvCreateCameraCapture_V4L2
+	virtual bool open(const std::string& name);
+	virtual void close();
+	virtual double getProperty(int);
+	virtual bool setProperty(int, double);
+	virtual bool grabFrame();
+	virtual IplImage* retrieveFrame(int);
+	virtual bool retrieveFrameView(frame_view& view);
+	virtual int getCaptureDomain() { return CV_CAP_V4L2; } // Return the type of the capture object: CV_CAP_VFW, etc...
+
+	// device_id: N of /dev/videoN, -1 for the opened device
+	virtual bool getDevicesList(std::map<int, device_info>& devicelist) const;
+	virtual bool getCodecList(int device_id, std::vector<int>& codecids) const;
+	virtual bool getVideoSizeList(int device_id, int codec_id, std::vector<std::string>& sizelist) const;
+
+protected:
+	struct buffer {
+		void* start;
+		size_t length;
+		int dmabuf_fd;
+	};
+
+	bool openDevice(V4L2Device* dev, int index);
+	bool startCapture();
+	void stopCapture();
+	bool queueBuffer(int idx);
+
+	V4L2Device* device;
+	int index;
+	int epfd;
+	int width, height, fourcc, fps, bufferCount; // requested, 0: the current setting of the device
+	int bytesperline, sizeimage;
+	std::vector<buffer> buffers;
+	int current; // the dequeued buffer, -1 if none
+	int bytesused, sequence;
+	IplImage* frame; // the frame converted to BGR
+	IplImage view; // the header of the BGR24 frames on the mapped buffer
+};
+
+// creates the capture of /dev/videoN
+CvCapture* cvCreateCameraCapture_V4L2(int index);
+// creates the capture of a device path or of a stand-in device which emulates the V4L2 interface (MMAP ring, epoll)
+// without a camera:
+//     "synthetic:WxH[:FOURCC][@fps]": a moving test pattern,
+//     "file:path:WxH[:FOURCC][@fps]": the raw frames of a file in a loop;
+// FOURCC: YUYV (default), UYVY, BGR3, RGB3, GREY, NV12; fps: 30 by default, 0 delivers the frames without pacing
+CvCapture* cvCreateCameraCapture_V4L2(const std::string& name);
+
+} // namespace fbc
+
+#endif // __linux__
+#endif // FBC_CV_CAP_V4L2_HPP_
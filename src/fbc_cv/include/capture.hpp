@@ -235,12 +235,25 @@ typedef struct device_info {
 	int product_id;
 } device_info;
 
+// a captured frame in the native format of the device, as stored in the buffer of the driver: valid until the next grab
+typedef struct frame_view {
+	unsigned char* data;
+	int width;
+	int height;
+	int step;        // bytes per row of the first plane
+	int bytesused;   // bytes of the frame, the planes of the planar formats follow the first one
+	int fourcc;      // CV_FOURCC of the pixel format
+	int sequence;    // frame counter of the driver, gaps are the dropped frames
+	int dmabuf_fd;   // the buffer exported as a DMABUF, -1 when not supported
+} frame_view;
+
 struct CvCapture {
 	virtual ~CvCapture() {}
 	virtual double getProperty(int) { return 0; }
 	virtual bool setProperty(int, double) { return 0; }
 	virtual bool grabFrame() { return true; }
 	virtual IplImage* retrieveFrame(int) { return 0; }
+	virtual bool retrieveFrameView(frame_view&) { return false; }
 	virtual int getCaptureDomain() { return CV_CAP_ANY; } // Return the type of the capture object: CV_CAP_VFW, etc...
 	virtual bool getDevicesList(std::map<int, device_info>& devicelist) const { return false; };
 	virtual bool getCodecList(int device_id, std::vector<int>& codecids) const { return false; }
@@ -373,6 +373,18 @@ Ptr<T> makePtr(const A1& a1, const A2& a2, const A3& a3)
 	return Ptr<T>(new T(a1, a2, a3));
 }
 
+template<typename T, typename A1, typename A2, typename A3, typename A4>
+Ptr<T> makePtr(const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+{
+	return Ptr<T>(new T(a1, a2, a3, a4));
+}
+
+template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5>
+Ptr<T> makePtr(const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5)
+{
+	return Ptr<T>(new T(a1, a2, a3, a4, a5));
+}
+
 template<typename T, typename A1, typename A2, typename A3, typename A4, typename A5, typename A6>
 Ptr<T> makePtr(const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6)
 {
@@ -286,6 +286,12 @@ enum DftFlags {
 	DCT_ROWS = DFT_ROWS
 };
 
+enum RotateFlags {
+	ROTATE_90_CLOCKWISE = 0, //!< Rotate 90 degrees clockwise
+	ROTATE_180 = 1, //!< Rotate 180 degrees clockwise
+	ROTATE_90_COUNTERCLOCKWISE = 2 //!< Rotate 270 degrees clockwise
+};
+
 } //fbc
 
 #endif //FBC_CV_CORE_BASE_HPP_
@@ -18,6 +18,14 @@
 	#define FBC_DECL_ALIGNED(x) __attribute__((aligned(x)))
 #endif
 
+// atomically adds delta to *addr and returns the previous value
+#ifdef _MSC_VER
+	#include <intrin.h>
+	#define FBC_XADD(addr, delta) (int)_InterlockedExchangeAdd((long volatile*)(addr), (delta))
+#else
+	#define FBC_XADD(addr, delta) (int)__atomic_fetch_add((int*)(addr), (delta), __ATOMIC_ACQ_REL)
+#endif
+
 namespace fbc {
 
 #define FBC_CN_MAX		512
@@ -44,6 +52,26 @@ namespace fbc {
 #define  FBC_IMIN(a, b)  ((a) ^ (((a)^(b)) & (((a) < (b)) - 1)))
 #define  FBC_IMAX(a, b)  ((a) ^ (((a)^(b)) & (((a) > (b)) - 1)))
 
+// CPU features, see checkHardwareSupport()
+#define FBC_CPU_NONE		0
+#define FBC_CPU_MMX		1
+#define FBC_CPU_SSE		2
+#define FBC_CPU_SSE2		3
+#define FBC_CPU_SSE3		4
+#define FBC_CPU_SSSE3		5
+#define FBC_CPU_SSE4_1		6
+#define FBC_CPU_SSE4_2		7
+#define FBC_CPU_POPCNT		8
+#define FBC_CPU_AVX		10
+#define FBC_CPU_AVX2		11
+#define FBC_CPU_FMA3		12
+#define FBC_HARDWARE_MAX_FEATURE	255
+
+// the runtime dispatched x86 kernels (SSE4.1/AVX2) are built for these targets
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define FBC_CPU_X86 1
+#endif
+
 // fundamental constants
 #define FBC_PI 3.1415926535897932384626433832795
 
@@ -18,9 +18,45 @@ namespace fbc {
 #define  FBC_MALLOC_ALIGN    16
 
 // Allocates an aligned memory buffer
+// buffers of FBC_POOL_MIN_SIZE bytes and more are taken from a size-class buffer pool when the pool is enabled
 FBC_EXPORTS void* fastMalloc(size_t size);
-// Deallocates a memory buffer
+// Deallocates a memory buffer, pooled buffers are kept for reuse up to the pool limit
 FBC_EXPORTS void fastFree(void* ptr);
+
+// Allocates a temporary buffer (used by AutoBuffer)
+// small and medium buffers are served from a per-thread cache without any locking,
+// they can be freed by any thread
+FBC_EXPORTS void* scratchMalloc(size_t size);
+// Deallocates a temporary buffer allocated by scratchMalloc
+FBC_EXPORTS void scratchFree(void* ptr);
+
+/* the smallest buffer size handled by the buffer pool, smaller buffers always use malloc/free */
+#define  FBC_POOL_MIN_SIZE   1024
+
+// Memory counters of fastMalloc/scratchMalloc
+struct MemoryStats {
+	size_t bytesLive; // bytes allocated and not yet freed
+	size_t peakBytesLive; // maximum of bytesLive since the last resetMemoryStats()
+	size_t bytesCached; // bytes of the free buffers kept by the pool (the per-thread caches included)
+	uint64 poolHits; // allocations served by the pool
+	uint64 poolMisses; // allocations of a pooled size which had to call malloc
+	uint64 scratchHits; // scratch allocations served by the per-thread cache
+};
+
+// Returns the current memory counters
+FBC_EXPORTS MemoryStats getMemoryStats();
+// Resets peakBytesLive to bytesLive and the hit/miss counters to 0
+FBC_EXPORTS void resetMemoryStats();
+// Enables/disables the buffer pool, it is enabled by default unless the environment variable FBC_BUFFER_POOL is set to 0
+FBC_EXPORTS void setBufferPoolEnabled(bool enabled);
+FBC_EXPORTS bool isBufferPoolEnabled();
+// Sets the maximal number of bytes kept by the pool, 256MB by default (environment variable FBC_BUFFER_POOL_LIMIT, in MB)
+FBC_EXPORTS void setBufferPoolLimit(size_t bytes);
+FBC_EXPORTS size_t getBufferPoolLimit();
+// Frees all the buffers cached by the pool and by the cache of the calling thread,
+// the caches of the other threads are given back to the pool when these threads exit
+FBC_EXPORTS void releaseBufferPool();
+
 void* cvAlloc(size_t size);
 void cvFree_(void* ptr);
 #define cvFree(ptr) (cvFree_(*(ptr)), *(ptr)=0)
@@ -152,6 +152,91 @@ FBC_EXPORTS void sqrt(const double* src, double* dst, int len);
 FBC_EXPORTS void invSqrt(const float* src, float* dst, int len);
 FBC_EXPORTS void invSqrt(const double* src, double* dst, int len);
 
+// resize kernels, dispatched at runtime to the AVX2/SSE4.1 code (see checkHardwareSupport)
+// they process the beginning of the rows and return the number of processed elements (0 without optimized code),
+// the caller finishes the rows with the plain C++ code; the results are bit-exact with the plain C++ code
+FBC_EXPORTS int resizeHLinear8u(const uchar** src, int** dst, int count, const int* xofs, const short* alpha, int swidth, int cn, int xmax);
+FBC_EXPORTS int resizeHLinear32f(const float** src, float** dst, int count, const int* xofs, const float* alpha, int swidth, int cn, int xmax);
+FBC_EXPORTS int resizeVLinear8u(const int** src, uchar* dst, const short* beta, int width);
+FBC_EXPORTS int resizeVLinear32f(const float** src, float* dst, const float* beta, int width);
+FBC_EXPORTS int resizeVCubic8u(const int** src, uchar* dst, const short* beta, int width);
+FBC_EXPORTS int resizeVCubic32f(const float** src, float* dst, const float* beta, int width);
+FBC_EXPORTS int resizeVLanczos4_8u(const int** src, uchar* dst, const short* beta, int width);
+FBC_EXPORTS int resizeVLanczos4_32f(const float** src, float* dst, const float* beta, int width);
+// 2x2 INTER_AREA decimation of the rows src and src_next, cn: 1, 3 or 4
+FBC_EXPORTS int resizeAreaFast2x2_8u(const uchar* src, const uchar* src_next, uchar* dst, int width, int cn);
+
+// split/merge kernels of 2, 3 and 4 channels, dispatched at runtime to the SSE4.1 code, used by split8u/merge8u
+// and split32s/merge32s; they return the number of processed elements of every plane (0 without optimized code)
+FBC_EXPORTS int splitVec8u(const uchar* src, uchar** dst, int len, int cn);
+FBC_EXPORTS int mergeVec8u(const uchar** src, uchar* dst, int len, int cn);
+FBC_EXPORTS int splitVec32s(const int* src, int** dst, int len, int cn);
+FBC_EXPORTS int mergeVec32s(const int** src, int* dst, int len, int cn);
+
+// cache-blocked transpose of the height x width array src of esz-byte elements into the width x height array dst,
+// the steps may be negative (reversed row order, see rotate); src and dst must not overlap
+FBC_EXPORTS void transpose2D(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz);
+// in-place transpose of the n x n array data: swaps the elements (i, j) and (j, i) of the rows row0 <= i < row1, j >= i,
+// the row ranges of concurrent calls must not overlap
+FBC_EXPORTS void transposeInplace(uchar* data, size_t step, int n, int esz, int row0, int row1);
+// reverses the order of the elements of every row, the steps may be negative; src and dst must not overlap
+FBC_EXPORTS void flipRows(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz);
+
+// bilinear interpolation of a run of remapBilinear whose 2x2 neighbourhoods are inside the source (sstep in elements,
+// swidth columns), wtab is the table of initInterTab2D(INTER_LINEAR); 1, 3 and 4 channels, they return the number of
+// processed pixels (0 without optimized code)
+FBC_EXPORTS int remapBilinear8u(const uchar* S0, size_t sstep, int swidth, uchar* D, const short* XY, const ushort* FXY, const short* wtab, int cn, int width);
+FBC_EXPORTS int remapBilinear32f(const float* S0, size_t sstep, int swidth, float* D, const short* XY, const ushort* FXY, const float* wtab, int cn, int width);
+// the source coordinates of bw destination pixels of a warpAffine row: integer parts in xy, interpolation table
+// indices in alpha (nearest neighbour: rounded coordinates only); they return the number of processed pixels
+FBC_EXPORTS int warpAffineBlockline(const int* adelta, const int* bdelta, short* xy, short* alpha, int X0, int Y0, int bw);
+FBC_EXPORTS int warpAffineBlocklineNN(const int* adelta, const int* bdelta, short* xy, int X0, int Y0, int bw);
+
+// threshold of a row of width elements with one threshold (see threshold()) or with the threshold thresh[x] of
+// every element (see localThreshold()), type is a THRESH_* type without THRESH_OTSU/THRESH_TRIANGLE;
+// they return the number of processed elements (0 without optimized code)
+FBC_EXPORTS int threshold8u(const uchar* src, uchar* dst, int width, uchar thresh, uchar maxval, int type);
+FBC_EXPORTS int thresholdMap8u(const uchar* src, const uchar* thresh, uchar* dst, int width, uchar maxval, int type);
+FBC_EXPORTS int threshold32f(const float* src, float* dst, int width, float thresh, float maxval, int type);
+
+// 8-bit BGR/RGB of scn (3 or 4) channels to YCrCb/YUV and back (dcn 3 or 4 channels), coeffs are the fixed-point
+// coefficients C0..C4 of RGB2YCrCb_i (C0..C2 in the order of the source channels) or C0..C3 of YCrCb2RGB_i;
+// they return the number of converted pixels (0 without optimized code)
+FBC_EXPORTS int cvtBGRtoYCrCb8u(const uchar* src, uchar* dst, int n, int scn, int bidx, const int* coeffs);
+FBC_EXPORTS int cvtYCrCbtoBGR8u(const uchar* src, uchar* dst, int n, int dcn, int bidx, const int* coeffs);
+// 8-bit BGR/RGB of scn (3 or 4) channels to gray, coeffs are the fixed-point coefficients in the order of the channels
+FBC_EXPORTS int cvtBGRtoGray8u(const uchar* src, uchar* dst, int n, int scn, const int* coeffs);
+
+// look-up table of n 8-bit elements of cn channels (see LUT()), lut32 holds the 256 entries of the table, or 256 * cn
+// entries of the tables of the channels, widened to 32 bits; returns the number of processed elements
+FBC_EXPORTS int LUT8u(const uchar* src, uchar* dst, int n, const int* lut32, int cn);
+// tetrahedral and trilinear interpolation of the 3D table of Lut3D for n 8-bit pixels of cn (3 or 4) channels: tab holds
+// 4 fixed-point values per lattice point of the size^3 points, pos the lattice position of every 8-bit value;
+// they return the number of processed pixels (0 without optimized code)
+FBC_EXPORTS int lut3DTetrahedral8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size);
+FBC_EXPORTS int lut3DTrilinear8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size);
+
+// separable linear filters of 8-bit images with the fixed-point kernels: the row pass of width elements of cn channels
+// with the integer kernel kx of ksize taps (symmetry: 1 symmetrical, -1 asymmetrical around the center, 0 general),
+// the column pass of the int rows src[-ksize2] .. src[ksize2] with the float coefficients ky[0] .. ky[ksize2] of
+// the center and the lower half of the symmetrical (or asymmetrical) kernel;
+// they return the number of processed elements (0 without optimized code)
+FBC_EXPORTS int sepFilterRow8u32s(const uchar* src, int* dst, int width, int cn, const int* kx, int ksize, int symmetry);
+FBC_EXPORTS int sepFilterColumn32s8u(const int** src, uchar* dst, int width, const float* ky, int ksize2, float delta, bool symmetrical);
+// the running column sums of the box filter of 8-bit images: dst = (sum + Sp) * scale, sum += Sp - Sm
+FBC_EXPORTS int boxFilterColumn32s8u(const int* Sp, const int* Sm, int* sum, uchar* dst, int width, double scale);
+// a row of the integral of a single-channel 8-bit image from the start of the row: sum = prev + the prefix sums of src
+FBC_EXPORTS int integralRow8u32s(const uchar* src, const int* prev, int* sum, int width);
+
+// pyrDown and pyrUp of 8-bit images: the horizontal pass of n results of a single-channel row ([1 4 6 4 1] on
+// src[x * 2 - 2] .. src[x * 2 + 2] of pyrDown; the interleaved src[x - 1] + src[x] * 6 + src[x + 1] and
+// (src[x] + src[x + 1]) * 4 of pyrUp), the vertical pass of the int rows src[0] .. src[4] (pyrDown) or
+// src[0] .. src[2] to the two destination rows (pyrUp); they return the number of processed results
+FBC_EXPORTS int pyrDownRow8u32s(const uchar* src, int* row, int n);
+FBC_EXPORTS int pyrDownColumn32s8u(const int** src, uchar* dst, int width);
+FBC_EXPORTS int pyrUpRow8u32s(const uchar* src, int* row, int n);
+FBC_EXPORTS int pyrUpColumn32s8u(const int** src, uchar* dst0, uchar* dst1, int width);
+
 } // namespace hal
 } // namespace fbc
 
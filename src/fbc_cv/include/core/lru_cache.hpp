@@ -0,0 +1,66 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_CORE_LRU_CACHE_HPP_
+#define FBC_CV_CORE_LRU_CACHE_HPP_
+
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace fbc {
+
+// thread-safe LRU cache of immutable objects, such as the plans of resize() and dft(), at most capacity of them
+template<typename _Tp, int capacity>
+class LRUCache {
+public:
+	// the cached object for which match(object) is true, else the one returned by make(), which is inserted;
+	// make() runs without holding the lock, two threads may build the same object, the first one inserted is kept
+	template<typename Match, typename Make>
+	std::shared_ptr<const _Tp> get(Match match, Make make)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (find(match))
+				return values.front();
+		}
+
+		std::shared_ptr<const _Tp> value = make();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (find(match))
+			return values.front();
+		values.push_front(value);
+		if ((int)values.size() > capacity)
+			values.pop_back();
+
+		return value;
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		values.clear();
+	}
+
+private:
+	// moves the matching object to the front, most recently used first; called with the lock held
+	template<typename Match>
+	bool find(Match& match)
+	{
+		for (auto it = values.begin(); it != values.end(); ++it) {
+			if (match(**it)) {
+				values.splice(values.begin(), values, it);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::mutex mutex;
+	std::list<std::shared_ptr<const _Tp>> values;
+};
+
+} // fbc
+
+#endif // FBC_CV_CORE_LRU_CACHE_HPP_
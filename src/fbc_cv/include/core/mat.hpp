@@ -18,6 +18,7 @@
 #include <typeinfo>
 #include <string.h>
 #include <float.h>
+#include <vector>
 #include "fbcdef.hpp"
 #include "types.hpp"
 #include "base.hpp"
@@ -28,22 +29,49 @@
 
 namespace fbc {
 
+// Custom array allocator
+// allocate() must return a buffer aligned to at least sizeof(void*) or NULL,
+// deallocate() gets the pointer and the size passed to the allocate() call
+class FBC_EXPORTS MatAllocator {
+public:
+	MatAllocator() {}
+	virtual ~MatAllocator();
+
+	virtual void* allocate(size_t size) = 0;
+	virtual void deallocate(void* ptr, size_t size) = 0;
+};
+
+// Returns the allocator based on fastMalloc/fastFree
+FBC_EXPORTS MatAllocator* getStdAllocator();
+// Returns the allocator used by Mat_::create() when Mat_::allocator is NULL
+FBC_EXPORTS MatAllocator* getDefaultAllocator();
+// Sets the default allocator, NULL restores the std allocator; the allocator must outlive all the matrices it allocated
+FBC_EXPORTS void setDefaultAllocator(MatAllocator* allocator);
+
 // The class Mat_ represents an n-dimensional dense numerical single-channel or multi-channel array
 template<typename _Tp, int chs> class Mat_ {
 public:
 	typedef _Tp value_type;
 
 	// default constructor
-	Mat_() : rows(0), cols(0), channels(0), data(NULL), step(0), allocated(false), datastart(NULL), dataend(NULL) {}
+	Mat_() : rows(0), cols(0), channels(0), data(NULL), step(0), allocated(false), refcount(NULL), allocator(NULL), datastart(NULL), dataend(NULL) {}
 	// constructs 2D matrix of the specified size
 	Mat_(int _rows, int _cols);
 	// constucts 2D matrix and fills it with the specified value _s
 	Mat_(int _rows, int _cols, const Scalar& _s);
 	// constructor for matrix headers pointing to user-allocated data, no data is copied
 	Mat_(int _rows, int _cols, void* _data);
-	// copy constructor, NOTE: deep copy
+	// copy constructor, NOTE: shallow copy, the data is shared and the reference counter is incremented, use clone() for a deep copy
 	Mat_(const Mat_<_Tp, chs>& _m);
 	Mat_& operator = (const Mat_& _m);
+	// move constructor and move assignment, the data is taken over, _m becomes empty
+	Mat_(Mat_<_Tp, chs>&& _m) noexcept;
+	Mat_& operator = (Mat_&& _m) noexcept;
+
+	// allocates new matrix data unless the matrix already has the specified size
+	void create(int _rows, int _cols);
+	// creates a full copy of the matrix and the underlying data
+	Mat_<_Tp, chs> clone() const;
 
 	// reports whether the matrix is continuous or not
 	bool isContinuous() const;
@@ -87,7 +115,7 @@ public:
 	// returns the total number of array elements
 	size_t total() const;
 
-	// release memory
+	// decrements the reference counter and releases the data when it reaches 0
 	inline void release();
 	// destructor - calls release()
 	~Mat_() { release(); };
@@ -101,8 +129,13 @@ public:
 	uchar* data;
 	// bytes per row
 	int step; // stride
-	// memory allocation flag
+	// memory allocation flag, true when the data is owned (shared with a reference counter)
 	bool allocated;
+	// pointer to the reference counter, it's NULL when the data points to user-allocated data
+	int* refcount;
+	// allocator used by create(), NULL: the default allocator (getDefaultAllocator())
+	// the data is always released by the allocator which allocated it
+	MatAllocator* allocator;
 	// helper fields used in locateROI and adjustROI
 	const uchar* datastart;
 	const uchar* dataend;
@@ -115,54 +148,61 @@ typedef Mat_<uchar, 4> Mat4BGRA;
 template<typename _Tp, int chs> inline
 void Mat_<_Tp, chs>::release()
 {
-	if (this->data && this->allocated) {
-		fastFree(this->data);
+	if (this->refcount && FBC_XADD(this->refcount, -1) == 1) {
+		// the allocator of the data is stored after the reference counter, see create()
+		MatAllocator* a = *(MatAllocator**)((uchar*)this->refcount + sizeof(void*));
+		a->deallocate((void*)this->datastart, (uchar*)this->refcount - this->datastart + 2 * sizeof(void*));
 	}
 
 	this->data = NULL;
 	this->datastart = NULL;
 	this->dataend = NULL;
 	this->allocated = false;
+	this->refcount = NULL;
 	this->rows = this->cols = this->step = this->channels = 0;
 }
 
 template<typename _Tp, int chs>
-Mat_<_Tp, chs>::Mat_(int _rows, int _cols)
+void Mat_<_Tp, chs>::create(int _rows, int _cols)
 {
 	FBC_Assert(_rows > 0 && _cols > 0 && chs > 0);
 
+	if (this->data && this->rows == _rows && this->cols == _cols)
+		return;
+
+	release();
+
 	this->rows = _rows;
 	this->cols = _cols;
 	this->channels = chs;
 	this->step = sizeof(_Tp) * _cols * chs;
-	this->allocated = true;
 
-	size_t size_ = this->rows * this->step;
-	uchar* p = (uchar*)fastMalloc(size_);
+	// the reference counter and the allocator are stored right after the matrix data, as OpenCV 2.x does
+	MatAllocator* a = this->allocator ? this->allocator : getDefaultAllocator();
+	size_t size_ = (size_t)this->rows * this->step;
+	size_t total_ = alignSize(size_, (int)sizeof(void*));
+	uchar* p = (uchar*)a->allocate(total_ + 2 * sizeof(void*));
 	FBC_Assert(p != NULL);
+	*(MatAllocator**)(p + total_ + sizeof(void*)) = a;
 
 	this->data = p;
 	this->datastart = this->data;
 	this->dataend = this->data + size_;
+	this->refcount = (int*)(p + total_);
+	*this->refcount = 1;
+	this->allocated = true;
 }
 
 template<typename _Tp, int chs>
-Mat_<_Tp, chs>::Mat_(int _rows, int _cols, const Scalar& _s)
+Mat_<_Tp, chs>::Mat_(int _rows, int _cols) : rows(0), cols(0), channels(0), data(NULL), step(0), allocated(false), refcount(NULL), allocator(NULL), datastart(NULL), dataend(NULL)
 {
-	FBC_Assert(_rows > 0 && _cols > 0 && chs > 0);
-
-	this->rows = _rows;
-	this->cols = _cols;
-	this->channels = chs;
-	this->step = sizeof(_Tp) * _cols * chs;
-	this->allocated = true;
+	create(_rows, _cols);
+}
 
-	size_t size_ = this->rows * this->step;
-	uchar* p = (uchar*)fastMalloc(size_);
-	FBC_Assert(p != NULL);
-	this->data = p;
-	this->datastart = this->data;
-	this->dataend = this->data + size_;
+template<typename _Tp, int chs>
+Mat_<_Tp, chs>::Mat_(int _rows, int _cols, const Scalar& _s) : rows(0), cols(0), channels(0), data(NULL), step(0), allocated(false), refcount(NULL), allocator(NULL), datastart(NULL), dataend(NULL)
+{
+	create(_rows, _cols);
 
 	for (int i = 0; i < _rows; i++) {
 		_Tp* pRow = (_Tp*)this->data + i * _cols * chs;
@@ -187,6 +227,8 @@ Mat_<_Tp, chs>::Mat_(int _rows, int _cols, void* _data)
 	this->channels = chs;
 	this->step = sizeof(_Tp) * _cols * chs;
 	this->allocated = false;
+	this->refcount = NULL;
+	this->allocator = NULL;
 	this->data = (uchar*)_data;
 	this->datastart = this->data;
 	this->dataend = this->data + this->step * this->rows;
@@ -194,63 +236,83 @@ Mat_<_Tp, chs>::Mat_(int _rows, int _cols, void* _data)
 
 template<typename _Tp, int chs>
 Mat_<_Tp, chs>::Mat_(const Mat_<_Tp, chs>& _m)
+	: rows(_m.rows), cols(_m.cols), channels(_m.channels), data(_m.data), step(_m.step), allocated(_m.allocated),
+	refcount(_m.refcount), allocator(_m.allocator), datastart(_m.datastart), dataend(_m.dataend)
 {
-	this->rows = _m.rows;
-	this->cols = _m.cols;
-	this->channels = _m.channels;
-	this->step = sizeof(_Tp) * this->cols * this->channels;
-
-	size_t size_ = this->rows * this->step;
-	if (size_ > 0) {
-		this->allocated = true;
-		uchar* p = (uchar*)fastMalloc(size_);
-		FBC_Assert(p != NULL);
-
-		memcpy(p, _m.data, size_);
-		this->data = p;
-	} else {
-		this->allocated = false;
-		this->data = NULL;
-	}
-
-	this->datastart = this->data;
-	this->dataend = this->data + size_;
+	if (this->refcount)
+		FBC_XADD(this->refcount, 1);
 }
 
 template<typename _Tp, int chs>
 Mat_<_Tp, chs>& Mat_<_Tp, chs>::operator = (const Mat_& _m)
 {
-	size_t size1 = this->rows * this->step;
-	size_t size2 = _m.rows * _m.step;
+	if (this != &_m) {
+		if (_m.refcount)
+			FBC_XADD(_m.refcount, 1);
+		release();
+
+		this->rows = _m.rows;
+		this->cols = _m.cols;
+		this->channels = _m.channels;
+		this->data = _m.data;
+		this->step = _m.step;
+		this->allocated = _m.allocated;
+		this->refcount = _m.refcount;
+		this->allocator = _m.allocator;
+		this->datastart = _m.datastart;
+		this->dataend = _m.dataend;
+	}
 
-	this->rows = _m.rows;
-	this->cols = _m.cols;
-	this->channels = _m.channels;
-	this->step = sizeof(_Tp) * this->cols * this->channels;
+	return *this;
+}
 
-	if ((size1 == size2) && (this->allocated == true) && (this->data != _m.data)) {
-		memcpy(this->data, _m.data, size2);
-	} else if (size2 > 0){
-		if (this->allocated == true) {
-			fastFree(this->data);
-		}
+template<typename _Tp, int chs>
+Mat_<_Tp, chs>::Mat_(Mat_<_Tp, chs>&& _m) noexcept
+	: rows(_m.rows), cols(_m.cols), channels(_m.channels), data(_m.data), step(_m.step), allocated(_m.allocated),
+	refcount(_m.refcount), allocator(_m.allocator), datastart(_m.datastart), dataend(_m.dataend)
+{
+	_m.data = NULL;
+	_m.datastart = _m.dataend = NULL;
+	_m.allocated = false;
+	_m.refcount = NULL;
+	_m.rows = _m.cols = _m.step = _m.channels = 0;
+}
 
-		this->allocated = true;
-		uchar* p = (uchar*)fastMalloc(size2);
-		FBC_Assert(p != NULL);
-		memcpy(p, _m.data, size2);
-		this->data = p;
-	} else {
-		this->allocated = false;
-		this->data = NULL;
-	}
+template<typename _Tp, int chs>
+Mat_<_Tp, chs>& Mat_<_Tp, chs>::operator = (Mat_&& _m) noexcept
+{
+	if (this != &_m) {
+		release();
+
+		this->rows = _m.rows;
+		this->cols = _m.cols;
+		this->channels = _m.channels;
+		this->data = _m.data;
+		this->step = _m.step;
+		this->allocated = _m.allocated;
+		this->refcount = _m.refcount;
+		this->allocator = _m.allocator;
+		this->datastart = _m.datastart;
+		this->dataend = _m.dataend;
 
-	this->datastart = this->data;
-	this->dataend = this->data + size2;
+		_m.data = NULL;
+		_m.datastart = _m.dataend = NULL;
+		_m.allocated = false;
+		_m.refcount = NULL;
+		_m.rows = _m.cols = _m.step = _m.channels = 0;
+	}
 
 	return *this;
 }
 
+template<typename _Tp, int chs>
+Mat_<_Tp, chs> Mat_<_Tp, chs>::clone() const
+{
+	Mat_<_Tp, chs> m;
+	copyTo(m);
+	return m;
+}
+
 template<typename _Tp, int chs>
 bool Mat_<_Tp, chs>::isContinuous() const
 {
@@ -271,81 +333,27 @@ void Mat_<_Tp, chs>::copyTo(Mat_<_Tp, chs>& _m, const Rect& rect) const
 {
 	FBC_Assert((this->rows >= rect.y + rect.height) && (this->cols >= rect.x + rect.width));
 
-	if (this->data != NULL) {
-		if ((rect.width > 0) && (rect.height > 0)) {
-			size_t size1 = sizeof(_Tp) * this->channels * rect.width * rect.height;
-			int step_ = sizeof(_Tp) * this->channels * rect.width;
-			size_t size2 = _m.rows * _m.step;
-
-			if (size1 == size2) {
-				uchar* p1 = _m.data;
-				uchar* p2 = this->data;
-
-				for (int i = 0; i < rect.height; i++) {
-					uchar* p1_ = p1 + i * sizeof(_Tp) * this->channels * rect.width;
-					uchar* p2_ = p2 + (rect.y + i) * this->step + rect.x * this->channels * sizeof(_Tp);
-
-					memcpy(p1_, p2_, step_);
-				}
-			} else {
-				if (_m.allocated == true)
-					fastFree(_m.data);
-
-				uchar* p1 = (uchar*)fastMalloc(size1);
-				FBC_Assert(p1 != NULL);
-				uchar* p2 = this->data;
-
-				for (int i = 0; i < rect.height; i++) {
-					uchar* p1_ = p1 + i * sizeof(_Tp) * this->channels * rect.width;
-					uchar* p2_ = p2 + (rect.y + i) * this->step + rect.x * this->channels * sizeof(_Tp);
-
-					memcpy(p1_, p2_, step_);
-				}
-				_m.data = p1;
-				_m.allocated = true;
-			}
+	if (this->data == NULL) {
+		_m.release();
+		return;
+	}
 
-			_m.rows = rect.height;
-			_m.cols = rect.width;
-			_m.step = step_;
-		} else {
-			size_t size1 = this->rows * this->step;
-			size_t size2 = _m.step * _m.rows;
-
-			if (size1 == size2) {
-				memcpy(_m.data, this->data, size1);
-			} else {
-				if (_m.allocated == true)
-					fastFree(_m.data);
-
-				uchar* p = (uchar*)fastMalloc(size1);
-				FBC_Assert(p != NULL);
-				memcpy(p, this->data, size1);
-				_m.data = p;
-				_m.allocated = true;
-			}
+	Rect rect_ = rect;
+	if ((rect_.width <= 0) || (rect_.height <= 0))
+		rect_ = Rect(0, 0, this->cols, this->rows);
 
-			_m.rows = this->rows;
-			_m.cols = this->cols;
-			_m.step = this->step;
-		}
-		_m.channels = this->channels;
+	if (_m.data == this->data && rect_.x == 0 && rect_.y == 0 && _m.rows == rect_.height && _m.cols == rect_.width)
+		return;
 
-	} else {
-		if ((_m.data != NULL) && (_m.allocated == true)) {
-			fastFree(_m.data);
-		}
+	// _m may share the data with this matrix, keep a reference until the copy is done
+	Mat_<_Tp, chs> src_(*this);
+	_m.create(rect_.height, rect_.width);
 
-		_m.data = NULL;
-		_m.allocated = false;
-		_m.rows = 0;
-		_m.cols = 0;
-		_m.step = 0;
-		_m.channels = 0;
+	size_t len = sizeof(_Tp) * chs * rect_.width;
+	for (int i = 0; i < rect_.height; i++) {
+		const uchar* p2 = src_.data + (rect_.y + i) * src_.step + rect_.x * sizeof(_Tp) * chs;
+		memcpy(_m.data + i * _m.step, p2, len);
 	}
-
-	_m.datastart = _m.data;
-	_m.dataend = _m.data + _m.step * _m.rows;
 }
 
 template<typename _Tp, int chs>
@@ -370,18 +378,22 @@ void Mat_<_Tp, chs>::getROI(Mat_<_Tp, chs>& _m, const Rect& rect)
 	FBC_Assert((rect.x >= 0) && (rect.y >= 0) && (rect.width > 0) && (rect.height > 0) &&
 			(this->rows >= rect.y + rect.height) && (this->cols >= rect.x + rect.width));
 
-	if (_m.allocated == true) {
-		fastFree(_m.data);
-	}
+	// the submatrix shares the data (and the reference counter) with this matrix
+	Mat_<_Tp, chs> m(*this);
+	_m.release();
 
 	_m.rows = rect.height;
 	_m.cols = rect.width;
-	_m.channels = this->channels;
-	_m.allocated = false;
-	_m.step = this->step;
-	_m.data = this->data + rect.y * this->step + rect.x * sizeof(_Tp) * this->channels;
-	_m.datastart = this->datastart;
-	_m.dataend = this->dataend;
+	_m.channels = m.channels;
+	_m.allocated = m.allocated;
+	_m.refcount = m.refcount;
+	_m.allocator = m.allocator;
+	_m.step = m.step;
+	_m.data = m.data + rect.y * m.step + rect.x * sizeof(_Tp) * m.channels;
+	_m.datastart = m.datastart;
+	_m.dataend = m.dataend;
+	if (_m.refcount)
+		FBC_XADD(_m.refcount, 1);
 }
 
 template<typename _Tp, int chs>
@@ -439,25 +451,7 @@ void Mat_<_Tp, chs>::convertTo(Mat_<_Tp2, chs>& _m, double alpha, const Scalar&
 		return;
 	}*/
 
-	size_t size = this->rows * this->cols * this->channels * sizeof(_Tp2);
-
-	if (this->rows * this->cols != _m.rows * _m.cols) {
-		if (_m.allocated == true) {
-			fastFree(_m.data);
-		}
-
-		uchar* p = (uchar*)fastMalloc(size);
-		FBC_Assert(p != NULL);
-		_m.data = p;
-		_m.allocated = true;
-	}
-
-	_m.channels = this->channels;
-	_m.rows = this->rows;
-	_m.cols = this->cols;
-	_m.step = _m.cols * sizeof(_Tp2) * _m.channels;
-	_m.datastart = _m.data;
-	_m.dataend = _m.data + _m.step * _m.rows;
+	_m.create(this->rows, this->cols);
 
 	_Tp2 alpha_ = (_Tp2)alpha;
 	Scalar_<_Tp2> scalar_;
@@ -483,18 +477,11 @@ void Mat_<_Tp, chs>::convertTo(Mat_<_Tp2, chs>& _m, double alpha, const Scalar&
 template<typename _Tp, int chs>
 Mat_<_Tp, chs>& Mat_<_Tp, chs>::zeros(int _rows, int _cols)
 {
-	this->rows = _rows;
-	this->cols = _cols;
-	this->channels = chs;
-	this->step = sizeof(_Tp) * _cols * chs;
-	this->allocated = true;
-
-	size_t size_ = this->rows * this->step;
-	uchar* p = (uchar*)fastMalloc(size_);
-	FBC_Assert(p != NULL);
-	this->data = p;
+	create(_rows, _cols);
 
-	memset(this->data, 0, size_);
+	for (int i = 0; i < this->rows; i++) {
+		memset(this->data + i * this->step, 0, sizeof(_Tp) * this->cols * chs);
+	}
 
 	return *this;
 }
@@ -529,6 +516,21 @@ bool Mat_<_Tp, chs>::empty() const
 	return total() == 0 || this->data == NULL;
 }
 
+// Creates the destination images of a batch: count images of size, the images which have the size already
+// are kept (e.g. the batch of the previous call), the others are allocated one by one, so that a filter which
+// takes the border from the parent matrix (locateROI) never sees the neighbouring images
+template<typename _Tp, int chs>
+void createBatch(std::vector<Mat_<_Tp, chs>>& batch, int count, Size size)
+{
+	FBC_Assert(count >= 0 && size.width > 0 && size.height > 0);
+	batch.resize(count);
+
+	for (int i = 0; i < count; i++) {
+		if (batch[i].empty() || batch[i].size() != size)
+			batch[i] = Mat_<_Tp, chs>(size.height, size.width);
+	}
+}
+
 /////////////////////////// Mat_ out-of-class operators ///////////////////////////
 template<typename _Tp1, typename _Tp2, int chs> static inline
 Mat_<_Tp1, chs>& operator -= (Mat_<_Tp1, chs>& a, const Mat_<_Tp2, chs>& b)
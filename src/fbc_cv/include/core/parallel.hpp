@@ -0,0 +1,109 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_CORE_PARALLEL_HPP_
+#define FBC_CV_CORE_PARALLEL_HPP_
+
+/* reference: include/opencv2/core/utility.hpp
+              include/opencv2/core/parallel/parallel_backend.hpp
+              modules/core/src/parallel.cpp
+*/
+
+#ifndef __cplusplus
+	#error parallel.hpp header must be compiled as C++
+#endif
+
+#include <functional>
+#include <memory>
+#include "fbcdef.hpp"
+#include "types.hpp"
+
+namespace fbc {
+
+// Base class for parallel data processors
+class FBC_EXPORTS ParallelLoopBody {
+public:
+	virtual ~ParallelLoopBody();
+	// process the sub-range [range.start, range.end) of the whole loop range, must be thread safe
+	virtual void operator() (const Range& range) const = 0;
+};
+
+// Parallel data processor
+// splits range into nstripes sub-ranges and calls body for each of them, possibly from several threads;
+// nstripes <= 0 lets the backend choose, a single stripe or a single thread runs body(range) in the caller thread
+FBC_EXPORTS void parallel_for_(const Range& range, const ParallelLoopBody& body, double nstripes = -1.);
+
+class ParallelLoopBodyLambdaWrapper : public ParallelLoopBody {
+public:
+	ParallelLoopBodyLambdaWrapper(std::function<void(const Range&)> functor) : m_functor(functor) {}
+	virtual void operator() (const Range& range) const { m_functor(range); }
+
+private:
+	std::function<void(const Range&)> m_functor;
+};
+
+static inline void parallel_for_(const Range& range, std::function<void(const Range&)> functor, double nstripes = -1.)
+{
+	parallel_for_(range, ParallelLoopBodyLambdaWrapper(functor), nstripes);
+}
+
+// Interface of the parallel execution backends used by parallel_for_
+class FBC_EXPORTS ParallelForAPI {
+public:
+	typedef void (*FN_parallel_for_body_cb_t)(int start, int end, void* data);
+
+	virtual ~ParallelForAPI();
+	// run body for every stripe of [0, numStripes), it returns after all stripes are processed
+	virtual void parallel_for(int numStripes, FN_parallel_for_body_cb_t body_cb, void* body_cb_data) = 0;
+	// maximal number of threads the backend uses, including the caller thread
+	virtual int getNumThreads() const = 0;
+	// n > 0: use n threads, n == 0: serial execution, n < 0: reset to the default number of threads
+	virtual int setNumThreads(int nThreads) = 0;
+	// index of the current thread in [0, getNumThreads()), 0 is the caller thread
+	virtual int getThreadNum() const = 0;
+	// name of the backend: "threads", "openmp" or a user supplied one
+	virtual const char* getName() const = 0;
+};
+
+// Replace the backend of parallel_for_, NULL restores the default backend
+// the number of threads is taken over by the new backend
+FBC_EXPORTS void setParallelForBackend(const std::shared_ptr<ParallelForAPI>& api);
+// Select one of the built-in backends by name: "threads" (std::thread pool) or "openmp" (only when built with FBC_USE_OPENMP)
+FBC_EXPORTS bool setParallelForBackend(const char* backendName);
+// Returns the currently active backend
+FBC_EXPORTS std::shared_ptr<ParallelForAPI> getParallelForBackend();
+
+// Sets the number of threads used by parallel regions
+// nthreads > 0: use nthreads threads, nthreads == 0: disable threading, nthreads < 0: reset to the default value
+// the default value is the number of logical cpus, it can be overridden by the environment variable FBC_NUM_THREADS
+FBC_EXPORTS void setNumThreads(int nthreads);
+// Returns the number of threads used by parallel regions, 1 when threading is disabled
+FBC_EXPORTS int getNumThreads();
+// Returns the index of the currently executed thread within the current parallel region, 0 outside parallel regions
+FBC_EXPORTS int getThreadNum();
+// Returns the number of logical CPUs available for the process
+FBC_EXPORTS int getNumberOfCPUs();
+
+// Processes the images [0, count) of a batch, body(i) processes image i
+// the images are distributed over the threads as whole images as long as every thread gets one (one parallel
+// region for the batch, the parallel loops of body run serially inside it), the remaining count % threads images
+// are processed one after another, each with its own parallel loops over its row stripes
+static inline void parallel_for_batch_(int count, std::function<void(int)> body)
+{
+	int nthreads = getNumThreads();
+	int whole = count / nthreads * nthreads;
+
+	if (whole > 0) {
+		parallel_for_(Range(0, whole), [&](const Range& range) {
+			for (int i = range.start; i < range.end; i++)
+				body(i);
+		}, whole);
+	}
+
+	for (int i = whole; i < count; i++)
+		body(i);
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_CORE_PARALLEL_HPP_
@@ -10,8 +10,10 @@
 	#error utility.hpp header must be compiled as C++
 #endif
 
+#include <type_traits>
 #include "fbcdef.hpp"
 #include "base.hpp"
+#include "fbcstd.hpp"
 
 namespace fbc {
 
@@ -30,6 +32,7 @@ static inline size_t alignSize(size_t sz, int n)
 
 // Automatically Allocated Buffer Class
 // The class is used for temporary buffers in functions and methods.
+// heap buffers of trivial types are taken from scratchMalloc, other types use new[]/delete[]
 template<typename _Tp, size_t fixed_size = 1024 / sizeof(_Tp) + 8> class AutoBuffer {
 public:
 	typedef _Tp value_type;
@@ -61,6 +64,13 @@ public:
 	operator const _Tp* () const;
 
 protected:
+	static _Tp* heapAllocate(size_t _size) { return heapAllocate(_size, std::is_trivial<_Tp>()); }
+	static _Tp* heapAllocate(size_t _size, std::true_type) { return (_Tp*)scratchMalloc(_size * sizeof(_Tp)); }
+	static _Tp* heapAllocate(size_t _size, std::false_type) { return new _Tp[_size]; }
+	static void heapDeallocate(_Tp* p) { heapDeallocate(p, std::is_trivial<_Tp>()); }
+	static void heapDeallocate(_Tp* p, std::true_type) { scratchFree(p); }
+	static void heapDeallocate(_Tp* p, std::false_type) { delete[] p; }
+
 	// pointer to the real buffer, can point to buf if the buffer is small enough
 	_Tp* ptr;
 	// size of the real buffer
@@ -124,7 +134,7 @@ AutoBuffer<_Tp, fixed_size>::allocate(size_t _size)
 
 	deallocate();
 	if (_size > fixed_size) {
-		ptr = new _Tp[_size];
+		ptr = heapAllocate(_size);
 		sz = _size;
 	}
 }
@@ -133,7 +143,7 @@ template<typename _Tp, size_t fixed_size> inline void
 AutoBuffer<_Tp, fixed_size>::deallocate()
 {
 	if (ptr != buf) {
-		delete[] ptr;
+		heapDeallocate(ptr);
 		ptr = buf;
 		sz = fixed_size;
 	}
@@ -149,7 +159,7 @@ AutoBuffer<_Tp, fixed_size>::resize(size_t _size)
 	size_t i, prevsize = sz, minsize = MIN(prevsize, _size);
 	_Tp* prevptr = ptr;
 
-	ptr = _size > fixed_size ? new _Tp[_size] : buf;
+	ptr = _size > fixed_size ? heapAllocate(_size) : buf;
 	sz = _size;
 
 	if (ptr != prevptr) {
@@ -162,7 +172,7 @@ AutoBuffer<_Tp, fixed_size>::resize(size_t _size)
 	}
 
 	if (prevptr != buf) {
-		delete[] prevptr;
+		heapDeallocate(prevptr);
 	}
 }
 
@@ -184,6 +194,16 @@ AutoBuffer<_Tp, fixed_size>::operator const _Tp* () const
 	return ptr;
 }
 
+// Returns true if the specified feature (FBC_CPU_SSE4_1, FBC_CPU_AVX2, ...) is supported by the host hardware and enabled
+// features can be disabled with the environment variable FBC_CPU_DISABLE, e.g. FBC_CPU_DISABLE=AVX2,SSE4_1
+// it always returns false when the optimized code is turned off by setUseOptimized(false)
+FBC_EXPORTS bool checkHardwareSupport(int feature);
+
+// Enables or disables the optimized (SIMD) code paths, they produce the same results as the plain C++ code
+FBC_EXPORTS void setUseOptimized(bool onoff);
+// Returns the status of the optimized code usage
+FBC_EXPORTS bool useOptimized();
+
 } // fbc
 
 #endif // FBC_CV_CORE_UTILITY_HPP_
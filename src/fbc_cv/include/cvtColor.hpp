@@ -9,10 +9,13 @@
 */
 
 #include <typeinfo>
+#include <vector>
 #include "core/mat.hpp"
 #include "core/saturate.hpp"
 #include "imgproc.hpp"
 #include "core/core.hpp"
+#include "core/parallel.hpp"
+#include "core/hal.hpp"
 
 namespace fbc {
 #define  FBC_DESCALE(x,n)     (((x) + (1 << ((n)-1))) >> (n))
@@ -306,6 +309,55 @@ int cvtColor(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst, int code)
 	return 0;
 }
 
+// Converts the images of a batch from one color space to another
+// the sources must have the same size, dst gets one image per source image, see createBatch()
+template<typename _Tp, int chs1, int chs2>
+int cvtColor(const std::vector<Mat_<_Tp, chs1>>& src, std::vector<Mat_<_Tp, chs2>>& dst, int code)
+{
+	int n = (int)src.size();
+	if (n == 0) {
+		dst.clear();
+		return 0;
+	}
+
+	Size sz = src[0].size(), dz = sz;
+	for (int i = 1; i < n; i++)
+		FBC_Assert(src[i].size() == sz);
+
+	switch (code) {
+		case CV_YUV2BGR_NV21:  case CV_YUV2RGB_NV21:  case CV_YUV2BGR_NV12:  case CV_YUV2RGB_NV12:
+		case CV_YUV2BGRA_NV21: case CV_YUV2RGBA_NV21: case CV_YUV2BGRA_NV12: case CV_YUV2RGBA_NV12:
+		case CV_YUV2BGR_YV12: case CV_YUV2RGB_YV12: case CV_YUV2BGRA_YV12: case CV_YUV2RGBA_YV12:
+		case CV_YUV2BGR_IYUV: case CV_YUV2RGB_IYUV: case CV_YUV2BGRA_IYUV: case CV_YUV2RGBA_IYUV:
+		case CV_YUV2GRAY_420:
+			dz.height = sz.height * 2 / 3;
+			break;
+		case CV_RGB2YUV_YV12: case CV_BGR2YUV_YV12: case CV_RGBA2YUV_YV12: case CV_BGRA2YUV_YV12:
+		case CV_RGB2YUV_IYUV: case CV_BGR2YUV_IYUV: case CV_RGBA2YUV_IYUV: case CV_BGRA2YUV_IYUV:
+			dz.height = sz.height / 2 * 3;
+			break;
+		default:
+			break;
+	}
+
+	createBatch(dst, n, dz);
+
+	parallel_for_batch_(n, [&](int i) {
+		cvtColor(src[i], dst[i], code);
+	});
+
+	return 0;
+}
+
+// Converts an image from one color space to another, the conversion code is a template argument, e.g.
+// cvtColor<CV_BGR2YCrCb>(src, dst): BGR/RGB <-> BGRA/RGBA, Gray, YCrCb, YUV and HSV use kernels specialized
+// at compile time (channel order, channel counts and coefficients are constants, 8-bit BGR <-> YCrCb/YUV runs
+// in SSE4.1 fixed point), the rows are converted in parallel; the results are those of cvtColor(src, dst, code),
+// the other codes are converted by it
+// support type: uchar/ushort/float
+template<int code, typename _Tp, int chs1, int chs2>
+int cvtColor(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst);
+
 // computes cubic spline coefficients for a function: (xi=i, yi=f[i]), i=0..n
 template<typename _Tp> static void splineBuild(const _Tp* f, int n, _Tp* tab)
 {
@@ -1670,8 +1722,11 @@ const int ITUR_BT_601_CBU = 460324;
 const int ITUR_BT_601_CGV = -385875;
 const int ITUR_BT_601_CBV = -74448;
 
+// smaller images are converted in the caller thread, the gain does not pay for the thread synchronization
+#define MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION (320*240)
+
 template<typename _Tp, int chs, int bIdx, int uIdx>
-struct YUV420sp2RGB888Invoker
+struct YUV420sp2RGB888Invoker : ParallelLoopBody
 {
 	Mat_<_Tp, chs>* dst;
 	const uchar* my1, *muv;
@@ -1733,7 +1788,7 @@ struct YUV420sp2RGB888Invoker
 };
 
 template<typename _Tp, int chs, int bIdx, int uIdx>
-struct YUV420sp2RGBA8888Invoker
+struct YUV420sp2RGBA8888Invoker : ParallelLoopBody
 {
 	Mat_<_Tp, chs>* dst;
 	const uchar* my1, *muv;
@@ -1799,7 +1854,7 @@ struct YUV420sp2RGBA8888Invoker
 };
 
 template<typename _Tp, int chs, int bIdx>
-struct YUV420p2RGB888Invoker
+struct YUV420p2RGB888Invoker : ParallelLoopBody
 {
 	Mat_<_Tp, chs>* dst;
 	const uchar* my1, *mu, *mv;
@@ -1864,7 +1919,7 @@ struct YUV420p2RGB888Invoker
 };
 
 template<typename _Tp, int chs, int bIdx>
-struct YUV420p2RGBA8888Invoker
+struct YUV420p2RGBA8888Invoker : ParallelLoopBody
 {
 	Mat_<_Tp, chs>* dst;
 	const uchar* my1, *mu, *mv;
@@ -1936,32 +1991,44 @@ template<typename _Tp, int chs, int bIdx, int uIdx>
 inline void cvtYUV420sp2RGB(Mat_<_Tp, chs>& _dst, int _stride, const uchar* _y1, const uchar* _uv)
 {
 	YUV420sp2RGB888Invoker<_Tp, chs, bIdx, uIdx> converter(&_dst, _stride, _y1, _uv);
-	converter(Range(0, _dst.rows / 2));
+	if (_dst.total() >= MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION)
+		parallel_for_(Range(0, _dst.rows / 2), converter);
+	else
+		converter(Range(0, _dst.rows / 2));
 }
 
 template<typename _Tp, int chs, int bIdx, int uIdx>
 inline void cvtYUV420sp2RGBA(Mat_<_Tp, chs>& _dst, int _stride, const uchar* _y1, const uchar* _uv)
 {
 	YUV420sp2RGBA8888Invoker<_Tp, chs, bIdx, uIdx> converter(&_dst, _stride, _y1, _uv);
-	converter(Range(0, _dst.rows / 2));
+	if (_dst.total() >= MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION)
+		parallel_for_(Range(0, _dst.rows / 2), converter);
+	else
+		converter(Range(0, _dst.rows / 2));
 }
 
 template<typename _Tp, int chs, int bIdx>
 inline void cvtYUV420p2RGB(Mat_<_Tp, chs>& _dst, int _stride, const uchar* _y1, const uchar* _u, const uchar* _v, int ustepIdx, int vstepIdx)
 {
 	YUV420p2RGB888Invoker<_Tp, chs, bIdx> converter(&_dst, _stride, _y1, _u, _v, ustepIdx, vstepIdx);
-	converter(Range(0, _dst.rows / 2));
+	if (_dst.total() >= MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION)
+		parallel_for_(Range(0, _dst.rows / 2), converter);
+	else
+		converter(Range(0, _dst.rows / 2));
 }
 
 template<typename _Tp, int chs, int bIdx>
 inline void cvtYUV420p2RGBA(Mat_<_Tp, chs>& _dst, int _stride, const uchar* _y1, const uchar* _u, const uchar* _v, int ustepIdx, int vstepIdx)
 {
 	YUV420p2RGBA8888Invoker<_Tp, chs, bIdx> converter(&_dst, _stride, _y1, _u, _v, ustepIdx, vstepIdx);
-	converter(Range(0, _dst.rows / 2));
+	if (_dst.total() >= MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION)
+		parallel_for_(Range(0, _dst.rows / 2), converter);
+	else
+		converter(Range(0, _dst.rows / 2));
 }
 
 template<typename _Tp, int chs1, int chs2, int bIdx>
-struct RGB888toYUV420pInvoker
+struct RGB888toYUV420pInvoker : ParallelLoopBody
 {
 	RGB888toYUV420pInvoker(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>* dst, const int uIdx)
 		: src_(src), dst_(dst), uIdx_(uIdx) { }
@@ -2021,7 +2088,10 @@ template<typename _Tp, int chs1, int chs2, int bIdx, int uIdx>
 static void cvtRGBtoYUV420p(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
 {
 	RGB888toYUV420pInvoker<_Tp, chs1, chs2, bIdx> colorConverter(src, &dst, uIdx);
-	colorConverter(Range(0, src.rows / 2));
+	if (src.total() >= MIN_SIZE_FOR_PARALLEL_YUV420_CONVERSION)
+		parallel_for_(Range(0, src.rows / 2), colorConverter);
+	else
+		colorConverter(Range(0, src.rows / 2));
 }
 
 template<typename _Tp, int chs1, int chs2>
@@ -2437,5 +2507,357 @@ static int CvtColorLoop_Luv2RGB(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst
 }
 
 
+// the kinds of conversions of cvtColor<code>() with kernels specialized at compile time
+enum CvtStaticKind {
+	CVT_STATIC_RGB2RGB, CVT_STATIC_RGB2GRAY, CVT_STATIC_GRAY2RGB, CVT_STATIC_RGB2YCrCb, CVT_STATIC_YCrCb2RGB,
+	CVT_STATIC_RGB2HSV, CVT_STATIC_HSV2RGB, CVT_STATIC_RUNTIME
+};
+
+// the constants of a conversion code: its kind, the index of blue in the BGR/RGB image, the channels of the
+// destination of RGB2RGB, the YUV coefficients instead of the YCrCb ones and the hue range of 8-bit HSV
+template<int code> struct CvtColorCode
+{
+	static const CvtStaticKind kind = (code == CV_BGR2BGRA || code == CV_RGB2BGRA || code == CV_BGRA2BGR || code == CV_RGBA2BGR ||
+		code == CV_RGB2BGR || code == CV_BGRA2RGBA) ? CVT_STATIC_RGB2RGB :
+		(code == CV_BGR2GRAY || code == CV_BGRA2GRAY || code == CV_RGB2GRAY || code == CV_RGBA2GRAY) ? CVT_STATIC_RGB2GRAY :
+		(code == CV_GRAY2BGR || code == CV_GRAY2BGRA) ? CVT_STATIC_GRAY2RGB :
+		(code == CV_BGR2YCrCb || code == CV_RGB2YCrCb || code == CV_BGR2YUV || code == CV_RGB2YUV) ? CVT_STATIC_RGB2YCrCb :
+		(code == CV_YCrCb2BGR || code == CV_YCrCb2RGB || code == CV_YUV2BGR || code == CV_YUV2RGB) ? CVT_STATIC_YCrCb2RGB :
+		(code == CV_BGR2HSV || code == CV_RGB2HSV || code == CV_BGR2HSV_FULL || code == CV_RGB2HSV_FULL) ? CVT_STATIC_RGB2HSV :
+		(code == CV_HSV2BGR || code == CV_HSV2RGB || code == CV_HSV2BGR_FULL || code == CV_HSV2RGB_FULL) ? CVT_STATIC_HSV2RGB :
+		CVT_STATIC_RUNTIME;
+
+	enum {
+		bidx = (code == CV_BGR2BGRA || code == CV_BGRA2BGR || code == CV_BGR2GRAY || code == CV_BGRA2GRAY ||
+			code == CV_BGR2YCrCb || code == CV_BGR2YUV || code == CV_YCrCb2BGR || code == CV_YUV2BGR ||
+			code == CV_BGR2HSV || code == CV_BGR2HSV_FULL || code == CV_HSV2BGR || code == CV_HSV2BGR_FULL) ? 0 : 2,
+		dcn = (code == CV_BGR2BGRA || code == CV_RGB2BGRA || code == CV_BGRA2RGBA) ? 4 : 3,
+		yuv = (code == CV_BGR2YUV || code == CV_RGB2YUV || code == CV_YUV2BGR || code == CV_YUV2RGB) ? 1 : 0,
+		hrange = (code == CV_BGR2HSV || code == CV_RGB2HSV || code == CV_HSV2BGR || code == CV_HSV2RGB) ? 180 :
+			(code == CV_BGR2HSV_FULL || code == CV_RGB2HSV_FULL) ? 256 : 255
+	};
+};
+
+// the kernels of cvtColor<code>(), they compute what the functors of cvtColor(src, dst, code) compute with
+// the same operations, the parameters of those are template arguments here
+template<typename _Tp, int scn, int dcn, int bidx> struct CvtRGB2RGB
+{
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		if (dcn == 3) {
+			for (int i = 0; i < n; i++, src += scn, dst += 3) {
+				_Tp t0 = src[bidx], t1 = src[1], t2 = src[bidx ^ 2];
+				dst[0] = t0; dst[1] = t1; dst[2] = t2;
+			}
+		} else if (scn == 3) {
+			_Tp alpha = ColorChannel<_Tp>::max();
+			for (int i = 0; i < n; i++, src += 3, dst += 4) {
+				_Tp t0 = src[0], t1 = src[1], t2 = src[2];
+				dst[bidx] = t0; dst[1] = t1; dst[bidx ^ 2] = t2; dst[3] = alpha;
+			}
+		} else {
+			for (int i = 0; i < n; i++, src += 4, dst += 4) {
+				_Tp t0 = src[0], t1 = src[1], t2 = src[2], t3 = src[3];
+				dst[0] = t2; dst[1] = t1; dst[2] = t0; dst[3] = t3;
+			}
+		}
+	}
+};
+
+template<typename _Tp, int scn, int bidx> struct CvtRGB2Gray
+{
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		if (sizeof(_Tp) == 4) {
+			const float cb = bidx == 0 ? 0.114f : 0.299f, cg = 0.587f, cr = bidx == 0 ? 0.299f : 0.114f;
+			for (int i = 0; i < n; i++, src += scn)
+				dst[i] = saturate_cast<_Tp>(src[0] * cb + src[1] * cg + src[2] * cr);
+		} else {
+			const int cb = bidx == 0 ? B2Y : R2Y, cg = G2Y, cr = bidx == 0 ? R2Y : B2Y;
+			int i = 0;
+			if (sizeof(_Tp) == 1) {
+				const int coeffs[] = { cb, cg, cr };
+				i = hal::cvtBGRtoGray8u((const uchar*)src, (uchar*)dst, n, scn, coeffs);
+				src += i * scn;
+			}
+			for (; i < n; i++, src += scn)
+				dst[i] = (_Tp)FBC_DESCALE((unsigned)(src[0] * cb + src[1] * cg + src[2] * cr), yuv_shift);
+		}
+	}
+};
+
+template<typename _Tp, int dcn> struct CvtGray2RGB
+{
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		_Tp alpha = ColorChannel<_Tp>::max();
+		for (int i = 0; i < n; i++, dst += dcn) {
+			dst[0] = dst[1] = dst[2] = src[i];
+			if (dcn == 4)
+				dst[3] = alpha;
+		}
+	}
+};
+
+// the YUV coefficients of RGB2YCrCb_f/RGB2YCrCb_i are given in B, G, R order and swapped like the YCrCb ones
+template<typename _Tp, int scn, int bidx, int yuv> struct CvtRGB2YCrCb
+{
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		if (sizeof(_Tp) == 4) {
+			const float c0 = yuv ? 0.114f : 0.299f, c2 = yuv ? 0.299f : 0.114f;
+			const float C0 = bidx == 0 ? c2 : c0, C1 = 0.587f, C2 = bidx == 0 ? c0 : c2;
+			const float C3 = yuv ? 0.492f : 0.713f, C4 = yuv ? 0.877f : 0.564f;
+			const _Tp delta = ColorChannel<_Tp>::half();
+			for (int i = 0; i < n; i++, src += scn, dst += 3) {
+				_Tp Y = saturate_cast<_Tp>(src[0] * C0 + src[1] * C1 + src[2] * C2);
+				_Tp Cr = saturate_cast<_Tp>((src[bidx ^ 2] - Y)*C3 + delta);
+				_Tp Cb = saturate_cast<_Tp>((src[bidx] - Y)*C4 + delta);
+				dst[0] = Y; dst[1] = Cr; dst[2] = Cb;
+			}
+		} else {
+			const int c0 = yuv ? B2Y : R2Y, c2 = yuv ? R2Y : B2Y;
+			const int C0 = bidx == 0 ? c2 : c0, C1 = G2Y, C2 = bidx == 0 ? c0 : c2;
+			const int C3 = yuv ? 8061 : 11682, C4 = yuv ? 14369 : 9241;
+			const int delta = ColorChannel<_Tp>::half()*(1 << yuv_shift);
+			int i = 0;
+			if (sizeof(_Tp) == 1) {
+				const int coeffs[] = { C0, C1, C2, C3, C4 };
+				i = hal::cvtBGRtoYCrCb8u((const uchar*)src, (uchar*)dst, n, scn, bidx, coeffs);
+				src += i * scn;
+				dst += i * 3;
+			}
+			for (; i < n; i++, src += scn, dst += 3) {
+				int s0 = src[0], s1 = src[1], s2 = src[2];
+				int Y = FBC_DESCALE(s0 * C0 + s1 * C1 + s2 * C2, yuv_shift);
+				int Cr = FBC_DESCALE(((bidx == 0 ? s2 : s0) - Y)*C3 + delta, yuv_shift);
+				int Cb = FBC_DESCALE(((bidx == 0 ? s0 : s2) - Y)*C4 + delta, yuv_shift);
+				dst[0] = saturate_cast<_Tp>(Y);
+				dst[1] = saturate_cast<_Tp>(Cr);
+				dst[2] = saturate_cast<_Tp>(Cb);
+			}
+		}
+	}
+};
+
+template<typename _Tp, int dcn, int bidx, int yuv> struct CvtYCrCb2RGB
+{
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		const _Tp alpha = ColorChannel<_Tp>::max();
+		if (sizeof(_Tp) == 4) {
+			const _Tp delta = ColorChannel<_Tp>::half();
+			const float C0 = yuv ? 2.032f : 1.403f, C1 = yuv ? -0.395f : -0.714f;
+			const float C2 = yuv ? -0.581f : -0.344f, C3 = yuv ? 1.140f : 1.773f;
+			for (int i = 0; i < n; i++, src += 3, dst += dcn) {
+				_Tp Y = src[0], Cr = src[1], Cb = src[2];
+				_Tp b = saturate_cast<_Tp>(Y + (Cb - delta)*C3);
+				_Tp g = saturate_cast<_Tp>(Y + (Cb - delta)*C2 + (Cr - delta)*C1);
+				_Tp r = saturate_cast<_Tp>(Y + (Cr - delta)*C0);
+				dst[bidx] = b; dst[1] = g; dst[bidx ^ 2] = r;
+				if (dcn == 4)
+					dst[3] = alpha;
+			}
+		} else {
+			const int C0 = yuv ? 33292 : 22987, C1 = yuv ? -6472 : -11698;
+			const int C2 = yuv ? -9519 : -5636, C3 = yuv ? 18678 : 29049;
+			const int delta = ColorChannel<_Tp>::half();
+			int i = 0;
+			if (sizeof(_Tp) == 1) {
+				const int coeffs[] = { C0, C1, C2, C3 };
+				i = hal::cvtYCrCbtoBGR8u((const uchar*)src, (uchar*)dst, n, dcn, bidx, coeffs);
+				src += i * 3;
+				dst += i * dcn;
+			}
+			for (; i < n; i++, src += 3, dst += dcn) {
+				int Y = src[0], Cr = src[1], Cb = src[2];
+				int b = Y + FBC_DESCALE((Cb - delta)*C3, yuv_shift);
+				int g = Y + FBC_DESCALE((Cb - delta)*C2 + (Cr - delta)*C1, yuv_shift);
+				int r = Y + FBC_DESCALE((Cr - delta)*C0, yuv_shift);
+				dst[bidx] = saturate_cast<_Tp>(b);
+				dst[1] = saturate_cast<_Tp>(g);
+				dst[bidx ^ 2] = saturate_cast<_Tp>(r);
+				if (dcn == 4)
+					dst[3] = alpha;
+			}
+		}
+	}
+};
+
+// 8-bit: the integer code of RGB2HSV_b with the division tables of hrange, float: RGB2HSV_f
+template<typename _Tp, int scn, int bidx, int hrange> struct CvtRGB2HSV
+{
+	enum { hsv_shift = 12 };
+
+	CvtRGB2HSV() : cvt_f(scn, bidx, 360.f)
+	{
+		sdiv_table[0] = hdiv_table[0] = 0;
+		for (int i = 1; i < 256; i++) {
+			sdiv_table[i] = saturate_cast<int>((255 << hsv_shift) / (1.*i));
+			hdiv_table[i] = saturate_cast<int>((hrange << hsv_shift) / (6.*i));
+		}
+	}
+
+	void operator()(const _Tp* _src, _Tp* _dst, int n) const
+	{
+		if (sizeof(_Tp) == 4) {
+			cvt_f((const float*)_src, (float*)_dst, n);
+			return;
+		}
+
+		const uchar* src = (const uchar*)_src;
+		uchar* dst = (uchar*)_dst;
+		for (int i = 0; i < n; i++, src += scn, dst += 3) {
+			int b = src[bidx], g = src[1], r = src[bidx ^ 2];
+			int h, s, v = b;
+			int vmin = b, diff;
+			int vr, vg;
+
+			FBC_CALC_MAX_8U(v, g);
+			FBC_CALC_MAX_8U(v, r);
+			FBC_CALC_MIN_8U(vmin, g);
+			FBC_CALC_MIN_8U(vmin, r);
+
+			diff = v - vmin;
+			vr = v == r ? -1 : 0;
+			vg = v == g ? -1 : 0;
+
+			s = (diff * sdiv_table[v] + (1 << (hsv_shift - 1))) >> hsv_shift;
+			h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + ((~vg) & (r - g + 4 * diff))));
+			h = (h * hdiv_table[diff] + (1 << (hsv_shift - 1))) >> hsv_shift;
+			h += h < 0 ? hrange : 0;
+
+			dst[0] = saturate_cast<uchar>(h);
+			dst[1] = (uchar)s;
+			dst[2] = (uchar)v;
+		}
+	}
+
+	int sdiv_table[256], hdiv_table[256];
+	RGB2HSV_f cvt_f;
+};
+
+// HSV2RGB_b/HSV2RGB_f, the 8-bit conversion goes through float like the one of cvtColor(src, dst, code)
+template<typename _Tp, int dcn, int bidx, int hrange> struct CvtHSV2RGB
+{
+	CvtHSV2RGB() : cvt_b(dcn, bidx, hrange), cvt_f(dcn, bidx, 360.f) {}
+
+	void operator()(const _Tp* src, _Tp* dst, int n) const
+	{
+		if (sizeof(_Tp) == 4)
+			cvt_f((const float*)src, (float*)dst, n);
+		else
+			cvt_b((const uchar*)src, (uchar*)dst, n);
+	}
+
+	HSV2RGB_b cvt_b;
+	HSV2RGB_f cvt_f;
+};
+
+// converts the rows of src with cvt, the rows are processed in parallel
+template<typename _Tp, int chs1, int chs2, class Cvt>
+static void CvtColorRows(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst, const Cvt& cvt)
+{
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++)
+			cvt((const _Tp*)src.ptr(i), (_Tp*)dst.ptr(i), src.cols);
+	}, src.total() / (double)(1 << 16));
+}
+
+// cvtColor<code>() of a kind of conversion, the codes without a specialized kernel use cvtColor(src, dst, code)
+template<int kind> struct CvtColorStatic
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst) { cvtColor(src, dst, code); }
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_RGB2RGB>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert((chs1 == 3 || chs1 == 4) && chs2 == CvtColorCode<code>::dcn);
+		CvtColorRows(src, dst, CvtRGB2RGB<_Tp, chs1, chs2, CvtColorCode<code>::bidx>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_RGB2GRAY>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert((chs1 == 3 || chs1 == 4) && chs2 == 1);
+		CvtColorRows(src, dst, CvtRGB2Gray<_Tp, chs1, CvtColorCode<code>::bidx>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_GRAY2RGB>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert(chs1 == 1 && (chs2 == 3 || chs2 == 4));
+		CvtColorRows(src, dst, CvtGray2RGB<_Tp, chs2>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_RGB2YCrCb>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert((chs1 == 3 || chs1 == 4) && chs2 == 3);
+		CvtColorRows(src, dst, CvtRGB2YCrCb<_Tp, chs1, CvtColorCode<code>::bidx, CvtColorCode<code>::yuv>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_YCrCb2RGB>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert(chs1 == 3 && (chs2 == 3 || chs2 == 4));
+		CvtColorRows(src, dst, CvtYCrCb2RGB<_Tp, chs2, CvtColorCode<code>::bidx, CvtColorCode<code>::yuv>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_RGB2HSV>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert((chs1 == 3 || chs1 == 4) && chs2 == 3);
+		FBC_Assert(sizeof(_Tp) == 1 || sizeof(_Tp) == 4);
+		CvtColorRows(src, dst, CvtRGB2HSV<_Tp, chs1, CvtColorCode<code>::bidx, CvtColorCode<code>::hrange>());
+	}
+};
+
+template<> struct CvtColorStatic<CVT_STATIC_HSV2RGB>
+{
+	template<int code, typename _Tp, int chs1, int chs2>
+	static void run(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+	{
+		FBC_Assert(chs1 == 3 && (chs2 == 3 || chs2 == 4));
+		FBC_Assert(sizeof(_Tp) == 1 || sizeof(_Tp) == 4);
+		CvtColorRows(src, dst, CvtHSV2RGB<_Tp, chs2, CvtColorCode<code>::bidx, CvtColorCode<code>::hrange>());
+	}
+};
+
+template<int code, typename _Tp, int chs1, int chs2>
+int cvtColor(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst)
+{
+	if (CvtColorCode<code>::kind != CVT_STATIC_RUNTIME) {
+		FBC_Assert(src.cols > 0 && src.rows > 0 && src.size() == dst.size());
+		FBC_Assert(src.data != NULL && dst.data != NULL);
+		FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() ||
+			typeid(ushort).name() == typeid(_Tp).name() ||
+			typeid(float).name() == typeid(_Tp).name());
+	}
+
+	CvtColorStatic<CvtColorCode<code>::kind>::template run<code>(src, dst);
+
+	return 0;
+}
+
 } // namespace fbc
 #endif // FBC_CV_CVTCOLOR_HPP_
@@ -8,8 +8,15 @@
               modules/core/src/dxt.cpp
 */
 
+#include <string.h>
+#include <typeinfo>
+#include <memory>
+#include <vector>
 #include "core/mat.hpp"
 #include "core/core.hpp"
+#include "core/utility.hpp"
+#include "core/lru_cache.hpp"
+#include "core/parallel.hpp"
 
 namespace fbc {
 
@@ -88,6 +95,12 @@ static const double DFTTab[][2] =
 
 enum { DFT_NO_PERMUTE = 256, DFT_COMPLEX_INPUT_OR_OUTPUT = 512 };
 
+// the number of elements of the rows (or the columns) transformed by a thread at least
+const int DFT_STRIPE_ELEMS = 1 << 15;
+
+template<typename _Tp, int chs1, int chs2> class DFTPlan;
+template<typename _Tp, int chs1, int chs2> class DFTPlanCache;
+
 // Performs a forward or inverse Discrete Fourier transform of a 1D or 2D floating-point array
 /*
 The function performs one of the following :
@@ -103,46 +116,134 @@ The function performs one of the following :
     \f[\begin{ array }{l} X'=  \left (F^{(M)} \right )^*  \cdot Y  \cdot \left (F^{(N)} \right )^* \\ X =  \frac{1}{M \cdot N} \cdot X' \end{ array }\f]
 */
 // support type: float, multi-channels
+// the factorizations and the twiddle factors are taken from a small LRU cache of dft plans, so transforming
+// a stream of images of a fixed size computes them only once; the rows and the columns are transformed in parallel
+template<typename _Tp, int chs1, int chs2>
+int dft(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst, int flags = 0, int nonzero_rows = 0)
+{
+	FBC_Assert(typeid(float).name() == typeid(_Tp).name());
+
+	std::shared_ptr<const DFTPlan<_Tp, chs1, chs2>> plan = DFTPlanCache<_Tp, chs1, chs2>::getInstance().get(src.size(), flags);
+
+	return plan->apply(src, dst, nonzero_rows);
+}
+
+// Performs the same transform of several images of the same size, e.g. the frames of a batch
+// dst is resized to the number of the source images, its empty images are created
+// the images are spread over the threads by parallel_for_batch_
 template<typename _Tp, int chs1, int chs2>
-int dft(const Mat_<_Tp, chs1>& src0, Mat_<_Tp, chs2>& dst, int flags = 0, int nonzero_rows = 0)
+int dft(const std::vector<Mat_<_Tp, chs1>>& src, std::vector<Mat_<_Tp, chs2>>& dst, int flags = 0, int nonzero_rows = 0)
 {
 	FBC_Assert(typeid(float).name() == typeid(_Tp).name());
-	FBC_Assert(chs1 == 1 || chs1 == 2 || chs2 == 1 || chs2 == 2);
 
-	AutoBuffer<uchar> buf;
-	int prev_len = 0, stage = 0;
-	bool inv = (flags & DFT_INVERSE) != 0;
-	int nf = 0, real_transform = src0.channels == 1 || (inv && (flags & DFT_REAL_OUTPUT) != 0);
-	int elem_size = (int)src0.elemSize1(), complex_elem_size = elem_size * 2;
+	dst.resize(src.size());
+	if (src.empty())
+		return 0;
+
+	for (size_t i = 1; i < src.size(); i++)
+		FBC_Assert(src[i].size() == src[0].size());
+
+	std::shared_ptr<const DFTPlan<_Tp, chs1, chs2>> plan = DFTPlanCache<_Tp, chs1, chs2>::getInstance().get(src[0].size(), flags);
+
+	parallel_for_batch_((int)src.size(), [&](int i) {
+		plan->apply(src[i], dst[i], nonzero_rows);
+	});
+
+	return 0;
+}
+
+// The factorization of the length, the twiddle factors and the permutation table of a 1D transform
+template<typename _Tp>
+struct DFTTables {
+	DFTTables() : len(0), nf(0), inplace(false), bufSize(0) {}
+
+	// inv_itab: the permutation of the inverse real transform of the rows
+	void init(int _len, int inv_itab)
+	{
+		len = _len;
+		nf = DFTFactorize<dump>(len, factors);
+		inplace = factors[0] == factors[nf - 1];
+
+		wave.assign(len, Complex<_Tp>());
+		itab.assign(len, 0);
+		DFTInit<dump>(len, nf, factors, &itab[0], (int)sizeof(Complex<_Tp>), &wave[0], inv_itab);
+
+		// DFT_32f needs a buffer for an odd factor greater than 5
+		int i = nf > 1 && (factors[0] & 1) == 0;
+		bufSize = ((factors[i] & 1) != 0 && factors[i] > 5) ? (factors[i] + 1) * (int)sizeof(Complex<_Tp>) : 0;
+	}
+
+	int len, nf;
 	int factors[34];
-	bool inplace_transform = false;
+	bool inplace; // the permutation is done in place
+	std::vector<Complex<_Tp>> wave;
+	std::vector<int> itab;
+	int bufSize;
+};
 
-	if (!inv && src0.channels == 1 && (flags & DFT_COMPLEX_OUTPUT)) {
-		FBC_Assert(chs2 == 2);
+// Precomputed discrete Fourier transform of a fixed size
+// the plan holds the tables of the row and the column transforms of (size, flags), it is immutable
+// after the construction and apply() can be called from several threads at the same time
+//	DFTPlan<float, 1, 2> plan(Size(width, height), DFT_COMPLEX_OUTPUT);
+//	for (;;) { ...; plan.apply(frame, spectrum); }
+template<typename _Tp, int chs1, int chs2>
+class DFTPlan {
+public:
+	// size: the size of the source images, flags: the flags of dft()
+	DFTPlan(Size size, int flags = 0);
+
+	// transforms src to dst, src must have the planned size, dst is created if it is empty
+	int apply(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst, int nonzero_rows = 0) const;
+
+	Size srcSize() const { return ssize; }
+	int flags() const { return dftflags; }
+
+private:
+	Size ssize;
+	int dftflags;
+	bool inv, real_transform;
+	DFTTables<_Tp> rowTab, colTab;
+};
 
-		if (dst.empty()) {
-			dst = Mat_<_Tp, chs2>(src0.rows, src0.cols);
-		} else {
-			FBC_Assert(src0.rows == dst.rows && src0.cols == dst.cols);
-		}
-	} else if (inv && src0.channels == 2 && (flags & DFT_REAL_OUTPUT)) {
-		FBC_Assert(chs2 == 1);
+template<typename _Tp, int chs1, int chs2>
+DFTPlan<_Tp, chs1, chs2>::DFTPlan(Size size, int flags) : ssize(size), dftflags(flags)
+{
+	FBC_Assert(typeid(float).name() == typeid(_Tp).name());
+	FBC_Assert((chs1 == 1 || chs1 == 2) && (chs2 == 1 || chs2 == 2));
+	FBC_Assert(size.width > 0 && size.height > 0);
 
-		if (dst.empty()) {
-			dst = Mat_<_Tp, chs2>(src0.rows, src0.cols);
-		} else {
-			FBC_Assert(src0.rows == dst.rows && src0.cols == dst.cols);
-		}
-	} else {
+	inv = (flags & DFT_INVERSE) != 0;
+	real_transform = chs1 == 1 || (inv && (flags & DFT_REAL_OUTPUT) != 0);
+
+	if (!inv && chs1 == 1 && (flags & DFT_COMPLEX_OUTPUT))
+		FBC_Assert(chs2 == 2);
+	else if (inv && chs1 == 2 && (flags & DFT_REAL_OUTPUT))
+		FBC_Assert(chs2 == 1);
+	else
 		FBC_Assert(chs2 == chs1);
 
-		if (dst.empty()) {
-			dst = Mat_<_Tp, chs2>(src0.rows, src0.cols);
-		} else {
-			FBC_Assert(src0.rows == dst.rows && src0.cols == dst.cols);
-		}
+	// a single column is transformed as a row (or as a column when it is not continuous)
+	bool column_vector = size.width == 1 && !(flags & DFT_ROWS);
+	rowTab.init(column_vector ? size.height : size.width, inv && real_transform);
+	if (!(flags & DFT_ROWS) && size.height > 1)
+		colTab.init(size.height, 0);
+}
+
+template<typename _Tp, int chs1, int chs2>
+int DFTPlan<_Tp, chs1, chs2>::apply(const Mat_<_Tp, chs1>& src0, Mat_<_Tp, chs2>& dst, int nonzero_rows) const
+{
+	FBC_Assert(src0.rows == ssize.height && src0.cols == ssize.width);
+
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs2>(src0.rows, src0.cols);
+	} else {
+		FBC_Assert(src0.rows == dst.rows && src0.cols == dst.cols);
 	}
 
+	int flags = dftflags;
+	int elem_size = (int)sizeof(_Tp), complex_elem_size = elem_size * 2;
+	int stage = 0;
+
 	if (!real_transform)
 		elem_size = complex_elem_size;
 
@@ -158,77 +259,34 @@ int dft(const Mat_<_Tp, chs1>& src0, Mat_<_Tp, chs2>& dst, int flags = 0, int no
 		(src0.cols > 1 && inv && real_transform)))
 		stage = 1;
 
-	Mat_<_Tp, chs1> src = src0;
+	// the source of the second stage is dst
+	const uchar* sdata = src0.ptr();
+	size_t sstep = src0.step;
+	int src_channels = chs1;
+	int rows = src0.rows, cols = src0.cols;
+
 	for (;;) {
 		double scale = 1;
-		uchar* wave = 0;
-		int* itab = 0;
-		uchar* ptr;
-		int i, len, count, sz = 0;
-		int use_buf = 0, odd_real = 0;
+		int len, count;
 
 		if (stage == 0) { // row-wise transform
-			len = !inv ? src.cols : dst.cols;
-			count = src.rows;
+			const DFTTables<_Tp>& tab = rowTab;
+			len = cols;
+			count = rows;
 			if (len == 1 && !(flags & DFT_ROWS)) {
-				len = !inv ? src.rows : dst.rows;
+				len = rows;
 				count = 1;
 			}
-			odd_real = real_transform && (len & 1);
-		} else {
-			len = dst.rows;
-			count = !inv ? src0.cols : dst.cols;
-			sz = 2 * len*complex_elem_size;
-		}
-
-		void *spec = 0;
-
-		{
-			if (len != prev_len)
-				nf = DFTFactorize<dump>(len, factors);
-
-			inplace_transform = factors[0] == factors[nf - 1];
-			sz += len*(complex_elem_size + sizeof(int));
-			i = nf > 1 && (factors[0] & 1) == 0;
-			if ((factors[i] & 1) != 0 && factors[i] > 5)
-				sz += (factors[i] + 1)*complex_elem_size;
-
-			if ((stage == 0 && ((src.data == dst.data && !inplace_transform) || odd_real)) ||
-				(stage == 1 && !inplace_transform)) {
-				use_buf = 1;
-				sz += len*complex_elem_size;
-			}
-		}
+			FBC_Assert(len == tab.len);
 
-		ptr = (uchar*)buf;
-		buf.allocate(sz + 32);
-		if (ptr != (uchar*)buf)
-			prev_len = 0; // because we release the buffer,
-		// force recalculation of twiddle factors and permutation table
-		ptr = (uchar*)buf;
-		if (!spec) {
-			wave = ptr;
-			ptr += len*complex_elem_size;
-			itab = (int*)ptr;
-			ptr = (uchar*)fbcAlignPtr<dump>(ptr + len*sizeof(int), 16);
-
-			if (len != prev_len || (!inplace_transform && inv && real_transform))
-				DFTInit<dump>(len, nf, factors, itab, complex_elem_size, wave, stage == 0 && inv && real_transform);
-			// otherwise reuse the tables calculated on the previous stage
-		}
-
-		if (stage == 0) {
-			uchar* tmp_buf = 0;
+			int odd_real = real_transform && (len & 1);
+			int use_buf = (sdata == dst.ptr() && !tab.inplace) || odd_real;
 			int dptr_offset = 0;
 			int dst_full_len = len*elem_size;
-			int _flags = (int)inv + (src.channels != dst.channels ? DFT_COMPLEX_INPUT_OR_OUTPUT : 0);
+			int _flags = (int)inv + (src_channels != chs2 ? DFT_COMPLEX_INPUT_OR_OUTPUT : 0);
 
-			if (use_buf) {
-				tmp_buf = ptr;
-				ptr += len*complex_elem_size;
-				if (odd_real && !inv && len > 1 && !(_flags & DFT_COMPLEX_INPUT_OR_OUTPUT))
-					dptr_offset = elem_size;
-			}
+			if (use_buf && odd_real && !inv && len > 1 && !(_flags & DFT_COMPLEX_INPUT_OR_OUTPUT))
+				dptr_offset = elem_size;
 
 			if (!inv && (_flags & DFT_COMPLEX_INPUT_OR_OUTPUT))
 				dst_full_len += (len & 1) ? elem_size : complex_elem_size;
@@ -241,152 +299,232 @@ int dft(const Mat_<_Tp, chs1>& src0, Mat_<_Tp, chs2>& dst, int flags = 0, int no
 			if (nonzero_rows <= 0 || nonzero_rows > count)
 				nonzero_rows = count;
 
-			for (i = 0; i < nonzero_rows; i++) {
-				const uchar* sptr = src.ptr(i);
-				uchar* dptr0 = dst.ptr(i);
-				uchar* dptr = dptr0;
+			parallel_for_(Range(0, nonzero_rows), [&](const Range& range) {
+				// the work buffers of the thread, the factors are modified temporarily by the real transforms
+				AutoBuffer<uchar> buf((use_buf ? len*complex_elem_size : 0) + tab.bufSize + 48);
+				uchar* ptr = (uchar*)fbcAlignPtr<dump>((uchar*)buf, 16);
+				uchar* tmp_buf = 0;
+				int factors[34];
+				memcpy(factors, tab.factors, sizeof(factors));
+
+				if (use_buf) {
+					tmp_buf = ptr;
+					ptr += len*complex_elem_size;
+				}
 
-				if (tmp_buf)
-					dptr = tmp_buf;
+				const Complex<_Tp>* wave = &tab.wave[0];
+				const int* itab = &tab.itab[0];
+				int nf = tab.nf;
 
-				if (!real_transform) {
-					DFT_32f<_Tp>(static_cast<const Complex<_Tp>*>((void*)sptr), static_cast<Complex<_Tp>*>((void*)dptr), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<float>*>((void*)ptr), _flags, scale);
-				} else if (!inv) {
-					RealDFT_32f<_Tp>(static_cast<const _Tp*>((void*)sptr), static_cast<_Tp*>((void*)dptr), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), _flags, scale);
-				} else if (inv) {
-					CCSIDFT_32f<_Tp>(static_cast<const _Tp*>((void*)sptr), static_cast<_Tp*>((void*)dptr), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), _flags, scale);
-				} else {
-					FBC_Error("no support type");
-				}
+				for (int i = range.start; i < range.end; i++) {
+					const uchar* sptr = sdata + i*sstep;
+					uchar* dptr0 = dst.ptr(i);
+					uchar* dptr = dptr0;
 
-				if (dptr != dptr0)
-					memcpy(dptr0, dptr + dptr_offset, dst_full_len);
-			}
+					if (tmp_buf)
+						dptr = tmp_buf;
+
+					if (!real_transform) {
+						DFT_32f<_Tp>((const Complex<_Tp>*)sptr, (Complex<_Tp>*)dptr, len, nf, factors, itab, wave, len, 0, (Complex<_Tp>*)ptr, _flags, scale);
+					} else if (!inv) {
+						RealDFT_32f<_Tp>((const _Tp*)sptr, (_Tp*)dptr, len, nf, factors, itab, wave, len, 0, (Complex<_Tp>*)ptr, _flags, scale);
+					} else {
+						CCSIDFT_32f<_Tp>((const _Tp*)sptr, (_Tp*)dptr, len, nf, factors, itab, wave, len, 0, (Complex<_Tp>*)ptr, _flags, scale);
+					}
 
-			for (; i < count; i++) {
+					if (dptr != dptr0)
+						memcpy(dptr0, dptr + dptr_offset, dst_full_len);
+				}
+			}, (double)len * nonzero_rows / DFT_STRIPE_ELEMS);
+
+			for (int i = nonzero_rows; i < count; i++) {
 				uchar* dptr0 = dst.ptr(i);
 				memset(dptr0, 0, dst_full_len);
 			}
 
 			if (stage != 1) {
-				if (!inv && real_transform && dst.channels == 2)
-					complementComplexOutput(dst, nonzero_rows, 1);
+				if (!inv && real_transform && chs2 == 2) {
+					if (len != cols) {
+						// a continuous column vector is transformed as a single row
+						Mat_<_Tp, chs2> row(1, len, dst.ptr());
+						complementComplexOutput(row, 1, 1);
+					} else {
+						complementComplexOutput(dst, nonzero_rows, 1);
+					}
+				}
 				break;
 			}
-
-			src = dst;
 		} else {
-			int a = 0, b = count;
-			uchar *buf0, *buf1, *dbuf0, *dbuf1;
-			const uchar* sptr0 = src.ptr();
+			const DFTTables<_Tp>& tab = colTab;
+			len = rows;
+			count = !inv ? cols : dst.cols;
+			FBC_Assert(len == tab.len);
+
+			int use_buf = !tab.inplace;
+			int a = 0, b = count, even = 0;
+			const uchar* sptr0 = sdata;
 			uchar* dptr0 = dst.ptr();
-			buf0 = ptr;
-			ptr += len*complex_elem_size;
-			buf1 = ptr;
-			ptr += len*complex_elem_size;
-			dbuf0 = buf0, dbuf1 = buf1;
-
-			if (use_buf) {
-				dbuf1 = ptr;
-				dbuf0 = buf1;
-				ptr += len*complex_elem_size;
-			}
 
-			if (real_transform && inv && src.cols > 1)
+			if (real_transform && inv && cols > 1)
 				stage = 0;
 			else if (flags & FBC_DXT_SCALE)
 				scale = 1. / (len * count);
 
+			// the columns are transformed by pairs, copied to and from the buffers of a thread
+			struct ColumnBuffers {
+				ColumnBuffers(const DFTTables<_Tp>& tab, int use_buf) : buf(len_bytes(tab, use_buf))
+				{
+					int size = tab.len * (int)sizeof(Complex<_Tp>);
+					uchar* ptr = (uchar*)fbcAlignPtr<dump>((uchar*)buf, 16);
+					buf0 = ptr;
+					ptr += size;
+					buf1 = ptr;
+					ptr += size;
+					dbuf0 = buf0, dbuf1 = buf1;
+					if (use_buf) {
+						dbuf1 = ptr;
+						dbuf0 = buf1;
+						ptr += size;
+					}
+					work = ptr;
+					memcpy(factors, tab.factors, sizeof(factors));
+				}
+				static size_t len_bytes(const DFTTables<_Tp>& tab, int use_buf) { return (2 + use_buf) * tab.len * sizeof(Complex<_Tp>) + tab.bufSize + 48; }
+
+				AutoBuffer<uchar> buf;
+				uchar *buf0, *buf1, *dbuf0, *dbuf1, *work;
+				int factors[34];
+			};
+
+			const Complex<_Tp>* wave = &tab.wave[0];
+			const int* itab = &tab.itab[0];
+			int nf = tab.nf;
+
 			if (real_transform) {
-				int even;
+				// the first and the last (for an even count) columns are real
+				ColumnBuffers cb(tab, use_buf);
 				a = 1;
 				even = (count & 1) == 0;
 				b = (count + 1) / 2;
 				if (!inv) {
-					memset(buf0, 0, len*complex_elem_size);
-					CopyColumn<dump>(sptr0, src.step, buf0, complex_elem_size, len, elem_size);
-					sptr0 += dst.channels*elem_size;
+					memset(cb.buf0, 0, len*complex_elem_size);
+					CopyColumn<dump>(sptr0, sstep, cb.buf0, complex_elem_size, len, elem_size);
+					sptr0 += chs2*elem_size;
 					if (even) {
-						memset(buf1, 0, len*complex_elem_size);
-						CopyColumn<dump>(sptr0 + (count - 2)*elem_size, src.step, buf1, complex_elem_size, len, elem_size);
+						memset(cb.buf1, 0, len*complex_elem_size);
+						CopyColumn<dump>(sptr0 + (count - 2)*elem_size, sstep, cb.buf1, complex_elem_size, len, elem_size);
 					}
-				} else if (src.channels == 1) {
-					CopyColumn<dump>(sptr0, src.step, buf0, elem_size, len, elem_size);
-					ExpandCCS<dump>(buf0, len, elem_size);
+				} else if (src_channels == 1) {
+					CopyColumn<dump>(sptr0, sstep, cb.buf0, elem_size, len, elem_size);
+					ExpandCCS<dump>(cb.buf0, len, elem_size);
 					if (even) {
-						CopyColumn<dump>(sptr0 + (count - 1)*elem_size, src.step, buf1, elem_size, len, elem_size);
-						ExpandCCS<dump>(buf1, len, elem_size);
+						CopyColumn<dump>(sptr0 + (count - 1)*elem_size, sstep, cb.buf1, elem_size, len, elem_size);
+						ExpandCCS<dump>(cb.buf1, len, elem_size);
 					}
 					sptr0 += elem_size;
 				} else {
-					CopyColumn<dump>(sptr0, src.step, buf0, complex_elem_size, len, complex_elem_size);
+					CopyColumn<dump>(sptr0, sstep, cb.buf0, complex_elem_size, len, complex_elem_size);
 					if (even) {
-						CopyColumn<dump>(sptr0 + b*complex_elem_size, src.step, buf1, complex_elem_size, len, complex_elem_size);
+						CopyColumn<dump>(sptr0 + b*complex_elem_size, sstep, cb.buf1, complex_elem_size, len, complex_elem_size);
 					}
 					sptr0 += complex_elem_size;
 				}
 
 				if (even)
-					DFT_32f<_Tp>(static_cast<const Complex<_Tp>*>((void*)buf1), static_cast<Complex<_Tp>*>((void*)dbuf1), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), inv, scale);
-				DFT_32f<_Tp>(static_cast<const Complex<_Tp>*>((void*)buf0), static_cast<Complex<_Tp>*>((void*)dbuf0), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), inv, scale);
+					DFT_32f<_Tp>((const Complex<_Tp>*)cb.buf1, (Complex<_Tp>*)cb.dbuf1, len, nf, cb.factors, itab, wave, len, 0, (Complex<_Tp>*)cb.work, inv, scale);
+				DFT_32f<_Tp>((const Complex<_Tp>*)cb.buf0, (Complex<_Tp>*)cb.dbuf0, len, nf, cb.factors, itab, wave, len, 0, (Complex<_Tp>*)cb.work, inv, scale);
 
-				if (dst.channels == 1) {
+				if (chs2 == 1) {
 					if (!inv) {
 						// copy the half of output vector to the first/last column.
 						// before doing that, defgragment the vector
-						memcpy(dbuf0 + elem_size, dbuf0, elem_size);
-						CopyColumn<dump>(dbuf0 + elem_size, elem_size, dptr0, dst.step, len, elem_size);
+						memcpy(cb.dbuf0 + elem_size, cb.dbuf0, elem_size);
+						CopyColumn<dump>(cb.dbuf0 + elem_size, elem_size, dptr0, dst.step, len, elem_size);
 						if (even) {
-							memcpy(dbuf1 + elem_size, dbuf1, elem_size);
-							CopyColumn<dump>(dbuf1 + elem_size, elem_size, dptr0 + (count - 1)*elem_size, dst.step, len, elem_size);
+							memcpy(cb.dbuf1 + elem_size, cb.dbuf1, elem_size);
+							CopyColumn<dump>(cb.dbuf1 + elem_size, elem_size, dptr0 + (count - 1)*elem_size, dst.step, len, elem_size);
 						}
 						dptr0 += elem_size;
 					} else {
 						// copy the real part of the complex vector to the first/last column
-						CopyColumn<dump>(dbuf0, complex_elem_size, dptr0, dst.step, len, elem_size);
+						CopyColumn<dump>(cb.dbuf0, complex_elem_size, dptr0, dst.step, len, elem_size);
 						if (even)
-							CopyColumn<dump>(dbuf1, complex_elem_size, dptr0 + (count - 1)*elem_size, dst.step, len, elem_size);
+							CopyColumn<dump>(cb.dbuf1, complex_elem_size, dptr0 + (count - 1)*elem_size, dst.step, len, elem_size);
 						dptr0 += elem_size;
 					}
 				} else {
 					assert(!inv);
-					CopyColumn<dump>(dbuf0, complex_elem_size, dptr0, dst.step, len, complex_elem_size);
+					CopyColumn<dump>(cb.dbuf0, complex_elem_size, dptr0, dst.step, len, complex_elem_size);
 					if (even)
-						CopyColumn<dump>(dbuf1, complex_elem_size, dptr0 + b*complex_elem_size, dst.step, len, complex_elem_size);
+						CopyColumn<dump>(cb.dbuf1, complex_elem_size, dptr0 + b*complex_elem_size, dst.step, len, complex_elem_size);
 					dptr0 += complex_elem_size;
 				}
 			}
 
-			for (i = a; i < b; i += 2) {
-				if (i + 1 < b) {
-					CopyFrom2Columns<dump>(sptr0, src.step, buf0, buf1, len, complex_elem_size);
-					DFT_32f<_Tp>(static_cast<const Complex<_Tp>*>((void*)buf1), static_cast<Complex<_Tp>*>((void*)dbuf1), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), inv, scale);
-				} else
-					CopyColumn<dump>(sptr0, src.step, buf0, complex_elem_size, len, complex_elem_size);
-
-				DFT_32f<_Tp>(static_cast<const Complex<_Tp>*>((void*)buf0), static_cast<Complex<_Tp>*>((void*)dbuf0), len, nf, factors, itab, static_cast<const Complex<_Tp>*>((void*)wave), len, spec, static_cast<Complex<_Tp>*>((void*)ptr), inv, scale);
-
-				if (i + 1 < b)
-					CopyTo2Columns<dump>(dbuf0, dbuf1, dptr0, dst.step, len, complex_elem_size);
-				else
-					CopyColumn<dump>(dbuf0, complex_elem_size, dptr0, dst.step, len, complex_elem_size);
-				sptr0 += 2 * complex_elem_size;
-				dptr0 += 2 * complex_elem_size;
-			}
+			// the pairs of the complex columns [a, b)
+			parallel_for_(Range(0, (b - a + 1) / 2), [&](const Range& range) {
+				ColumnBuffers cb(tab, use_buf);
+
+				for (int k = range.start; k < range.end; k++) {
+					int i = a + k * 2;
+					const uchar* sptr = sptr0 + (size_t)k * 2 * complex_elem_size;
+					uchar* dptr = dptr0 + (size_t)k * 2 * complex_elem_size;
+
+					if (i + 1 < b) {
+						CopyFrom2Columns<dump>(sptr, sstep, cb.buf0, cb.buf1, len, complex_elem_size);
+						DFT_32f<_Tp>((const Complex<_Tp>*)cb.buf1, (Complex<_Tp>*)cb.dbuf1, len, nf, cb.factors, itab, wave, len, 0, (Complex<_Tp>*)cb.work, inv, scale);
+					} else
+						CopyColumn<dump>(sptr, sstep, cb.buf0, complex_elem_size, len, complex_elem_size);
+
+					DFT_32f<_Tp>((const Complex<_Tp>*)cb.buf0, (Complex<_Tp>*)cb.dbuf0, len, nf, cb.factors, itab, wave, len, 0, (Complex<_Tp>*)cb.work, inv, scale);
+
+					if (i + 1 < b)
+						CopyTo2Columns<dump>(cb.dbuf0, cb.dbuf1, dptr, dst.step, len, complex_elem_size);
+					else
+						CopyColumn<dump>(cb.dbuf0, complex_elem_size, dptr, dst.step, len, complex_elem_size);
+				}
+			}, (double)len * (b - a) / DFT_STRIPE_ELEMS);
 
 			if (stage != 0) {
-				if (!inv && real_transform && dst.channels == 2 && len > 1)
+				if (!inv && real_transform && chs2 == 2 && len > 1)
 					complementComplexOutput(dst, len, 2);
 				break;
 			}
-
-			src = dst;
 		}
+
+		sdata = dst.ptr();
+		sstep = dst.step;
+		src_channels = chs2;
 	}
 
 	return 0;
 }
 
+// LRU cache of the dft plans used by dft(), one cache per image type
+template<typename _Tp, int chs1, int chs2>
+class DFTPlanCache {
+public:
+	static DFTPlanCache& getInstance()
+	{
+		static DFTPlanCache cache;
+		return cache;
+	}
+
+	std::shared_ptr<const DFTPlan<_Tp, chs1, chs2>> get(Size size, int flags)
+	{
+		return plans.get([&](const DFTPlan<_Tp, chs1, chs2>& plan) { return plan.srcSize() == size && plan.flags() == flags; },
+			[&]() { return std::make_shared<const DFTPlan<_Tp, chs1, chs2>>(size, flags); });
+	}
+
+	void clear() { plans.clear(); }
+
+private:
+	// the forward and the inverse transforms of a few sizes, a plan of 1024x1024 holds about 24KB of tables
+	static const int DFT_PLAN_CACHE_SIZE = 16;
+
+	LRUCache<DFTPlan<_Tp, chs1, chs2>, DFT_PLAN_CACHE_SIZE> plans;
+};
+
 template<typename T> struct DFT_VecR4
 {
 	int operator()(Complex<T>*, int, int, int&, const Complex<T>*) const { return 1; }
@@ -1346,7 +1484,7 @@ static void DFTInit(int n0, int nf, int* factors, int* itab, int elem_size, void
 template<typename _Tp, int chs1, int chs2>
 int idft(const Mat_<_Tp, chs1>& src, Mat_<_Tp, chs2>& dst, int flags = 0, int nonzero_rows = 0)
 {
-	dft(src, dst, flags | DFT_INVERSE, nonzero_rows);
+	return dft(src, dst, flags | DFT_INVERSE, nonzero_rows);
 }
 
 } // namespace fbc
@@ -26,63 +26,7 @@ template<typename _Tp, int chs>
 int erode(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, const Mat_<uchar, 1>& kernel,
 	Point anchor = Point(-1, -1), int iterations = 1, int borderType = BORDER_CONSTANT, const Scalar& borderValue = Scalar::all(DBL_MAX))
 {
-	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
-	if (dst.empty()) {
-		dst = Mat_<_Tp, chs>(src.rows, src.cols);
-	} else {
-		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
-	}
-
-	Size ksize = !kernel.empty() ? kernel.size() : Size(3, 3);
-	anchor = normalizeAnchor(anchor, ksize);
-
-	if (iterations == 0 || kernel.rows * kernel.cols == 1) {
-		src.copyTo(dst);
-		return 0;
-	}
-
-	Mat_<uchar, 1> kernel_ = kernel;
-	if (kernel_.empty()) {
-		kernel_ = Mat_<uchar, 1>(1 + iterations * 2, 1 + iterations * 2);
-		getStructuringElement(kernel_, MORPH_RECT, Size(1 + iterations * 2, 1 + iterations * 2));
-		anchor = Point(iterations, iterations);
-		iterations = 1;
-	} else if (iterations > 1 && countNonZero(kernel_) == kernel_.rows * kernel_.cols) {
-		anchor = Point(anchor.x*iterations, anchor.y*iterations);
-		kernel_ = Mat_<uchar, 1>(ksize.height + (iterations - 1)*(ksize.height - 1), ksize.width + (iterations - 1)*(ksize.width - 1));
-		getStructuringElement(kernel_, MORPH_RECT,
-			Size(ksize.width + (iterations - 1)*(ksize.width - 1), ksize.height + (iterations - 1)*(ksize.height - 1)), anchor);
-		iterations = 1;
-	}
-
-	anchor = normalizeAnchor(anchor, kernel_.size());
-
-	Ptr<BaseRowFilter> rowFilter;
-	Ptr<BaseColumnFilter> columnFilter;
-	Ptr<BaseFilter> filter2D;
-
-	if (countNonZero(kernel_) == kernel_.rows*kernel_.cols) {
-		// rectangular structuring element
-		rowFilter = getMorphologyRowFilter<_Tp, chs>(0, kernel_.cols, anchor.x);
-		columnFilter = getMorphologyColumnFilter<_Tp, chs>(0, kernel_.rows, anchor.y);
-	} else {
-		filter2D = getMorphologyFilter<_Tp, chs>(0, kernel_, anchor);
-	}
-
-	Scalar borderValue_ = borderValue;
-	if (borderType == BORDER_CONSTANT && borderValue_ == Scalar::all(DBL_MAX)) {
-		if (sizeof(_Tp) == 1) // CV_8U
-			borderValue_ = Scalar::all((double)UCHAR_MAX);
-		else // CV_32F
-			borderValue_ = Scalar::all((double)FLT_MAX);
-	}
-
-	Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>> f = makePtr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>>(filter2D, rowFilter, columnFilter, borderType, borderType, borderValue_);
-	f->apply(src, dst);
-	for (int i = 1; i < iterations; i++)
-		f->apply(dst, dst);
-
-	return 0;
+	return morphOp(MORPH_ERODE, src, dst, kernel, anchor, iterations, borderType, borderValue);
 }
 
 } // namespace fbc
@@ -0,0 +1,681 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_FILTER_HPP_
+#define FBC_CV_FILTER_HPP_
+
+/* reference: modules/imgproc/src/filterengine.hpp
+              modules/imgproc/src/filter.cpp
+*/
+
+#include <float.h>
+#include <math.h>
+#include <typeinfo>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/Ptr.hpp"
+#include "core/saturate.hpp"
+#include "core/hal.hpp"
+#include "imgproc.hpp"
+#include "filterengine.hpp"
+
+namespace fbc {
+
+// the coefficients of a 1D kernel, a single row or a single column
+template<typename _Tp>
+void getKernelCoeffs(const Mat_<float, 1>& kernel, std::vector<_Tp>& coeffs)
+{
+	FBC_Assert(kernel.rows == 1 || kernel.cols == 1);
+	int n = kernel.rows + kernel.cols - 1;
+
+	coeffs.resize(n);
+	for (int i = 0; i < n; i++)
+		coeffs[i] = (_Tp)(kernel.rows == 1 ? ((const float*)kernel.ptr(0))[i] : ((const float*)kernel.ptr(i))[0]);
+}
+
+// returns the type of the kernel, a combination of KERNEL_*; the symmetry is only checked for a 1D kernel
+// with the anchor at the center
+inline int getKernelType(const Mat_<float, 1>& kernel, Point anchor)
+{
+	int i, sz = kernel.rows * kernel.cols;
+	std::vector<double> coeffs(sz);
+	for (i = 0; i < sz; i++)
+		coeffs[i] = ((const float*)kernel.ptr(i / kernel.cols))[i % kernel.cols];
+
+	double sum = 0;
+	int type = KERNEL_SMOOTH + KERNEL_INTEGER;
+	if ((kernel.rows == 1 || kernel.cols == 1) && anchor.x * 2 + 1 == kernel.cols && anchor.y * 2 + 1 == kernel.rows)
+		type |= (KERNEL_SYMMETRICAL + KERNEL_ASYMMETRICAL);
+
+	for (i = 0; i < sz; i++) {
+		double a = coeffs[i], b = coeffs[sz - i - 1];
+		if (a != b)
+			type &= ~KERNEL_SYMMETRICAL;
+		if (a != -b)
+			type &= ~KERNEL_ASYMMETRICAL;
+		if (a < 0)
+			type &= ~KERNEL_SMOOTH;
+		if (a != saturate_cast<int>(a))
+			type &= ~KERNEL_INTEGER;
+		sum += a;
+	}
+
+	if (fabs(sum - 1) > FLT_EPSILON*(fabs(sum) + 1))
+		type &= ~KERNEL_SMOOTH;
+
+	return type;
+}
+
+// the cast of the fixed-point sums of the column filters: bits is the number of fractional bits
+template<typename ST, typename DT> struct FixedPtCastEx
+{
+	typedef ST type1;
+	typedef DT rtype;
+
+	FixedPtCastEx() : SHIFT(0), DELTA(0) {}
+	FixedPtCastEx(int bits) : SHIFT(bits), DELTA(bits ? 1 << (bits - 1) : 0) {}
+	DT operator()(ST val) const { return saturate_cast<DT>((val + DELTA) >> SHIFT); }
+
+	int SHIFT, DELTA;
+};
+
+struct RowNoVec
+{
+	int operator()(const uchar*, uchar*, int, int) const { return 0; }
+};
+
+struct ColumnNoVec
+{
+	int operator()(const uchar**, uchar*, int) const { return 0; }
+};
+
+// the optimized row pass of the 8-bit images with the fixed-point kernels (see hal::sepFilterRow8u32s)
+struct RowVec_8u32s
+{
+	RowVec_8u32s() : symmetry(0) {}
+	RowVec_8u32s(const std::vector<int>& _kernel, int symmetryType) : kernel(_kernel)
+	{
+		symmetry = (symmetryType & KERNEL_SYMMETRICAL) ? 1 : (symmetryType & KERNEL_ASYMMETRICAL) ? -1 : 0;
+	}
+
+	int operator()(const uchar* src, uchar* dst, int width, int cn) const
+	{
+		return hal::sepFilterRow8u32s(src, (int*)dst, width * cn, cn, &kernel[0], (int)kernel.size(), symmetry);
+	}
+
+	std::vector<int> kernel;
+	int symmetry;
+};
+
+// the optimized column pass of the 8-bit images with the fixed-point kernels (see hal::sepFilterColumn32s8u), it
+// computes in float with the kernel scaled back by 1 / (1 << bits)
+struct SymmColumnVec_32s8u
+{
+	SymmColumnVec_32s8u() : symmetrical(true), delta(0) {}
+	SymmColumnVec_32s8u(const std::vector<int>& _kernel, int symmetryType, int bits, double _delta)
+	{
+		FBC_Assert((symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL)) != 0);
+		symmetrical = (symmetryType & KERNEL_SYMMETRICAL) != 0;
+		kernel.resize(_kernel.size());
+		for (size_t i = 0; i < kernel.size(); i++)
+			kernel[i] = (float)(_kernel[i] * (1. / (1 << bits)));
+		delta = (float)(_delta / (1 << bits));
+	}
+
+	int operator()(const uchar** src, uchar* dst, int width) const
+	{
+		int ksize2 = (int)kernel.size() / 2;
+		return hal::sepFilterColumn32s8u((const int**)src, dst, width, &kernel[ksize2], ksize2, delta, symmetrical);
+	}
+
+	std::vector<float> kernel;
+	bool symmetrical;
+	float delta;
+};
+
+// the generic horizontal pass: D[i] = sum(kernel[k] * S[i + k * cn])
+template<typename ST, typename DT, class VecOp> struct RowFilter : public BaseRowFilter
+{
+	template<typename KT>
+	RowFilter(const std::vector<KT>& _kernel, int _anchor, const VecOp& _vecOp = VecOp()) : kernel(_kernel.begin(), _kernel.end()), vecOp(_vecOp)
+	{
+		anchor = _anchor;
+		ksize = (int)kernel.size();
+	}
+
+	void operator()(const uchar* src, uchar* dst, int width, int cn)
+	{
+		int _ksize = ksize;
+		const DT* kx = &kernel[0];
+		const ST* S;
+		DT* D = (DT*)dst;
+		int i, k;
+
+		i = vecOp(src, dst, width, cn);
+		width *= cn;
+
+		for (; i <= width - 4; i += 4) {
+			S = (const ST*)src + i;
+			DT f = kx[0];
+			DT s0 = f*S[0], s1 = f*S[1], s2 = f*S[2], s3 = f*S[3];
+
+			for (k = 1; k < _ksize; k++) {
+				S += cn;
+				f = kx[k];
+				s0 += f*S[0]; s1 += f*S[1];
+				s2 += f*S[2]; s3 += f*S[3];
+			}
+
+			D[i] = s0; D[i + 1] = s1;
+			D[i + 2] = s2; D[i + 3] = s3;
+		}
+
+		for (; i < width; i++) {
+			S = (const ST*)src + i;
+			DT s0 = kx[0] * S[0];
+			for (k = 1; k < _ksize; k++) {
+				S += cn;
+				s0 += kx[k] * S[0];
+			}
+			D[i] = s0;
+		}
+	}
+
+	std::vector<DT> kernel;
+	VecOp vecOp;
+};
+
+// the horizontal pass of the symmetrical or asymmetrical kernels of 1, 3 or 5 taps
+template<typename ST, typename DT, class VecOp> struct SymmRowSmallFilter : public RowFilter<ST, DT, VecOp>
+{
+	template<typename KT>
+	SymmRowSmallFilter(const std::vector<KT>& _kernel, int _anchor, int _symmetryType, const VecOp& _vecOp = VecOp())
+		: RowFilter<ST, DT, VecOp>(_kernel, _anchor, _vecOp)
+	{
+		symmetryType = _symmetryType;
+		FBC_Assert((symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL)) != 0 && this->ksize <= 5);
+	}
+
+	void operator()(const uchar* src, uchar* dst, int width, int cn)
+	{
+		int ksize2 = this->ksize / 2, ksize2n = ksize2*cn;
+		const DT* kx = &this->kernel[0] + ksize2;
+		bool symmetrical = (this->symmetryType & KERNEL_SYMMETRICAL) != 0;
+		DT* D = (DT*)dst;
+		int i = this->vecOp(src, dst, width, cn), j, k;
+		const ST* S = (const ST*)src + i + ksize2n;
+		width *= cn;
+
+		if (symmetrical) {
+			if (this->ksize == 1 && kx[0] == 1) {
+				for (; i <= width - 2; i += 2, S += 2) {
+					DT s0 = S[0], s1 = S[1];
+					D[i] = s0; D[i + 1] = s1;
+				}
+			} else if (this->ksize == 3) {
+				if (kx[0] == 2 && kx[1] == 1) {
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = S[-cn] + S[0] * 2 + S[cn], s1 = S[1 - cn] + S[1] * 2 + S[1 + cn];
+						D[i] = s0; D[i + 1] = s1;
+					}
+				} else if (kx[0] == -2 && kx[1] == 1) {
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = S[-cn] - S[0] * 2 + S[cn], s1 = S[1 - cn] - S[1] * 2 + S[1 + cn];
+						D[i] = s0; D[i + 1] = s1;
+					}
+				} else {
+					DT k0 = kx[0], k1 = kx[1];
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = S[0] * k0 + (S[-cn] + S[cn])*k1, s1 = S[1] * k0 + (S[1 - cn] + S[1 + cn])*k1;
+						D[i] = s0; D[i + 1] = s1;
+					}
+				}
+			} else if (this->ksize == 5) {
+				DT k0 = kx[0], k1 = kx[1], k2 = kx[2];
+				if (k0 == -2 && k1 == 0 && k2 == 1) {
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = -2 * S[0] + S[-cn * 2] + S[cn * 2];
+						DT s1 = -2 * S[1] + S[1 - cn * 2] + S[1 + cn * 2];
+						D[i] = s0; D[i + 1] = s1;
+					}
+				} else {
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = S[0] * k0 + (S[-cn] + S[cn])*k1 + (S[-cn * 2] + S[cn * 2])*k2;
+						DT s1 = S[1] * k0 + (S[1 - cn] + S[1 + cn])*k1 + (S[1 - cn * 2] + S[1 + cn * 2])*k2;
+						D[i] = s0; D[i + 1] = s1;
+					}
+				}
+			}
+
+			for (; i < width; i++, S++) {
+				DT s0 = kx[0] * S[0];
+				for (k = 1, j = cn; k <= ksize2; k++, j += cn)
+					s0 += kx[k] * (S[j] + S[-j]);
+				D[i] = s0;
+			}
+		} else {
+			if (this->ksize == 3) {
+				if (kx[0] == 0 && kx[1] == 1) {
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = S[cn] - S[-cn], s1 = S[1 + cn] - S[1 - cn];
+						D[i] = s0; D[i + 1] = s1;
+					}
+				} else {
+					DT k1 = kx[1];
+					for (; i <= width - 2; i += 2, S += 2) {
+						DT s0 = (S[cn] - S[-cn])*k1, s1 = (S[1 + cn] - S[1 - cn])*k1;
+						D[i] = s0; D[i + 1] = s1;
+					}
+				}
+			} else if (this->ksize == 5) {
+				DT k1 = kx[1], k2 = kx[2];
+				for (; i <= width - 2; i += 2, S += 2) {
+					DT s0 = (S[cn] - S[-cn])*k1 + (S[cn * 2] - S[-cn * 2])*k2;
+					DT s1 = (S[1 + cn] - S[1 - cn])*k1 + (S[1 + cn * 2] - S[1 - cn * 2])*k2;
+					D[i] = s0; D[i + 1] = s1;
+				}
+			}
+
+			for (; i < width; i++, S++) {
+				DT s0 = kx[0] * S[0];
+				for (k = 1, j = cn; k <= ksize2; k++, j += cn)
+					s0 += kx[k] * (S[j] - S[-j]);
+				D[i] = s0;
+			}
+		}
+	}
+
+	int symmetryType;
+};
+
+// the generic vertical pass: D[i] = castOp(sum(kernel[k] * src[k][i]) + delta)
+template<class CastOp, class VecOp> struct ColumnFilter : public BaseColumnFilter
+{
+	typedef typename CastOp::type1 ST;
+	typedef typename CastOp::rtype DT;
+
+	template<typename KT>
+	ColumnFilter(const std::vector<KT>& _kernel, int _anchor, double _delta, const CastOp& _castOp = CastOp(), const VecOp& _vecOp = VecOp())
+		: kernel(_kernel.begin(), _kernel.end()), castOp0(_castOp), vecOp(_vecOp)
+	{
+		anchor = _anchor;
+		ksize = (int)kernel.size();
+		delta = saturate_cast<ST>(_delta);
+	}
+
+	void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
+	{
+		const ST* ky = &kernel[0];
+		ST _delta = delta;
+		int _ksize = ksize;
+		int i, k;
+		CastOp castOp = castOp0;
+
+		for (; count--; dst += dststep, src++) {
+			DT* D = (DT*)dst;
+			i = vecOp(src, dst, width);
+
+			for (; i <= width - 4; i += 4) {
+				ST f = ky[0];
+				const ST* S = (const ST*)src[0] + i;
+				ST s0 = f*S[0] + _delta, s1 = f*S[1] + _delta, s2 = f*S[2] + _delta, s3 = f*S[3] + _delta;
+
+				for (k = 1; k < _ksize; k++) {
+					S = (const ST*)src[k] + i;
+					f = ky[k];
+					s0 += f*S[0]; s1 += f*S[1];
+					s2 += f*S[2]; s3 += f*S[3];
+				}
+
+				D[i] = castOp(s0); D[i + 1] = castOp(s1);
+				D[i + 2] = castOp(s2); D[i + 3] = castOp(s3);
+			}
+
+			for (; i < width; i++) {
+				ST s0 = ky[0] * ((const ST*)src[0])[i] + _delta;
+				for (k = 1; k < _ksize; k++)
+					s0 += ky[k] * ((const ST*)src[k])[i];
+				D[i] = castOp(s0);
+			}
+		}
+	}
+
+	std::vector<ST> kernel;
+	ST delta;
+	CastOp castOp0;
+	VecOp vecOp;
+};
+
+// the vertical pass of the symmetrical or asymmetrical kernels
+template<class CastOp, class VecOp> struct SymmColumnFilter : public ColumnFilter<CastOp, VecOp>
+{
+	typedef typename CastOp::type1 ST;
+	typedef typename CastOp::rtype DT;
+
+	template<typename KT>
+	SymmColumnFilter(const std::vector<KT>& _kernel, int _anchor, double _delta, int _symmetryType,
+		const CastOp& _castOp = CastOp(), const VecOp& _vecOp = VecOp())
+		: ColumnFilter<CastOp, VecOp>(_kernel, _anchor, _delta, _castOp, _vecOp)
+	{
+		symmetryType = _symmetryType;
+		FBC_Assert((symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL)) != 0);
+	}
+
+	void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
+	{
+		int ksize2 = this->ksize / 2;
+		const ST* ky = &this->kernel[0] + ksize2;
+		int i, k;
+		bool symmetrical = (symmetryType & KERNEL_SYMMETRICAL) != 0;
+		ST _delta = this->delta;
+		CastOp castOp = this->castOp0;
+		src += ksize2;
+
+		if (symmetrical) {
+			for (; count--; dst += dststep, src++) {
+				DT* D = (DT*)dst;
+				i = (this->vecOp)(src, dst, width);
+
+				for (; i <= width - 4; i += 4) {
+					ST f = ky[0];
+					const ST* S = (const ST*)src[0] + i, *S2;
+					ST s0 = f*S[0] + _delta, s1 = f*S[1] + _delta, s2 = f*S[2] + _delta, s3 = f*S[3] + _delta;
+
+					for (k = 1; k <= ksize2; k++) {
+						S = (const ST*)src[k] + i;
+						S2 = (const ST*)src[-k] + i;
+						f = ky[k];
+						s0 += f*(S[0] + S2[0]);
+						s1 += f*(S[1] + S2[1]);
+						s2 += f*(S[2] + S2[2]);
+						s3 += f*(S[3] + S2[3]);
+					}
+
+					D[i] = castOp(s0); D[i + 1] = castOp(s1);
+					D[i + 2] = castOp(s2); D[i + 3] = castOp(s3);
+				}
+
+				for (; i < width; i++) {
+					ST s0 = ky[0] * ((const ST*)src[0])[i] + _delta;
+					for (k = 1; k <= ksize2; k++)
+						s0 += ky[k] * (((const ST*)src[k])[i] + ((const ST*)src[-k])[i]);
+					D[i] = castOp(s0);
+				}
+			}
+		} else {
+			for (; count--; dst += dststep, src++) {
+				DT* D = (DT*)dst;
+				i = this->vecOp(src, dst, width);
+
+				for (; i <= width - 4; i += 4) {
+					ST f;
+					const ST *S, *S2;
+					ST s0 = _delta, s1 = _delta, s2 = _delta, s3 = _delta;
+
+					for (k = 1; k <= ksize2; k++) {
+						S = (const ST*)src[k] + i;
+						S2 = (const ST*)src[-k] + i;
+						f = ky[k];
+						s0 += f*(S[0] - S2[0]);
+						s1 += f*(S[1] - S2[1]);
+						s2 += f*(S[2] - S2[2]);
+						s3 += f*(S[3] - S2[3]);
+					}
+
+					D[i] = castOp(s0); D[i + 1] = castOp(s1);
+					D[i + 2] = castOp(s2); D[i + 3] = castOp(s3);
+				}
+
+				for (; i < width; i++) {
+					ST s0 = _delta;
+					for (k = 1; k <= ksize2; k++)
+						s0 += ky[k] * (((const ST*)src[k])[i] - ((const ST*)src[-k])[i]);
+					D[i] = castOp(s0);
+				}
+			}
+		}
+	}
+
+	int symmetryType;
+};
+
+// the vertical pass of the symmetrical or asymmetrical kernels of 3 taps
+template<class CastOp, class VecOp> struct SymmColumnSmallFilter : public SymmColumnFilter<CastOp, VecOp>
+{
+	typedef typename CastOp::type1 ST;
+	typedef typename CastOp::rtype DT;
+
+	template<typename KT>
+	SymmColumnSmallFilter(const std::vector<KT>& _kernel, int _anchor, double _delta, int _symmetryType,
+		const CastOp& _castOp = CastOp(), const VecOp& _vecOp = VecOp())
+		: SymmColumnFilter<CastOp, VecOp>(_kernel, _anchor, _delta, _symmetryType, _castOp, _vecOp)
+	{
+		FBC_Assert(this->ksize == 3);
+	}
+
+	void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
+	{
+		int ksize2 = this->ksize / 2;
+		const ST* ky = &this->kernel[0] + ksize2;
+		int i;
+		bool symmetrical = (this->symmetryType & KERNEL_SYMMETRICAL) != 0;
+		bool is_1_2_1 = ky[0] == 2 && ky[1] == 1;
+		bool is_1_m2_1 = ky[0] == -2 && ky[1] == 1;
+		bool is_m1_0_1 = ky[0] == 0 && (ky[1] == 1 || ky[1] == -1);
+		ST f0 = ky[0], f1 = ky[1];
+		ST _delta = this->delta;
+		CastOp castOp = this->castOp0;
+		src += ksize2;
+
+		for (; count--; dst += dststep, src++) {
+			DT* D = (DT*)dst;
+			i = (this->vecOp)(src, dst, width);
+			const ST* S0 = (const ST*)src[-1];
+			const ST* S1 = (const ST*)src[0];
+			const ST* S2 = (const ST*)src[1];
+
+			if (symmetrical) {
+				if (is_1_2_1) {
+					for (; i <= width - 4; i += 4) {
+						ST s0 = S0[i] + S1[i] * 2 + S2[i] + _delta;
+						ST s1 = S0[i + 1] + S1[i + 1] * 2 + S2[i + 1] + _delta;
+						D[i] = castOp(s0); D[i + 1] = castOp(s1);
+						s0 = S0[i + 2] + S1[i + 2] * 2 + S2[i + 2] + _delta;
+						s1 = S0[i + 3] + S1[i + 3] * 2 + S2[i + 3] + _delta;
+						D[i + 2] = castOp(s0); D[i + 3] = castOp(s1);
+					}
+				} else if (is_1_m2_1) {
+					for (; i <= width - 4; i += 4) {
+						ST s0 = S0[i] - S1[i] * 2 + S2[i] + _delta;
+						ST s1 = S0[i + 1] - S1[i + 1] * 2 + S2[i + 1] + _delta;
+						D[i] = castOp(s0); D[i + 1] = castOp(s1);
+						s0 = S0[i + 2] - S1[i + 2] * 2 + S2[i + 2] + _delta;
+						s1 = S0[i + 3] - S1[i + 3] * 2 + S2[i + 3] + _delta;
+						D[i + 2] = castOp(s0); D[i + 3] = castOp(s1);
+					}
+				} else {
+					for (; i <= width - 4; i += 4) {
+						ST s0 = (S0[i] + S2[i])*f1 + S1[i] * f0 + _delta;
+						ST s1 = (S0[i + 1] + S2[i + 1])*f1 + S1[i + 1] * f0 + _delta;
+						D[i] = castOp(s0); D[i + 1] = castOp(s1);
+						s0 = (S0[i + 2] + S2[i + 2])*f1 + S1[i + 2] * f0 + _delta;
+						s1 = (S0[i + 3] + S2[i + 3])*f1 + S1[i + 3] * f0 + _delta;
+						D[i + 2] = castOp(s0); D[i + 3] = castOp(s1);
+					}
+				}
+
+				for (; i < width; i++)
+					D[i] = castOp((S0[i] + S2[i])*f1 + S1[i] * f0 + _delta);
+			} else {
+				if (is_m1_0_1) {
+					if (f1 < 0)
+						std::swap(S0, S2);
+
+					for (; i <= width - 4; i += 4) {
+						ST s0 = S2[i] - S0[i] + _delta;
+						ST s1 = S2[i + 1] - S0[i + 1] + _delta;
+						D[i] = castOp(s0); D[i + 1] = castOp(s1);
+						s0 = S2[i + 2] - S0[i + 2] + _delta;
+						s1 = S2[i + 3] - S0[i + 3] + _delta;
+						D[i + 2] = castOp(s0); D[i + 3] = castOp(s1);
+					}
+
+					if (f1 < 0)
+						std::swap(S0, S2);
+				} else {
+					for (; i <= width - 4; i += 4) {
+						ST s0 = (S2[i] - S0[i])*f1 + _delta;
+						ST s1 = (S2[i + 1] - S0[i + 1])*f1 + _delta;
+						D[i] = castOp(s0); D[i + 1] = castOp(s1);
+						s0 = (S2[i + 2] - S0[i + 2])*f1 + _delta;
+						s1 = (S2[i + 3] - S0[i + 3])*f1 + _delta;
+						D[i + 2] = castOp(s0); D[i + 3] = castOp(s1);
+					}
+				}
+
+				for (; i < width; i++)
+					D[i] = castOp((S2[i] - S0[i])*f1 + _delta);
+			}
+		}
+	}
+};
+
+// returns the horizontal pass of a separable linear filter
+// support type: uchar -> int (fixed-point kernel), uchar -> float, float -> float
+template<typename ST, typename DT>
+Ptr<BaseRowFilter> getLinearRowFilter(const std::vector<DT>& kernel, int anchor, int symmetryType)
+{
+	int ksize = (int)kernel.size();
+
+	if ((symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL)) != 0 && ksize <= 5) {
+		if (typeid(uchar).name() == typeid(ST).name() && typeid(int).name() == typeid(DT).name()) {
+			std::vector<int> k(kernel.begin(), kernel.end());
+			return makePtr<SymmRowSmallFilter<uchar, int, RowVec_8u32s> >(k, anchor, symmetryType, RowVec_8u32s(k, symmetryType));
+		}
+		if (typeid(float).name() == typeid(ST).name() && typeid(float).name() == typeid(DT).name())
+			return makePtr<SymmRowSmallFilter<float, float, RowNoVec> >(kernel, anchor, symmetryType);
+	}
+
+	if (typeid(uchar).name() == typeid(ST).name() && typeid(int).name() == typeid(DT).name()) {
+		std::vector<int> k(kernel.begin(), kernel.end());
+		return makePtr<RowFilter<uchar, int, RowVec_8u32s> >(k, anchor, RowVec_8u32s(k, symmetryType));
+	}
+	if (typeid(uchar).name() == typeid(ST).name() && typeid(float).name() == typeid(DT).name())
+		return makePtr<RowFilter<uchar, float, RowNoVec> >(kernel, anchor);
+	if (typeid(float).name() == typeid(ST).name() && typeid(float).name() == typeid(DT).name())
+		return makePtr<RowFilter<float, float, RowNoVec> >(kernel, anchor);
+
+	FBC_Error("Unsupported combination of source format and buffer format");
+	return Ptr<BaseRowFilter>();
+}
+
+// returns the vertical pass of a separable linear filter, bits: the fractional bits of the fixed-point sums
+// support type: int (fixed-point kernel) -> uchar, float -> uchar, float -> float
+template<typename ST, typename DT>
+Ptr<BaseColumnFilter> getLinearColumnFilter(const std::vector<ST>& kernel, int anchor, int symmetryType, double delta, int bits)
+{
+	int ksize = (int)kernel.size();
+	bool int8u = typeid(int).name() == typeid(ST).name() && typeid(uchar).name() == typeid(DT).name();
+	bool float8u = typeid(float).name() == typeid(ST).name() && typeid(uchar).name() == typeid(DT).name();
+	bool float32f = typeid(float).name() == typeid(ST).name() && typeid(float).name() == typeid(DT).name();
+
+	if (!(symmetryType & (KERNEL_SYMMETRICAL | KERNEL_ASYMMETRICAL))) {
+		if (int8u)
+			return makePtr<ColumnFilter<FixedPtCastEx<int, uchar>, ColumnNoVec> >(kernel, anchor, delta, FixedPtCastEx<int, uchar>(bits));
+		if (float8u)
+			return makePtr<ColumnFilter<Cast<float, uchar>, ColumnNoVec> >(kernel, anchor, delta);
+		if (float32f)
+			return makePtr<ColumnFilter<Cast<float, float>, ColumnNoVec> >(kernel, anchor, delta);
+	} else {
+		std::vector<int> k(kernel.begin(), kernel.end());
+		if (ksize == 3) {
+			if (int8u)
+				return makePtr<SymmColumnSmallFilter<FixedPtCastEx<int, uchar>, SymmColumnVec_32s8u> >(k, anchor, delta, symmetryType,
+					FixedPtCastEx<int, uchar>(bits), SymmColumnVec_32s8u(k, symmetryType, bits, delta));
+			if (float32f)
+				return makePtr<SymmColumnSmallFilter<Cast<float, float>, ColumnNoVec> >(kernel, anchor, delta, symmetryType);
+		}
+		if (int8u)
+			return makePtr<SymmColumnFilter<FixedPtCastEx<int, uchar>, SymmColumnVec_32s8u> >(k, anchor, delta, symmetryType,
+				FixedPtCastEx<int, uchar>(bits), SymmColumnVec_32s8u(k, symmetryType, bits, delta));
+		if (float8u)
+			return makePtr<SymmColumnFilter<Cast<float, uchar>, ColumnNoVec> >(kernel, anchor, delta, symmetryType);
+		if (float32f)
+			return makePtr<SymmColumnFilter<Cast<float, float>, ColumnNoVec> >(kernel, anchor, delta, symmetryType);
+	}
+
+	FBC_Error("Unsupported combination of buffer format and destination format");
+	return Ptr<BaseColumnFilter>();
+}
+
+// true when the separable filter of the kernels runs with the fixed-point (int) buffer: 8-bit source and destination
+// and smooth symmetrical kernels, their coefficients are then scaled by 1 << 8 and rounded
+template<typename _Tp1, typename _Tp2>
+bool isFixedPointSepFilter(const Mat_<float, 1>& rowKernel, const Mat_<float, 1>& columnKernel, Point anchor = Point(-1, -1))
+{
+	if (typeid(uchar).name() != typeid(_Tp1).name() || typeid(uchar).name() != typeid(_Tp2).name())
+		return false;
+
+	int rsize = rowKernel.rows + rowKernel.cols - 1;
+	int csize = columnKernel.rows + columnKernel.cols - 1;
+	if (anchor.x < 0)
+		anchor.x = rsize / 2;
+	if (anchor.y < 0)
+		anchor.y = csize / 2;
+
+	int rtype = getKernelType(rowKernel, rowKernel.rows == 1 ? Point(anchor.x, 0) : Point(0, anchor.x));
+	int ctype = getKernelType(columnKernel, columnKernel.rows == 1 ? Point(anchor.y, 0) : Point(0, anchor.y));
+
+	return rtype == KERNEL_SMOOTH + KERNEL_SYMMETRICAL && ctype == KERNEL_SMOOTH + KERNEL_SYMMETRICAL;
+}
+
+// creates the engine of a separable linear filter, the buffer type _Tp3 is int for the fixed-point filters of the 8-bit
+// images (see isFixedPointSepFilter), float otherwise
+// support type: uchar/float -> uchar/float
+template<typename _Tp1, typename _Tp2, typename _Tp3, int chs>
+Ptr<FilterEngine<_Tp1, _Tp2, _Tp3, chs, chs, chs>> createSeparableLinearFilter(const Mat_<float, 1>& rowKernel, const Mat_<float, 1>& columnKernel,
+	Point anchor = Point(-1, -1), double delta = 0, int rowBorderType = BORDER_DEFAULT, int columnBorderType = -1, const Scalar& borderValue = Scalar())
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp1).name() || typeid(float).name() == typeid(_Tp1).name()); // uchar || float
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp2).name() || typeid(float).name() == typeid(_Tp2).name()); // uchar || float
+
+	int rsize = rowKernel.rows + rowKernel.cols - 1;
+	int csize = columnKernel.rows + columnKernel.cols - 1;
+	if (anchor.x < 0)
+		anchor.x = rsize / 2;
+	if (anchor.y < 0)
+		anchor.y = csize / 2;
+
+	int rtype = getKernelType(rowKernel, rowKernel.rows == 1 ? Point(anchor.x, 0) : Point(0, anchor.x));
+	int ctype = getKernelType(columnKernel, columnKernel.rows == 1 ? Point(anchor.y, 0) : Point(0, anchor.y));
+
+	std::vector<_Tp3> rkernel, ckernel;
+	int bits = 0;
+
+	if (typeid(int).name() == typeid(_Tp3).name()) {
+		FBC_Assert((isFixedPointSepFilter<_Tp1, _Tp2>(rowKernel, columnKernel, anchor)));
+		std::vector<double> k;
+		getKernelCoeffs(rowKernel, k);
+		for (size_t i = 0; i < k.size(); i++)
+			rkernel.push_back((_Tp3)saturate_cast<int>(k[i] * (1 << 8)));
+		getKernelCoeffs(columnKernel, k);
+		for (size_t i = 0; i < k.size(); i++)
+			ckernel.push_back((_Tp3)saturate_cast<int>(k[i] * (1 << 8)));
+		bits = 8 * 2;
+		delta *= (1 << bits);
+	} else {
+		FBC_Assert(typeid(float).name() == typeid(_Tp3).name());
+		getKernelCoeffs(rowKernel, rkernel);
+		getKernelCoeffs(columnKernel, ckernel);
+	}
+
+	Ptr<BaseRowFilter> rowFilter = getLinearRowFilter<_Tp1, _Tp3>(rkernel, anchor.x, rtype);
+	Ptr<BaseColumnFilter> columnFilter = getLinearColumnFilter<_Tp3, _Tp2>(ckernel, anchor.y, ctype, delta, bits);
+
+	return makePtr<FilterEngine<_Tp1, _Tp2, _Tp3, chs, chs, chs>>(Ptr<BaseFilter>(), rowFilter, columnFilter,
+		rowBorderType, columnBorderType, borderValue);
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_FILTER_HPP_
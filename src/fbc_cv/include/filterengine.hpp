@@ -12,6 +12,7 @@
 #include "core/mat.hpp"
 #include "core/Ptr.hpp"
 #include "core/fbcdef.hpp"
+#include "core/parallel.hpp"
 
 namespace fbc {
 
@@ -49,6 +50,8 @@ public:
 	virtual void operator()(const uchar** src, uchar* dst, int dststep, int dstcount, int width) = 0;
 	// resets the internal buffers, if any
 	virtual void reset() {}
+	// the number of rows of the ring buffer of the engine the filter works best with, -1: the default of the engine
+	virtual int bufferRows() const { return -1; }
 
 	int ksize;
 	int anchor;
@@ -259,7 +262,7 @@ int FilterEngine<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>::start(Size _wholeSize, Rec
 	const uchar* constVal = !constBorderValue.empty() ? &constBorderValue[0] : 0;
 
 	if (_maxBufRows < 0)
-		_maxBufRows = ksize.height + 3;
+		_maxBufRows = std::max(ksize.height + 3, isSeparable() ? columnFilter->bufferRows() : -1);
 	_maxBufRows = std::max(_maxBufRows, std::max(anchor.y, ksize.height - anchor.y - 1) * 2 + 1);
 
 	if (maxWidth < roi.width || _maxBufRows != (int)rows.size()) {
@@ -480,6 +483,41 @@ void FilterEngine<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>::apply(const Mat_<_Tp1, ch
 		dstOfs.x*dst.elemSize(), (int)dst.step);
 }
 
+// filters src into dst by horizontal stripes in parallel, create() returns a new engine for every stripe (the row and
+// column filters keep state); a stripe reads the kheight - 1 rows around it from src, so the result is the one of a
+// single engine. A source overlapping dst is copied first, or filtered by a single engine when it is a submatrix
+// whose border is taken from the parent matrix.
+template<typename _Tp1, typename _Tp2, int chs1, int chs2, class Create>
+void applyFilterStripes(const Mat_<_Tp1, chs1>& src, Mat_<_Tp2, chs2>& dst, int kheight, bool isolated, Create create)
+{
+	FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	if (src.empty())
+		return;
+
+	// a stripe costs kheight - 1 more rows of the row filter
+	double nstripes = std::min(src.rows * (double)src.cols / (1 << 16), src.rows / (double)std::max(kheight * 4, 32));
+	const uchar* s0 = src.ptr(0), *s1 = src.ptr(src.rows - 1) + src.cols * src.elemSize();
+	const uchar* d0 = dst.ptr(0), *d1 = dst.ptr(dst.rows - 1) + dst.cols * dst.elemSize();
+	bool overlap = s0 < d1 && d0 < s1;
+
+	if (nstripes <= 1 || getNumThreads() <= 1 || (overlap && src.isSubmatrix() && !isolated)) {
+		create()->apply(src, dst, Rect(0, 0, -1, -1), Point(0, 0), isolated);
+		return;
+	}
+
+	Mat_<_Tp1, chs1> src_;
+	if (overlap) {
+		src_ = src.clone();
+		isolated = true;
+	} else {
+		src_ = src;
+	}
+
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		create()->apply(src_, dst, Rect(0, range.start, src.cols, range.end - range.start), Point(0, range.start), isolated);
+	}, nstripes);
+}
+
 } // namespace fbc
 
 #endif // FBC_CV_FILTER_ENGINE_HPP_
@@ -0,0 +1,264 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_FILTER_PIPELINE_HPP_
+#define FBC_CV_FILTER_PIPELINE_HPP_
+
+/* reference: modules/imgproc/src/filterengine.hpp (FilterEngine::start/proceed)
+*/
+
+#include <string.h>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/Ptr.hpp"
+#include "filterengine.hpp"
+
+namespace fbc {
+
+// one filter engine of a FilterPipeline, the types of the engine are hidden behind the element sizes
+class BaseFilterStage {
+public:
+	virtual ~BaseFilterStage() {}
+	// starts the filtering of the roi of an image of size wholeSize, returns the first source row needed
+	virtual int start(Size wholeSize, Rect roi) = 0;
+	// FilterEngine::proceed
+	virtual int proceed(const uchar* src, int srcstep, int count, uchar* dst, int dststep) = 0;
+	virtual int remainingInputRows() const = 0;
+
+	int srcElemSize; // sizeof(_Tp1) * chs1
+	int dstElemSize; // sizeof(_Tp2) * chs2
+	int delayRows; // ksize.height - 1, the output rows lag the input rows by at most this number
+};
+
+template <typename _Tp1, typename _Tp2, typename _Tp3, int chs1, int chs2, int chs3>
+class FilterEngineStage : public BaseFilterStage {
+public:
+	FilterEngineStage(const Ptr<FilterEngine<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>>& _f, int _maxBufRows) : f(_f), maxBufRows(_maxBufRows)
+	{
+		srcElemSize = sizeof(_Tp1) * chs1;
+		dstElemSize = sizeof(_Tp2) * chs2;
+		delayRows = f->ksize.height - 1;
+	}
+
+	int start(Size wholeSize, Rect roi) { return f->start(wholeSize, roi, maxBufRows); }
+	int proceed(const uchar* src, int srcstep, int count, uchar* dst, int dststep) { return f->proceed(src, srcstep, count, dst, dststep); }
+	int remainingInputRows() const { return f->remainingInputRows(); }
+
+	Ptr<FilterEngine<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>> f;
+	int maxBufRows;
+};
+
+// Streaming filtering of an image band by band with one or several chained filter engines.
+// The source rows are pushed in any number of bands (e.g. from a line-scan camera or a decoder), each stage
+// filters blockRows rows at a time and passes its output rows to the next stage through a buffer of a few
+// rows, the finished rows of the last stage are pulled by the caller (or written to dst directly by proceed).
+// The memory does not depend on the height of the image, the intermediate images are never allocated.
+// The height of the image must be known by start() for the bottom border, the last output rows are
+// available once the last source row has been pushed.
+//	FilterPipeline pipeline;
+//	pipeline.add(createMorphologyFilter<uchar, 1>(MORPH_ERODE, kernel, Point(-1, -1)));
+//	pipeline.add(createMorphologyFilter<uchar, 1>(MORPH_DILATE, kernel, Point(-1, -1)));
+//	pipeline.start(Size(width, height));
+//	while (pipeline.remainingInputRows() > 0) {
+//		pipeline.push(band);
+//		pipeline.pull(out); // up to out.rows finished rows
+//	}
+class FilterPipeline {
+public:
+	FilterPipeline() : width(0), height(0), blockRows(32), inputY(0), outputY(0), outStep(0), outBegin(0), outCount(0) {}
+
+	// appends a filter engine, its source type must be the destination type of the previous one
+	// maxBufRows: the number of rows of the ring buffer of the engine, -1: the default of the engine
+	template <typename _Tp1, typename _Tp2, typename _Tp3, int chs1, int chs2, int chs3>
+	void add(const Ptr<FilterEngine<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>>& f, int maxBufRows = -1)
+	{
+		FBC_Assert(f);
+		Ptr<BaseFilterStage> stage = makePtr<FilterEngineStage<_Tp1, _Tp2, _Tp3, chs1, chs2, chs3>>(f, maxBufRows);
+		FBC_Assert(stages.empty() || stages.back()->dstElemSize == stage->srcElemSize);
+		stages.push_back(stage);
+	}
+
+	// removes the stages
+	void clear() { stages.clear(); buffers.clear(); outBuf.clear(); width = height = 0; }
+
+	// starts the filtering of the roi of an image of size wholeSize: the rows and the columns of the image around
+	// the roi are used as the border of the first stage (as FilterEngine::start does for a submatrix), the output
+	// has the size of the roi. returns the first source row to push, relative to roi.y (<= 0)
+	// blockRows: the number of source rows filtered at a time
+	int start(Size wholeSize, Rect roi, int _blockRows = 32)
+	{
+		FBC_Assert(!stages.empty() && _blockRows > 0);
+
+		width = roi.width;
+		height = roi.height;
+		blockRows = _blockRows;
+		inputY = outputY = 0;
+		outBegin = outCount = 0;
+
+		int y = stages[0]->start(wholeSize, roi) - roi.y;
+		for (size_t i = 1; i < stages.size(); i++)
+			stages[i]->start(roi.size(), Rect(0, 0, width, height));
+
+		// the input of stage i + 1: at most the rows of a block plus the delayed rows of stages 0..i
+		buffers.resize(stages.size() - 1);
+		int rows = blockRows;
+		for (size_t i = 0; i + 1 < stages.size(); i++) {
+			rows += stages[i]->delayRows;
+			buffers[i].resize((size_t)rows * width * stages[i]->dstElemSize);
+		}
+		outStep = (size_t)width * stages.back()->dstElemSize;
+
+		return y;
+	}
+
+	// starts the filtering of an image of size
+	int start(Size size, int _blockRows = 32) { return start(size, Rect(0, 0, size.width, size.height), _blockRows); }
+
+	// starts the filtering of src, a submatrix is filtered with the pixels of its parent matrix around it as the border
+	// returns the first source row to push, relative to src.ptr(0) (<= 0)
+	template<typename _Tp, int chs>
+	int start(const Mat_<_Tp, chs>& src, int _blockRows = 32)
+	{
+		FBC_Assert(!stages.empty() && stages[0]->srcElemSize == (int)(sizeof(_Tp) * chs));
+		Size wholeSize;
+		Point ofs;
+		src.locateROI(wholeSize, ofs);
+		return start(wholeSize, Rect(ofs.x, ofs.y, src.cols, src.rows), _blockRows);
+	}
+
+	// pushes the next count source rows (at most remainingInputRows()), the finished rows are kept until they are pulled
+	// returns the number of the rows available to pull
+	int push(const uchar* src, int srcstep, int count)
+	{
+		process(src, srcstep, count, NULL, 0);
+		return outCount;
+	}
+
+	// pushes the rows of band, band.cols must be the width of the roi
+	template<typename _Tp, int chs>
+	int push(const Mat_<_Tp, chs>& band)
+	{
+		FBC_Assert(band.cols == width && stages[0]->srcElemSize == (int)(sizeof(_Tp) * chs));
+		return push(band.ptr(), (int)band.step, band.rows);
+	}
+
+	// copies up to maxCount finished rows to dst and removes them, returns the number of rows copied
+	int pull(uchar* dst, int dststep, int maxCount)
+	{
+		int count = std::min(maxCount, outCount);
+		for (int i = 0; i < count; i++)
+			memcpy(dst + (size_t)i * dststep, &outBuf[(outBegin + i) * outStep], outStep);
+
+		outBegin += count;
+		outCount -= count;
+		outputY += count;
+		if (outCount == 0)
+			outBegin = 0;
+
+		return count;
+	}
+
+	// copies up to dst.rows finished rows to the first rows of dst
+	template<typename _Tp, int chs>
+	int pull(Mat_<_Tp, chs>& dst)
+	{
+		FBC_Assert(dst.cols == width && stages.back()->dstElemSize == (int)(sizeof(_Tp) * chs));
+		return pull(dst.ptr(), (int)dst.step, dst.rows);
+	}
+
+	// pushes the next count source rows and writes the finished rows to dst directly, returns their number.
+	// dst must have room for count + delayRows() rows, push/pull and proceed are not mixed for an image
+	int proceed(const uchar* src, int srcstep, int count, uchar* dst, int dststep)
+	{
+		FBC_Assert(dst && outCount == 0);
+		int dy = process(src, srcstep, count, dst, dststep);
+		outputY += dy;
+		return dy;
+	}
+
+	// the number of source rows still expected
+	int remainingInputRows() const { return stages.empty() ? 0 : stages[0]->remainingInputRows(); }
+	// the number of finished rows not pulled yet
+	int availableRows() const { return outCount; }
+	// the number of output rows not pulled (or written by proceed) yet
+	int remainingOutputRows() const { return height - outputY; }
+	// the maximum lag of the output rows behind the source rows
+	int delayRows() const
+	{
+		int d = 0;
+		for (size_t i = 0; i < stages.size(); i++)
+			d += stages[i]->delayRows;
+		return d;
+	}
+
+private:
+	// the source rows go through the stages by blocks of blockRows rows, the rows of the last stage
+	// are written to dst or to outBuf when dst is NULL. returns the number of the rows of the last stage
+	int process(const uchar* src, int srcstep, int count, uchar* dst, int dststep)
+	{
+		FBC_Assert(!stages.empty() && width > 0);
+		count = std::min(count, remainingInputRows());
+
+		int total = 0, nstages = (int)stages.size();
+		for (; count > 0; ) {
+			int n = std::min(count, blockRows);
+			const uchar* in = src;
+			int instep = srcstep, dy = n;
+
+			for (int i = 0; i < nstages && dy > 0; i++) {
+				uchar* out;
+				int outstep;
+				if (i + 1 < nstages) {
+					out = &buffers[i][0];
+					outstep = width * stages[i]->dstElemSize;
+				} else if (dst) {
+					out = dst + (size_t)total * dststep;
+					outstep = dststep;
+				} else {
+					out = reserveOutput(dy + stages[i]->delayRows);
+					outstep = (int)outStep;
+				}
+
+				dy = stages[i]->proceed(in, instep, dy, out, outstep);
+				in = out;
+				instep = outstep;
+			}
+
+			if (!dst)
+				outCount += dy;
+			total += dy;
+			src += (size_t)n * srcstep;
+			count -= n;
+			inputY += n;
+		}
+
+		return total;
+	}
+
+	// returns the first free row of outBuf after making room for rows more rows
+	uchar* reserveOutput(int rows)
+	{
+		if (outBegin > 0 && outCount > 0)
+			memmove(&outBuf[0], &outBuf[outBegin * outStep], outCount * outStep);
+		outBegin = 0;
+
+		size_t size = (outCount + rows) * outStep;
+		if (outBuf.size() < size)
+			outBuf.resize(size);
+
+		return &outBuf[outCount * outStep];
+	}
+
+	std::vector<Ptr<BaseFilterStage>> stages;
+	std::vector<std::vector<uchar>> buffers; // the output rows of the stages but the last one
+	int width, height;
+	int blockRows;
+	int inputY, outputY;
+	std::vector<uchar> outBuf; // the finished rows not pulled yet
+	size_t outStep;
+	int outBegin, outCount;
+};
+
+} // namespace fbc
+
+#endif // FBC_CV_FILTER_PIPELINE_HPP_
@@ -9,7 +9,10 @@
 */
 
 #include <typeinfo>
+#include <vector>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 
 namespace fbc {
 
@@ -46,6 +49,17 @@ int flip(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int flipCode)
 		return 0;
 	}
 
+	if (flipCode != 0 && src.data != dst.data) {
+		// one pass over the rows, reversed and read from the last row up for flipCode < 0 (see hal::flipRows)
+		const int esz = (int)(sizeof(_Tp) * chs);
+		ptrdiff_t sstep = flipCode < 0 ? -(ptrdiff_t)src.step : (ptrdiff_t)src.step;
+		parallel_for_(Range(0, size.height), [&](const Range& range) {
+			int y = flipCode < 0 ? size.height - 1 - range.start : range.start;
+			hal::flipRows(src.ptr(y), sstep, dst.ptr(range.start), dst.step, size.width, range.end - range.start, esz);
+		}, (double)size.area() * esz / (1 << 16));
+		return 0;
+	}
+
 	if (flipCode <= 0)
 		flipVert(src, dst);
 	else
@@ -57,6 +71,26 @@ int flip(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int flipCode)
 	return 0;
 }
 
+// Flips the images of a batch, the sources must have the same size
+// dst gets one image per source image, see createBatch()
+template <typename _Tp, int chs>
+int flip(const std::vector<Mat_<_Tp, chs>>& src, std::vector<Mat_<_Tp, chs>>& dst, int flipCode)
+{
+	int n = (int)src.size();
+	if (n == 0) {
+		dst.clear();
+		return 0;
+	}
+
+	for (int i = 1; i < n; i++)
+		FBC_Assert(src[i].size() == src[0].size());
+	createBatch(dst, n, src[0].size());
+
+	parallel_for_batch_(n, [&](int i) { flip(src[i], dst[i], flipCode); });
+
+	return 0;
+}
+
 template<typename _Tp, int chs>
 static int flipHoriz(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 {
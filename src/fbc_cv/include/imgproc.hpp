@@ -303,9 +303,41 @@ const uchar icvSaturate8u_cv[] =
 #define FBC_CALC_MIN_8U(a,b) (a) -= FBC_FAST_CAST_8U((a) - (b))
 #define FBC_CALC_MAX_8U(a,b) (a) += FBC_FAST_CAST_8U((b) - (a))
 
+// the cast of the sums of the filters to the destination type
+template<typename ST, typename DT> struct Cast
+{
+	typedef ST type1;
+	typedef DT rtype;
+
+	DT operator()(ST val) const { return saturate_cast<DT>(val); }
+};
+
+// the cast of the fixed-point sums with bits fractional bits, rounded
+template<typename ST, typename DT, int bits> struct FixedPtCast
+{
+	typedef ST type1;
+	typedef DT rtype;
+	enum { SHIFT = bits, DELTA = 1 << (bits - 1) };
+
+	DT operator()(ST val) const { return saturate_cast<DT>((val + DELTA) >> SHIFT); }
+};
+
+// the cast of the float sums with bits fractional bits
+template<typename T, int shift> struct FltCast
+{
+	typedef T type1;
+	typedef T rtype;
+
+	T operator()(type1 arg) const { return arg*(T)(1. / (1 << shift)); }
+};
+
 // cal a structuring element of the specified size and shape for morphological operations
 FBC_EXPORTS int getStructuringElement(Mat_<uchar, 1>& dst, int shape, Size ksize, Point anchor = Point(-1, -1));
 
+// cal the ksize x 1 Gaussian filter coefficients, G_i = alpha * exp(-(i - (ksize - 1) / 2)^2 / (2 * sigma^2)),
+// alpha normalizes their sum to 1; sigma <= 0: computed from ksize as 0.3 * ((ksize - 1) * 0.5 - 1) + 0.8
+FBC_EXPORTS int getGaussianKernel(Mat_<float, 1>& dst, int ksize, double sigma);
+
 // Returns the optimal DFT size for a given vector size
 // Arrays whose size is a power-of-two (2, 4, 8, 16, 32, ...) are the fastest to process.
 // Though, the arrays whose size is a product of 2's, 3's, and 5's are also processed quite efficiently
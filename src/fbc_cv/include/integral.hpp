@@ -0,0 +1,251 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_INTEGRAL_HPP_
+#define FBC_CV_INTEGRAL_HPP_
+
+/* reference: include/opencv2/imgproc.hpp
+              modules/imgproc/src/sumpixels.cpp
+*/
+
+#include <string.h>
+#include <typeinfo>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "imgproc.hpp"
+
+namespace fbc {
+
+// the optimized rows of the sums only, returns true when the whole image is processed
+template<typename T, typename ST>
+static inline bool integralSumVec(const T*, size_t, ST*, size_t, int, int, int) { return false; }
+static inline bool integralSumVec(const uchar* src, size_t srcstep, int* sum, size_t sumstep, int width, int height, int cn)
+{
+	if (cn != 1)
+		return false;
+
+	memset(sum, 0, (width + 1)*sizeof(sum[0]));
+	for (int y = 0; y < height; y++, src += srcstep) {
+		const int* prev = sum + 1;
+		sum += sumstep;
+		sum[0] = 0;
+
+		int x = hal::integralRow8u32s(src, prev, sum + 1, width);
+		int s = x > 0 ? sum[x] - prev[x - 1] : 0;
+		for (; x < width; x++) {
+			s += src[x];
+			sum[x + 1] = prev[x] + s;
+		}
+	}
+
+	return true;
+}
+
+// the sums (and the squared sums, the sums of the 45 degrees rotated rectangles) of the rectangles above and to
+// the left of each pixel, the steps are in elements; sqsum and tilted may be NULL
+template<typename T, typename ST, typename QT>
+void integral_(const T* src, size_t srcstep, ST* sum, size_t sumstep, QT* sqsum, size_t sqsumstep,
+	ST* tilted, size_t tiltedstep, int width, int height, int cn)
+{
+	int x, y, k;
+
+	if (sqsum == 0 && tilted == 0 && integralSumVec(src, srcstep, sum, sumstep, width, height, cn))
+		return;
+
+	width *= cn;
+
+	memset(sum, 0, (width + cn)*sizeof(sum[0]));
+	sum += sumstep + cn;
+
+	if (sqsum) {
+		memset(sqsum, 0, (width + cn)*sizeof(sqsum[0]));
+		sqsum += sqsumstep + cn;
+	}
+
+	if (tilted) {
+		memset(tilted, 0, (width + cn)*sizeof(tilted[0]));
+		tilted += tiltedstep + cn;
+	}
+
+	if (sqsum == 0 && tilted == 0) {
+		for (y = 0; y < height; y++, src += srcstep - cn, sum += sumstep - cn) {
+			for (k = 0; k < cn; k++, src++, sum++) {
+				ST s = sum[-cn] = 0;
+				for (x = 0; x < width; x += cn) {
+					s += src[x];
+					sum[x] = sum[x - sumstep] + s;
+				}
+			}
+		}
+	} else if (tilted == 0) {
+		for (y = 0; y < height; y++, src += srcstep - cn, sum += sumstep - cn, sqsum += sqsumstep - cn) {
+			for (k = 0; k < cn; k++, src++, sum++, sqsum++) {
+				ST s = sum[-cn] = 0;
+				QT sq = sqsum[-cn] = 0;
+				for (x = 0; x < width; x += cn) {
+					T it = src[x];
+					s += it;
+					sq += (QT)it*it;
+					ST t = sum[x - sumstep] + s;
+					QT tq = sqsum[x - sqsumstep] + sq;
+					sum[x] = t;
+					sqsum[x] = tq;
+				}
+			}
+		}
+	} else {
+		std::vector<ST> _buf(width + cn);
+		ST* buf = &_buf[0];
+		ST s;
+		QT sq;
+		for (k = 0; k < cn; k++, src++, sum++, tilted++, buf++) {
+			sum[-cn] = tilted[-cn] = 0;
+
+			for (x = 0, s = 0, sq = 0; x < width; x += cn) {
+				T it = src[x];
+				buf[x] = tilted[x] = it;
+				s += it;
+				sq += (QT)it*it;
+				sum[x] = s;
+				if (sqsum)
+					sqsum[x] = sq;
+			}
+
+			if (width == cn)
+				buf[cn] = 0;
+
+			if (sqsum) {
+				sqsum[-cn] = 0;
+				sqsum++;
+			}
+		}
+
+		for (y = 1; y < height; y++) {
+			src += srcstep - cn;
+			sum += sumstep - cn;
+			tilted += tiltedstep - cn;
+			buf += -cn;
+
+			if (sqsum)
+				sqsum += sqsumstep - cn;
+
+			for (k = 0; k < cn; k++, src++, sum++, tilted++, buf++) {
+				T it = src[0];
+				ST t0 = s = it;
+				QT tq0 = sq = (QT)it*it;
+
+				sum[-cn] = 0;
+				if (sqsum)
+					sqsum[-cn] = 0;
+				tilted[-cn] = tilted[-tiltedstep];
+
+				sum[0] = sum[-sumstep] + t0;
+				if (sqsum)
+					sqsum[0] = sqsum[-sqsumstep] + tq0;
+				tilted[0] = tilted[-tiltedstep] + t0 + buf[cn];
+
+				for (x = cn; x < width - cn; x += cn) {
+					ST t1 = buf[x];
+					buf[x - cn] = t1 + t0;
+					t0 = it = src[x];
+					tq0 = (QT)it*it;
+					s += t0;
+					sq += tq0;
+					sum[x] = sum[x - sumstep] + s;
+					if (sqsum)
+						sqsum[x] = sqsum[x - sqsumstep] + sq;
+					t1 += buf[x + cn] + t0 + tilted[x - tiltedstep - cn];
+					tilted[x] = t1;
+				}
+
+				if (width > cn) {
+					ST t1 = buf[x];
+					buf[x - cn] = t1 + t0;
+					t0 = it = src[x];
+					tq0 = (QT)it*it;
+					s += t0;
+					sq += tq0;
+					sum[x] = sum[x - sumstep] + s;
+					if (sqsum)
+						sqsum[x] = sqsum[x - sqsumstep] + sq;
+					tilted[x] = t0 + t1 + tilted[x - tiltedstep - cn];
+					buf[x] = t0;
+				}
+
+				if (sqsum)
+					sqsum++;
+			}
+		}
+	}
+}
+
+template<typename _Tp, typename _Tp1, int chs>
+static void createIntegralSum(const Mat_<_Tp, chs>& src, Mat_<_Tp1, chs>& sum)
+{
+	if (sum.empty()) {
+		sum = Mat_<_Tp1, chs>(src.rows + 1, src.cols + 1);
+	} else {
+		FBC_Assert(sum.rows == src.rows + 1 && sum.cols == src.cols + 1);
+	}
+}
+
+// Calculates the integral of an image
+// \f[\texttt{sum} (X,Y) =  \sum _{x<X,y<Y}  \texttt{image} (x,y)\f]
+// \f[\texttt{sqsum} (X,Y) =  \sum _{x<X,y<Y}  \texttt{image} (x,y)^2\f]
+// \f[\texttt{tilted} (X,Y) =  \sum _{y<Y,abs(x-X+1) \leq Y-y-1}  \texttt{image} (x,y)\f]
+// the outputs are (src.rows + 1) x (src.cols + 1), the sum of a rectangle then costs 4 look-ups; the sums of the
+// single-channel 8-bit images without the squared sums go through the SIMD prefix sums
+// support type: uchar/float -> int/float/double, multi-channels
+template<typename _Tp, typename _Tp1, int chs>
+int integral(const Mat_<_Tp, chs>& src, Mat_<_Tp1, chs>& sum)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(typeid(int).name() == typeid(_Tp1).name() || typeid(float).name() == typeid(_Tp1).name() ||
+		typeid(double).name() == typeid(_Tp1).name()); // int || float || double
+	createIntegralSum(src, sum);
+
+	integral_<_Tp, _Tp1, double>((const _Tp*)src.ptr(0), src.step / sizeof(_Tp), (_Tp1*)sum.ptr(0), sum.step / sizeof(_Tp1),
+		(double*)NULL, 0, (_Tp1*)NULL, 0, src.cols, src.rows, chs);
+
+	return 0;
+}
+
+// support type: uchar/float -> int/float/double (sum), float/double (sqsum), multi-channels
+template<typename _Tp, typename _Tp1, typename _Tp2, int chs>
+int integral(const Mat_<_Tp, chs>& src, Mat_<_Tp1, chs>& sum, Mat_<_Tp2, chs>& sqsum)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(typeid(int).name() == typeid(_Tp1).name() || typeid(float).name() == typeid(_Tp1).name() ||
+		typeid(double).name() == typeid(_Tp1).name()); // int || float || double
+	FBC_Assert(typeid(float).name() == typeid(_Tp2).name() || typeid(double).name() == typeid(_Tp2).name()); // float || double
+	createIntegralSum(src, sum);
+	createIntegralSum(src, sqsum);
+
+	integral_<_Tp, _Tp1, _Tp2>((const _Tp*)src.ptr(0), src.step / sizeof(_Tp), (_Tp1*)sum.ptr(0), sum.step / sizeof(_Tp1),
+		(_Tp2*)sqsum.ptr(0), sqsum.step / sizeof(_Tp2), (_Tp1*)NULL, 0, src.cols, src.rows, chs);
+
+	return 0;
+}
+
+// support type: uchar/float -> int/float/double (sum, tilted), float/double (sqsum), multi-channels
+template<typename _Tp, typename _Tp1, typename _Tp2, int chs>
+int integral(const Mat_<_Tp, chs>& src, Mat_<_Tp1, chs>& sum, Mat_<_Tp2, chs>& sqsum, Mat_<_Tp1, chs>& tilted)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(typeid(int).name() == typeid(_Tp1).name() || typeid(float).name() == typeid(_Tp1).name() ||
+		typeid(double).name() == typeid(_Tp1).name()); // int || float || double
+	FBC_Assert(typeid(float).name() == typeid(_Tp2).name() || typeid(double).name() == typeid(_Tp2).name()); // float || double
+	createIntegralSum(src, sum);
+	createIntegralSum(src, sqsum);
+	createIntegralSum(src, tilted);
+
+	integral_<_Tp, _Tp1, _Tp2>((const _Tp*)src.ptr(0), src.step / sizeof(_Tp), (_Tp1*)sum.ptr(0), sum.step / sizeof(_Tp1),
+		(_Tp2*)sqsum.ptr(0), sqsum.step / sizeof(_Tp2), (_Tp1*)tilted.ptr(0), tilted.step / sizeof(_Tp1), src.cols, src.rows, chs);
+
+	return 0;
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_INTEGRAL_HPP_
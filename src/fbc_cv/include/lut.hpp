@@ -0,0 +1,298 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_LUT_HPP_
+#define FBC_CV_LUT_HPP_
+
+/* reference: include/opencv2/core.hpp
+              modules/core/src/convert.cpp
+*/
+
+#include <string.h>
+#include <algorithm>
+#include <typeinfo>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
+
+namespace fbc {
+
+// Performs a look-up table transform of an array: dst(I) = lut(src(I)), with a table per channel when lut has the
+// channels of src (dst(I)[c] = lut(src(I)[c])[c]); the table has 256 entries for an 8-bit source and 65536 entries
+// for a 16-bit one, e.g. a gamma or a tone curve. the rows are processed in parallel
+// support type: src uchar/ushort, lut and dst uchar/ushort/float; lut has 1 channel or the channels of src
+template<typename _Tsrc, typename _Tp, int chs, int lutcn>
+int LUT(const Mat_<_Tsrc, chs>& src, const Mat_<_Tp, lutcn>& lut, Mat_<_Tp, chs>& dst)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tsrc).name() || typeid(ushort).name() == typeid(_Tsrc).name()); // uchar || ushort
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(ushort).name() == typeid(_Tp).name() ||
+		typeid(float).name() == typeid(_Tp).name()); // uchar || ushort || float
+	FBC_Assert(lutcn == 1 || lutcn == chs);
+	FBC_Assert(lut.total() == (sizeof(_Tsrc) == 1 ? 256 : 65536));
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	std::vector<_Tp> buf;
+	const _Tp* tab = (const _Tp*)lut.data;
+	if (!lut.isContinuous()) {
+		buf.resize(lut.total() * lutcn);
+		for (int i = 0; i < lut.rows; i++)
+			memcpy(&buf[i * lut.cols * lutcn], lut.ptr(i), lut.cols * lutcn * sizeof(_Tp));
+		tab = &buf[0];
+	}
+
+	// 8-bit to 8-bit: the table widened to 32 bits for the gathers of hal::LUT8u
+	std::vector<int> tab32;
+	if (sizeof(_Tsrc) == 1 && sizeof(_Tp) == 1)
+		tab32.assign(tab, tab + 256 * lutcn);
+
+	int len = src.cols * chs;
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			const _Tsrc* s = (const _Tsrc*)src.ptr(i);
+			_Tp* d = (_Tp*)dst.ptr(i);
+			int x = 0;
+
+			if (!tab32.empty())
+				x = hal::LUT8u((const uchar*)s, (uchar*)d, len, &tab32[0], lutcn);
+
+			if (lutcn == 1) {
+				for (; x <= len - 4; x += 4) {
+					_Tp t0 = tab[s[x]], t1 = tab[s[x + 1]];
+					d[x] = t0; d[x + 1] = t1;
+					t0 = tab[s[x + 2]]; t1 = tab[s[x + 3]];
+					d[x + 2] = t0; d[x + 3] = t1;
+				}
+				for (; x < len; x++)
+					d[x] = tab[s[x]];
+			} else {
+				for (; x < len; x += chs) {
+					for (int c = 0; c < chs; c++)
+						d[x + c] = tab[s[x + c] * chs + c];
+				}
+			}
+		}
+	}, src.total() / (double)(1 << 16));
+
+	return 0;
+}
+
+// interpolation of Lut3D
+enum Lut3DInterpolation {
+	LUT3D_TRILINEAR = 0, // the 8 lattice points of the cell
+	LUT3D_TETRAHEDRAL = 1 // the 4 lattice points of the tetrahedron of the cell containing the color
+};
+
+// the fractional bits of the lattice positions and of the 16-bit entries of the 8-bit tables of Lut3D
+const int LUT3D_POS_BITS = 8;
+const int LUT3D_VALUE_BITS = 7;
+
+// Precomputed 3D color look-up table, e.g. the camera matching or the color grading of a .cube file
+// the table maps the first 3 channels of an image, the remaining channel is copied. the entries are converted once to
+// a table of 4 values per lattice point: 16-bit fixed-point values for 8-bit images (the 8-bit values are mapped to
+// fixed-point lattice positions by a table of 256 positions), floats for float images whose range is [0, 1]
+// the 8-bit interpolations have SIMD paths (hal::lut3DTetrahedral8u/lut3DTrilinear8u), the rows are processed in parallel
+// the object is immutable after the construction and apply() can be called from several threads at the same time
+// support type: uchar/float, 3 or 4 channels
+template<typename _Tp, int chs>
+class Lut3D {
+public:
+	// table: size * size rows of size entries with values in [0, 1], the entry (i2 * size + i1, i0) is the color of the
+	// lattice point (i0, i1, i2) of the channels 0, 1, 2 of the image (channel 0 varies fastest: the order of the
+	// entries of a .cube file, whose colors are RGB, for RGB images); size >= 2, e.g. 17, 33 or 65
+	Lut3D(const Mat_<float, 3>& table, int interpolation = LUT3D_TETRAHEDRAL);
+
+	// maps the colors of src to dst, dst is created if it is empty
+	int apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const;
+
+	int size() const { return lsize; }
+	int interpolation() const { return inter; }
+
+private:
+	// the index of the first entry of the lattice cell of an 8-bit color and its fractions (0..1 << LUT3D_POS_BITS)
+	int cell_8u(const uchar* src, int& f0, int& f1, int& f2) const;
+	void applyRow_8u(const uchar* src, uchar* dst, int width) const;
+	void applyRow_32f(const float* src, float* dst, int width) const;
+
+	int lsize, inter;
+	std::vector<short> tab_i; // 8-bit images: the entries scaled by 255 << LUT3D_VALUE_BITS
+	std::vector<float> tab_f; // float images
+	int pos[256]; // 8-bit images: the lattice position of every value, LUT3D_POS_BITS fractional bits
+};
+
+template<typename _Tp, int chs>
+Lut3D<_Tp, chs>::Lut3D(const Mat_<float, 3>& table, int interpolation) : inter(interpolation)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(chs == 3 || chs == 4);
+	FBC_Assert(interpolation == LUT3D_TRILINEAR || interpolation == LUT3D_TETRAHEDRAL);
+	lsize = table.cols;
+	FBC_Assert(lsize >= 2 && table.rows == lsize * lsize);
+
+	size_t npoints = (size_t)lsize * lsize * lsize;
+	if (sizeof(_Tp) == 1)
+		tab_i.resize(npoints * 4);
+	else
+		tab_f.resize(npoints * 4);
+
+	for (int i = 0; i < table.rows; i++) {
+		const float* p = (const float*)table.ptr(i);
+		for (int j = 0; j < lsize * 3; j++) {
+			float v = std::min(std::max(p[j], 0.f), 1.f);
+			size_t k = ((size_t)i * lsize + j / 3) * 4 + j % 3;
+			if (sizeof(_Tp) == 1)
+				tab_i[k] = saturate_cast<short>(v * (255 << LUT3D_VALUE_BITS));
+			else
+				tab_f[k] = v;
+		}
+	}
+
+	for (int v = 0; v < 256; v++)
+		pos[v] = (v * (lsize - 1) * (2 << LUT3D_POS_BITS) + 255) / 510;
+}
+
+template<typename _Tp, int chs>
+inline int Lut3D<_Tp, chs>::cell_8u(const uchar* src, int& f0, int& f1, int& f2) const
+{
+	int p0 = pos[src[0]], p1 = pos[src[1]], p2 = pos[src[2]];
+	int i0 = std::min(p0 >> LUT3D_POS_BITS, lsize - 2), i1 = std::min(p1 >> LUT3D_POS_BITS, lsize - 2);
+	int i2 = std::min(p2 >> LUT3D_POS_BITS, lsize - 2);
+	f0 = p0 - (i0 << LUT3D_POS_BITS);
+	f1 = p1 - (i1 << LUT3D_POS_BITS);
+	f2 = p2 - (i2 << LUT3D_POS_BITS);
+
+	return ((i2 * lsize + i1) * lsize + i0) * 4;
+}
+
+template<typename _Tp, int chs>
+void Lut3D<_Tp, chs>::applyRow_8u(const uchar* src, uchar* dst, int width) const
+{
+	const int one = 1 << LUT3D_POS_BITS;
+	const int d0 = 4, d1 = lsize * 4, d2 = lsize * lsize * 4;
+	const short* tab = &tab_i[0];
+	int x = 0;
+
+	if (inter == LUT3D_TETRAHEDRAL) {
+		x = hal::lut3DTetrahedral8u(src, dst, width, chs, tab, pos, lsize);
+
+		// the vertices of the tetrahedron: the first point of the cell, then the steps along the axes of the
+		// largest, the middle and the smallest fraction; ties select any of the axes, their weights are 0
+		const int shift = LUT3D_POS_BITS + LUT3D_VALUE_BITS, delta = 1 << (shift - 1);
+		for (src += x * chs, dst += x * chs; x < width; x++, src += chs, dst += chs) {
+			int f0, f1, f2;
+			int ofs = cell_8u(src, f0, f1, f2);
+
+			bool g01 = f0 > f1, g12 = f1 > f2, g02 = f0 > f2;
+			int omax = g01 && g02 ? d0 : (!g01 && g12 ? d1 : d2);
+			int omin = !g01 && !g02 ? d0 : (g01 && !g12 ? d1 : d2);
+			int fmax = std::max(f0, std::max(f1, f2)), fmin = std::min(f0, std::min(f1, f2));
+			int fmid = f0 + f1 + f2 - fmax - fmin;
+			int w0 = one - fmax, w1 = fmax - fmid, w2 = fmid - fmin, w3 = fmin;
+
+			const short* c0 = tab + ofs;
+			const short* c1 = c0 + omax;
+			const short* c2 = c1 + (d0 + d1 + d2 - omax - omin);
+			const short* c3 = c0 + d0 + d1 + d2;
+			for (int c = 0; c < 3; c++)
+				dst[c] = (uchar)((c0[c] * w0 + c1[c] * w1 + c2[c] * w2 + c3[c] * w3 + delta) >> shift);
+			if (chs == 4)
+				dst[3] = src[3];
+		}
+	} else {
+		x = hal::lut3DTrilinear8u(src, dst, width, chs, tab, pos, lsize);
+
+		// interpolated along the axes 0, 1 and 2, 4 guard bits after the first step
+		const int shift = 2 * LUT3D_POS_BITS - 4 + LUT3D_VALUE_BITS;
+		for (src += x * chs, dst += x * chs; x < width; x++, src += chs, dst += chs) {
+			int f0, f1, f2;
+			int ofs = cell_8u(src, f0, f1, f2);
+
+			const short* c000 = tab + ofs;
+			for (int c = 0; c < 3; c++) {
+				int c00 = (c000[c] * (one - f0) + c000[d0 + c] * f0 + 8) >> 4;
+				int c10 = (c000[d1 + c] * (one - f0) + c000[d1 + d0 + c] * f0 + 8) >> 4;
+				int c01 = (c000[d2 + c] * (one - f0) + c000[d2 + d0 + c] * f0 + 8) >> 4;
+				int c11 = (c000[d2 + d1 + c] * (one - f0) + c000[d2 + d1 + d0 + c] * f0 + 8) >> 4;
+				int c0 = (c00 * (one - f1) + c10 * f1 + (one >> 1)) >> LUT3D_POS_BITS;
+				int c1 = (c01 * (one - f1) + c11 * f1 + (one >> 1)) >> LUT3D_POS_BITS;
+				dst[c] = (uchar)((c0 * (one - f2) + c1 * f2 + (1 << (shift - 1))) >> shift);
+			}
+			if (chs == 4)
+				dst[3] = src[3];
+		}
+	}
+}
+
+template<typename _Tp, int chs>
+void Lut3D<_Tp, chs>::applyRow_32f(const float* src, float* dst, int width) const
+{
+	const int d0 = 4, d1 = lsize * 4, d2 = lsize * lsize * 4;
+	const float* tab = &tab_f[0];
+	const float scale = (float)(lsize - 1);
+
+	for (int x = 0; x < width; x++, src += chs, dst += chs) {
+		int i[3];
+		float f[3];
+		for (int c = 0; c < 3; c++) {
+			float p = std::min(std::max(src[c], 0.f), 1.f) * scale;
+			i[c] = std::min((int)p, lsize - 2);
+			f[c] = p - i[c];
+		}
+		const float* c000 = tab + ((i[2] * lsize + i[1]) * lsize + i[0]) * 4;
+		float alpha = chs == 4 ? src[3] : 0.f;
+
+		if (inter == LUT3D_TETRAHEDRAL) {
+			bool g01 = f[0] > f[1], g12 = f[1] > f[2], g02 = f[0] > f[2];
+			int omax = g01 && g02 ? d0 : (!g01 && g12 ? d1 : d2);
+			int omin = !g01 && !g02 ? d0 : (g01 && !g12 ? d1 : d2);
+			float fmax = std::max(f[0], std::max(f[1], f[2])), fmin = std::min(f[0], std::min(f[1], f[2]));
+			float fmid = f[0] + f[1] + f[2] - fmax - fmin;
+
+			const float* c1 = c000 + omax;
+			const float* c2 = c1 + (d0 + d1 + d2 - omax - omin);
+			const float* c3 = c000 + d0 + d1 + d2;
+			for (int c = 0; c < 3; c++)
+				dst[c] = c000[c] * (1.f - fmax) + c1[c] * (fmax - fmid) + c2[c] * (fmid - fmin) + c3[c] * fmin;
+		} else {
+			for (int c = 0; c < 3; c++) {
+				float c00 = c000[c] + (c000[d0 + c] - c000[c]) * f[0];
+				float c10 = c000[d1 + c] + (c000[d1 + d0 + c] - c000[d1 + c]) * f[0];
+				float c01 = c000[d2 + c] + (c000[d2 + d0 + c] - c000[d2 + c]) * f[0];
+				float c11 = c000[d2 + d1 + c] + (c000[d2 + d1 + d0 + c] - c000[d2 + d1 + c]) * f[0];
+				float c0 = c00 + (c10 - c00) * f[1], c1 = c01 + (c11 - c01) * f[1];
+				dst[c] = c0 + (c1 - c0) * f[2];
+			}
+		}
+		if (chs == 4)
+			dst[3] = alpha;
+	}
+}
+
+template<typename _Tp, int chs>
+int Lut3D<_Tp, chs>::apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const
+{
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			if (sizeof(_Tp) == 1)
+				applyRow_8u((const uchar*)src.ptr(i), (uchar*)dst.ptr(i), src.cols);
+			else
+				applyRow_32f((const float*)src.ptr(i), (float*)dst.ptr(i), src.cols);
+		}
+	}, src.total() / (double)(1 << 14));
+
+	return 0;
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_LUT_HPP_
@@ -11,6 +11,8 @@
 
 #include <vector>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 
 #ifndef __cplusplus
 	#error merge.hpp header must be compiled as C++
@@ -18,41 +20,96 @@
 
 namespace fbc {
 
+template<typename _Tp, int chs> static void mergePlanes(const _Tp* const* src, const size_t* srcstep, Mat_<_Tp, chs>& dst);
+
 // merge several arrays to make a single multi-channel array
+// dst is created when it is empty, the arrays may be submatrices
 template<typename _Tp, int chs1, int chs2>
 int merge(const std::vector<Mat_<_Tp, chs1>>& src, Mat_<_Tp, chs2>& dst)
 {
-	FBC_Assert(dst.data != NULL);
-	FBC_Assert((src.size() > 0) && (src.size() == dst.channels) && (src.size() <= FBC_CN_MAX));
+	FBC_Assert((src.size() > 0) && (src.size() == chs2) && (src.size() <= FBC_CN_MAX) && (chs1 == 1));
 	int width = src[0].cols;
 	int height = src[0].rows;
+	if (dst.empty())
+		dst.create(height, width);
 	FBC_Assert((dst.cols == width) && (dst.rows == height));
-	for (int i = 0; i < src.size(); i++) {
+
+	const _Tp* planes[chs2];
+	size_t steps[chs2];
+	for (int i = 0; i < chs2; i++) {
 		FBC_Assert(src[i].data != NULL);
 		FBC_Assert((src[i].cols == width) && src[i].rows == height);
-		FBC_Assert(src[i].channels == 1);
+		planes[i] = (const _Tp*)src[i].ptr();
+		steps[i] = src[i].step;
 	}
 
-	if (src.size() == 1) {
-		memcpy(dst.data, src[0].data, dst.step * dst.rows);
-		return 0;
+	mergePlanes(planes, steps, dst);
+
+	return 0;
+}
+
+// merge the chs single-channel arrays src[0], ..., src[chs - 1] to make a multi-channel array
+template<typename _Tp, int chs>
+int merge(const Mat_<_Tp, 1>* src, Mat_<_Tp, chs>& dst)
+{
+	FBC_Assert(src != NULL && src[0].data != NULL);
+	dst.create(src[0].rows, src[0].cols);
+
+	const _Tp* planes[chs];
+	size_t steps[chs];
+	for (int i = 0; i < chs; i++) {
+		FBC_Assert(src[i].data != NULL && src[i].size() == dst.size());
+		planes[i] = (const _Tp*)src[i].ptr();
+		steps[i] = src[i].step;
 	}
 
-	_Tp* pDst = (_Tp*)dst.data;
-	int len = width * height;
-	int cn = dst.channels;
+	mergePlanes(planes, steps, dst);
 
-	for (int i = 0; i < src.size(); i++) {
-		_Tp* pSrc = (_Tp*)src[i].data;
+	return 0;
+}
 
-		for (int j = 0; j < len; j++) {
-			pDst[j * cn + i] = pSrc[j];
-		}
+// merge the planes src[0], ..., src[chs - 1] into the allocated dst: row y of channel i is read at
+// (const uchar*)src[i] + y * srcstep, e.g. the CHW output blob of a network
+template<typename _Tp, int chs>
+int merge(const _Tp* const* src, size_t srcstep, Mat_<_Tp, chs>& dst)
+{
+	FBC_Assert(src != NULL && dst.data != NULL);
+
+	size_t steps[chs];
+	for (int i = 0; i < chs; i++) {
+		FBC_Assert(src[i] != NULL);
+		steps[i] = srcstep;
 	}
 
+	mergePlanes(src, steps, dst);
+
 	return 0;
 }
 
+// interleaves the rows of the planes in one pass over dst (see hal::merge8u), the rows are processed in parallel
+template<typename _Tp, int chs>
+static void mergePlanes(const _Tp* const* src, const size_t* srcstep, Mat_<_Tp, chs>& dst)
+{
+	FBC_Assert(sizeof(_Tp) == 1 || sizeof(_Tp) == 2 || sizeof(_Tp) == 4 || sizeof(_Tp) == 8);
+
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		const _Tp* planes[chs];
+
+		for (int y = range.start; y < range.end; y++) {
+			for (int i = 0; i < chs; i++)
+				planes[i] = (const _Tp*)((const uchar*)src[i] + y * srcstep[i]);
+
+			_Tp* row = (_Tp*)dst.ptr(y);
+			switch (sizeof(_Tp)) {
+				case 1: hal::merge8u((const uchar**)planes, (uchar*)row, dst.cols, chs); break;
+				case 2: hal::merge16u((const ushort**)planes, (ushort*)row, dst.cols, chs); break;
+				case 4: hal::merge32s((const int**)planes, (int*)row, dst.cols, chs); break;
+				default: hal::merge64s((const int64**)planes, (int64*)row, dst.cols, chs); break;
+			}
+		}
+	}, dst.total() * chs / (double)(1 << 16));
+}
+
 } // namespace fbc
 
 #endif // FBC_CV_MERGE_HPP_
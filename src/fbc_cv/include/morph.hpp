@@ -11,6 +11,7 @@
 #include <typeinfo>
 #include "core/mat.hpp"
 #include "core/Ptr.hpp"
+#include "core/core.hpp"
 #include "imgproc.hpp"
 #include "filterengine.hpp"
 
@@ -32,15 +33,6 @@ template<typename T> struct MaxOp
 	T operator ()(const T a, const T b) const { return std::max(a, b); }
 };
 
-#undef CV_MIN_8U
-#undef CV_MAX_8U
-#define CV_FAST_CAST_8U(t)	(assert(-256 <= (t) && (t) <= 512), icvSaturate8u_cv[(t)+256])
-#define CV_MIN_8U(a,b)		((a) - CV_FAST_CAST_8U((a) - (b)))
-#define CV_MAX_8U(a,b)		((a) + CV_FAST_CAST_8U((b) - (a)))
-
-template<> inline uchar MinOp<uchar>::operator ()(const uchar a, const uchar b) const { return CV_MIN_8U(a, b); }
-template<> inline uchar MaxOp<uchar>::operator ()(const uchar a, const uchar b) const { return CV_MAX_8U(a, b); }
-
 struct MorphRowNoVec
 {
 	MorphRowNoVec(int, int) {}
@@ -250,6 +242,124 @@ template<class Op, class VecOp> struct MorphFilter : BaseFilter
 	VecOp vecOp;
 };
 
+// the van Herk/Gil-Werman filters are used from this kernel size, below it the direct filters are faster
+const int MORPH_VHG_MIN_KSIZE = 9;
+
+// horizontal van Herk/Gil-Werman min/max filter: the row is cut into blocks of ksize pixels, g is the running
+// min/max from the start of each block and h the one to its end, then
+// dst[i] = op(src[i], ..., src[i + ksize - 1]) = op(h[i], g[i + ksize - 1]), ~3 operations per pixel whatever ksize is
+template<class Op> struct MorphRowFilterVHG : public BaseRowFilter
+{
+	typedef typename Op::rtype T;
+
+	MorphRowFilterVHG(int _ksize, int _anchor)
+	{
+		ksize = _ksize;
+		anchor = _anchor;
+	}
+
+	void operator()(const uchar* src, uchar* dst, int width, int cn)
+	{
+		int i, b, n = (width + ksize - 1)*cn, _ksize = ksize*cn;
+		const T* S = (const T*)src;
+		T* D = (T*)dst;
+		Op op;
+
+		g.resize(n);
+		h.resize(n);
+
+		for (b = 0; b < n; b += _ksize) {
+			int e = std::min(b + _ksize, n);
+
+			for (i = b; i < b + cn; i++)
+				g[i] = S[i];
+			for (; i < e; i++)
+				g[i] = op(g[i - cn], S[i]);
+
+			for (i = e - 1; i >= e - cn; i--)
+				h[i] = S[i];
+			for (; i >= b; i--)
+				h[i] = op(h[i + cn], S[i]);
+		}
+
+		const T* G = &g[_ksize - cn];
+		for (i = 0; i < width*cn; i++)
+			D[i] = op(h[i], G[i]);
+	}
+
+	std::vector<T> g, h;
+};
+
+// vertical van Herk/Gil-Werman min/max filter, the output rows are processed in blocks of ksize rows:
+// the running min/max of the first ksize source rows from the bottom is written to the output rows,
+// then the one of the next rows from the top is merged into them. the cost per output row is
+// ~4 row operations when the filter engine provides ksize output rows per call, hence bufferRows()
+template<class Op> struct MorphColumnFilterVHG : public BaseColumnFilter
+{
+	typedef typename Op::rtype T;
+
+	MorphColumnFilterVHG(int _ksize, int _anchor)
+	{
+		ksize = _ksize;
+		anchor = _anchor;
+	}
+
+	void operator()(const uchar** _src, uchar* dst, int dststep, int count, int width)
+	{
+		int i, t;
+		const T** src = (const T**)_src;
+		Op op;
+
+		dststep /= sizeof(T);
+		buf.resize(width);
+		T* G = &buf[0];
+
+		for (; count > 0; count -= ksize, src += ksize, dst += dststep*ksize*sizeof(T)) {
+			int m = std::min(count, ksize);
+			T* D = (T*)dst;
+
+			// D[t] = op(src[t], ..., src[ksize - 1])
+			T* Dt = D + (m - 1)*dststep;
+			const T* sptr = src[ksize - 1];
+			for (i = 0; i < width; i++)
+				Dt[i] = sptr[i];
+			for (t = ksize - 2; t >= m - 1; t--) {
+				sptr = src[t];
+				for (i = 0; i < width; i++)
+					Dt[i] = op(Dt[i], sptr[i]);
+			}
+			for (t = m - 2; t >= 0; t--, Dt -= dststep) {
+				T* Dn = Dt - dststep;
+				sptr = src[t];
+				for (i = 0; i < width; i++)
+					Dn[i] = op(Dt[i], sptr[i]);
+			}
+
+			// D[t] = op(D[t], src[ksize], ..., src[ksize + t - 1])
+			if (m > 1) {
+				sptr = src[ksize];
+				Dt = D + dststep;
+				for (i = 0; i < width; i++) {
+					G[i] = sptr[i];
+					Dt[i] = op(Dt[i], G[i]);
+				}
+				for (t = 2; t < m; t++) {
+					sptr = src[ksize + t - 1];
+					Dt = D + t*dststep;
+					for (i = 0; i < width; i++) {
+						G[i] = op(G[i], sptr[i]);
+						Dt[i] = op(Dt[i], G[i]);
+					}
+				}
+			}
+		}
+	}
+
+	int bufferRows() const { return ksize * 2 - 1; }
+
+	std::vector<T> buf;
+};
+
 // returns horizontal 1D morphological filter
 template<typename _Tp, int chs>
 Ptr<BaseRowFilter> getMorphologyRowFilter(int op, int ksize, int anchor = -1)
@@ -260,17 +370,25 @@ Ptr<BaseRowFilter> getMorphologyRowFilter(int op, int ksize, int anchor = -1)
 
 	if (op == MORPH_ERODE) {
 		if (typeid(uchar).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphRowFilterVHG<MinOp<uchar> > >(ksize, anchor);
 			return makePtr<MorphRowFilter<MinOp<uchar>, MorphRowNoVec> >(ksize, anchor);
 		}
 		if (typeid(float).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphRowFilterVHG<MinOp<float> > >(ksize, anchor);
 			return makePtr<MorphRowFilter<MinOp<float>, MorphRowNoVec> >(ksize, anchor);
 		}
 	}
 	else {
 		if (typeid(uchar).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphRowFilterVHG<MaxOp<uchar> > >(ksize, anchor);
 			return makePtr<MorphRowFilter<MaxOp<uchar>, MorphRowNoVec> >(ksize, anchor);
 		}
 		if (typeid(float).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphRowFilterVHG<MaxOp<float> > >(ksize, anchor);
 			return makePtr<MorphRowFilter<MaxOp<float>, MorphRowNoVec> >(ksize, anchor);
 		}
 	}
@@ -289,16 +407,24 @@ Ptr<BaseColumnFilter> getMorphologyColumnFilter(int op, int ksize, int anchor =
 
 	if (op == MORPH_ERODE) {
 		if (typeid(uchar).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphColumnFilterVHG<MinOp<uchar> > >(ksize, anchor);
 			return makePtr<MorphColumnFilter<MinOp<uchar>, MorphColumnNoVec> >(ksize, anchor);
 		}
 		if (typeid(float).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphColumnFilterVHG<MinOp<float> > >(ksize, anchor);
 			return makePtr<MorphColumnFilter<MinOp<float>, MorphColumnNoVec> >(ksize, anchor);
 		}
 	} else {
 		if (typeid(uchar).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphColumnFilterVHG<MaxOp<uchar> > >(ksize, anchor);
 			return makePtr<MorphColumnFilter<MaxOp<uchar>, MorphColumnNoVec> >(ksize, anchor);
 		}
 		if (typeid(float).name() == typeid(_Tp).name()) {
+			if (ksize >= MORPH_VHG_MIN_KSIZE)
+				return makePtr<MorphColumnFilterVHG<MaxOp<float> > >(ksize, anchor);
 			return makePtr<MorphColumnFilter<MaxOp<float>, MorphColumnNoVec> >(ksize, anchor);
 		}
 	}
@@ -334,6 +460,207 @@ Ptr<BaseFilter> getMorphologyFilter(int op, Mat_<uchar, 1> kernel, Point anchor
 	return Ptr<BaseFilter>();
 }
 
+// the iterations of a rectangular kernel are merged into one larger kernel, an empty kernel is a 3x3 rectangle
+// returns false when the operation is a copy
+inline bool preprocessMorphKernel(const Mat_<uchar, 1>& kernel, Mat_<uchar, 1>& kernel_, Point& anchor, int& iterations)
+{
+	Size ksize = !kernel.empty() ? kernel.size() : Size(3, 3);
+	anchor = normalizeAnchor(anchor, ksize);
+
+	if (iterations == 0 || kernel.rows * kernel.cols == 1)
+		return false;
+
+	kernel_ = kernel;
+	if (kernel_.empty()) {
+		kernel_ = Mat_<uchar, 1>(1 + iterations * 2, 1 + iterations * 2);
+		getStructuringElement(kernel_, MORPH_RECT, Size(1 + iterations * 2, 1 + iterations * 2));
+		anchor = Point(iterations, iterations);
+		iterations = 1;
+	} else if (iterations > 1 && countNonZero(kernel_) == kernel_.rows * kernel_.cols) {
+		anchor = Point(anchor.x*iterations, anchor.y*iterations);
+		kernel_ = Mat_<uchar, 1>(ksize.height + (iterations - 1)*(ksize.height - 1), ksize.width + (iterations - 1)*(ksize.width - 1));
+		getStructuringElement(kernel_, MORPH_RECT,
+			Size(ksize.width + (iterations - 1)*(ksize.width - 1), ksize.height + (iterations - 1)*(ksize.height - 1)), anchor);
+		iterations = 1;
+	}
+
+	anchor = normalizeAnchor(anchor, kernel_.size());
+	return true;
+}
+
+// splits a non-rectangular structuring element (cross, ellipse, ...) into rectangles which all contain the anchor,
+// the erosion/dilation by the element is then the min/max of the ones by the rectangles, each of them separable.
+// every row of the element must be one run of non-zeros, for each distinct run the rows containing it must be
+// consecutive. returns false when the element can't be split or when the generic 2D filter is cheaper
+template<typename _Tp>
+bool decomposeStructuringElement(const Mat_<uchar, 1>& kernel, Point anchor, std::vector<Rect>& rects)
+{
+	rects.clear();
+
+	std::vector<Point> runs(kernel.rows, Point(-1, -1)); // [x, y] of the non-zeros of each row, -1: empty row
+	int nz = 0;
+	for (int i = 0; i < kernel.rows; i++) {
+		const uchar* krow = kernel.ptr(i);
+		int x0 = -1, x1 = -1;
+		for (int j = 0; j < kernel.cols; j++) {
+			if (krow[j] == 0)
+				continue;
+			if (x0 < 0)
+				x0 = j;
+			else if (x1 != j - 1)
+				return false; // two runs in the row
+			x1 = j;
+			nz++;
+		}
+		runs[i] = Point(x0, x1);
+	}
+
+	if (nz == 0)
+		return false;
+
+	for (int i = 0; i < kernel.rows; i++) {
+		Point run = runs[i];
+		if (run.x < 0)
+			continue;
+
+		bool found = false;
+		for (size_t k = 0; k < rects.size(); k++) {
+			if (rects[k].x == run.x && rects[k].width == run.y - run.x + 1)
+				found = true;
+		}
+		if (found)
+			continue;
+
+		int y0 = -1, y1 = -1;
+		for (int y = 0; y < kernel.rows; y++) {
+			if (runs[y].x < 0 || runs[y].x > run.x || runs[y].y < run.y)
+				continue;
+			if (y0 < 0)
+				y0 = y;
+			else if (y1 != y - 1)
+				return false;
+			y1 = y;
+		}
+
+		Rect r(run.x, y0, run.y - run.x + 1, y1 - y0 + 1);
+		if (!anchor.inside(r))
+			return false;
+		rects.push_back(r);
+	}
+
+	// a rectangle (two passes over the image and the merge) costs about as much as 32 (8 bits) or 16 (float)
+	// elements of the 2D filter
+	return rects.size() > 1 && nz > (sizeof(_Tp) == 1 ? 32 : 16) * (int)rects.size();
+}
+
+// creates the morphological filter engine of the kernel, separable for a rectangular kernel
+// op: MORPH_ERODE/MORPH_DILATE
+template<typename _Tp, int chs>
+Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>> createMorphologyFilter(int op, const Mat_<uchar, 1>& kernel, Point anchor,
+	int borderType = BORDER_CONSTANT, const Scalar& borderValue = Scalar::all(DBL_MAX))
+{
+	FBC_Assert(op == MORPH_ERODE || op == MORPH_DILATE);
+	anchor = normalizeAnchor(anchor, kernel.size());
+
+	Ptr<BaseRowFilter> rowFilter;
+	Ptr<BaseColumnFilter> columnFilter;
+	Ptr<BaseFilter> filter2D;
+
+	if (countNonZero(kernel) == kernel.rows*kernel.cols) {
+		// rectangular structuring element
+		rowFilter = getMorphologyRowFilter<_Tp, chs>(op, kernel.cols, anchor.x);
+		columnFilter = getMorphologyColumnFilter<_Tp, chs>(op, kernel.rows, anchor.y);
+	} else {
+		filter2D = getMorphologyFilter<_Tp, chs>(op, kernel, anchor);
+	}
+
+	Scalar borderValue_ = borderValue;
+	if (borderType == BORDER_CONSTANT && borderValue_ == Scalar::all(DBL_MAX)) {
+		if (sizeof(_Tp) == 1) // CV_8U
+			borderValue_ = Scalar::all(op == MORPH_ERODE ? (double)UCHAR_MAX : 0.);
+		else // CV_32F
+			borderValue_ = Scalar::all(op == MORPH_ERODE ? (double)FLT_MAX : (double)-FLT_MAX);
+	}
+
+	return makePtr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>>(filter2D, rowFilter, columnFilter, borderType, borderType, borderValue_);
+}
+
+// dst = min(dst, src) (MORPH_ERODE) or max(dst, src) (MORPH_DILATE)
+template<typename _Tp, int chs>
+void combineMorphology(int op, const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+{
+	int width = src.cols * chs;
+
+	for (int y = 0; y < src.rows; y++) {
+		const _Tp* s = (const _Tp*)src.ptr(y);
+		_Tp* d = (_Tp*)dst.ptr(y);
+
+		if (op == MORPH_ERODE) {
+			for (int x = 0; x < width; x++)
+				d[x] = std::min(d[x], s[x]);
+		} else {
+			for (int x = 0; x < width; x++)
+				d[x] = std::max(d[x], s[x]);
+		}
+	}
+}
+
+// erosion/dilation shared by erode and dilate, op: MORPH_ERODE/MORPH_DILATE
+// rectangular kernels go through the separable filters (van Herk/Gil-Werman from MORPH_VHG_MIN_KSIZE),
+// large crosses/ellipses are split into rectangles by decomposeStructuringElement, the other kernels use the 2D filter
+template<typename _Tp, int chs>
+int morphOp(int op, const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, const Mat_<uchar, 1>& kernel,
+	Point anchor, int iterations, int borderType, const Scalar& borderValue)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	Mat_<uchar, 1> kernel_;
+	if (!preprocessMorphKernel(kernel, kernel_, anchor, iterations)) {
+		src.copyTo(dst);
+		return 0;
+	}
+
+	std::vector<Rect> rects;
+	if (decomposeStructuringElement<_Tp>(kernel_, anchor, rects)) {
+		std::vector<Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>>> f(rects.size());
+		for (size_t k = 0; k < rects.size(); k++) {
+			Mat_<uchar, 1> r(rects[k].height, rects[k].width, Scalar::all(1));
+			f[k] = createMorphologyFilter<_Tp, chs>(op, r, anchor - rects[k].tl(), borderType, borderValue);
+		}
+
+		Mat_<_Tp, chs> temp(src.rows, src.cols);
+		for (int i = 0; i < iterations; i++) {
+			const Mat_<_Tp, chs>& in = i == 0 ? src : dst;
+			Mat_<_Tp, chs> out = dst;
+			if (in.data == dst.data)
+				out = Mat_<_Tp, chs>(src.rows, src.cols);
+
+			f[0]->apply(in, out);
+			for (size_t k = 1; k < rects.size(); k++) {
+				f[k]->apply(in, temp);
+				combineMorphology(op, temp, out);
+			}
+
+			if (out.data != dst.data)
+				out.copyTo(dst);
+		}
+
+		return 0;
+	}
+
+	Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>> f = createMorphologyFilter<_Tp, chs>(op, kernel_, anchor, borderType, borderValue);
+	f->apply(src, dst);
+	for (int i = 1; i < iterations; i++)
+		f->apply(dst, dst);
+
+	return 0;
+}
+
 } // namespace fbc
 
 #endif // FBC_CV_MORPH_HPP_
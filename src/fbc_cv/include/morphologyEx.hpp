@@ -11,9 +11,78 @@
 #include <typeinfo>
 #include "erode.hpp"
 #include "dilate.hpp"
+#include "filterpipeline.hpp"
 
 namespace fbc {
 
+// dst = f2(f1(src)) without the intermediate image, the rows filtered by f1 are passed to f2 by blocks
+// through a FilterPipeline. src and dst may be the same matrix
+template<typename _Tp, int chs>
+void morphologyChain(const Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>>& f1, const Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>>& f2,
+	const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+{
+	if (src.rows * src.cols == 0)
+		return;
+
+	FilterPipeline pipeline;
+	pipeline.add(f1);
+	pipeline.add(f2);
+
+	int y = pipeline.start(src, std::max(f1->ksize.height, 16));
+	pipeline.proceed(src.ptr() + y*src.step, (int)src.step, pipeline.remainingInputRows(), dst.ptr(), (int)dst.step);
+}
+
+// dst = dilate(src) - erode(src), computed by blocks of rows without the eroded image. src and dst may be the same matrix
+template<typename _Tp, int chs>
+void morphologyGradient(FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>& fe, FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>& fd,
+	const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+{
+	if (src.rows * src.cols == 0)
+		return;
+
+	int y = fe.start(src);
+	fd.start(src);
+
+	int blockRows = std::max(fe.ksize.height, 16);
+	Mat_<_Tp, chs> buf(blockRows + fe.ksize.height, src.cols);
+
+	const uchar* sptr = src.ptr() + y*src.step;
+	int dstY = 0, width = src.cols * chs;
+
+	while (fe.remainingInputRows() > 0) {
+		int count = std::min(blockRows, fe.remainingInputRows());
+		// the source rows are read by the erosion before the dilation writes the ones of dst
+		int dy = fe.proceed(sptr, (int)src.step, count, buf.ptr(), (int)buf.step);
+		int dy2 = fd.proceed(sptr, (int)src.step, count, dst.ptr(dstY), (int)dst.step);
+		FBC_Assert(dy == dy2);
+		(void)dy2;
+		sptr += count*src.step;
+
+		for (int i = 0; i < dy; i++) {
+			const _Tp* e = (const _Tp*)buf.ptr(i);
+			_Tp* d = (_Tp*)dst.ptr(dstY + i);
+			for (int x = 0; x < width; x++)
+				d[x] = saturate_cast<_Tp>(d[x] - e[x]);
+		}
+		dstY += dy;
+	}
+}
+
+// dst = src1 - src2, dst may be src1 or src2
+template<typename _Tp, int chs>
+void subtractMorphology(const Mat_<_Tp, chs>& src1, const Mat_<_Tp, chs>& src2, Mat_<_Tp, chs>& dst)
+{
+	int width = src1.cols * chs;
+
+	for (int y = 0; y < src1.rows; y++) {
+		const _Tp* s1 = (const _Tp*)src1.ptr(y);
+		const _Tp* s2 = (const _Tp*)src2.ptr(y);
+		_Tp* d = (_Tp*)dst.ptr(y);
+		for (int x = 0; x < width; x++)
+			d[x] = saturate_cast<_Tp>(s1[x] - s2[x]);
+	}
+}
+
 // perform advanced morphological transformations using an erosion and dilation as basic operations
 // In case of multi - channel images, each channel is processed independently.
 // morphologyEx can be applied several ( iterations ) times.
@@ -36,6 +105,54 @@ int morphologyEx(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int op, const M
 		getStructuringElement(kernel_, MORPH_RECT, Size(3, 3), Point(1, 1));
 	}
 
+	// opening, closing and gradient in one pass when each of them is a single erosion and dilation by the same
+	// filter, the intermediate image is not allocated
+	if (op == MORPH_OPEN || op == MORPH_CLOSE || op == MORPH_GRADIENT || op == MORPH_TOPHAT || op == MORPH_BLACKHAT) {
+		Mat_<uchar, 1> kernel1;
+		Point anchor1 = anchor;
+		int iterations1 = iterations;
+		std::vector<Rect> rects;
+
+		if (preprocessMorphKernel(kernel_, kernel1, anchor1, iterations1) && iterations1 == 1 &&
+			!decomposeStructuringElement<_Tp>(kernel1, anchor1, rects)) {
+			Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>> fe = createMorphologyFilter<_Tp, chs>(MORPH_ERODE, kernel1, anchor1, borderType, borderValue);
+			Ptr<FilterEngine<_Tp, _Tp, _Tp, chs, chs, chs>> fd = createMorphologyFilter<_Tp, chs>(MORPH_DILATE, kernel1, anchor1, borderType, borderValue);
+
+			switch (op) {
+				case MORPH_OPEN: {
+					morphologyChain(fe, fd, src, dst);
+					break;
+				}
+				case MORPH_CLOSE: {
+					morphologyChain(fd, fe, src, dst);
+					break;
+				}
+				case MORPH_GRADIENT: {
+					morphologyGradient(*fe, *fd, src, dst);
+					break;
+				}
+				case MORPH_TOPHAT: {
+					Mat_<_Tp, chs> temp = dst;
+					if (src.data == dst.data)
+						temp = Mat_<_Tp, chs>(src.rows, src.cols);
+					morphologyChain(fe, fd, src, temp);
+					subtractMorphology(src, temp, dst);
+					break;
+				}
+				case MORPH_BLACKHAT: {
+					Mat_<_Tp, chs> temp = dst;
+					if (src.data == dst.data)
+						temp = Mat_<_Tp, chs>(src.rows, src.cols);
+					morphologyChain(fd, fe, src, temp);
+					subtractMorphology(temp, src, dst);
+					break;
+				}
+			}
+
+			return 0;
+		}
+	}
+
 	switch (op) {
 		case MORPH_ERODE: {
 			erode(src, dst, kernel_, anchor, iterations, borderType, borderValue);
@@ -0,0 +1,435 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_PYRAMIDS_HPP_
+#define FBC_CV_PYRAMIDS_HPP_
+
+/* reference: include/opencv2/imgproc.hpp
+              modules/imgproc/src/pyramids.cpp
+*/
+
+#include <limits.h>
+#include <typeinfo>
+#include <vector>
+#include "core/mat.hpp"
+#include "core/core.hpp"
+#include "core/utility.hpp"
+#include "core/hal.hpp"
+#include "imgproc.hpp"
+
+namespace fbc {
+
+// the sums of the pyramid filters: int with 8 (pyrDown) or 6 (pyrUp) fractional bits for uchar, float for float
+template<typename _Tp> struct PyrTypes;
+template<> struct PyrTypes<uchar>
+{
+	typedef int WT;
+	typedef FixedPtCast<int, uchar, 8> DownCast;
+	typedef FixedPtCast<int, uchar, 6> UpCast;
+};
+template<> struct PyrTypes<float>
+{
+	typedef float WT;
+	typedef FltCast<float, 8> DownCast;
+	typedef FltCast<float, 6> UpCast;
+};
+
+// the optimized parts of the pyramid filters, they return the next element to be processed by the plain C++ code
+template<typename T, typename WT>
+static inline int pyrDownRowVec(const T*, WT*, int x, int, int, int) { return x; }
+static inline int pyrDownRowVec(const uchar* src, int* row, int x, int width0, int swidth, int cn)
+{
+	// the last source element read by the kernel is src[x * 2 + 3]
+	int n = std::min(width0, (swidth - 2) / 2) - x;
+	return cn == 1 && n > 0 ? x + hal::pyrDownRow8u32s(src + x * 2, row + x, n) : x;
+}
+
+template<typename WT, typename T>
+static inline int pyrDownVec(const WT**, T*, int) { return 0; }
+static inline int pyrDownVec(const int** src, uchar* dst, int width)
+{
+	return hal::pyrDownColumn32s8u(src, dst, width);
+}
+
+template<typename T, typename WT>
+static inline int pyrUpRowVec(const T*, WT*, int x, int, int) { return x; }
+static inline int pyrUpRowVec(const uchar* src, int* row, int x, int swidth, int cn)
+{
+	int n = swidth - cn - x;
+	return cn == 1 && n > 0 ? x + hal::pyrUpRow8u32s(src + x, row + x * 2, n) : x;
+}
+
+template<typename WT, typename T>
+static inline int pyrUpVec(const WT**, T*, T*, int) { return 0; }
+static inline int pyrUpVec(const int** src, uchar* dst0, uchar* dst1, int width)
+{
+	return hal::pyrUpColumn32s8u(src, dst0, dst1, width);
+}
+
+// pyrDown of one image as a row stream: the ring buffer holds the last 5 source rows filtered by [1 4 6 4 1] and
+// decimated horizontally, every destination row is produced as soon as its source rows are available, so a pyramid
+// can be built level by level with the rows of a level still in the cache (see Pyramid)
+template<typename _Tp, int chs>
+class PyrDownRows {
+public:
+	typedef typename PyrTypes<_Tp>::WT WT;
+	typedef typename PyrTypes<_Tp>::DownCast CastOp;
+	enum { PD_SZ = 5 };
+
+	PyrDownRows() : borderType(BORDER_DEFAULT), width0(0), bufstep(0), sy(0), dy(0) {}
+
+	// starts the filtering of src to dst, the buffers of the previous image are reused
+	void init(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, int _borderType)
+	{
+		FBC_Assert(_borderType != BORDER_CONSTANT);
+		FBC_Assert(_src.rows > 0 && _src.cols > 0 && std::abs(_dst.cols * 2 - _src.cols) <= 2 && std::abs(_dst.rows * 2 - _src.rows) <= 2);
+		src = _src;
+		dst = _dst;
+		borderType = _borderType;
+
+		const int cn = chs;
+		int swidth = src.cols, dwidth = dst.cols;
+		width0 = std::min((swidth - PD_SZ / 2 - 1) / 2 + 1, dwidth);
+
+		for (int x = 0; x <= PD_SZ + 1; x++) {
+			int sx0 = borderInterpolate<int>(x - PD_SZ / 2, swidth, borderType)*cn;
+			int sx1 = borderInterpolate<int>(x + width0 * 2 - PD_SZ / 2, swidth, borderType)*cn;
+			for (int k = 0; k < cn; k++) {
+				tabL[x*cn + k] = sx0 + k;
+				tabR[x*cn + k] = sx1 + k;
+			}
+		}
+
+		width0 *= cn;
+		bufstep = (int)alignSize(dwidth*cn, 16);
+		buf.resize(bufstep*PD_SZ);
+		tabM.resize(dwidth*cn);
+		for (int x = 0; x < dwidth*cn; x++)
+			tabM[x] = (x / cn) * 2 * cn + x % cn;
+
+		sy = -(PD_SZ / 2);
+		dy = 0;
+	}
+
+	// produces the destination rows whose source rows are among the first srcRows rows, at most maxRows rows in all;
+	// returns the number of produced rows
+	int proceed(int srcRows, int maxRows = INT_MAX)
+	{
+		const int cn = chs, sy0 = -(PD_SZ / 2);
+		int sheight = src.rows, swidth = src.cols*cn, dwidth = dst.cols*cn;
+		int dheight = std::min(dst.rows, maxRows);
+		CastOp castOp;
+		WT* rows[PD_SZ];
+
+		for (; dy < dheight; dy++) {
+			int need = 0;
+			for (int k = -(PD_SZ / 2); k <= PD_SZ / 2; k++)
+				need = std::max(need, borderInterpolate<int>(dy * 2 + k, sheight, borderType));
+			if (need >= srcRows)
+				break;
+
+			// fill the ring buffer (horizontal convolution and decimation)
+			for (; sy <= dy * 2 + 2; sy++) {
+				WT* row = &buf[((sy - sy0) % PD_SZ)*bufstep];
+				const _Tp* s = (const _Tp*)src.ptr(borderInterpolate<int>(sy, sheight, borderType));
+				const int* tab = tabL;
+				int limit = cn, x0 = 0, x;
+
+				for (x = 0;;) {
+					for (; x < limit; x++) {
+						const int* t = tab + x - x0;
+						row[x] = s[t[cn * 2]] * 6 + (s[t[cn]] + s[t[cn * 3]]) * 4 + s[t[0]] + s[t[cn * 4]];
+					}
+
+					if (x == dwidth)
+						break;
+
+					x = pyrDownRowVec(s, row, x, width0, swidth, cn);
+					if (cn == 1) {
+						for (; x < width0; x++)
+							row[x] = s[x * 2] * 6 + (s[x * 2 - 1] + s[x * 2 + 1]) * 4 + s[x * 2 - 2] + s[x * 2 + 2];
+					} else if (cn == 3) {
+						for (; x < width0; x += 3) {
+							const _Tp* p = s + x * 2;
+							WT t0 = p[0] * 6 + (p[-3] + p[3]) * 4 + p[-6] + p[6];
+							WT t1 = p[1] * 6 + (p[-2] + p[4]) * 4 + p[-5] + p[7];
+							WT t2 = p[2] * 6 + (p[-1] + p[5]) * 4 + p[-4] + p[8];
+							row[x] = t0; row[x + 1] = t1; row[x + 2] = t2;
+						}
+					} else if (cn == 4) {
+						for (; x < width0; x += 4) {
+							const _Tp* p = s + x * 2;
+							WT t0 = p[0] * 6 + (p[-4] + p[4]) * 4 + p[-8] + p[8];
+							WT t1 = p[1] * 6 + (p[-3] + p[5]) * 4 + p[-7] + p[9];
+							row[x] = t0; row[x + 1] = t1;
+							t0 = p[2] * 6 + (p[-2] + p[6]) * 4 + p[-6] + p[10];
+							t1 = p[3] * 6 + (p[-1] + p[7]) * 4 + p[-5] + p[11];
+							row[x + 2] = t0; row[x + 3] = t1;
+						}
+					} else {
+						for (; x < width0; x++) {
+							int sx = tabM[x];
+							row[x] = s[sx] * 6 + (s[sx - cn] + s[sx + cn]) * 4 + s[sx - cn * 2] + s[sx + cn * 2];
+						}
+					}
+
+					limit = dwidth;
+					tab = tabR;
+					x0 = x;
+				}
+			}
+
+			// do vertical convolution and decimation and write the result to the destination image
+			for (int k = 0; k < PD_SZ; k++)
+				rows[k] = &buf[((dy * 2 - PD_SZ / 2 + k - sy0) % PD_SZ)*bufstep];
+			const WT *row0 = rows[0], *row1 = rows[1], *row2 = rows[2], *row3 = rows[3], *row4 = rows[4];
+			_Tp* d = (_Tp*)dst.ptr(dy);
+
+			int x = pyrDownVec((const WT**)rows, d, dwidth);
+			for (; x < dwidth; x++)
+				d[x] = castOp(row2[x] * 6 + (row1[x] + row3[x]) * 4 + row0[x] + row4[x]);
+		}
+
+		return dy;
+	}
+
+	// the number of produced destination rows
+	int rowsDone() const { return dy; }
+
+private:
+	Mat_<_Tp, chs> src, dst;
+	int borderType;
+	int width0, bufstep;
+	int sy, dy;
+	int tabL[chs*(PD_SZ + 2)], tabR[chs*(PD_SZ + 2)];
+	std::vector<int> tabM;
+	std::vector<WT> buf;
+};
+
+// the size of the pyrDown result of an image of the size
+inline Size pyrDownSize(Size size)
+{
+	return Size((size.width + 1) / 2, (size.height + 1) / 2);
+}
+
+// builds levels[1] .. levels[maxlevel] from levels[0] in one pass: every row of a level is handed to the next level
+// right after it is produced, the level buffers and the ring buffers of states are reused when the sizes don't change
+template<typename _Tp, int chs>
+void pyrDownChain(std::vector<Mat_<_Tp, chs>>& levels, std::vector<PyrDownRows<_Tp, chs>>& states, int maxlevel, int borderType)
+{
+	FBC_Assert((int)levels.size() >= maxlevel + 1 && (int)states.size() >= maxlevel);
+
+	for (int i = 1; i <= maxlevel; i++) {
+		Size size = pyrDownSize(levels[i - 1].size());
+		levels[i].create(size.height, size.width);
+		states[i - 1].init(levels[i - 1], levels[i], borderType);
+	}
+
+	if (maxlevel == 0)
+		return;
+
+	for (int y = 0; y < levels[1].rows; y++) {
+		states[0].proceed(levels[0].rows, y + 1);
+		for (int i = 1; i < maxlevel; i++)
+			states[i].proceed(states[i - 1].rowsDone());
+	}
+}
+
+// Blurs an image and downsamples it
+// By default, size of the output image is computed as Size((src.cols+1)/2, (src.rows+1)/2), but in
+// any case, the following conditions should be satisfied:
+// \f[\begin{array}{l} | \texttt{dstsize.width} *2-src.cols| \leq 2 \\ | \texttt{dstsize.height} *2-src.rows| \leq 2 \end{array}\f]
+// The function convolves the source image with the 5x5 Gaussian kernel [1 4 6 4 1]^T [1 4 6 4 1] / 256
+// and then downsamples the image by rejecting even rows and columns.
+// support type: uchar/float, multi-channels; borderType: all but BORDER_CONSTANT
+template<typename _Tp, int chs>
+int pyrDown(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size dstsize = Size(), int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(!src.empty());
+	if (dstsize.area() == 0)
+		dstsize = pyrDownSize(src.size());
+	FBC_Assert(src.data != dst.data);
+	dst.create(dstsize.height, dstsize.width);
+
+	PyrDownRows<_Tp, chs> rows;
+	rows.init(src, dst, borderType);
+	rows.proceed(src.rows);
+
+	return 0;
+}
+
+// Upsamples an image and then blurs it
+// By default, size of the output image is computed as Size(src.cols\*2, (src.rows\*2), but in any
+// case, the following conditions should be satisfied:
+// \f[\begin{array}{l} | \texttt{dstsize.width} -src.cols*2| \leq  ( \texttt{dstsize.width}   \mod  2)  \\ | \texttt{dstsize.height} -src.rows*2| \leq  ( \texttt{dstsize.height}   \mod  2) \end{array}\f]
+// The function performs the upsampling step of the Gaussian pyramid construction, though it can
+// actually be used to construct the Laplacian pyramid. First, it upsamples the source image by
+// injecting even zero rows and columns and then convolves the result with the same kernel as in
+// pyrDown multiplied by 4.
+// support type: uchar/float, multi-channels; borderType: BORDER_DEFAULT
+template<typename _Tp, int chs>
+int pyrUp(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size dstsize = Size(), int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(borderType == BORDER_DEFAULT);
+	FBC_Assert(!src.empty());
+	if (dstsize.area() == 0)
+		dstsize = Size(src.cols * 2, src.rows * 2);
+	FBC_Assert(std::abs(dstsize.width - src.cols * 2) == dstsize.width % 2 && std::abs(dstsize.height - src.rows * 2) == dstsize.height % 2);
+	FBC_Assert(src.data != dst.data);
+	dst.create(dstsize.height, dstsize.width);
+
+	typedef typename PyrTypes<_Tp>::WT WT;
+	typedef typename PyrTypes<_Tp>::UpCast CastOp;
+	const int PU_SZ = 3, cn = chs;
+	Size ssize = src.size(), dsize = dst.size();
+	int bufstep = (int)alignSize((dsize.width + 1)*cn, 16);
+	std::vector<WT> _buf(bufstep*PU_SZ);
+	WT* buf = &_buf[0];
+	std::vector<int> _dtab(ssize.width*cn);
+	int* dtab = &_dtab[0];
+	WT* rows[PU_SZ];
+	CastOp castOp;
+
+	int k, x, sy0 = -PU_SZ / 2, sy = sy0;
+
+	ssize.width *= cn;
+	dsize.width *= cn;
+
+	for (x = 0; x < ssize.width; x++)
+		dtab[x] = (x / cn) * 2 * cn + x % cn;
+
+	for (int y = 0; y < ssize.height; y++) {
+		_Tp* dst0 = (_Tp*)dst.ptr(y * 2);
+		_Tp* dst1 = (_Tp*)dst.ptr(std::min(y * 2 + 1, dsize.height - 1));
+		WT *row0, *row1, *row2;
+
+		// fill the ring buffer (horizontal convolution and decimation)
+		for (; sy <= y + 1; sy++) {
+			WT* row = buf + ((sy - sy0) % PU_SZ)*bufstep;
+			int _sy = borderInterpolate<int>(sy * 2, ssize.height * 2, BORDER_REFLECT_101) / 2;
+			const _Tp* s = (const _Tp*)src.ptr(_sy);
+
+			if (ssize.width == cn) {
+				for (x = 0; x < cn; x++) {
+					row[x] = row[x + cn] = s[x] * 8;
+					if (dsize.width > ssize.width * 2)
+						row[(dst.cols - 1) * cn + x] = row[x + cn];
+				}
+				continue;
+			}
+
+			for (x = 0; x < cn; x++) {
+				int dx = dtab[x];
+				WT t0 = s[x] * 6 + s[x + cn] * 2;
+				WT t1 = (s[x] + s[x + cn]) * 4;
+				row[dx] = t0; row[dx + cn] = t1;
+				dx = dtab[ssize.width - cn + x];
+				int sx = ssize.width - cn + x;
+				t0 = s[sx - cn] + s[sx] * 7;
+				t1 = s[sx] * 8;
+				row[dx] = t0; row[dx + cn] = t1;
+
+				if (dsize.width > ssize.width * 2)
+					row[(dst.cols - 1) * cn + x] = row[dx + cn];
+			}
+
+			x = pyrUpRowVec(s, row, cn, ssize.width, cn);
+			for (; x < ssize.width - cn; x++) {
+				int dx = dtab[x];
+				WT t0 = s[x - cn] + s[x] * 6 + s[x + cn];
+				WT t1 = (s[x] + s[x + cn]) * 4;
+				row[dx] = t0;
+				row[dx + cn] = t1;
+			}
+		}
+
+		// do vertical convolution and decimation and write the result to the destination image
+		for (k = 0; k < PU_SZ; k++)
+			rows[k] = buf + ((y - PU_SZ / 2 + k - sy0) % PU_SZ)*bufstep;
+		row0 = rows[0]; row1 = rows[1]; row2 = rows[2];
+
+		x = pyrUpVec((const WT**)rows, dst0, dst1, dsize.width);
+		for (; x < dsize.width; x++) {
+			_Tp t1 = castOp((row1[x] + row2[x]) * 4);
+			_Tp t0 = castOp(row0[x] + row1[x] * 6 + row2[x]);
+			dst1[x] = t1; dst0[x] = t0;
+		}
+	}
+
+	if (dsize.height > ssize.height * 2) {
+		_Tp* dst0 = (_Tp*)dst.ptr(ssize.height * 2 - 2);
+		_Tp* dst2 = (_Tp*)dst.ptr(ssize.height * 2);
+		for (x = 0; x < dsize.width; x++)
+			dst2[x] = dst0[x];
+	}
+
+	return 0;
+}
+
+// Constructs the Gaussian pyramid for an image
+// The function constructs a vector of images and builds the Gaussian pyramid by recursively applying
+// pyrDown to the previously built pyramid layers, starting from `dst[0]==src`.
+// dst: destination vector of maxlevel+1 images of the same type as src. dst[0] will be the
+// same as src. dst[1] is the next pyramid layer, a smoothed and down-sized src, and so on.
+// The levels are computed in one pass over the rows (see pyrDownChain)
+// support type: uchar/float, multi-channels; borderType: all but BORDER_CONSTANT
+template<typename _Tp, int chs>
+int buildPyramid(const Mat_<_Tp, chs>& src, std::vector<Mat_<_Tp, chs>>& dst, int maxlevel, int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(borderType != BORDER_CONSTANT && maxlevel >= 0 && !src.empty());
+
+	dst.resize(maxlevel + 1);
+	src.copyTo(dst[0]);
+
+	std::vector<PyrDownRows<_Tp, chs>> states(maxlevel);
+	pyrDownChain(dst, states, maxlevel, borderType);
+
+	return 0;
+}
+
+// A Gaussian pyramid rebuilt frame after frame: the levels and the ring buffers of the filters are allocated once
+// and reused while the frame size doesn't change, all the levels are computed in one pass over the rows of the frame.
+// Level 0 shares the data of the last frame, the other levels are owned by the pyramid
+// support type: uchar/float, multi-channels
+template<typename _Tp, int chs>
+class Pyramid {
+public:
+	// maxlevel: the index of the last (smallest) level; borderType: all but BORDER_CONSTANT
+	Pyramid(int maxlevel = 5, int borderType = BORDER_DEFAULT) : maxlevel_(maxlevel), borderType_(borderType)
+	{
+		FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+		FBC_Assert(maxlevel >= 0 && borderType != BORDER_CONSTANT);
+		levels_.resize(maxlevel + 1);
+		states_.resize(maxlevel);
+	}
+
+	// rebuilds all the levels from src
+	int build(const Mat_<_Tp, chs>& src)
+	{
+		FBC_Assert(!src.empty());
+		levels_[0] = src;
+		pyrDownChain(levels_, states_, maxlevel_, borderType_);
+		return 0;
+	}
+
+	// the number of levels, maxlevel + 1
+	int levels() const { return maxlevel_ + 1; }
+	// the level, 0 is the frame of the last build()
+	const Mat_<_Tp, chs>& operator[](int level) const
+	{
+		FBC_Assert(level >= 0 && level <= maxlevel_);
+		return levels_[level];
+	}
+
+private:
+	int maxlevel_, borderType_;
+	std::vector<Mat_<_Tp, chs>> levels_;
+	std::vector<PyrDownRows<_Tp, chs>> states_;
+};
+
+} // namespace fbc
+
+#endif // FBC_CV_PYRAMIDS_HPP_
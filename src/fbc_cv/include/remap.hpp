@@ -8,10 +8,14 @@
               modules/imgproc/src/imgwarp.cpp
 */
 
+#include <limits.h>
 #include <typeinfo>
+#include <vector>
 #include "core/mat.hpp"
 #include "core/base.hpp"
 #include "core/core.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 #include "imgproc.hpp"
 #include "resize.hpp"
 
@@ -89,6 +93,95 @@ int remap(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst, const Mat_<_Tp2, c
 	return 0;
 }
 
+// Converts the float maps of remap to the fixed-point maps remap uses internally
+/*
+map1, map2: the x and the y coordinates as two Mat_<float, 1>, or (x, y) as Mat_<float, 2> with an empty map2
+dstmap1: the integer parts of (x, y)
+dstmap2: the fractional parts of y and x, INTER_BITS bits each, the index of the interpolation coefficients
+nninterpolation: the maps are for INTER_NEAREST, dstmap1 holds the rounded coordinates and dstmap2 is released
+*/
+// remap with the converted maps gives the same result as with the float maps, without converting
+// them on every call; the same as OpenCV convertMaps with dstmap1type = CV_16SC2
+template<typename _Tp2, typename _Tp3, int chs2, int chs3>
+int convertMaps(const Mat_<_Tp2, chs2>& map1, const Mat_<_Tp3, chs3>& map2, Mat_<short, 2>& dstmap1, Mat_<ushort, 1>& dstmap2, bool nninterpolation = false)
+{
+	FBC_Assert(map1.size().area() > 0);
+	FBC_Assert(typeid(float).name() == typeid(_Tp2).name() && typeid(float).name() == typeid(_Tp3).name());
+	FBC_Assert((chs2 == 2 && map2.empty()) || (chs2 == 1 && chs3 == 1 && map2.size() == map1.size()));
+
+	int rows = map1.rows, cols = map1.cols;
+	dstmap1.create(rows, cols);
+	if (nninterpolation)
+		dstmap2.release();
+	else
+		dstmap2.create(rows, cols);
+
+	parallel_for_(Range(0, rows), [&](const Range& range) {
+		for (int y = range.start; y < range.end; y++) {
+			short* XY = (short*)dstmap1.ptr(y);
+			ushort* A = nninterpolation ? NULL : (ushort*)dstmap2.ptr(y);
+			const float* sX = (const float*)map1.ptr(y);
+			const float* sY = chs2 == 1 ? (const float*)map2.ptr(y) : sX + 1;
+			int sstep = chs2; // the step of the coordinates of a map
+
+			if (nninterpolation) {
+				for (int x = 0; x < cols; x++) {
+					XY[x * 2] = saturate_cast<short>(sX[x * sstep]);
+					XY[x * 2 + 1] = saturate_cast<short>(sY[x * sstep]);
+				}
+			} else {
+				for (int x = 0; x < cols; x++) {
+					int sx = fbcRound(sX[x * sstep] * INTER_TAB_SIZE);
+					int sy = fbcRound(sY[x * sstep] * INTER_TAB_SIZE);
+					XY[x * 2] = saturate_cast<short>(sx >> INTER_BITS);
+					XY[x * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+					A[x] = (ushort)((sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1)));
+				}
+			}
+		}
+	}, map1.total() / (double)(1 << 16));
+
+	return 0;
+}
+
+// the bytes of the source pixels a destination tile of RemapPlan may read, half of the L2 cache of a recent core
+const int REMAP_TILE_CACHE_SIZE = 1 << 19;
+
+// Precomputed remap of a fixed geometry, e.g. the undistortion of the frames of a camera
+// the maps are converted to the fixed-point maps once (see convertMaps) and the destination is split into
+// tiles whose source footprint, the bounding box of the source pixels they read, fits in cacheSize bytes:
+// a strongly warped map gets smaller tiles than a nearly uniform one. the tiles are processed in parallel
+// the plan is immutable after the construction and apply() can be called from several threads at the same time
+template<typename _Tp, int chs>
+class RemapPlan {
+public:
+	// ssize: the size of the source images, map1/map2: the maps of remap, float maps or fixed-point maps
+	// (Mat_<short, 2> with an empty or a Mat_<ushort, 1> map2), the size of the maps is the destination size
+	template<typename _Tp2, typename _Tp3, int chs2, int chs3>
+	RemapPlan(Size ssize, const Mat_<_Tp2, chs2>& map1, const Mat_<_Tp3, chs3>& map2, int interpolation,
+		int borderMode = BORDER_CONSTANT, const Scalar& borderValue = Scalar(), int cacheSize = REMAP_TILE_CACHE_SIZE);
+
+	// remaps src to dst, src must have the planned source size, dst is created if it is empty
+	int apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const;
+
+	Size srcSize() const { return ssize; }
+	Size dstSize() const { return dsize; }
+	int interpolation() const { return inter; }
+	Size tileSize() const { return tile; }
+
+private:
+	// the largest square tile (a multiple of 16) whose source footprint fits in cacheSize
+	void initTiles(int cacheSize);
+
+	Size ssize, dsize;
+	int inter, borderMode;
+	Scalar borderValue;
+	Mat_<short, 2> xy; // the source pixel of every destination pixel
+	Mat_<ushort, 1> fxy; // the index of the interpolation coefficients, empty for INTER_NEAREST
+	const void* ctab;
+	Size tile;
+};
+
 template<typename _Tp>
 static inline void interpolateLinear(_Tp x, _Tp* coeffs)
 {
@@ -260,6 +353,19 @@ static void remapNearest(const Mat_<_Tp1, chs1>& _src, Mat_<_Tp1, chs1>& _dst, c
 	}
 }
 
+// optimized kernels of the runs of remapBilinear inside the source (see hal::remapBilinear8u ...), they return the
+// number of processed pixels; only the uchar fixed-point and the float paths have them
+template<typename T, typename AT>
+static inline int remapBilinearVec(const T*, size_t, int, T*, const short*, const ushort*, const AT*, int, int) { return 0; }
+static inline int remapBilinearVec(const uchar* S0, size_t sstep, int swidth, uchar* D, const short* XY, const ushort* FXY, const short* wtab, int cn, int width)
+{
+	return hal::remapBilinear8u(S0, sstep, swidth, D, XY, FXY, wtab, cn, width);
+}
+static inline int remapBilinearVec(const float* S0, size_t sstep, int swidth, float* D, const short* XY, const ushort* FXY, const float* wtab, int cn, int width)
+{
+	return hal::remapBilinear32f(S0, sstep, swidth, D, XY, FXY, wtab, cn, width);
+}
+
 template<class CastOp, typename AT, typename _Tp1, typename _Tp2, typename _Tp3, int chs1, int chs2, int chs3>
 static int remapBilinear(const Mat_<_Tp1, chs1>& _src, Mat_<_Tp1, chs1>& _dst,
 	const Mat_<_Tp2, chs2>& _xy, const Mat_<_Tp3, chs3>& _fxy, const void* _wtab, int borderType, const Scalar& _borderValue)
@@ -299,7 +405,7 @@ static int remapBilinear(const Mat_<_Tp1, chs1>& _src, Mat_<_Tp1, chs1>& _dst,
 			prevInlier = curInlier;
 
 			if (!curInlier) {
-				int len = 0;
+				int len = remapBilinearVec(S0, sstep, ssize.width, D, XY + dx * 2, FXY + dx, wtab, cn, X1 - dx);
 				D += len*cn;
 				dx += len;
 
@@ -624,60 +730,65 @@ static int remap_nearest(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst,
 	const void* ctab = 0;
 	bool fixpt = typeid(uchar).name() == typeid(_Tp1).name();
 	bool planar_input = map1.channels == 1;
-	Range range(0, dst.rows);
-
-	int x, y, x1, y1;
-	const int buf_size = 1 << 14;
-	int brows0 = std::min(128, dst.rows);
-	int bcols0 = std::min(buf_size / brows0, dst.cols);
-	brows0 = std::min(buf_size / bcols0, dst.rows);
-
-	Mat_<short, 2> _bufxy(brows0, bcols0);
-	Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
-	Mat_<float, 2> map1_tmp2(map1.rows, map1.cols, map1.data);
-
-	for (y = range.start; y < range.end; y += brows0) {
-		for (x = 0; x < dst.cols; x += bcols0) {
-			int brows = std::min(brows0, range.end - y);
-			int bcols = std::min(bcols0, dst.cols - x);
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bcols, brows));
-			Mat_<short, 2> bufxy;
-			_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
-
-			if (map1.channels == 2 && sizeof(_Tp2) == sizeof(short) && map2.empty()) { // the data is already in the right format
-				map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
-			} else if (sizeof(_Tp2) != sizeof(float)) {
-				for (y1 = 0; y1 < brows; y1++) {
-					short* XY = (short*)bufxy.ptr(y1);
-					const short* sXY = (const short*)map1.ptr(y + y1) + x * 2;
-					const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
-
-					for (x1 = 0; x1 < bcols; x1++) {
-						int a = sA[x1] & (INTER_TAB_SIZE2 - 1);
-						XY[x1 * 2] = sXY[x1 * 2] + NNDeltaTab_i[a][0];
-						XY[x1 * 2 + 1] = sXY[x1 * 2 + 1] + NNDeltaTab_i[a][1];
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		int x, y, x1, y1;
+		const int buf_size = 1 << 14;
+		int brows0 = std::min(128, dst.rows);
+		int bcols0 = std::min(buf_size / brows0, dst.cols);
+		brows0 = std::min(buf_size / bcols0, dst.rows);
+
+		Mat_<short, 2> _bufxy(brows0, bcols0);
+		Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
+
+		for (y = range.start; y < range.end; y += brows0) {
+			for (x = 0; x < dst.cols; x += bcols0) {
+				int brows = std::min(brows0, range.end - y);
+				int bcols = std::min(bcols0, dst.cols - x);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bcols, brows));
+				Mat_<short, 2> bufxy;
+				_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
+
+				if (map1.channels == 2 && sizeof(_Tp2) == sizeof(short) && map2.empty()) { // the data is already in the right format
+					map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
+				} else if (sizeof(_Tp2) != sizeof(float)) {
+					for (y1 = 0; y1 < brows; y1++) {
+						short* XY = (short*)bufxy.ptr(y1);
+						const short* sXY = (const short*)map1.ptr(y + y1) + x * 2;
+						const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
+
+						for (x1 = 0; x1 < bcols; x1++) {
+							int a = sA[x1] & (INTER_TAB_SIZE2 - 1);
+							XY[x1 * 2] = sXY[x1 * 2] + NNDeltaTab_i[a][0];
+							XY[x1 * 2 + 1] = sXY[x1 * 2 + 1] + NNDeltaTab_i[a][1];
+						}
 					}
-				}
-			} else if (!planar_input) {
-				map1_tmp2.convertTo(bufxy);
-			} else {
-				for (y1 = 0; y1 < brows; y1++) {
-					short* XY = (short*)bufxy.ptr(y1);
-					const float* sX = (const float*)map1.ptr(y + y1) + x;
-					const float* sY = (const float*)map2.ptr(y + y1) + x;
+				} else if (!planar_input) {
+					for (y1 = 0; y1 < brows; y1++) {
+						short* XY = (short*)bufxy.ptr(y1);
+						const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
 
-					x1 = 0;
-					for (; x1 < bcols; x1++) {
-						XY[x1 * 2] = saturate_cast<short>(sX[x1]);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sY[x1]);
+						for (x1 = 0; x1 < bcols * 2; x1++)
+							XY[x1] = saturate_cast<short>(sXY[x1]);
+					}
+				} else {
+					for (y1 = 0; y1 < brows; y1++) {
+						short* XY = (short*)bufxy.ptr(y1);
+						const float* sX = (const float*)map1.ptr(y + y1) + x;
+						const float* sY = (const float*)map2.ptr(y + y1) + x;
+
+						x1 = 0;
+						for (; x1 < bcols; x1++) {
+							XY[x1 * 2] = saturate_cast<short>(sX[x1]);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sY[x1]);
+						}
 					}
 				}
-			}
 
-			remapNearest<_Tp1, short, chs1, 2>(src, dpart, bufxy, borderMode, borderValue);
+				remapNearest<_Tp1, short, chs1, 2>(src, dpart, bufxy, borderMode, borderValue);
+			}
 		}
-	}
+	}, dst.total() / (double)(1 << 16));
 
 	return 0;
 }
@@ -690,76 +801,76 @@ static int remap_linear(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst,
 	bool fixpt = typeid(uchar).name() == typeid(_Tp1).name();
 	bool planar_input = map1.channels == 1;
 	ctab = initInterTab2D<_Tp1>(INTER_LINEAR, fixpt);
-	Range range(0, dst.rows);
-
-	int x, y, x1, y1;
-	const int buf_size = 1 << 14;
-	int brows0 = std::min(128, dst.rows);
-	int bcols0 = std::min(buf_size / brows0, dst.cols);
-	brows0 = std::min(buf_size / bcols0, dst.rows);
-
-	Mat_<short, 2> _bufxy(brows0, bcols0);
-	Mat_<ushort, 1> _bufa(brows0, bcols0);
-	Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
-
-	for (y = range.start; y < range.end; y += brows0) {
-		for (x = 0; x < dst.cols; x += bcols0) {
-			int brows = std::min(brows0, range.end - y);
-			int bcols = std::min(bcols0, dst.cols - x);
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bcols, brows));
-			Mat_<short, 2> bufxy;
-			_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
-			Mat_<ushort, 1> bufa;
-			_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
-
-			for (y1 = 0; y1 < brows; y1++) {
-				short* XY = (short*)bufxy.ptr(y1);
-				ushort* A = (ushort*)bufa.ptr(y1);
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		int x, y, x1, y1;
+		const int buf_size = 1 << 14;
+		int brows0 = std::min(128, dst.rows);
+		int bcols0 = std::min(buf_size / brows0, dst.cols);
+		brows0 = std::min(buf_size / bcols0, dst.rows);
+
+		Mat_<short, 2> _bufxy(brows0, bcols0);
+		Mat_<ushort, 1> _bufa(brows0, bcols0);
+		Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
+
+		for (y = range.start; y < range.end; y += brows0) {
+			for (x = 0; x < dst.cols; x += bcols0) {
+				int brows = std::min(brows0, range.end - y);
+				int bcols = std::min(bcols0, dst.cols - x);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bcols, brows));
+				Mat_<short, 2> bufxy;
+				_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
+				Mat_<ushort, 1> bufa;
+				_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
 
-				if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
-					(map2.channels == 1 && sizeof(_Tp3) == 2)) {
-					map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
-
-					const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
-					x1 = 0;
-
-					for (; x1 < bcols; x1++)
-						A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
-				} else if (planar_input) {
-					const float* sX = (const float*)map1.ptr(y + y1) + x;
-					const float* sY = (const float*)map2.ptr(y + y1) + x;
-
-					x1 = 0;
-					for (; x1 < bcols; x1++) {
-						int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
-						int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
-					}
-				} else {
-					const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
-					x1 = 0;
-					for (x1 = 0; x1 < bcols; x1++) {
-						int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
-						int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
+				for (y1 = 0; y1 < brows; y1++) {
+					short* XY = (short*)bufxy.ptr(y1);
+					ushort* A = (ushort*)bufa.ptr(y1);
+
+					if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
+						(map2.channels == 1 && sizeof(_Tp3) == 2)) {
+						map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
+
+						const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
+						x1 = 0;
+
+						for (; x1 < bcols; x1++)
+							A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
+					} else if (planar_input) {
+						const float* sX = (const float*)map1.ptr(y + y1) + x;
+						const float* sY = (const float*)map2.ptr(y + y1) + x;
+
+						x1 = 0;
+						for (; x1 < bcols; x1++) {
+							int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
+							int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
+					} else {
+						const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
+						x1 = 0;
+						for (x1 = 0; x1 < bcols; x1++) {
+							int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
+							int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
 					}
 				}
-			}
 
-			if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
-				remapBilinear<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
-			} else { // float
-				remapBilinear<Cast<float, float>, float, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
+					remapBilinear<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				} else { // float
+					remapBilinear<Cast<float, float>, float, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				}
 			}
 		}
-	}
+	}, dst.total() / (double)(1 << 16));
 
 	return 0;
 }
@@ -772,76 +883,76 @@ static int remap_cubic(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst,
 	bool fixpt = typeid(uchar).name() == typeid(_Tp1).name();
 	bool planar_input = map1.channels == 1;
 	ctab = initInterTab2D<_Tp1>(INTER_CUBIC, fixpt);
-	Range range(0, dst.rows);
-
-	int x, y, x1, y1;
-	const int buf_size = 1 << 14;
-	int brows0 = std::min(128, dst.rows);
-	int bcols0 = std::min(buf_size / brows0, dst.cols);
-	brows0 = std::min(buf_size / bcols0, dst.rows);
-
-	Mat_<short, 2> _bufxy(brows0, bcols0);
-	Mat_<ushort, 1> _bufa(brows0, bcols0);
-	Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
-
-	for (y = range.start; y < range.end; y += brows0) {
-		for (x = 0; x < dst.cols; x += bcols0) {
-			int brows = std::min(brows0, range.end - y);
-			int bcols = std::min(bcols0, dst.cols - x);
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bcols, brows));
-			Mat_<short, 2> bufxy;
-			_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
-			Mat_<ushort, 1> bufa;
-			_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
-
-			for (y1 = 0; y1 < brows; y1++) {
-				short* XY = (short*)bufxy.ptr(y1);
-				ushort* A = (ushort*)bufa.ptr(y1);
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		int x, y, x1, y1;
+		const int buf_size = 1 << 14;
+		int brows0 = std::min(128, dst.rows);
+		int bcols0 = std::min(buf_size / brows0, dst.cols);
+		brows0 = std::min(buf_size / bcols0, dst.rows);
+
+		Mat_<short, 2> _bufxy(brows0, bcols0);
+		Mat_<ushort, 1> _bufa(brows0, bcols0);
+		Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
+
+		for (y = range.start; y < range.end; y += brows0) {
+			for (x = 0; x < dst.cols; x += bcols0) {
+				int brows = std::min(brows0, range.end - y);
+				int bcols = std::min(bcols0, dst.cols - x);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bcols, brows));
+				Mat_<short, 2> bufxy;
+				_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
+				Mat_<ushort, 1> bufa;
+				_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
 
-				if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
-					(map2.channels == 1 && sizeof(_Tp3) == 2)) {
-					map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
-
-					const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
-					x1 = 0;
-
-					for (; x1 < bcols; x1++)
-						A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
-				} else if (planar_input) {
-					const float* sX = (const float*)map1.ptr(y + y1) + x;
-					const float* sY = (const float*)map2.ptr(y + y1) + x;
-
-					x1 = 0;
-					for (; x1 < bcols; x1++) {
-						int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
-						int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
-					}
-				} else {
-					const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
-					x1 = 0;
-					for (x1 = 0; x1 < bcols; x1++) {
-						int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
-						int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
+				for (y1 = 0; y1 < brows; y1++) {
+					short* XY = (short*)bufxy.ptr(y1);
+					ushort* A = (ushort*)bufa.ptr(y1);
+
+					if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
+						(map2.channels == 1 && sizeof(_Tp3) == 2)) {
+						map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
+
+						const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
+						x1 = 0;
+
+						for (; x1 < bcols; x1++)
+							A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
+					} else if (planar_input) {
+						const float* sX = (const float*)map1.ptr(y + y1) + x;
+						const float* sY = (const float*)map2.ptr(y + y1) + x;
+
+						x1 = 0;
+						for (; x1 < bcols; x1++) {
+							int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
+							int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
+					} else {
+						const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
+						x1 = 0;
+						for (x1 = 0; x1 < bcols; x1++) {
+							int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
+							int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
 					}
 				}
-			}
 
-			if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
-				remapBicubic<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
-			} else { // float
-				remapBicubic<Cast<float, float>, float, 1, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
+					remapBicubic<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				} else { // float
+					remapBicubic<Cast<float, float>, float, 1, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				}
 			}
 		}
-	}
+	}, dst.total() / (double)(1 << 16));
 
 	return 0;
 }
@@ -854,78 +965,250 @@ static int remap_lanczos4(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst,
 	bool fixpt = typeid(uchar).name() == typeid(_Tp1).name();
 	bool planar_input = map1.channels == 1;
 	ctab = initInterTab2D<_Tp1>(INTER_LANCZOS4, fixpt);
-	Range range(0, dst.rows);
-
-	int x, y, x1, y1;
-	const int buf_size = 1 << 14;
-	int brows0 = std::min(128, dst.rows);
-	int bcols0 = std::min(buf_size / brows0, dst.cols);
-	brows0 = std::min(buf_size / bcols0, dst.rows);
-
-	Mat_<short, 2> _bufxy(brows0, bcols0);
-	Mat_<ushort, 1> _bufa(brows0, bcols0);
-	Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
-
-	for (y = range.start; y < range.end; y += brows0) {
-		for (x = 0; x < dst.cols; x += bcols0) {
-			int brows = std::min(brows0, range.end - y);
-			int bcols = std::min(bcols0, dst.cols - x);
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bcols, brows));
-			Mat_<short, 2> bufxy;
-			_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
-			Mat_<ushort, 1> bufa;
-			_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
-
-			for (y1 = 0; y1 < brows; y1++) {
-				short* XY = (short*)bufxy.ptr(y1);
-				ushort* A = (ushort*)bufa.ptr(y1);
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		int x, y, x1, y1;
+		const int buf_size = 1 << 14;
+		int brows0 = std::min(128, dst.rows);
+		int bcols0 = std::min(buf_size / brows0, dst.cols);
+		brows0 = std::min(buf_size / bcols0, dst.rows);
+
+		Mat_<short, 2> _bufxy(brows0, bcols0);
+		Mat_<ushort, 1> _bufa(brows0, bcols0);
+		Mat_<short, 2> map1_tmp1(map1.rows, map1.cols, map1.data);
+
+		for (y = range.start; y < range.end; y += brows0) {
+			for (x = 0; x < dst.cols; x += bcols0) {
+				int brows = std::min(brows0, range.end - y);
+				int bcols = std::min(bcols0, dst.cols - x);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bcols, brows));
+				Mat_<short, 2> bufxy;
+				_bufxy.getROI(bufxy, Rect(0, 0, bcols, brows));
+				Mat_<ushort, 1> bufa;
+				_bufa.getROI(bufa, Rect(0, 0, bcols, brows));
 
-				if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
-					(map2.channels == 1 && sizeof(_Tp3) == 2)) {
-					map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
-
-					const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
-					x1 = 0;
-
-					for (; x1 < bcols; x1++)
-						A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
-				} else if (planar_input) {
-					const float* sX = (const float*)map1.ptr(y + y1) + x;
-					const float* sY = (const float*)map2.ptr(y + y1) + x;
-
-					x1 = 0;
-					for (; x1 < bcols; x1++) {
-						int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
-						int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
-					}
-				} else {
-					const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
-					x1 = 0;
-					for (x1 = 0; x1 < bcols; x1++) {
-						int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
-						int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
-						int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
-						XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
-						XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
-						A[x1] = (ushort)v;
+				for (y1 = 0; y1 < brows; y1++) {
+					short* XY = (short*)bufxy.ptr(y1);
+					ushort* A = (ushort*)bufa.ptr(y1);
+
+					if (map1.channels == 2 && typeid(short).name() == typeid(_Tp2).name() &&
+						(map2.channels == 1 && sizeof(_Tp3) == 2)) {
+						map1_tmp1.getROI(bufxy, Rect(x, y, bcols, brows));
+
+						const ushort* sA = (const ushort*)map2.ptr(y + y1) + x;
+						x1 = 0;
+
+						for (; x1 < bcols; x1++)
+							A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2 - 1));
+					} else if (planar_input) {
+						const float* sX = (const float*)map1.ptr(y + y1) + x;
+						const float* sY = (const float*)map2.ptr(y + y1) + x;
+
+						x1 = 0;
+						for (; x1 < bcols; x1++) {
+							int sx = fbcRound(sX[x1] * INTER_TAB_SIZE);
+							int sy = fbcRound(sY[x1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
+					} else {
+						const float* sXY = (const float*)map1.ptr(y + y1) + x * 2;
+						x1 = 0;
+						for (x1 = 0; x1 < bcols; x1++) {
+							int sx = fbcRound(sXY[x1 * 2] * INTER_TAB_SIZE);
+							int sy = fbcRound(sXY[x1 * 2 + 1] * INTER_TAB_SIZE);
+							int v = (sy & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE - 1));
+							XY[x1 * 2] = saturate_cast<short>(sx >> INTER_BITS);
+							XY[x1 * 2 + 1] = saturate_cast<short>(sy >> INTER_BITS);
+							A[x1] = (ushort)v;
+						}
 					}
 				}
+
+				if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
+					remapLanczos4<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				}
+				else { // float
+					remapLanczos4<Cast<float, float>, float, 1, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+				}
+			}
+		}
+	}, dst.total() / (double)(1 << 16));
+
+	return 0;
+}
+
+// remaps the destination block dpart with the fixed-point maps xy/fxy of the block (see convertMaps(), fxy is not
+// used by INTER_NEAREST), ctab is the table of initInterTab2D() for the interpolation; used by RemapPlan, warpAffine
+// and warpPerspective, which compute the maps of every block themselves
+template<typename _Tp, int chs>
+static void remapBlock(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dpart, const Mat_<short, 2>& xy, const Mat_<ushort, 1>& fxy,
+	int interpolation, const void* ctab, int borderMode, const Scalar& borderValue)
+{
+	bool fixpt = typeid(uchar).name() == typeid(_Tp).name();
+
+	if (interpolation == INTER_NEAREST) {
+		remapNearest<_Tp, short, chs, 2>(src, dpart, xy, borderMode, borderValue);
+	} else if (interpolation == INTER_LINEAR) {
+		if (fixpt)
+			remapBilinear<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+		else
+			remapBilinear<Cast<float, float>, float, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+	} else if (interpolation == INTER_CUBIC) {
+		if (fixpt)
+			remapBicubic<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+		else
+			remapBicubic<Cast<float, float>, float, 1, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+	} else {
+		if (fixpt)
+			remapLanczos4<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+		else
+			remapLanczos4<Cast<float, float>, float, 1, _Tp, short, ushort, chs, 2, 1>(src, dpart, xy, fxy, ctab, borderMode, borderValue);
+	}
+}
+
+template<typename _Tp, int chs>
+template<typename _Tp2, typename _Tp3, int chs2, int chs3>
+RemapPlan<_Tp, chs>::RemapPlan(Size ssize_, const Mat_<_Tp2, chs2>& map1, const Mat_<_Tp3, chs3>& map2, int interpolation,
+	int borderMode_, const Scalar& borderValue_, int cacheSize)
+	: ssize(ssize_), dsize(map1.size()), inter(interpolation), borderMode(borderMode_), borderValue(borderValue_), ctab(0)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+	FBC_Assert(ssize.area() > 0 && dsize.area() > 0);
+	FBC_Assert(map2.empty() || map1.size() == map2.size());
+	if (inter == INTER_AREA)
+		inter = INTER_LINEAR;
+	FBC_Assert(inter == INTER_NEAREST || inter == INTER_LINEAR || inter == INTER_CUBIC || inter == INTER_LANCZOS4);
+
+	bool nearest = inter == INTER_NEAREST;
+	if (!nearest)
+		ctab = initInterTab2D<_Tp>(inter, typeid(uchar).name() == typeid(_Tp).name());
+	else if (!map2.empty())
+		initInterTab2D<_Tp>(INTER_LINEAR, true); // fills NNDeltaTab_i too
+
+	if (typeid(float).name() == typeid(_Tp2).name()) {
+		convertMaps(map1, map2, xy, fxy, nearest);
+	} else {
+		FBC_Assert(typeid(short).name() == typeid(_Tp2).name() && chs2 == 2);
+		FBC_Assert(map2.empty() || ((typeid(short).name() == typeid(_Tp3).name() || typeid(ushort).name() == typeid(_Tp3).name()) && chs3 == 1));
+
+		// the fixed-point maps are copied, adding the rounding of the fractional parts for INTER_NEAREST,
+		// without map2 the coordinates are rounded already (convertMaps() with nninterpolation)
+		xy.create(dsize.height, dsize.width);
+		if (!nearest)
+			fxy.create(dsize.height, dsize.width);
+		for (int y = 0; y < dsize.height; y++) {
+			const short* sXY = (const short*)map1.ptr(y);
+			const ushort* sA = map2.empty() ? NULL : (const ushort*)map2.ptr(y);
+			short* XY = (short*)xy.ptr(y);
+
+			for (int x = 0; x < dsize.width; x++) {
+				int a = sA ? sA[x] & (INTER_TAB_SIZE2 - 1) : 0;
+				XY[x * 2] = nearest && sA ? sXY[x * 2] + NNDeltaTab_i[a][0] : sXY[x * 2];
+				XY[x * 2 + 1] = nearest && sA ? sXY[x * 2 + 1] + NNDeltaTab_i[a][1] : sXY[x * 2 + 1];
+				if (!nearest)
+					((ushort*)fxy.ptr(y))[x] = (ushort)a;
 			}
+		}
+	}
+
+	initTiles(cacheSize);
+}
 
-			if (typeid(_Tp1).name() == typeid(uchar).name()) { // uchar
-				remapLanczos4<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, short, INTER_REMAP_COEF_SCALE, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+template<typename _Tp, int chs>
+void RemapPlan<_Tp, chs>::initTiles(int cacheSize)
+{
+	// the source pixels read around (sx, sy) by the interpolation: [sx - k0, sx + k1]
+	int k0 = inter == INTER_CUBIC ? 1 : inter == INTER_LANCZOS4 ? 3 : 0;
+	int k1 = inter == INTER_NEAREST ? 0 : inter == INTER_LINEAR ? 1 : inter == INTER_CUBIC ? 2 : 4;
+	const int block = 16;
+	int bw = (dsize.width + block - 1) / block, bh = (dsize.height + block - 1) / block;
+
+	// the bounding boxes of the source pixels read by the blocks of 16x16 destination pixels, clipped to the source
+	std::vector<Rect> boxes(bw * bh);
+	parallel_for_(Range(0, bh), [&](const Range& range) {
+		for (int by = range.start; by < range.end; by++) {
+			for (int bx = 0; bx < bw; bx++) {
+				int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+				for (int y = by * block; y < std::min((by + 1) * block, dsize.height); y++) {
+					const short* XY = (const short*)xy.ptr(y);
+					for (int x = bx * block; x < std::min((bx + 1) * block, dsize.width); x++) {
+						x0 = std::min(x0, (int)XY[x * 2]);
+						x1 = std::max(x1, (int)XY[x * 2]);
+						y0 = std::min(y0, (int)XY[x * 2 + 1]);
+						y1 = std::max(y1, (int)XY[x * 2 + 1]);
+					}
+				}
+				x0 = std::max(x0 - k0, 0);
+				y0 = std::max(y0 - k0, 0);
+				x1 = std::min(x1 + k1, ssize.width - 1);
+				y1 = std::min(y1 + k1, ssize.height - 1);
+				boxes[by * bw + bx] = x0 <= x1 && y0 <= y1 ? Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1) : Rect();
 			}
-			else { // float
-				remapLanczos4<Cast<float, float>, float, 1, _Tp1, short, ushort, chs1, 2, 1>(src, dpart, bufxy, bufa, ctab, borderMode, borderValue);
+		}
+	}, bh * bw / 64.);
+
+	// the tiles of n x n blocks, from the largest
+	size_t elemSize = sizeof(_Tp) * chs;
+	int n = 16;
+	for (; n > 1; n /= 2) {
+		size_t footprint = 0;
+		for (int ty = 0; ty < bh; ty += n) {
+			for (int tx = 0; tx < bw; tx += n) {
+				Rect r;
+				for (int by = ty; by < std::min(ty + n, bh); by++) {
+					for (int bx = tx; bx < std::min(tx + n, bw); bx++) {
+						const Rect& b = boxes[by * bw + bx];
+						if (b.area() > 0)
+							r = r.area() > 0 ? (r | b) : b;
+					}
+				}
+				footprint = std::max(footprint, (size_t)r.area() * elemSize);
 			}
 		}
+		if (footprint <= (size_t)cacheSize)
+			break;
 	}
 
+	tile = Size(std::min(n * block, dsize.width), std::min(n * block, dsize.height));
+}
+
+template<typename _Tp, int chs>
+int RemapPlan<_Tp, chs>::apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const
+{
+	FBC_Assert(src.size() == ssize);
+	FBC_Assert(src.data != dst.data);
+
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(dsize.height, dsize.width);
+	} else {
+		FBC_Assert(dst.size() == dsize);
+	}
+
+	int tilesX = (dsize.width + tile.width - 1) / tile.width;
+	int tilesY = (dsize.height + tile.height - 1) / tile.height;
+
+	parallel_for_(Range(0, tilesX * tilesY), [&](const Range& range) {
+		Mat_<short, 2> xy_ = xy;
+		Mat_<ushort, 1> fxy_ = fxy;
+
+		for (int i = range.start; i < range.end; i++) {
+			int x = (i % tilesX) * tile.width, y = (i / tilesX) * tile.height;
+			Rect r(x, y, std::min(tile.width, dsize.width - x), std::min(tile.height, dsize.height - y));
+			Mat_<_Tp, chs> dpart;
+			dst.getROI(dpart, r);
+			Mat_<short, 2> bufxy;
+			xy_.getROI(bufxy, r);
+			Mat_<ushort, 1> bufa;
+			if (inter != INTER_NEAREST)
+				fxy_.getROI(bufa, r);
+
+			remapBlock(src, dpart, bufxy, bufa, inter, ctab, borderMode, borderValue);
+		}
+	}, dsize.area() / (double)(1 << 16));
+
 	return 0;
 }
 
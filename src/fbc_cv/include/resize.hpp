@@ -9,10 +9,15 @@
 */
 
 #include <typeinfo>
+#include <memory>
+#include <vector>
 #include "core/mat.hpp"
 #include "core/base.hpp"
 #include "core/saturate.hpp"
 #include "core/utility.hpp"
+#include "core/lru_cache.hpp"
+#include "core/parallel.hpp"
+#include "core/hal.hpp"
 #include "imgproc.hpp"
 
 namespace fbc {
@@ -23,14 +28,19 @@ static const int MAX_ESIZE = 16;
 const int INTER_RESIZE_COEF_BITS = 11;
 const int INTER_RESIZE_COEF_SCALE = 1 << INTER_RESIZE_COEF_BITS;
 
-template<typename _Tp, int chs> static int resize_nearest(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst);
-template<typename _Tp, int chs> static int resize_linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst);
-template<typename _Tp, int chs> static int resize_cubic(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst);
-template<typename _Tp, int chs> static int resize_area(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst);
-template<typename _Tp, int chs> static int resize_lanczos4(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst);
+struct DecimateAlpha
+{
+	int si, di;
+	float alpha;
+};
+
+template<typename _Tp, int chs> class ResizePlan;
+template<typename _Tp, int chs> class ResizePlanCache;
 
 // resize the image src down to or up to the specified size
 // support type: uchar/float
+// the coefficient tables are taken from a small LRU cache of resize plans, so resizing
+// a stream of frames of a fixed geometry computes them only once
 template<typename _Tp, int chs>
 int resize(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int interpolation = INTER_LINEAR)
 {
@@ -47,38 +57,148 @@ int resize(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int interpolation = I
 		return 0;
 	}
 
-	switch (interpolation) {
-		case 0: {
-			resize_nearest(src, dst);
-			break;
-		}
-		case 1: {
-			resize_linear(src, dst);
-			break;
-		}
-		case 2: {
-			resize_cubic(src, dst);
-			break;
-		}
-		case 3: {
-			resize_area(src, dst);
-			break;
-		}
-		case 4: {
-			resize_lanczos4(src, dst);
-			break;
-		}
-		default:
-			return -1;
+	std::shared_ptr<const ResizePlan<_Tp, chs>> plan = ResizePlanCache<_Tp, chs>::getInstance().get(ssize, dsize, interpolation);
+
+	return plan->apply(src, dst);
+}
+
+// resizes the images of a batch (e.g. the crops of one inference call) to dsize
+// dst gets one image per source image, see createBatch(); the sources may have different sizes,
+// the plans are looked up once per batch and the images are spread over the threads by parallel_for_batch_
+template<typename _Tp, int chs>
+int resize(const std::vector<Mat_<_Tp, chs>>& src, std::vector<Mat_<_Tp, chs>>& dst, Size dsize, int interpolation = INTER_LINEAR)
+{
+	FBC_Assert((interpolation >= 0) && (interpolation < 5));
+	FBC_Assert(dsize.width >= 4 && dsize.height >= 4);
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+
+	int n = (int)src.size();
+	createBatch(dst, n, dsize);
+
+	// NULL: same size, the image is copied
+	std::vector<std::shared_ptr<const ResizePlan<_Tp, chs>>> plans(n);
+	for (int i = 0; i < n; i++) {
+		Size ssize = src[i].size();
+		FBC_Assert(ssize.width >= 4 && ssize.height >= 4 && src[i].data != dst[i].data);
+		if (ssize == dsize)
+			continue;
+
+		if (i > 0 && plans[i - 1] && src[i - 1].size() == ssize)
+			plans[i] = plans[i - 1];
+		else
+			plans[i] = ResizePlanCache<_Tp, chs>::getInstance().get(ssize, dsize, interpolation);
 	}
 
+	parallel_for_batch_(n, [&](int i) {
+		if (plans[i])
+			plans[i]->apply(src[i], dst[i]);
+		else
+			src[i].copyTo(dst[i]);
+	});
+
 	return 0;
 }
 
-struct DecimateAlpha
-{
-	int si, di;
-	float alpha;
+// Source rows of ResizePlan::apply(source, sink)
+// operator()(sy, count, buf) returns the rows [sy, sy + count), step() bytes apart; a source that generates
+// its rows (GENERATED != 0) writes them into buf, which has room for count rows of step() bytes
+template<typename _Tp, int chs>
+struct ResizeMatSource {
+	enum { GENERATED = 0 };
+
+	explicit ResizeMatSource(const Mat_<_Tp, chs>& src_) : src(src_) {}
+	size_t step() const { return src.step; }
+	const _Tp* operator()(int sy, int, _Tp*) const { return (const _Tp*)src.ptr(sy); }
+
+	const Mat_<_Tp, chs>& src;
+};
+
+// Destination rows of ResizePlan::apply(source, sink)
+// operator()(dy, buf) returns where row dy is written, commit(dy, row) is called when it is complete;
+// a sink that consumes its rows (GENERATED != 0) gets a buf of one destination row
+template<typename _Tp, int chs>
+struct ResizeMatSink {
+	enum { GENERATED = 0 };
+
+	explicit ResizeMatSink(Mat_<_Tp, chs>& dst_) : dst(dst_) {}
+	_Tp* operator()(int dy, _Tp*) const { return (_Tp*)dst.ptr(dy); }
+	void commit(int dy, const _Tp* row) const
+	{
+		if (row != (const _Tp*)dst.ptr(dy))
+			memcpy(dst.ptr(dy), row, dst.step);
+	}
+
+	Mat_<_Tp, chs>& dst;
+};
+
+// Precomputed resize of a fixed geometry
+// the plan holds the coefficient tables of (source size, destination size, interpolation), it is immutable
+// after the construction and apply() can be called from several threads at the same time
+template<typename _Tp, int chs>
+class ResizePlan {
+public:
+	// support type: uchar/float, interpolation: INTER_NEAREST/INTER_LINEAR/INTER_CUBIC/INTER_AREA/INTER_LANCZOS4
+	ResizePlan(Size ssize, Size dsize, int interpolation = INTER_LINEAR);
+
+	// resizes src to dst, their sizes must be the planned source and destination sizes
+	int apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const;
+	// resizes the rows given by source into sink (see ResizeMatSource/ResizeMatSink), for pipelines that
+	// produce the source rows on the fly or consume the destination rows directly
+	// only the plans of INTER_LINEAR and INTER_AREA (and same size) support it
+	template<class Source, class Sink>
+	int apply(const Source& source, const Sink& sink) const;
+
+	Size srcSize() const { return ssize; }
+	Size dstSize() const { return dsize; }
+	int interpolation() const { return inter; }
+
+private:
+	enum Mode { MODE_COPY, MODE_NEAREST, MODE_LINEAR, MODE_CUBIC, MODE_LANCZOS4, MODE_AREA_FAST, MODE_AREA };
+
+	void initNearest();
+	// tables of the separable filters: linear, cubic, lanczos4 and area (upscaling)
+	void initSeparable(int ksize_, bool area);
+	void initArea(double scale_x, double scale_y);
+
+	Size ssize, dsize;
+	int inter;
+	Mode mode;
+	int ksize, xmin, xmax;
+	int iscale_x, iscale_y;
+	// nearest: byte offsets of the source pixels, separable filters: source row/column of every destination pixel
+	std::vector<int> xofs, yofs;
+	// coefficients of the separable filters, fixed-point for uchar images
+	std::vector<float> alpha, beta;
+	std::vector<short> ialpha, ibeta;
+	// area
+	std::vector<DecimateAlpha> xtab, ytab;
+	std::vector<int> tabofs;
+};
+
+// LRU cache of the resize plans used by resize(), one cache per image type
+template<typename _Tp, int chs>
+class ResizePlanCache {
+public:
+	static ResizePlanCache& getInstance()
+	{
+		static ResizePlanCache cache;
+		return cache;
+	}
+
+	std::shared_ptr<const ResizePlan<_Tp, chs>> get(Size ssize, Size dsize, int interpolation)
+	{
+		return plans.get([&](const ResizePlan<_Tp, chs>& plan) {
+			return plan.srcSize() == ssize && plan.dstSize() == dsize && plan.interpolation() == interpolation; },
+			[&]() { return std::make_shared<const ResizePlan<_Tp, chs>>(ssize, dsize, interpolation); });
+	}
+
+	void clear() { plans.clear(); }
+
+private:
+	// enough for the streams of a multi-camera pipeline, a plan of 1080p->416x416 holds about 10KB of tables
+	static const int RESIZE_PLAN_CACHE_SIZE = 16;
+
+	LRUCache<ResizePlan<_Tp, chs>, RESIZE_PLAN_CACHE_SIZE> plans;
 };
 
 template<typename type>
@@ -119,27 +239,56 @@ static int computeResizeAreaTab(int ssize, int dsize, int cn, double scale, Deci
 	return k;
 }
 
-template<typename ST, typename DT> struct Cast
+template<typename type>
+static type clip(type x, type a, type b)
 {
-	typedef ST type1;
-	typedef DT rtype;
+	return x >= a ? (x < b ? x : b - 1) : a;
+}
 
-	DT operator()(ST val) const { return saturate_cast<DT>(val); }
-};
+// optimized kernels of the horizontal/vertical passes (see hal::resizeHLinear8u ...), they return the number
+// of processed elements; only the uchar fixed-point and the float paths have them
+template<typename T, typename WT, typename AT>
+static inline int hresizeLinearVec(const T**, WT**, int, const int*, const AT*, int, int, int) { return 0; }
+static inline int hresizeLinearVec(const uchar** src, int** dst, int count, const int* xofs, const short* alpha, int swidth, int cn, int xmax)
+{
+	return hal::resizeHLinear8u(src, dst, count, xofs, alpha, swidth, cn, xmax);
+}
+static inline int hresizeLinearVec(const float** src, float** dst, int count, const int* xofs, const float* alpha, int swidth, int cn, int xmax)
+{
+	return hal::resizeHLinear32f(src, dst, count, xofs, alpha, swidth, cn, xmax);
+}
+
+// the vertical kernels are selected by the cast of the sums: FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2> for uchar, Cast<float, float> for float
+typedef FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2> VResizeCast8u;
+typedef Cast<float, float> VResizeCast32f;
 
-template<typename ST, typename DT, int bits> struct FixedPtCast
+template<typename T, typename WT, typename AT, class CastOp>
+static inline int vresizeLinearVec(const WT**, T*, const AT*, int, const CastOp&) { return 0; }
+static inline int vresizeLinearVec(const float** src, float* dst, const float* beta, int width, const VResizeCast32f&)
 {
-	typedef ST type1;
-	typedef DT rtype;
-	enum { SHIFT = bits, DELTA = 1 << (bits - 1) };
+	return hal::resizeVLinear32f(src, dst, beta, width);
+}
 
-	DT operator()(ST val) const { return saturate_cast<DT>((val + DELTA) >> SHIFT); }
-};
+template<typename T, typename WT, typename AT, class CastOp>
+static inline int vresizeCubicVec(const WT**, T*, const AT*, int, const CastOp&) { return 0; }
+static inline int vresizeCubicVec(const int** src, uchar* dst, const short* beta, int width, const VResizeCast8u&)
+{
+	return hal::resizeVCubic8u(src, dst, beta, width);
+}
+static inline int vresizeCubicVec(const float** src, float* dst, const float* beta, int width, const VResizeCast32f&)
+{
+	return hal::resizeVCubic32f(src, dst, beta, width);
+}
 
-template<typename type>
-static type clip(type x, type a, type b)
+template<typename T, typename WT, typename AT, class CastOp>
+static inline int vresizeLanczos4Vec(const WT**, T*, const AT*, int, const CastOp&) { return 0; }
+static inline int vresizeLanczos4Vec(const int** src, uchar* dst, const short* beta, int width, const VResizeCast8u&)
 {
-	return x >= a ? (x < b ? x : b - 1) : a;
+	return hal::resizeVLanczos4_8u(src, dst, beta, width);
+}
+static inline int vresizeLanczos4Vec(const float** src, float* dst, const float* beta, int width, const VResizeCast32f&)
+{
+	return hal::resizeVLanczos4_32f(src, dst, beta, width);
 }
 
 template<typename T, typename WT, typename AT>
@@ -154,7 +303,7 @@ struct HResizeLinear
 		int swidth, int dwidth, int cn, int xmin, int xmax, int ONE) const
 	{
 		int dx, k;
-		int dx0 = 0;
+		int dx0 = hresizeLinearVec(src, dst, count, xofs, alpha, swidth, cn, xmax);
 
 		for (k = 0; k <= count - 2; k++) {
 			const T *S0 = src[k], *S1 = src[k + 1];
@@ -176,7 +325,7 @@ struct HResizeLinear
 		for (; k < count; k++) {
 			const T *S = src[k];
 			WT *D = dst[k];
-			for (dx = 0; dx < xmax; dx++) {
+			for (dx = dx0; dx < xmax; dx++) {
 				int sx = xofs[dx];
 				D[dx] = S[sx] * alpha[dx * 2] + S[sx + cn] * alpha[dx * 2 + 1];
 			}
@@ -200,7 +349,7 @@ struct VResizeLinear
 		WT b0 = beta[0], b1 = beta[1];
 		const WT *S0 = src[0], *S1 = src[1];
 		CastOp castOp;
-		int x = 0;
+		int x = vresizeLinearVec(src, dst, beta, width, castOp);
 
 		for (; x <= width - 4; x += 4) {
 			WT t0, t1;
@@ -229,7 +378,7 @@ struct VResizeLinear<uchar, int, short, FixedPtCast<int, uchar, INTER_RESIZE_COE
 	{
 		alpha_type b0 = beta[0], b1 = beta[1];
 		const buf_type *S0 = src[0], *S1 = src[1];
-		int x = 0;
+		int x = hal::resizeVLinear8u(src, dst, beta, width);
 
 		for (; x <= width - 4; x += 4) {
 			dst[x + 0] = uchar((((b0 * (S0[x + 0] >> 4)) >> 16) + ((b1 * (S1[x + 0] >> 4)) >> 16) + 2) >> 2);
@@ -302,7 +451,7 @@ struct VResizeCubic
 		const WT *S0 = src[0], *S1 = src[1], *S2 = src[2], *S3 = src[3];
 		CastOp castOp;
 
-		int x = 0;
+		int x = vresizeCubicVec(src, dst, beta, width, castOp);
 		for (; x < width; x++) {
 			dst[x] = castOp(S0[x] * b0 + S1[x] * b1 + S2[x] * b2 + S3[x] * b3);
 		}
@@ -366,7 +515,7 @@ struct VResizeLanczos4
 	void operator()(const WT** src, T* dst, const AT* beta, int width) const
 	{
 		CastOp castOp;
-		int k, x = 0;
+		int k, x = vresizeLanczos4Vec(src, dst, beta, width, castOp);
 
 		for (; x <= width - 4; x += 4) {
 			WT b = beta[0];
@@ -407,7 +556,7 @@ struct ResizeAreaFastVec
 		}
 
 		const T* nextS = (const T*)((const uchar*)S + step);
-		int dx = 0;
+		int dx = hal::resizeAreaFast2x2_8u((const uchar*)S, (const uchar*)nextS, (uchar*)D, w, cn);
 
 		if (cn == 1) {
 			for (; dx < w; ++dx) {
@@ -443,67 +592,76 @@ private:
 	int step;
 };
 
-template<typename _Tp, typename value_type, typename buf_type, typename alpha_type, int chs>
-static void resizeGeneric_Linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst,
+template<typename _Tp, typename value_type, typename buf_type, typename alpha_type, int chs, class Source, class Sink>
+static void resizeGeneric_Linear(Size ssize, Size dsize, const Source& source, const Sink& sink,
 	const int* xofs, const void* _alpha, const int* yofs, const void* _beta, int xmin, int xmax, int ksize, int ONE)
 {
-	Size ssize = src.size(), dsize = dst.size();
-	int dy, cn = src.channels;
+	int cn = chs;
 	ssize.width *= cn;
 	dsize.width *= cn;
 	xmin *= cn;
 	xmax *= cn;
 	// image resize is a separable operation. In case of not too strong
 
-	Range range(0, dsize.height);
-
-	int bufstep = (int)alignSize(dsize.width, 16);
-	AutoBuffer<buf_type> _buffer(bufstep*ksize);
-	const value_type* srows[MAX_ESIZE] = { 0 };
-	buf_type* rows[MAX_ESIZE] = { 0 };
-	int prev_sy[MAX_ESIZE];
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		int bufstep = (int)alignSize(dsize.width, 16);
+		AutoBuffer<buf_type> _buffer(bufstep*ksize);
+		// one generated source row per filter tap, one generated destination row
+		int srcbufstep = (int)(source.step() / sizeof(value_type));
+		AutoBuffer<value_type> _srcbuf(Source::GENERATED ? srcbufstep*ksize : 1);
+		AutoBuffer<value_type> _dstbuf(Sink::GENERATED ? dsize.width : 1);
+		const value_type* srows[MAX_ESIZE] = { 0 };
+		buf_type* rows[MAX_ESIZE] = { 0 };
+		int prev_sy[MAX_ESIZE];
 
-	for (int k = 0; k < ksize; k++) {
-		prev_sy[k] = -1;
-		rows[k] = (buf_type*)_buffer + bufstep*k;
-	}
+		for (int k = 0; k < ksize; k++) {
+			prev_sy[k] = -1;
+			rows[k] = (buf_type*)_buffer + bufstep*k;
+		}
 
-	const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
+		const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
 
-	HResizeLinear<value_type, buf_type, alpha_type> hresize;
-	VResizeLinear<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
-	VResizeLinear<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
+		HResizeLinear<value_type, buf_type, alpha_type> hresize;
+		VResizeLinear<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
+		VResizeLinear<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
 
-	for (dy = range.start; dy < range.end; dy++, beta += ksize) {
-		int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
+		for (int dy = range.start; dy < range.end; dy++, beta += ksize) {
+			int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
 
-		for (int k = 0; k < ksize; k++) {
-			int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
-			for (k1 = std::max(k1, k); k1 < ksize; k1++) {
-				if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
-					if (k1 > k) {
-						memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+			for (int k = 0; k < ksize; k++) {
+				int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
+				for (k1 = std::max(k1, k); k1 < ksize; k1++) {
+					if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
+						if (k1 > k) {
+							memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+						}
+						break;
 					}
-					break;
 				}
+				if (k1 == ksize) {
+					k0 = std::min(k0, k); // remember the first row that needs to be computed
+				}
+				prev_sy[k] = sy;
 			}
-			if (k1 == ksize) {
-				k0 = std::min(k0, k); // remember the first row that needs to be computed
+
+			if (k0 < ksize) {
+				// only the rows that are not reused are fetched
+				for (int k = k0; k < ksize; k++) {
+					srows[k] = (const value_type*)source(prev_sy[k], 1, (_Tp*)((value_type*)_srcbuf + srcbufstep*k));
+				}
+				hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
+					ssize.width, dsize.width, cn, xmin, xmax, ONE);
 			}
-			srows[k] = (const value_type*)src.ptr(sy);
-			prev_sy[k] = sy;
-		}
 
-		if (k0 < ksize) {
-			hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
-				ssize.width, dsize.width, cn, xmin, xmax, ONE);
-		}
-		if (sizeof(_Tp) == 1) { // uchar
-			vresize1((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
-		} else { // float
-			vresize2((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			value_type* D = (value_type*)sink(dy, (_Tp*)(value_type*)_dstbuf);
+			if (sizeof(_Tp) == 1) { // uchar
+				vresize1((const buf_type**)rows, D, beta, dsize.width);
+			} else { // float
+				vresize2((const buf_type**)rows, D, beta, dsize.width);
+			}
+			sink.commit(dy, (const _Tp*)D);
 		}
-	}
+	}, dsize.area() / (double)(1 << 16));
 }
 
 template<typename _Tp, typename value_type, typename buf_type, typename alpha_type, int chs>
@@ -511,62 +669,62 @@ static void resizeGeneric_Cubic(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst,
 	const int* xofs, const void* _alpha, const int* yofs, const void* _beta, int xmin, int xmax, int ksize)
 {
 	Size ssize = src.size(), dsize = dst.size();
-	int dy, cn = src.channels;
+	int cn = src.channels;
 	ssize.width *= cn;
 	dsize.width *= cn;
 	xmin *= cn;
 	xmax *= cn;
 	// image resize is a separable operation. In case of not too strong
 
-	Range range(0, dsize.height);
-
-	int bufstep = (int)alignSize(dsize.width, 16);
-	AutoBuffer<buf_type> _buffer(bufstep*ksize);
-	const value_type* srows[MAX_ESIZE] = { 0 };
-	buf_type* rows[MAX_ESIZE] = { 0 };
-	int prev_sy[MAX_ESIZE];
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		int bufstep = (int)alignSize(dsize.width, 16);
+		AutoBuffer<buf_type> _buffer(bufstep*ksize);
+		const value_type* srows[MAX_ESIZE] = { 0 };
+		buf_type* rows[MAX_ESIZE] = { 0 };
+		int prev_sy[MAX_ESIZE];
 
-	for (int k = 0; k < ksize; k++) {
-		prev_sy[k] = -1;
-		rows[k] = (buf_type*)_buffer + bufstep*k;
-	}
+		for (int k = 0; k < ksize; k++) {
+			prev_sy[k] = -1;
+			rows[k] = (buf_type*)_buffer + bufstep*k;
+		}
 
-	const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
+		const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
 
-	HResizeCubic<value_type, buf_type, alpha_type> hresize;
-	VResizeCubic<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
-	VResizeCubic<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
+		HResizeCubic<value_type, buf_type, alpha_type> hresize;
+		VResizeCubic<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
+		VResizeCubic<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
 
-	for (dy = range.start; dy < range.end; dy++, beta += ksize) {
-		int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
+		for (int dy = range.start; dy < range.end; dy++, beta += ksize) {
+			int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
 
-		for (int k = 0; k < ksize; k++) {
-			int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
-			for (k1 = std::max(k1, k); k1 < ksize; k1++) {
-				if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
-					if (k1 > k) {
-						memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+			for (int k = 0; k < ksize; k++) {
+				int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
+				for (k1 = std::max(k1, k); k1 < ksize; k1++) {
+					if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
+						if (k1 > k) {
+							memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+						}
+						break;
 					}
-					break;
 				}
+				if (k1 == ksize) {
+					k0 = std::min(k0, k); // remember the first row that needs to be computed
+				}
+				srows[k] = (const value_type*)src.ptr(sy);
+				prev_sy[k] = sy;
 			}
-			if (k1 == ksize) {
-				k0 = std::min(k0, k); // remember the first row that needs to be computed
-			}
-			srows[k] = (const value_type*)src.ptr(sy);
-			prev_sy[k] = sy;
-		}
 
-		if (k0 < ksize) {
-			hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
-				ssize.width, dsize.width, cn, xmin, xmax);
-		}
-		if (sizeof(_Tp) == 1) { // uchar
-			vresize1((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
-		} else { // float
-			vresize2((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			if (k0 < ksize) {
+				hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
+					ssize.width, dsize.width, cn, xmin, xmax);
+			}
+			if (sizeof(_Tp) == 1) { // uchar
+				vresize1((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			} else { // float
+				vresize2((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			}
 		}
-	}
+	}, dst.total() / (double)(1 << 16));
 }
 
 template<typename _Tp, typename value_type, typename buf_type, typename alpha_type, int chs>
@@ -574,231 +732,249 @@ static void resizeGeneric_Lanczos4(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& ds
 	const int* xofs, const void* _alpha, const int* yofs, const void* _beta, int xmin, int xmax, int ksize)
 {
 	Size ssize = src.size(), dsize = dst.size();
-	int dy, cn = src.channels;
+	int cn = src.channels;
 	ssize.width *= cn;
 	dsize.width *= cn;
 	xmin *= cn;
 	xmax *= cn;
 	// image resize is a separable operation. In case of not too strong
 
-	Range range(0, dsize.height);
-
-	int bufstep = (int)alignSize(dsize.width, 16);
-	AutoBuffer<buf_type> _buffer(bufstep*ksize);
-	const value_type* srows[MAX_ESIZE] = { 0 };
-	buf_type* rows[MAX_ESIZE] = { 0 };
-	int prev_sy[MAX_ESIZE];
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		int bufstep = (int)alignSize(dsize.width, 16);
+		AutoBuffer<buf_type> _buffer(bufstep*ksize);
+		const value_type* srows[MAX_ESIZE] = { 0 };
+		buf_type* rows[MAX_ESIZE] = { 0 };
+		int prev_sy[MAX_ESIZE];
 
-	for (int k = 0; k < ksize; k++) {
-		prev_sy[k] = -1;
-		rows[k] = (buf_type*)_buffer + bufstep*k;
-	}
+		for (int k = 0; k < ksize; k++) {
+			prev_sy[k] = -1;
+			rows[k] = (buf_type*)_buffer + bufstep*k;
+		}
 
-	const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
+		const alpha_type* beta = (const alpha_type*)_beta + ksize * range.start;
 
-	HResizeLanczos4<value_type, buf_type, alpha_type> hresize;
-	VResizeLanczos4<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
-	VResizeLanczos4<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
+		HResizeLanczos4<value_type, buf_type, alpha_type> hresize;
+		VResizeLanczos4<value_type, buf_type, alpha_type, FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS * 2>> vresize1;
+		VResizeLanczos4<value_type, buf_type, alpha_type, Cast<float, float>> vresize2;
 
-	for (dy = range.start; dy < range.end; dy++, beta += ksize) {
-		int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
+		for (int dy = range.start; dy < range.end; dy++, beta += ksize) {
+			int sy0 = yofs[dy], k0 = ksize, k1 = 0, ksize2 = ksize / 2;
 
-		for (int k = 0; k < ksize; k++) {
-			int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
-			for (k1 = std::max(k1, k); k1 < ksize; k1++) {
-				if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
-					if (k1 > k) {
-						memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+			for (int k = 0; k < ksize; k++) {
+				int sy = clip<int>(sy0 - ksize2 + 1 + k, 0, ssize.height);
+				for (k1 = std::max(k1, k); k1 < ksize; k1++) {
+					if (sy == prev_sy[k1]) { // if the sy-th row has been computed already, reuse it.
+						if (k1 > k) {
+							memcpy(rows[k], rows[k1], bufstep*sizeof(rows[0][0]));
+						}
+						break;
 					}
-					break;
 				}
+				if (k1 == ksize) {
+					k0 = std::min(k0, k); // remember the first row that needs to be computed
+				}
+				srows[k] = (const value_type*)src.ptr(sy);
+				prev_sy[k] = sy;
 			}
-			if (k1 == ksize) {
-				k0 = std::min(k0, k); // remember the first row that needs to be computed
-			}
-			srows[k] = (const value_type*)src.ptr(sy);
-			prev_sy[k] = sy;
-		}
 
-		if (k0 < ksize) {
-			hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
-				ssize.width, dsize.width, cn, xmin, xmax);
-		}
-		if (sizeof(_Tp) == 1) { // uchar
-			vresize1((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
-		}
-		else { // float
-			vresize2((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			if (k0 < ksize) {
+				hresize((const value_type**)(srows + k0), (buf_type**)(rows + k0), ksize - k0, xofs, (const alpha_type*)(_alpha),
+					ssize.width, dsize.width, cn, xmin, xmax);
+			}
+			if (sizeof(_Tp) == 1) { // uchar
+				vresize1((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			}
+			else { // float
+				vresize2((const buf_type**)rows, (value_type*)(dst.data + dst.step*dy), beta, dsize.width);
+			}
 		}
-	}
-
+	}, dst.total() / (double)(1 << 16));
 }
 
-template<typename _Tp, typename T, typename WT, int chs>
-static void resizeGeneric_Area(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst,
+template<typename _Tp, typename T, typename WT, int chs, class Source, class Sink>
+static void resizeGeneric_Area(Size ssize, Size dsize, const Source& source, const Sink& sink,
 	const DecimateAlpha* xtab0, int xtab_size0, const DecimateAlpha* ytab, int ytab_size, const int* tabofs)
 {
-	Size dsize = dst.size();
-	int cn = dst.channels;
-	Range range(0, dsize.height);
+	int cn = chs;
 	dsize.width *= cn;
-	AutoBuffer<WT> _buffer(dsize.width * 2);
-	const DecimateAlpha* xtab = xtab0;
-	int xtab_size = xtab_size0;
-	WT *buf = _buffer, *sum = buf + dsize.width;
-	int j_start = tabofs[range.start], j_end = tabofs[range.end], j, k, dx, prev_dy = ytab[j_start].di;
-
-	for (dx = 0; dx < dsize.width; dx++) {
-		sum[dx] = (WT)0;
-	}
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		AutoBuffer<WT> _buffer(dsize.width * 2);
+		AutoBuffer<T> _srcbuf(Source::GENERATED ? source.step() / sizeof(T) : 1);
+		AutoBuffer<T> _dstbuf(Sink::GENERATED ? dsize.width : 1);
+		const T* S = NULL;
+		int prev_sy = -1;
+		const DecimateAlpha* xtab = xtab0;
+		int xtab_size = xtab_size0;
+		WT *buf = _buffer, *sum = buf + dsize.width;
+		int j_start = tabofs[range.start], j_end = tabofs[range.end], j, k, dx, prev_dy = ytab[j_start].di;
 
-	for (j = j_start; j < j_end; j++) {
-		WT beta = ytab[j].alpha;
-		int dy = ytab[j].di;
-		int sy = ytab[j].si;
-
-		const T* S = (const T*)src.ptr(sy);
 		for (dx = 0; dx < dsize.width; dx++) {
-			buf[dx] = (WT)0;
+			sum[dx] = (WT)0;
 		}
 
-		if (cn == 1) {
-			for (k = 0; k < xtab_size; k++) {
-				int dxn = xtab[k].di;
-				WT alpha = xtab[k].alpha;
-				buf[dxn] += S[xtab[k].si] * alpha;
-			}
-		} else if (cn == 2) {
-			for (k = 0; k < xtab_size; k++) {
-				int sxn = xtab[k].si;
-				int dxn = xtab[k].di;
-				WT alpha = xtab[k].alpha;
-				WT t0 = buf[dxn] + S[sxn] * alpha;
-				WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
-				buf[dxn] = t0; buf[dxn + 1] = t1;
-			}
-		} else if (cn == 3) {
-			for (k = 0; k < xtab_size; k++) {
-				int sxn = xtab[k].si;
-				int dxn = xtab[k].di;
-				WT alpha = xtab[k].alpha;
-				WT t0 = buf[dxn] + S[sxn] * alpha;
-				WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
-				WT t2 = buf[dxn + 2] + S[sxn + 2] * alpha;
-				buf[dxn] = t0; buf[dxn + 1] = t1; buf[dxn + 2] = t2;
+		for (j = j_start; j < j_end; j++) {
+			WT beta = ytab[j].alpha;
+			int dy = ytab[j].di;
+			int sy = ytab[j].si;
+
+			if (sy != prev_sy) { // the last row of an area can be the first row of the next one
+				S = (const T*)source(sy, 1, (_Tp*)(T*)_srcbuf);
+				prev_sy = sy;
 			}
-		} else if (cn == 4) {
-			for (k = 0; k < xtab_size; k++) {
-				int sxn = xtab[k].si;
-				int dxn = xtab[k].di;
-				WT alpha = xtab[k].alpha;
-				WT t0 = buf[dxn] + S[sxn] * alpha;
-				WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
-				buf[dxn] = t0; buf[dxn + 1] = t1;
-				t0 = buf[dxn + 2] + S[sxn + 2] * alpha;
-				t1 = buf[dxn + 3] + S[sxn + 3] * alpha;
-				buf[dxn + 2] = t0; buf[dxn + 3] = t1;
+			for (dx = 0; dx < dsize.width; dx++) {
+				buf[dx] = (WT)0;
 			}
-		} else {
-			for (k = 0; k < xtab_size; k++) {
-				int sxn = xtab[k].si;
-				int dxn = xtab[k].di;
-				WT alpha = xtab[k].alpha;
-				for (int c = 0; c < cn; c++)
-					buf[dxn + c] += S[sxn + c] * alpha;
+
+			if (cn == 1) {
+				for (k = 0; k < xtab_size; k++) {
+					int dxn = xtab[k].di;
+					WT alpha = xtab[k].alpha;
+					buf[dxn] += S[xtab[k].si] * alpha;
+				}
+			} else if (cn == 2) {
+				for (k = 0; k < xtab_size; k++) {
+					int sxn = xtab[k].si;
+					int dxn = xtab[k].di;
+					WT alpha = xtab[k].alpha;
+					WT t0 = buf[dxn] + S[sxn] * alpha;
+					WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
+					buf[dxn] = t0; buf[dxn + 1] = t1;
+				}
+			} else if (cn == 3) {
+				for (k = 0; k < xtab_size; k++) {
+					int sxn = xtab[k].si;
+					int dxn = xtab[k].di;
+					WT alpha = xtab[k].alpha;
+					WT t0 = buf[dxn] + S[sxn] * alpha;
+					WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
+					WT t2 = buf[dxn + 2] + S[sxn + 2] * alpha;
+					buf[dxn] = t0; buf[dxn + 1] = t1; buf[dxn + 2] = t2;
+				}
+			} else if (cn == 4) {
+				for (k = 0; k < xtab_size; k++) {
+					int sxn = xtab[k].si;
+					int dxn = xtab[k].di;
+					WT alpha = xtab[k].alpha;
+					WT t0 = buf[dxn] + S[sxn] * alpha;
+					WT t1 = buf[dxn + 1] + S[sxn + 1] * alpha;
+					buf[dxn] = t0; buf[dxn + 1] = t1;
+					t0 = buf[dxn + 2] + S[sxn + 2] * alpha;
+					t1 = buf[dxn + 3] + S[sxn + 3] * alpha;
+					buf[dxn + 2] = t0; buf[dxn + 3] = t1;
+				}
+			} else {
+				for (k = 0; k < xtab_size; k++) {
+					int sxn = xtab[k].si;
+					int dxn = xtab[k].di;
+					WT alpha = xtab[k].alpha;
+					for (int c = 0; c < cn; c++)
+						buf[dxn + c] += S[sxn + c] * alpha;
+				}
 			}
-		}
 
-		if (dy != prev_dy) {
-			T* D = (T*)dst.ptr(prev_dy);
+			if (dy != prev_dy) {
+				T* D = (T*)sink(prev_dy, (_Tp*)(T*)_dstbuf);
 
-			for (dx = 0; dx < dsize.width; dx++) {
-				D[dx] = saturate_cast<T>(sum[dx]);
-				sum[dx] = beta*buf[dx];
-			}
-			prev_dy = dy;
-		} else {
-			for (dx = 0; dx < dsize.width; dx++) {
-				sum[dx] += beta*buf[dx];
+				for (dx = 0; dx < dsize.width; dx++) {
+					D[dx] = saturate_cast<T>(sum[dx]);
+					sum[dx] = beta*buf[dx];
+				}
+				sink.commit(prev_dy, (const _Tp*)D);
+				prev_dy = dy;
+			} else {
+				for (dx = 0; dx < dsize.width; dx++) {
+					sum[dx] += beta*buf[dx];
+				}
 			}
 		}
-	}
 
-	T* D = (T*)dst.ptr(prev_dy);
-	for (dx = 0; dx < dsize.width; dx++) {
-		D[dx] = saturate_cast<T>(sum[dx]);
-	}
+		T* D = (T*)sink(prev_dy, (_Tp*)(T*)_dstbuf);
+		for (dx = 0; dx < dsize.width; dx++) {
+			D[dx] = saturate_cast<T>(sum[dx]);
+		}
+		sink.commit(prev_dy, (const _Tp*)D);
+	}, dsize.area() / (double)(1 << 16));
 }
 
-template<typename _Tp, typename T, typename WT, int chs>
-static void resizeGeneric_AreaFast(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst,
+template<typename _Tp, typename T, typename WT, int chs, class Source, class Sink>
+static void resizeGeneric_AreaFast(Size ssize, Size dsize, const Source& source, const Sink& sink,
 	const int* ofs, const int* xofs, int scale_x, int scale_y)
 {
-	Size ssize = src.size(), dsize = dst.size();
-	int cn = src.channels;
-	Range range(0, dsize.height);
+	int cn = chs;
 	int area = scale_x*scale_y;
 	float scale = 1.f / (area);
 	int dwidth1 = (ssize.width / scale_x)*cn;
 	dsize.width *= cn;
 	ssize.width *= cn;
-	int dy, dx, k = 0;
+	size_t srcstep = source.step();
 
-	ResizeAreaFastVec<uchar> vop(scale_x, scale_y, src.channels, (int)src.step);
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		int dy, dx, k = 0;
+		// the scale_y source rows of an area, one generated destination row
+		AutoBuffer<T> _srcbuf(Source::GENERATED ? srcstep / sizeof(T) * scale_y : 1);
+		AutoBuffer<T> _dstbuf(Sink::GENERATED ? dsize.width : 1);
 
-	for (dy = range.start; dy < range.end; dy++) {
-		T* D = (T*)(dst.data + dst.step*dy);
-		int sy0 = dy*scale_y;
-		int w = sy0 + scale_y <= ssize.height ? dwidth1 : 0;
+		ResizeAreaFastVec<uchar> vop(scale_x, scale_y, cn, (int)srcstep);
 
-		if (sy0 >= ssize.height) {
-			for (dx = 0; dx < dsize.width; dx++) {
-				D[dx] = 0;
+		for (dy = range.start; dy < range.end; dy++) {
+			T* D = (T*)sink(dy, (_Tp*)(T*)_dstbuf);
+			int sy0 = dy*scale_y;
+			int w = sy0 + scale_y <= ssize.height ? dwidth1 : 0;
+
+			if (sy0 >= ssize.height) {
+				for (dx = 0; dx < dsize.width; dx++) {
+					D[dx] = 0;
+				}
+				sink.commit(dy, (const _Tp*)D);
+				continue;
 			}
-			continue;
-		}
 
-		dx = sizeof(_Tp) == 1 ? vop(src.ptr(sy0), (uchar*)D, w) : 0;
-		for (; dx < w; dx++) {
-			const T* S = (const T*)src.ptr(sy0) +xofs[dx];
-			WT sum = 0;
-			k = 0;
+			const T* S0 = (const T*)source(sy0, std::min(scale_y, ssize.height - sy0), (_Tp*)(T*)_srcbuf);
 
-			for (; k <= area - 4; k += 4) {
-				sum += S[ofs[k]] + S[ofs[k + 1]] + S[ofs[k + 2]] + S[ofs[k + 3]];
-			}
+			dx = sizeof(_Tp) == 1 ? vop((const uchar*)S0, (uchar*)D, w) : 0;
+			for (; dx < w; dx++) {
+				const T* S = S0 + xofs[dx];
+				WT sum = 0;
+				k = 0;
 
-			for (; k < area; k++) {
-				sum += S[ofs[k]];
-			}
+				for (; k <= area - 4; k += 4) {
+					sum += S[ofs[k]] + S[ofs[k + 1]] + S[ofs[k + 2]] + S[ofs[k + 3]];
+				}
 
-			D[dx] = saturate_cast<T>(sum * scale);
-		}
+				for (; k < area; k++) {
+					sum += S[ofs[k]];
+				}
 
-		for (; dx < dsize.width; dx++) {
-			WT sum = 0;
-			int count = 0, sx0 = xofs[dx];
-			if (sx0 >= ssize.width) {
-				D[dx] = 0;
+				D[dx] = saturate_cast<T>(sum * scale);
 			}
 
-			for (int sy = 0; sy < scale_y; sy++) {
-				if (sy0 + sy >= ssize.height) {
-					break;
+			for (; dx < dsize.width; dx++) {
+				WT sum = 0;
+				int count = 0, sx0 = xofs[dx];
+				if (sx0 >= ssize.width) {
+					D[dx] = 0;
 				}
-				const T* S = (const T*)src.ptr(sy0 + sy) + sx0;
-				for (int sx = 0; sx < scale_x*cn; sx += cn) {
-					if (sx0 + sx >= ssize.width) {
+
+				for (int sy = 0; sy < scale_y; sy++) {
+					if (sy0 + sy >= ssize.height) {
 						break;
 					}
-					sum += S[sx];
-					count++;
+					const T* S = (const T*)((const uchar*)S0 + sy*srcstep) + sx0;
+					for (int sx = 0; sx < scale_x*cn; sx += cn) {
+						if (sx0 + sx >= ssize.width) {
+							break;
+						}
+						sum += S[sx];
+						count++;
+					}
 				}
+
+				D[dx] = saturate_cast<T>((float)sum / count);
 			}
 
-			D[dx] = saturate_cast<T>((float)sum / count);
+			sink.commit(dy, (const _Tp*)D);
 		}
-	}
+	}, dsize.area() / (double)(1 << 16));
 }
 
 template<typename _Tp>
@@ -841,149 +1017,233 @@ static void interpolateLanczos4(_Tp x, _Tp* coeffs)
 }
 
 template<typename _Tp, int chs>
-static int resize_nearest(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+static void resizeGeneric_Nearest(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, const int* x_ofs)
 {
 	Size ssize = src.size();
 	Size dsize = dst.size();
-
-	double fx = (double)dsize.width / ssize.width;
-	double fy = (double)dsize.height / ssize.height;
-
-	AutoBuffer<int> _x_ofs(dsize.width);
-	int* x_ofs = _x_ofs;
 	int pix_size = (int)src.elemSize();
 	int pix_size4 = (int)(pix_size / sizeof(int));
-	double ifx = 1. / fx, ify = 1. / fy;
-
-	for (int x = 0; x < dsize.width; x++) {
-		int sx = fbcFloor(x*ifx);
-		x_ofs[x] = std::min(sx, ssize.width - 1)*pix_size;
-	}
+	double fy = (double)dsize.height / ssize.height;
+	double ify = 1. / fy;
+
+	parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+		int x, y;
+
+		for (y = range.start; y < range.end; y++) {
+			uchar* D = dst.data + dst.step*y;
+			int sy = std::min(fbcFloor(y*ify), ssize.height - 1);
+			const uchar* S = src.ptr(sy);
+
+			switch (pix_size) {
+			case 1:
+				for (x = 0; x <= dsize.width - 2; x += 2) {
+					uchar t0 = S[x_ofs[x]];
+					uchar t1 = S[x_ofs[x + 1]];
+					D[x] = t0;
+					D[x + 1] = t1;
+				}
 
-	Range range(0, dsize.height);
-	int x, y;
-
-	for (y = range.start; y < range.end; y++) {
-		uchar* D = dst.data + dst.step*y;
-		int sy = std::min(fbcFloor(y*ify), ssize.height - 1);
-		const uchar* S = src.ptr(sy);
-
-		switch (pix_size) {
-		case 1:
-			for (x = 0; x <= dsize.width - 2; x += 2) {
-				uchar t0 = S[x_ofs[x]];
-				uchar t1 = S[x_ofs[x + 1]];
-				D[x] = t0;
-				D[x + 1] = t1;
+				for (; x < dsize.width; x++) {
+					D[x] = S[x_ofs[x]];
+				}
+				break;
+			case 2:
+				for (x = 0; x < dsize.width; x++) {
+					*(ushort*)(D + x * 2) = *(ushort*)(S + x_ofs[x]);
+				}
+				break;
+			case 3:
+				for (x = 0; x < dsize.width; x++, D += 3) {
+					const uchar* _tS = S + x_ofs[x];
+					D[0] = _tS[0]; D[1] = _tS[1]; D[2] = _tS[2];
+				}
+				break;
+			case 4:
+				for (x = 0; x < dsize.width; x++) {
+					*(int*)(D + x * 4) = *(int*)(S + x_ofs[x]);
+				}
+				break;
+			case 6:
+				for (x = 0; x < dsize.width; x++, D += 6) {
+					const ushort* _tS = (const ushort*)(S + x_ofs[x]);
+					ushort* _tD = (ushort*)D;
+					_tD[0] = _tS[0]; _tD[1] = _tS[1]; _tD[2] = _tS[2];
+				}
+				break;
+			case 8:
+				for (x = 0; x < dsize.width; x++, D += 8) {
+					const int* _tS = (const int*)(S + x_ofs[x]);
+					int* _tD = (int*)D;
+					_tD[0] = _tS[0]; _tD[1] = _tS[1];
+				}
+				break;
+			case 12:
+				for (x = 0; x < dsize.width; x++, D += 12) {
+					const int* _tS = (const int*)(S + x_ofs[x]);
+					int* _tD = (int*)D;
+					_tD[0] = _tS[0]; _tD[1] = _tS[1]; _tD[2] = _tS[2];
+				}
+				break;
+			default:
+				for (x = 0; x < dsize.width; x++, D += pix_size) {
+					const int* _tS = (const int*)(S + x_ofs[x]);
+					int* _tD = (int*)D;
+					for (int k = 0; k < pix_size4; k++)
+						_tD[k] = _tS[k];
+				}
 			}
+		}
+	}, dst.total() / (double)(1 << 16));
+}
 
-			for (; x < dsize.width; x++) {
-				D[x] = S[x_ofs[x]];
-			}
-			break;
-		case 2:
-			for (x = 0; x < dsize.width; x++) {
-				*(ushort*)(D + x * 2) = *(ushort*)(S + x_ofs[x]);
-			}
-			break;
-		case 3:
-			for (x = 0; x < dsize.width; x++, D += 3) {
-				const uchar* _tS = S + x_ofs[x];
-				D[0] = _tS[0]; D[1] = _tS[1]; D[2] = _tS[2];
-			}
+template<typename _Tp, int chs>
+ResizePlan<_Tp, chs>::ResizePlan(Size ssize_, Size dsize_, int interpolation)
+	: ssize(ssize_), dsize(dsize_), inter(interpolation), mode(MODE_COPY), ksize(0), xmin(0), xmax(0), iscale_x(0), iscale_y(0)
+{
+	FBC_Assert((interpolation >= 0) && (interpolation < 5));
+	FBC_Assert((ssize.height >= 4 && ssize.width >= 4) && (dsize.height >= 4 && dsize.width >= 4));
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
+
+	if (dsize == ssize)
+		return;
+
+	double inv_scale_x = (double)dsize.width / ssize.width;
+	double inv_scale_y = (double)dsize.height / ssize.height;
+	double scale_x = 1. / inv_scale_x, scale_y = 1. / inv_scale_y;
+
+	int iscale_x_ = saturate_cast<int>(scale_x);
+	int iscale_y_ = saturate_cast<int>(scale_y);
+
+	bool is_area_fast = std::abs(scale_x - iscale_x_) < DBL_EPSILON && std::abs(scale_y - iscale_y_) < DBL_EPSILON;
+
+	switch (interpolation) {
+		case INTER_NEAREST: {
+			initNearest();
 			break;
-		case 4:
-			for (x = 0; x < dsize.width; x++) {
-				*(int*)(D + x * 4) = *(int*)(S + x_ofs[x]);
+		}
+		case INTER_LINEAR: {
+			// in case of scale_x && scale_y is equal to 2
+			// INTER_AREA (fast) also is equal to INTER_LINEAR
+			if (is_area_fast && iscale_x_ == 2 && iscale_y_ == 2) {
+				mode = MODE_AREA_FAST;
+				iscale_x = iscale_x_;
+				iscale_y = iscale_y_;
+			} else {
+				mode = MODE_LINEAR;
+				initSeparable(2, false);
 			}
 			break;
-		case 6:
-			for (x = 0; x < dsize.width; x++, D += 6) {
-				const ushort* _tS = (const ushort*)(S + x_ofs[x]);
-				ushort* _tD = (ushort*)D;
-				_tD[0] = _tS[0]; _tD[1] = _tS[1]; _tD[2] = _tS[2];
-			}
+		}
+		case INTER_CUBIC: {
+			mode = MODE_CUBIC;
+			initSeparable(4, false);
 			break;
-		case 8:
-			for (x = 0; x < dsize.width; x++, D += 8) {
-				const int* _tS = (const int*)(S + x_ofs[x]);
-				int* _tD = (int*)D;
-				_tD[0] = _tS[0]; _tD[1] = _tS[1];
+		}
+		case INTER_AREA: {
+			// true "area" interpolation is only implemented for the case (scale_x <= 1 && scale_y <= 1).
+			// In other cases it is emulated using some variant of bilinear interpolation
+			if (scale_x >= 1 && scale_y >= 1) {
+				if (is_area_fast) {
+					mode = MODE_AREA_FAST;
+					iscale_x = iscale_x_;
+					iscale_y = iscale_y_;
+				} else {
+					mode = MODE_AREA;
+					initArea(scale_x, scale_y);
+				}
+			} else {
+				mode = MODE_LINEAR;
+				initSeparable(2, true);
 			}
 			break;
-		case 12:
-			for (x = 0; x < dsize.width; x++, D += 12) {
-				const int* _tS = (const int*)(S + x_ofs[x]);
-				int* _tD = (int*)D;
-				_tD[0] = _tS[0]; _tD[1] = _tS[1]; _tD[2] = _tS[2];
-			}
+		}
+		case INTER_LANCZOS4: {
+			mode = MODE_LANCZOS4;
+			initSeparable(8, false);
 			break;
-		default:
-			for (x = 0; x < dsize.width; x++, D += pix_size) {
-				const int* _tS = (const int*)(S + x_ofs[x]);
-				int* _tD = (int*)D;
-				for (int k = 0; k < pix_size4; k++)
-					_tD[k] = _tS[k];
-			}
 		}
 	}
 
-	return 0;
+	if (mode == MODE_AREA_FAST) {
+		int cn = chs;
+		xofs.resize(dsize.width * cn);
+		for (int dx = 0; dx < dsize.width; dx++) {
+			int j = dx * cn;
+			int sx = iscale_x * j;
+			for (int k = 0; k < cn; k++) {
+				xofs[j + k] = sx + k;
+			}
+		}
+	}
 }
 
 template<typename _Tp, int chs>
-static int resize_linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+void ResizePlan<_Tp, chs>::initNearest()
 {
-	Size ssize = src.size();
-	Size dsize = dst.size();
+	mode = MODE_NEAREST;
+
+	double fx = (double)dsize.width / ssize.width;
+	int pix_size = (int)(sizeof(_Tp) * chs);
+	double ifx = 1. / fx;
 
+	xofs.resize(dsize.width);
+	for (int x = 0; x < dsize.width; x++) {
+		int sx = fbcFloor(x*ifx);
+		xofs[x] = std::min(sx, ssize.width - 1)*pix_size;
+	}
+}
+
+template<typename _Tp, int chs>
+void ResizePlan<_Tp, chs>::initSeparable(int ksize_, bool area)
+{
 	double inv_scale_x = (double)dsize.width / ssize.width;
 	double inv_scale_y = (double)dsize.height / ssize.height;
 	double scale_x = 1. / inv_scale_x, scale_y = 1. / inv_scale_y;
 
-	int iscale_x = saturate_cast<int>(scale_x);
-	int iscale_y = saturate_cast<int>(scale_y);
-
-	bool is_area_fast = std::abs(scale_x - iscale_x) < DBL_EPSILON && std::abs(scale_y - iscale_y) < DBL_EPSILON;
-	// in case of scale_x && scale_y is equal to 2
-	// INTER_AREA (fast) also is equal to INTER_LINEAR
-	if (is_area_fast && iscale_x == 2 && iscale_y == 2) {
-		resize_area(src, dst);
-		return 0;
-	}
-
-	int cn = dst.channels;
+	int cn = chs;
 	int k, sx, sy, dx, dy;
-	int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
+	int width = dsize.width*cn;
 	bool fixpt = sizeof(_Tp) == 1 ? true : false;
+	// the linear (and area) coefficients are clamped at the borders, cubic and lanczos4 use border extrapolation
+	bool clamp = ksize_ == 2;
 	float fx, fy;
-	int ksize = 2, ksize2;
-	ksize2 = ksize / 2;
-
-	AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
-	int* xofs = (int*)(uchar*)_buffer;
-	int* yofs = xofs + width;
-	float* alpha = (float*)(yofs + dsize.height);
-	short* ialpha = (short*)alpha;
-	float* beta = alpha + width*ksize;
-	short* ibeta = ialpha + width*ksize;
+	int ksize2 = ksize_ / 2;
 	float cbuf[MAX_ESIZE];
 
+	ksize = ksize_;
+	xmin = 0;
+	xmax = dsize.width;
+	xofs.resize(width);
+	yofs.resize(dsize.height);
+	if (fixpt) {
+		ialpha.resize(width*ksize);
+		ibeta.resize(dsize.height*ksize);
+	} else {
+		alpha.resize(width*ksize);
+		beta.resize(dsize.height*ksize);
+	}
+
 	for (dx = 0; dx < dsize.width; dx++) {
-		fx = (float)((dx + 0.5)*scale_x - 0.5);
-		sx = fbcFloor(fx);
-		fx -= sx;
+		if (area) {
+			sx = fbcFloor(dx*scale_x);
+			fx = (float)((dx + 1) - (sx + 1)*inv_scale_x);
+			fx = fx <= 0 ? 0.f : fx - fbcFloor(fx);
+		} else {
+			fx = (float)((dx + 0.5)*scale_x - 0.5);
+			sx = fbcFloor(fx);
+			fx -= sx;
+		}
 
 		if (sx < ksize2 - 1) {
 			xmin = dx + 1;
-			if (sx < 0) {
+			if (clamp && sx < 0) {
 				fx = 0, sx = 0;
 			}
 		}
 
 		if (sx + ksize2 >= ssize.width) {
 			xmax = std::min(xmax, dx);
-			if (sx >= ssize.width - 1) {
+			if (clamp && sx >= ssize.width - 1) {
 				fx = 0, sx = ssize.width - 1;
 			}
 		}
@@ -992,8 +1252,14 @@ static int resize_linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 			xofs[dx*cn + k] = sx + k;
 		}
 
-		cbuf[0] = 1.f - fx;
-		cbuf[1] = fx;
+		if (ksize == 2) {
+			cbuf[0] = 1.f - fx;
+			cbuf[1] = fx;
+		} else if (ksize == 4) {
+			interpolateCubic<float>(fx, cbuf);
+		} else {
+			interpolateLanczos4<float>(fx, cbuf);
+		}
 
 		if (fixpt) {
 			for (k = 0; k < ksize; k++) {
@@ -1013,13 +1279,26 @@ static int resize_linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 	}
 
 	for (dy = 0; dy < dsize.height; dy++) {
-		fy = (float)((dy + 0.5)*scale_y - 0.5);
-		sy = fbcFloor(fy);
-		fy -= sy;
+		if (area) {
+			sy = fbcFloor(dy*scale_y);
+			fy = (float)((dy + 1) - (sy + 1)*inv_scale_y);
+			fy = fy <= 0 ? 0.f : fy - fbcFloor(fy);
+		} else {
+			fy = (float)((dy + 0.5)*scale_y - 0.5);
+			sy = fbcFloor(fy);
+			fy -= sy;
+		}
 
 		yofs[dy] = sy;
-		cbuf[0] = 1.f - fy;
-		cbuf[1] = fy;
+
+		if (ksize == 2) {
+			cbuf[0] = 1.f - fy;
+			cbuf[1] = fy;
+		} else if (ksize == 4) {
+			interpolateCubic<float>(fy, cbuf);
+		} else {
+			interpolateLanczos4<float>(fy, cbuf);
+		}
 
 		if (fixpt) {
 			for (k = 0; k < ksize; k++) {
@@ -1031,427 +1310,181 @@ static int resize_linear(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 			}
 		}
 	}
+}
 
-	if (sizeof(_Tp) == 1) { // uchar
-		typedef uchar value_type; // HResizeLinear/VResizeLinear
-		typedef int buf_type;
-		typedef short alpha_type;
-		int ONE = INTER_RESIZE_COEF_SCALE;
-
-		resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize, ONE);
-	} else if (sizeof(_Tp) == 4) { // float
-		typedef float value_type; // HResizeLinear/VResizeLinear
-		typedef float buf_type;
-		typedef float alpha_type;
-		int ONE = 1;
-
-		resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize, ONE);
-	} else {
-		fprintf(stderr, "not support type\n");
-		return -1;
+template<typename _Tp, int chs>
+void ResizePlan<_Tp, chs>::initArea(double scale_x, double scale_y)
+{
+	int cn = chs;
+	FBC_Assert(cn <= 4);
+
+	xtab.resize(ssize.width * 2);
+	ytab.resize(ssize.height * 2);
+
+	int xtab_size = computeResizeAreaTab<int>(ssize.width, dsize.width, cn, scale_x, &xtab[0]);
+	int ytab_size = computeResizeAreaTab<int>(ssize.height, dsize.height, 1, scale_y, &ytab[0]);
+	xtab.resize(xtab_size);
+	ytab.resize(ytab_size);
+
+	tabofs.resize(dsize.height + 1);
+	int k, dy;
+	for (k = 0, dy = 0; k < ytab_size; k++) {
+		if (k == 0 || ytab[k].di != ytab[k - 1].di) {
+			assert(ytab[k].di == dy);
+			tabofs[dy++] = k;
+		}
 	}
-
-	return 0;
+	tabofs[dy] = ytab_size;
 }
 
 template<typename _Tp, int chs>
-static int resize_cubic(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+int ResizePlan<_Tp, chs>::apply(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst) const
 {
-	Size ssize = src.size();
-	Size dsize = dst.size();
+	FBC_Assert(src.size() == ssize && dst.size() == dsize);
 
-	double inv_scale_x = (double)dsize.width / ssize.width;
-	double inv_scale_y = (double)dsize.height / ssize.height;
-	double scale_x = 1. / inv_scale_x, scale_y = 1. / inv_scale_y;
-
-	int cn = dst.channels;
-	int k, sx, sy, dx, dy;
-	int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
 	bool fixpt = sizeof(_Tp) == 1 ? true : false;
-	float fx, fy;
-	int ksize = 4, ksize2;
-	ksize2 = ksize / 2;
-
-	AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
-	int* xofs = (int*)(uchar*)_buffer;
-	int* yofs = xofs + width;
-	float* alpha = (float*)(yofs + dsize.height);
-	short* ialpha = (short*)alpha;
-	float* beta = alpha + width*ksize;
-	short* ibeta = ialpha + width*ksize;
-	float cbuf[MAX_ESIZE];
-
-	for (dx = 0; dx < dsize.width; dx++) {
-		fx = (float)((dx + 0.5)*scale_x - 0.5);
-		sx = fbcFloor(fx);
-		fx -= sx;
-
-		if (sx < ksize2 - 1) {
-			xmin = dx + 1;
-		}
+	const void* _alpha = fixpt ? (const void*)ialpha.data() : (const void*)alpha.data();
+	const void* _beta = fixpt ? (const void*)ibeta.data() : (const void*)beta.data();
 
-		if (sx + ksize2 >= ssize.width) {
-			xmax = std::min(xmax, dx);
+	switch (mode) {
+		case MODE_COPY: {
+			src.copyTo(dst);
+			break;
 		}
-
-		for (k = 0, sx *= cn; k < cn; k++) {
-			xofs[dx*cn + k] = sx + k;
+		case MODE_NEAREST: {
+			resizeGeneric_Nearest(src, dst, xofs.data());
+			break;
 		}
-
-		interpolateCubic<float>(fx, cbuf);
-
-		if (fixpt) {
-			for (k = 0; k < ksize; k++) {
-				ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-			}
-			for (; k < cn*ksize; k++) {
-				ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
-			}
-		} else {
-			for (k = 0; k < ksize; k++) {
-				alpha[dx*cn*ksize + k] = cbuf[k];
-			}
-			for (; k < cn*ksize; k++) {
-				alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
+		case MODE_CUBIC: {
+			if (sizeof(_Tp) == 1) { // uchar
+				typedef uchar value_type; // HResizeCubic/VResizeCubic
+				typedef int buf_type;
+				typedef short alpha_type;
+
+				resizeGeneric_Cubic<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize);
+			} else { // float
+				typedef float value_type; // HResizeCubic/VResizeCubic
+				typedef float buf_type;
+				typedef float alpha_type;
+
+				resizeGeneric_Cubic<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize);
 			}
+			break;
 		}
-	}
-
-	for (dy = 0; dy < dsize.height; dy++) {
-		fy = (float)((dy + 0.5)*scale_y - 0.5);
-		sy = fbcFloor(fy);
-		fy -= sy;
-
-		yofs[dy] = sy;
-		interpolateCubic<float>(fy, cbuf);
-
-		if (fixpt) {
-			for (k = 0; k < ksize; k++) {
-				ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-			}
-		} else {
-			for (k = 0; k < ksize; k++) {
-				beta[dy*ksize + k] = cbuf[k];
+		case MODE_LANCZOS4: {
+			if (sizeof(_Tp) == 1) { // uchar
+				typedef uchar value_type; // HResizeLanczos4/VResizeLanczos4
+				typedef int buf_type;
+				typedef short alpha_type;
+
+				resizeGeneric_Lanczos4<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize);
+			} else { // float
+				typedef float value_type; // HResizeLanczos4/VResizeLanczos4
+				typedef float buf_type;
+				typedef float alpha_type;
+
+				resizeGeneric_Lanczos4<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize);
 			}
+			break;
 		}
-	}
-
-	if (sizeof(_Tp) == 1) { // uchar
-		typedef uchar value_type; // HResizeCubic/VResizeCubic
-		typedef int buf_type;
-		typedef short alpha_type;
-
-		resizeGeneric_Cubic<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize);
-	} else if (sizeof(_Tp) == 4) { // float
-		typedef float value_type; // HResizeCubic/VResizeCubic
-		typedef float buf_type;
-		typedef float alpha_type;
-
-		resizeGeneric_Cubic<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize);
-	} else {
-		fprintf(stderr, "not support type\n");
-		return -1;
+		default:
+			// the modes that support a row source/sink
+			return apply(ResizeMatSource<_Tp, chs>(src), ResizeMatSink<_Tp, chs>(dst));
 	}
 
 	return 0;
 }
 
-template<typename _Tp, int chs>
-static int resize_area(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
+template<typename _Tp, int chs> template<class Source, class Sink>
+int ResizePlan<_Tp, chs>::apply(const Source& source, const Sink& sink) const
 {
-	Size ssize = src.size();
-	Size dsize = dst.size();
-	int cn = dst.channels;
-
-	double inv_scale_x = (double)dsize.width / ssize.width;
-	double inv_scale_y = (double)dsize.height / ssize.height;
-	double scale_x = 1. / inv_scale_x, scale_y = 1. / inv_scale_y;
-
-	int iscale_x = saturate_cast<int>(scale_x);
-	int iscale_y = saturate_cast<int>(scale_y);
-
-	bool is_area_fast = std::abs(scale_x - iscale_x) < DBL_EPSILON && std::abs(scale_y - iscale_y) < DBL_EPSILON;
-
-	int k, sx, sy, dx, dy;
-
-	// true "area" interpolation is only implemented for the case (scale_x <= 1 && scale_y <= 1).
-	// In other cases it is emulated using some variant of bilinear interpolation
-	if (scale_x >= 1 && scale_y >= 1) {
-		if (is_area_fast) {
+	bool fixpt = sizeof(_Tp) == 1 ? true : false;
+	const void* _alpha = fixpt ? (const void*)ialpha.data() : (const void*)alpha.data();
+	const void* _beta = fixpt ? (const void*)ibeta.data() : (const void*)beta.data();
+
+	switch (mode) {
+		case MODE_COPY: {
+			parallel_for_(Range(0, dsize.height), [&](const Range& range) {
+				AutoBuffer<_Tp> _srcbuf(Source::GENERATED ? source.step() / sizeof(_Tp) : 1);
+				AutoBuffer<_Tp> _dstbuf(Sink::GENERATED ? dsize.width * chs : 1);
+
+				for (int y = range.start; y < range.end; y++) {
+					const _Tp* S = source(y, 1, (_Tp*)_srcbuf);
+					_Tp* D = sink(y, (_Tp*)_dstbuf);
+					memcpy(D, S, dsize.width * chs * sizeof(_Tp));
+					sink.commit(y, D);
+				}
+			}, dsize.area() / (double)(1 << 16));
+			break;
+		}
+		case MODE_LINEAR: {
+			if (sizeof(_Tp) == 1) { // uchar
+				typedef uchar value_type; // HResizeLinear/VResizeLinear
+				typedef int buf_type;
+				typedef short alpha_type;
+				int ONE = INTER_RESIZE_COEF_SCALE;
+
+				resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(ssize, dsize, source, sink,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize, ONE);
+			} else { // float
+				typedef float value_type; // HResizeLinear/VResizeLinear
+				typedef float buf_type;
+				typedef float alpha_type;
+				int ONE = 1;
+
+				resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(ssize, dsize, source, sink,
+					xofs.data(), _alpha, yofs.data(), _beta, xmin, xmax, ksize, ONE);
+			}
+			break;
+		}
+		case MODE_AREA_FAST: {
+			// the offsets of the pixels of an area depend on the step of the source rows, they are not part of the plan
+			int cn = chs;
 			int area = iscale_x*iscale_y;
-			size_t srcstep = src.step / sizeof(_Tp);
-			AutoBuffer<int> _ofs(area + dsize.width*cn);
+			size_t srcstep = source.step() / sizeof(_Tp);
+			AutoBuffer<int> _ofs(area);
 			int* ofs = _ofs;
-			int* xofs = ofs + area;
 
-			for (sy = 0, k = 0; sy < iscale_y; sy++) {
-				for (sx = 0; sx < iscale_x; sx++) {
+			for (int sy = 0, k = 0; sy < iscale_y; sy++) {
+				for (int sx = 0; sx < iscale_x; sx++) {
 					ofs[k++] = (int)(sy*srcstep + sx*cn);
 				}
 			}
 
-			for (dx = 0; dx < dsize.width; dx++) {
-				int j = dx * cn;
-				sx = iscale_x * j;
-				for (k = 0; k < cn; k++) {
-					xofs[j + k] = sx + k;
-				}
-			}
-
 			if (sizeof(_Tp) == 1) { // uchar
 				typedef uchar T;
 				typedef int WT;
 
-				resizeGeneric_AreaFast<_Tp, T, WT, chs>(src, dst, ofs, xofs, iscale_x, iscale_y);
-			} else if (sizeof(_Tp) == 4) { // float
+				resizeGeneric_AreaFast<_Tp, T, WT, chs>(ssize, dsize, source, sink, ofs, xofs.data(), iscale_x, iscale_y);
+			} else { // float
 				typedef float T;
 				typedef float WT;
 
-				resizeGeneric_AreaFast<_Tp, T, WT, chs>(src, dst, ofs, xofs, iscale_x, iscale_y);
-			} else {
-				fprintf(stderr, "not support type\n");
-				return -1;
+				resizeGeneric_AreaFast<_Tp, T, WT, chs>(ssize, dsize, source, sink, ofs, xofs.data(), iscale_x, iscale_y);
 			}
-
-			return 0;
+			break;
 		}
+		case MODE_AREA: {
+			if (sizeof(_Tp) == 1) { // uchar
+				typedef uchar T;
+				typedef float WT;
 
-		FBC_Assert(cn <= 4);
-
-		AutoBuffer<DecimateAlpha> _xytab((ssize.width + ssize.height) * 2);
-		DecimateAlpha* xtab = _xytab, *ytab = xtab + ssize.width * 2;
-
-		int xtab_size = computeResizeAreaTab<int>(ssize.width, dsize.width, cn, scale_x, xtab);
-		int ytab_size = computeResizeAreaTab<int>(ssize.height, dsize.height, 1, scale_y, ytab);
+				resizeGeneric_Area<_Tp, T, WT, chs>(ssize, dsize, source, sink, xtab.data(), (int)xtab.size(), ytab.data(), (int)ytab.size(), tabofs.data());
+			} else { // float
+				typedef float T;
+				typedef float WT;
 
-		AutoBuffer<int> _tabofs(dsize.height + 1);
-		int* tabofs = _tabofs;
-		for (k = 0, dy = 0; k < ytab_size; k++) {
-			if (k == 0 || ytab[k].di != ytab[k - 1].di) {
-				assert(ytab[k].di == dy);
-				tabofs[dy++] = k;
+				resizeGeneric_Area<_Tp, T, WT, chs>(ssize, dsize, source, sink, xtab.data(), (int)xtab.size(), ytab.data(), (int)ytab.size(), tabofs.data());
 			}
+			break;
 		}
-		tabofs[dy] = ytab_size;
-
-		if (sizeof(_Tp) == 1) { // uchar
-			typedef uchar T;
-			typedef float WT;
-
-			resizeGeneric_Area<_Tp, T, WT, chs>(src, dst, xtab, xtab_size, ytab, ytab_size, tabofs);
-		} else if (sizeof(_Tp) == 4) { // float
-			typedef float T;
-			typedef float WT;
-
-			resizeGeneric_Area<_Tp, T, WT, chs>(src, dst, xtab, xtab_size, ytab, ytab_size, tabofs);
-		} else {
-			fprintf(stderr, "not support type\n");
+		default:
+			FBC_Error("the interpolation of the plan does not support a row source/sink");
 			return -1;
-		}
-
-		return 0;
-	}
-
-	int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
-	bool fixpt = sizeof(_Tp) == 1 ? true : false;
-	float fx, fy;
-	int ksize = 2, ksize2;
-	ksize2 = ksize / 2;
-
-	AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
-	int* xofs = (int*)(uchar*)_buffer;
-	int* yofs = xofs + width;
-	float* alpha = (float*)(yofs + dsize.height);
-	short* ialpha = (short*)alpha;
-	float* beta = alpha + width*ksize;
-	short* ibeta = ialpha + width*ksize;
-	float cbuf[MAX_ESIZE];
-
-	for (dx = 0; dx < dsize.width; dx++) {
-		sx = fbcFloor(dx*scale_x);
-		fx = (float)((dx + 1) - (sx + 1)*inv_scale_x);
-		fx = fx <= 0 ? 0.f : fx - fbcFloor(fx);
-
-		if (sx < ksize2 - 1) {
-			xmin = dx + 1;
-			if (sx < 0) {
-				fx = 0, sx = 0;
-			}
-		}
-
-		if (sx + ksize2 >= ssize.width) {
-			xmax = std::min(xmax, dx);
-			if (sx >= ssize.width - 1) {
-				fx = 0, sx = ssize.width - 1;
-			}
-		}
-
-		for (k = 0, sx *= cn; k < cn; k++) {
-			xofs[dx*cn + k] = sx + k;
-		}
-
-		cbuf[0] = 1.f - fx;
-		cbuf[1] = fx;
-
-		if (fixpt) {
-			for (k = 0; k < ksize; k++) {
-				ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-			}
-			for (; k < cn*ksize; k++) {
-				ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
-			}
-		} else {
-			for (k = 0; k < ksize; k++) {
-				alpha[dx*cn*ksize + k] = cbuf[k];
-			}
-			for (; k < cn*ksize; k++) {
-				alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
-			}
-		}
-	}
-
-	for (dy = 0; dy < dsize.height; dy++) {
-		sy = fbcFloor(dy*scale_y);
-		fy = (float)((dy + 1) - (sy + 1)*inv_scale_y);
-		fy = fy <= 0 ? 0.f : fy - fbcFloor(fy);
-
-		yofs[dy] = sy;
-		cbuf[0] = 1.f - fy;
-		cbuf[1] = fy;
-
-		if (fixpt) {
-			for (k = 0; k < ksize; k++) {
-				ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-			}
-		} else {
-			for (k = 0; k < ksize; k++) {
-				beta[dy*ksize + k] = cbuf[k];
-			}
-		}
-	}
-
-	if (sizeof(_Tp) == 1) { // uchar
-		typedef uchar value_type; // HResizeLinear/VResizeLinear
-		typedef int buf_type;
-		typedef short alpha_type;
-		int ONE = INTER_RESIZE_COEF_SCALE;
-
-		resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize, ONE);
-	} else if (sizeof(_Tp) == 4) { // float
-		typedef float value_type; // HResizeLinear/VResizeLinear
-		typedef float buf_type;
-		typedef float alpha_type;
-		int ONE = 1;
-
-		resizeGeneric_Linear<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize, ONE);
-	} else {
-		fprintf(stderr, "not support type\n");
-		return -1;
-	}
-
-	return 0;
-}
-
-template<typename _Tp, int chs>
-static int resize_lanczos4(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
-{
-	Size ssize = src.size();
-	Size dsize = dst.size();
-
-	double inv_scale_x = (double)dsize.width / ssize.width;
-	double inv_scale_y = (double)dsize.height / ssize.height;
-	double scale_x = 1. / inv_scale_x, scale_y = 1. / inv_scale_y;
-
-	int cn = dst.channels;
-	int k, sx, sy, dx, dy;
-	int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
-	bool fixpt = sizeof(_Tp) == 1 ? true : false;
-	float fx, fy;
-	int ksize = 8, ksize2;
-	ksize2 = ksize / 2;
-
-	AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
-	int* xofs = (int*)(uchar*)_buffer;
-	int* yofs = xofs + width;
-	float* alpha = (float*)(yofs + dsize.height);
-	short* ialpha = (short*)alpha;
-	float* beta = alpha + width*ksize;
-	short* ibeta = ialpha + width*ksize;
-	float cbuf[MAX_ESIZE];
-
-	for (dx = 0; dx < dsize.width; dx++) {
-		fx = (float)((dx + 0.5)*scale_x - 0.5);
-		sx = fbcFloor(fx);
-		fx -= sx;
-
-		if (sx < ksize2 - 1) {
-			xmin = dx + 1;
-		}
-
-		if (sx + ksize2 >= ssize.width) {
-			xmax = std::min(xmax, dx);
-		}
-
-		for (k = 0, sx *= cn; k < cn; k++) {
-			xofs[dx*cn + k] = sx + k;
-		}
-
-		interpolateLanczos4<float>(fx, cbuf);
-
-		if (fixpt) {
-			for (k = 0; k < ksize; k++)
-				ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-			for (; k < cn*ksize; k++)
-				ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
-		} else {
-			for (k = 0; k < ksize; k++)
-				alpha[dx*cn*ksize + k] = cbuf[k];
-			for (; k < cn*ksize; k++)
-				alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
-		}
-	}
-
-	for (dy = 0; dy < dsize.height; dy++) {
-		fy = (float)((dy + 0.5)*scale_y - 0.5);
-		sy = fbcFloor(fy);
-		fy -= sy;
-
-		yofs[dy] = sy;
-
-		interpolateLanczos4<float>(fy, cbuf);
-
-		if (fixpt){
-			for (k = 0; k < ksize; k++)
-				ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k] * INTER_RESIZE_COEF_SCALE);
-		} else {
-			for (k = 0; k < ksize; k++)
-				beta[dy*ksize + k] = cbuf[k];
-		}
-	}
-
-	if (sizeof(_Tp) == 1) { // uchar
-		typedef uchar value_type; // HResizeLanczos4/VResizeLanczos4
-		typedef int buf_type;
-		typedef short alpha_type;
-
-		resizeGeneric_Lanczos4<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize);
-	} else if (sizeof(_Tp) == 4) { // float
-		typedef float value_type; // HResizeLanczos4/VResizeLanczos4
-		typedef float buf_type;
-		typedef float alpha_type;
-
-		resizeGeneric_Lanczos4<_Tp, value_type, buf_type, alpha_type, chs>(src, dst,
-			xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize);
-	} else {
-		fprintf(stderr, "not support type\n");
-		return -1;
 	}
 
 	return 0;
@@ -1460,4 +1493,3 @@ static int resize_lanczos4(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 } // namespace fbc
 
 #endif // FBC_CV_RESIZE_HPP_
-
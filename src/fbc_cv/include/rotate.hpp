@@ -6,9 +6,15 @@
 
 /* reference: include/opencv2/imgproc.hpp
               modules/imgproc/src/imgwarp.cpp
+              include/opencv2/core.hpp
+              modules/core/src/matrix_transform.cpp
 */
 
+#include <math.h>
+#include <algorithm>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 #include "warpAffine.hpp"
 
 namespace fbc {
@@ -22,8 +28,41 @@ where
 */
 FBC_EXPORTS int getRotationMatrix2D(Point2f center, double angle, double scale, Mat_<double, 1>& dst);
 
+// checks whether the rotation matrix m (scale 1) maps every pixel of a dsize destination onto a source pixel: a multiple
+// of 90 degrees with a whole-pixel translation, all the destination pixels inside the ssize source; then the warp is
+// the copy (rotateCode -1) or the rotation by rotateCode of the source rectangle roi
+static inline bool rotationMapsPixels(const double* m, Size ssize, Size dsize, Rect& roi, int& rotateCode)
+{
+	// the warp rounds the coordinates to 1 / 1024 pixel, smaller errors of the matrix don't change its result
+	const double eps = 1e-9, teps = 1e-6;
+	double a = floor(m[0] + 0.5), b = floor(m[1] + 0.5);
+	double tx = floor(m[2] + 0.5), ty = floor(m[5] + 0.5);
+	if (fabs(m[0] - a) > eps || fabs(m[1] - b) > eps || fabs(m[3] + b) > eps || fabs(m[4] - a) > eps ||
+		fabs(m[2] - tx) > teps || fabs(m[5] - ty) > teps || fabs(a) + fabs(b) != 1)
+		return false;
+
+	// the source pixels of the destination corners (0, 0) and (dsize.width - 1, dsize.height - 1)
+	double x1 = dsize.width - 1, y1 = dsize.height - 1;
+	double sx0 = -a * tx + b * ty, sy0 = -b * tx - a * ty;
+	double sx1 = a * (x1 - tx) - b * (y1 - ty), sy1 = b * (x1 - tx) + a * (y1 - ty);
+	double xmin = std::min(sx0, sx1), ymin = std::min(sy0, sy1), xmax = std::max(sx0, sx1), ymax = std::max(sy0, sy1);
+	if (xmin < 0 || ymin < 0 || xmax > ssize.width - 1 || ymax > ssize.height - 1)
+		return false;
+
+	roi = Rect((int)xmin, (int)ymin, (int)(xmax - xmin) + 1, (int)(ymax - ymin) + 1);
+	rotateCode = a == 1 ? -1 : a == -1 ? ROTATE_180 : b == 1 ? ROTATE_90_COUNTERCLOCKWISE : ROTATE_90_CLOCKWISE;
+	return true;
+}
+
+template<typename _Tp, int chs>
+int rotate(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int rotateCode);
+
 // Applies an rotate to an image
 // The function cannot operate in - place
+// when the angle is a multiple of 90 degrees and every destination pixel falls on a source pixel (a whole-pixel
+// translation, e.g. the center ((cols - 1) / 2, (rows - 1) / 2) of a square image), the result of the warp is an exact
+// rotation of a source rectangle and it is computed by rotate(src, dst, rotateCode) or copyTo without interpolation
+// (uchar: all the interpolations, float: INTER_NEAREST/INTER_LINEAR, whose warp gives the same pixels)
 // support type: uchar/float
 template<typename _Tp, int chs>
 int rotate(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Point2f center, double angle,
@@ -51,11 +90,76 @@ int rotate(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Point2f center, doubl
 		}
 	}
 
+	// the float tables of INTER_CUBIC/INTER_LANCZOS4 are not exactly 1 at the pixel and 0 around it
+	int interpolation = flags & INTER_MAX;
+	bool exact = typeid(uchar).name() == typeid(_Tp).name() || (interpolation != INTER_CUBIC && interpolation != INTER_LANCZOS4);
+	Rect roi;
+	int rotateCode;
+	if (exact && rotationMapsPixels((const double*)rot_matrix.data, src.size(), dst.size(), roi, rotateCode)) {
+		if (rotateCode < 0) {
+			src.copyTo(dst, roi);
+		} else {
+			Mat_<_Tp, chs> src_ = src, part;
+			src_.getROI(part, roi);
+			rotate(part, dst, rotateCode);
+		}
+		return 0;
+	}
+
 	warpAffine(src, dst, rot_matrix, flags, borderMode, borderValue);
 
 	return 0;
 }
 
+// Rotates an array by 90 degrees clockwise (ROTATE_90_CLOCKWISE), 180 degrees (ROTATE_180)
+// or 270 degrees clockwise (ROTATE_90_COUNTERCLOCKWISE), see RotateFlags
+// every rotation is a single pass over the image: the 90 degrees rotations are tiled transposes with a reversed
+// row order (see hal::transpose2D), the 180 degrees rotation reverses the rows (see hal::flipRows)
+// dst is created when it is empty; when it is src, a new dst is allocated
+// support type: uchar/float, multi-channels
+template<typename _Tp, int chs>
+int rotate(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, int rotateCode)
+{
+	FBC_Assert(typeid(float).name() == typeid(_Tp).name() || typeid(uchar).name() == typeid(_Tp).name());
+	FBC_Assert(src.data != NULL && src.rows > 0 && src.cols > 0);
+	FBC_Assert(rotateCode == ROTATE_90_CLOCKWISE || rotateCode == ROTATE_180 || rotateCode == ROTATE_90_COUNTERCLOCKWISE);
+
+	// holds the source data when dst is reallocated below
+	Mat_<_Tp, chs> src_ = src;
+	Size dsize = rotateCode == ROTATE_180 ? src.size() : Size(src.rows, src.cols);
+	if (dst.empty() || src.data == dst.data) {
+		dst = Mat_<_Tp, chs>(dsize.height, dsize.width);
+	} else {
+		FBC_Assert(dst.rows == dsize.height && dst.cols == dsize.width);
+	}
+
+	const int esz = (int)(sizeof(_Tp) * chs);
+	const int tile = 32;
+	ptrdiff_t sstep = (ptrdiff_t)src_.step, dstep = (ptrdiff_t)dst.step;
+	double nstripes = (double)src_.rows * src_.cols * esz / (1 << 16);
+
+	if (rotateCode == ROTATE_180) {
+		// dst row y is the reversed source row rows - 1 - y
+		parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+			hal::flipRows(src_.ptr(src_.rows - 1 - range.start), -sstep, dst.ptr(range.start), dstep,
+				dst.cols, range.end - range.start, esz);
+		}, nstripes);
+	} else {
+		// 90 clockwise: dst(i, j) = src(rows - 1 - j, i), the transpose of src read from the last row up
+		// 90 counterclockwise: dst(i, j) = src(j, cols - 1 - i), the transpose of src written from the last row up
+		bool cw = rotateCode == ROTATE_90_CLOCKWISE;
+		parallel_for_(Range(0, (src_.cols + tile - 1) / tile), [&](const Range& range) {
+			int x0 = range.start * tile, x1 = std::min(range.end * tile, src_.cols);
+			if (cw)
+				hal::transpose2D(src_.ptr(src_.rows - 1) + (size_t)x0 * esz, -sstep, dst.ptr(x0), dstep, x1 - x0, src_.rows, esz);
+			else
+				hal::transpose2D(src_.ptr() + (size_t)x0 * esz, sstep, dst.ptr(dst.rows - 1 - x0), -dstep, x1 - x0, src_.rows, esz);
+		}, nstripes);
+	}
+
+	return 0;
+}
+
 } // namespace fbc
 
 #endif // FBC_CV_ROTATE_HPP_
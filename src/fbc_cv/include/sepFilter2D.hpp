@@ -0,0 +1,56 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifndef FBC_CV_SEPFILTER2D_HPP_
+#define FBC_CV_SEPFILTER2D_HPP_
+
+/* reference: include/opencv2/imgproc.hpp
+              modules/imgproc/src/filter.cpp
+*/
+
+#include <typeinfo>
+#include "core/mat.hpp"
+#include "imgproc.hpp"
+#include "filterengine.hpp"
+#include "filter.hpp"
+
+namespace fbc {
+
+// Applies a separable linear filter to an image
+// The function applies a separable linear filter to the image. That is, first, every row of src is
+// filtered with the 1D kernel kernelX. Then, every column of the result is filtered with the 1D
+// kernel kernelY. The final result shifted by delta is stored in dst.
+// 8-bit images filtered by smooth symmetrical kernels use fixed-point arithmetic (8 fractional bits per kernel),
+// the image is processed in parallel horizontal stripes
+// support type: uchar/float -> uchar/float, multi-channels
+template<typename _Tp1, typename _Tp2, int chs>
+int sepFilter2D(const Mat_<_Tp1, chs>& src, Mat_<_Tp2, chs>& dst, const Mat_<float, 1>& kernelX, const Mat_<float, 1>& kernelY,
+	Point anchor = Point(-1, -1), double delta = 0, int borderType = BORDER_DEFAULT)
+{
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp1).name() || typeid(float).name() == typeid(_Tp1).name()); // uchar || float
+	FBC_Assert(typeid(uchar).name() == typeid(_Tp2).name() || typeid(float).name() == typeid(_Tp2).name()); // uchar || float
+	FBC_Assert((kernelX.rows == 1 || kernelX.cols == 1) && (kernelY.rows == 1 || kernelY.cols == 1));
+	if (dst.empty()) {
+		dst = Mat_<_Tp2, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	bool isolated = (borderType & BORDER_ISOLATED) != 0;
+	borderType &= ~BORDER_ISOLATED;
+	int kheight = kernelY.rows + kernelY.cols - 1;
+
+	if (isFixedPointSepFilter<_Tp1, _Tp2>(kernelX, kernelY, anchor)) {
+		applyFilterStripes(src, dst, kheight, isolated, [&]() {
+			return createSeparableLinearFilter<_Tp1, _Tp2, int, chs>(kernelX, kernelY, anchor, delta, borderType); });
+	} else {
+		applyFilterStripes(src, dst, kheight, isolated, [&]() {
+			return createSeparableLinearFilter<_Tp1, _Tp2, float, chs>(kernelX, kernelY, anchor, delta, borderType); });
+	}
+
+	return 0;
+}
+
+} // namespace fbc
+
+#endif // FBC_CV_SEPFILTER2D_HPP_
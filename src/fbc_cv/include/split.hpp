@@ -11,6 +11,8 @@
 
 #include <vector>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 
 #ifndef __cplusplus
 	#error split.hpp header must be compiled as C++
@@ -18,36 +20,94 @@
 
 namespace fbc {
 
+template<typename _Tp, int chs> static void splitPlanes(const Mat_<_Tp, chs>& src, _Tp* const* dst, const size_t* dststep);
+
 // split a multi-channel array into separate single-channel arrays
+// the planes are created when they are empty, they may be submatrices
 template<typename _Tp, int chs1, int chs2>
 int split(const Mat_<_Tp, chs1>& src, std::vector<Mat_<_Tp, chs2>>& dst)
 {
 	FBC_Assert(src.data != NULL);
 	FBC_Assert((dst.size() == chs1) && (chs2 == 1));
-	for (int i = 0; i < dst.size(); i++) {
-		FBC_Assert((dst[i].data != NULL) && (dst[i].rows == src.rows) && (dst[i].cols == src.cols));
+
+	_Tp* planes[chs1];
+	size_t steps[chs1];
+	for (int i = 0; i < chs1; i++) {
+		if (dst[i].empty())
+			dst[i].create(src.rows, src.cols);
+		FBC_Assert((dst[i].rows == src.rows) && (dst[i].cols == src.cols));
+		planes[i] = (_Tp*)dst[i].ptr();
+		steps[i] = dst[i].step;
 	}
 
-	int cn = src.channels;
-	if (cn == 1) {
-		memcpy(dst[0].data, src.data, src.step * src.rows);
-		return 0;
+	splitPlanes(src, planes, steps);
+
+	return 0;
+}
+
+// split a multi-channel array into the chs single-channel arrays dst[0], ..., dst[chs - 1]
+template<typename _Tp, int chs>
+int split(const Mat_<_Tp, chs>& src, Mat_<_Tp, 1>* dst)
+{
+	FBC_Assert(src.data != NULL && dst != NULL);
+
+	_Tp* planes[chs];
+	size_t steps[chs];
+	for (int i = 0; i < chs; i++) {
+		dst[i].create(src.rows, src.cols);
+		planes[i] = (_Tp*)dst[i].ptr();
+		steps[i] = dst[i].step;
 	}
 
-	_Tp* pSrc = (_Tp*)src.data;
-	int len = src.rows * src.cols;
+	splitPlanes(src, planes, steps);
 
-	for (int i = 0; i < cn; i++) {
-		_Tp* pDst = (_Tp*)dst[i].data;
+	return 0;
+}
 
-		for (int j = 0; j < len; j++) {
-			pDst[j] = pSrc[j * cn + i];
-		}
+// split a multi-channel array into preallocated planes: row y of channel i is written at (uchar*)dst[i] + y * dststep
+// e.g. into the CHW input blob of a network:
+//	float* planes[3] = { blob, blob + rows * cols, blob + 2 * rows * cols };
+//	split(src, planes, cols * sizeof(float));
+template<typename _Tp, int chs>
+int split(const Mat_<_Tp, chs>& src, _Tp* const* dst, size_t dststep)
+{
+	FBC_Assert(src.data != NULL && dst != NULL);
+
+	size_t steps[chs];
+	for (int i = 0; i < chs; i++) {
+		FBC_Assert(dst[i] != NULL);
+		steps[i] = dststep;
 	}
 
+	splitPlanes(src, dst, steps);
+
 	return 0;
 }
 
+// de-interleaves the rows of src in one pass (see hal::split8u), the rows are processed in parallel
+template<typename _Tp, int chs>
+static void splitPlanes(const Mat_<_Tp, chs>& src, _Tp* const* dst, const size_t* dststep)
+{
+	FBC_Assert(sizeof(_Tp) == 1 || sizeof(_Tp) == 2 || sizeof(_Tp) == 4 || sizeof(_Tp) == 8);
+
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		_Tp* planes[chs];
+
+		for (int y = range.start; y < range.end; y++) {
+			for (int i = 0; i < chs; i++)
+				planes[i] = (_Tp*)((uchar*)dst[i] + y * dststep[i]);
+
+			const _Tp* row = (const _Tp*)src.ptr(y);
+			switch (sizeof(_Tp)) {
+				case 1: hal::split8u((const uchar*)row, (uchar**)planes, src.cols, chs); break;
+				case 2: hal::split16u((const ushort*)row, (ushort**)planes, src.cols, chs); break;
+				case 4: hal::split32s((const int*)row, (int**)planes, src.cols, chs); break;
+				default: hal::split64s((const int64*)row, (int64**)planes, src.cols, chs); break;
+			}
+		}
+	}, src.total() * chs / (double)(1 << 16));
+}
+
 } // namespace fbc
 
 #endif // FBC_CV_SPLIT_HPP_
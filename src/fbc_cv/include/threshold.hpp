@@ -8,20 +8,28 @@
               modules/imgproc/src/thresh.cpp
 */
 
+#include <string.h>
 #include <typeinfo>
+#include <vector>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 #include "imgproc.hpp"
 
 namespace fbc {
 
-template<typename _Tp, int chs> static double getThreshVal_Otsu_8u(const Mat_<_Tp, chs>& src);
-template<typename _Tp, int chs> static double getThreshVal_Triangle_8u(const Mat_<_Tp, chs>& src);
+static inline double getThreshVal_Otsu_8u(const int* h, size_t total);
+static inline double getThreshVal_Triangle_8u(const int* h);
+template<typename _Tp, int chs> static void calcTileHist_8u(const Mat_<_Tp, chs>& src, Size tile, int* hist);
+template<typename _Tp, int chs> static void calcHist_8u(const Mat_<_Tp, chs>& src, int* hist);
 template<typename _Tp, int chs> static void thresh_8u(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, uchar thresh, uchar maxval, int type);
 template<typename _Tp, int chs> static void thresh_32f(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, float thresh, float maxval, int type);
 
 // applies fixed-level thresholding to a single-channel array
-// the Otsu's and Triangle methods are implemented only for 8-bit images
+// the Otsu's and Triangle methods are implemented only for 8-bit single-channel images, their histogram is reduced
+// from the histograms of row stripes computed in parallel; the thresholding pass is parallel over the rows
 // support type: uchar/float, single-channel
+// returns the threshold value (the computed one with THRESH_OTSU or THRESH_TRIANGLE)
 template<typename _Tp, int chs>
 double threshold(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, double thresh, double maxval, int type)
 {
@@ -36,12 +44,11 @@ double threshold(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, double thresh,
 	type &= THRESH_MASK;
 
 	FBC_Assert(automatic_thresh != (THRESH_OTSU | THRESH_TRIANGLE));
-	if (automatic_thresh == THRESH_OTSU) {
-		FBC_Assert(sizeof(_Tp) == 1);
-		thresh = getThreshVal_Otsu_8u(src);
-	} else if (automatic_thresh == THRESH_TRIANGLE) {
-		FBC_Assert(sizeof(_Tp) == 1);
-		thresh = getThreshVal_Triangle_8u(src);
+	if (automatic_thresh == THRESH_OTSU || automatic_thresh == THRESH_TRIANGLE) {
+		FBC_Assert(sizeof(_Tp) == 1 && chs == 1);
+		int h[256];
+		calcHist_8u(src, h);
+		thresh = automatic_thresh == THRESH_OTSU ? getThreshVal_Otsu_8u(h, src.total()) : getThreshVal_Triangle_8u(h);
 	}
 
 	if (sizeof(_Tp) == 1) {
@@ -78,30 +85,223 @@ double threshold(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, double thresh,
 		thresh_32f(src, dst, (float)thresh, (float)maxval, type);
 	}
 
-	return 0;
+	return thresh;
 }
 
+// applies fixed-level thresholding to the images of a batch, the sources must have the same size
+// dst gets one image per source image (see createBatch()), the Otsu's and Triangle thresholds are computed per image
+// returns the threshold value of every image
 template<typename _Tp, int chs>
-static double getThreshVal_Otsu_8u(const Mat_<_Tp, chs>& _src)
+std::vector<double> threshold(const std::vector<Mat_<_Tp, chs>>& src, std::vector<Mat_<_Tp, chs>>& dst, double thresh, double maxval, int type)
 {
-	Size size = _src.size();
-	const int N = 256;
-	int i, j, h[N] = { 0 };
-
-	for (i = 0; i < size.height; i++) {
-		const uchar* src = _src.ptr(i);
-		j = 0;
-		for (; j <= size.width - 4; j += 4) {
-			int v0 = src[j], v1 = src[j + 1];
-			h[v0]++; h[v1]++;
-			v0 = src[j + 2]; v1 = src[j + 3];
-			h[v0]++; h[v1]++;
+	int n = (int)src.size();
+	std::vector<double> thresholds(n, thresh);
+	if (n == 0) {
+		dst.clear();
+		return thresholds;
+	}
+
+	for (int i = 1; i < n; i++)
+		FBC_Assert(src[i].size() == src[0].size());
+	createBatch(dst, n, src[0].size());
+
+	parallel_for_batch_(n, [&](int i) { thresholds[i] = threshold(src[i], dst[i], thresh, maxval, type); });
+
+	return thresholds;
+}
+
+// the centers of the tiles of length tile covering [0, len), and for every position i of [0, len) the tiles ofs[2*i],
+// ofs[2*i + 1] of the nearest centers around it and the weight w[i] of the second one (8 fractional bits)
+static inline void localThresholdWeights(int len, int tile, int* ofs, int* w)
+{
+	int tiles = (len + tile - 1) / tile;
+	std::vector<double> center(tiles);
+	for (int t = 0; t < tiles; t++)
+		center[t] = t * tile + std::min(tile, len - t * tile) * 0.5;
+
+	for (int i = 0, t = 0; i < len; i++) {
+		double p = i + 0.5;
+		while (t + 1 < tiles && center[t + 1] <= p)
+			t++;
+
+		if (p <= center[t] || t == tiles - 1) {
+			ofs[i * 2] = ofs[i * 2 + 1] = t;
+			w[i] = 0;
+		} else {
+			ofs[i * 2] = t;
+			ofs[i * 2 + 1] = t + 1;
+			w[i] = fbcRound((p - center[t]) / (center[t + 1] - center[t]) * 256);
+		}
+	}
+}
+
+static inline uchar thresholdValue_8u(uchar v, uchar thresh, uchar maxval, int type)
+{
+	switch (type) {
+	case THRESH_BINARY: return v > thresh ? maxval : 0;
+	case THRESH_BINARY_INV: return v > thresh ? 0 : maxval;
+	case THRESH_TRUNC: return std::min(v, thresh);
+	case THRESH_TOZERO: return v > thresh ? v : 0;
+	default: return v > thresh ? 0 : v; // THRESH_TOZERO_INV
+	}
+}
+
+// applies locally adaptive thresholding to a 8-bit single-channel image, e.g. the binarization of scanned documents
+// with uneven illumination: the Otsu's or Triangle threshold (type combines a THRESH_* type with THRESH_OTSU or
+// THRESH_TRIANGLE) is computed for every tile of tileSize from the tile histograms, which are built in parallel;
+// the tiles whose range of values (max - min) is less than minContrast get the threshold of the whole image (computed
+// from the sum of the tile histograms), the threshold of a pixel is the bilinear interpolation of the thresholds of
+// the tiles whose centers surround it, all thresholds are clamped to [0, 255]
+// returns the threshold of the whole image
+template<typename _Tp, int chs>
+double localThreshold(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst, Size tileSize, double maxval, int type, int minContrast = 0)
+{
+	FBC_Assert(sizeof(_Tp) == 1 && chs == 1);
+	FBC_Assert(tileSize.width > 0 && tileSize.height > 0);
+	if (dst.empty()) {
+		dst = Mat_<_Tp, chs>(src.rows, src.cols);
+	} else {
+		FBC_Assert(src.rows == dst.rows && src.cols == dst.cols);
+	}
+
+	int automatic_thresh = (type & ~THRESH_MASK);
+	type &= THRESH_MASK;
+	FBC_Assert(automatic_thresh == THRESH_OTSU || automatic_thresh == THRESH_TRIANGLE);
+	FBC_Assert(type <= THRESH_TOZERO_INV);
+
+	int tilesX = (src.cols + tileSize.width - 1) / tileSize.width;
+	int tilesY = (src.rows + tileSize.height - 1) / tileSize.height;
+	std::vector<int> hist((size_t)tilesX * tilesY * 256);
+	calcTileHist_8u(src, tileSize, hist.data());
+
+	int h[256] = { 0 };
+	for (size_t i = 0; i < hist.size(); i += 256) {
+		for (int k = 0; k < 256; k++)
+			h[k] += hist[i + k];
+	}
+	double thresh = automatic_thresh == THRESH_OTSU ? getThreshVal_Otsu_8u(h, src.total()) : getThreshVal_Triangle_8u(h);
+	int gthresh = std::min(std::max(fbcFloor(thresh), 0), 255);
+
+	std::vector<int> tthresh(tilesX * tilesY);
+	for (int ty = 0; ty < tilesY; ty++) {
+		for (int tx = 0; tx < tilesX; tx++) {
+			const int* th = &hist[(size_t)(ty * tilesX + tx) * 256];
+			int lo = 0, hi = 255;
+			while (th[lo] == 0) lo++;
+			while (th[hi] == 0) hi--;
+
+			int t = gthresh;
+			if (hi - lo >= minContrast) {
+				size_t area = (size_t)std::min(tileSize.width, src.cols - tx * tileSize.width) * std::min(tileSize.height, src.rows - ty * tileSize.height);
+				double v = automatic_thresh == THRESH_OTSU ? getThreshVal_Otsu_8u(th, area) : getThreshVal_Triangle_8u(th);
+				t = std::min(std::max(fbcFloor(v), 0), 255);
+			}
+			tthresh[ty * tilesX + tx] = t;
+		}
+	}
+
+	std::vector<int> xofs(src.cols * 2), xw(src.cols), yofs(src.rows * 2), yw(src.rows);
+	localThresholdWeights(src.cols, tileSize.width, xofs.data(), xw.data());
+	localThresholdWeights(src.rows, tileSize.height, yofs.data(), yw.data());
+	uchar imaxval = saturate_cast<uchar>(fbcRound(maxval));
+
+	// the thresholds of every row of tiles interpolated along the rows (8 fractional bits), the rows of src
+	// interpolate them along the columns
+	std::vector<int> rowT((size_t)tilesY * src.cols);
+	for (int ty = 0; ty < tilesY; ty++) {
+		const int* t = &tthresh[ty * tilesX];
+		int* r = &rowT[(size_t)ty * src.cols];
+		for (int x = 0; x < src.cols; x++)
+			r[x] = t[xofs[x * 2]] * (256 - xw[x]) + t[xofs[x * 2 + 1]] * xw[x];
+	}
+
+	parallel_for_(Range(0, src.rows), [&](const Range& range) {
+		int width = src.cols;
+		std::vector<uchar> _tbuf(width);
+		uchar* tbuf = _tbuf.data();
+
+		for (int y = range.start; y < range.end; y++) {
+			const int* r0 = &rowT[(size_t)yofs[y * 2] * width];
+			const int* r1 = &rowT[(size_t)yofs[y * 2 + 1] * width];
+			int w0 = 256 - yw[y], w1 = yw[y];
+			for (int x = 0; x < width; x++)
+				tbuf[x] = (uchar)((r0[x] * w0 + r1[x] * w1 + (1 << 15)) >> 16);
+
+			const uchar* s = (const uchar*)src.ptr(y);
+			uchar* d = (uchar*)dst.ptr(y);
+			int x = hal::thresholdMap8u(s, tbuf, d, width, imaxval, type);
+			for (; x < width; x++)
+				d[x] = thresholdValue_8u(s[x], tbuf[x], imaxval, type);
 		}
-		for (; j < size.width; j++)
-			h[src[j]]++;
+	}, src.total() / (double)(1 << 16));
+
+	return gthresh;
+}
+
+// the histogram of the elements of a tile (width elements of height rows), four partial histograms break the
+// dependency chains of runs of equal values
+static inline void histTile_8u(const uchar* src, size_t step, int width, int height, int* hist)
+{
+	int h[4][256] = { { 0 } };
+
+	for (int i = 0; i < height; i++, src += step) {
+		int j = 0;
+		for (; j <= width - 4; j += 4) {
+			h[0][src[j]]++; h[1][src[j + 1]]++;
+			h[2][src[j + 2]]++; h[3][src[j + 3]]++;
+		}
+		for (; j < width; j++)
+			h[0][src[j]]++;
 	}
 
-	double mu = 0, scale = 1. / (size.width*size.height);
+	for (int k = 0; k < 256; k++)
+		hist[k] = h[0][k] + h[1][k] + h[2][k] + h[3][k];
+}
+
+// the histograms of the tiles of tile.width x tile.height elements of src (the last tiles of a row or column are
+// smaller), 256 bins per tile, the tiles in row-major order; the rows of tiles are processed in parallel
+template<typename _Tp, int chs>
+static void calcTileHist_8u(const Mat_<_Tp, chs>& src, Size tile, int* hist)
+{
+	int width = src.cols * chs;
+	int tilesX = (width + tile.width - 1) / tile.width;
+	int tilesY = (src.rows + tile.height - 1) / tile.height;
+
+	parallel_for_(Range(0, tilesY), [&](const Range& range) {
+		for (int ty = range.start; ty < range.end; ty++) {
+			int y = ty * tile.height;
+			for (int tx = 0; tx < tilesX; tx++) {
+				int x = tx * tile.width;
+				histTile_8u((const uchar*)src.ptr(y) + x, src.step, std::min(tile.width, width - x),
+					std::min(tile.height, src.rows - y), hist + (size_t)(ty * tilesX + tx) * 256);
+			}
+		}
+	}, tilesY);
+}
+
+// the histogram of src, the sum of the histograms of row stripes of about 64K elements
+template<typename _Tp, int chs>
+static void calcHist_8u(const Mat_<_Tp, chs>& src, int* hist)
+{
+	int width = src.cols * chs;
+	Size tile(std::max(width, 1), std::max((1 << 16) / std::max(width, 1), 1));
+	int tiles = (src.rows + tile.height - 1) / tile.height;
+	std::vector<int> stripes((size_t)tiles * 256);
+	calcTileHist_8u(src, tile, stripes.data());
+
+	memset(hist, 0, 256 * sizeof(int));
+	for (size_t i = 0; i < stripes.size(); i += 256) {
+		for (int k = 0; k < 256; k++)
+			hist[k] += stripes[i + k];
+	}
+}
+
+static inline double getThreshVal_Otsu_8u(const int* h, size_t total)
+{
+	const int N = 256;
+	int i;
+
+	double mu = 0, scale = 1. / total;
 	for (i = 0; i < N; i++)
 		mu += i*(double)h[i];
 
@@ -132,26 +332,11 @@ static double getThreshVal_Otsu_8u(const Mat_<_Tp, chs>& _src)
 	return max_val;
 }
 
-template<typename _Tp, int chs>
-static double getThreshVal_Triangle_8u(const Mat_<_Tp, chs>& _src)
+static inline double getThreshVal_Triangle_8u(const int* _h)
 {
-	Size size = _src.size();
 	const int N = 256;
-	int i, j, h[N] = { 0 };
-
-	for (i = 0; i < size.height; i++) {
-		const uchar* src = _src.ptr(i);
-		j = 0;
-		for (; j <= size.width - 4; j += 4) {
-			int v0 = src[j], v1 = src[j + 1];
-			h[v0]++; h[v1]++;
-			v0 = src[j + 2]; v1 = src[j + 3];
-			h[v0]++; h[v1]++;
-		}
-
-		for (; j < size.width; j++)
-			h[src[j]]++;
-	}
+	int i, j, h[N];
+	memcpy(h, _h, sizeof(h));
 
 	int left_bound = 0, right_bound = 0, max_ind = 0, max = 0;
 	int temp;
@@ -217,7 +402,7 @@ static double getThreshVal_Triangle_8u(const Mat_<_Tp, chs>& _src)
 template<typename _Tp, int chs>
 static void thresh_8u(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, uchar thresh, uchar maxval, int type)
 {
-	int i, j, j_scalar = 0;
+	int i;
 	uchar tab[256];
 	Size roi = _src.size();
 	roi.width *= _src.channels;
@@ -257,11 +442,11 @@ static void thresh_8u(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, uchar th
 		FBC_Error("Unknown threshold type");
 	}
 
-	if (j_scalar < roi.width) {
-		for (i = 0; i < roi.height; i++) {
+	parallel_for_(Range(0, roi.height), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++) {
 			const uchar* src = _src.ptr(i);
 			uchar* dst = _dst.ptr(i);
-			j = j_scalar;
+			int j = hal::threshold8u(src, dst, roi.width, thresh, maxval, type);
 
 			for (; j <= roi.width - 4; j += 4) {
 				uchar t0 = tab[src[j]];
@@ -280,62 +465,56 @@ static void thresh_8u(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, uchar th
 			for (; j < roi.width; j++)
 				dst[j] = tab[src[j]];
 		}
-	}
+	}, (double)roi.width * roi.height / (1 << 16));
 }
 
 template<typename _Tp, int chs>
 static void thresh_32f(const Mat_<_Tp, chs>& _src, Mat_<_Tp, chs>& _dst, float thresh, float maxval, int type)
 {
-	int i, j;
 	Size roi = _src.size();
 	roi.width *= _src.channels;
-	const float* src = (const float*)_src.ptr();
-	float* dst = (float*)_dst.ptr();
-	size_t src_step = _src.step / sizeof(src[0]);
-	size_t dst_step = _dst.step / sizeof(dst[0]);
-
-	switch (type) {
-	case THRESH_BINARY:
-		for (i = 0; i < roi.height; i++, src += src_step, dst += dst_step) {
-			for (j = 0; j < roi.width; j++)
-				dst[j] = src[j] > thresh ? maxval : 0;
-		}
-		break;
-
-	case THRESH_BINARY_INV:
-		for (i = 0; i < roi.height; i++, src += src_step, dst += dst_step) {
-			for (j = 0; j < roi.width; j++)
-				dst[j] = src[j] <= thresh ? maxval : 0;
-		}
-		break;
-
-	case THRESH_TRUNC:
-		for (i = 0; i < roi.height; i++, src += src_step, dst += dst_step) {
-			for (j = 0; j < roi.width; j++)
-				dst[j] = std::min(src[j], thresh);
-		}
-		break;
-
-	case THRESH_TOZERO:
-		for (i = 0; i < roi.height; i++, src += src_step, dst += dst_step) {
-			for (j = 0; j < roi.width; j++) {
-				float v = src[j];
-				dst[j] = v > thresh ? v : 0;
-			}
-		}
-		break;
+	if (type < THRESH_BINARY || type > THRESH_TOZERO_INV) {
+		FBC_Error("BadArg");
+	}
 
-	case THRESH_TOZERO_INV:
-		for (i = 0; i < roi.height; i++, src += src_step, dst += dst_step) {
-			for (j = 0; j < roi.width; j++) {
-				float v = src[j];
-				dst[j] = v <= thresh ? v : 0;
+	parallel_for_(Range(0, roi.height), [&](const Range& range) {
+		for (int i = range.start; i < range.end; i++) {
+			const float* src = (const float*)_src.ptr(i);
+			float* dst = (float*)_dst.ptr(i);
+			int j = hal::threshold32f(src, dst, roi.width, thresh, maxval, type);
+
+			switch (type) {
+			case THRESH_BINARY:
+				for (; j < roi.width; j++)
+					dst[j] = src[j] > thresh ? maxval : 0;
+				break;
+
+			case THRESH_BINARY_INV:
+				for (; j < roi.width; j++)
+					dst[j] = src[j] <= thresh ? maxval : 0;
+				break;
+
+			case THRESH_TRUNC:
+				for (; j < roi.width; j++)
+					dst[j] = std::min(src[j], thresh);
+				break;
+
+			case THRESH_TOZERO:
+				for (; j < roi.width; j++) {
+					float v = src[j];
+					dst[j] = v > thresh ? v : 0;
+				}
+				break;
+
+			default: // THRESH_TOZERO_INV
+				for (; j < roi.width; j++) {
+					float v = src[j];
+					dst[j] = v <= thresh ? v : 0;
+				}
+				break;
 			}
 		}
-		break;
-	default:
-		FBC_Error("BadArg");
-	}
+	}, (double)roi.width * roi.height / (1 << 16));
 }
 
 } // namespace fbc
@@ -8,18 +8,21 @@
               modules/core/src/matrix.cpp
 */
 
-#include <typeinfo>
+#include <vector>
+#include <algorithm>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 
 namespace fbc {
 
 // transposes the matrix
 // \f[\texttt{dst} (i,j) =  \texttt{src} (j,i)\f]
-// support type: uchar/float, multi-channels
+// the matrix is transposed in cache-sized tiles (see hal::transpose2D), in place when dst is src (square matrices only)
+// support type: all element types (the elements are moved as esz-byte blocks), multi-channels
 template <typename _Tp, int chs>
 int transpose(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 {
-	FBC_Assert(typeid(uchar).name() == typeid(_Tp).name() || typeid(float).name() == typeid(_Tp).name()); // uchar || float
 	if (dst.empty()) {
 		dst = Mat_<_Tp, chs>(src.cols, src.rows);
 	} else {
@@ -38,47 +41,53 @@ int transpose(const Mat_<_Tp, chs>& src, Mat_<_Tp, chs>& dst)
 		return 0;
 	}
 
+	const int esz = (int)(sizeof(_Tp) * chs);
+	const int tile = 32;
+	double nstripes = (double)src.rows * src.cols * esz / (1 << 16);
+
 	if (dst.data == src.data) {
 		FBC_Assert(dst.cols == dst.rows);
 		int n = dst.rows;
-		int  step = dst.step;
 		uchar* data = dst.ptr();
+		size_t step = dst.step;
 
-		for (int i = 0; i < n; i++) {
-			_Tp* row = (_Tp*)(data + step*i);
-			int i_ = i * chs;
-
-			for (int j = i + 1; j < n; j++) {
-				_Tp* data1 = (_Tp*)(data + step * j);
-				int j_ = j * chs;
-
-				for (int ch = 0; ch < chs; ch++) {
-					std::swap(row[j_ + ch], data1[i_ + ch]);
-				}
-			}
-		}
+		// bands of tile rows, each one swaps its tiles right of the diagonal with the transposed tiles below it
+		parallel_for_(Range(0, (n + tile - 1) / tile), [&](const Range& range) {
+			hal::transposeInplace(data, step, n, esz, range.start * tile, std::min(range.end * tile, n));
+		}, nstripes);
 	} else {
 		const uchar* src_ = src.ptr();
 		size_t sstep = src.step;
 		uchar* dst_ = dst.ptr();
 		size_t dstep = dst.step;
-		int m = src.cols, n = src.rows;
 
-		for (int i = 0; i < n; i++) {
-			const _Tp* s = (const _Tp*)(src_ + sstep*i);
-			int i_ = i * chs;
+		// bands of destination rows, i.e. of source columns
+		parallel_for_(Range(0, (src.cols + tile - 1) / tile), [&](const Range& range) {
+			int x0 = range.start * tile, x1 = std::min(range.end * tile, src.cols);
+			hal::transpose2D(src_ + (size_t)x0 * esz, sstep, dst_ + x0 * dstep, dstep, x1 - x0, src.rows, esz);
+		}, nstripes);
+	}
 
-			for (int j = 0; j < m; j++) {
-				_Tp* d = (_Tp*)(dst_ + dstep*j);
-				int j_ = j * chs;
+	return 0;
+}
 
-				for (int ch = 0; ch < chs; ch++) {
-					d[i_ + ch] = s[j_ + ch];
-				}
-			}
-		}
+// transposes the images of a batch, the sources must have the same size
+// dst gets one image per source image, see createBatch()
+template <typename _Tp, int chs>
+int transpose(const std::vector<Mat_<_Tp, chs>>& src, std::vector<Mat_<_Tp, chs>>& dst)
+{
+	int n = (int)src.size();
+	if (n == 0) {
+		dst.clear();
+		return 0;
 	}
 
+	for (int i = 1; i < n; i++)
+		FBC_Assert(src[i].size() == src[0].size() && !src[i].empty());
+	createBatch(dst, n, Size(src[0].rows, src[0].cols));
+
+	parallel_for_batch_(n, [&](int i) { transpose(src[i], dst[i]); });
+
 	return 0;
 }
 
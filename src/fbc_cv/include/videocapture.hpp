@@ -22,6 +22,26 @@ typedef enum video_codec_type_t {
 	VIDEO_CODEC_TYPE_RAWVIDEO
 } video_codec_type_t;
 
+// the policies of the asynchronous capture when the ring of frames is full
+enum {
+	CAP_ASYNC_LATEST = 0, // the oldest unread frame is overwritten, read() returns the freshest frame
+	CAP_ASYNC_NO_DROP = 1 // the grab thread waits for a free buffer, read() returns every frame in order
+};
+
+typedef struct frame_info {
+	uint64 sequence; // number of the frame since open() or startAsync(), the dropped frames keep their numbers
+	int64 timestamp; // steady clock time in nanoseconds when the frame was grabbed
+} frame_info;
+
+typedef struct capture_stats {
+	uint64 grabbed; // frames grabbed by the grab thread
+	uint64 delivered; // frames returned by read()
+	uint64 dropped; // frames overwritten or skipped in the ring before they were read
+	uint64 device_dropped; // frames lost by the device, from the gaps of its sequence numbers (V4L2)
+} capture_stats;
+
+class AsyncGrabber;
+
 class FBC_EXPORTS VideoCapture {
 public:
 	VideoCapture();
@@ -39,6 +59,24 @@ public:
 	virtual VideoCapture& operator >> (Mat_<unsigned char, 3>& image);
 	virtual bool read(Mat_<unsigned char, 3>& image);
 
+	// starts a thread which grabs and retrieves the frames continuously into a ring of bufferCount preallocated
+	// frames (at least 2); read() then copies a frame out of the ring instead of waiting for the device, it waits
+	// only when no unread frame is left. grab() and retrieve() fail while the thread runs
+	virtual bool startAsync(int bufferCount = 3, int policy = CAP_ASYNC_LATEST);
+	virtual void stopAsync();
+	virtual bool isAsync() const;
+	// the next frame of the ring and its sequence number and timestamp (also in synchronous mode);
+	// timeout: milliseconds to wait for a frame, -1 waits until a frame arrives or the grab thread fails
+	virtual bool read(Mat_<unsigned char, 3>& image, frame_info& info, int timeout = -1);
+	virtual capture_stats getAsyncStats() const;
+
+	// the grabbed frame in the native format of the device without a copy (V4L2): the view shares the mapped buffer
+	// of the driver and is valid until the next grab(), rows: the rows of all the planes, cols: the bytes per row;
+	// fourcc: CV_FOURCC of the pixel format, the compressed formats (MJPG, H264) come as one row of bytesused bytes
+	virtual bool retrieveView(Mat_<unsigned char, 1>& view, int* fourcc = nullptr);
+	// the grabbed frame as a view on the mapped buffer when the device delivers contiguous BGR24
+	virtual bool retrieveView(Mat_<unsigned char, 3>& view);
+
 	virtual bool set(int propId, double value);
 	virtual double get(int propId);
 
@@ -48,9 +86,11 @@ public:
 
 protected:
 	Ptr<CvCapture> cap;
+	Ptr<AsyncGrabber> async;
 
 private:
 	int device_id;
+	uint64 sequence; // the next frame number of the synchronous read(image, info)
 };
 
 bool FBC_EXPORTS get_camera_names(std::map<int, device_info>& infos); // index value, device info
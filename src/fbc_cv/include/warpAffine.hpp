@@ -9,7 +9,10 @@
 */
 
 #include <typeinfo>
+#include <vector>
 #include "core/mat.hpp"
+#include "core/hal.hpp"
+#include "core/parallel.hpp"
 #include "imgproc.hpp"
 #include "remap.hpp"
 
@@ -23,6 +26,49 @@ where
 */
 FBC_EXPORTS int getAffineTransform(const Point2f src1[], const Point2f src2[], Mat_<double, 1>& dst);
 
+// The inverse transform of warpAffine and the fixed-point offsets of the destination columns
+struct WarpAffineTables {
+	enum { AB_BITS = MAX(10, (int)INTER_BITS), AB_SCALE = 1 << AB_BITS };
+
+	template<typename _Tp2, int chs2>
+	WarpAffineTables(const Mat_<_Tp2, chs2>& M_, int flags, int dcols)
+	{
+		FBC_Assert(typeid(double) == typeid(_Tp2) && M_.rows == 2 && M_.cols == 3);
+
+		Mat_<double, 1> matM(2, 3, M);
+		M_.convertTo(matM);
+
+		interpolation = flags & INTER_MAX;
+		if (interpolation == INTER_AREA)
+			interpolation = INTER_LINEAR;
+
+		if (!(flags & WARP_INVERSE_MAP)) {
+			double D = M[0] * M[4] - M[1] * M[3];
+			D = D != 0 ? 1. / D : 0;
+			double A11 = M[4] * D, A22 = M[0] * D;
+			M[0] = A11; M[1] *= -D;
+			M[3] *= -D; M[4] = A22;
+			double b1 = -M[0] * M[2] - M[1] * M[5];
+			double b2 = -M[3] * M[2] - M[4] * M[5];
+			M[2] = b1; M[5] = b2;
+		}
+
+		adelta.resize(dcols);
+		bdelta.resize(dcols);
+		for (int x = 0; x < dcols; x++) {
+			adelta[x] = saturate_cast<int>(M[0] * x*AB_SCALE);
+			bdelta[x] = saturate_cast<int>(M[3] * x*AB_SCALE);
+		}
+	}
+
+	double M[6];
+	int interpolation;
+	std::vector<int> adelta, bdelta;
+};
+
+template<typename _Tp1, int chs1> static void warpAffineInvoker(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst, const WarpAffineTables& tab,
+	int borderMode, const Scalar& borderValue);
+
 // Applies an affine transformation to an image
 // The function cannot operate in - place
 // support type: uchar/float
@@ -36,95 +82,102 @@ int warpAffine(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst, const Mat_<_T
 	FBC_Assert(src.data != NULL && dst.data != NULL && M_.data != NULL);
 	FBC_Assert(src.cols > 0 && src.rows > 0 && dst.cols > 0 && dst.rows > 0);
 	FBC_Assert(src.data != dst.data);
-	FBC_Assert(typeid(double) == typeid(_Tp2) && M_.rows == 2 && M_.cols == 3);
 	FBC_Assert((typeid(uchar).name() == typeid(_Tp1).name()) || (typeid(float).name() == typeid(_Tp1).name())); // uchar/float
 
-	double M[6];
-	Mat_<double, 1> matM(2, 3, M);
-	M_.convertTo(matM);
-
-	int interpolation = flags & INTER_MAX;
-	if (interpolation == INTER_AREA)
-		interpolation = INTER_LINEAR;
-
-	if (!(flags & WARP_INVERSE_MAP)) {
-		double D = M[0] * M[4] - M[1] * M[3];
-		D = D != 0 ? 1. / D : 0;
-		double A11 = M[4] * D, A22 = M[0] * D;
-		M[0] = A11; M[1] *= -D;
-		M[3] *= -D; M[4] = A22;
-		double b1 = -M[0] * M[2] - M[1] * M[5];
-		double b2 = -M[3] * M[2] - M[4] * M[5];
-		M[2] = b1; M[5] = b2;
-	}
+	WarpAffineTables tab(M_, flags, dst.cols);
+	warpAffineInvoker(src, dst, tab, borderMode, borderValue);
 
-	int x;
-	AutoBuffer<int> _abdelta(dst.cols * 2);
-	int* adelta = &_abdelta[0], *bdelta = adelta + dst.cols;
-	const int AB_BITS = MAX(10, (int)INTER_BITS);
-	const int AB_SCALE = 1 << AB_BITS;
+	return 0;
+}
 
-	for (x = 0; x < dst.cols; x++) {
-		adelta[x] = saturate_cast<int>(M[0] * x*AB_SCALE);
-		bdelta[x] = saturate_cast<int>(M[3] * x*AB_SCALE);
-	}
+// Applies the same affine transformation to the images of a batch
+// dst gets one image of size dsize per source image (see createBatch()), the inverse transform and the
+// offsets of the destination columns are computed once for the batch
+template<typename _Tp1, typename _Tp2, int chs1, int chs2>
+int warpAffine(const std::vector<Mat_<_Tp1, chs1>>& src, std::vector<Mat_<_Tp1, chs1>>& dst, const Mat_<_Tp2, chs2>& M_, Size dsize,
+	int flags = INTER_LINEAR, int borderMode = BORDER_CONSTANT, const Scalar& borderValue = Scalar())
+{
+	FBC_Assert(M_.data != NULL && dsize.width > 0 && dsize.height > 0);
+	FBC_Assert((typeid(uchar).name() == typeid(_Tp1).name()) || (typeid(float).name() == typeid(_Tp1).name())); // uchar/float
 
-	Range range(0, dst.rows);
-
-	const int BLOCK_SZ = 64;
-	short XY[BLOCK_SZ*BLOCK_SZ * 2], A[BLOCK_SZ*BLOCK_SZ];;
-	int round_delta = interpolation == INTER_NEAREST ? AB_SCALE / 2 : AB_SCALE / INTER_TAB_SIZE / 2, y, x1, y1;
-
-	int bh0 = std::min(BLOCK_SZ / 2, dst.rows);
-	int bw0 = std::min(BLOCK_SZ*BLOCK_SZ / bh0, dst.cols);
-	bh0 = std::min(BLOCK_SZ*BLOCK_SZ / bw0, dst.rows);
-
-	for (y = range.start; y < range.end; y += bh0) {
-		for (x = 0; x < dst.cols; x += bw0) {
-			int bw = std::min(bw0, dst.cols - x);
-			int bh = std::min(bh0, range.end - y);
-
-			Mat_<short, 2> _XY(bh, bw, XY);
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bw, bh));
-
-			for (y1 = 0; y1 < bh; y1++) {
-				short* xy = XY + y1*bw * 2;
-				int X0 = saturate_cast<int>((M[1] * (y + y1) + M[2])*AB_SCALE) + round_delta;
-				int Y0 = saturate_cast<int>((M[4] * (y + y1) + M[5])*AB_SCALE) + round_delta;
-
-				if (interpolation == INTER_NEAREST) {
-					x1 = 0;
-					for (; x1 < bw; x1++) {
-						int X = (X0 + adelta[x + x1]) >> AB_BITS;
-						int Y = (Y0 + bdelta[x + x1]) >> AB_BITS;
-						xy[x1 * 2] = saturate_cast<short>(X);
-						xy[x1 * 2 + 1] = saturate_cast<short>(Y);
-					}
-				} else {
-					short* alpha = A + y1*bw;
-					x1 = 0;
-					for (; x1 < bw; x1++) {
-						int X = (X0 + adelta[x + x1]) >> (AB_BITS - INTER_BITS);
-						int Y = (Y0 + bdelta[x + x1]) >> (AB_BITS - INTER_BITS);
-						xy[x1 * 2] = saturate_cast<short>(X >> INTER_BITS);
-						xy[x1 * 2 + 1] = saturate_cast<short>(Y >> INTER_BITS);
-						alpha[x1] = (short)((Y & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE +
-							(X & (INTER_TAB_SIZE - 1)));
+	int n = (int)src.size();
+	createBatch(dst, n, dsize);
+	for (int i = 0; i < n; i++)
+		FBC_Assert(src[i].data != NULL && src[i].cols > 0 && src[i].rows > 0 && src[i].data != dst[i].data);
+
+	WarpAffineTables tab(M_, flags, dsize.width);
+	parallel_for_batch_(n, [&](int i) {
+		warpAffineInvoker(src[i], dst[i], tab, borderMode, borderValue);
+	});
+
+	return 0;
+}
+
+// the destination is processed in blocks of at most 64 x 64 pixels, the blocks of a band of rows run in parallel:
+// the source coordinates of a block are stepped in fixed point from X0, Y0 of its rows by the column offsets of tab
+// (see hal::warpAffineBlockline), then the block is interpolated directly from them (see remapBlock)
+template<typename _Tp1, int chs1>
+static void warpAffineInvoker(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst, const WarpAffineTables& tab, int borderMode, const Scalar& borderValue)
+{
+	FBC_Assert((int)tab.adelta.size() == dst.cols);
+
+	const double* M = tab.M;
+	const int* adelta = &tab.adelta[0], *bdelta = &tab.bdelta[0];
+	const int interpolation = tab.interpolation;
+	const int AB_BITS = WarpAffineTables::AB_BITS;
+	const int AB_SCALE = WarpAffineTables::AB_SCALE;
+	const void* ctab = interpolation == INTER_NEAREST ? NULL : initInterTab2D<_Tp1>(interpolation, typeid(uchar).name() == typeid(_Tp1).name());
+
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		const int BLOCK_SZ = 64;
+		short XY[BLOCK_SZ*BLOCK_SZ * 2], A[BLOCK_SZ*BLOCK_SZ];
+		int round_delta = interpolation == INTER_NEAREST ? AB_SCALE / 2 : AB_SCALE / INTER_TAB_SIZE / 2, x, y, x1, y1;
+
+		int bh0 = std::min(BLOCK_SZ / 2, dst.rows);
+		int bw0 = std::min(BLOCK_SZ*BLOCK_SZ / bh0, dst.cols);
+		bh0 = std::min(BLOCK_SZ*BLOCK_SZ / bw0, dst.rows);
+
+		for (y = range.start; y < range.end; y += bh0) {
+			for (x = 0; x < dst.cols; x += bw0) {
+				int bw = std::min(bw0, dst.cols - x);
+				int bh = std::min(bh0, range.end - y);
+
+				Mat_<short, 2> _XY(bh, bw, XY);
+				Mat_<ushort, 1> _matA(bh, bw, A);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bw, bh));
+
+				for (y1 = 0; y1 < bh; y1++) {
+					short* xy = XY + y1*bw * 2;
+					int X0 = saturate_cast<int>((M[1] * (y + y1) + M[2])*AB_SCALE) + round_delta;
+					int Y0 = saturate_cast<int>((M[4] * (y + y1) + M[5])*AB_SCALE) + round_delta;
+
+					if (interpolation == INTER_NEAREST) {
+						x1 = hal::warpAffineBlocklineNN(adelta + x, bdelta + x, xy, X0, Y0, bw);
+						for (; x1 < bw; x1++) {
+							int X = (X0 + adelta[x + x1]) >> AB_BITS;
+							int Y = (Y0 + bdelta[x + x1]) >> AB_BITS;
+							xy[x1 * 2] = saturate_cast<short>(X);
+							xy[x1 * 2 + 1] = saturate_cast<short>(Y);
+						}
+					} else {
+						short* alpha = A + y1*bw;
+						x1 = hal::warpAffineBlockline(adelta + x, bdelta + x, xy, alpha, X0, Y0, bw);
+						for (; x1 < bw; x1++) {
+							int X = (X0 + adelta[x + x1]) >> (AB_BITS - INTER_BITS);
+							int Y = (Y0 + bdelta[x + x1]) >> (AB_BITS - INTER_BITS);
+							xy[x1 * 2] = saturate_cast<short>(X >> INTER_BITS);
+							xy[x1 * 2 + 1] = saturate_cast<short>(Y >> INTER_BITS);
+							alpha[x1] = (short)((Y & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE +
+								(X & (INTER_TAB_SIZE - 1)));
+						}
 					}
 				}
-			}
 
-			if (interpolation == INTER_NEAREST) {
-				remap(src, dpart, _XY, Mat_<float, 1>(), interpolation, borderMode, borderValue);
-			} else {
-				Mat_<ushort, 1> _matA(bh, bw, A);
-				remap(src, dpart, _XY, _matA, interpolation, borderMode, borderValue);
+				remapBlock(src, dpart, _XY, _matA, interpolation, ctab, borderMode, borderValue);
 			}
 		}
-	}
-
-	return 0;
+	}, dst.total() / (double)(1 << 16));
 }
 
 } // namespace fbc
@@ -11,6 +11,7 @@
 #include <typeinfo>
 #include "core/mat.hpp"
 #include "core/invert.hpp"
+#include "core/parallel.hpp"
 #include "imgproc.hpp"
 #include "remap.hpp"
 
@@ -50,71 +51,67 @@ int warpPerspective(const Mat_<_Tp1, chs1>& src, Mat_<_Tp1, chs1>& dst, const Ma
 
 	if (!(flags & WARP_INVERSE_MAP))
 		invert(M_, matM);
-
-	Range range(0, dst.rows);
-
-	const int BLOCK_SZ = 32;
-	short XY[BLOCK_SZ*BLOCK_SZ * 2], A[BLOCK_SZ*BLOCK_SZ];
-	int x, y, x1, y1, width = dst.cols, height = dst.rows;
-
-	int bh0 = std::min(BLOCK_SZ / 2, height);
-	int bw0 = std::min(BLOCK_SZ*BLOCK_SZ / bh0, width);
-	bh0 = std::min(BLOCK_SZ*BLOCK_SZ / bw0, height);
-
-	for (y = range.start; y < range.end; y += bh0) {
-		for (x = 0; x < width; x += bw0) {
-			int bw = std::min(bw0, width - x);
-			int bh = std::min(bh0, range.end - y); // height
-
-			Mat_<short, 2> _XY(bh, bw, XY), matA;
-			Mat_<_Tp1, chs1> dpart;
-			dst.getROI(dpart, Rect(x, y, bw, bh));
-
-			for (y1 = 0; y1 < bh; y1++) {
-				short* xy = XY + y1*bw * 2;
-				double X0 = M[0] * x + M[1] * (y + y1) + M[2];
-				double Y0 = M[3] * x + M[4] * (y + y1) + M[5];
-				double W0 = M[6] * x + M[7] * (y + y1) + M[8];
-
-				if (interpolation == INTER_NEAREST) {
-					x1 = 0;
-					for (; x1 < bw; x1++) {
-						double W = W0 + M[6] * x1;
-						W = W ? 1. / W : 0;
-						double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0] * x1)*W));
-						double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3] * x1)*W));
-						int X = saturate_cast<int>(fX);
-						int Y = saturate_cast<int>(fY);
-
-						xy[x1 * 2] = saturate_cast<short>(X);
-						xy[x1 * 2 + 1] = saturate_cast<short>(Y);
-					}
-				} else {
-					short* alpha = A + y1*bw;
-					x1 = 0;
-					for (; x1 < bw; x1++) {
-						double W = W0 + M[6] * x1;
-						W = W ? INTER_TAB_SIZE / W : 0;
-						double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0] * x1)*W));
-						double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3] * x1)*W));
-						int X = saturate_cast<int>(fX);
-						int Y = saturate_cast<int>(fY);
-
-						xy[x1 * 2] = saturate_cast<short>(X >> INTER_BITS);
-						xy[x1 * 2 + 1] = saturate_cast<short>(Y >> INTER_BITS);
-						alpha[x1] = (short)((Y & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (X & (INTER_TAB_SIZE - 1)));
+	const void* ctab = interpolation == INTER_NEAREST ? NULL : initInterTab2D<_Tp1>(interpolation, typeid(uchar).name() == typeid(_Tp1).name());
+
+	parallel_for_(Range(0, dst.rows), [&](const Range& range) {
+		const int BLOCK_SZ = 32;
+		short XY[BLOCK_SZ*BLOCK_SZ * 2], A[BLOCK_SZ*BLOCK_SZ];
+		int x, y, x1, y1, width = dst.cols, height = dst.rows;
+
+		int bh0 = std::min(BLOCK_SZ / 2, height);
+		int bw0 = std::min(BLOCK_SZ*BLOCK_SZ / bh0, width);
+		bh0 = std::min(BLOCK_SZ*BLOCK_SZ / bw0, height);
+
+		for (y = range.start; y < range.end; y += bh0) {
+			for (x = 0; x < width; x += bw0) {
+				int bw = std::min(bw0, width - x);
+				int bh = std::min(bh0, range.end - y); // height
+
+				Mat_<short, 2> _XY(bh, bw, XY);
+				Mat_<_Tp1, chs1> dpart;
+				dst.getROI(dpart, Rect(x, y, bw, bh));
+
+				for (y1 = 0; y1 < bh; y1++) {
+					short* xy = XY + y1*bw * 2;
+					double X0 = M[0] * x + M[1] * (y + y1) + M[2];
+					double Y0 = M[3] * x + M[4] * (y + y1) + M[5];
+					double W0 = M[6] * x + M[7] * (y + y1) + M[8];
+
+					if (interpolation == INTER_NEAREST) {
+						x1 = 0;
+						for (; x1 < bw; x1++) {
+							double W = W0 + M[6] * x1;
+							W = W ? 1. / W : 0;
+							double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0] * x1)*W));
+							double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3] * x1)*W));
+							int X = saturate_cast<int>(fX);
+							int Y = saturate_cast<int>(fY);
+
+							xy[x1 * 2] = saturate_cast<short>(X);
+							xy[x1 * 2 + 1] = saturate_cast<short>(Y);
+						}
+					} else {
+						short* alpha = A + y1*bw;
+						x1 = 0;
+						for (; x1 < bw; x1++) {
+							double W = W0 + M[6] * x1;
+							W = W ? INTER_TAB_SIZE / W : 0;
+							double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0] * x1)*W));
+							double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3] * x1)*W));
+							int X = saturate_cast<int>(fX);
+							int Y = saturate_cast<int>(fY);
+
+							xy[x1 * 2] = saturate_cast<short>(X >> INTER_BITS);
+							xy[x1 * 2 + 1] = saturate_cast<short>(Y >> INTER_BITS);
+							alpha[x1] = (short)((Y & (INTER_TAB_SIZE - 1))*INTER_TAB_SIZE + (X & (INTER_TAB_SIZE - 1)));
+						}
 					}
 				}
-			}
 
-			if (interpolation == INTER_NEAREST) {
-				remap(src, dpart, _XY, Mat_<float, 1>(), interpolation, borderMode, borderValue);
-			} else {
-				Mat_<ushort, 1> _matA(bh, bw, A);
-				remap(src, dpart, _XY, _matA, interpolation, borderMode, borderValue);
+				remapBlock(src, dpart, _XY, Mat_<ushort, 1>(bh, bw, (ushort*)A), interpolation, ctab, borderMode, borderValue);
 			}
 		}
-	}
+	}, dst.total() / (double)(1 << 16));
 
 	return 0;
 }
@@ -0,0 +1,1008 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <linux/videodev2.h>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "cap_v4l2.hpp"
+#include "videocapture.hpp"
+#include "cvtColor.hpp"
+#include "core/saturate.hpp"
+
+// reference: 2.4.13.6
+//            highgui/src/cap_v4l.cpp
+
+namespace fbc {
+
+// the ioctl interface of a capture device
+class V4L2Device {
+public:
+	virtual ~V4L2Device() {}
+	// as ::ioctl: -1 and errno on failure
+	virtual int ioctl(unsigned long request, void* arg) = 0;
+	// the descriptor waited for by epoll, readable when a frame can be dequeued
+	virtual int pollFd() const = 0;
+	// the descriptor the buffers are mapped from
+	virtual int mapFd() const = 0;
+};
+
+namespace {
+
+const int V4L2_GRAB_TIMEOUT_MS = 10000;
+const int V4L2_DEFAULT_BUFFERS = 4;
+
+int xioctl(V4L2Device* dev, unsigned long request, void* arg)
+{
+	int r;
+	do {
+		r = dev->ioctl(request, arg);
+	} while (r == -1 && errno == EINTR);
+	return r;
+}
+
+class V4L2FileDevice : public V4L2Device {
+public:
+	explicit V4L2FileDevice(int _fd) : fd(_fd) {}
+	~V4L2FileDevice() { ::close(fd); }
+
+	int ioctl(unsigned long request, void* arg) { return ::ioctl(fd, request, arg); }
+	int pollFd() const { return fd; }
+	int mapFd() const { return fd; }
+
+private:
+	int fd;
+};
+
+V4L2Device* openDevicePath(const char* path)
+{
+	int fd = ::open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC, 0);
+	return fd < 0 ? nullptr : new V4L2FileDevice(fd);
+}
+
+bool isCaptureDevice(V4L2Device* dev, v4l2_capability& cap)
+{
+	memset(&cap, 0, sizeof(cap));
+	if (xioctl(dev, VIDIOC_QUERYCAP, &cap) == -1)
+		return false;
+
+	__u32 caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+	return (caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING);
+}
+
+// video_codec_type_t of a pixel format, -1 if unknown
+int codecTypeOf(__u32 pixelformat, __u32 flags)
+{
+	switch (pixelformat) {
+	case V4L2_PIX_FMT_MJPEG:
+	case V4L2_PIX_FMT_JPEG:
+		return VIDEO_CODEC_TYPE_MJPEG;
+	case V4L2_PIX_FMT_H264:
+		return VIDEO_CODEC_TYPE_H264;
+#ifdef V4L2_PIX_FMT_HEVC
+	case V4L2_PIX_FMT_HEVC:
+		return VIDEO_CODEC_TYPE_H265;
+#endif
+	}
+
+	return (flags & V4L2_FMT_FLAG_COMPRESSED) ? -1 : VIDEO_CODEC_TYPE_RAWVIDEO;
+}
+
+int readSysfsHex(const char* path)
+{
+	FILE* f = fopen(path, "r");
+	if (!f) return 0;
+	unsigned int value = 0;
+	if (fscanf(f, "%x", &value) != 1) value = 0;
+	fclose(f);
+	return (int)value;
+}
+
+// the layout of the raw formats of the stand-in device, false if the format is not supported
+bool fillPixFormat(v4l2_pix_format& pix, __u32 width, __u32 height, __u32 pixelformat)
+{
+	__u32 bpp;
+	switch (pixelformat) {
+	case V4L2_PIX_FMT_YUYV:
+	case V4L2_PIX_FMT_UYVY:
+		bpp = 2; break;
+	case V4L2_PIX_FMT_BGR24:
+	case V4L2_PIX_FMT_RGB24:
+		bpp = 3; break;
+	case V4L2_PIX_FMT_GREY:
+	case V4L2_PIX_FMT_NV12:
+		bpp = 1; break;
+	default:
+		return false;
+	}
+
+	memset(&pix, 0, sizeof(pix));
+	pix.width = width;
+	pix.height = height;
+	pix.pixelformat = pixelformat;
+	pix.field = V4L2_FIELD_NONE;
+	pix.bytesperline = width * bpp;
+	pix.sizeimage = pixelformat == V4L2_PIX_FMT_NV12 ? width * height * 3 / 2 : pix.bytesperline * height;
+	pix.colorspace = V4L2_COLORSPACE_SMPTE170M;
+	return true;
+}
+
+// a device emulated in the process: the buffers live in a memfd mapped by the capture as the buffers of a driver,
+// a timerfd paces the frames (a one-shot expiry which is never read when fps is 0, so the device is always ready)
+class V4L2StandInDevice : public V4L2Device {
+public:
+	V4L2StandInDevice() : width(0), height(0), pixelformat(V4L2_PIX_FMT_YUYV), fps(30), file(nullptr),
+		memfd(-1), tfd(-1), base(nullptr), bufsize(0), count(0), streaming(false), sequence(0) {}
+
+	~V4L2StandInDevice()
+	{
+		releaseBuffers();
+		if (tfd >= 0) ::close(tfd);
+		if (file) fclose(file);
+	}
+
+	// name: "synthetic:WxH[:FOURCC][@fps]" or "file:path:WxH[:FOURCC][@fps]"
+	bool init(const std::string& name)
+	{
+		std::string spec;
+		bool synthetic = name.compare(0, 10, "synthetic:") == 0;
+		if (synthetic)
+			spec = name.substr(10);
+		else if (name.compare(0, 5, "file:") == 0)
+			spec = name.substr(5);
+		else
+			return false;
+
+		size_t pos = spec.rfind('@');
+		if (pos != std::string::npos && spec.find_first_of(":/", pos) == std::string::npos) {
+			fps = atoi(spec.c_str() + pos + 1);
+			spec.erase(pos);
+		}
+
+		pos = spec.rfind(':');
+		std::string token = spec.substr(pos == std::string::npos ? 0 : pos + 1);
+		if (sscanf(token.c_str(), "%dx%d", &width, &height) != 2) {
+			if (token.size() != 4 || pos == std::string::npos)
+				return false;
+			pixelformat = v4l2_fourcc(token[0], token[1], token[2], token[3]);
+			spec.erase(pos);
+			pos = spec.rfind(':');
+			token = spec.substr(pos == std::string::npos ? 0 : pos + 1);
+			if (sscanf(token.c_str(), "%dx%d", &width, &height) != 2)
+				return false;
+		}
+
+		v4l2_pix_format pix;
+		if (width <= 0 || height <= 0 || width % 2 || height % 2 || fps < 0 || !fillPixFormat(pix, width, height, pixelformat))
+			return false;
+
+		if (synthetic) {
+			if (pos != std::string::npos)
+				return false;
+		} else {
+			if (pos == std::string::npos)
+				return false;
+			path = spec.substr(0, pos);
+			file = fopen(path.c_str(), "rb");
+			if (!file) {
+				fprintf(stderr, "Error: fail to open %s\n", path.c_str());
+				return false;
+			}
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			rewind(file);
+			if (size < (long)pix.sizeimage) {
+				fprintf(stderr, "Error: %s is shorter than one frame of %u bytes\n", path.c_str(), pix.sizeimage);
+				return false;
+			}
+		}
+
+		card = name;
+		tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		return tfd >= 0;
+	}
+
+	int pollFd() const { return tfd; }
+	int mapFd() const { return memfd; }
+
+	int ioctl(unsigned long request, void* arg)
+	{
+		switch (request) {
+		case VIDIOC_QUERYCAP: {
+			v4l2_capability* cap = (v4l2_capability*)arg;
+			memset(cap, 0, sizeof(*cap));
+			strncpy((char*)cap->driver, "fbc_stand_in", sizeof(cap->driver) - 1);
+			strncpy((char*)cap->card, card.c_str(), sizeof(cap->card) - 1);
+			strncpy((char*)cap->bus_info, "platform:fbc_stand_in", sizeof(cap->bus_info) - 1);
+			cap->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+			cap->capabilities = cap->device_caps | V4L2_CAP_DEVICE_CAPS;
+			return 0;
+		}
+		case VIDIOC_ENUM_FMT: {
+			v4l2_fmtdesc* desc = (v4l2_fmtdesc*)arg;
+			if (desc->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || desc->index != 0)
+				return fail(EINVAL);
+			desc->flags = 0;
+			desc->pixelformat = pixelformat;
+			snprintf((char*)desc->description, sizeof(desc->description), "%.4s", (const char*)&pixelformat);
+			return 0;
+		}
+		case VIDIOC_ENUM_FRAMESIZES: {
+			v4l2_frmsizeenum* fse = (v4l2_frmsizeenum*)arg;
+			if (fse->index != 0 || fse->pixel_format != pixelformat)
+				return fail(EINVAL);
+			fse->type = V4L2_FRMSIZE_TYPE_DISCRETE;
+			fse->discrete.width = width;
+			fse->discrete.height = height;
+			return 0;
+		}
+		case VIDIOC_G_FMT:
+		case VIDIOC_S_FMT:
+		case VIDIOC_TRY_FMT: {
+			v4l2_format* fmt = (v4l2_format*)arg;
+			if (fmt->type != V4L2_BUF_TYPE_VIDEO_CAPTURE)
+				return fail(EINVAL);
+			if (request == VIDIOC_S_FMT && count > 0)
+				return fail(EBUSY);
+
+			// the synthetic frames can take any size and raw format, as a driver the device adjusts the request
+			int w = width, h = height;
+			__u32 f = pixelformat;
+			v4l2_pix_format pix;
+			if (request != VIDIOC_G_FMT && !file) {
+				w = std::max(2, (int)fmt->fmt.pix.width & ~1);
+				h = std::max(2, (int)fmt->fmt.pix.height & ~1);
+				if (fillPixFormat(pix, w, h, fmt->fmt.pix.pixelformat))
+					f = fmt->fmt.pix.pixelformat;
+			}
+			fillPixFormat(fmt->fmt.pix, w, h, f);
+			if (request == VIDIOC_S_FMT) {
+				width = w;
+				height = h;
+				pixelformat = f;
+			}
+			return 0;
+		}
+		case VIDIOC_G_PARM:
+		case VIDIOC_S_PARM: {
+			v4l2_streamparm* parm = (v4l2_streamparm*)arg;
+			if (parm->type != V4L2_BUF_TYPE_VIDEO_CAPTURE)
+				return fail(EINVAL);
+			v4l2_fract tpf = parm->parm.capture.timeperframe;
+			if (request == VIDIOC_S_PARM && !streaming && tpf.numerator > 0)
+				fps = (int)((tpf.denominator + tpf.numerator / 2) / tpf.numerator);
+			memset(&parm->parm.capture, 0, sizeof(parm->parm.capture));
+			parm->parm.capture.capability = V4L2_CAP_TIMEPERFRAME;
+			parm->parm.capture.timeperframe.numerator = fps > 0 ? 1 : 0;
+			parm->parm.capture.timeperframe.denominator = fps;
+			return 0;
+		}
+		case VIDIOC_REQBUFS: {
+			v4l2_requestbuffers* req = (v4l2_requestbuffers*)arg;
+			if (req->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || req->memory != V4L2_MEMORY_MMAP)
+				return fail(EINVAL);
+			if (streaming)
+				return fail(EBUSY);
+			releaseBuffers();
+			if (req->count == 0)
+				return 0;
+
+			v4l2_pix_format pix;
+			if (!fillPixFormat(pix, width, height, pixelformat))
+				return fail(EINVAL);
+			long page = sysconf(_SC_PAGESIZE);
+			count = std::min(req->count, (__u32)VIDEO_MAX_FRAME);
+			bufsize = (pix.sizeimage + page - 1) / page * page;
+			memfd = memfd_create("fbc_stand_in", MFD_CLOEXEC);
+			if (memfd < 0 || ftruncate(memfd, (off_t)bufsize * count) != 0 ||
+				(base = (uchar*)mmap(NULL, bufsize * count, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0)) == MAP_FAILED) {
+				int err = errno;
+				base = nullptr;
+				releaseBuffers();
+				return fail(err);
+			}
+			queued.assign(count, false);
+			req->count = count;
+			return 0;
+		}
+		case VIDIOC_QUERYBUF:
+		case VIDIOC_QBUF: {
+			v4l2_buffer* buf = (v4l2_buffer*)arg;
+			if (buf->type != V4L2_BUF_TYPE_VIDEO_CAPTURE || buf->memory != V4L2_MEMORY_MMAP || buf->index >= count)
+				return fail(EINVAL);
+			if (request == VIDIOC_QBUF) {
+				if (queued[buf->index])
+					return fail(EINVAL);
+				queued[buf->index] = true;
+				queue.push_back(buf->index);
+			}
+			describe(*buf, buf->index);
+			return 0;
+		}
+		case VIDIOC_DQBUF:
+			return dequeue(*(v4l2_buffer*)arg);
+		case VIDIOC_STREAMON:
+		case VIDIOC_STREAMOFF: {
+			if (*(int*)arg != V4L2_BUF_TYPE_VIDEO_CAPTURE || count == 0)
+				return fail(EINVAL);
+			streaming = request == VIDIOC_STREAMON;
+			itimerspec its;
+			memset(&its, 0, sizeof(its));
+			if (streaming) {
+				its.it_value.tv_nsec = fps > 0 ? 1000000000L / fps : 1;
+				its.it_interval = fps > 0 ? its.it_value : its.it_interval;
+			} else {
+				queue.clear();
+				queued.assign(count, false);
+			}
+			timerfd_settime(tfd, 0, &its, NULL);
+			return 0;
+		}
+		default:
+			// VIDIOC_EXPBUF included: a memfd is not a DMABUF
+			return fail(request == VIDIOC_EXPBUF ? EINVAL : ENOTTY);
+		}
+	}
+
+private:
+	static int fail(int err)
+	{
+		errno = err;
+		return -1;
+	}
+
+	void releaseBuffers()
+	{
+		if (base) munmap(base, bufsize * count);
+		if (memfd >= 0) ::close(memfd);
+		base = nullptr;
+		memfd = -1;
+		count = 0;
+		queue.clear();
+		queued.clear();
+	}
+
+	void describe(v4l2_buffer& buf, __u32 idx) const
+	{
+		v4l2_pix_format pix = {};
+		fillPixFormat(pix, width, height, pixelformat);
+		buf.length = pix.sizeimage;
+		buf.m.offset = (__u32)(bufsize * idx);
+		buf.flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC | (queued[idx] ? V4L2_BUF_FLAG_QUEUED : 0);
+		buf.field = V4L2_FIELD_NONE;
+	}
+
+	int dequeue(v4l2_buffer& buf)
+	{
+		if (buf.type != V4L2_BUF_TYPE_VIDEO_CAPTURE || buf.memory != V4L2_MEMORY_MMAP || !streaming)
+			return fail(EINVAL);
+
+		// the periods elapsed since the last frame, all but the last one are dropped frames
+		uint64_t ticks = 1;
+		if (fps > 0 && read(tfd, &ticks, sizeof(ticks)) != sizeof(ticks))
+			return fail(EAGAIN);
+		sequence += (__u32)ticks;
+		if (queue.empty())
+			return fail(EAGAIN);
+
+		__u32 idx = queue.front();
+		queue.pop_front();
+		queued[idx] = false;
+
+		uchar* data = base + bufsize * idx;
+		v4l2_pix_format pix;
+		if (!fillPixFormat(pix, width, height, pixelformat))
+			return fail(EINVAL);
+		if (file) {
+			if (fread(data, 1, pix.sizeimage, file) != pix.sizeimage) {
+				rewind(file);
+				if (fread(data, 1, pix.sizeimage, file) != pix.sizeimage)
+					return fail(EIO);
+			}
+		} else {
+			// byte x of row y of frame n is x + 2 * y + 7 * n
+			for (__u32 y = 0; y < pix.sizeimage / pix.bytesperline; y++) {
+				uchar* row = data + y * pix.bytesperline;
+				uchar v = (uchar)(2 * y + 7 * (sequence - 1));
+				for (__u32 x = 0; x < pix.bytesperline; x++)
+					row[x] = (uchar)(v + x);
+			}
+		}
+
+		buf.index = idx;
+		describe(buf, idx);
+		buf.bytesused = pix.sizeimage;
+		buf.sequence = sequence - 1;
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		buf.timestamp.tv_sec = ts.tv_sec;
+		buf.timestamp.tv_usec = ts.tv_nsec / 1000;
+		return 0;
+	}
+
+	int width, height;
+	__u32 pixelformat;
+	int fps;
+	std::string card, path;
+	FILE* file;
+	int memfd, tfd;
+	uchar* base;
+	size_t bufsize;
+	__u32 count;
+	bool streaming;
+	__u32 sequence;
+	std::vector<bool> queued;
+	std::deque<__u32> queue;
+};
+
+// the opened device for -1 or the index of the opened device, a temporary one otherwise
+V4L2Device* deviceForQuery(V4L2Device* opened, int index, int device_id, std::unique_ptr<V4L2Device>& tmp)
+{
+	if (device_id < 0 || device_id == index)
+		return opened;
+
+	char path[32];
+	snprintf(path, sizeof(path), "/dev/video%d", device_id);
+	tmp.reset(openDevicePath(path));
+	return tmp.get();
+}
+
+// YUV 4:2:2 and 4:2:0 to BGR with the coefficients of cvtColor (ITU-R BT.601), two pixels of the same chroma
+inline void yuv2bgr(int y0, int y1, int u, int v, uchar* d)
+{
+	u -= 128;
+	v -= 128;
+	int ruv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVR * v;
+	int guv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CVG * v + ITUR_BT_601_CUG * u;
+	int buv = (1 << (ITUR_BT_601_SHIFT - 1)) + ITUR_BT_601_CUB * u;
+
+	y0 = std::max(0, y0 - 16) * ITUR_BT_601_CY;
+	d[0] = saturate_cast<uchar>((y0 + buv) >> ITUR_BT_601_SHIFT);
+	d[1] = saturate_cast<uchar>((y0 + guv) >> ITUR_BT_601_SHIFT);
+	d[2] = saturate_cast<uchar>((y0 + ruv) >> ITUR_BT_601_SHIFT);
+
+	y1 = std::max(0, y1 - 16) * ITUR_BT_601_CY;
+	d[3] = saturate_cast<uchar>((y1 + buv) >> ITUR_BT_601_SHIFT);
+	d[4] = saturate_cast<uchar>((y1 + guv) >> ITUR_BT_601_SHIFT);
+	d[5] = saturate_cast<uchar>((y1 + ruv) >> ITUR_BT_601_SHIFT);
+}
+
+} // namespace
+
+CvCaptureCAM_V4L2::CvCaptureCAM_V4L2()
+	: device(nullptr), index(-1), epfd(-1), width(0), height(0), fourcc(0), fps(0), bufferCount(V4L2_DEFAULT_BUFFERS),
+	bytesperline(0), sizeimage(0), current(-1), bytesused(0), sequence(0), frame(nullptr)
+{
+	memset(&view, 0, sizeof(view));
+}
+
+CvCaptureCAM_V4L2::~CvCaptureCAM_V4L2()
+{
+	close();
+}
+
+void CvCaptureCAM_V4L2::close()
+{
+	stopCapture();
+	if (epfd >= 0) ::close(epfd);
+	epfd = -1;
+	delete device;
+	device = nullptr;
+	index = -1;
+	if (frame) cvReleaseImage(&frame);
+	width = height = fourcc = fps = 0;
+	bufferCount = V4L2_DEFAULT_BUFFERS;
+}
+
+bool CvCaptureCAM_V4L2::open(int _index)
+{
+	char path[32];
+	snprintf(path, sizeof(path), "/dev/video%d", _index);
+	V4L2Device* dev = openDevicePath(path);
+	return dev ? openDevice(dev, _index) : false;
+}
+
+bool CvCaptureCAM_V4L2::open(const std::string& name)
+{
+	if (name.compare(0, 10, "synthetic:") == 0 || name.compare(0, 5, "file:") == 0) {
+		V4L2StandInDevice* dev = new V4L2StandInDevice;
+		if (!dev->init(name)) {
+			delete dev;
+			return false;
+		}
+		return openDevice(dev, -1);
+	}
+
+	int n = -1;
+	if (sscanf(name.c_str(), "/dev/video%d", &n) != 1)
+		n = -1;
+	V4L2Device* dev = openDevicePath(name.c_str());
+	return dev ? openDevice(dev, n) : false;
+}
+
+bool CvCaptureCAM_V4L2::openDevice(V4L2Device* dev, int _index)
+{
+	close();
+	device = dev;
+	index = _index;
+
+	v4l2_capability cap;
+	if (!isCaptureDevice(device, cap)) {
+		close();
+		return false;
+	}
+
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	if (epfd < 0 || epoll_ctl(epfd, EPOLL_CTL_ADD, device->pollFd(), &ev) != 0 || !startCapture()) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+// sets the requested format and frame rate (the driver may adjust them), maps and queues the buffers, streams on
+bool CvCaptureCAM_V4L2::startCapture()
+{
+	v4l2_format fmt;
+	memset(&fmt, 0, sizeof(fmt));
+	fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(device, VIDIOC_G_FMT, &fmt) == -1)
+		return false;
+	if (width > 0) fmt.fmt.pix.width = width;
+	if (height > 0) fmt.fmt.pix.height = height;
+	if (fourcc != 0) fmt.fmt.pix.pixelformat = fourcc;
+	if (xioctl(device, VIDIOC_S_FMT, &fmt) == -1)
+		return false;
+	width = fmt.fmt.pix.width;
+	height = fmt.fmt.pix.height;
+	fourcc = fmt.fmt.pix.pixelformat;
+	bytesperline = fmt.fmt.pix.bytesperline;
+	sizeimage = fmt.fmt.pix.sizeimage;
+
+	v4l2_streamparm parm;
+	memset(&parm, 0, sizeof(parm));
+	parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (fps > 0) {
+		parm.parm.capture.timeperframe.numerator = 1;
+		parm.parm.capture.timeperframe.denominator = fps;
+		xioctl(device, VIDIOC_S_PARM, &parm);
+	}
+	if (xioctl(device, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0)
+		fps = cvRound((double)parm.parm.capture.timeperframe.denominator / parm.parm.capture.timeperframe.numerator);
+
+	v4l2_requestbuffers req;
+	memset(&req, 0, sizeof(req));
+	req.count = bufferCount;
+	req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	req.memory = V4L2_MEMORY_MMAP;
+	if (xioctl(device, VIDIOC_REQBUFS, &req) == -1 || req.count < 1)
+		return false;
+
+	buffer unmapped = { MAP_FAILED, 0, -1 };
+	buffers.assign(req.count, unmapped);
+	for (int i = 0; i < (int)buffers.size(); i++) {
+		v4l2_buffer buf;
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = i;
+		if (xioctl(device, VIDIOC_QUERYBUF, &buf) == -1)
+			return false;
+
+		buffers[i].start = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, device->mapFd(), buf.m.offset);
+		if (buffers[i].start == MAP_FAILED)
+			return false;
+		buffers[i].length = buf.length;
+
+		v4l2_exportbuffer expbuf;
+		memset(&expbuf, 0, sizeof(expbuf));
+		expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		expbuf.index = i;
+		expbuf.flags = O_RDONLY | O_CLOEXEC;
+		if (xioctl(device, VIDIOC_EXPBUF, &expbuf) == 0)
+			buffers[i].dmabuf_fd = expbuf.fd;
+	}
+
+	for (int i = 0; i < (int)buffers.size(); i++) {
+		if (!queueBuffer(i))
+			return false;
+	}
+
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (xioctl(device, VIDIOC_STREAMON, &type) == -1)
+		return false;
+
+	current = -1;
+	return true;
+}
+
+void CvCaptureCAM_V4L2::stopCapture()
+{
+	if (!device)
+		return;
+
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	if (!buffers.empty())
+		xioctl(device, VIDIOC_STREAMOFF, &type);
+
+	for (size_t i = 0; i < buffers.size(); i++) {
+		if (buffers[i].dmabuf_fd >= 0) ::close(buffers[i].dmabuf_fd);
+		if (buffers[i].start != MAP_FAILED) munmap(buffers[i].start, buffers[i].length);
+	}
+	buffers.clear();
+
+	// frees the buffers of the driver, needed before a new format
+	v4l2_requestbuffers req;
+	memset(&req, 0, sizeof(req));
+	req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	req.memory = V4L2_MEMORY_MMAP;
+	xioctl(device, VIDIOC_REQBUFS, &req);
+
+	current = -1;
+}
+
+bool CvCaptureCAM_V4L2::queueBuffer(int idx)
+{
+	v4l2_buffer buf;
+	memset(&buf, 0, sizeof(buf));
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	buf.index = idx;
+	return xioctl(device, VIDIOC_QBUF, &buf) != -1;
+}
+
+// gives the previous frame back to the driver and dequeues the next one, waiting for it with epoll
+bool CvCaptureCAM_V4L2::grabFrame()
+{
+	if (!device || buffers.empty())
+		return false;
+
+	if (current >= 0) {
+		int idx = current;
+		current = -1;
+		if (!queueBuffer(idx))
+			return false;
+	}
+
+	for (;;) {
+		v4l2_buffer buf;
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		if (xioctl(device, VIDIOC_DQBUF, &buf) == 0) {
+			current = buf.index;
+			bytesused = buf.bytesused;
+			sequence = buf.sequence;
+			return true;
+		}
+		if (errno != EAGAIN)
+			return false;
+
+		epoll_event ev;
+		int n = epoll_wait(epfd, &ev, 1, V4L2_GRAB_TIMEOUT_MS);
+		if (n == 0) {
+			fprintf(stderr, "Error: V4L2: timeout while waiting for a frame\n");
+			return false;
+		}
+		if (n < 0 && errno != EINTR)
+			return false;
+	}
+}
+
+bool CvCaptureCAM_V4L2::retrieveFrameView(frame_view& v)
+{
+	if (current < 0)
+		return false;
+
+	v.data = (unsigned char*)buffers[current].start;
+	v.width = width;
+	v.height = height;
+	v.step = bytesperline;
+	v.bytesused = bytesused;
+	v.fourcc = fourcc;
+	v.sequence = sequence;
+	v.dmabuf_fd = buffers[current].dmabuf_fd;
+	return true;
+}
+
+// the frame as BGR: a header on the mapped buffer for the BGR24 devices, converted otherwise; NULL for the
+// compressed formats, which are available through retrieveFrameView
+IplImage* CvCaptureCAM_V4L2::retrieveFrame(int)
+{
+	if (current < 0)
+		return NULL;
+
+	const uchar* src = (const uchar*)buffers[current].start;
+	int needed = fourcc == V4L2_PIX_FMT_NV12 ? bytesperline * height * 3 / 2 : bytesperline * height;
+	if (bytesused < needed)
+		return NULL;
+
+	if (fourcc == V4L2_PIX_FMT_BGR24 && bytesperline == width * 3) {
+		cvInitImageHeader(&view, cvSize(width, height), IPL_DEPTH_8U, 3, IPL_ORIGIN_TL, 4);
+		view.imageData = view.imageDataOrigin = (char*)src;
+		view.widthStep = bytesperline;
+		view.imageSize = bytesperline * height;
+		return &view;
+	}
+
+	if (!frame || frame->width != width || frame->height != height) {
+		if (frame) cvReleaseImage(&frame);
+		frame = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, 3);
+	}
+
+	for (int y = 0; y < height; y++) {
+		const uchar* s = src + y * bytesperline;
+		uchar* d = (uchar*)frame->imageData + y * frame->widthStep;
+
+		switch (fourcc) {
+		case V4L2_PIX_FMT_BGR24:
+			memcpy(d, s, width * 3);
+			break;
+		case V4L2_PIX_FMT_RGB24:
+			for (int x = 0; x < width * 3; x += 3) {
+				d[x] = s[x + 2]; d[x + 1] = s[x + 1]; d[x + 2] = s[x];
+			}
+			break;
+		case V4L2_PIX_FMT_GREY:
+			for (int x = 0; x < width; x++)
+				d[x * 3] = d[x * 3 + 1] = d[x * 3 + 2] = s[x];
+			break;
+		case V4L2_PIX_FMT_YUYV:
+			for (int x = 0; x < width; x += 2, s += 4)
+				yuv2bgr(s[0], s[2], s[1], s[3], d + x * 3);
+			break;
+		case V4L2_PIX_FMT_UYVY:
+			for (int x = 0; x < width; x += 2, s += 4)
+				yuv2bgr(s[1], s[3], s[0], s[2], d + x * 3);
+			break;
+		case V4L2_PIX_FMT_NV12: {
+			const uchar* uv = src + bytesperline * (height + y / 2);
+			for (int x = 0; x < width; x += 2)
+				yuv2bgr(s[x], s[x + 1], uv[x], uv[x + 1], d + x * 3);
+			break;
+		}
+		default:
+			return NULL;
+		}
+	}
+
+	return frame;
+}
+
+static __u32 controlFromCV(int property_id)
+{
+	switch (property_id) {
+	case CV_CAP_PROP_BRIGHTNESS: return V4L2_CID_BRIGHTNESS;
+	case CV_CAP_PROP_CONTRAST: return V4L2_CID_CONTRAST;
+	case CV_CAP_PROP_SATURATION: return V4L2_CID_SATURATION;
+	case CV_CAP_PROP_HUE: return V4L2_CID_HUE;
+	case CV_CAP_PROP_GAIN: return V4L2_CID_GAIN;
+	case CV_CAP_PROP_SHARPNESS: return V4L2_CID_SHARPNESS;
+	case CV_CAP_PROP_GAMMA: return V4L2_CID_GAMMA;
+	case CV_CAP_PROP_BACKLIGHT: return V4L2_CID_BACKLIGHT_COMPENSATION;
+	case CV_CAP_PROP_EXPOSURE: return V4L2_CID_EXPOSURE_ABSOLUTE;
+	case CV_CAP_PROP_AUTO_EXPOSURE: return V4L2_CID_EXPOSURE_AUTO;
+	case CV_CAP_PROP_FOCUS: return V4L2_CID_FOCUS_ABSOLUTE;
+	case CV_CAP_PROP_ZOOM: return V4L2_CID_ZOOM_ABSOLUTE;
+	case CV_CAP_PROP_PAN: return V4L2_CID_PAN_ABSOLUTE;
+	case CV_CAP_PROP_TILT: return V4L2_CID_TILT_ABSOLUTE;
+	}
+
+	return 0;
+}
+
+double CvCaptureCAM_V4L2::getProperty(int property_id)
+{
+	if (!device)
+		return -1;
+
+	switch (property_id) {
+	case CV_CAP_PROP_FRAME_WIDTH:
+		return width;
+	case CV_CAP_PROP_FRAME_HEIGHT:
+		return height;
+	case CV_CAP_PROP_FOURCC:
+		return (double)(unsigned int)fourcc;
+	case CV_CAP_PROP_FPS:
+		return fps;
+	case CV_CAP_PROP_BUFFERSIZE:
+		return (double)buffers.size();
+	}
+
+	// the controls of the driver, unscaled
+	v4l2_control control;
+	control.id = controlFromCV(property_id);
+	control.value = 0;
+	if (control.id != 0 && xioctl(device, VIDIOC_G_CTRL, &control) == 0)
+		return control.value;
+
+	// unknown parameter or value not available
+	return -1;
+}
+
+bool CvCaptureCAM_V4L2::setProperty(int property_id, double value)
+{
+	if (!device)
+		return false;
+
+	// the stream settings restart the capture
+	bool restart = true;
+	switch (property_id) {
+	case CV_CAP_PROP_FRAME_WIDTH:
+		width = cvRound(value);
+		break;
+	case CV_CAP_PROP_FRAME_HEIGHT:
+		height = cvRound(value);
+		break;
+	case CV_CAP_PROP_FOURCC:
+		fourcc = (int)(unsigned int)value;
+		break;
+	case CV_CAP_PROP_FPS:
+		fps = cvRound(value);
+		break;
+	case CV_CAP_PROP_BUFFERSIZE:
+		bufferCount = std::max(1, cvRound(value));
+		break;
+	default:
+		restart = false;
+	}
+
+	if (restart) {
+		stopCapture();
+		return startCapture();
+	}
+
+	v4l2_control control;
+	control.id = controlFromCV(property_id);
+	control.value = cvRound(value);
+	return control.id != 0 && xioctl(device, VIDIOC_S_CTRL, &control) == 0;
+}
+
+bool CvCaptureCAM_V4L2::getDevicesList(std::map<int, device_info>& devicelist) const
+{
+	devicelist.clear();
+
+	DIR* dir = opendir("/dev");
+	if (!dir) {
+		fprintf(stderr, "Error: couldn't open the directory: /dev\n");
+		return false;
+	}
+
+	struct dirent* entry = nullptr;
+	while ((entry = readdir(dir))) {
+		int n;
+		char c;
+		if (sscanf(entry->d_name, "video%d%c", &n, &c) != 1)
+			continue;
+
+		char path[5 + NAME_MAX + 1];
+		snprintf(path, sizeof(path), "/dev/%s", entry->d_name);
+		std::unique_ptr<V4L2Device> dev(openDevicePath(path));
+		v4l2_capability cap;
+		if (!dev || !isCaptureDevice(dev.get(), cap))
+			continue;
+
+		device_info info;
+		info.name = (const char*)cap.card;
+		// the USB ids are attributes of the parent of the interface
+		snprintf(path, sizeof(path), "/sys/class/video4linux/video%d/device/../idVendor", n);
+		info.vendor_id = readSysfsHex(path);
+		snprintf(path, sizeof(path), "/sys/class/video4linux/video%d/device/../idProduct", n);
+		info.product_id = readSysfsHex(path);
+		devicelist[n] = info;
+	}
+
+	closedir(dir);
+	return true;
+}
+
+bool CvCaptureCAM_V4L2::getCodecList(int device_id, std::vector<int>& codecids) const
+{
+	codecids.clear();
+
+	std::unique_ptr<V4L2Device> tmp;
+	V4L2Device* dev = deviceForQuery(device, index, device_id, tmp);
+	if (!dev)
+		return false;
+
+	std::set<int> codecs;
+	v4l2_fmtdesc desc;
+	memset(&desc, 0, sizeof(desc));
+	desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	for (; xioctl(dev, VIDIOC_ENUM_FMT, &desc) == 0; desc.index++) {
+		int codec = codecTypeOf(desc.pixelformat, desc.flags);
+		if (codec >= 0)
+			codecs.insert(codec);
+	}
+
+	codecids.assign(codecs.begin(), codecs.end());
+	return true;
+}
+
+bool CvCaptureCAM_V4L2::getVideoSizeList(int device_id, int codec_id, std::vector<std::string>& sizelist) const
+{
+	sizelist.clear();
+
+	std::unique_ptr<V4L2Device> tmp;
+	V4L2Device* dev = deviceForQuery(device, index, device_id, tmp);
+	if (!dev)
+		return false;
+
+	std::set<std::pair<__u32, __u32>> sizes;
+	v4l2_fmtdesc desc;
+	memset(&desc, 0, sizeof(desc));
+	desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	for (; xioctl(dev, VIDIOC_ENUM_FMT, &desc) == 0; desc.index++) {
+		if (codecTypeOf(desc.pixelformat, desc.flags) != codec_id)
+			continue;
+
+		v4l2_frmsizeenum fse;
+		memset(&fse, 0, sizeof(fse));
+		fse.pixel_format = desc.pixelformat;
+		for (; xioctl(dev, VIDIOC_ENUM_FRAMESIZES, &fse) == 0; fse.index++) {
+			if (fse.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+				sizes.insert(std::make_pair(fse.discrete.width, fse.discrete.height));
+			} else {
+				// stepwise or continuous: the smallest and the largest sizes, as the DirectShow capture
+				sizes.insert(std::make_pair(fse.stepwise.min_width, fse.stepwise.min_height));
+				sizes.insert(std::make_pair(fse.stepwise.max_width, fse.stepwise.max_height));
+				break;
+			}
+		}
+	}
+
+	for (auto it = sizes.cbegin(); it != sizes.cend(); ++it) {
+		std::string size = std::to_string((*it).first);
+		size += "x";
+		size += std::to_string((*it).second);
+		sizelist.push_back(size);
+	}
+
+	return true;
+}
+
+CvCapture* cvCreateCameraCapture_V4L2(int index)
+{
+	CvCaptureCAM_V4L2* capture = new CvCaptureCAM_V4L2;
+	if (capture->open(index))
+		return capture;
+
+	delete capture;
+	return nullptr;
+}
+
+CvCapture* cvCreateCameraCapture_V4L2(const std::string& name)
+{
+	CvCaptureCAM_V4L2* capture = new CvCaptureCAM_V4L2;
+	if (capture->open(name))
+		return capture;
+
+	delete capture;
+	return nullptr;
+}
+
+} // namespace fbc
+
+#endif // __linux__
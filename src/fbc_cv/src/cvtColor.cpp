@@ -0,0 +1,264 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: imgproc/src/color.cpp
+*/
+
+// SSE4.1 kernels of the 8-bit BGR <-> YCrCb/YUV and BGR -> gray conversions of cvtColor, selected at runtime by
+// checkHardwareSupport(); the 14-bit fixed-point products are the ones of RGB2YCrCb_i/YCrCb2RGB_i/RGB2Gray, computed in 32-bit lanes with pmaddwd
+// (a coefficient beyond the 16-bit range is split into two halves), so the results are those of the plain C++ code
+
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+	#define FBC_TARGET_SSE4_1
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// element p of plane c is the element 3 * p + c of the 3 source registers: masks[c][r] takes it from register r
+static const signed char deinterleave3Masks[3][3][16] = {
+	{ { 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13 } },
+	{ { 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14 } },
+	{ { 2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15 } }
+};
+
+// element j of the destination register k is the element (16 * k + j) / 3 of plane (16 * k + j) % 3: masks[k][c]
+static const signed char interleave3Masks[3][3][16] = {
+	{ { 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5 },
+	  { -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1 },
+	  { -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1 } },
+	{ { -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1 },
+	  { 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10 },
+	  { -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1 } },
+	{ { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+	  { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+	  { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } }
+};
+
+static inline FBC_TARGET_SSE4_1 __m128i loadMask(const signed char* mask)
+{
+	return _mm_loadu_si128((const __m128i*)mask);
+}
+
+static inline FBC_TARGET_SSE4_1 void shuffle3(const __m128i* in, __m128i* out, const signed char (*masks)[3][16])
+{
+	for (int k = 0; k < 3; k++) {
+		out[k] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in[0], loadMask(masks[k][0])),
+			_mm_shuffle_epi8(in[1], loadMask(masks[k][1]))), _mm_shuffle_epi8(in[2], loadMask(masks[k][2])));
+	}
+}
+
+// the first 3 channels of 16 pixels of cn (3 or 4) channels as planes
+static inline FBC_TARGET_SSE4_1 void load16(const uchar* src, int cn, __m128i* planes)
+{
+	if (cn == 3) {
+		__m128i in[3];
+		for (int k = 0; k < 3; k++)
+			in[k] = _mm_loadu_si128((const __m128i*)(src + k * 16));
+		shuffle3(in, planes, deinterleave3Masks);
+	} else {
+		const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+		__m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), group);
+		__m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)), group);
+		__m128i v2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 32)), group);
+		__m128i v3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 48)), group);
+		__m128i t0 = _mm_unpacklo_epi32(v0, v1), t1 = _mm_unpacklo_epi32(v2, v3);
+		__m128i t2 = _mm_unpackhi_epi32(v0, v1), t3 = _mm_unpackhi_epi32(v2, v3);
+		planes[0] = _mm_unpacklo_epi64(t0, t1);
+		planes[1] = _mm_unpackhi_epi64(t0, t1);
+		planes[2] = _mm_unpacklo_epi64(t2, t3);
+	}
+}
+
+// 16 pixels of cn (3 or 4) channels from 3 planes, the fourth channel is 255
+static inline FBC_TARGET_SSE4_1 void store16(uchar* dst, int cn, const __m128i* planes)
+{
+	if (cn == 3) {
+		__m128i out[3];
+		shuffle3(planes, out, interleave3Masks);
+		for (int k = 0; k < 3; k++)
+			_mm_storeu_si128((__m128i*)(dst + k * 16), out[k]);
+	} else {
+		__m128i d = _mm_set1_epi8((char)255);
+		__m128i ab0 = _mm_unpacklo_epi8(planes[0], planes[1]), ab1 = _mm_unpackhi_epi8(planes[0], planes[1]);
+		__m128i cd0 = _mm_unpacklo_epi8(planes[2], d), cd1 = _mm_unpackhi_epi8(planes[2], d);
+		_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(ab0, cd0));
+		_mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(ab0, cd0));
+		_mm_storeu_si128((__m128i*)(dst + 32), _mm_unpacklo_epi16(ab1, cd1));
+		_mm_storeu_si128((__m128i*)(dst + 48), _mm_unpackhi_epi16(ab1, cd1));
+	}
+}
+
+// the pmaddwd multiplier of the pairs (a, b): a * c0 + b * c1
+static inline FBC_TARGET_SSE4_1 __m128i pairCoeffs(int c0, int c1)
+{
+	return _mm_set1_epi32((int)(((unsigned)c1 << 16) | (unsigned)(c0 & 0xffff)));
+}
+
+// Y of 8 pixels of 16-bit channels s0, s1, s2 (memory order), c[0]: (s0, s1), c[1]: (s2, rounding)
+static inline FBC_TARGET_SSE4_1 __m128i luma8(__m128i s0, __m128i s1, __m128i s2, const __m128i* c)
+{
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i y0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(s0, s1), c[0]), _mm_madd_epi16(_mm_unpacklo_epi16(s2, one), c[1]));
+	__m128i y1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(s0, s1), c[0]), _mm_madd_epi16(_mm_unpackhi_epi16(s2, one), c[1]));
+	return _mm_packs_epi32(_mm_srai_epi32(y0, 14), _mm_srai_epi32(y1, 14));
+}
+
+// Y, Cr and Cb of 8 pixels of 16-bit channels s0, s1, s2 (memory order), r and b are two of them
+static inline FBC_TARGET_SSE4_1 void bgr2ycrcb8(__m128i s0, __m128i s1, __m128i s2, __m128i r, __m128i b, const __m128i* c, __m128i* y, __m128i* cr, __m128i* cb)
+{
+	const __m128i one = _mm_set1_epi16(1), delta = _mm_set1_epi32(128);
+	*y = luma8(s0, s1, s2, c);
+
+	// (d * C + (128 << 14) + (1 << 13)) >> 14 = ((d * C + (1 << 13)) >> 14) + 128
+	__m128i dr = _mm_sub_epi16(r, *y), db = _mm_sub_epi16(b, *y);
+	__m128i r0 = _mm_add_epi32(_mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(dr, one), c[2]), 14), delta);
+	__m128i r1 = _mm_add_epi32(_mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(dr, one), c[2]), 14), delta);
+	__m128i b0 = _mm_add_epi32(_mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(db, one), c[3]), 14), delta);
+	__m128i b1 = _mm_add_epi32(_mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(db, one), c[3]), 14), delta);
+	*cr = _mm_packs_epi32(r0, r1);
+	*cb = _mm_packs_epi32(b0, b1);
+}
+
+static FBC_TARGET_SSE4_1 int cvtBGRtoYCrCb8u(const uchar* src, uchar* dst, int n, int scn, int bidx, const int* coeffs)
+{
+	// c[0]: (s0, s1), c[1]: (s2, rounding), c[2]: Cr, c[3]: Cb
+	__m128i c[4] = { pairCoeffs(coeffs[0], coeffs[1]), pairCoeffs(coeffs[2], 1 << 13),
+		pairCoeffs(coeffs[3], 1 << 13), pairCoeffs(coeffs[4], 1 << 13) };
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x <= n - 16; x += 16) {
+		__m128i p[3], out[3];
+		load16(src + x * scn, scn, p);
+
+		__m128i s[3][2];
+		for (int k = 0; k < 3; k++) {
+			s[k][0] = _mm_unpacklo_epi8(p[k], zero);
+			s[k][1] = _mm_unpackhi_epi8(p[k], zero);
+		}
+
+		__m128i y[2], cr[2], cb[2];
+		for (int h = 0; h < 2; h++)
+			bgr2ycrcb8(s[0][h], s[1][h], s[2][h], s[bidx ^ 2][h], s[bidx][h], c, &y[h], &cr[h], &cb[h]);
+
+		out[0] = _mm_packus_epi16(y[0], y[1]);
+		out[1] = _mm_packus_epi16(cr[0], cr[1]);
+		out[2] = _mm_packus_epi16(cb[0], cb[1]);
+		store16(dst + x * 3, 3, out);
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int cvtBGRtoGray8u(const uchar* src, uchar* dst, int n, int scn, const int* coeffs)
+{
+	__m128i c[2] = { pairCoeffs(coeffs[0], coeffs[1]), pairCoeffs(coeffs[2], 1 << 13) };
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x <= n - 16; x += 16) {
+		__m128i p[3];
+		load16(src + x * scn, scn, p);
+
+		__m128i y0 = luma8(_mm_unpacklo_epi8(p[0], zero), _mm_unpacklo_epi8(p[1], zero), _mm_unpacklo_epi8(p[2], zero), c);
+		__m128i y1 = luma8(_mm_unpackhi_epi8(p[0], zero), _mm_unpackhi_epi8(p[1], zero), _mm_unpackhi_epi8(p[2], zero), c);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(y0, y1));
+	}
+
+	return x;
+}
+
+// (d * C + (1 << 13)) >> 14 of 8 16-bit values d, C split as (C - C / 2, C / 2)
+static inline FBC_TARGET_SSE4_1 __m128i descaleMul8(__m128i d, __m128i c)
+{
+	const __m128i round = _mm_set1_epi32(1 << 13);
+	__m128i v0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(d, d), c), round);
+	__m128i v1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(d, d), c), round);
+	return _mm_packs_epi32(_mm_srai_epi32(v0, 14), _mm_srai_epi32(v1, 14));
+}
+
+static FBC_TARGET_SSE4_1 int cvtYCrCbtoBGR8u(const uchar* src, uchar* dst, int n, int dcn, int bidx, const int* coeffs)
+{
+	__m128i cr = pairCoeffs(coeffs[0] - coeffs[0] / 2, coeffs[0] / 2);
+	__m128i cg = pairCoeffs(coeffs[2], coeffs[1]);
+	__m128i cb = pairCoeffs(coeffs[3] - coeffs[3] / 2, coeffs[3] / 2);
+	const __m128i zero = _mm_setzero_si128(), delta = _mm_set1_epi16(128), round = _mm_set1_epi32(1 << 13);
+	int x = 0;
+
+	for (; x <= n - 16; x += 16) {
+		__m128i p[3], out[3];
+		load16(src + x * 3, 3, p);
+
+		__m128i b[2], g[2], r[2];
+		for (int h = 0; h < 2; h++) {
+			__m128i y = h == 0 ? _mm_unpacklo_epi8(p[0], zero) : _mm_unpackhi_epi8(p[0], zero);
+			__m128i dcr = _mm_sub_epi16(h == 0 ? _mm_unpacklo_epi8(p[1], zero) : _mm_unpackhi_epi8(p[1], zero), delta);
+			__m128i dcb = _mm_sub_epi16(h == 0 ? _mm_unpacklo_epi8(p[2], zero) : _mm_unpackhi_epi8(p[2], zero), delta);
+
+			b[h] = _mm_add_epi16(y, descaleMul8(dcb, cb));
+			r[h] = _mm_add_epi16(y, descaleMul8(dcr, cr));
+			__m128i g0 = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(dcb, dcr), cg), round);
+			__m128i g1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(dcb, dcr), cg), round);
+			g[h] = _mm_add_epi16(y, _mm_packs_epi32(_mm_srai_epi32(g0, 14), _mm_srai_epi32(g1, 14)));
+		}
+
+		out[bidx] = _mm_packus_epi16(b[0], b[1]);
+		out[1] = _mm_packus_epi16(g[0], g[1]);
+		out[bidx ^ 2] = _mm_packus_epi16(r[0], r[1]);
+		store16(dst + x * dcn, dcn, out);
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+#endif // FBC_CPU_X86
+
+int cvtBGRtoYCrCb8u(const uchar* src, uchar* dst, int n, int scn, int bidx, const int* coeffs)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::cvtBGRtoYCrCb8u(src, dst, n, scn, bidx, coeffs);
+#endif
+	return 0;
+}
+
+int cvtBGRtoGray8u(const uchar* src, uchar* dst, int n, int scn, const int* coeffs)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::cvtBGRtoGray8u(src, dst, n, scn, coeffs);
+#endif
+	return 0;
+}
+
+int cvtYCrCbtoBGR8u(const uchar* src, uchar* dst, int n, int dcn, int bidx, const int* coeffs)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::cvtYCrCbtoBGR8u(src, dst, n, dcn, bidx, coeffs);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
@@ -2,37 +2,366 @@
 // Email: fengbingchun@163.com
 
 // reference: modules/core/src/alloc.cpp
+//            modules/core/src/matrix.cpp (MatAllocator)
 
 #include <malloc.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
 #include "core/fbcstd.hpp"
 #include "core/interface.hpp"
 #include "core/utility.hpp"
 #include "core/base.hpp"
+#include "core/mat.hpp"
 
 namespace fbc {
 
-// Allocates an aligned memory buffer
-void* fastMalloc(size_t size)
+// every buffer returned by fastMalloc/scratchMalloc is preceded by this header,
+// its size is a multiple of FBC_MALLOC_ALIGN so the user pointer keeps the alignment
+struct BufferHeader {
+	uchar* udata; // pointer returned by malloc
+	size_t size; // requested size
+	int cls; // size class, -1: not pooled
+	int magic;
+	size_t reserved;
+};
+
+#define FBC_BUFFER_MAGIC 0x4642434d
+static const size_t header_size = alignSize(sizeof(BufferHeader), FBC_MALLOC_ALIGN);
+
+// size classes: 4 classes per power of two, from FBC_POOL_MIN_SIZE up to 1GB
+static const int pool_min_shift = 10;
+static const int pool_max_shift = 30;
+static const int pool_num_classes = (pool_max_shift - pool_min_shift + 1) * 4;
+// buffers up to this size are kept in the per-thread caches, bigger ones go to the shared pool directly
+static const size_t thread_cache_max_size = 256 * 1024;
+static const int thread_cache_max_count = 8;
+
+static int sizeToClass(size_t size)
+{
+	if (size < FBC_POOL_MIN_SIZE || size > ((size_t)1 << pool_max_shift))
+		return -1;
+
+	if (size == FBC_POOL_MIN_SIZE)
+		return 0;
+
+	// size is in ((1 << shift), (1 << (shift + 1))], the range is split into 4 classes
+	int shift = pool_min_shift;
+	while (((size_t)1 << (shift + 1)) < size)
+		shift++;
+	size_t step = (size_t)1 << (shift - 2);
+	int sub = (int)((size - ((size_t)1 << shift) + step - 1) / step); // 1..4
+
+	return (shift - pool_min_shift) * 4 + sub - 1;
+}
+
+static size_t classToSize(int cls)
+{
+	int shift = pool_min_shift + cls / 4;
+	int sub = cls % 4 + 1;
+	return ((size_t)1 << shift) + (size_t)sub * ((size_t)1 << (shift - 2));
+}
+
+static std::atomic<size_t> stat_bytes_live{ 0 };
+static std::atomic<size_t> stat_peak_bytes_live{ 0 };
+static std::atomic<size_t> stat_bytes_cached{ 0 };
+static std::atomic<uint64> stat_pool_hits{ 0 };
+static std::atomic<uint64> stat_pool_misses{ 0 };
+static std::atomic<uint64> stat_scratch_hits{ 0 };
+
+static bool readPoolEnabled()
 {
-	uchar* udata = (uchar*)malloc(size + sizeof(void*) + FBC_MALLOC_ALIGN);
+	const char* env = getenv("FBC_BUFFER_POOL");
+	return !(env && atoi(env) == 0);
+}
+
+static size_t readPoolLimit()
+{
+	const char* env = getenv("FBC_BUFFER_POOL_LIMIT");
+	if (env && env[0] != '\0')
+		return (size_t)atol(env) * 1024 * 1024;
+	return (size_t)256 * 1024 * 1024;
+}
+
+static std::atomic<bool> pool_enabled{ readPoolEnabled() };
+static std::atomic<size_t> pool_limit{ readPoolLimit() };
+
+static void onAllocate(size_t size)
+{
+	size_t live = stat_bytes_live.fetch_add(size) + size;
+	size_t peak = stat_peak_bytes_live.load();
+	while (live > peak && !stat_peak_bytes_live.compare_exchange_weak(peak, live)) {}
+}
+
+// shared pool of free buffers, one list (and one lock) per size class
+class BufferPool {
+public:
+	void* get(int cls)
+	{
+		Bucket& b = buckets[cls];
+		std::lock_guard<std::mutex> lock(b.mutex);
+		if (!b.head)
+			return NULL;
+
+		FreeBlock* block = b.head;
+		b.head = block->next;
+		stat_bytes_cached -= classToSize(cls);
+		return block;
+	}
+
+	// returns false when the pool is full, the caller frees the buffer then
+	bool put(int cls, void* ptr)
+	{
+		size_t size = classToSize(cls);
+		if (stat_bytes_cached.load() + size > pool_limit.load())
+			return false;
+
+		Bucket& b = buckets[cls];
+		std::lock_guard<std::mutex> lock(b.mutex);
+		FreeBlock* block = (FreeBlock*)ptr;
+		block->next = b.head;
+		b.head = block;
+		stat_bytes_cached += size;
+		return true;
+	}
+
+	void release()
+	{
+		for (int cls = 0; cls < pool_num_classes; cls++) {
+			Bucket& b = buckets[cls];
+			std::lock_guard<std::mutex> lock(b.mutex);
+			while (b.head) {
+				FreeBlock* block = b.head;
+				b.head = block->next;
+				stat_bytes_cached -= classToSize(cls);
+				free(((BufferHeader*)((uchar*)block - header_size))->udata);
+			}
+		}
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct Bucket {
+		std::mutex mutex;
+		FreeBlock* head = NULL;
+	};
+
+	Bucket buckets[pool_num_classes];
+};
+
+// never destroyed: buffers can be freed from static destructors
+static BufferPool& getBufferPool()
+{
+	static BufferPool* pool = new BufferPool();
+	return *pool;
+}
+
+// lock-free per-thread cache of small and medium buffers
+struct ThreadCache {
+	void* blocks[pool_num_classes][thread_cache_max_count];
+	int count[pool_num_classes];
+
+	ThreadCache() { memset(count, 0, sizeof(count)); }
+
+	void flush()
+	{
+		for (int cls = 0; cls < pool_num_classes; cls++) {
+			for (int i = 0; i < count[cls]; i++) {
+				stat_bytes_cached -= classToSize(cls);
+				if (!getBufferPool().put(cls, blocks[cls][i]))
+					free(((BufferHeader*)((uchar*)blocks[cls][i] - header_size))->udata);
+			}
+			count[cls] = 0;
+		}
+	}
+};
+
+static thread_local ThreadCache* tls_cache = NULL;
+static thread_local bool tls_cache_destroyed = false;
+
+struct ThreadCacheGuard {
+	~ThreadCacheGuard()
+	{
+		if (tls_cache) {
+			tls_cache->flush();
+			delete tls_cache;
+			tls_cache = NULL;
+		}
+		tls_cache_destroyed = true;
+	}
+};
+
+static thread_local ThreadCacheGuard tls_cache_guard;
+
+static ThreadCache* getThreadCache()
+{
+	if (!tls_cache && !tls_cache_destroyed) {
+		(void)&tls_cache_guard; // registers the destructor of the cache for this thread
+		tls_cache = new ThreadCache();
+	}
+	return tls_cache;
+}
+
+static void* bufferAlloc(size_t size, bool scratch)
+{
+	int cls = pool_enabled.load(std::memory_order_relaxed) ? sizeToClass(size) : -1;
+	void* ptr = NULL;
+
+	if (cls >= 0) {
+		if (scratch && classToSize(cls) <= thread_cache_max_size) {
+			ThreadCache* cache = getThreadCache();
+			if (cache && cache->count[cls] > 0) {
+				ptr = cache->blocks[cls][--cache->count[cls]];
+				stat_bytes_cached -= classToSize(cls);
+				stat_scratch_hits++;
+			}
+		}
+		if (!ptr) {
+			ptr = getBufferPool().get(cls);
+			if (ptr)
+				stat_pool_hits++;
+			else
+				stat_pool_misses++;
+		}
+	}
+
+	if (ptr) {
+		BufferHeader* header = (BufferHeader*)((uchar*)ptr - header_size);
+		header->size = size;
+		onAllocate(size);
+		return ptr;
+	}
+
+	size_t capacity = cls >= 0 ? classToSize(cls) : size;
+	uchar* udata = (uchar*)malloc(capacity + header_size + FBC_MALLOC_ALIGN);
 	if (!udata) {
 		fprintf(stderr, "failed to allocate %lu bytes\n", (unsigned long)size);
 		return NULL;
 	}
-	uchar** adata = alignPtr((uchar**)udata + 1, FBC_MALLOC_ALIGN);
-	adata[-1] = udata;
+
+	uchar* adata = alignPtr(udata + header_size, FBC_MALLOC_ALIGN);
+	BufferHeader* header = (BufferHeader*)(adata - header_size);
+	header->udata = udata;
+	header->size = size;
+	header->cls = cls;
+	header->magic = FBC_BUFFER_MAGIC;
+	onAllocate(size);
+
 	return adata;
 }
 
+static void bufferFree(void* ptr, bool scratch)
+{
+	if (!ptr)
+		return;
+
+	BufferHeader* header = (BufferHeader*)((uchar*)ptr - header_size);
+	FBC_Assert(header->magic == FBC_BUFFER_MAGIC && header->udata < (uchar*)ptr);
+	stat_bytes_live -= header->size;
+
+	int cls = header->cls;
+	if (cls >= 0 && pool_enabled.load(std::memory_order_relaxed)) {
+		size_t size = classToSize(cls);
+		if (scratch && size <= thread_cache_max_size) {
+			ThreadCache* cache = getThreadCache();
+			if (cache && cache->count[cls] < thread_cache_max_count && stat_bytes_cached.load() + size <= pool_limit.load()) {
+				cache->blocks[cls][cache->count[cls]++] = ptr;
+				stat_bytes_cached += size;
+				return;
+			}
+		}
+		if (getBufferPool().put(cls, ptr))
+			return;
+	}
+
+	free(header->udata);
+}
+
+// Allocates an aligned memory buffer
+void* fastMalloc(size_t size)
+{
+	return bufferAlloc(size, false);
+}
+
 // Deallocates a memory buffer
 void fastFree(void* ptr)
 {
-	if (ptr) {
-		uchar* udata = ((uchar**)ptr)[-1];
-		FBC_Assert(udata < (uchar*)ptr && ((uchar*)ptr - udata) <= (ptrdiff_t)(sizeof(void*) + FBC_MALLOC_ALIGN));
-		free(udata);
+	bufferFree(ptr, false);
+}
+
+void* scratchMalloc(size_t size)
+{
+	return bufferAlloc(size, true);
+}
+
+void scratchFree(void* ptr)
+{
+	bufferFree(ptr, true);
+}
+
+MemoryStats getMemoryStats()
+{
+	MemoryStats stats;
+	stats.bytesLive = stat_bytes_live.load();
+	stats.peakBytesLive = stat_peak_bytes_live.load();
+	stats.bytesCached = stat_bytes_cached.load();
+	stats.poolHits = stat_pool_hits.load();
+	stats.poolMisses = stat_pool_misses.load();
+	stats.scratchHits = stat_scratch_hits.load();
+
+	return stats;
+}
+
+void resetMemoryStats()
+{
+	stat_peak_bytes_live = stat_bytes_live.load();
+	stat_pool_hits = 0;
+	stat_pool_misses = 0;
+	stat_scratch_hits = 0;
+}
+
+void setBufferPoolEnabled(bool enabled)
+{
+	pool_enabled = enabled;
+	if (!enabled)
+		releaseBufferPool();
+}
+
+bool isBufferPoolEnabled()
+{
+	return pool_enabled.load();
+}
+
+void setBufferPoolLimit(size_t bytes)
+{
+	pool_limit = bytes;
+	if (stat_bytes_cached.load() > bytes)
+		releaseBufferPool();
+}
+
+size_t getBufferPoolLimit()
+{
+	return pool_limit.load();
+}
+
+void releaseBufferPool()
+{
+	ThreadCache* cache = tls_cache;
+	if (cache) {
+		for (int cls = 0; cls < pool_num_classes; cls++) {
+			for (int i = 0; i < cache->count[cls]; i++) {
+				stat_bytes_cached -= classToSize(cls);
+				free(((BufferHeader*)((uchar*)cache->blocks[cls][i] - header_size))->udata);
+			}
+			cache->count[cls] = 0;
+		}
 	}
+
+	getBufferPool().release();
 }
 
 void* cvAlloc(size_t size)
@@ -45,4 +374,32 @@ void cvFree_(void* ptr)
 	fastFree(ptr);
 }
 
+MatAllocator::~MatAllocator() {}
+
+// the default allocator, fastMalloc/fastFree
+class StdMatAllocator : public MatAllocator {
+public:
+	void* allocate(size_t size) { return fastMalloc(size); }
+	void deallocate(void* ptr, size_t) { fastFree(ptr); }
+};
+
+static std::atomic<MatAllocator*> default_allocator{ NULL };
+
+MatAllocator* getStdAllocator()
+{
+	static StdMatAllocator* allocator = new StdMatAllocator();
+	return allocator;
+}
+
+MatAllocator* getDefaultAllocator()
+{
+	MatAllocator* allocator = default_allocator.load();
+	return allocator ? allocator : getStdAllocator();
+}
+
+void setDefaultAllocator(MatAllocator* allocator)
+{
+	default_allocator = allocator;
+}
+
 } // namespace fbc
@@ -0,0 +1,381 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/imgproc/src/filter.cpp
+              modules/imgproc/src/smooth.cpp
+              modules/imgproc/src/sumpixels.cpp
+*/
+
+// SSE4.1/AVX2 kernels of the linear filters, the box filter and the integral image, selected at runtime by
+// checkHardwareSupport(). The row kernels and the integral are integer code with the results of the plain C++ code.
+// The 8-bit column kernels compute like the SSE2 code of OpenCV: the int sums are converted to float, multiplied
+// by the float coefficients in the same order (no FMA) and rounded to nearest even, the plain C++ code of the filters
+// only finishes the last (less than 4) elements of a row with the fixed-point arithmetic, as OpenCV does
+
+#include <stdlib.h>
+#include <string.h>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+	#define FBC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define FBC_TARGET_SSE4_1
+	#define FBC_TARGET_AVX2
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+// the terms of a row filter: the element at offset ofs0 (ofs1 < 0) or the sum/difference of the elements at ofs0 and
+// ofs1, the coefficients of two consecutive terms are packed in one int for pmaddwd
+struct SepFilterRowTerms {
+	enum { MAX_TERMS = 64 };
+
+	int n;
+	int ofs0[MAX_TERMS + 1];
+	int ofs1[MAX_TERMS + 1];
+	int coeffs[MAX_TERMS / 2 + 1];
+
+	// returns false when the kernel has too many taps or a coefficient doesn't fit in a short
+	bool init(int cn, const int* kx, int ksize, int symmetry)
+	{
+		if (ksize > MAX_TERMS)
+			return false;
+
+		int k[MAX_TERMS + 1];
+		n = 0;
+		if (symmetry != 0 && ksize % 2 == 1) {
+			int ksize2 = ksize / 2;
+			ofs0[n] = ksize2 * cn; ofs1[n] = -1; k[n++] = kx[ksize2];
+			for (int j = 1; j <= ksize2; j++) {
+				// symmetry > 0: S[j] + S[-j], symmetry < 0: S[j] - S[-j]
+				ofs0[n] = (ksize2 + j) * cn; ofs1[n] = (ksize2 - j) * cn; k[n++] = kx[ksize2 + j];
+			}
+		} else {
+			for (int j = 0; j < ksize; j++) {
+				ofs0[n] = j * cn; ofs1[n] = -1; k[n++] = kx[j];
+			}
+		}
+
+		ofs0[n] = ofs0[0]; ofs1[n] = -1; k[n] = 0; // the pair of an odd last term
+		for (int j = 0; j < n; j += 2) {
+			if (abs(k[j]) > 32767 || abs(k[j + 1]) > 32767)
+				return false;
+			coeffs[j / 2] = (k[j] & 0xffff) | (k[j + 1] << 16);
+		}
+
+		return true;
+	}
+};
+
+namespace opt_SSE4_1 {
+
+// 8 terms of the row filter as shorts
+FBC_TARGET_SSE4_1 static inline __m128i sepFilterRowTerm8(const uchar* S, const SepFilterRowTerms& t, int j, int symmetry)
+{
+	__m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(S + t.ofs0[j])));
+	if (t.ofs1[j] < 0)
+		return a;
+	__m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(S + t.ofs1[j])));
+	return symmetry > 0 ? _mm_add_epi16(a, b) : _mm_sub_epi16(a, b);
+}
+
+FBC_TARGET_SSE4_1 static int sepFilterRow8u32s(const uchar* src, int* dst, int width, int cn, const int* kx, int ksize, int symmetry)
+{
+	SepFilterRowTerms t;
+	if (!t.init(cn, kx, ksize, symmetry))
+		return 0;
+
+	int i = 0;
+	for (; i <= width - 8; i += 8) {
+		const uchar* S = src + i;
+		__m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+		for (int j = 0; j < t.n; j += 2) {
+			__m128i a = sepFilterRowTerm8(S, t, j, symmetry);
+			__m128i b = j + 1 < t.n ? sepFilterRowTerm8(S, t, j + 1, symmetry) : _mm_setzero_si128();
+			__m128i k = _mm_set1_epi32(t.coeffs[j / 2]);
+			s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), k));
+			s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), k));
+		}
+		_mm_storeu_si128((__m128i*)(dst + i), s0);
+		_mm_storeu_si128((__m128i*)(dst + i + 4), s1);
+	}
+
+	return i;
+}
+
+// 4 results of the column filter, the sums of the rows are converted to float
+FBC_TARGET_SSE4_1 static inline __m128i sepFilterColumn4(const int** src, int i, const float* ky, int ksize2, __m128 d4, bool symmetrical)
+{
+	__m128 s0;
+	if (symmetrical) {
+		s0 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src[0] + i))), _mm_set1_ps(ky[0])), d4);
+		for (int k = 1; k <= ksize2; k++) {
+			__m128i x0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(src[k] + i)), _mm_loadu_si128((const __m128i*)(src[-k] + i)));
+			s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_cvtepi32_ps(x0), _mm_set1_ps(ky[k])));
+		}
+	} else {
+		s0 = d4;
+		for (int k = 1; k <= ksize2; k++) {
+			__m128i x0 = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(src[k] + i)), _mm_loadu_si128((const __m128i*)(src[-k] + i)));
+			s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_cvtepi32_ps(x0), _mm_set1_ps(ky[k])));
+		}
+	}
+
+	return _mm_cvtps_epi32(s0);
+}
+
+FBC_TARGET_SSE4_1 static int sepFilterColumn32s8u(const int** src, uchar* dst, int width, const float* ky, int ksize2, float delta, bool symmetrical)
+{
+	__m128 d4 = _mm_set1_ps(delta);
+	int i = 0;
+
+	for (; i <= width - 16; i += 16) {
+		__m128i x0 = _mm_packs_epi32(sepFilterColumn4(src, i, ky, ksize2, d4, symmetrical), sepFilterColumn4(src, i + 4, ky, ksize2, d4, symmetrical));
+		__m128i x1 = _mm_packs_epi32(sepFilterColumn4(src, i + 8, ky, ksize2, d4, symmetrical), sepFilterColumn4(src, i + 12, ky, ksize2, d4, symmetrical));
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(x0, x1));
+	}
+
+	for (; i <= width - 4; i += 4) {
+		__m128i x0 = _mm_packs_epi32(sepFilterColumn4(src, i, ky, ksize2, d4, symmetrical), _mm_setzero_si128());
+		int d = _mm_cvtsi128_si32(_mm_packus_epi16(x0, x0));
+		memcpy(dst + i, &d, sizeof(d)); // dst + i is not aligned to int
+	}
+
+	return i;
+}
+
+FBC_TARGET_SSE4_1 static int boxFilterColumn32s8u(const int* Sp, const int* Sm, int* sum, uchar* dst, int width, double scale)
+{
+	int i = 0;
+
+	if (scale != 1) {
+		__m128 scale4 = _mm_set1_ps((float)scale);
+		for (; i <= width - 8; i += 8) {
+			__m128i s0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i)), _mm_loadu_si128((const __m128i*)(Sp + i)));
+			__m128i s1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i + 4)), _mm_loadu_si128((const __m128i*)(Sp + i + 4)));
+			__m128i d0 = _mm_cvtps_epi32(_mm_mul_ps(scale4, _mm_cvtepi32_ps(s0)));
+			__m128i d1 = _mm_cvtps_epi32(_mm_mul_ps(scale4, _mm_cvtepi32_ps(s1)));
+			d0 = _mm_packs_epi32(d0, d1);
+			_mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(d0, d0));
+			_mm_storeu_si128((__m128i*)(sum + i), _mm_sub_epi32(s0, _mm_loadu_si128((const __m128i*)(Sm + i))));
+			_mm_storeu_si128((__m128i*)(sum + i + 4), _mm_sub_epi32(s1, _mm_loadu_si128((const __m128i*)(Sm + i + 4))));
+		}
+	} else {
+		for (; i <= width - 8; i += 8) {
+			__m128i s0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i)), _mm_loadu_si128((const __m128i*)(Sp + i)));
+			__m128i s1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(sum + i + 4)), _mm_loadu_si128((const __m128i*)(Sp + i + 4)));
+			__m128i d0 = _mm_packs_epi32(s0, s1);
+			_mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(d0, d0));
+			_mm_storeu_si128((__m128i*)(sum + i), _mm_sub_epi32(s0, _mm_loadu_si128((const __m128i*)(Sm + i))));
+			_mm_storeu_si128((__m128i*)(sum + i + 4), _mm_sub_epi32(s1, _mm_loadu_si128((const __m128i*)(Sm + i + 4))));
+		}
+	}
+
+	return i;
+}
+
+// one row of the integral of a single-channel image: the prefix sums of 16 pixels are computed with shifts inside
+// the register, the running sum of the row is carried in the last lane
+FBC_TARGET_SSE4_1 static int integralRow8u32s(const uchar* src, const int* prev, int* sum, int width)
+{
+	__m128i s = _mm_setzero_si128(), zero = _mm_setzero_si128();
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i w0 = _mm_unpacklo_epi8(v, zero), w1 = _mm_unpackhi_epi8(v, zero);
+		// prefix sums of 8 shorts (at most 8 * 255)
+		w0 = _mm_add_epi16(w0, _mm_slli_si128(w0, 2)); w1 = _mm_add_epi16(w1, _mm_slli_si128(w1, 2));
+		w0 = _mm_add_epi16(w0, _mm_slli_si128(w0, 4)); w1 = _mm_add_epi16(w1, _mm_slli_si128(w1, 4));
+		w0 = _mm_add_epi16(w0, _mm_slli_si128(w0, 8)); w1 = _mm_add_epi16(w1, _mm_slli_si128(w1, 8));
+
+		__m128i p0 = _mm_add_epi32(_mm_cvtepu16_epi32(w0), s);
+		__m128i p1 = _mm_add_epi32(_mm_unpackhi_epi16(w0, zero), s);
+		s = _mm_shuffle_epi32(p1, 0xff);
+		__m128i p2 = _mm_add_epi32(_mm_cvtepu16_epi32(w1), s);
+		__m128i p3 = _mm_add_epi32(_mm_unpackhi_epi16(w1, zero), s);
+		s = _mm_shuffle_epi32(p3, 0xff);
+
+		_mm_storeu_si128((__m128i*)(sum + x), _mm_add_epi32(p0, _mm_loadu_si128((const __m128i*)(prev + x))));
+		_mm_storeu_si128((__m128i*)(sum + x + 4), _mm_add_epi32(p1, _mm_loadu_si128((const __m128i*)(prev + x + 4))));
+		_mm_storeu_si128((__m128i*)(sum + x + 8), _mm_add_epi32(p2, _mm_loadu_si128((const __m128i*)(prev + x + 8))));
+		_mm_storeu_si128((__m128i*)(sum + x + 12), _mm_add_epi32(p3, _mm_loadu_si128((const __m128i*)(prev + x + 12))));
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+namespace opt_AVX2 {
+
+// 16 terms of the row filter as shorts
+FBC_TARGET_AVX2 static inline __m256i sepFilterRowTerm16(const uchar* S, const SepFilterRowTerms& t, int j, int symmetry)
+{
+	__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(S + t.ofs0[j])));
+	if (t.ofs1[j] < 0)
+		return a;
+	__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(S + t.ofs1[j])));
+	return symmetry > 0 ? _mm256_add_epi16(a, b) : _mm256_sub_epi16(a, b);
+}
+
+FBC_TARGET_AVX2 static int sepFilterRow8u32s(const uchar* src, int* dst, int width, int cn, const int* kx, int ksize, int symmetry)
+{
+	SepFilterRowTerms t;
+	if (!t.init(cn, kx, ksize, symmetry))
+		return 0;
+
+	int i = 0;
+	for (; i <= width - 16; i += 16) {
+		const uchar* S = src + i;
+		__m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+		for (int j = 0; j < t.n; j += 2) {
+			__m256i a = sepFilterRowTerm16(S, t, j, symmetry);
+			__m256i b = j + 1 < t.n ? sepFilterRowTerm16(S, t, j + 1, symmetry) : _mm256_setzero_si256();
+			__m256i k = _mm256_set1_epi32(t.coeffs[j / 2]);
+			// lanes: s0 = [0..3, 8..11], s1 = [4..7, 12..15]
+			s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), k));
+			s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), k));
+		}
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute2x128_si256(s0, s1, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_permute2x128_si256(s0, s1, 0x31));
+	}
+
+	return i + opt_SSE4_1::sepFilterRow8u32s(src + i, dst + i, width - i, cn, kx, ksize, symmetry);
+}
+
+FBC_TARGET_AVX2 static inline __m256i sepFilterColumn8(const int** src, int i, const float* ky, int ksize2, __m256 d8, bool symmetrical)
+{
+	__m256 s0;
+	if (symmetrical) {
+		s0 = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(src[0] + i))), _mm256_set1_ps(ky[0])), d8);
+		for (int k = 1; k <= ksize2; k++) {
+			__m256i x0 = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(src[k] + i)), _mm256_loadu_si256((const __m256i*)(src[-k] + i)));
+			s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_cvtepi32_ps(x0), _mm256_set1_ps(ky[k])));
+		}
+	} else {
+		s0 = d8;
+		for (int k = 1; k <= ksize2; k++) {
+			__m256i x0 = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(src[k] + i)), _mm256_loadu_si256((const __m256i*)(src[-k] + i)));
+			s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_cvtepi32_ps(x0), _mm256_set1_ps(ky[k])));
+		}
+	}
+
+	return _mm256_cvtps_epi32(s0);
+}
+
+FBC_TARGET_AVX2 static int sepFilterColumn32s8u(const int** src, uchar* dst, int width, const float* ky, int ksize2, float delta, bool symmetrical)
+{
+	__m256 d8 = _mm256_set1_ps(delta);
+	int i = 0;
+
+	for (; i <= width - 32; i += 32) {
+		__m256i x0 = _mm256_packs_epi32(sepFilterColumn8(src, i, ky, ksize2, d8, symmetrical), sepFilterColumn8(src, i + 8, ky, ksize2, d8, symmetrical));
+		__m256i x1 = _mm256_packs_epi32(sepFilterColumn8(src, i + 16, ky, ksize2, d8, symmetrical), sepFilterColumn8(src, i + 24, ky, ksize2, d8, symmetrical));
+		// the packs work inside the 128-bit lanes, the groups of 4 bytes are 0 8 16 24 | 4 12 20 28
+		__m256i d = _mm256_packus_epi16(x0, x1);
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_permutevar8x32_epi32(d, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+	}
+
+	for (; i <= width - 8; i += 8) {
+		__m256i x0 = sepFilterColumn8(src, i, ky, ksize2, d8, symmetrical);
+		__m128i d = _mm_packs_epi32(_mm256_castsi256_si128(x0), _mm256_extracti128_si256(x0, 1));
+		_mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(d, d));
+	}
+
+	for (; i <= width - 4; i += 4) {
+		__m128i x0 = _mm_packs_epi32(opt_SSE4_1::sepFilterColumn4(src, i, ky, ksize2, _mm256_castps256_ps128(d8), symmetrical), _mm_setzero_si128());
+		int d = _mm_cvtsi128_si32(_mm_packus_epi16(x0, x0));
+		memcpy(dst + i, &d, sizeof(d)); // dst + i is not aligned to int
+	}
+
+	return i;
+}
+
+FBC_TARGET_AVX2 static int boxFilterColumn32s8u(const int* Sp, const int* Sm, int* sum, uchar* dst, int width, double scale)
+{
+	int i = 0;
+
+	if (scale != 1) {
+		__m256 scale8 = _mm256_set1_ps((float)scale);
+		for (; i <= width - 16; i += 16) {
+			__m256i s0 = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(sum + i)), _mm256_loadu_si256((const __m256i*)(Sp + i)));
+			__m256i s1 = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(sum + i + 8)), _mm256_loadu_si256((const __m256i*)(Sp + i + 8)));
+			__m256i d0 = _mm256_cvtps_epi32(_mm256_mul_ps(scale8, _mm256_cvtepi32_ps(s0)));
+			__m256i d1 = _mm256_cvtps_epi32(_mm256_mul_ps(scale8, _mm256_cvtepi32_ps(s1)));
+			d0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d0, d1), 0xd8);
+			__m256i d = _mm256_packus_epi16(d0, d0);
+			_mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(d, 0x08)));
+			_mm256_storeu_si256((__m256i*)(sum + i), _mm256_sub_epi32(s0, _mm256_loadu_si256((const __m256i*)(Sm + i))));
+			_mm256_storeu_si256((__m256i*)(sum + i + 8), _mm256_sub_epi32(s1, _mm256_loadu_si256((const __m256i*)(Sm + i + 8))));
+		}
+	} else {
+		for (; i <= width - 16; i += 16) {
+			__m256i s0 = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(sum + i)), _mm256_loadu_si256((const __m256i*)(Sp + i)));
+			__m256i s1 = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(sum + i + 8)), _mm256_loadu_si256((const __m256i*)(Sp + i + 8)));
+			__m256i d0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(s0, s1), 0xd8);
+			__m256i d = _mm256_packus_epi16(d0, d0);
+			_mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(_mm256_permute4x64_epi64(d, 0x08)));
+			_mm256_storeu_si256((__m256i*)(sum + i), _mm256_sub_epi32(s0, _mm256_loadu_si256((const __m256i*)(Sm + i))));
+			_mm256_storeu_si256((__m256i*)(sum + i + 8), _mm256_sub_epi32(s1, _mm256_loadu_si256((const __m256i*)(Sm + i + 8))));
+		}
+	}
+
+	return i + opt_SSE4_1::boxFilterColumn32s8u(Sp + i, Sm + i, sum + i, dst + i, width - i, scale);
+}
+
+} // namespace opt_AVX2
+
+#endif // FBC_CPU_X86
+
+int sepFilterRow8u32s(const uchar* src, int* dst, int width, int cn, const int* kx, int ksize, int symmetry)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::sepFilterRow8u32s(src, dst, width, cn, kx, ksize, symmetry);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::sepFilterRow8u32s(src, dst, width, cn, kx, ksize, symmetry);
+#endif
+	return 0;
+}
+
+int sepFilterColumn32s8u(const int** src, uchar* dst, int width, const float* ky, int ksize2, float delta, bool symmetrical)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::sepFilterColumn32s8u(src, dst, width, ky, ksize2, delta, symmetrical);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::sepFilterColumn32s8u(src, dst, width, ky, ksize2, delta, symmetrical);
+#endif
+	return 0;
+}
+
+int boxFilterColumn32s8u(const int* Sp, const int* Sm, int* sum, uchar* dst, int width, double scale)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::boxFilterColumn32s8u(Sp, Sm, sum, dst, width, scale);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::boxFilterColumn32s8u(Sp, Sm, sum, dst, width, scale);
+#endif
+	return 0;
+}
+
+int integralRow8u32s(const uchar* src, const int* prev, int* sum, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::integralRow8u32s(src, prev, sum, width);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
@@ -1195,9 +1195,23 @@ split_(const T* src, T** dst, int len, int cn)
 	}
 }
 
+// finishes the rows of the optimized kernels from the element x
+template<typename T> static void
+splitTail_(const T* src, T** dst, int x, int len, int cn)
+{
+	if (x == 0) {
+		split_(src, dst, len, cn);
+	} else if (x < len) {
+		T* dst_[FBC_CN_MAX];
+		for (int k = 0; k < cn; k++)
+			dst_[k] = dst[k] + x;
+		split_(src + x * cn, dst_, len - x, cn);
+	}
+}
+
 void split8u(const uchar* src, uchar** dst, int len, int cn)
 {
-	split_(src, dst, len, cn);
+	splitTail_(src, dst, splitVec8u(src, dst, len, cn), len, cn);
 }
 
 void split16u(const ushort* src, ushort** dst, int len, int cn)
@@ -1207,7 +1221,7 @@ void split16u(const ushort* src, ushort** dst, int len, int cn)
 
 void split32s(const int* src, int** dst, int len, int cn)
 {
-	split_(src, dst, len, cn);
+	splitTail_(src, dst, splitVec32s(src, dst, len, cn), len, cn);
 }
 
 void split64s(const int64* src, int64** dst, int len, int cn)
@@ -1260,9 +1274,22 @@ merge_(const T** src, T* dst, int len, int cn)
 	}
 }
 
+template<typename T> static void
+mergeTail_(const T** src, T* dst, int x, int len, int cn)
+{
+	if (x == 0) {
+		merge_(src, dst, len, cn);
+	} else if (x < len) {
+		const T* src_[FBC_CN_MAX];
+		for (int k = 0; k < cn; k++)
+			src_[k] = src[k] + x;
+		merge_(src_, dst + x * cn, len - x, cn);
+	}
+}
+
 void merge8u(const uchar** src, uchar* dst, int len, int cn)
 {
-	merge_(src, dst, len, cn);
+	mergeTail_(src, dst, mergeVec8u(src, dst, len, cn), len, cn);
 }
 
 void merge16u(const ushort** src, ushort* dst, int len, int cn)
@@ -1272,7 +1299,7 @@ void merge16u(const ushort** src, ushort* dst, int len, int cn)
 
 void merge32s(const int** src, int* dst, int len, int cn)
 {
-	merge_(src, dst, len, cn);
+	mergeTail_(src, dst, mergeVec32s(src, dst, len, cn), len, cn);
 }
 
 void merge64s(const int64** src, int64* dst, int len, int cn)
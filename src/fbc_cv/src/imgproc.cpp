@@ -8,6 +8,7 @@
 
 /* reference: include/opencv2/imgproc.hpp
               modules/imgproc/src/morph.cpp
+              modules/imgproc/src/smooth.cpp
 */
 
 namespace fbc {
@@ -241,6 +242,40 @@ static const int optimalDFTSizeTab[] = {
 	2097152000, 2099520000, 2109375000, 2123366400, 2125764000
 };
 
+int getGaussianKernel(Mat_<float, 1>& dst, int n, double sigma)
+{
+	const int SMALL_GAUSSIAN_SIZE = 7;
+	static const float small_gaussian_tab[][SMALL_GAUSSIAN_SIZE] = {
+		{ 1.f },
+		{ 0.25f, 0.5f, 0.25f },
+		{ 0.0625f, 0.25f, 0.375f, 0.25f, 0.0625f },
+		{ 0.03125f, 0.109375f, 0.21875f, 0.28125f, 0.21875f, 0.109375f, 0.03125f }
+	};
+
+	FBC_Assert(n > 0);
+	const float* fixed_kernel = n % 2 == 1 && n <= SMALL_GAUSSIAN_SIZE && sigma <= 0 ? small_gaussian_tab[n >> 1] : 0;
+
+	dst = Mat_<float, 1>(n, 1);
+	float* cf = (float*)dst.ptr(0);
+
+	double sigmaX = sigma > 0 ? sigma : ((n - 1)*0.5 - 1)*0.3 + 0.8;
+	double scale2X = -0.5 / (sigmaX*sigmaX);
+	double sum = 0;
+
+	for (int i = 0; i < n; i++) {
+		double x = i - (n - 1)*0.5;
+		double t = fixed_kernel ? (double)fixed_kernel[i] : std::exp(scale2X*x*x);
+		cf[i] = (float)t;
+		sum += cf[i];
+	}
+
+	sum = 1. / sum;
+	for (int i = 0; i < n; i++)
+		cf[i] = (float)(cf[i] * sum);
+
+	return 0;
+}
+
 int getOptimalDFTSize(int size0)
 {
 	int a = 0, b = sizeof(optimalDFTSizeTab) / sizeof(optimalDFTSizeTab[0]) - 1;
@@ -0,0 +1,261 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/core/src/convert.cpp
+*/
+
+// AVX2 kernels of LUT and Lut3D, selected at runtime by checkHardwareSupport(); the table entries are read by gathers
+// and combined with the integer arithmetic of the plain C++ code in lut.hpp, so the results are the same
+
+#include <string.h>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#include "lut.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define FBC_TARGET_AVX2
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_AVX2 {
+
+// 24 elements per iteration (a multiple of 1, 2, 3 and 4 channels): the table index of element k of a table per
+// channel is src[k] * cn + k % cn
+static FBC_TARGET_AVX2 int LUT8u(const uchar* src, uchar* dst, int n, const int* lut32, int cn)
+{
+	__m256i ofs[3];
+	for (int v = 0; v < 3; v++) {
+		int o[8];
+		for (int k = 0; k < 8; k++)
+			o[k] = cn == 1 ? 0 : (v * 8 + k) % cn;
+		ofs[v] = _mm256_loadu_si256((const __m256i*)o);
+	}
+	const __m256i vcn = _mm256_set1_epi32(cn);
+	int x = 0;
+
+	for (; x <= n - 24; x += 24) {
+		__m256i r[3];
+		for (int v = 0; v < 3; v++) {
+			__m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + x + v * 8)));
+			idx = _mm256_add_epi32(_mm256_mullo_epi32(idx, vcn), ofs[v]);
+			r[v] = _mm256_i32gather_epi32(lut32, idx, 4);
+		}
+
+		__m256i r01 = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[0], r[1]), 0xd8);
+		__m256i r22 = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[2], r[2]), 0xd8);
+		__m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(r01, r22), 0xd8);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(b));
+		_mm_storel_epi64((__m128i*)(dst + x + 16), _mm256_extracti128_si256(b, 1));
+	}
+
+	return x;
+}
+
+// the pixels 0, 2 (even) and 1, 3 (odd) of 4 pixels gathered as 64-bit elements are in the unpacklo and unpackhi of two
+// gathers: 4 32-bit lanes per pixel, the lanes of a pixel get the value of the pixel p + first of v (8 pixels)
+static inline FBC_TARGET_AVX2 __m256i lut3DEven(__m256i v, int first)
+{
+	return _mm256_permutevar8x32_epi32(v, _mm256_add_epi32(_mm256_setr_epi32(0, 0, 0, 0, 2, 2, 2, 2), _mm256_set1_epi32(first)));
+}
+
+static inline FBC_TARGET_AVX2 __m256i lut3DOdd(__m256i v, int first)
+{
+	return _mm256_permutevar8x32_epi32(v, _mm256_add_epi32(_mm256_setr_epi32(1, 1, 1, 1, 3, 3, 3, 3), _mm256_set1_epi32(first)));
+}
+
+// the lattice cells of 8 pixels of cn (3 or 4) channels of Lut3D::cell_8u: the index of the first point in lattice
+// points and the fractions, v gets the pixels in 32-bit lanes; 3-channel loads read 4 bytes beyond the 8 pixels
+static inline FBC_TARGET_AVX2 void lut3DCells8(const uchar* s, int cn, const int* pos, int size, __m256i& v, __m256i& base, __m256i* f)
+{
+	const __m256i m8 = _mm256_set1_epi32(0xff), lim = _mm256_set1_epi32(size - 2);
+	if (cn == 3) {
+		const __m256i expand3 = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		__m128i lo = _mm_loadu_si128((const __m128i*)s), hi = _mm_loadu_si128((const __m128i*)(s + 12));
+		v = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), expand3);
+	} else {
+		v = _mm256_loadu_si256((const __m256i*)s);
+	}
+
+	__m256i i[3];
+	for (int c = 0; c < 3; c++) {
+		__m256i p = _mm256_i32gather_epi32(pos, _mm256_and_si256(_mm256_srli_epi32(v, c * 8), m8), 4);
+		i[c] = _mm256_min_epi32(_mm256_srai_epi32(p, LUT3D_POS_BITS), lim);
+		f[c] = _mm256_sub_epi32(p, _mm256_slli_epi32(i[c], LUT3D_POS_BITS));
+	}
+	base = _mm256_add_epi32(i[0], _mm256_add_epi32(_mm256_mullo_epi32(i[1], _mm256_set1_epi32(size)),
+		_mm256_mullo_epi32(i[2], _mm256_set1_epi32(size * size))));
+}
+
+// the entries of the lattice points idx of 8 pixels, pixels 0..3 in lo and 4..7 in hi
+static inline FBC_TARGET_AVX2 void lut3DGather8(const short* tab, __m256i idx, __m256i& lo, __m256i& hi)
+{
+	lo = _mm256_i32gather_epi64((const long long*)tab, _mm256_castsi256_si128(idx), 8);
+	hi = _mm256_i32gather_epi64((const long long*)tab, _mm256_extracti128_si256(idx, 1), 8);
+}
+
+// stores 8 pixels of cn (3 or 4) channels from the 16-bit results of the pixels 0..3 (lo) and 4..7 (hi), 4 values
+// per pixel; the fourth channel is the one of the source pixels v
+static inline FBC_TARGET_AVX2 void lut3DStore8(uchar* d, int cn, __m256i lo, __m256i hi, __m256i v)
+{
+	// the 4 bytes of the pixels 0, 1, 4, 5 | 2, 3, 6, 7, then in order
+	__m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+
+	if (cn == 3) {
+		const __m256i compress3 = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		r = _mm256_shuffle_epi8(r, compress3);
+		__m128i h = _mm256_extracti128_si256(r, 1);
+		_mm_storeu_si128((__m128i*)d, _mm256_castsi256_si128(r));
+		_mm_storel_epi64((__m128i*)(d + 12), h);
+		int t = _mm_extract_epi32(h, 2);
+		memcpy(d + 20, &t, 4);
+	} else {
+		_mm256_storeu_si256((__m256i*)d, _mm256_blendv_epi8(r, v, _mm256_set1_epi32((int)0xff000000)));
+	}
+}
+
+// the sums w0 * c0 + w1 * c1 + w2 * c2 + w3 * c3 of 4 pixels of the vertices g[0..3], wa = (w0, w1) and
+// wb = (w2, w3) of the 8 pixels as 16-bit pairs
+static inline FBC_TARGET_AVX2 __m256i lut3DTetrahedralSum4(const __m256i* g, __m256i wa, __m256i wb, int first)
+{
+	const int shift = LUT3D_POS_BITS + LUT3D_VALUE_BITS;
+	const __m256i delta = _mm256_set1_epi32(1 << (shift - 1));
+
+	__m256i se = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(g[0], g[1]), lut3DEven(wa, first)),
+		_mm256_madd_epi16(_mm256_unpacklo_epi16(g[2], g[3]), lut3DEven(wb, first)));
+	__m256i so = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(g[0], g[1]), lut3DOdd(wa, first)),
+		_mm256_madd_epi16(_mm256_unpackhi_epi16(g[2], g[3]), lut3DOdd(wb, first)));
+	se = _mm256_srai_epi32(_mm256_add_epi32(se, delta), shift);
+	so = _mm256_srai_epi32(_mm256_add_epi32(so, delta), shift);
+
+	return _mm256_packs_epi32(se, so);
+}
+
+// 8 pixels per iteration: the vertices of the tetrahedra of Lut3D::applyRow_8u in 32-bit lanes
+static FBC_TARGET_AVX2 int lut3DTetrahedral8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size)
+{
+	const __m256i one = _mm256_set1_epi32(1 << LUT3D_POS_BITS);
+	const __m256i d0 = _mm256_set1_epi32(1), d1 = _mm256_set1_epi32(size), d2 = _mm256_set1_epi32(size * size);
+	const __m256i dsum = _mm256_add_epi32(d0, _mm256_add_epi32(d1, d2));
+	int x = 0, end = cn == 3 ? n - 10 : n - 8;
+
+	for (; x <= end; x += 8) {
+		__m256i v, base, f[3];
+		lut3DCells8(src + x * cn, cn, pos, size, v, base, f);
+
+		__m256i g01 = _mm256_cmpgt_epi32(f[0], f[1]), g12 = _mm256_cmpgt_epi32(f[1], f[2]), g02 = _mm256_cmpgt_epi32(f[0], f[2]);
+		__m256i omax = _mm256_blendv_epi8(_mm256_blendv_epi8(d2, d1, _mm256_andnot_si256(g01, g12)), d0, _mm256_and_si256(g01, g02));
+		__m256i omin = _mm256_blendv_epi8(d0, _mm256_blendv_epi8(d2, d1, _mm256_andnot_si256(g12, g01)), _mm256_or_si256(g01, g02));
+		__m256i fmax = _mm256_max_epi32(f[0], _mm256_max_epi32(f[1], f[2])), fmin = _mm256_min_epi32(f[0], _mm256_min_epi32(f[1], f[2]));
+		__m256i fmid = _mm256_sub_epi32(_mm256_add_epi32(f[0], _mm256_add_epi32(f[1], f[2])), _mm256_add_epi32(fmax, fmin));
+
+		// (w0, w1) and (w2, w3) as 16-bit pairs
+		__m256i wa = _mm256_or_si256(_mm256_sub_epi32(one, fmax), _mm256_slli_epi32(_mm256_sub_epi32(fmax, fmid), 16));
+		__m256i wb = _mm256_or_si256(_mm256_sub_epi32(fmid, fmin), _mm256_slli_epi32(fmin, 16));
+
+		__m256i vtx[4] = { base, _mm256_add_epi32(base, omax), _mm256_sub_epi32(_mm256_add_epi32(base, dsum), omin),
+			_mm256_add_epi32(base, dsum) };
+		__m256i glo[4], ghi[4];
+		for (int k = 0; k < 4; k++)
+			lut3DGather8(tab, vtx[k], glo[k], ghi[k]);
+
+		lut3DStore8(dst + x * cn, cn, lut3DTetrahedralSum4(glo, wa, wb, 0), lut3DTetrahedralSum4(ghi, wa, wb, 4), v);
+	}
+
+	return x;
+}
+
+// the trilinear interpolation of 4 pixels of the 8 vertices g (vertex a + 2 * b + 4 * c is the point (a, b, c) of
+// the cell), the steps along the axes 0, 1 and 2 of Lut3D::applyRow_8u; w0 = (1 - f0, f0) as 16-bit pairs
+static inline FBC_TARGET_AVX2 __m256i lut3DTrilinear4(const __m256i* g, __m256i w0, __m256i f1, __m256i f2, int first)
+{
+	const int shift = 2 * LUT3D_POS_BITS - 4 + LUT3D_VALUE_BITS;
+	const __m256i one = _mm256_set1_epi32(1 << LUT3D_POS_BITS), guard = _mm256_set1_epi32(8);
+	const __m256i half = _mm256_set1_epi32(1 << (LUT3D_POS_BITS - 1)), delta = _mm256_set1_epi32(1 << (shift - 1));
+	__m256i r[2];
+
+	for (int k = 0; k < 2; k++) {
+		__m256i w = k == 0 ? lut3DEven(w0, first) : lut3DOdd(w0, first);
+		__m256i a1 = k == 0 ? lut3DEven(f1, first) : lut3DOdd(f1, first);
+		__m256i a2 = k == 0 ? lut3DEven(f2, first) : lut3DOdd(f2, first);
+		__m256i c[4];
+		for (int j = 0; j < 4; j++) {
+			__m256i pair = k == 0 ? _mm256_unpacklo_epi16(g[j * 2], g[j * 2 + 1]) : _mm256_unpackhi_epi16(g[j * 2], g[j * 2 + 1]);
+			c[j] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(pair, w), guard), 4);
+		}
+
+		__m256i b1 = _mm256_sub_epi32(one, a1), b2 = _mm256_sub_epi32(one, a2);
+		__m256i c0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(c[0], b1), _mm256_mullo_epi32(c[1], a1)), half), LUT3D_POS_BITS);
+		__m256i c1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(c[2], b1), _mm256_mullo_epi32(c[3], a1)), half), LUT3D_POS_BITS);
+		r[k] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(c0, b2), _mm256_mullo_epi32(c1, a2)), delta), shift);
+	}
+
+	return _mm256_packs_epi32(r[0], r[1]);
+}
+
+// 8 pixels per iteration: the 8 points of the cells of Lut3D::applyRow_8u in 32-bit lanes
+static FBC_TARGET_AVX2 int lut3DTrilinear8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size)
+{
+	const __m256i one = _mm256_set1_epi32(1 << LUT3D_POS_BITS);
+	int step[8];
+	for (int k = 0; k < 8; k++)
+		step[k] = (k & 1) + (k & 2 ? size : 0) + (k & 4 ? size * size : 0);
+	int x = 0, end = cn == 3 ? n - 10 : n - 8;
+
+	for (; x <= end; x += 8) {
+		__m256i v, base, f[3];
+		lut3DCells8(src + x * cn, cn, pos, size, v, base, f);
+		__m256i w0 = _mm256_or_si256(_mm256_sub_epi32(one, f[0]), _mm256_slli_epi32(f[0], 16));
+
+		__m256i glo[8], ghi[8];
+		for (int k = 0; k < 8; k++)
+			lut3DGather8(tab, _mm256_add_epi32(base, _mm256_set1_epi32(step[k])), glo[k], ghi[k]);
+
+		lut3DStore8(dst + x * cn, cn, lut3DTrilinear4(glo, w0, f[1], f[2], 0), lut3DTrilinear4(ghi, w0, f[1], f[2], 4), v);
+	}
+
+	return x;
+}
+
+} // namespace opt_AVX2
+
+#endif // FBC_CPU_X86
+
+int LUT8u(const uchar* src, uchar* dst, int n, const int* lut32, int cn)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::LUT8u(src, dst, n, lut32, cn);
+#endif
+	return 0;
+}
+
+int lut3DTetrahedral8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::lut3DTetrahedral8u(src, dst, n, cn, tab, pos, size);
+#endif
+	return 0;
+}
+
+int lut3DTrilinear8u(const uchar* src, uchar* dst, int n, int cn, const short* tab, const int* pos, int size)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::lut3DTrilinear8u(src, dst, n, cn, tab, pos, size);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
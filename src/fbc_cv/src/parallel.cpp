@@ -0,0 +1,348 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/core/src/parallel.cpp
+              modules/core/src/parallel_impl.cpp
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+	#include <sched.h>
+#endif
+#ifdef FBC_USE_OPENMP
+	#include <omp.h>
+#endif
+#include "core/parallel.hpp"
+#include "core/base.hpp"
+#include "core/fast_math.hpp"
+
+namespace fbc {
+
+ParallelLoopBody::~ParallelLoopBody() {}
+
+ParallelForAPI::~ParallelForAPI() {}
+
+// index of the current thread inside a parallel region
+static thread_local int tls_thread_num = 0;
+// set while the current thread executes a parallel region, nested parallel_for_ calls are run serially
+static thread_local bool tls_in_parallel = false;
+
+int getNumberOfCPUs()
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		int count = CPU_COUNT(&set);
+		if (count > 0)
+			return count;
+	}
+#endif
+	unsigned int count = std::thread::hardware_concurrency();
+	return count > 0 ? (int)count : 1;
+}
+
+static int defaultNumThreads()
+{
+	const char* env = getenv("FBC_NUM_THREADS");
+	if (env && env[0] != '\0') {
+		int n = atoi(env);
+		if (n >= 0)
+			return n;
+	}
+
+	return getNumberOfCPUs();
+}
+
+// std::thread pool, the caller thread always takes part in the processing of the stripes
+class ThreadPoolBackend : public ParallelForAPI {
+public:
+	ThreadPoolBackend() : num_threads(defaultNumThreads()) {}
+	~ThreadPoolBackend() { stop(); }
+
+	void parallel_for(int numStripes, FN_parallel_for_body_cb_t body_cb, void* body_cb_data)
+	{
+		std::unique_lock<std::mutex> job_lock(job_mutex, std::try_to_lock);
+		// the pool is busy with a job of another thread: do not wait for it, process the stripes serially
+		if (!job_lock.owns_lock() || num_threads <= 1 || numStripes <= 1) {
+			body_cb(0, numStripes, body_cb_data);
+			return;
+		}
+
+		start();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job_cb = body_cb;
+			job_data = body_cb_data;
+			job_stripes = numStripes;
+			job_next = 0;
+			job_active = true;
+			generation++;
+		}
+		cond_work.notify_all();
+
+		process();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		cond_done.wait(lock, [this] { return active_workers == 0; });
+		job_active = false;
+	}
+
+	int getNumThreads() const { return std::max(num_threads, 1); }
+
+	int setNumThreads(int nThreads)
+	{
+		std::lock_guard<std::mutex> job_lock(job_mutex);
+		stop();
+		num_threads = nThreads < 0 ? defaultNumThreads() : nThreads;
+
+		return num_threads;
+	}
+
+	int getThreadNum() const { return tls_thread_num; }
+
+	const char* getName() const { return "threads"; }
+
+private:
+	// caller must hold job_mutex
+	void start()
+	{
+		if ((int)workers.size() == num_threads - 1)
+			return;
+
+		stop();
+		exiting = false;
+		for (int i = 1; i < num_threads; i++) {
+			workers.push_back(std::thread(&ThreadPoolBackend::worker, this, i));
+		}
+	}
+
+	// caller must hold job_mutex or be the destructor
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			exiting = true;
+		}
+		cond_work.notify_all();
+
+		for (size_t i = 0; i < workers.size(); i++) {
+			if (workers[i].joinable())
+				workers[i].join();
+		}
+		workers.clear();
+	}
+
+	void process()
+	{
+		for (;;) {
+			int i = job_next.fetch_add(1);
+			if (i >= job_stripes)
+				break;
+			job_cb(i, i + 1, job_data);
+		}
+	}
+
+	void worker(int index)
+	{
+		tls_thread_num = index;
+		tls_in_parallel = true;
+		unsigned seen = 0;
+
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cond_work.wait(lock, [&] { return exiting || (job_active && generation != seen); });
+				if (exiting)
+					break;
+				seen = generation;
+				active_workers++;
+			}
+
+			process();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				active_workers--;
+			}
+			cond_done.notify_one();
+		}
+	}
+
+	int num_threads;
+	std::vector<std::thread> workers;
+	std::mutex job_mutex; // serializes jobs and the (re)configuration of the pool
+	std::mutex mutex; // protects the job description below
+	std::condition_variable cond_work, cond_done;
+	bool exiting = false;
+	bool job_active = false;
+	unsigned generation = 0;
+	int active_workers = 0;
+	FN_parallel_for_body_cb_t job_cb = NULL;
+	void* job_data = NULL;
+	int job_stripes = 0;
+	std::atomic<int> job_next{ 0 };
+};
+
+#ifdef FBC_USE_OPENMP
+class OpenMPBackend : public ParallelForAPI {
+public:
+	OpenMPBackend() : num_threads(defaultNumThreads()) {}
+
+	void parallel_for(int numStripes, FN_parallel_for_body_cb_t body_cb, void* body_cb_data)
+	{
+		#pragma omp parallel for schedule(dynamic) num_threads(getNumThreads())
+		for (int i = 0; i < numStripes; i++) {
+			body_cb(i, i + 1, body_cb_data);
+		}
+	}
+
+	int getNumThreads() const { return std::max(num_threads, 1); }
+	int setNumThreads(int nThreads) { num_threads = nThreads < 0 ? defaultNumThreads() : nThreads; return num_threads; }
+	int getThreadNum() const { return omp_get_thread_num(); }
+	const char* getName() const { return "openmp"; }
+
+private:
+	int num_threads;
+};
+#endif // FBC_USE_OPENMP
+
+static std::mutex& getBackendMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+static std::shared_ptr<ParallelForAPI>& getBackendRef()
+{
+	static std::shared_ptr<ParallelForAPI> backend;
+	return backend;
+}
+
+static std::shared_ptr<ParallelForAPI> createDefaultBackend()
+{
+#ifdef FBC_USE_OPENMP
+	return std::make_shared<OpenMPBackend>();
+#else
+	return std::make_shared<ThreadPoolBackend>();
+#endif
+}
+
+std::shared_ptr<ParallelForAPI> getParallelForBackend()
+{
+	std::lock_guard<std::mutex> lock(getBackendMutex());
+	std::shared_ptr<ParallelForAPI>& backend = getBackendRef();
+	if (!backend)
+		backend = createDefaultBackend();
+
+	return backend;
+}
+
+void setParallelForBackend(const std::shared_ptr<ParallelForAPI>& api)
+{
+	std::lock_guard<std::mutex> lock(getBackendMutex());
+	std::shared_ptr<ParallelForAPI>& backend = getBackendRef();
+	int nthreads = backend ? backend->getNumThreads() : -1;
+
+	backend = api ? api : createDefaultBackend();
+	backend->setNumThreads(nthreads);
+}
+
+bool setParallelForBackend(const char* backendName)
+{
+	FBC_Assert(backendName != NULL);
+
+	if (strcmp(backendName, "threads") == 0) {
+		setParallelForBackend(std::make_shared<ThreadPoolBackend>());
+		return true;
+	}
+#ifdef FBC_USE_OPENMP
+	if (strcmp(backendName, "openmp") == 0) {
+		setParallelForBackend(std::make_shared<OpenMPBackend>());
+		return true;
+	}
+#endif
+
+	fprintf(stderr, "unknown or unavailable parallel_for_ backend: %s\n", backendName);
+	return false;
+}
+
+void setNumThreads(int nthreads)
+{
+	getParallelForBackend()->setNumThreads(nthreads);
+}
+
+int getNumThreads()
+{
+	return getParallelForBackend()->getNumThreads();
+}
+
+int getThreadNum()
+{
+	return tls_in_parallel ? getParallelForBackend()->getThreadNum() : 0;
+}
+
+// maps the stripe indices to sub-ranges of the whole range
+class ParallelLoopBodyWrapper {
+public:
+	ParallelLoopBodyWrapper(const ParallelLoopBody& _body, const Range& _r, int _nstripes) : body(&_body), wholeRange(_r), nstripes(_nstripes) {}
+
+	Range stripeRange(int start, int end) const
+	{
+		int len = wholeRange.end - wholeRange.start;
+		Range r;
+		r.start = (int)(wholeRange.start + ((uint64)start * len + nstripes / 2) / nstripes);
+		r.end = end >= nstripes ? wholeRange.end : (int)(wholeRange.start + ((uint64)end * len + nstripes / 2) / nstripes);
+		return r;
+	}
+
+	static void callback(int start, int end, void* data)
+	{
+		const ParallelLoopBodyWrapper* self = (const ParallelLoopBodyWrapper*)data;
+		bool in_parallel = tls_in_parallel;
+		tls_in_parallel = true;
+		(*self->body)(self->stripeRange(start, end));
+		tls_in_parallel = in_parallel;
+	}
+
+private:
+	const ParallelLoopBody* body;
+	Range wholeRange;
+	int nstripes;
+};
+
+void parallel_for_(const Range& range, const ParallelLoopBody& body, double nstripes)
+{
+	if (range.empty())
+		return;
+
+	if (tls_in_parallel) {
+		body(range);
+		return;
+	}
+
+	std::shared_ptr<ParallelForAPI> backend = getParallelForBackend();
+	int numThreads = backend->getNumThreads();
+	int len = range.end - range.start;
+	// more stripes than threads keeps the load balanced, but every stripe repeats the setup work of the body
+	int maxStripes = std::min(len, numThreads * 4);
+	int numStripes = nstripes <= 0 ? maxStripes : std::min(std::max(fbcRound(nstripes), 1), maxStripes);
+
+	if (numThreads <= 1 || numStripes <= 1) {
+		body(range);
+		return;
+	}
+
+	ParallelLoopBodyWrapper wrapper(body, range, numStripes);
+	backend->parallel_for(numStripes, ParallelLoopBodyWrapper::callback, &wrapper);
+}
+
+} // namespace fbc
@@ -0,0 +1,247 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/imgproc/src/pyramids.cpp
+*/
+
+// SSE4.1/AVX2 kernels of pyrDown and pyrUp of 8-bit images, selected at runtime by checkHardwareSupport(). The
+// horizontal passes of single-channel rows and the vertical passes are integer code with the results of the plain
+// C++ code in pyramids.hpp
+
+#include <string.h>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+	#define FBC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define FBC_TARGET_SSE4_1
+	#define FBC_TARGET_AVX2
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// 8 results per iteration: the even and the odd bytes of three loads shifted by 2 are the 5 taps, the sums fit in
+// 16 bits (16 * 255)
+FBC_TARGET_SSE4_1 static int pyrDownRow8u32s(const uchar* src, int* row, int n)
+{
+	const __m128i mask = _mm_set1_epi16(0x00ff);
+	int x = 0;
+
+	for (; x <= n - 8; x += 8) {
+		const uchar* s = src + x * 2;
+		__m128i v0 = _mm_loadu_si128((const __m128i*)(s - 2));
+		__m128i v1 = _mm_loadu_si128((const __m128i*)s);
+		__m128i v2 = _mm_loadu_si128((const __m128i*)(s + 2));
+		__m128i e0 = _mm_and_si128(v0, mask), o0 = _mm_srli_epi16(v0, 8);
+		__m128i e1 = _mm_and_si128(v1, mask), o1 = _mm_srli_epi16(v1, 8);
+		__m128i e2 = _mm_and_si128(v2, mask);
+
+		__m128i t = _mm_add_epi16(_mm_add_epi16(e0, e2), _mm_slli_epi16(_mm_add_epi16(o0, o1), 2));
+		t = _mm_add_epi16(t, _mm_add_epi16(_mm_slli_epi16(e1, 2), _mm_slli_epi16(e1, 1)));
+
+		_mm_storeu_si128((__m128i*)(row + x), _mm_cvtepu16_epi32(t));
+		_mm_storeu_si128((__m128i*)(row + x + 4), _mm_cvtepu16_epi32(_mm_srli_si128(t, 8)));
+	}
+
+	return x;
+}
+
+// 4 results of the 5 rows: row2 * 6 + (row1 + row3) * 4 + row0 + row4, rounded with 8 fractional bits
+FBC_TARGET_SSE4_1 static inline __m128i pyrDownColumn4(const int** src, int x)
+{
+	__m128i r0 = _mm_loadu_si128((const __m128i*)(src[0] + x)), r1 = _mm_loadu_si128((const __m128i*)(src[1] + x));
+	__m128i r2 = _mm_loadu_si128((const __m128i*)(src[2] + x)), r3 = _mm_loadu_si128((const __m128i*)(src[3] + x));
+	__m128i r4 = _mm_loadu_si128((const __m128i*)(src[4] + x));
+
+	__m128i t = _mm_add_epi32(_mm_add_epi32(r0, r4), _mm_slli_epi32(_mm_add_epi32(r1, r3), 2));
+	t = _mm_add_epi32(t, _mm_add_epi32(_mm_slli_epi32(r2, 2), _mm_slli_epi32(r2, 1)));
+	return _mm_srai_epi32(_mm_add_epi32(t, _mm_set1_epi32(128)), 8);
+}
+
+FBC_TARGET_SSE4_1 static int pyrDownColumn32s8u(const int** src, uchar* dst, int width)
+{
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m128i d0 = _mm_packs_epi32(pyrDownColumn4(src, x), pyrDownColumn4(src, x + 4));
+		__m128i d1 = _mm_packs_epi32(pyrDownColumn4(src, x + 8), pyrDownColumn4(src, x + 12));
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(d0, d1));
+	}
+
+	for (; x <= width - 4; x += 4) {
+		__m128i d0 = _mm_packs_epi32(pyrDownColumn4(src, x), _mm_setzero_si128());
+		int d = _mm_cvtsi128_si32(_mm_packus_epi16(d0, d0));
+		memcpy(dst + x, &d, sizeof(d)); // dst + x is not aligned to int
+	}
+
+	return x;
+}
+
+// 8 source elements per iteration, the even results s[-1] + s[0] * 6 + s[1] and the odd (s[0] + s[1]) * 4 are
+// interleaved
+FBC_TARGET_SSE4_1 static int pyrUpRow8u32s(const uchar* src, int* row, int n)
+{
+	int x = 0;
+
+	for (; x <= n - 8; x += 8) {
+		__m128i l = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(src + x - 1)));
+		__m128i c = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(src + x)));
+		__m128i r = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(src + x + 1)));
+
+		__m128i t0 = _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+		__m128i t1 = _mm_slli_epi16(_mm_add_epi16(c, r), 2);
+		__m128i lo = _mm_unpacklo_epi16(t0, t1), hi = _mm_unpackhi_epi16(t0, t1);
+
+		int* d = row + x * 2;
+		_mm_storeu_si128((__m128i*)d, _mm_cvtepu16_epi32(lo));
+		_mm_storeu_si128((__m128i*)(d + 4), _mm_cvtepu16_epi32(_mm_srli_si128(lo, 8)));
+		_mm_storeu_si128((__m128i*)(d + 8), _mm_cvtepu16_epi32(hi));
+		_mm_storeu_si128((__m128i*)(d + 12), _mm_cvtepu16_epi32(_mm_srli_si128(hi, 8)));
+	}
+
+	return x;
+}
+
+// 4 results of the even (row0 + row1 * 6 + row2) and the odd ((row1 + row2) * 4) destination rows, rounded with
+// 6 fractional bits
+FBC_TARGET_SSE4_1 static inline void pyrUpColumn4(const int** src, int x, __m128i& d0, __m128i& d1)
+{
+	__m128i r0 = _mm_loadu_si128((const __m128i*)(src[0] + x)), r1 = _mm_loadu_si128((const __m128i*)(src[1] + x));
+	__m128i r2 = _mm_loadu_si128((const __m128i*)(src[2] + x)), delta = _mm_set1_epi32(32);
+
+	__m128i t0 = _mm_add_epi32(_mm_add_epi32(r0, r2), _mm_add_epi32(_mm_slli_epi32(r1, 2), _mm_slli_epi32(r1, 1)));
+	__m128i t1 = _mm_slli_epi32(_mm_add_epi32(r1, r2), 2);
+	d0 = _mm_srai_epi32(_mm_add_epi32(t0, delta), 6);
+	d1 = _mm_srai_epi32(_mm_add_epi32(t1, delta), 6);
+}
+
+FBC_TARGET_SSE4_1 static int pyrUpColumn32s8u(const int** src, uchar* dst0, uchar* dst1, int width)
+{
+	int x = 0;
+
+	for (; x <= width - 8; x += 8) {
+		__m128i a0, a1, b0, b1;
+		pyrUpColumn4(src, x, a0, a1);
+		pyrUpColumn4(src, x + 4, b0, b1);
+		__m128i d0 = _mm_packs_epi32(a0, b0), d1 = _mm_packs_epi32(a1, b1);
+		_mm_storel_epi64((__m128i*)(dst0 + x), _mm_packus_epi16(d0, d0));
+		_mm_storel_epi64((__m128i*)(dst1 + x), _mm_packus_epi16(d1, d1));
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+namespace opt_AVX2 {
+
+FBC_TARGET_AVX2 static int pyrDownRow8u32s(const uchar* src, int* row, int n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00ff);
+	int x = 0;
+
+	for (; x <= n - 16; x += 16) {
+		const uchar* s = src + x * 2;
+		__m256i v0 = _mm256_loadu_si256((const __m256i*)(s - 2));
+		__m256i v1 = _mm256_loadu_si256((const __m256i*)s);
+		__m256i v2 = _mm256_loadu_si256((const __m256i*)(s + 2));
+		__m256i e0 = _mm256_and_si256(v0, mask), o0 = _mm256_srli_epi16(v0, 8);
+		__m256i e1 = _mm256_and_si256(v1, mask), o1 = _mm256_srli_epi16(v1, 8);
+		__m256i e2 = _mm256_and_si256(v2, mask);
+
+		__m256i t = _mm256_add_epi16(_mm256_add_epi16(e0, e2), _mm256_slli_epi16(_mm256_add_epi16(o0, o1), 2));
+		t = _mm256_add_epi16(t, _mm256_add_epi16(_mm256_slli_epi16(e1, 2), _mm256_slli_epi16(e1, 1)));
+
+		_mm256_storeu_si256((__m256i*)(row + x), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(t)));
+		_mm256_storeu_si256((__m256i*)(row + x + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(t, 1)));
+	}
+
+	return x + opt_SSE4_1::pyrDownRow8u32s(src + x * 2, row + x, n - x);
+}
+
+FBC_TARGET_AVX2 static inline __m256i pyrDownColumn8(const int** src, int x)
+{
+	__m256i r0 = _mm256_loadu_si256((const __m256i*)(src[0] + x)), r1 = _mm256_loadu_si256((const __m256i*)(src[1] + x));
+	__m256i r2 = _mm256_loadu_si256((const __m256i*)(src[2] + x)), r3 = _mm256_loadu_si256((const __m256i*)(src[3] + x));
+	__m256i r4 = _mm256_loadu_si256((const __m256i*)(src[4] + x));
+
+	__m256i t = _mm256_add_epi32(_mm256_add_epi32(r0, r4), _mm256_slli_epi32(_mm256_add_epi32(r1, r3), 2));
+	t = _mm256_add_epi32(t, _mm256_add_epi32(_mm256_slli_epi32(r2, 2), _mm256_slli_epi32(r2, 1)));
+	return _mm256_srai_epi32(_mm256_add_epi32(t, _mm256_set1_epi32(128)), 8);
+}
+
+FBC_TARGET_AVX2 static int pyrDownColumn32s8u(const int** src, uchar* dst, int width)
+{
+	const __m256i perm = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int x = 0;
+
+	for (; x <= width - 32; x += 32) {
+		__m256i d0 = _mm256_packs_epi32(pyrDownColumn8(src, x), pyrDownColumn8(src, x + 8));
+		__m256i d1 = _mm256_packs_epi32(pyrDownColumn8(src, x + 16), pyrDownColumn8(src, x + 24));
+		_mm256_storeu_si256((__m256i*)(dst + x), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(d0, d1), perm));
+	}
+
+	for (; x <= width - 4; x += 4) {
+		__m128i d0 = _mm_packs_epi32(opt_SSE4_1::pyrDownColumn4(src, x), _mm_setzero_si128());
+		int d = _mm_cvtsi128_si32(_mm_packus_epi16(d0, d0));
+		memcpy(dst + x, &d, sizeof(d)); // dst + x is not aligned to int
+	}
+
+	return x;
+}
+
+} // namespace opt_AVX2
+
+#endif // FBC_CPU_X86
+
+int pyrDownRow8u32s(const uchar* src, int* row, int n)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::pyrDownRow8u32s(src, row, n);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::pyrDownRow8u32s(src, row, n);
+#endif
+	return 0;
+}
+
+int pyrDownColumn32s8u(const int** src, uchar* dst, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::pyrDownColumn32s8u(src, dst, width);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::pyrDownColumn32s8u(src, dst, width);
+#endif
+	return 0;
+}
+
+int pyrUpRow8u32s(const uchar* src, int* row, int n)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::pyrUpRow8u32s(src, row, n);
+#endif
+	return 0;
+}
+
+int pyrUpColumn32s8u(const int** src, uchar* dst0, uchar* dst1, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::pyrUpColumn32s8u(src, dst0, dst1, width);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
@@ -0,0 +1,273 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/imgproc/src/imgwarp.cpp
+              modules/imgproc/src/imgwarp.sse4_1.cpp
+*/
+
+// SSE4.1 kernels of remap and warpAffine, selected at runtime by checkHardwareSupport()
+// every kernel must give exactly the same results as the plain C++ code in remap.hpp/warpAffine.hpp:
+// the fixed-point paths use the same integer arithmetic, the float path the same order of operations and no FMA
+
+#include <string.h>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/saturate.hpp"
+#include "core/utility.hpp"
+#include "imgproc.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+	#define FBC_TARGET_SSE4_1
+#endif
+
+namespace fbc { namespace hal {
+
+// fractional bits of the coordinates of warpAffine, see WarpAffineTables::AB_BITS
+static const int WARP_AB_BITS = MAX(10, (int)INTER_BITS);
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// the fixed-point weights are summed as (S[0] * w[0] + S[1] * w[1]) + (S[sstep] * w[2] + S[sstep + 1] * w[3]) by
+// pmaddwd, the rounding of FixedPtCast<int, uchar, 15> follows
+static const int REMAP_COEF_BITS = 15;
+
+static inline FBC_TARGET_SSE4_1 __m128i castRemap8u(__m128i sum)
+{
+	sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << (REMAP_COEF_BITS - 1))), REMAP_COEF_BITS);
+	sum = _mm_packs_epi32(sum, sum);
+	return _mm_packus_epi16(sum, sum);
+}
+
+// the weights w[0], w[1] of the pixels 0..3 in the low register, w[2], w[3] in the high register
+static inline FBC_TARGET_SSE4_1 void loadWeights4(const short* wtab, const ushort* FXY, __m128i& w01, __m128i& w23)
+{
+	__m128i t0 = _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i*)(wtab + FXY[0] * 4)),
+		_mm_loadl_epi64((const __m128i*)(wtab + FXY[1] * 4)));
+	__m128i t1 = _mm_unpacklo_epi32(_mm_loadl_epi64((const __m128i*)(wtab + FXY[2] * 4)),
+		_mm_loadl_epi64((const __m128i*)(wtab + FXY[3] * 4)));
+	w01 = _mm_unpacklo_epi64(t0, t1);
+	w23 = _mm_unpackhi_epi64(t0, t1);
+}
+
+static inline int loadPair8u(const uchar* S)
+{
+	return S[0] | (S[1] << 8);
+}
+
+static FBC_TARGET_SSE4_1 int remapBilinear8u(const uchar* S0, size_t sstep, int swidth, uchar* D, const short* XY,
+	const ushort* FXY, const short* wtab, int cn, int width)
+{
+	int x = 0;
+
+	if (cn == 1) {
+		for (; x <= width - 8; x += 8) {
+			// the pairs S[0], S[1] of the 8 pixels in r0, the pairs S[sstep], S[sstep + 1] in r1
+			__m128i r0 = _mm_setzero_si128(), r1 = _mm_setzero_si128();
+#define FBC_REMAP_LOAD_PAIR(i) { \
+				const uchar* S = S0 + XY[(x + i) * 2 + 1] * sstep + XY[(x + i) * 2]; \
+				r0 = _mm_insert_epi16(r0, loadPair8u(S), i); \
+				r1 = _mm_insert_epi16(r1, loadPair8u(S + sstep), i); }
+			FBC_REMAP_LOAD_PAIR(0) FBC_REMAP_LOAD_PAIR(1) FBC_REMAP_LOAD_PAIR(2) FBC_REMAP_LOAD_PAIR(3)
+			FBC_REMAP_LOAD_PAIR(4) FBC_REMAP_LOAD_PAIR(5) FBC_REMAP_LOAD_PAIR(6) FBC_REMAP_LOAD_PAIR(7)
+#undef FBC_REMAP_LOAD_PAIR
+
+			__m128i w01, w23, sum0, sum1;
+			loadWeights4(wtab, FXY + x, w01, w23);
+			sum0 = _mm_add_epi32(_mm_madd_epi16(_mm_cvtepu8_epi16(r0), w01), _mm_madd_epi16(_mm_cvtepu8_epi16(r1), w23));
+			loadWeights4(wtab, FXY + x + 4, w01, w23);
+			sum1 = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi8(r0, _mm_setzero_si128()), w01),
+				_mm_madd_epi16(_mm_unpackhi_epi8(r1, _mm_setzero_si128()), w23));
+
+			sum0 = _mm_srai_epi32(_mm_add_epi32(sum0, _mm_set1_epi32(1 << (REMAP_COEF_BITS - 1))), REMAP_COEF_BITS);
+			sum1 = _mm_srai_epi32(_mm_add_epi32(sum1, _mm_set1_epi32(1 << (REMAP_COEF_BITS - 1))), REMAP_COEF_BITS);
+			__m128i v = _mm_packs_epi32(sum0, sum1);
+			_mm_storel_epi64((__m128i*)(D + x), _mm_packus_epi16(v, v));
+		}
+	} else if (cn == 3 || cn == 4) {
+		// the channels of the pixels sx and sx + 1 interleaved as 16-bit lanes: c0 d0 c1 d1 c2 d2 (c3 d3)
+		const __m128i interleave = cn == 3 ? _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1) :
+			_mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+		// 8 bytes are loaded per row: the 3-channel pixels of the last two source columns are computed one channel at a time
+		int sxmax = cn == 3 ? swidth - 3 : swidth;
+
+		for (; x < width; x++, D += cn) {
+			int sx = XY[x * 2], sy = XY[x * 2 + 1];
+			const uchar* S = S0 + sy * sstep + sx * cn;
+			const short* w = wtab + FXY[x] * 4;
+
+			if (sx > sxmax) {
+				for (int k = 0; k < cn; k++) {
+					int sum = S[k] * w[0] + S[k + cn] * w[1] + S[sstep + k] * w[2] + S[sstep + k + cn] * w[3];
+					D[k] = saturate_cast<uchar>((sum + (1 << (REMAP_COEF_BITS - 1))) >> REMAP_COEF_BITS);
+				}
+				continue;
+			}
+
+			__m128i wv = _mm_loadl_epi64((const __m128i*)w);
+			__m128i r0 = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i*)S), interleave);
+			__m128i r1 = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i*)(S + sstep)), interleave);
+			__m128i sum = _mm_add_epi32(_mm_madd_epi16(r0, _mm_shuffle_epi32(wv, 0)), _mm_madd_epi16(r1, _mm_shuffle_epi32(wv, 0x55)));
+			int v = _mm_cvtsi128_si32(castRemap8u(sum));
+
+			if (cn == 4)
+				memcpy(D, &v, 4);
+			else
+				memcpy(D, &v, 3);
+		}
+	}
+
+	return x;
+}
+
+// the products are summed in the order of the C++ code: ((v0 * w0 + v1 * w1) + v2 * w2) + v3 * w3
+static inline FBC_TARGET_SSE4_1 __m128 sumBilinear32f(__m128 v0, __m128 v1, __m128 v2, __m128 v3, __m128 w0, __m128 w1, __m128 w2, __m128 w3)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, w0), _mm_mul_ps(v1, w1)), _mm_mul_ps(v2, w2)), _mm_mul_ps(v3, w3));
+}
+
+static FBC_TARGET_SSE4_1 int remapBilinear32f(const float* S0, size_t sstep, int swidth, float* D, const short* XY,
+	const ushort* FXY, const float* wtab, int cn, int width)
+{
+	int x = 0;
+
+	if (cn == 1) {
+		for (; x <= width - 4; x += 4) {
+			const float* S[4];
+			for (int i = 0; i < 4; i++)
+				S[i] = S0 + XY[(x + i) * 2 + 1] * sstep + XY[(x + i) * 2];
+
+			// the weights of the 4 pixels are the rows of w0..w3, transposed to the columns
+			__m128 w0 = _mm_loadu_ps(wtab + FXY[x] * 4), w1 = _mm_loadu_ps(wtab + FXY[x + 1] * 4);
+			__m128 w2 = _mm_loadu_ps(wtab + FXY[x + 2] * 4), w3 = _mm_loadu_ps(wtab + FXY[x + 3] * 4);
+			_MM_TRANSPOSE4_PS(w0, w1, w2, w3);
+
+			__m128 v0 = _mm_setr_ps(S[0][0], S[1][0], S[2][0], S[3][0]);
+			__m128 v1 = _mm_setr_ps(S[0][1], S[1][1], S[2][1], S[3][1]);
+			__m128 v2 = _mm_setr_ps(S[0][sstep], S[1][sstep], S[2][sstep], S[3][sstep]);
+			__m128 v3 = _mm_setr_ps(S[0][sstep + 1], S[1][sstep + 1], S[2][sstep + 1], S[3][sstep + 1]);
+			_mm_storeu_ps(D + x, sumBilinear32f(v0, v1, v2, v3, w0, w1, w2, w3));
+		}
+	} else if (cn == 3 || cn == 4) {
+		// 4 floats are loaded per pixel: the 3-channel pixels of the last two source columns are computed one channel at a time
+		int sxmax = cn == 3 ? swidth - 3 : swidth;
+
+		for (; x < width; x++, D += cn) {
+			int sx = XY[x * 2], sy = XY[x * 2 + 1];
+			const float* S = S0 + sy * sstep + sx * cn;
+			const float* w = wtab + FXY[x] * 4;
+
+			if (sx > sxmax) {
+				for (int k = 0; k < cn; k++)
+					D[k] = S[k] * w[0] + S[k + cn] * w[1] + S[sstep + k] * w[2] + S[sstep + k + cn] * w[3];
+				continue;
+			}
+
+			__m128 wv = _mm_loadu_ps(w);
+			__m128 v = sumBilinear32f(_mm_loadu_ps(S), _mm_loadu_ps(S + cn), _mm_loadu_ps(S + sstep), _mm_loadu_ps(S + sstep + cn),
+				_mm_shuffle_ps(wv, wv, 0), _mm_shuffle_ps(wv, wv, 0x55), _mm_shuffle_ps(wv, wv, 0xaa), _mm_shuffle_ps(wv, wv, 0xff));
+
+			if (cn == 4) {
+				_mm_storeu_ps(D, v);
+			} else {
+				_mm_storel_pi((__m64*)D, v);
+				_mm_store_ss(D + 2, _mm_movehl_ps(v, v));
+			}
+		}
+	}
+
+	return x;
+}
+
+// X = X0 + adelta[x], Y = Y0 + bdelta[x] are shifted to INTER_BITS fractional bits, the integer parts are saturated
+// to short and the fractional parts give the index of the interpolation table
+static FBC_TARGET_SSE4_1 int warpAffineBlockline(const int* adelta, const int* bdelta, short* xy, short* alpha, int X0, int Y0, int bw)
+{
+	const __m128i vX0 = _mm_set1_epi32(X0), vY0 = _mm_set1_epi32(Y0), mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
+	int x = 0;
+
+	for (; x <= bw - 8; x += 8) {
+		__m128i tx0 = _mm_srai_epi32(_mm_add_epi32(vX0, _mm_loadu_si128((const __m128i*)(adelta + x))), WARP_AB_BITS - INTER_BITS);
+		__m128i tx1 = _mm_srai_epi32(_mm_add_epi32(vX0, _mm_loadu_si128((const __m128i*)(adelta + x + 4))), WARP_AB_BITS - INTER_BITS);
+		__m128i ty0 = _mm_srai_epi32(_mm_add_epi32(vY0, _mm_loadu_si128((const __m128i*)(bdelta + x))), WARP_AB_BITS - INTER_BITS);
+		__m128i ty1 = _mm_srai_epi32(_mm_add_epi32(vY0, _mm_loadu_si128((const __m128i*)(bdelta + x + 4))), WARP_AB_BITS - INTER_BITS);
+
+		__m128i a0 = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(ty0, mask), INTER_BITS), _mm_and_si128(tx0, mask));
+		__m128i a1 = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(ty1, mask), INTER_BITS), _mm_and_si128(tx1, mask));
+		_mm_storeu_si128((__m128i*)(alpha + x), _mm_packs_epi32(a0, a1));
+
+		__m128i vx = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS), _mm_srai_epi32(tx1, INTER_BITS));
+		__m128i vy = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS), _mm_srai_epi32(ty1, INTER_BITS));
+		_mm_storeu_si128((__m128i*)(xy + x * 2), _mm_unpacklo_epi16(vx, vy));
+		_mm_storeu_si128((__m128i*)(xy + x * 2 + 8), _mm_unpackhi_epi16(vx, vy));
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int warpAffineBlocklineNN(const int* adelta, const int* bdelta, short* xy, int X0, int Y0, int bw)
+{
+	const __m128i vX0 = _mm_set1_epi32(X0), vY0 = _mm_set1_epi32(Y0);
+	int x = 0;
+
+	for (; x <= bw - 8; x += 8) {
+		__m128i tx0 = _mm_srai_epi32(_mm_add_epi32(vX0, _mm_loadu_si128((const __m128i*)(adelta + x))), WARP_AB_BITS);
+		__m128i tx1 = _mm_srai_epi32(_mm_add_epi32(vX0, _mm_loadu_si128((const __m128i*)(adelta + x + 4))), WARP_AB_BITS);
+		__m128i ty0 = _mm_srai_epi32(_mm_add_epi32(vY0, _mm_loadu_si128((const __m128i*)(bdelta + x))), WARP_AB_BITS);
+		__m128i ty1 = _mm_srai_epi32(_mm_add_epi32(vY0, _mm_loadu_si128((const __m128i*)(bdelta + x + 4))), WARP_AB_BITS);
+
+		__m128i vx = _mm_packs_epi32(tx0, tx1), vy = _mm_packs_epi32(ty0, ty1);
+		_mm_storeu_si128((__m128i*)(xy + x * 2), _mm_unpacklo_epi16(vx, vy));
+		_mm_storeu_si128((__m128i*)(xy + x * 2 + 8), _mm_unpackhi_epi16(vx, vy));
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+#endif // FBC_CPU_X86
+
+int remapBilinear8u(const uchar* S0, size_t sstep, int swidth, uchar* D, const short* XY, const ushort* FXY, const short* wtab, int cn, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::remapBilinear8u(S0, sstep, swidth, D, XY, FXY, wtab, cn, width);
+#endif
+	return 0;
+}
+
+int remapBilinear32f(const float* S0, size_t sstep, int swidth, float* D, const short* XY, const ushort* FXY, const float* wtab, int cn, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::remapBilinear32f(S0, sstep, swidth, D, XY, FXY, wtab, cn, width);
+#endif
+	return 0;
+}
+
+int warpAffineBlockline(const int* adelta, const int* bdelta, short* xy, short* alpha, int X0, int Y0, int bw)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::warpAffineBlockline(adelta, bdelta, xy, alpha, X0, Y0, bw);
+#endif
+	return 0;
+}
+
+int warpAffineBlocklineNN(const int* adelta, const int* bdelta, short* xy, int X0, int Y0, int bw)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::warpAffineBlocklineNN(adelta, bdelta, xy, X0, Y0, bw);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
@@ -0,0 +1,494 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/imgproc/src/imgwarp.cpp
+              modules/imgproc/src/resize.sse4_1.cpp
+              modules/imgproc/src/resize.avx2.cpp
+*/
+
+// SSE4.1/AVX2 kernels of resize, selected at runtime by checkHardwareSupport()
+// every kernel must give exactly the same results as the plain C++ code in resize.hpp:
+// integer paths use the same (wrapping) arithmetic, float paths the same order of operations and no FMA
+
+#include <string.h>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	// the kernels are compiled for their instruction set only, the rest of the library keeps the default target
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+	#define FBC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define FBC_TARGET_SSE4_1
+	#define FBC_TARGET_AVX2
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+static FBC_TARGET_SSE4_1 int resizeHLinear8u(const uchar** src, int** dst, int count, const int* xofs, const short* alpha, int cn, int xmax)
+{
+	int dx = 0;
+
+	for (int k = 0; k < count; k++) {
+		const uchar* S = src[k];
+		int* D = dst[k];
+
+		for (dx = 0; dx <= xmax - 4; dx += 4) {
+			// (S[sx], S[sx + cn]) pairs multiplied by the (alpha0, alpha1) pairs
+			__m128i s = _mm_setr_epi32(S[xofs[dx]] | (S[xofs[dx] + cn] << 16), S[xofs[dx + 1]] | (S[xofs[dx + 1] + cn] << 16),
+				S[xofs[dx + 2]] | (S[xofs[dx + 2] + cn] << 16), S[xofs[dx + 3]] | (S[xofs[dx + 3] + cn] << 16));
+			__m128i a = _mm_loadu_si128((const __m128i*)(alpha + dx * 2));
+			_mm_storeu_si128((__m128i*)(D + dx), _mm_madd_epi16(s, a));
+		}
+	}
+
+	return dx;
+}
+
+static FBC_TARGET_SSE4_1 int resizeHLinear32f(const float** src, float** dst, int count, const int* xofs, const float* alpha, int cn, int xmax)
+{
+	int dx = 0;
+
+	for (int k = 0; k < count; k++) {
+		const float* S = src[k];
+		float* D = dst[k];
+
+		for (dx = 0; dx <= xmax - 4; dx += 4) {
+			__m128 s0 = _mm_setr_ps(S[xofs[dx]], S[xofs[dx + 1]], S[xofs[dx + 2]], S[xofs[dx + 3]]);
+			__m128 s1 = _mm_setr_ps(S[xofs[dx] + cn], S[xofs[dx + 1] + cn], S[xofs[dx + 2] + cn], S[xofs[dx + 3] + cn]);
+			__m128 a_lo = _mm_loadu_ps(alpha + dx * 2), a_hi = _mm_loadu_ps(alpha + dx * 2 + 4);
+			__m128 a0 = _mm_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 a1 = _mm_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(3, 1, 3, 1));
+			_mm_storeu_ps(D + dx, _mm_add_ps(_mm_mul_ps(s0, a0), _mm_mul_ps(s1, a1)));
+		}
+	}
+
+	return dx;
+}
+
+static FBC_TARGET_SSE4_1 int resizeVLinear8u(const int** src, uchar* dst, const short* beta, int width)
+{
+	const int *S0 = src[0], *S1 = src[1];
+	__m128i b0 = _mm_set1_epi16(beta[0]), b1 = _mm_set1_epi16(beta[1]);
+	__m128i delta = _mm_set1_epi16(2);
+	int x = 0;
+
+	// the rows hold pixel * INTER_RESIZE_COEF_SCALE, (S >> 4) fits into 16 bits
+	for (; x <= width - 16; x += 16) {
+		__m128i x0 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S0 + x)), 4),
+			_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S0 + x + 4)), 4));
+		__m128i y0 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S1 + x)), 4),
+			_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S1 + x + 4)), 4));
+		__m128i x1 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S0 + x + 8)), 4),
+			_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S0 + x + 12)), 4));
+		__m128i y1 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S1 + x + 8)), 4),
+			_mm_srai_epi32(_mm_loadu_si128((const __m128i*)(S1 + x + 12)), 4));
+
+		x0 = _mm_adds_epi16(_mm_mulhi_epi16(x0, b0), _mm_mulhi_epi16(y0, b1));
+		x1 = _mm_adds_epi16(_mm_mulhi_epi16(x1, b0), _mm_mulhi_epi16(y1, b1));
+
+		x0 = _mm_srai_epi16(_mm_adds_epi16(x0, delta), 2);
+		x1 = _mm_srai_epi16(_mm_adds_epi16(x1, delta), 2);
+		_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(x0, x1));
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int resizeVLinear32f(const float** src, float* dst, const float* beta, int width)
+{
+	const float *S0 = src[0], *S1 = src[1];
+	__m128 b0 = _mm_set1_ps(beta[0]), b1 = _mm_set1_ps(beta[1]);
+	int x = 0;
+
+	for (; x <= width - 8; x += 8) {
+		__m128 x0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(S0 + x), b0), _mm_mul_ps(_mm_loadu_ps(S1 + x), b1));
+		__m128 x1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(S0 + x + 4), b0), _mm_mul_ps(_mm_loadu_ps(S1 + x + 4), b1));
+		_mm_storeu_ps(dst + x, x0);
+		_mm_storeu_ps(dst + x + 4, x1);
+	}
+
+	return x;
+}
+
+// sum of ksize rows multiplied by beta, (sum + 2^21) >> 22 saturated to uchar
+static FBC_TARGET_SSE4_1 int resizeVSum8u(const int** src, uchar* dst, const short* beta, int width, int ksize)
+{
+	__m128i delta = _mm_set1_epi32(1 << 21);
+	int x = 0;
+
+	for (; x <= width - 8; x += 8) {
+		__m128i b = _mm_set1_epi32(beta[0]);
+		__m128i s0 = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(src[0] + x)), b);
+		__m128i s1 = _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(src[0] + x + 4)), b);
+
+		for (int k = 1; k < ksize; k++) {
+			b = _mm_set1_epi32(beta[k]);
+			s0 = _mm_add_epi32(s0, _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(src[k] + x)), b));
+			s1 = _mm_add_epi32(s1, _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(src[k] + x + 4)), b));
+		}
+
+		s0 = _mm_srai_epi32(_mm_add_epi32(s0, delta), 22);
+		s1 = _mm_srai_epi32(_mm_add_epi32(s1, delta), 22);
+		_mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(_mm_packs_epi32(s0, s1), s0));
+	}
+
+	return x;
+}
+
+// sum of ksize rows multiplied by beta, accumulated from the first row to the last one
+static FBC_TARGET_SSE4_1 int resizeVSum32f(const float** src, float* dst, const float* beta, int width, int ksize)
+{
+	int x = 0;
+
+	for (; x <= width - 8; x += 8) {
+		__m128 b = _mm_set1_ps(beta[0]);
+		__m128 s0 = _mm_mul_ps(_mm_loadu_ps(src[0] + x), b);
+		__m128 s1 = _mm_mul_ps(_mm_loadu_ps(src[0] + x + 4), b);
+
+		for (int k = 1; k < ksize; k++) {
+			b = _mm_set1_ps(beta[k]);
+			s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(src[k] + x), b));
+			s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(src[k] + x + 4), b));
+		}
+
+		_mm_storeu_ps(dst + x, s0);
+		_mm_storeu_ps(dst + x + 4, s1);
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int resizeAreaFast2x2_8u(const uchar* S, const uchar* nextS, uchar* D, int w, int cn)
+{
+	__m128i delta = _mm_set1_epi16(2);
+	int dx = 0;
+
+	if (cn == 1) {
+		__m128i ones = _mm_set1_epi8(1);
+
+		for (; dx <= w - 16; dx += 16) {
+			int index = dx * 2;
+			__m128i s0 = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(S + index)), ones),
+				_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(nextS + index)), ones));
+			__m128i s1 = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(S + index + 16)), ones),
+				_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(nextS + index + 16)), ones));
+			s0 = _mm_srli_epi16(_mm_add_epi16(s0, delta), 2);
+			s1 = _mm_srli_epi16(_mm_add_epi16(s1, delta), 2);
+			_mm_storeu_si128((__m128i*)(D + dx), _mm_packus_epi16(s0, s1));
+		}
+	} else if (cn == 4) {
+		__m128i zero = _mm_setzero_si128();
+
+		for (; dx <= w - 16; dx += 16) {
+			int index = dx * 2;
+			__m128i s[2];
+
+			for (int i = 0; i < 2; i++) {
+				__m128i r0 = _mm_loadu_si128((const __m128i*)(S + index + i * 16));
+				__m128i r1 = _mm_loadu_si128((const __m128i*)(nextS + index + i * 16));
+				// pixels 0, 1 and pixels 2, 3 of both rows
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+				__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+				s[i] = _mm_srli_epi16(_mm_add_epi16(sum, delta), 2);
+			}
+
+			_mm_storeu_si128((__m128i*)(D + dx), _mm_packus_epi16(s[0], s[1]));
+		}
+	}
+
+	return dx;
+}
+
+} // namespace opt_SSE4_1
+
+namespace opt_AVX2 {
+
+// lane crossing fix-up of the 256 bits pack instructions
+#define FBC_PERMUTE_PACKED(v) _mm256_permute4x64_epi64(v, 0xD8)
+
+static FBC_TARGET_AVX2 int resizeHLinear8u(const uchar** src, int** dst, int count, const int* xofs, const short* alpha, int swidth, int cn, int xmax)
+{
+	// the gathers load 4 bytes from S + xofs[dx] (and S + xofs[dx] + cn), they must stay inside the row.
+	// xofs[dx] = sx*cn + dx%cn is not monotonic inside a pixel, so the test uses the last channel of the pixel
+	int gather_size = cn < 4 ? 4 : cn + 4;
+	int xmax_safe = xmax;
+	while (xmax_safe > 0 && xofs[xmax_safe - 1] - (xmax_safe - 1) % cn + cn - 1 + gather_size > swidth)
+		xmax_safe--;
+
+	__m256i mask = _mm256_set1_epi32(0xff);
+	__m128i shift = _mm_cvtsi32_si128(cn * 8);
+	int dx = 0;
+
+	for (int k = 0; k < count; k++) {
+		const uchar* S = src[k];
+		int* D = dst[k];
+
+		for (dx = 0; dx <= xmax_safe - 8; dx += 8) {
+			__m256i idx = _mm256_loadu_si256((const __m256i*)(xofs + dx));
+			__m256i v0 = _mm256_i32gather_epi32((const int*)S, idx, 1);
+			__m256i v1 = cn < 4 ? _mm256_srl_epi32(v0, shift) : _mm256_i32gather_epi32((const int*)(S + cn), idx, 1);
+			// (S[sx], S[sx + cn]) pairs multiplied by the (alpha0, alpha1) pairs
+			__m256i s = _mm256_or_si256(_mm256_and_si256(v0, mask), _mm256_slli_epi32(_mm256_and_si256(v1, mask), 16));
+			__m256i a = _mm256_loadu_si256((const __m256i*)(alpha + dx * 2));
+			_mm256_storeu_si256((__m256i*)(D + dx), _mm256_madd_epi16(s, a));
+		}
+	}
+
+	return dx;
+}
+
+static FBC_TARGET_AVX2 int resizeHLinear32f(const float** src, float** dst, int count, const int* xofs, const float* alpha, int cn, int xmax)
+{
+	int dx = 0;
+
+	for (int k = 0; k < count; k++) {
+		const float* S = src[k];
+		float* D = dst[k];
+
+		for (dx = 0; dx <= xmax - 8; dx += 8) {
+			__m256i idx = _mm256_loadu_si256((const __m256i*)(xofs + dx));
+			__m256 s0 = _mm256_i32gather_ps(S, idx, 4);
+			__m256 s1 = _mm256_i32gather_ps(S + cn, idx, 4);
+			__m256 a_lo = _mm256_loadu_ps(alpha + dx * 2), a_hi = _mm256_loadu_ps(alpha + dx * 2 + 8);
+			__m256 a0 = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(2, 0, 2, 0))), 0xD8));
+			__m256 a1 = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a_lo, a_hi, _MM_SHUFFLE(3, 1, 3, 1))), 0xD8));
+			_mm256_storeu_ps(D + dx, _mm256_add_ps(_mm256_mul_ps(s0, a0), _mm256_mul_ps(s1, a1)));
+		}
+	}
+
+	return dx;
+}
+
+static FBC_TARGET_AVX2 int resizeVLinear8u(const int** src, uchar* dst, const short* beta, int width)
+{
+	const int *S0 = src[0], *S1 = src[1];
+	__m256i b0 = _mm256_set1_epi16(beta[0]), b1 = _mm256_set1_epi16(beta[1]);
+	__m256i delta = _mm256_set1_epi16(2);
+	int x = 0;
+
+	for (; x <= width - 32; x += 32) {
+		__m256i x0 = FBC_PERMUTE_PACKED(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S0 + x)), 4),
+			_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S0 + x + 8)), 4)));
+		__m256i y0 = FBC_PERMUTE_PACKED(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S1 + x)), 4),
+			_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S1 + x + 8)), 4)));
+		__m256i x1 = FBC_PERMUTE_PACKED(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S0 + x + 16)), 4),
+			_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S0 + x + 24)), 4)));
+		__m256i y1 = FBC_PERMUTE_PACKED(_mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S1 + x + 16)), 4),
+			_mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)(S1 + x + 24)), 4)));
+
+		x0 = _mm256_adds_epi16(_mm256_mulhi_epi16(x0, b0), _mm256_mulhi_epi16(y0, b1));
+		x1 = _mm256_adds_epi16(_mm256_mulhi_epi16(x1, b0), _mm256_mulhi_epi16(y1, b1));
+
+		x0 = _mm256_srai_epi16(_mm256_adds_epi16(x0, delta), 2);
+		x1 = _mm256_srai_epi16(_mm256_adds_epi16(x1, delta), 2);
+		_mm256_storeu_si256((__m256i*)(dst + x), FBC_PERMUTE_PACKED(_mm256_packus_epi16(x0, x1)));
+	}
+
+	return x;
+}
+
+static FBC_TARGET_AVX2 int resizeVLinear32f(const float** src, float* dst, const float* beta, int width)
+{
+	const float *S0 = src[0], *S1 = src[1];
+	__m256 b0 = _mm256_set1_ps(beta[0]), b1 = _mm256_set1_ps(beta[1]);
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m256 x0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(S0 + x), b0), _mm256_mul_ps(_mm256_loadu_ps(S1 + x), b1));
+		__m256 x1 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(S0 + x + 8), b0), _mm256_mul_ps(_mm256_loadu_ps(S1 + x + 8), b1));
+		_mm256_storeu_ps(dst + x, x0);
+		_mm256_storeu_ps(dst + x + 8, x1);
+	}
+
+	return x;
+}
+
+static FBC_TARGET_AVX2 int resizeVSum8u(const int** src, uchar* dst, const short* beta, int width, int ksize)
+{
+	__m256i delta = _mm256_set1_epi32(1 << 21);
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m256i b = _mm256_set1_epi32(beta[0]);
+		__m256i s0 = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(src[0] + x)), b);
+		__m256i s1 = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(src[0] + x + 8)), b);
+
+		for (int k = 1; k < ksize; k++) {
+			b = _mm256_set1_epi32(beta[k]);
+			s0 = _mm256_add_epi32(s0, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(src[k] + x)), b));
+			s1 = _mm256_add_epi32(s1, _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(src[k] + x + 8)), b));
+		}
+
+		s0 = _mm256_srai_epi32(_mm256_add_epi32(s0, delta), 22);
+		s1 = _mm256_srai_epi32(_mm256_add_epi32(s1, delta), 22);
+		__m256i s = FBC_PERMUTE_PACKED(_mm256_packs_epi32(s0, s1));
+		s = FBC_PERMUTE_PACKED(_mm256_packus_epi16(s, s));
+		_mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(s));
+	}
+
+	return x;
+}
+
+static FBC_TARGET_AVX2 int resizeVSum32f(const float** src, float* dst, const float* beta, int width, int ksize)
+{
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m256 b = _mm256_set1_ps(beta[0]);
+		__m256 s0 = _mm256_mul_ps(_mm256_loadu_ps(src[0] + x), b);
+		__m256 s1 = _mm256_mul_ps(_mm256_loadu_ps(src[0] + x + 8), b);
+
+		for (int k = 1; k < ksize; k++) {
+			b = _mm256_set1_ps(beta[k]);
+			s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_loadu_ps(src[k] + x), b));
+			s1 = _mm256_add_ps(s1, _mm256_mul_ps(_mm256_loadu_ps(src[k] + x + 8), b));
+		}
+
+		_mm256_storeu_ps(dst + x, s0);
+		_mm256_storeu_ps(dst + x + 8, s1);
+	}
+
+	return x;
+}
+
+static FBC_TARGET_AVX2 int resizeAreaFast2x2_8u(const uchar* S, const uchar* nextS, uchar* D, int w, int cn)
+{
+	if (cn != 1)
+		return 0;
+
+	__m256i ones = _mm256_set1_epi8(1);
+	__m256i delta = _mm256_set1_epi16(2);
+	int dx = 0;
+
+	for (; dx <= w - 32; dx += 32) {
+		int index = dx * 2;
+		__m256i s0 = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(S + index)), ones),
+			_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(nextS + index)), ones));
+		__m256i s1 = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(S + index + 32)), ones),
+			_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(nextS + index + 32)), ones));
+		s0 = _mm256_srli_epi16(_mm256_add_epi16(s0, delta), 2);
+		s1 = _mm256_srli_epi16(_mm256_add_epi16(s1, delta), 2);
+		_mm256_storeu_si256((__m256i*)(D + dx), FBC_PERMUTE_PACKED(_mm256_packus_epi16(s0, s1)));
+	}
+
+	return dx;
+}
+
+#undef FBC_PERMUTE_PACKED
+
+} // namespace opt_AVX2
+
+#endif // FBC_CPU_X86
+
+int resizeHLinear8u(const uchar** src, int** dst, int count, const int* xofs, const short* alpha, int swidth, int cn, int xmax)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeHLinear8u(src, dst, count, xofs, alpha, swidth, cn, xmax);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeHLinear8u(src, dst, count, xofs, alpha, cn, xmax);
+#endif
+	return 0;
+}
+
+int resizeHLinear32f(const float** src, float** dst, int count, const int* xofs, const float* alpha, int swidth, int cn, int xmax)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeHLinear32f(src, dst, count, xofs, alpha, cn, xmax);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeHLinear32f(src, dst, count, xofs, alpha, cn, xmax);
+#endif
+	return 0;
+}
+
+int resizeVLinear8u(const int** src, uchar* dst, const short* beta, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeVLinear8u(src, dst, beta, width);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeVLinear8u(src, dst, beta, width);
+#endif
+	return 0;
+}
+
+int resizeVLinear32f(const float** src, float* dst, const float* beta, int width)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeVLinear32f(src, dst, beta, width);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeVLinear32f(src, dst, beta, width);
+#endif
+	return 0;
+}
+
+static int resizeVSum8u(const int** src, uchar* dst, const short* beta, int width, int ksize)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeVSum8u(src, dst, beta, width, ksize);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeVSum8u(src, dst, beta, width, ksize);
+#endif
+	return 0;
+}
+
+static int resizeVSum32f(const float** src, float* dst, const float* beta, int width, int ksize)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		return opt_AVX2::resizeVSum32f(src, dst, beta, width, ksize);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::resizeVSum32f(src, dst, beta, width, ksize);
+#endif
+	return 0;
+}
+
+int resizeVCubic8u(const int** src, uchar* dst, const short* beta, int width)
+{
+	return resizeVSum8u(src, dst, beta, width, 4);
+}
+
+int resizeVCubic32f(const float** src, float* dst, const float* beta, int width)
+{
+	return resizeVSum32f(src, dst, beta, width, 4);
+}
+
+int resizeVLanczos4_8u(const int** src, uchar* dst, const short* beta, int width)
+{
+	return resizeVSum8u(src, dst, beta, width, 8);
+}
+
+int resizeVLanczos4_32f(const float** src, float* dst, const float* beta, int width)
+{
+	return resizeVSum32f(src, dst, beta, width, 8);
+}
+
+int resizeAreaFast2x2_8u(const uchar* src, const uchar* src_next, uchar* dst, int width, int cn)
+{
+#ifdef FBC_CPU_X86
+	int x = 0;
+	if (checkHardwareSupport(FBC_CPU_AVX2))
+		x = opt_AVX2::resizeAreaFast2x2_8u(src, src_next, dst, width, cn);
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		x += opt_SSE4_1::resizeAreaFast2x2_8u(src + x * 2, src_next + x * 2, dst + x, width - x, cn);
+	return x;
+#else
+	return 0;
+#endif
+}
+
+} // namespace hal
+} // namespace fbc
@@ -0,0 +1,290 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/core/src/split.simd.hpp
+              modules/core/src/merge.simd.hpp
+*/
+
+// SSE4.1 kernels of split/merge (de-interleaving of 2, 3 and 4 channels), selected at runtime by checkHardwareSupport()
+// the 3-channel kernels gather every plane with one byte shuffle per source register, the 2 and 4-channel
+// kernels use pack/unpack; they only move the elements, so the results are those of the plain C++ code
+
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+	#define FBC_TARGET_SSE4_1
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// element p of plane c is the element 3 * p + c of the 3 source registers: masks[c][r] takes it from register r
+static const signed char split8uC3Masks[3][3][16] = {
+	{ { 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13 } },
+	{ { 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14 } },
+	{ { 2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15 } }
+};
+
+// element j of the destination register k is the element (16 * k + j) / 3 of plane (16 * k + j) % 3: masks[k][c]
+static const signed char merge8uC3Masks[3][3][16] = {
+	{ { 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5 },
+	  { -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1 },
+	  { -1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1 } },
+	{ { -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1 },
+	  { 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10 },
+	  { -1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1 } },
+	{ { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+	  { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+	  { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } }
+};
+
+// the same for 32-bit elements, 4 elements per register
+static const signed char split32sC3Masks[3][3][16] = {
+	{ { 0, 1, 2, 3, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, 8, 9, 10, 11, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, 6, 7 } },
+	{ { 4, 5, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, 0, 1, 2, 3, 12, 13, 14, 15, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, 9, 10, 11 } },
+	{ { 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, 4, 5, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3, 12, 13, 14, 15 } }
+};
+
+static const signed char merge32sC3Masks[3][3][16] = {
+	{ { 0, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, 6, 7 },
+	  { -1, -1, -1, -1, 0, 1, 2, 3, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, 2, 3, -1, -1, -1, -1 } },
+	{ { -1, -1, -1, -1, -1, -1, -1, -1, 8, 9, 10, 11, -1, -1, -1, -1 },
+	  { 4, 5, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, 8, 9, 10, 11 },
+	  { -1, -1, -1, -1, 4, 5, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1 } },
+	{ { -1, -1, -1, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1 },
+	  { -1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, 15, -1, -1, -1, -1 },
+	  { 8, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, 15 } }
+};
+
+static inline FBC_TARGET_SSE4_1 __m128i loadMask(const signed char* mask)
+{
+	return _mm_loadu_si128((const __m128i*)mask);
+}
+
+// gathers the planes of 3 interleaved registers (or interleaves 3 planes) with the masks
+static inline FBC_TARGET_SSE4_1 void shuffle3(const __m128i* in, __m128i* out, const signed char (*masks)[3][16])
+{
+	for (int k = 0; k < 3; k++) {
+		out[k] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in[0], loadMask(masks[k][0])),
+			_mm_shuffle_epi8(in[1], loadMask(masks[k][1]))), _mm_shuffle_epi8(in[2], loadMask(masks[k][2])));
+	}
+}
+
+static FBC_TARGET_SSE4_1 int split8u(const uchar* src, uchar** dst, int len, int cn)
+{
+	int x = 0;
+
+	if (cn == 2) {
+		const __m128i lo = _mm_set1_epi16(0xff);
+		for (; x <= len - 16; x += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + x * 2));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + x * 2 + 16));
+			_mm_storeu_si128((__m128i*)(dst[0] + x), _mm_packus_epi16(_mm_and_si128(a, lo), _mm_and_si128(b, lo)));
+			_mm_storeu_si128((__m128i*)(dst[1] + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+		}
+	} else if (cn == 3) {
+		for (; x <= len - 16; x += 16) {
+			__m128i in[3], out[3];
+			for (int k = 0; k < 3; k++)
+				in[k] = _mm_loadu_si128((const __m128i*)(src + x * 3 + k * 16));
+			shuffle3(in, out, split8uC3Masks);
+			for (int k = 0; k < 3; k++)
+				_mm_storeu_si128((__m128i*)(dst[k] + x), out[k]);
+		}
+	} else if (cn == 4) {
+		// c0 c0 c0 c0 c1 c1 c1 c1 c2 c2 c2 c2 c3 c3 c3 c3 in every register, then a 4x4 transposition of 32-bit lanes
+		const __m128i group = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+		for (; x <= len - 16; x += 16) {
+			__m128i v0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4)), group);
+			__m128i v1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 16)), group);
+			__m128i v2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 32)), group);
+			__m128i v3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x * 4 + 48)), group);
+			__m128i t0 = _mm_unpacklo_epi32(v0, v1), t1 = _mm_unpacklo_epi32(v2, v3);
+			__m128i t2 = _mm_unpackhi_epi32(v0, v1), t3 = _mm_unpackhi_epi32(v2, v3);
+			_mm_storeu_si128((__m128i*)(dst[0] + x), _mm_unpacklo_epi64(t0, t1));
+			_mm_storeu_si128((__m128i*)(dst[1] + x), _mm_unpackhi_epi64(t0, t1));
+			_mm_storeu_si128((__m128i*)(dst[2] + x), _mm_unpacklo_epi64(t2, t3));
+			_mm_storeu_si128((__m128i*)(dst[3] + x), _mm_unpackhi_epi64(t2, t3));
+		}
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int merge8u(const uchar** src, uchar* dst, int len, int cn)
+{
+	int x = 0;
+
+	if (cn == 2) {
+		for (; x <= len - 16; x += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(src[0] + x));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src[1] + x));
+			_mm_storeu_si128((__m128i*)(dst + x * 2), _mm_unpacklo_epi8(a, b));
+			_mm_storeu_si128((__m128i*)(dst + x * 2 + 16), _mm_unpackhi_epi8(a, b));
+		}
+	} else if (cn == 3) {
+		for (; x <= len - 16; x += 16) {
+			__m128i in[3], out[3];
+			for (int k = 0; k < 3; k++)
+				in[k] = _mm_loadu_si128((const __m128i*)(src[k] + x));
+			shuffle3(in, out, merge8uC3Masks);
+			for (int k = 0; k < 3; k++)
+				_mm_storeu_si128((__m128i*)(dst + x * 3 + k * 16), out[k]);
+		}
+	} else if (cn == 4) {
+		for (; x <= len - 16; x += 16) {
+			__m128i a = _mm_loadu_si128((const __m128i*)(src[0] + x));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src[1] + x));
+			__m128i c = _mm_loadu_si128((const __m128i*)(src[2] + x));
+			__m128i d = _mm_loadu_si128((const __m128i*)(src[3] + x));
+			__m128i ab0 = _mm_unpacklo_epi8(a, b), ab1 = _mm_unpackhi_epi8(a, b);
+			__m128i cd0 = _mm_unpacklo_epi8(c, d), cd1 = _mm_unpackhi_epi8(c, d);
+			_mm_storeu_si128((__m128i*)(dst + x * 4), _mm_unpacklo_epi16(ab0, cd0));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 16), _mm_unpackhi_epi16(ab0, cd0));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 32), _mm_unpacklo_epi16(ab1, cd1));
+			_mm_storeu_si128((__m128i*)(dst + x * 4 + 48), _mm_unpackhi_epi16(ab1, cd1));
+		}
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int split32s(const int* src, int** dst, int len, int cn)
+{
+	int x = 0;
+
+	if (cn == 2) {
+		for (; x <= len - 4; x += 4) {
+			__m128 a = _mm_loadu_ps((const float*)(src + x * 2));
+			__m128 b = _mm_loadu_ps((const float*)(src + x * 2 + 4));
+			_mm_storeu_ps((float*)(dst[0] + x), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps((float*)(dst[1] + x), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+	} else if (cn == 3) {
+		for (; x <= len - 4; x += 4) {
+			__m128i in[3], out[3];
+			for (int k = 0; k < 3; k++)
+				in[k] = _mm_loadu_si128((const __m128i*)(src + x * 3 + k * 4));
+			shuffle3(in, out, split32sC3Masks);
+			for (int k = 0; k < 3; k++)
+				_mm_storeu_si128((__m128i*)(dst[k] + x), out[k]);
+		}
+	} else if (cn == 4) {
+		for (; x <= len - 4; x += 4) {
+			__m128 v0 = _mm_loadu_ps((const float*)(src + x * 4));
+			__m128 v1 = _mm_loadu_ps((const float*)(src + x * 4 + 4));
+			__m128 v2 = _mm_loadu_ps((const float*)(src + x * 4 + 8));
+			__m128 v3 = _mm_loadu_ps((const float*)(src + x * 4 + 12));
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps((float*)(dst[0] + x), v0);
+			_mm_storeu_ps((float*)(dst[1] + x), v1);
+			_mm_storeu_ps((float*)(dst[2] + x), v2);
+			_mm_storeu_ps((float*)(dst[3] + x), v3);
+		}
+	}
+
+	return x;
+}
+
+static FBC_TARGET_SSE4_1 int merge32s(const int** src, int* dst, int len, int cn)
+{
+	int x = 0;
+
+	if (cn == 2) {
+		for (; x <= len - 4; x += 4) {
+			__m128 a = _mm_loadu_ps((const float*)(src[0] + x));
+			__m128 b = _mm_loadu_ps((const float*)(src[1] + x));
+			_mm_storeu_ps((float*)(dst + x * 2), _mm_unpacklo_ps(a, b));
+			_mm_storeu_ps((float*)(dst + x * 2 + 4), _mm_unpackhi_ps(a, b));
+		}
+	} else if (cn == 3) {
+		for (; x <= len - 4; x += 4) {
+			__m128i in[3], out[3];
+			for (int k = 0; k < 3; k++)
+				in[k] = _mm_loadu_si128((const __m128i*)(src[k] + x));
+			shuffle3(in, out, merge32sC3Masks);
+			for (int k = 0; k < 3; k++)
+				_mm_storeu_si128((__m128i*)(dst + x * 3 + k * 4), out[k]);
+		}
+	} else if (cn == 4) {
+		for (; x <= len - 4; x += 4) {
+			__m128 v0 = _mm_loadu_ps((const float*)(src[0] + x));
+			__m128 v1 = _mm_loadu_ps((const float*)(src[1] + x));
+			__m128 v2 = _mm_loadu_ps((const float*)(src[2] + x));
+			__m128 v3 = _mm_loadu_ps((const float*)(src[3] + x));
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps((float*)(dst + x * 4), v0);
+			_mm_storeu_ps((float*)(dst + x * 4 + 4), v1);
+			_mm_storeu_ps((float*)(dst + x * 4 + 8), v2);
+			_mm_storeu_ps((float*)(dst + x * 4 + 12), v3);
+		}
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+#endif // FBC_CPU_X86
+
+int splitVec8u(const uchar* src, uchar** dst, int len, int cn)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::split8u(src, dst, len, cn);
+#endif
+	return 0;
+}
+
+int mergeVec8u(const uchar** src, uchar* dst, int len, int cn)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::merge8u(src, dst, len, cn);
+#endif
+	return 0;
+}
+
+int splitVec32s(const int* src, int** dst, int len, int cn)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::split32s(src, dst, len, cn);
+#endif
+	return 0;
+}
+
+int mergeVec32s(const int** src, int* dst, int len, int cn)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::merge32s(src, dst, len, cn);
+#endif
+	return 0;
+}
+
+} // namespace hal
+} // namespace fbc
@@ -0,0 +1,136 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+// reference: modules/core/src/system.cpp
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include "core/fbcdef.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+namespace fbc {
+
+struct HWFeatures {
+	HWFeatures() { memset(have, 0, sizeof(have)); }
+
+	static HWFeatures initialize()
+	{
+		HWFeatures f;
+#ifdef FBC_CPU_X86
+		int cpuid_data[4] = { 0, 0, 0, 0 };
+		cpuid(cpuid_data, 0, 0);
+		int max_level = cpuid_data[0];
+
+		if (max_level >= 1) {
+			cpuid(cpuid_data, 1, 0);
+			f.have[FBC_CPU_MMX] = (cpuid_data[3] & (1 << 23)) != 0;
+			f.have[FBC_CPU_SSE] = (cpuid_data[3] & (1 << 25)) != 0;
+			f.have[FBC_CPU_SSE2] = (cpuid_data[3] & (1 << 26)) != 0;
+			f.have[FBC_CPU_SSE3] = (cpuid_data[2] & (1 << 0)) != 0;
+			f.have[FBC_CPU_SSSE3] = (cpuid_data[2] & (1 << 9)) != 0;
+			f.have[FBC_CPU_FMA3] = (cpuid_data[2] & (1 << 12)) != 0;
+			f.have[FBC_CPU_SSE4_1] = (cpuid_data[2] & (1 << 19)) != 0;
+			f.have[FBC_CPU_SSE4_2] = (cpuid_data[2] & (1 << 20)) != 0;
+			f.have[FBC_CPU_POPCNT] = (cpuid_data[2] & (1 << 23)) != 0;
+
+			// AVX needs the support of the OS to save the ymm registers (OSXSAVE and XCR0 bits 1, 2)
+			bool have_osxsave = (cpuid_data[2] & (1 << 27)) != 0;
+			bool have_avx = (cpuid_data[2] & (1 << 28)) != 0;
+			f.have[FBC_CPU_AVX] = have_osxsave && have_avx && (xgetbv() & 0x6) == 0x6;
+			if (!f.have[FBC_CPU_AVX])
+				f.have[FBC_CPU_FMA3] = false;
+		}
+
+		if (max_level >= 7 && f.have[FBC_CPU_AVX]) {
+			cpuid(cpuid_data, 7, 0);
+			f.have[FBC_CPU_AVX2] = (cpuid_data[1] & (1 << 5)) != 0;
+		}
+#endif
+
+		f.disable(getenv("FBC_CPU_DISABLE"));
+
+		return f;
+	}
+
+	// comma separated list of the feature names to turn off
+	void disable(const char* names)
+	{
+		static const struct { const char* name; int feature; } features[] = {
+			{ "MMX", FBC_CPU_MMX }, { "SSE", FBC_CPU_SSE }, { "SSE2", FBC_CPU_SSE2 }, { "SSE3", FBC_CPU_SSE3 },
+			{ "SSSE3", FBC_CPU_SSSE3 }, { "SSE4_1", FBC_CPU_SSE4_1 }, { "SSE4_2", FBC_CPU_SSE4_2 }, { "POPCNT", FBC_CPU_POPCNT },
+			{ "AVX", FBC_CPU_AVX }, { "AVX2", FBC_CPU_AVX2 }, { "FMA3", FBC_CPU_FMA3 }
+		};
+
+		while (names && *names) {
+			const char* end = strchr(names, ',');
+			size_t len = end ? (size_t)(end - names) : strlen(names);
+
+			for (size_t i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+				if (strlen(features[i].name) == len && strncmp(features[i].name, names, len) == 0)
+					have[features[i].feature] = false;
+			}
+
+			names = end ? end + 1 : NULL;
+		}
+	}
+
+#ifdef FBC_CPU_X86
+	static void cpuid(int* data, int level, int sublevel)
+	{
+	#ifdef _MSC_VER
+		__cpuidex(data, level, sublevel);
+	#else
+		unsigned int a = 0, b = 0, c = 0, d = 0;
+		__cpuid_count(level, sublevel, a, b, c, d);
+		data[0] = (int)a; data[1] = (int)b; data[2] = (int)c; data[3] = (int)d;
+	#endif
+	}
+
+	static unsigned long long xgetbv()
+	{
+	#ifdef _MSC_VER
+		return _xgetbv(0);
+	#else
+		unsigned int eax = 0, edx = 0;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return ((unsigned long long)edx << 32) | eax;
+	#endif
+	}
+#endif
+
+	bool have[FBC_HARDWARE_MAX_FEATURE + 1];
+};
+
+static const HWFeatures& getHWFeatures()
+{
+	static HWFeatures features = HWFeatures::initialize();
+	return features;
+}
+
+static std::atomic<bool> use_optimized{ true };
+
+bool checkHardwareSupport(int feature)
+{
+	FBC_Assert(0 <= feature && feature <= FBC_HARDWARE_MAX_FEATURE);
+	return use_optimized.load(std::memory_order_relaxed) && getHWFeatures().have[feature];
+}
+
+void setUseOptimized(bool onoff)
+{
+	use_optimized = onoff;
+}
+
+bool useOptimized()
+{
+	return use_optimized.load();
+}
+
+} // namespace fbc
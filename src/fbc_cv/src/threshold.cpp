@@ -0,0 +1,144 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/imgproc/src/thresh.cpp
+*/
+
+// SSE4.1 kernels of threshold (8-bit and float rows, 8-bit rows with a threshold per element), selected at runtime
+// by checkHardwareSupport(); every element is compared and selected like in the plain C++ code (the unsigned
+// comparisons of 8-bit elements are signed comparisons of the elements xor 0x80), so the results are the same
+
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#include "imgproc.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+	#define FBC_TARGET_SSE4_1
+#endif
+
+namespace fbc { namespace hal {
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// the result of 16 elements s with the thresholds t, gt is the mask of s > t
+FBC_TARGET_SSE4_1 static inline __m128i threshold8u16(__m128i s, __m128i t, __m128i gt, __m128i maxval, int type)
+{
+	switch (type) {
+	case THRESH_BINARY: return _mm_and_si128(gt, maxval);
+	case THRESH_BINARY_INV: return _mm_andnot_si128(gt, maxval);
+	case THRESH_TRUNC: return _mm_min_epu8(s, t);
+	case THRESH_TOZERO: return _mm_and_si128(gt, s);
+	default: return _mm_andnot_si128(gt, s); // THRESH_TOZERO_INV
+	}
+}
+
+FBC_TARGET_SSE4_1 static int threshold8u(const uchar* src, uchar* dst, int width, uchar thresh, uchar maxval, int type)
+{
+	const __m128i delta = _mm_set1_epi8((char)0x80);
+	__m128i t = _mm_set1_epi8((char)thresh), t_ = _mm_xor_si128(t, delta);
+	__m128i m = _mm_set1_epi8((char)maxval);
+	int x = 0;
+
+	for (; x <= width - 32; x += 32) {
+		__m128i s0 = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i s1 = _mm_loadu_si128((const __m128i*)(src + x + 16));
+		__m128i gt0 = _mm_cmpgt_epi8(_mm_xor_si128(s0, delta), t_);
+		__m128i gt1 = _mm_cmpgt_epi8(_mm_xor_si128(s1, delta), t_);
+		_mm_storeu_si128((__m128i*)(dst + x), threshold8u16(s0, t, gt0, m, type));
+		_mm_storeu_si128((__m128i*)(dst + x + 16), threshold8u16(s1, t, gt1, m, type));
+	}
+
+	for (; x <= width - 16; x += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i gt = _mm_cmpgt_epi8(_mm_xor_si128(s, delta), t_);
+		_mm_storeu_si128((__m128i*)(dst + x), threshold8u16(s, t, gt, m, type));
+	}
+
+	return x;
+}
+
+FBC_TARGET_SSE4_1 static int thresholdMap8u(const uchar* src, const uchar* thresh, uchar* dst, int width, uchar maxval, int type)
+{
+	const __m128i delta = _mm_set1_epi8((char)0x80);
+	__m128i m = _mm_set1_epi8((char)maxval);
+	int x = 0;
+
+	for (; x <= width - 16; x += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+		__m128i t = _mm_loadu_si128((const __m128i*)(thresh + x));
+		__m128i gt = _mm_cmpgt_epi8(_mm_xor_si128(s, delta), _mm_xor_si128(t, delta));
+		_mm_storeu_si128((__m128i*)(dst + x), threshold8u16(s, t, gt, m, type));
+	}
+
+	return x;
+}
+
+// the comparisons are false for NaN like in the C++ code, min_ps(t, s) is std::min(s, t) (t < s ? t : s)
+FBC_TARGET_SSE4_1 static inline __m128 threshold32f4(__m128 s, __m128 t, __m128 maxval, int type)
+{
+	switch (type) {
+	case THRESH_BINARY: return _mm_and_ps(_mm_cmpgt_ps(s, t), maxval);
+	case THRESH_BINARY_INV: return _mm_and_ps(_mm_cmple_ps(s, t), maxval);
+	case THRESH_TRUNC: return _mm_min_ps(t, s);
+	case THRESH_TOZERO: return _mm_and_ps(_mm_cmpgt_ps(s, t), s);
+	default: return _mm_and_ps(_mm_cmple_ps(s, t), s); // THRESH_TOZERO_INV
+	}
+}
+
+FBC_TARGET_SSE4_1 static int threshold32f(const float* src, float* dst, int width, float thresh, float maxval, int type)
+{
+	__m128 t = _mm_set1_ps(thresh), m = _mm_set1_ps(maxval);
+	int x = 0;
+
+	for (; x <= width - 8; x += 8) {
+		__m128 s0 = _mm_loadu_ps(src + x), s1 = _mm_loadu_ps(src + x + 4);
+		_mm_storeu_ps(dst + x, threshold32f4(s0, t, m, type));
+		_mm_storeu_ps(dst + x + 4, threshold32f4(s1, t, m, type));
+	}
+
+	for (; x <= width - 4; x += 4)
+		_mm_storeu_ps(dst + x, threshold32f4(_mm_loadu_ps(src + x), t, m, type));
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+#endif // FBC_CPU_X86
+
+int threshold8u(const uchar* src, uchar* dst, int width, uchar thresh, uchar maxval, int type)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::threshold8u(src, dst, width, thresh, maxval, type);
+#endif
+	return 0;
+}
+
+int thresholdMap8u(const uchar* src, const uchar* thresh, uchar* dst, int width, uchar maxval, int type)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::thresholdMap8u(src, thresh, dst, width, maxval, type);
+#endif
+	return 0;
+}
+
+int threshold32f(const float* src, float* dst, int width, float thresh, float maxval, int type)
+{
+#ifdef FBC_CPU_X86
+	if (checkHardwareSupport(FBC_CPU_SSE4_1))
+		return opt_SSE4_1::threshold32f(src, dst, width, thresh, maxval, type);
+#endif
+	return 0;
+}
+
+} } // namespace fbc::hal
@@ -0,0 +1,321 @@
+// fbc_cv is free software and uses the same licence as OpenCV
+// Email: fengbingchun@163.com
+
+/* reference: modules/core/src/matrix_transform.cpp
+*/
+
+// cache-blocked transpose, in-place transpose of square arrays and row reversal, the kernels of transpose/rotate/flip
+// the arrays are processed in tiles that fit in L1; inside the tiles 16x16 bytes (1-byte elements), 4x4 uchar3 and
+// 4x4 32-bit elements are transposed in SSE registers (selected at runtime by checkHardwareSupport()), the other
+// element sizes are copied element by element; the kernels only move the elements, so all paths give the same result
+
+#include <string.h>
+#include <algorithm>
+#include "core/fbcdef.hpp"
+#include "core/hal.hpp"
+#include "core/utility.hpp"
+#ifdef FBC_CPU_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+	#define FBC_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#else
+	#define FBC_TARGET_SSE4_1
+#endif
+
+namespace fbc { namespace hal {
+
+// side of the square tiles in elements, a tile of the source and one of the destination stay in L1
+static inline int transposeTileSize(int esz)
+{
+	return esz == 1 ? 64 : esz <= 4 ? 32 : 16;
+}
+
+template<int esz> static inline void copyElem(const uchar* src, uchar* dst)
+{
+	memcpy(dst, src, esz);
+}
+
+// transposes the height x width block src into the width x height block dst, element by element
+template<int esz>
+static void transposeBlock_(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height)
+{
+	for (int x = 0; x < width; x++) {
+		const uchar* s = src + x * esz;
+		uchar* d = dst + x * dstep;
+		for (int y = 0; y < height; y++, s += sstep)
+			copyElem<esz>(s, d + y * esz);
+	}
+}
+
+static void transposeBlockN(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz)
+{
+	for (int x = 0; x < width; x++) {
+		const uchar* s = src + (size_t)x * esz;
+		uchar* d = dst + x * dstep;
+		for (int y = 0; y < height; y++, s += sstep)
+			memcpy(d + (size_t)y * esz, s, esz);
+	}
+}
+
+static void transposeBlock(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz)
+{
+	switch (esz) {
+	case 1: transposeBlock_<1>(src, sstep, dst, dstep, width, height); break;
+	case 2: transposeBlock_<2>(src, sstep, dst, dstep, width, height); break;
+	case 3: transposeBlock_<3>(src, sstep, dst, dstep, width, height); break;
+	case 4: transposeBlock_<4>(src, sstep, dst, dstep, width, height); break;
+	case 6: transposeBlock_<6>(src, sstep, dst, dstep, width, height); break;
+	case 8: transposeBlock_<8>(src, sstep, dst, dstep, width, height); break;
+	case 12: transposeBlock_<12>(src, sstep, dst, dstep, width, height); break;
+	case 16: transposeBlock_<16>(src, sstep, dst, dstep, width, height); break;
+	default: transposeBlockN(src, sstep, dst, dstep, width, height, esz); break;
+	}
+}
+
+template<int esz>
+static void flipRows_(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int x0)
+{
+	for (int y = 0; y < height; y++, src += sstep, dst += dstep) {
+		for (int x = x0; x < width; x++)
+			copyElem<esz>(src + x * esz, dst + (width - 1 - x) * esz);
+	}
+}
+
+#ifdef FBC_CPU_X86
+
+namespace opt_SSE4_1 {
+
+// 16x16 bytes: four interleaving stages of 8, 16, 32 and 64-bit lanes
+static inline FBC_TARGET_SSE4_1 void transpose16x16_8u(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep)
+{
+	__m128i a[16], b[16];
+	for (int i = 0; i < 16; i++)
+		a[i] = _mm_loadu_si128((const __m128i*)(src + i * sstep));
+
+	// b[p]: columns 0..7 of the rows 2p, 2p + 1, b[p + 8]: columns 8..15
+	for (int p = 0; p < 8; p++) {
+		b[p] = _mm_unpacklo_epi8(a[2 * p], a[2 * p + 1]);
+		b[p + 8] = _mm_unpackhi_epi8(a[2 * p], a[2 * p + 1]);
+	}
+	// a[4 * c + q]: columns 4c..4c+3 of the rows 4q..4q+3
+	for (int h = 0; h < 16; h += 8) {
+		for (int q = 0; q < 4; q++) {
+			a[(h / 4) * 4 + q] = _mm_unpacklo_epi16(b[h + 2 * q], b[h + 2 * q + 1]);
+			a[(h / 4 + 1) * 4 + q] = _mm_unpackhi_epi16(b[h + 2 * q], b[h + 2 * q + 1]);
+		}
+	}
+	// b[2 * k + o]: columns 2k, 2k+1 of the rows 8o..8o+7
+	for (int c = 0; c < 4; c++) {
+		for (int o = 0; o < 2; o++) {
+			b[(2 * c) * 2 + o] = _mm_unpacklo_epi32(a[c * 4 + 2 * o], a[c * 4 + 2 * o + 1]);
+			b[(2 * c + 1) * 2 + o] = _mm_unpackhi_epi32(a[c * 4 + 2 * o], a[c * 4 + 2 * o + 1]);
+		}
+	}
+	for (int k = 0; k < 8; k++) {
+		_mm_storeu_si128((__m128i*)(dst + (2 * k) * dstep), _mm_unpacklo_epi64(b[2 * k], b[2 * k + 1]));
+		_mm_storeu_si128((__m128i*)(dst + (2 * k + 1) * dstep), _mm_unpackhi_epi64(b[2 * k], b[2 * k + 1]));
+	}
+}
+
+static inline FBC_TARGET_SSE4_1 void transpose4x4_32s(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep)
+{
+	__m128 r0 = _mm_loadu_ps((const float*)src), r1 = _mm_loadu_ps((const float*)(src + sstep));
+	__m128 r2 = _mm_loadu_ps((const float*)(src + 2 * sstep)), r3 = _mm_loadu_ps((const float*)(src + 3 * sstep));
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps((float*)dst, r0);
+	_mm_storeu_ps((float*)(dst + dstep), r1);
+	_mm_storeu_ps((float*)(dst + 2 * dstep), r2);
+	_mm_storeu_ps((float*)(dst + 3 * dstep), r3);
+}
+
+// 4x4 uchar3 elements: every row is widened to four 32-bit lanes, transposed as 4x4 32-bit elements and packed back;
+// the rows are loaded with 16 bytes, 4 bytes past the block
+static inline FBC_TARGET_SSE4_1 void transpose4x4_8uC3(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep)
+{
+	const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	__m128 r[4];
+	for (int i = 0; i < 4; i++)
+		r[i] = _mm_castsi128_ps(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i * sstep)), expand));
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+	for (int i = 0; i < 4; i++) {
+		__m128i v = _mm_shuffle_epi8(_mm_castps_si128(r[i]), pack);
+		uchar* d = dst + i * dstep;
+		_mm_storel_epi64((__m128i*)d, v);
+		int t = _mm_extract_epi32(v, 2);
+		memcpy(d + 8, &t, 4);
+	}
+}
+
+// transposes the height x width block (at most a tile) with the register kernels, returns false for other element sizes
+// avail: number of elements of the source rows from the beginning of the block, the uchar3 kernel reads past the block
+static FBC_TARGET_SSE4_1 bool transposeBlock(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz, int avail)
+{
+	int n, wvec;
+	if (esz == 1) {
+		n = 16;
+		wvec = width;
+	} else if (esz == 4) {
+		n = 4;
+		wvec = width;
+	} else if (esz == 3) {
+		n = 4;
+		wvec = std::min(width, avail - 2); // x + 6 <= avail: 16 bytes from element x are in the row
+	} else {
+		return false;
+	}
+
+	int x = 0, y = 0;
+	for (; y <= height - n; y += n) {
+		const uchar* s = src + y * sstep;
+		uchar* d = dst + y * esz;
+		for (x = 0; x <= wvec - n; x += n) {
+			if (esz == 1)
+				transpose16x16_8u(s + x, sstep, d + x * dstep, dstep);
+			else if (esz == 4)
+				transpose4x4_32s(s + x * 4, sstep, d + x * dstep, dstep);
+			else
+				transpose4x4_8uC3(s + x * 3, sstep, d + x * dstep, dstep);
+		}
+		if (x < width)
+			hal::transposeBlock(s + x * esz, sstep, d + x * dstep, dstep, width - x, n, esz);
+	}
+	if (y < height)
+		hal::transposeBlock(src + y * sstep, sstep, dst + y * esz, dstep, width, height - y, esz);
+
+	return true;
+}
+
+// reverses the elements of the rows, returns the number of processed elements of every row
+static FBC_TARGET_SSE4_1 int flipRows(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz)
+{
+	int x = 0;
+	if (esz == 1) {
+		const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		for (int y = 0; y < height; y++, src += sstep, dst += dstep) {
+			for (x = 0; x <= width - 16; x += 16) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+				_mm_storeu_si128((__m128i*)(dst + width - 16 - x), _mm_shuffle_epi8(v, rev));
+			}
+		}
+	} else if (esz == 4) {
+		for (int y = 0; y < height; y++, src += sstep, dst += dstep) {
+			for (x = 0; x <= width - 4; x += 4) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + x * 4));
+				_mm_storeu_si128((__m128i*)(dst + (width - 4 - x) * 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+			}
+		}
+	} else if (esz == 3) {
+		// 5 elements per register: the reversed 15 bytes are stored at bytes 1..15, byte 0 is overwritten by the
+		// next step; x + 6 <= width keeps the 16-byte load and store in the rows
+		const __m128i rev = _mm_setr_epi8(0, 12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2);
+		for (int y = 0; y < height; y++, src += sstep, dst += dstep) {
+			for (x = 0; x <= width - 6; x += 5) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + x * 3));
+				_mm_storeu_si128((__m128i*)(dst + (width - 5 - x) * 3 - 1), _mm_shuffle_epi8(v, rev));
+			}
+		}
+	}
+
+	return x;
+}
+
+} // namespace opt_SSE4_1
+
+#endif // FBC_CPU_X86
+
+static void transposeTile(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz, int avail, bool vec)
+{
+#ifdef FBC_CPU_X86
+	if (vec && opt_SSE4_1::transposeBlock(src, sstep, dst, dstep, width, height, esz, avail))
+		return;
+#endif
+	transposeBlock(src, sstep, dst, dstep, width, height, esz);
+}
+
+static bool useSSE4_1()
+{
+#ifdef FBC_CPU_X86
+	return checkHardwareSupport(FBC_CPU_SSE4_1);
+#else
+	return false;
+#endif
+}
+
+void transpose2D(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz)
+{
+	const int T = transposeTileSize(esz);
+	bool vec = useSSE4_1();
+
+	// tile columns outside: a band of T destination rows is completed before the next one
+	for (int x0 = 0; x0 < width; x0 += T) {
+		int tw = std::min(T, width - x0);
+		for (int y0 = 0; y0 < height; y0 += T) {
+			int th = std::min(T, height - y0);
+			transposeTile(src + y0 * sstep + (size_t)x0 * esz, sstep, dst + x0 * dstep + (size_t)y0 * esz, dstep,
+				tw, th, esz, width - x0, vec);
+		}
+	}
+}
+
+void transposeInplace(uchar* data, size_t step, int n, int esz, int row0, int row1)
+{
+	const int T = transposeTileSize(esz);
+	const ptrdiff_t bstep = (ptrdiff_t)T * esz;
+	AutoBuffer<uchar> _buf((size_t)T * bstep);
+	uchar* buf = _buf;
+	bool vec = useSSE4_1();
+
+	for (int i0 = row0; i0 < row1; i0 += T) {
+		int i1 = std::min(i0 + T, row1);
+		uchar* dii = data + i0 * step + (size_t)i0 * esz;
+
+		// the diagonal tile through the buffer
+		transposeTile(dii, step, buf, bstep, i1 - i0, i1 - i0, esz, n - i0, vec);
+		for (int i = 0; i < i1 - i0; i++)
+			memcpy(dii + i * step, buf + i * bstep, (size_t)(i1 - i0) * esz);
+
+		// swaps the tile (i, j) with the transposed tile (j, i) right of the diagonal
+		for (int j0 = i1; j0 < n; j0 += T) {
+			int j1 = std::min(j0 + T, n);
+			uchar* dij = data + i0 * step + (size_t)j0 * esz;
+			uchar* dji = data + j0 * step + (size_t)i0 * esz;
+
+			transposeTile(dji, step, buf, bstep, i1 - i0, j1 - j0, esz, n - i0, vec);
+			transposeTile(dij, step, dji, step, j1 - j0, i1 - i0, esz, n - j0, vec);
+			for (int i = 0; i < i1 - i0; i++)
+				memcpy(dij + i * step, buf + i * bstep, (size_t)(j1 - j0) * esz);
+		}
+	}
+}
+
+void flipRows(const uchar* src, ptrdiff_t sstep, uchar* dst, ptrdiff_t dstep, int width, int height, int esz)
+{
+	int x = 0;
+#ifdef FBC_CPU_X86
+	if (useSSE4_1())
+		x = opt_SSE4_1::flipRows(src, sstep, dst, dstep, width, height, esz);
+#endif
+
+	switch (esz) {
+	case 1: flipRows_<1>(src, sstep, dst, dstep, width, height, x); break;
+	case 2: flipRows_<2>(src, sstep, dst, dstep, width, height, x); break;
+	case 3: flipRows_<3>(src, sstep, dst, dstep, width, height, x); break;
+	case 4: flipRows_<4>(src, sstep, dst, dstep, width, height, x); break;
+	case 6: flipRows_<6>(src, sstep, dst, dstep, width, height, x); break;
+	case 8: flipRows_<8>(src, sstep, dst, dstep, width, height, x); break;
+	case 12: flipRows_<12>(src, sstep, dst, dstep, width, height, x); break;
+	case 16: flipRows_<16>(src, sstep, dst, dstep, width, height, x); break;
+	default:
+		for (int y = 0; y < height; y++, src += sstep, dst += dstep) {
+			for (int i = x; i < width; i++)
+				memcpy(dst + (size_t)(width - 1 - i) * esz, src + (size_t)i * esz, esz);
+		}
+		break;
+	}
+}
+
+} // namespace hal
+} // namespace fbc
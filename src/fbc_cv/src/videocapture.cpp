@@ -1,9 +1,14 @@
 // fbc_cv is free software and uses the same licence as OpenCV
 // Email: fengbingchun@163.com
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 #include "videocapture.hpp"
 #include "core/Ptr.hpp"
 #include "dshow.hpp"
+#include "cap_v4l2.hpp"
 
 // referece: 2.4.13.6
 //           highgui/src/cap.cpp
@@ -17,6 +22,8 @@ CvCapture* cvCreateCameraCapture(int index)
 	CvCapture* capture = nullptr;
 	capture = cvCreateCameraCapture_DShow(index);
 	return capture;
+#elif defined(__linux__)
+	return cvCreateCameraCapture_V4L2(index);
 #else
 	return nullptr;
 #endif
@@ -42,28 +49,254 @@ int cvSetCaptureProperty(CvCapture* capture, int id, double value)
 	return capture ? capture->setProperty(id, value) : 0;
 }
 
-VideoCapture::VideoCapture()
+// copies the BGR frame row by row (the rows of the IplImage may be padded), image is reallocated if the size changed
+static bool copyFrame(const IplImage* img, Mat_<unsigned char, 3>& image)
+{
+	if (img->nChannels != 3 || img->depth != IPL_DEPTH_8U) {
+		fprintf(stderr, "unsupported frame format: channels: %d, depth: %d\n", img->nChannels, img->depth);
+		return false;
+	}
+
+	image.create(img->height, img->width);
+	size_t len = (size_t)img->width * 3;
+	for (int y = 0; y < img->height; y++)
+		memcpy(image.ptr(y), img->imageData + (size_t)y * img->widthStep, len);
+	return true;
+}
+
+static int64 steadyClockNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the grab thread of the asynchronous capture: grabs into the free frames of a ring, read() copies the frames out;
+// every frame of the ring is owned either by the thread (WRITING) or by one reader (READING) while it is copied
+class AsyncGrabber {
+public:
+	AsyncGrabber(CvCapture* capture, int bufferCount, int policy);
+	~AsyncGrabber();
+
+	bool read(Mat_<unsigned char, 3>& image, frame_info& info, int timeout);
+	capture_stats stats() const;
+
+	// serializes the other accesses to the capture (properties, device queries) with the grab thread
+	std::mutex device_mutex;
+
+private:
+	enum { SLOT_FREE, SLOT_WRITING, SLOT_READY, SLOT_READING };
+
+	struct Slot {
+		Mat_<unsigned char, 3> image;
+		frame_info info;
+		int state;
+	};
+
+	void run();
+	int acquireSlot(std::unique_lock<std::mutex>& lock);
+
+	CvCapture* capture;
+	int policy;
+	std::vector<Slot> slots;
+	mutable std::mutex mutex;
+	std::condition_variable frame_ready, slot_free;
+	bool stopping, failed;
+	uint64 next_sequence;
+	int device_sequence; // the last sequence number of the device, -1 if unknown
+	capture_stats counters;
+	std::thread thread;
+};
+
+AsyncGrabber::AsyncGrabber(CvCapture* capture, int bufferCount, int policy)
+	: capture(capture), policy(policy), slots(bufferCount), stopping(false), failed(false), next_sequence(0), device_sequence(-1)
+{
+	memset(&counters, 0, sizeof(counters));
+
+	// preallocate the ring with the current frame size, a frame is only reallocated when the resolution changes
+	int width = (int)capture->getProperty(CV_CAP_PROP_FRAME_WIDTH);
+	int height = (int)capture->getProperty(CV_CAP_PROP_FRAME_HEIGHT);
+	for (size_t i = 0; i < slots.size(); i++) {
+		if (width > 0 && height > 0)
+			slots[i].image.create(height, width);
+		slots[i].state = SLOT_FREE;
+	}
+
+	thread = std::thread(&AsyncGrabber::run, this);
+}
+
+AsyncGrabber::~AsyncGrabber()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	slot_free.notify_all();
+	frame_ready.notify_all();
+	thread.join();
+}
+
+// caller must hold mutex, returns -1 when the thread is stopped
+int AsyncGrabber::acquireSlot(std::unique_lock<std::mutex>& lock)
+{
+	while (!stopping) {
+		int oldest = -1;
+		for (int i = 0; i < (int)slots.size(); i++) {
+			if (slots[i].state == SLOT_FREE)
+				return i;
+			if (slots[i].state == SLOT_READY && (oldest < 0 || slots[i].info.sequence < slots[oldest].info.sequence))
+				oldest = i;
+		}
+
+		if (policy == CAP_ASYNC_LATEST && oldest >= 0) {
+			counters.dropped++;
+			return oldest;
+		}
+
+		slot_free.wait(lock);
+	}
+
+	return -1;
+}
+
+void AsyncGrabber::run()
+{
+	while (true) {
+		int idx;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			idx = acquireSlot(lock);
+			if (idx < 0) return;
+			slots[idx].state = SLOT_WRITING;
+		}
+
+		bool ok = false;
+		int64 timestamp = 0;
+		int sequence = -1;
+		{
+			std::lock_guard<std::mutex> lock(device_mutex);
+			if (capture->grabFrame()) {
+				timestamp = steadyClockNanoseconds();
+				IplImage* img = capture->retrieveFrame(0);
+				ok = img && copyFrame(img, slots[idx].image);
+
+				frame_view view;
+				if (ok && capture->retrieveFrameView(view))
+					sequence = view.sequence;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!ok) {
+				slots[idx].state = SLOT_FREE;
+				failed = true;
+			} else {
+				if (sequence >= 0 && device_sequence >= 0 && sequence > device_sequence + 1)
+					counters.device_dropped += sequence - device_sequence - 1;
+				device_sequence = sequence;
+
+				slots[idx].info.sequence = next_sequence++;
+				slots[idx].info.timestamp = timestamp;
+				slots[idx].state = SLOT_READY;
+				counters.grabbed++;
+			}
+		}
+		frame_ready.notify_all();
+
+		if (!ok) {
+			fprintf(stderr, "fail to grab frame, the grab thread stops\n");
+			return;
+		}
+	}
+}
+
+bool AsyncGrabber::read(Mat_<unsigned char, 3>& image, frame_info& info, int timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	auto ready = [this]() {
+		if (failed || stopping) return true;
+		for (size_t i = 0; i < slots.size(); i++)
+			if (slots[i].state == SLOT_READY) return true;
+		return false;
+	};
+	if (timeout < 0)
+		frame_ready.wait(lock, ready);
+	else if (!frame_ready.wait_for(lock, std::chrono::milliseconds(timeout), ready))
+		return false;
+
+	// latest: the newest frame, the older unread frames are dropped; no drop: the oldest frame
+	int idx = -1;
+	for (int i = 0; i < (int)slots.size(); i++) {
+		if (slots[i].state != SLOT_READY) continue;
+		if (idx < 0 || (policy == CAP_ASYNC_LATEST) == (slots[i].info.sequence > slots[idx].info.sequence))
+			idx = i;
+	}
+	if (idx < 0) return false;
+
+	int skipped = 0;
+	if (policy == CAP_ASYNC_LATEST) {
+		for (int i = 0; i < (int)slots.size(); i++) {
+			if (i != idx && slots[i].state == SLOT_READY) {
+				slots[i].state = SLOT_FREE;
+				skipped++;
+			}
+		}
+		counters.dropped += skipped;
+	}
+	slots[idx].state = SLOT_READING;
+	lock.unlock();
+	if (skipped > 0) slot_free.notify_all();
+
+	slots[idx].image.copyTo(image);
+	info = slots[idx].info;
+
+	lock.lock();
+	slots[idx].state = SLOT_FREE;
+	counters.delivered++;
+	lock.unlock();
+	slot_free.notify_all();
+
+	return true;
+}
+
+capture_stats AsyncGrabber::stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+// locks the capture against the grab thread, does nothing in synchronous mode
+static std::unique_lock<std::mutex> lockDevice(const Ptr<AsyncGrabber>& async)
+{
+	return async.empty() ? std::unique_lock<std::mutex>() : std::unique_lock<std::mutex>(async->device_mutex);
+}
+
+VideoCapture::VideoCapture() : device_id(-1), sequence(0)
 {}
 
-VideoCapture::VideoCapture(const std::string& filename)
+VideoCapture::VideoCapture(const std::string& filename) : device_id(-1), sequence(0)
 {
 	open(filename);
 }
 
-VideoCapture::VideoCapture(int device)
+VideoCapture::VideoCapture(int device) : device_id(-1), sequence(0)
 {
-	device_id = device;
 	open(device);
 }
 
 VideoCapture::~VideoCapture()
 {
+	async.release();
 	cap.release();
 }
 
 bool VideoCapture::open(const std::string& filename)
 {
 	if (isOpened()) release();
+#ifdef __linux__
+	// a device path or a stand-in device
+	cap.reset(cvCreateCameraCapture_V4L2(filename));
+	if (isOpened()) return true;
+#endif
 	open(0);
 	if (!cap) return false;
 
@@ -86,6 +319,8 @@ bool VideoCapture::open(int device)
 {
 	if (isOpened()) release();
 	cap.reset(cvCreateCameraCapture(device));
+	device_id = isOpened() ? device : -1;
+	sequence = 0;
 	return isOpened();
 }
 
@@ -93,29 +328,29 @@ bool VideoCapture::isOpened() const { return !cap.empty(); }
 
 void VideoCapture::release()
 {
+	async.release();
 	cap.release();
+	device_id = -1;
+	sequence = 0;
 }
 
 bool VideoCapture::grab()
 {
+	if (isAsync()) return false;
 	return cvGrabFrame(cap) != 0;
 }
 
 bool VideoCapture::retrieve(Mat_<unsigned char, 3>& image, int channel)
 {
-	IplImage* _img = cvRetrieveFrame(cap, channel);
+	IplImage* _img = isAsync() ? NULL : cvRetrieveFrame(cap, channel);
 	if (!_img)
 	{
 		image.release();
 		return false;
 	}
 
-	if (_img->width != image.cols || _img->height != image.rows || _img->nChannels != image.channels) {
-		printf("image size mismatch\n");
-		return false;
-	}
-	static int size = _img->width * _img->height * _img->nChannels;
-	memcpy(image.data, _img->imageData, size);
+	// image keeps its buffer while the frame size is unchanged
+	return copyFrame(_img, image);
 
 	//if (_img->origin == IPL_ORIGIN_TL)
 	//	Mat(_img).copyTo(image);
@@ -124,11 +359,43 @@ bool VideoCapture::retrieve(Mat_<unsigned char, 3>& image, int channel)
 	//	Mat temp(_img);
 	//	flip(temp, image, 0);
 	//}
+}
+
+bool VideoCapture::retrieveView(Mat_<unsigned char, 1>& view, int* fourcc)
+{
+	frame_view v;
+	if (!cap || isAsync() || !cap->retrieveFrameView(v) || v.bytesused <= 0) {
+		view.release();
+		return false;
+	}
+
+	if (fourcc) *fourcc = v.fourcc;
+	if (v.step > 0 && v.bytesused >= v.step)
+		view = Mat_<unsigned char, 1>(v.bytesused / v.step, v.step, v.data);
+	else
+		view = Mat_<unsigned char, 1>(1, v.bytesused, v.data);
+	return true;
+}
+
+bool VideoCapture::retrieveView(Mat_<unsigned char, 3>& view)
+{
+	frame_view v;
+	if (!cap || isAsync() || !cap->retrieveFrameView(v) || v.fourcc != CV_FOURCC('B', 'G', 'R', '3') || v.step != v.width * 3) {
+		view.release();
+		return false;
+	}
+
+	view = Mat_<unsigned char, 3>(v.height, v.width, v.data);
 	return true;
 }
 
 bool VideoCapture::read(Mat_<unsigned char, 3>& image)
 {
+	if (isAsync()) {
+		frame_info info;
+		return read(image, info);
+	}
+
 	if (grab())
 		retrieve(image);
 	else
@@ -136,6 +403,50 @@ bool VideoCapture::read(Mat_<unsigned char, 3>& image)
 	return !image.empty();
 }
 
+bool VideoCapture::startAsync(int bufferCount, int policy)
+{
+	if (!isOpened() || isAsync() || bufferCount < 2 || (policy != CAP_ASYNC_LATEST && policy != CAP_ASYNC_NO_DROP))
+		return false;
+
+	async.reset(new AsyncGrabber(cap.get(), bufferCount, policy));
+	return true;
+}
+
+void VideoCapture::stopAsync()
+{
+	async.release();
+}
+
+bool VideoCapture::isAsync() const { return !async.empty(); }
+
+bool VideoCapture::read(Mat_<unsigned char, 3>& image, frame_info& info, int timeout)
+{
+	if (isAsync()) {
+		if (async->read(image, info, timeout))
+			return true;
+		image.release();
+		return false;
+	}
+
+	if (!grab()) {
+		image.release();
+		return false;
+	}
+	info.timestamp = steadyClockNanoseconds();
+	info.sequence = sequence++;
+	return retrieve(image);
+}
+
+capture_stats VideoCapture::getAsyncStats() const
+{
+	if (isAsync())
+		return async->stats();
+
+	capture_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	return stats;
+}
+
 VideoCapture& VideoCapture::operator >> (Mat_<unsigned char, 3>& image)
 {
 	read(image);
@@ -144,29 +455,34 @@ VideoCapture& VideoCapture::operator >> (Mat_<unsigned char, 3>& image)
 
 bool VideoCapture::set(int propId, double value)
 {
+	std::unique_lock<std::mutex> lock = lockDevice(async);
 	return cvSetCaptureProperty(cap, propId, value) != 0;
 }
 
 double VideoCapture::get(int propId)
 {
+	std::unique_lock<std::mutex> lock = lockDevice(async);
 	return cvGetCaptureProperty(cap, propId);
 }
 
 bool VideoCapture::getDevicesList(std::map<int, device_info>& infos) const
 {
 	if (!cap) return false;
+	std::unique_lock<std::mutex> lock = lockDevice(async);
 	return cap->getDevicesList(infos);
 }
 
 bool VideoCapture::getCodecList(std::vector<int>& codecids) const
 {
 	if (!cap) return false;
+	std::unique_lock<std::mutex> lock = lockDevice(async);
 	return cap->getCodecList(device_id, codecids);
 }
 
 bool VideoCapture::getVideoSizeList(int codec_id, std::vector<std::string>& sizelist) const
 {
 	if (!cap) return false;
+	std::unique_lock<std::mutex> lock = lockDevice(async);
 	return cap->getVideoSizeList(device_id, codec_id, sizelist);
 }
 